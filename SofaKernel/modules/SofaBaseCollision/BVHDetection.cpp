@@ -0,0 +1,531 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2019 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#include <SofaBaseCollision/BVHDetection.h>
+
+#include <sofa/core/ObjectFactory.h>
+#include <sofa/helper/AdvancedTimer.h>
+#include <sofa/simulation/TaskScheduler.h>
+#include <sofa/simulation/ParallelForEach.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace sofa
+{
+
+namespace component
+{
+
+namespace collision
+{
+
+using namespace sofa::defaulttype;
+
+int BVHDetectionClass = core::RegisterObject("Collision detection keeping the bounding boxes of the collision models in a dynamic AABB tree")
+        .add< BVHDetection >()
+        ;
+
+namespace
+{
+
+template<class TBox>
+inline bool overlaps(const TBox& a, const TBox& b)
+{
+    for (int i = 0; i < 3; ++i)
+    {
+        if (a.minBBox[i] > b.maxBBox[i] || b.minBBox[i] > a.maxBBox[i])
+            return false;
+    }
+    return true;
+}
+
+template<class TBox>
+inline bool contains(const TBox& a, const TBox& b)
+{
+    for (int i = 0; i < 3; ++i)
+    {
+        if (b.minBBox[i] < a.minBBox[i] || b.maxBBox[i] > a.maxBBox[i])
+            return false;
+    }
+    return true;
+}
+
+template<class TBox>
+inline TBox merge(const TBox& a, const TBox& b)
+{
+    TBox box;
+    for (int i = 0; i < 3; ++i)
+    {
+        box.minBBox[i] = std::min(a.minBBox[i], b.minBBox[i]);
+        box.maxBBox[i] = std::max(a.maxBBox[i], b.maxBBox[i]);
+    }
+    return box;
+}
+
+/// half of the surface of the box, used as the cost of the tree nodes
+template<class TBox>
+inline SReal area(const TBox& box)
+{
+    const Vector3 d = box.maxBBox - box.minBBox;
+    return d[0]*d[1] + d[1]*d[2] + d[2]*d[0];
+}
+
+} // anonymous namespace
+
+BVHDetection::BVHDetection()
+    : d_boxMargin(initData(&d_boxMargin, (SReal)0.1, "boxMargin", "Enlargement of the boxes kept in the tree, relative to their size. Larger margins mean fewer updates of the tree but more candidate pairs"))
+    , d_parallel(initData(&d_parallel, false, "parallel", "If true, query the tree in parallel tasks"))
+    , m_root(-1)
+    , m_freeNode(-1)
+    , m_step(0)
+    , m_rebuildCount(0)
+{
+}
+
+BVHDetection::~BVHDetection()
+{
+}
+
+void BVHDetection::init()
+{
+    BruteForceDetection::init();
+
+    if (d_parallel.getValue())
+    {
+        simulation::TaskScheduler::getInstance();
+    }
+}
+
+void BVHDetection::beginBroadPhase()
+{
+    BruteForceDetection::beginBroadPhase();
+    m_models.clear();
+    m_boxes.clear();
+    m_bounded.clear();
+    m_unbounded.clear();
+    ++m_step;
+}
+
+void BVHDetection::addCollisionModel(core::CollisionModel *cm)
+{
+    if (cm->empty())
+        return;
+
+    if (!intersectsBox(cm))
+        return;
+
+    Box box;
+    const bool bounded = getRootBox(cm, box);
+    if (!bounded)
+        m_unbounded.push_back((int)m_models.size());
+    m_models.push_back(cm);
+    m_boxes.push_back(box);
+    m_bounded.push_back(bounded);
+}
+
+void BVHDetection::endBroadPhase()
+{
+    sofa::helper::ScopedAdvancedTimer timer("BVHDetection");
+
+    updateTree();
+
+    const std::size_t n = m_models.size();
+    m_candidates.resize(n);
+    if (d_parallel.getValue() && n > 1)
+    {
+        simulation::TaskScheduler* scheduler = simulation::TaskScheduler::getInstance();
+        simulation::parallelForEachRange(*scheduler, std::size_t(0), n,
+            [this](std::size_t first, std::size_t last) { queryCandidates(first, last); }, 16);
+    }
+    else
+    {
+        queryCandidates(0, n);
+    }
+
+    // the pairs are added sequentially, in the same order as BruteForceDetection
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        addSelfCollisionPair(m_models[i]);
+        for (int j : m_candidates[i])
+        {
+            addIntersectingPair(m_models[i], m_models[j]);
+        }
+    }
+
+    BruteForceDetection::endBroadPhase();
+}
+
+bool BVHDetection::getRootBox(core::CollisionModel *cm, Box& box)
+{
+    CubeCollisionModel* cube = dynamic_cast<CubeCollisionModel*>(cm);
+    if (cube == nullptr || cube->getSize() == 0)
+        return false;
+
+    // Here we assume a single root element, as in BruteForceDetection
+    const Cube root(cube, 0);
+    const Vector3& minVect = root.minVect();
+    const Vector3& maxVect = root.maxVect();
+
+    // two boxes overlap when their models are closer than the alarm distance, with a small tolerance
+    // so that the candidates always include the pairs accepted by the intersector
+    SReal distance = intersectionMethod->getAlarmDistance()*0.5 + cm->getProximity();
+    SReal scale = 1;
+    for (int i = 0; i < 3; ++i)
+        scale = std::max(scale, std::max(std::abs(minVect[i]), std::abs(maxVect[i])));
+    distance += scale * 64 * std::numeric_limits<SReal>::epsilon();
+
+    const Vector3 d(distance, distance, distance);
+    box.minBBox = minVect - d;
+    box.maxBBox = maxVect + d;
+    return true;
+}
+
+int BVHDetection::allocateNode()
+{
+    int node = m_freeNode;
+    if (node < 0)
+    {
+        node = (int)m_nodes.size();
+        m_nodes.push_back(TreeNode());
+    }
+    else
+    {
+        m_freeNode = m_nodes[node].parent;
+    }
+
+    TreeNode& n = m_nodes[node];
+    n.parent = -1;
+    n.child1 = -1;
+    n.child2 = -1;
+    n.height = 0;
+    n.model = nullptr;
+    n.index = -1;
+    n.step = 0;
+    return node;
+}
+
+void BVHDetection::freeNode(int node)
+{
+    m_nodes[node].height = -1;
+    m_nodes[node].parent = m_freeNode;
+    m_freeNode = node;
+}
+
+void BVHDetection::refit(int node)
+{
+    while (node >= 0)
+    {
+        TreeNode& n = m_nodes[node];
+        n.box = merge(m_nodes[n.child1].box, m_nodes[n.child2].box);
+        n.height = 1 + std::max(m_nodes[n.child1].height, m_nodes[n.child2].height);
+        node = n.parent;
+    }
+}
+
+void BVHDetection::insertLeaf(int leaf)
+{
+    if (m_root < 0)
+    {
+        m_root = leaf;
+        m_nodes[leaf].parent = -1;
+        return;
+    }
+
+    // find the best sibling, minimizing the increase of the surface of the tree
+    const Box box = m_nodes[leaf].box;
+    int index = m_root;
+    while (m_nodes[index].child1 >= 0)
+    {
+        const TreeNode& n = m_nodes[index];
+        const SReal combined = area(merge(n.box, box));
+
+        // cost of a new parent for this node and the leaf
+        const SReal cost = 2 * combined;
+        // minimum cost of pushing the leaf further down the tree
+        const SReal inheritance = 2 * (combined - area(n.box));
+
+        SReal childCost[2];
+        const int children[2] = { n.child1, n.child2 };
+        for (int c = 0; c < 2; ++c)
+        {
+            const TreeNode& child = m_nodes[children[c]];
+            const SReal merged = area(merge(child.box, box));
+            childCost[c] = (child.child1 < 0 ? merged : merged - area(child.box)) + inheritance;
+        }
+
+        if (cost < childCost[0] && cost < childCost[1])
+            break;
+
+        index = (childCost[0] <= childCost[1]) ? children[0] : children[1];
+    }
+
+    const int sibling = index;
+    const int oldParent = m_nodes[sibling].parent;
+    const int newParent = allocateNode();
+
+    TreeNode& p = m_nodes[newParent];
+    p.parent = oldParent;
+    p.child1 = sibling;
+    p.child2 = leaf;
+    p.box = merge(box, m_nodes[sibling].box);
+    p.height = m_nodes[sibling].height + 1;
+    m_nodes[sibling].parent = newParent;
+    m_nodes[leaf].parent = newParent;
+
+    if (oldParent < 0)
+    {
+        m_root = newParent;
+    }
+    else
+    {
+        if (m_nodes[oldParent].child1 == sibling)
+            m_nodes[oldParent].child1 = newParent;
+        else
+            m_nodes[oldParent].child2 = newParent;
+        refit(oldParent);
+    }
+}
+
+void BVHDetection::removeLeaf(int leaf)
+{
+    if (leaf == m_root)
+    {
+        m_root = -1;
+        return;
+    }
+
+    const int parent = m_nodes[leaf].parent;
+    const int grandParent = m_nodes[parent].parent;
+    const int sibling = (m_nodes[parent].child1 == leaf) ? m_nodes[parent].child2 : m_nodes[parent].child1;
+
+    m_nodes[sibling].parent = grandParent;
+    if (grandParent < 0)
+    {
+        m_root = sibling;
+    }
+    else
+    {
+        if (m_nodes[grandParent].child1 == parent)
+            m_nodes[grandParent].child1 = sibling;
+        else
+            m_nodes[grandParent].child2 = sibling;
+    }
+    freeNode(parent);
+    m_nodes[leaf].parent = -1;
+
+    if (grandParent >= 0)
+        refit(grandParent);
+}
+
+int BVHDetection::buildSubTree(int* leaves, int count)
+{
+    if (count == 1)
+        return leaves[0];
+
+    // split the leaves at the median of their centers, along the axis where the centers are the most spread
+    Box centers;
+    for (int i = 0; i < count; ++i)
+    {
+        const Box& box = m_nodes[leaves[i]].box;
+        const Vector3 center = (box.minBBox + box.maxBBox) * 0.5;
+        if (i == 0)
+        {
+            centers.minBBox = center;
+            centers.maxBBox = center;
+        }
+        else for (int k = 0; k < 3; ++k)
+        {
+            centers.minBBox[k] = std::min(centers.minBBox[k], center[k]);
+            centers.maxBBox[k] = std::max(centers.maxBBox[k], center[k]);
+        }
+    }
+    const Vector3 extent = centers.maxBBox - centers.minBBox;
+    int axis = 0;
+    if (extent[1] > extent[axis]) axis = 1;
+    if (extent[2] > extent[axis]) axis = 2;
+
+    const int middle = count / 2;
+    std::nth_element(leaves, leaves + middle, leaves + count, [this, axis](int a, int b)
+    {
+        const SReal ca = m_nodes[a].box.minBBox[axis] + m_nodes[a].box.maxBBox[axis];
+        const SReal cb = m_nodes[b].box.minBBox[axis] + m_nodes[b].box.maxBBox[axis];
+        return ca < cb || (ca == cb && m_nodes[a].index < m_nodes[b].index);
+    });
+
+    const int child1 = buildSubTree(leaves, middle);
+    const int child2 = buildSubTree(leaves + middle, count - middle);
+
+    const int node = allocateNode();
+    TreeNode& n = m_nodes[node];
+    n.child1 = child1;
+    n.child2 = child2;
+    n.box = merge(m_nodes[child1].box, m_nodes[child2].box);
+    n.height = 1 + std::max(m_nodes[child1].height, m_nodes[child2].height);
+    m_nodes[child1].parent = node;
+    m_nodes[child2].parent = node;
+    return node;
+}
+
+void BVHDetection::rebuildTree()
+{
+    helper::vector<int> leaves;
+    leaves.reserve(m_leaves.size());
+    for (const auto& leaf : m_leaves)
+        leaves.push_back(leaf.second);
+
+    // the order of the map depends on the addresses of the models, sort the leaves to build the same tree at each run
+    std::sort(leaves.begin(), leaves.end(), [this](int a, int b) { return m_nodes[a].index < m_nodes[b].index; });
+
+    for (std::size_t i = 0; i < m_nodes.size(); ++i)
+    {
+        if (m_nodes[i].height > 0)
+            freeNode((int)i);
+    }
+
+    m_root = leaves.empty() ? -1 : buildSubTree(leaves.data(), (int)leaves.size());
+    if (m_root >= 0)
+        m_nodes[m_root].parent = -1;
+    ++m_rebuildCount;
+}
+
+void BVHDetection::updateTree()
+{
+    const SReal margin = d_boxMargin.getValue();
+    std::size_t moved = 0;
+
+    // insert the new models, and move the models which left their enlarged box
+    for (std::size_t i = 0; i < m_models.size(); ++i)
+    {
+        if (!m_bounded[i])
+            continue;
+
+        const Box& box = m_boxes[i];
+        int leaf;
+        const auto it = m_leaves.find(m_models[i]);
+        if (it == m_leaves.end())
+        {
+            leaf = allocateNode();
+            m_nodes[leaf].model = m_models[i];
+            m_leaves[m_models[i]] = leaf;
+        }
+        else
+        {
+            leaf = it->second;
+            if (contains(m_nodes[leaf].box, box))
+            {
+                m_nodes[leaf].index = (int)i;
+                m_nodes[leaf].step = m_step;
+                continue;
+            }
+            removeLeaf(leaf);
+        }
+
+        const SReal enlargement = margin * (box.maxBBox - box.minBBox).norm();
+        const Vector3 d(enlargement, enlargement, enlargement);
+        m_nodes[leaf].box.minBBox = box.minBBox - d;
+        m_nodes[leaf].box.maxBBox = box.maxBBox + d;
+        m_nodes[leaf].index = (int)i;
+        m_nodes[leaf].step = m_step;
+        insertLeaf(leaf);
+        ++moved;
+    }
+
+    // remove the models which were not added during this step
+    for (auto it = m_leaves.begin(); it != m_leaves.end(); )
+    {
+        const int leaf = it->second;
+        if (m_nodes[leaf].step != m_step)
+        {
+            removeLeaf(leaf);
+            freeNode(leaf);
+            it = m_leaves.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+
+    // rebuild the tree when it is unbalanced, or when most of it changed
+    const std::size_t leafCount = m_leaves.size();
+    if (leafCount > 2)
+    {
+        const int maxHeight = 2 * (int)std::ceil(std::log2((double)leafCount)) + 2;
+        if (getTreeHeight() > maxHeight || 2 * moved > leafCount)
+            rebuildTree();
+    }
+}
+
+void BVHDetection::queryCandidates(std::size_t first, std::size_t last)
+{
+    helper::vector<int> stack;
+    for (std::size_t i = first; i < last; ++i)
+    {
+        helper::vector<int>& candidates = m_candidates[i];
+        candidates.clear();
+
+        if (!m_bounded[i])
+        {
+            for (std::size_t j = 0; j < i; ++j)
+                candidates.push_back((int)j);
+            continue;
+        }
+
+        for (int j : m_unbounded)
+        {
+            if (j >= (int)i)
+                break;
+            candidates.push_back(j);
+        }
+
+        const Box& box = m_boxes[i];
+        if (m_root >= 0)
+            stack.push_back(m_root);
+        while (!stack.empty())
+        {
+            const TreeNode& n = m_nodes[stack.back()];
+            stack.pop_back();
+            if (!overlaps(n.box, box))
+                continue;
+
+            if (n.child1 < 0)
+            {
+                if (n.index < (int)i)
+                    candidates.push_back(n.index);
+            }
+            else
+            {
+                stack.push_back(n.child1);
+                stack.push_back(n.child2);
+            }
+        }
+
+        std::sort(candidates.begin(), candidates.end());
+    }
+}
+
+} // namespace collision
+
+} // namespace component
+
+} // namespace sofa
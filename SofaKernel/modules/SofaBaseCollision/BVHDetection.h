@@ -0,0 +1,130 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2019 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#ifndef SOFA_COMPONENT_COLLISION_BVHDETECTION_H
+#define SOFA_COMPONENT_COLLISION_BVHDETECTION_H
+#include "config.h"
+
+#include <SofaBaseCollision/BruteForceDetection.h>
+#include <sofa/defaulttype/Vec.h>
+
+#include <unordered_map>
+
+
+namespace sofa
+{
+
+namespace component
+{
+
+namespace collision
+{
+
+/**
+ * Broad phase keeping the bounding boxes of the root collision models in a dynamic AABB tree.
+ *
+ * The tree stores boxes enlarged by a margin, so that a model moving inside its enlarged box does
+ * not change the tree. Models leaving their box are removed and inserted again, and the whole tree
+ * is rebuilt, splitting the boxes sorted along their largest axis, when it becomes unbalanced.
+ * Each model then queries the tree for the models added before it, optionally in parallel tasks.
+ *
+ * The pairs are tested and reported in the same order as BruteForceDetection, whose narrow phase is used.
+ */
+class SOFA_BASE_COLLISION_API BVHDetection : public BruteForceDetection
+{
+public:
+    SOFA_CLASS(BVHDetection, BruteForceDetection);
+
+    Data<SReal> d_boxMargin; ///< enlargement of the boxes kept in the tree, relative to their size
+    Data<bool> d_parallel;   ///< query the tree in parallel tasks
+
+protected:
+    BVHDetection();
+
+    ~BVHDetection() override;
+
+public:
+
+    void init() override;
+
+    void beginBroadPhase() override;
+    void addCollisionModel(core::CollisionModel *cm) override;
+    void endBroadPhase() override;
+
+    /// number of times the whole tree has been rebuilt
+    unsigned int getRebuildCount() const { return m_rebuildCount; }
+
+    /// height of the tree, 0 for a single leaf and -1 for an empty tree
+    int getTreeHeight() const { return m_root < 0 ? -1 : m_nodes[m_root].height; }
+
+protected:
+
+    typedef sofa::defaulttype::Vector3 Vector3;
+
+    struct Box
+    {
+        Vector3 minBBox, maxBBox;
+    };
+
+    struct TreeNode
+    {
+        Box box;              ///< enlarged box of the model for the leaves, union of the children for the internal nodes
+        int parent;
+        int child1, child2;   ///< -1 for the leaves
+        int height;           ///< 0 for the leaves, -1 for the free nodes
+        core::CollisionModel* model;
+        int index;            ///< position of the model in the models added during the current step
+        unsigned int step;    ///< last step the model was added
+    };
+
+    helper::vector<TreeNode> m_nodes;
+    int m_root;
+    int m_freeNode;
+    std::unordered_map<core::CollisionModel*, int> m_leaves;
+    unsigned int m_step;
+    unsigned int m_rebuildCount;
+
+    helper::vector<core::CollisionModel*> m_models;       ///< root models added during the current step
+    helper::vector<Box> m_boxes;                          ///< their boxes, enlarged by the distance at which they are tested
+    helper::vector<bool> m_bounded;                       ///< false for the models without a root box, tested against all the others
+    helper::vector<int> m_unbounded;
+    helper::vector< helper::vector<int> > m_candidates;   ///< models added before each model and whose box overlaps its box
+
+    bool getRootBox(core::CollisionModel *cm, Box& box);
+
+    int allocateNode();
+    void freeNode(int node);
+    void insertLeaf(int leaf);
+    void removeLeaf(int leaf);
+    void refit(int node);
+    void rebuildTree();
+    int buildSubTree(int* leaves, int count);
+    void updateTree();
+    void queryCandidates(std::size_t first, std::size_t last);
+};
+
+} // namespace collision
+
+} // namespace component
+
+} // namespace sofa
+
+#endif
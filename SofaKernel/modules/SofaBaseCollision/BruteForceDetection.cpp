@@ -28,6 +28,8 @@
 #include <queue>
 #include <stack>
 #include <sofa/helper/AdvancedTimer.h>
+#include <sofa/simulation/TaskScheduler.h>
+#include <sofa/simulation/ParallelForEach.h>
 
 namespace sofa
 {
@@ -81,6 +83,20 @@ void BruteForceDetection::addCollisionModel(core::CollisionModel *cm)
     if (cm->empty())
         return;
 
+    if (!intersectsBox(cm))
+        return;
+
+    addSelfCollisionPair(cm);
+
+    for (sofa::helper::vector<core::CollisionModel*>::iterator it = collisionModels.begin(); it != collisionModels.end(); ++it)
+    {
+        addIntersectingPair(cm, *it);
+    }
+    collisionModels.push_back(cm);
+}
+
+bool BruteForceDetection::intersectsBox(core::CollisionModel *cm)
+{
     if (boxModel)
     {
         bool swapModels = false;
@@ -92,10 +108,14 @@ void BruteForceDetection::addCollisionModel(core::CollisionModel *cm)
 
             // Here we assume a single root element is present in both models
             if (!intersector->canIntersect(cm1->begin(), cm2->begin()))
-                return;
+                return false;
         }
     }
+    return true;
+}
 
+void BruteForceDetection::addSelfCollisionPair(core::CollisionModel *cm)
+{
     if (cm->isSimulated() && cm->getLast()->canCollideWith(cm->getLast()))
     {
         // self collision
@@ -108,54 +128,52 @@ void BruteForceDetection::addCollisionModel(core::CollisionModel *cm)
             }
 
     }
-    for (sofa::helper::vector<core::CollisionModel*>::iterator it = collisionModels.begin(); it != collisionModels.end(); ++it)
-    {
-        core::CollisionModel* cm2 = *it;
+}
 
-        if (!cm->isSimulated() && !cm2->isSimulated())
-        {
-            continue;
-        }
+void BruteForceDetection::addIntersectingPair(core::CollisionModel *cm, core::CollisionModel *cm2)
+{
+    if (!cm->isSimulated() && !cm2->isSimulated())
+    {
+        return;
+    }
 
-        if (!keepCollisionBetween(cm->getLast(), cm2->getLast()))
-            continue;
+    if (!keepCollisionBetween(cm->getLast(), cm2->getLast()))
+        return;
 
-        bool swapModels = false;
-        core::collision::ElementIntersector* intersector = intersectionMethod->findIntersector(cm, cm2, swapModels);
-        if (intersector == nullptr)
-            continue;
+    bool swapModels = false;
+    core::collision::ElementIntersector* intersector = intersectionMethod->findIntersector(cm, cm2, swapModels);
+    if (intersector == nullptr)
+        return;
 
-        core::CollisionModel* cm1 = (swapModels?cm2:cm);
-        cm2 = (swapModels?cm:cm2);
-
-        // // Here we assume multiple root elements are present in both models
-        // bool collisionDetected = false;
-        // core::CollisionElementIterator begin1 = cm->begin();
-        // core::CollisionElementIterator end1 = cm->end();
-        // core::CollisionElementIterator begin2 = cm2->begin();
-        // core::CollisionElementIterator end2 = cm2->end();
-        // for (core::CollisionElementIterator it1 = begin1; it1 != end1; ++it1)
-        // {
-        //     for (core::CollisionElementIterator it2 = begin2; it2 != end2; ++it2)
-        //     {
-        //         //if (!it1->canCollideWith(it2)) continue;
-        //         if (intersector->canIntersect(it1, it2))
-        //         {
-        //             collisionDetected = true;
-        //             break;
-        //         }
-        //     }
-        //     if (collisionDetected) break;
-        // }
-        // if (collisionDetected)
-
-        // Here we assume a single root element is present in both models
-        if (intersector->canIntersect(cm1->begin(), cm2->begin()))
-        {
-            cmPairs.push_back(std::make_pair(cm1, cm2));
-        }
+    core::CollisionModel* cm1 = (swapModels?cm2:cm);
+    cm2 = (swapModels?cm:cm2);
+
+    // // Here we assume multiple root elements are present in both models
+    // bool collisionDetected = false;
+    // core::CollisionElementIterator begin1 = cm->begin();
+    // core::CollisionElementIterator end1 = cm->end();
+    // core::CollisionElementIterator begin2 = cm2->begin();
+    // core::CollisionElementIterator end2 = cm2->end();
+    // for (core::CollisionElementIterator it1 = begin1; it1 != end1; ++it1)
+    // {
+    //     for (core::CollisionElementIterator it2 = begin2; it2 != end2; ++it2)
+    //     {
+    //         //if (!it1->canCollideWith(it2)) continue;
+    //         if (intersector->canIntersect(it1, it2))
+    //         {
+    //             collisionDetected = true;
+    //             break;
+    //         }
+    //     }
+    //     if (collisionDetected) break;
+    // }
+    // if (collisionDetected)
+
+    // Here we assume a single root element is present in both models
+    if (intersector->canIntersect(cm1->begin(), cm2->begin()))
+    {
+        cmPairs.push_back(std::make_pair(cm1, cm2));
     }
-    collisionModels.push_back(cm);
 }
 
 
@@ -172,28 +190,73 @@ bool BruteForceDetection::keepCollisionBetween(core::CollisionModel *cm1, core::
 
 
 void BruteForceDetection::addCollisionPair(const std::pair<core::CollisionModel*, core::CollisionModel*>& cmPair)
-{    
-    typedef std::pair< std::pair<core::CollisionElementIterator,core::CollisionElementIterator>, std::pair<core::CollisionElementIterator,core::CollisionElementIterator> > TestPair;
+{
+    if (!cmPair.first->isSimulated() && !cmPair.second->isSimulated())
+        return;
+
+    if (cmPair.first->empty() || cmPair.second->empty())
+        return;
 
+    std::string msg = "BruteForceDetection addCollisionPair: " + cmPair.first->getLast()->getName() + " - " + cmPair.second->getLast()->getName();
+    sofa::helper::ScopedAdvancedTimer bfTimer(msg);
+
+    PairTest test;
+    if (beginCollisionPair(cmPair, test))
+        testCollisionPair(test);
+}
+
+void BruteForceDetection::addCollisionPairsParallel(const sofa::helper::vector< std::pair<core::CollisionModel*, core::CollisionModel*> >& v, simulation::TaskScheduler& scheduler)
+{
+    // The output vectors are created sequentially, as the map of the outputs is shared.
+    // Pairs writing into the same output vector are tested in the same task.
+    sofa::helper::vector< sofa::helper::vector<PairTest> > tests;
+    std::map< core::collision::DetectionOutputVector*, std::size_t > testIndex;
+    for (sofa::helper::vector< std::pair<core::CollisionModel*, core::CollisionModel*> >::const_iterator it = v.begin(); it != v.end(); ++it)
+    {
+        PairTest test;
+        if (!beginCollisionPair(*it, test))
+            continue;
+
+        std::map< core::collision::DetectionOutputVector*, std::size_t >::iterator index = testIndex.find(test.outputs);
+        if (index == testIndex.end())
+        {
+            testIndex[test.outputs] = tests.size();
+            tests.push_back(sofa::helper::vector<PairTest>(1, test));
+        }
+        else
+        {
+            tests[index->second].push_back(test);
+        }
+    }
+
+    // each task only writes into its own output vector, so the outputs do not depend on the scheduling
+    simulation::parallelForEach(scheduler, 0, tests.size(), [this, &tests](std::size_t i)
+    {
+        for (const PairTest& test : tests[i])
+            testCollisionPair(test);
+    });
+
+    m_primitiveTestCount = m_outputsMap.size();
+}
+
+bool BruteForceDetection::beginCollisionPair(const std::pair<core::CollisionModel*, core::CollisionModel*>& cmPair, PairTest& test)
+{
     core::CollisionModel *cm1 = cmPair.first; //->getNext();
     core::CollisionModel *cm2 = cmPair.second; //->getNext();
 
     if (!cm1->isSimulated() && !cm2->isSimulated())
-        return;
+        return false;
 
     if (cm1->empty() || cm2->empty())
-        return;
+        return false;
 
     core::CollisionModel *finalcm1 = cm1->getLast();//get the finnest CollisionModel which is not a CubeModel
     core::CollisionModel *finalcm2 = cm2->getLast();
 
-    std::string msg = "BruteForceDetection addCollisionPair: " + finalcm1->getName() + " - " + finalcm2->getName();
-    sofa::helper::ScopedAdvancedTimer bfTimer(msg);
-    
     bool swapModels = false;
     core::collision::ElementIntersector* finalintersector = intersectionMethod->findIntersector(finalcm1, finalcm2, swapModels);//find the method for the finnest CollisionModels
     if (finalintersector == nullptr)
-        return;
+        return false;
     if (swapModels)
     {
         core::CollisionModel* tmp;
@@ -201,11 +264,12 @@ void BruteForceDetection::addCollisionPair(const std::pair<core::CollisionModel*
         tmp = finalcm1; finalcm1 = finalcm2; finalcm2 = tmp;
     }
 
-    const bool self = (finalcm1->getContext() == finalcm2->getContext());
+    test.self = (finalcm1->getContext() == finalcm2->getContext());
 
     sofa::core::collision::DetectionOutputVector*& outputs = this->getDetectionOutputs(finalcm1, finalcm2);
 
     finalintersector->beginIntersect(finalcm1, finalcm2, outputs);//creates outputs if null
+    test.outputs = outputs;
 
     if (finalcm1 == cm1 || finalcm2 == cm2)
     {
@@ -215,6 +279,27 @@ void BruteForceDetection::addCollisionPair(const std::pair<core::CollisionModel*
         finalintersector = nullptr;
     }
 
+    test.cm1 = cm1;
+    test.cm2 = cm2;
+    test.finalcm1 = finalcm1;
+    test.finalcm2 = finalcm2;
+    test.finalintersector = finalintersector;
+    return true;
+}
+
+void BruteForceDetection::testCollisionPair(const PairTest& test)
+{
+    typedef std::pair< std::pair<core::CollisionElementIterator,core::CollisionElementIterator>, std::pair<core::CollisionElementIterator,core::CollisionElementIterator> > TestPair;
+
+    core::CollisionModel *cm1 = test.cm1;
+    core::CollisionModel *cm2 = test.cm2;
+    core::CollisionModel *finalcm1 = test.finalcm1;
+    core::CollisionModel *finalcm2 = test.finalcm2;
+    core::collision::ElementIntersector* finalintersector = test.finalintersector;
+    core::collision::DetectionOutputVector* outputs = test.outputs;
+    const bool self = test.self;
+    bool swapModels = false;
+
     std::queue< TestPair > externalCells;
 
     std::pair<core::CollisionElementIterator,core::CollisionElementIterator> internalChildren1 = cm1->begin().getInternalChildren();
@@ -253,11 +338,15 @@ void BruteForceDetection::addCollisionPair(const std::pair<core::CollisionModel*
             cm1 = root.first.first.getCollisionModel();
             cm2 = root.second.first.getCollisionModel();
             if (!cm1 || !cm2) continue;
-            intersector = intersectionMethod->findIntersector(cm1, cm2, swapModels);
-
-            if (intersector == nullptr)
             {
-                msg_error() << "BruteForceDetection: Error finding intersector " << intersectionMethod->getName() << " for "<<cm1->getClassName()<<" - "<<cm2->getClassName()<<sendl;
+                // the intersection method fills its cache of intersectors lazily, lock it when pairs are tested in parallel
+                std::lock_guard<std::mutex> lock(m_intersectorMutex);
+                intersector = intersectionMethod->findIntersector(cm1, cm2, swapModels);
+
+                if (intersector == nullptr)
+                {
+                    msg_error() << "BruteForceDetection: Error finding intersector " << intersectionMethod->getName() << " for "<<cm1->getClassName()<<" - "<<cm2->getClassName()<<sendl;
+                }
             }
 
             if (swapModels)
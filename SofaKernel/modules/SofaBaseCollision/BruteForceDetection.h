@@ -29,10 +29,17 @@
 #include <SofaBaseCollision/CubeModel.h>
 #include <sofa/defaulttype/Vec.h>
 
+#include <mutex>
+
 
 namespace sofa
 {
 
+namespace simulation
+{
+class TaskScheduler;
+}
+
 namespace component
 {
 
@@ -89,18 +96,44 @@ private:
     bool _is_initialized;
     sofa::helper::vector<core::CollisionModel*> collisionModels;
 
+protected:
     Data< helper::fixed_array<sofa::defaulttype::Vector3,2> > box; ///< if not empty, objects that do not intersect this bounding-box will be ignored
 
     CubeModel::SPtr boxModel;
 
+    std::mutex m_intersectorMutex;
 
-protected:
     BruteForceDetection();
 
     ~BruteForceDetection() override;
 
     virtual bool keepCollisionBetween(core::CollisionModel *cm1, core::CollisionModel *cm2);
 
+    /// Returns false if a box is given and the root element of cm does not intersect it
+    bool intersectsBox(core::CollisionModel *cm);
+
+    /// Add the pair (cm, cm) if cm can collide with itself
+    void addSelfCollisionPair(core::CollisionModel *cm);
+
+    /// Add the pair of root collision models, in the order expected by their intersector, if their root elements intersect
+    void addIntersectingPair(core::CollisionModel *cm, core::CollisionModel *cm2);
+
+    /// Intersection tests of a pair of root collision models, in the order expected by the intersector
+    struct PairTest
+    {
+        core::CollisionModel *cm1, *cm2;
+        core::CollisionModel *finalcm1, *finalcm2; ///< finest models, nullptr if they also contain the root element
+        core::collision::ElementIntersector* finalintersector;
+        core::collision::DetectionOutputVector* outputs;
+        bool self;
+    };
+
+    /// Find the intersector of a pair and create its output vector. Returns false if the pair cannot collide
+    bool beginCollisionPair(const std::pair<core::CollisionModel*, core::CollisionModel*>& cmPair, PairTest& test);
+
+    /// Traverse the bounding trees of a pair prepared by beginCollisionPair. Only writes into the outputs of the pair
+    void testCollisionPair(const PairTest& test);
+
 public:
 
     void init() override;
@@ -109,6 +142,10 @@ public:
     void addCollisionModel (core::CollisionModel *cm) override;
     void addCollisionPair (const std::pair<core::CollisionModel*, core::CollisionModel*>& cmPair) override;
 
+    /// Same as addCollisionPairs, testing each pair of collision models in a separate task.
+    /// The intersectors must only read the collision models, as the stock ones do
+    void addCollisionPairsParallel(const sofa::helper::vector< std::pair<core::CollisionModel*, core::CollisionModel*> >& v, simulation::TaskScheduler& scheduler);
+
     void beginBroadPhase() override
     {
         core::collision::BroadPhaseDetection::beginBroadPhase();
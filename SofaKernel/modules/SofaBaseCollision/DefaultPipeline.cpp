@@ -20,6 +20,7 @@
 * Contact information: contact@sofa-framework.org                             *
 ******************************************************************************/
 #include <SofaBaseCollision/DefaultPipeline.h>
+#include <SofaBaseCollision/BruteForceDetection.h>
 
 #include <sofa/core/CollisionModel.h>
 #include <sofa/core/ObjectFactory.h>
@@ -30,6 +31,7 @@
 #include <sofa/core/visual/VisualParams.h>
 
 #include <sofa/simulation/Node.h>
+#include <sofa/simulation/TaskScheduler.h>
 
 #ifdef SOFA_DUMP_VISITOR_INFO
 #include <sofa/simulation/Visitor.h>
@@ -68,6 +70,8 @@ DefaultPipeline::DefaultPipeline()
     //TODO(dmarchal 2017-05-16) Fix the min & max value with response from a github issue. Remove in 1 year if not done.
     , d_depth(initData(&d_depth, 6, "depth",
                        "Max depth of bounding trees. (default=6, min=?, max=?)"))
+    , d_parallelNarrowPhase(initData(&d_parallelNarrowPhase, false, "parallelNarrowPhase",
+                                     "Test each pair of collision models of the narrow phase in a separate task. Requires a narrow phase based on BruteForceDetection. (default=false)"))
 {
 }
 
@@ -81,6 +85,11 @@ void DefaultPipeline::init()
 
     /// Insure that all the value provided by the user are valid and report message if it is not.
     checkDataValues() ;
+
+    if (d_parallelNarrowPhase.getValue())
+    {
+        simulation::TaskScheduler::getInstance();
+    }
 }
 
 void DefaultPipeline::checkDataValues()
@@ -91,6 +100,13 @@ void DefaultPipeline::checkDataValues()
                       << "Replaced with the default value = 6." ;
         d_depth.setValue(6) ;
     }
+
+    if(d_parallelNarrowPhase.getValue() && narrowPhaseDetection != nullptr
+            && dynamic_cast<BruteForceDetection*>(narrowPhaseDetection) == nullptr)
+    {
+        msg_warning() << "'parallelNarrowPhase' is not supported by the narrow phase " << narrowPhaseDetection->getName() << "." << msgendl
+                      << "The pairs of collision models will be tested sequentially." ;
+    }
 }
 
 void DefaultPipeline::doCollisionReset()
@@ -209,7 +225,11 @@ void DefaultPipeline::doCollisionDetection(const helper::vector<core::CollisionM
         msg_info_when(d_doPrintInfoMessage.getValue())
                 << "doCollisionDetection, "<< vectCMPair.size()<<" colliding model pairs" ;
 
-        narrowPhaseDetection->addCollisionPairs(vectCMPair);
+        BruteForceDetection* parallelNarrowPhase = d_parallelNarrowPhase.getValue() ? dynamic_cast<BruteForceDetection*>(narrowPhaseDetection) : nullptr;
+        if (parallelNarrowPhase != nullptr)
+            parallelNarrowPhase->addCollisionPairsParallel(vectCMPair, *simulation::TaskScheduler::getInstance());
+        else
+            narrowPhaseDetection->addCollisionPairs(vectCMPair);
         narrowPhaseDetection->endNarrowPhase();
         intersectionMethod->endNarrowPhase();
     }
@@ -42,6 +42,7 @@ public:
     Data<bool> d_doPrintInfoMessage;
     Data<bool> d_doDebugDraw;
     Data<int>  d_depth;
+    Data<bool> d_parallelNarrowPhase; ///< test the pairs of collision models of the narrow phase in parallel tasks
 protected:
     DefaultPipeline();
 public:
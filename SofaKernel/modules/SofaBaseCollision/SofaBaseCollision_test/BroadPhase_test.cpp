@@ -21,6 +21,8 @@
 ******************************************************************************/
 #include "BroadPhase_test.h"
 #include <SofaBaseCollision/BruteForceDetection.h>
+#include <SofaBaseCollision/BVHDetection.h>
+#include <sofa/simulation/DefaultTaskScheduler.h>
 
 typedef BroadPhaseTest<sofa::component::collision::BruteForceDetection> Brut;
 TEST_F(Brut, rand_sparse_test ) { ASSERT_TRUE( randSparse()); }
@@ -33,3 +35,132 @@ TEST_F(IncrSAPTest, rand_dense_test ) { ASSERT_TRUE( randDense()); }
 typedef BroadPhaseTest<sofa::component::collision::DirectSAP> DirectSAPTest;
 TEST_F(DirectSAPTest, rand_sparse_test ) { ASSERT_TRUE( randSparse()); }
 TEST_F(DirectSAPTest, rand_dense_test ) { ASSERT_TRUE( randDense()); }
+
+typedef BroadPhaseTest<sofa::component::collision::BVHDetection> BVHTest;
+TEST_F(BVHTest, rand_sparse_test ) { ASSERT_TRUE( randSparse()); }
+TEST_F(BVHTest, rand_dense_test ) { ASSERT_TRUE( randDense()); }
+
+/// Check that BVHDetection finds the same pairs of collision models as BruteForceDetection,
+/// in the same order, on many models moving, appearing and disappearing
+static void testSameModelPairsAsBruteForce(bool parallel)
+{
+    using sofa::component::collision::BruteForceDetection;
+    using sofa::component::collision::BVHDetection;
+    using sofa::component::collision::OBBModel;
+
+    sofa::helper::srand(0);
+    const Vector3 min(-10,-10,-10);
+    const Vector3 max(10,10,10);
+
+    sofa::simulation::Node::SPtr scn = New<sofa::simulation::tree::GNode>();
+    std::vector<OBBModel::SPtr> models;
+    for(int i = 0 ; i < 200 ; ++i){
+        std::vector<Vector3> p;
+        for(int j = 0 ; j <= i % 3 ; ++j)
+            p.push_back(randVect(min,max));
+        models.push_back(makeOBBModel(p,scn,0.5));
+        models.back()->setSelfCollision(i % 2 == 0);
+    }
+
+    BruteForceDetection::SPtr bruteForce = New<BruteForceDetection>();
+    BVHDetection::SPtr bvh = New<BVHDetection>();
+    bruteForce->setIntersectionMethod(proxIntersection.get());
+    bvh->setIntersectionMethod(proxIntersection.get());
+    bvh->d_parallel.setValue(parallel);
+
+    for(int step = 0 ; step < 10 ; ++step){
+        bruteForce->beginBroadPhase();
+        bvh->beginBroadPhase();
+        for(std::size_t i = 0 ; i < models.size() ; ++i){
+            if((i + step) % 7 == 0)
+                continue;
+            bruteForce->addCollisionModel(models[i]->getFirst());
+            bvh->addCollisionModel(models[i]->getFirst());
+        }
+        bruteForce->endBroadPhase();
+        bvh->endBroadPhase();
+
+        ASSERT_FALSE(bruteForce->getCollisionModelPairs().empty());
+        ASSERT_TRUE(bruteForce->getCollisionModelPairs() == bvh->getCollisionModelPairs()) << "step " << step;
+
+        for(std::size_t i = 0 ; i < models.size() ; ++i)
+            randMoving(models[i].get(),min,max);
+    }
+
+    EXPECT_GE(bvh->getRebuildCount(), 1u);
+    EXPECT_LE(bvh->getTreeHeight(), 2 * 8 + 2);
+}
+
+TEST(BVHDetection, same_pairs_as_brute_force) { testSameModelPairsAsBruteForce(false); }
+
+TEST(BVHDetection, same_pairs_as_brute_force_parallel)
+{
+    using sofa::simulation::TaskScheduler;
+    TaskScheduler* scheduler = TaskScheduler::create(sofa::simulation::DefaultTaskScheduler::name());
+    scheduler->init(4);
+    testSameModelPairsAsBruteForce(true);
+    scheduler->stop();
+}
+
+/// Check that testing the pairs of collision models in parallel tasks gives the same outputs as sequentially
+TEST(BruteForceDetection, parallel_narrow_phase)
+{
+    using sofa::component::collision::BruteForceDetection;
+    using sofa::component::collision::OBBModel;
+    using sofa::core::collision::DetectionOutput;
+    using sofa::simulation::TaskScheduler;
+    typedef sofa::helper::vector<DetectionOutput> Outputs;
+
+    TaskScheduler* scheduler = TaskScheduler::create(sofa::simulation::DefaultTaskScheduler::name());
+    scheduler->init(4);
+
+    sofa::helper::srand(0);
+    const Vector3 min(-5,-5,-5);
+    const Vector3 max(5,5,5);
+
+    sofa::simulation::Node::SPtr scn = New<sofa::simulation::tree::GNode>();
+    std::vector<OBBModel::SPtr> models;
+    for(int i = 0 ; i < 20 ; ++i){
+        std::vector<Vector3> p;
+        for(int j = 0 ; j < 10 ; ++j)
+            p.push_back(randVect(min,max));
+        models.push_back(makeOBBModel(p,scn,1.2));
+        models.back()->setSelfCollision(true);
+    }
+
+    BruteForceDetection::SPtr detections[2] = { New<BruteForceDetection>(), New<BruteForceDetection>() };
+    for(int d = 0 ; d < 2 ; ++d){
+        BruteForceDetection& detection = *detections[d];
+        detection.setIntersectionMethod(proxIntersection.get());
+        detection.beginBroadPhase();
+        for(std::size_t i = 0 ; i < models.size() ; ++i)
+            detection.addCollisionModel(models[i]->getFirst());
+        detection.endBroadPhase();
+
+        detection.beginNarrowPhase();
+        if(d == 0)
+            detection.addCollisionPairs(detection.getCollisionModelPairs());
+        else
+            detection.addCollisionPairsParallel(detection.getCollisionModelPairs(), *scheduler);
+        detection.endNarrowPhase();
+    }
+    scheduler->stop();
+
+    const BruteForceDetection::DetectionOutputMap& sequentialOutputs = detections[0]->getDetectionOutputs();
+    ASSERT_FALSE(sequentialOutputs.empty());
+    ASSERT_EQ(sequentialOutputs.size(), detections[1]->getDetectionOutputs().size());
+    ASSERT_EQ(detections[0]->getPrimitiveTestCount(), detections[1]->getPrimitiveTestCount());
+
+    for(BruteForceDetection::DetectionOutputMap::const_iterator it = sequentialOutputs.begin() ; it != sequentialOutputs.end() ; ++it){
+        const Outputs* sequential = dynamic_cast<const Outputs*>(it->second);
+        const Outputs* parallel = dynamic_cast<const Outputs*>(detections[1]->getDetectionOutputs(it->first.first,it->first.second));
+        ASSERT_NE(sequential, nullptr);
+        ASSERT_NE(parallel, nullptr);
+        ASSERT_EQ(sequential->size(), parallel->size());
+        for(std::size_t i = 0 ; i < sequential->size() ; ++i){
+            EXPECT_EQ((*sequential)[i].elem, (*parallel)[i].elem);
+            EXPECT_EQ((*sequential)[i].point[0], (*parallel)[i].point[0]);
+            EXPECT_EQ((*sequential)[i].point[1], (*parallel)[i].point[1]);
+        }
+    }
+}
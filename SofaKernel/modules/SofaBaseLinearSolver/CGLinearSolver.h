@@ -24,6 +24,8 @@
 #include "config.h"
 
 #include <SofaBaseLinearSolver/MatrixLinearSolver.h>
+#include <SofaBaseLinearSolver/CompressedRowSparseMatrix.h>
+#include <sofa/simulation/TaskScheduler.h>
 
 #include <sofa/helper/map.h>
 
@@ -57,6 +59,7 @@ public:
     Data<bool> f_warmStart; ///< Use previous solution as initial solution
     Data<bool> f_verbose; ///< Dump system state at each iteration
     Data<std::map < std::string, sofa::helper::vector<SReal> > > f_graph; ///< Graph of residuals at each iteration
+    Data<bool> d_parallelProduct; ///< Compute the matrix-vector products on the task scheduler
 #ifdef DISPLAY_TIME
     SReal time1;
     SReal time2;
@@ -70,8 +73,14 @@ protected:
     /// It computes: p = p*beta + r
     inline void cgstep_beta(const core::ExecParams* params, Vector& p, Vector& r, SReal beta);
     /// This method is separated from the rest to be able to use custom/optimized versions depending on the types of vectors.
-    /// It computes: x += p*alpha, r -= q*alpha
-    inline void cgstep_alpha(const core::ExecParams* params, Vector& x, Vector& r, Vector& p, Vector& q, SReal alpha);
+    /// It computes: x += p*alpha, r -= q*alpha, and returns r.r for the next iteration
+    inline SReal cgstep_alpha(const core::ExecParams* params, Vector& x, Vector& r, Vector& p, Vector& q, SReal alpha);
+
+    /// It computes: q = M*p, on the task scheduler for the assembled CompressedRowSparseMatrix types
+    template<class TMatrix2>
+    void parallelMul(TMatrix2& M, Vector& q, Vector& p) { q = M*p; }
+    template<class TBloc, class TVecBloc, class TVecIndex>
+    void parallelMul(CompressedRowSparseMatrix<TBloc,TVecBloc,TVecIndex>& M, Vector& q, Vector& p) { M.mulParallel(q, p, *simulation::TaskScheduler::getInstance()); }
 
     int timeStepCount;
     bool equilibriumReached;
@@ -93,7 +102,7 @@ template<>
 inline void CGLinearSolver<component::linearsolver::GraphScatteredMatrix,component::linearsolver::GraphScatteredVector>::cgstep_beta(const core::ExecParams* /*params*/, Vector& p, Vector& r, SReal beta);
 
 template<>
-inline void CGLinearSolver<component::linearsolver::GraphScatteredMatrix,component::linearsolver::GraphScatteredVector>::cgstep_alpha(const core::ExecParams* params, Vector& x, Vector& r, Vector& p, Vector& q, SReal alpha);
+inline SReal CGLinearSolver<component::linearsolver::GraphScatteredMatrix,component::linearsolver::GraphScatteredVector>::cgstep_alpha(const core::ExecParams* params, Vector& x, Vector& r, Vector& p, Vector& q, SReal alpha);
 
 #if  !defined(SOFA_COMPONENT_LINEARSOLVER_CGLINEARSOLVER_CPP)
 extern template class SOFA_BASE_LINEAR_SOLVER_API CGLinearSolver< GraphScatteredMatrix, GraphScatteredVector >;
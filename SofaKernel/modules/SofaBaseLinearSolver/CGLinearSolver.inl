@@ -52,6 +52,7 @@ CGLinearSolver<TMatrix,TVector>::CGLinearSolver()
     , f_warmStart( initData(&f_warmStart,false,"warmStart","Use previous solution as initial solution") )
     , f_verbose( initData(&f_verbose,false,"verbose","Dump system state at each iteration") )
     , f_graph( initData(&f_graph,"graph","Graph of residuals at each iteration") )
+    , d_parallelProduct( initData(&d_parallelProduct,false,"parallelProduct","Compute the matrix-vector products on the task scheduler (assembled CompressedRowSparseMatrix types only)") )
 {
     f_graph.setWidget("graph");
 #ifdef DISPLAY_TIME
@@ -90,6 +91,9 @@ void CGLinearSolver<TMatrix,TVector>::init()
         f_smallDenominatorThreshold.setValue(1e-5);
     }
 
+    if (d_parallelProduct.getValue())
+        simulation::TaskScheduler::getInstance();
+
     timeStepCount = 0;
     equilibriumReached = false;
 }
@@ -200,8 +204,9 @@ void CGLinearSolver<TMatrix,TVector>::solve(Matrix& M, Vector& x, Vector& b)
             }
 #endif
 
-            /// Compute p = r^2
-            rho = r.dot(r);
+            /// Compute p = r^2 (computed with the update of r after the first iteration)
+            if( nb_iter==1 )
+                rho = r.dot(r);
 
             /// Compute the error from the norm of ρ and b
             double normr = sqrt(rho);
@@ -263,7 +268,10 @@ void CGLinearSolver<TMatrix,TVector>::solve(Matrix& M, Vector& x, Vector& b)
             }
 
             /// Compute the matrix-vector product : M p
-            q = M*p;
+            if (d_parallelProduct.getValue())
+                parallelMul(M, q, p);
+            else
+                q = M*p;
 
             if( verbose )
             {
@@ -316,8 +324,10 @@ void CGLinearSolver<TMatrix,TVector>::solve(Matrix& M, Vector& x, Vector& b)
                 /// Compute the coefficient α for the conjugate direction
                 alpha = rho/den;
 
-                /// End of the CG step : update x and r
-                cgstep_alpha(params, x,r,p,q,alpha);
+                rho_1 = rho;
+
+                /// End of the CG step : update x and r, and compute r^2 for the next iteration
+                rho = cgstep_alpha(params, x,r,p,q,alpha);
 
                 if( verbose )
                 {
@@ -330,8 +340,6 @@ void CGLinearSolver<TMatrix,TVector>::solve(Matrix& M, Vector& x, Vector& b)
                 break;
             }
 
-            rho_1 = rho;
-
 #ifdef SOFA_DUMP_VISITOR_INFO
             if (simulation::Visitor::isPrintActivated())
                 simulation::Visitor::printCloseNode(comment.str());
@@ -347,7 +355,10 @@ void CGLinearSolver<TMatrix,TVector>::solve(Matrix& M, Vector& x, Vector& b)
         if( timeStepCount==0 )
         {
             p = r;
-            q = M*p;
+            if (d_parallelProduct.getValue())
+                parallelMul(M, q, p);
+            else
+                q = M*p;
             double den = p.dot(q);
 
             if(den != 0.0)
@@ -396,13 +407,15 @@ inline void CGLinearSolver<TMatrix,TVector>::cgstep_beta(const core::ExecParams*
 }
 
 template<class TMatrix, class TVector>
-inline void CGLinearSolver<TMatrix,TVector>::cgstep_alpha(const core::ExecParams* /*params*/, Vector& x, Vector& r, Vector& p, Vector& q, SReal alpha)
+inline SReal CGLinearSolver<TMatrix,TVector>::cgstep_alpha(const core::ExecParams* /*params*/, Vector& x, Vector& r, Vector& p, Vector& q, SReal alpha)
 {
     // x = x + alpha p
     x.peq(p,alpha);
 
     // r = r - alpha q
     r.peq(q,-alpha);
+
+    return r.dot(r);
 }
 
 } // namespace linearsolver
@@ -27,7 +27,15 @@
 #include <SofaBaseLinearSolver/MatrixExpr.h>
 #include <SofaBaseLinearSolver/matrix_bloc_traits.h>
 #include "FullVector.h"
+#include <sofa/simulation/TaskScheduler.h>
+#include <sofa/simulation/ParallelForEach.h>
 #include <algorithm>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SOFA_COMPRESSEDROWSPARSEMATRIX_HAVE_SSE2
+#include <emmintrin.h>
+#endif
 
 namespace sofa
 {
@@ -49,6 +57,60 @@ namespace linearsolver
 #define EMIT_EXTRA_MESSAGE false
 #endif
 
+/// Products of a block of CompressedRowSparseMatrix with chunks of a large vector, used by the parallel products
+template<class TBloc, class Real2>
+struct CompressedRowSparseMatrixBlocProduct
+{
+    typedef matrix_bloc_traits<TBloc> traits;
+    enum { NL = traits::NL };
+    enum { NC = traits::NC };
+
+    /// r += b * v
+    static void addMul(Real2* r, const TBloc& b, const Real2* v)
+    {
+        for (int bi = 0; bi < NL; ++bi)
+            for (int bj = 0; bj < NC; ++bj)
+                r[bi] += traits::v(b, bi, bj) * v[bj];
+    }
+
+    /// r += b^T * v
+    static void addMulTranspose(Real2* r, const TBloc& b, const Real2* v)
+    {
+        for (int bi = 0; bi < NL; ++bi)
+            for (int bj = 0; bj < NC; ++bj)
+                r[bj] += traits::v(b, bi, bj) * v[bi];
+    }
+};
+
+#ifdef SOFA_COMPRESSEDROWSPARSEMATRIX_HAVE_SSE2
+/// 3x3 blocks of the assembled systems of 3D meshes: the first two rows of the product are computed as a pair
+template<>
+struct CompressedRowSparseMatrixBlocProduct<defaulttype::Mat<3,3,double>, double>
+{
+    typedef defaulttype::Mat<3,3,double> Bloc;
+
+    static void addMul(double* r, const Bloc& b, const double* v)
+    {
+        const __m128d v01 = _mm_loadu_pd(v);
+        const __m128d m0 = _mm_mul_pd(_mm_loadu_pd(&b[0][0]), v01);
+        const __m128d m1 = _mm_mul_pd(_mm_loadu_pd(&b[1][0]), v01);
+        __m128d r01 = _mm_add_pd(_mm_unpacklo_pd(m0, m1), _mm_unpackhi_pd(m0, m1));
+        r01 = _mm_add_pd(r01, _mm_mul_pd(_mm_set_pd(b[1][2], b[0][2]), _mm_set1_pd(v[2])));
+        _mm_storeu_pd(r, _mm_add_pd(_mm_loadu_pd(r), r01));
+        r[2] += b[2][0] * v[0] + b[2][1] * v[1] + b[2][2] * v[2];
+    }
+
+    static void addMulTranspose(double* r, const Bloc& b, const double* v)
+    {
+        __m128d r01 = _mm_mul_pd(_mm_loadu_pd(&b[0][0]), _mm_set1_pd(v[0]));
+        r01 = _mm_add_pd(r01, _mm_mul_pd(_mm_loadu_pd(&b[1][0]), _mm_set1_pd(v[1])));
+        r01 = _mm_add_pd(r01, _mm_mul_pd(_mm_loadu_pd(&b[2][0]), _mm_set1_pd(v[2])));
+        _mm_storeu_pd(r, _mm_add_pd(_mm_loadu_pd(r), r01));
+        r[2] += b[0][2] * v[0] + b[1][2] * v[1] + b[2][2] * v[2];
+    }
+};
+#endif
+
 template<typename TBloc, typename TVecBloc = helper::vector<TBloc>, typename TVecIndex = helper::vector<int> >
 class CompressedRowSparseMatrix : public defaulttype::BaseMatrix
 {
@@ -1332,6 +1394,73 @@ protected:
       }
 
 
+      /// Split the non-empty block rows in chunks of about the same number of blocks, a few per thread.
+      /// Returns the first non-empty row of each chunk, followed by the number of non-empty rows.
+      std::vector<Index> parallelChunks(const unsigned int threadCount) const
+      {
+          const Index nbRows = (Index)rowIndex.size();
+          const Index nbBlocs = nbRows > 0 ? rowBegin[nbRows] : 0;
+          const Index minBlocsPerChunk = 2048;
+          Index nbChunks = threadCount > 1 ? std::min((Index)threadCount * 4, nbBlocs / minBlocsPerChunk) : 1;
+          nbChunks = std::max(nbChunks, (Index)1);
+
+          std::vector<Index> chunks(1, 0);
+          for (Index c = 1; c < nbChunks; ++c)
+          {
+              const Index target = (Index)((long long)nbBlocs * c / nbChunks);
+              const Index xi = (Index)(std::lower_bound(rowBegin.begin(), rowBegin.begin() + nbRows, target) - rowBegin.begin());
+              if (xi > chunks.back() && xi < nbRows) chunks.push_back(xi);
+          }
+          chunks.push_back(nbRows);
+          return chunks;
+      }
+
+      /// Block rows covered by a chunk, including the empty rows before the next chunk
+      Index chunkRowBegin(const std::vector<Index>& chunks, const std::size_t c) const
+      {
+          return c == 0 ? 0 : rowIndex[chunks[c]];
+      }
+      Index chunkRowEnd(const std::vector<Index>& chunks, const std::size_t c) const
+      {
+          return c + 2 == chunks.size() ? rowBSize() : rowIndex[chunks[c+1]];
+      }
+
+      /** Product of the matrix with a full vector computed on the task scheduler, res = this * vec or res += this * vec */
+      template<class Real2, bool add>
+      void taddMulParallel(FullVector<Real2>& res, const FullVector<Real2>& vec, simulation::TaskScheduler& scheduler) const
+      {
+          typedef CompressedRowSparseMatrixBlocProduct<Bloc,Real2> BlocProduct;
+          assert( vec.size() == colSize() );
+
+          ((Matrix*)this)->compress();
+          if (!add)
+              res.fastResize( rowSize() );
+          else if (res.size() != rowSize())
+              res.resize( rowSize() );
+
+          const std::vector<Index> chunks = parallelChunks( scheduler.getThreadCount() );
+          const Real2* vp = vec.ptr();
+          Real2* rp = res.ptr();
+
+          auto chunkProduct = [&](const std::size_t c)
+          {
+              if (!add)
+                  std::fill(rp + chunkRowBegin(chunks, c) * NL, rp + chunkRowEnd(chunks, c) * NL, Real2());
+
+              for (Index xi = chunks[c]; xi < chunks[c+1]; ++xi)
+              {
+                  Real2 r[NL] = {};
+                  for (Index xj = rowBegin[xi]; xj < rowBegin[xi+1]; ++xj)
+                      BlocProduct::addMul(r, colsValue[xj], vp + colsIndex[xj] * NC);
+
+                  Real2* ri = rp + rowIndex[xi] * NL;
+                  for (Index bi = 0; bi < NL; ++bi)
+                      ri[bi] += r[bi];
+              }
+          };
+          simulation::parallelForEach(scheduler, 0, chunks.size() - 1, chunkProduct);
+      }
+
       /** Product of the matrix with a templated vector that have the size of the bloc res += this * [vec,...,vec]^T */
       template<class Real2, class V1, class V2>
       void taddMul_by_line(V1& res, const V2& vec) const
@@ -1581,6 +1710,103 @@ public:
         taddMul< Real,V1,V2 >( res, v );
     }
 
+    /// result = this * v, the block rows being split in chunks of about the same number of blocks computed on the task scheduler
+    template< typename Real2 >
+    void mulParallel( FullVector<Real2>& res, const FullVector<Real2>& v, simulation::TaskScheduler& scheduler ) const
+    {
+        taddMulParallel<Real2,false>( res, v, scheduler );
+    }
+
+    /// result += this * v, computed on the task scheduler
+    template< typename Real2 >
+    void addMulParallel( FullVector<Real2>& res, const FullVector<Real2>& v, simulation::TaskScheduler& scheduler ) const
+    {
+        taddMulParallel<Real2,true>( res, v, scheduler );
+    }
+
+    /// result = S * v, where S is the symmetric matrix whose upper triangle is stored in this matrix (see copyUpper).
+    /// The blocks below the diagonal and the lower part of the diagonal blocks are ignored.
+    /// The products with the transposed blocks of each chunk are accumulated in a buffer of the chunk, then summed.
+    template< typename Real2 >
+    void mulSymmetricParallel( FullVector<Real2>& res, const FullVector<Real2>& v, simulation::TaskScheduler& scheduler ) const
+    {
+        static_assert((int)NL == (int)NC, "a symmetric matrix has square blocks");
+        typedef CompressedRowSparseMatrixBlocProduct<Bloc,Real2> BlocProduct;
+        assert( v.size() == colSize() );
+
+        ((Matrix*)this)->compress();
+        res.fastResize( rowSize() );
+
+        const std::vector<Index> chunks = parallelChunks( scheduler.getThreadCount() );
+        const Index nbChunks = (Index)chunks.size() - 1;
+
+        // the transposed blocks of a chunk touch the rows after its own rows, up to its last column
+        std::vector<Index> bufferBegin(nbChunks), bufferEnd(nbChunks);
+        for (Index c = 0; c < nbChunks; ++c)
+        {
+            bufferBegin[c] = chunkRowEnd(chunks, c);
+            bufferEnd[c] = bufferBegin[c];
+            for (Index xi = chunks[c]; xi < chunks[c+1]; ++xi)
+                if (rowBegin[xi+1] > rowBegin[xi])
+                    bufferEnd[c] = std::max(bufferEnd[c], colsIndex[rowBegin[xi+1]-1] + 1);
+        }
+        std::vector< std::vector<Real2> > buffers(nbChunks);
+
+        const Real2* vp = v.ptr();
+        Real2* rp = res.ptr();
+
+        auto chunkProduct = [&](const std::size_t c)
+        {
+            const Index rowFirst = chunkRowBegin(chunks, c);
+            const Index rowLast = chunkRowEnd(chunks, c);
+            std::fill(rp + rowFirst * NL, rp + rowLast * NL, Real2());
+            buffers[c].assign((bufferEnd[c] - bufferBegin[c]) * NL, Real2());
+
+            for (Index xi = chunks[c]; xi < chunks[c+1]; ++xi)
+            {
+                const Index row = rowIndex[xi];
+                Real2* ri = rp + row * NL;
+                const Real2* vi = vp + row * NC;
+                for (Index xj = rowBegin[xi]; xj < rowBegin[xi+1]; ++xj)
+                {
+                    const Index col = colsIndex[xj];
+                    const Bloc& b = colsValue[xj];
+                    if (col > row)
+                    {
+                        BlocProduct::addMul(ri, b, vp + col * NC);
+                        BlocProduct::addMulTranspose(col < rowLast ? rp + col * NL : buffers[c].data() + (col - bufferBegin[c]) * NL, b, vi);
+                    }
+                    else if (col == row)
+                    {
+                        for (Index bi = 0; bi < NL; ++bi)
+                        {
+                            ri[bi] += traits::v(b, bi, bi) * vi[bi];
+                            for (Index bj = bi+1; bj < NC; ++bj)
+                            {
+                                ri[bi] += traits::v(b, bi, bj) * vi[bj];
+                                ri[bj] += traits::v(b, bi, bj) * vi[bi];
+                            }
+                        }
+                    }
+                }
+            }
+        };
+        simulation::parallelForEach(scheduler, 0, nbChunks, chunkProduct);
+
+        auto sumBuffers = [&](const std::size_t first, const std::size_t last)
+        {
+            for (Index c = 0; c < nbChunks; ++c)
+            {
+                const Index begin = std::max((Index)first, bufferBegin[c]);
+                const Index end = std::min((Index)last, bufferEnd[c]);
+                const Real2* buffer = buffers[c].data();
+                for (Index i = begin * NL; i < end * NL; ++i)
+                    rp[i] += buffer[i - bufferBegin[c] * NL];
+            }
+        };
+        simulation::parallelForEachRange(scheduler, 0, rowBSize(), sumBuffers, 1024);
+    }
+
 
 
     /// @}
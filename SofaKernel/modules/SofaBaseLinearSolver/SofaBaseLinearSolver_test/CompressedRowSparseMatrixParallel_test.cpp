@@ -0,0 +1,159 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2019 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#include <SofaBaseLinearSolver/CompressedRowSparseMatrix.h>
+#include <SofaBaseLinearSolver/FullVector.h>
+#include <sofa/simulation/DefaultTaskScheduler.h>
+
+#include <SofaTest/Sofa_test.h>
+
+#include <random>
+
+namespace sofa
+{
+
+using component::linearsolver::CompressedRowSparseMatrix;
+using component::linearsolver::FullVector;
+using component::linearsolver::matrix_bloc_traits;
+using simulation::TaskScheduler;
+using simulation::DefaultTaskScheduler;
+
+/** Compare the parallel matrix-vector products of CompressedRowSparseMatrix with the sequential ones */
+template <class TBloc>
+struct CompressedRowSparseMatrixParallel_test : public Sofa_test<typename matrix_bloc_traits<TBloc>::Real>
+{
+    typedef TBloc Bloc;
+    typedef CompressedRowSparseMatrix<Bloc> Matrix;
+    typedef typename Matrix::Real Real;
+    typedef FullVector<Real> Vector;
+    enum { NL = Matrix::NL };
+
+    std::mt19937 generator;
+    std::uniform_real_distribution<Real> distribution;
+
+    CompressedRowSparseMatrixParallel_test() : generator(1), distribution(-1,1) {}
+
+    void addBloc(Matrix& M, int i, int j, bool symmetric)
+    {
+        for (int bi = 0; bi < NL; ++bi)
+            for (int bj = (i == j ? bi : 0); bj < NL; ++bj)
+            {
+                const Real value = distribution(generator);
+                M.add(i*NL+bi, j*NL+bj, value);
+                if (symmetric && (i != j || bi != bj)) M.add(j*NL+bj, i*NL+bi, value);
+            }
+    }
+
+    /// Symmetric matrix with a band of blocks around the diagonal, a few far blocks and some empty rows
+    void buildMatrix(Matrix& M, int nbBlocRows)
+    {
+        M.resize(nbBlocRows*NL, nbBlocRows*NL);
+        std::uniform_int_distribution<int> band(1, 40);
+        std::uniform_int_distribution<int> anywhere(0, nbBlocRows-1);
+        for (int i = 0; i < nbBlocRows; ++i)
+        {
+            if (i % 97 == 13) continue;
+            addBloc(M, i, i, true);
+            for (int k = 0; k < 3; ++k)
+            {
+                const int j = i + band(generator);
+                if (j < nbBlocRows && j % 97 != 13) addBloc(M, i, j, true);
+            }
+            if (i % 50 == 0)
+            {
+                const int j = anywhere(generator);
+                if (j != i && j % 97 != 13) addBloc(M, i, j, true);
+            }
+        }
+        M.compress();
+    }
+
+    Vector randomVector(int size)
+    {
+        Vector v(size);
+        for (int i = 0; i < size; ++i) v[i] = distribution(generator);
+        return v;
+    }
+
+    void expectNear(const Vector& expected, const Vector& actual)
+    {
+        ASSERT_EQ(expected.size(), actual.size());
+        const Real tolerance = 100 * this->epsilon();
+        for (int i = 0; i < expected.size(); ++i)
+            EXPECT_NEAR(expected[i], actual[i], tolerance * (1 + std::abs(expected[i]))) << "at " << i;
+    }
+
+    void checkProducts(unsigned int nbThreads)
+    {
+        Matrix M;
+        buildMatrix(M, 3000);
+        const Vector v = randomVector(M.colSize());
+
+        Vector expected;
+        M.mul(expected, v);
+
+        TaskScheduler* scheduler = TaskScheduler::create(DefaultTaskScheduler::name());
+        scheduler->init(nbThreads);
+
+        Vector res = randomVector(M.rowSize()); // mulParallel overwrites the previous values
+        M.mulParallel(res, v, *scheduler);
+        expectNear(expected, res);
+
+        const Vector offset = randomVector(M.rowSize());
+        Vector sum = offset;
+        M.addMulParallel(sum, v, *scheduler);
+        for (int i = 0; i < sum.size(); ++i) sum[i] -= offset[i];
+        expectNear(expected, sum);
+
+        Matrix upper;
+        upper.copyUpper(M);
+        EXPECT_LT(upper.colsIndex.size(), M.colsIndex.size());
+        Vector symmetric = randomVector(M.rowSize());
+        upper.mulSymmetricParallel(symmetric, v, *scheduler);
+        expectNear(expected, symmetric);
+
+        // the blocks under the diagonal are ignored
+        M.mulSymmetricParallel(symmetric, v, *scheduler);
+        expectNear(expected, symmetric);
+
+        scheduler->stop();
+    }
+};
+
+typedef testing::Types<
+    double,
+    defaulttype::Mat<3,3,double>,
+    defaulttype::Mat<2,2,float>
+> BlocTypes;
+
+TYPED_TEST_CASE(CompressedRowSparseMatrixParallel_test, BlocTypes);
+
+TYPED_TEST(CompressedRowSparseMatrixParallel_test, oneThread)
+{
+    this->checkProducts(1);
+}
+
+TYPED_TEST(CompressedRowSparseMatrixParallel_test, fourThreads)
+{
+    this->checkProducts(4);
+}
+
+} // namespace sofa
@@ -23,6 +23,7 @@
 #define SOFA_COMPONENT_MAPPING_BARYCENTRICMAPPERMESHTOPOLOGY_INL
 
 #include "BarycentricMapperMeshTopology.h"
+#include <SofaBaseMechanics/BarycentricMappers/BarycentricPointLocator.h>
 #include <sofa/core/visual/VisualParams.h>
 
 namespace sofa
@@ -82,6 +83,8 @@ void BarycentricMapperMeshTopology<In,Out>::init ( const typename Out::VecCoord&
 {
     m_updateJ = true;
 
+    simulation::TaskScheduler* scheduler = this->m_parallelInit ? simulation::TaskScheduler::getInstance() : nullptr;
+
     const SeqTetrahedra& tetras = this->m_fromTopology->getTetrahedra();
     const SeqHexahedra& hexas = this->m_fromTopology->getHexahedra();
 
@@ -151,30 +154,55 @@ void BarycentricMapperMeshTopology<In,Out>::init ( const typename Out::VecCoord&
                 bases[nbTriangles+q].invert ( mt );
                 centers[nbTriangles+q] = ( in[quads[q][0]]+in[quads[q][1]]+in[quads[q][2]]+in[quads[q][3]] ) *0.25;
             }
-            for ( unsigned int i=0; i<out.size(); i++ )
+            BarycentricPointLocator locator;
+            locator.clear ( triangles.size() +quads.size() );
+            for ( unsigned int t = 0; t < triangles.size(); t++ )
+            {
+                locator.addElement();
+                for ( unsigned int j = 0; j < 3; j++ )
+                    locator.addPoint ( t, in[triangles[t][j]] );
+                locator.addBarycentricRegion ( t, in[triangles[t][0]], bases[t] );
+            }
+            for ( unsigned int q = 0; q < quads.size(); q++ )
+            {
+                locator.addElement();
+                for ( unsigned int j = 0; j < 4; j++ )
+                    locator.addPoint ( nbTriangles+q, in[quads[q][j]] );
+                locator.addBarycentricRegion ( nbTriangles+q, in[quads[q][0]], bases[nbTriangles+q] );
+            }
+            locator.build();
+
+            helper::vector<int> indices ( out.size() );
+            helper::vector<Vector3> coefs ( out.size() );
+            BarycentricPointLocator::forEachPoint ( scheduler, out.size(), [&] ( std::size_t i )
             {
                 Vector3 outPos = Out::getCPos(out[i]);
-                Vector3 coefs;
-                int index = -1;
-                double distance = 1e10;
-                for ( unsigned int t = 0; t < triangles.size(); t++ )
+                auto measure = [&] ( int e )
                 {
-                    Vec3d v = bases[t] * ( outPos - in[triangles[t][0]] );
-                    double d = std::max ( std::max ( -v[0],-v[1] ),std::max ( ( v[2]<0?-v[2]:v[2] )-0.01,v[0]+v[1]-1 ) );
-                    if ( d>0 ) d = ( outPos-centers[t] ).norm2();
-                    if ( d<distance ) { coefs = v; distance = d; index = int(t); }
-                }
-                for ( unsigned int q = 0; q < quads.size(); q++ )
-                {
-                    Vec3d v = bases[nbTriangles+q] * ( outPos - in[quads[q][0]] );
+                    if ( e < int(nbTriangles) )
+                    {
+                        Vec3d v = bases[e] * ( outPos - in[triangles[e][0]] );
+                        double d = std::max ( std::max ( -v[0],-v[1] ),std::max ( ( v[2]<0?-v[2]:v[2] )-0.01,v[0]+v[1]-1 ) );
+                        if ( d>0 ) d = ( outPos-centers[e] ).norm2();
+                        return d;
+                    }
+                    Vec3d v = bases[e] * ( outPos - in[quads[e-nbTriangles][0]] );
                     double d = std::max ( std::max ( -v[0],-v[1] ),std::max ( std::max ( v[1]-1,v[0]-1 ),std::max ( v[2]-0.01,-v[2]-0.01 ) ) );
-                    if ( d>0 ) d = ( outPos-centers[nbTriangles+q] ).norm2();
-                    if ( d<distance ) { coefs = v; distance = d; index = nbTriangles+q; }
-                }
-                if ( index < int(nbTriangles) )
-                    addPointInTriangle ( index, coefs.ptr() );
+                    if ( d>0 ) d = ( outPos-centers[e] ).norm2();
+                    return d;
+                };
+                double distance;
+                const int index = locator.findNearest ( outPos, measure, distance );
+                indices[i] = index;
+                coefs[i] = bases[index] * ( outPos - in[index < int(nbTriangles) ? triangles[index][0] : quads[index-nbTriangles][0]] );
+            } );
+
+            for ( unsigned int i=0; i<out.size(); i++ )
+            {
+                if ( indices[i] < int(nbTriangles) )
+                    addPointInTriangle ( indices[i], coefs[i].ptr() );
                 else
-                    addPointInQuad ( index-nbTriangles, coefs.ptr() );
+                    addPointInQuad ( indices[i]-nbTriangles, coefs[i].ptr() );
             }
         }
     }
@@ -204,30 +232,55 @@ void BarycentricMapperMeshTopology<In,Out>::init ( const typename Out::VecCoord&
             bases[nbTetras+h].invert ( mt );
             centers[nbTetras+h] = ( in[hexas[h][0]]+in[hexas[h][1]]+in[hexas[h][2]]+in[hexas[h][3]]+in[hexas[h][4]]+in[hexas[h][5]]+in[hexas[h][6]]+in[hexas[h][7]] ) *0.125;
         }
-        for ( unsigned int i=0; i<out.size(); i++ )
+        BarycentricPointLocator locator;
+        locator.clear ( tetras.size() + hexas.size() );
+        for ( unsigned int t = 0; t < tetras.size(); t++ )
+        {
+            locator.addElement();
+            for ( unsigned int j = 0; j < 4; j++ )
+                locator.addPoint ( t, in[tetras[t][j]] );
+            locator.addBarycentricRegion ( t, in[tetras[t][0]], bases[t] );
+        }
+        for ( unsigned int h = 0; h < hexas.size(); h++ )
+        {
+            locator.addElement();
+            for ( unsigned int j = 0; j < 8; j++ )
+                locator.addPoint ( nbTetras+h, in[hexas[h][j]] );
+            locator.addBarycentricRegion ( nbTetras+h, in[hexas[h][0]], bases[nbTetras+h] );
+        }
+        locator.build();
+
+        helper::vector<int> indices ( out.size() );
+        helper::vector<Vector3> coefs ( out.size() );
+        BarycentricPointLocator::forEachPoint ( scheduler, out.size(), [&] ( std::size_t i )
         {
             Vector3 pos = Out::getCPos(out[i]);
-            Vector3 coefs;
-            int index = -1;
-            double distance = 1e10;
-            for ( unsigned int t = 0; t < tetras.size(); t++ )
+            auto measure = [&] ( int e )
             {
-                Vector3 v = bases[t] * ( pos - in[tetras[t][0]] );
-                double d = std::max ( std::max ( -v[0],-v[1] ),std::max ( -v[2],v[0]+v[1]+v[2]-1 ) );
-                if ( d>0 ) d = ( pos-centers[t] ).norm2();
-                if ( d<distance ) { coefs = v; distance = d; index = int(t); }
-            }
-            for ( unsigned int h = 0; h < hexas.size(); h++ )
-            {
-                Vector3 v = bases[nbTetras+h] * ( pos - in[hexas[h][0]] );
+                if ( e < int(nbTetras) )
+                {
+                    Vector3 v = bases[e] * ( pos - in[tetras[e][0]] );
+                    double d = std::max ( std::max ( -v[0],-v[1] ),std::max ( -v[2],v[0]+v[1]+v[2]-1 ) );
+                    if ( d>0 ) d = ( pos-centers[e] ).norm2();
+                    return d;
+                }
+                Vector3 v = bases[e] * ( pos - in[hexas[e-nbTetras][0]] );
                 double d = std::max ( std::max ( -v[0],-v[1] ),std::max ( std::max ( -v[2],v[0]-1 ),std::max ( v[1]-1,v[2]-1 ) ) );
-                if ( d>0 ) d = ( pos-centers[nbTetras+h] ).norm2();
-                if ( d<distance ) { coefs = v; distance = d; index = int(nbTetras+h); }
-            }
-            if ( index < int(nbTetras) )
-                addPointInTetra ( index, coefs.ptr() );
+                if ( d>0 ) d = ( pos-centers[e] ).norm2();
+                return d;
+            };
+            double distance;
+            const int index = locator.findNearest ( pos, measure, distance );
+            indices[i] = index;
+            coefs[i] = bases[index] * ( pos - in[index < int(nbTetras) ? tetras[index][0] : hexas[index-nbTetras][0]] );
+        } );
+
+        for ( unsigned int i=0; i<out.size(); i++ )
+        {
+            if ( indices[i] < int(nbTetras) )
+                addPointInTetra ( indices[i], coefs[i].ptr() );
             else
-                addPointInCube ( index-nbTetras, coefs.ptr() );
+                addPointInCube ( indices[i]-nbTetras, coefs[i].ptr() );
         }
     }
 }
@@ -22,6 +22,7 @@
 #ifndef SOFA_COMPONENT_MAPPING_BARYCENTRICMAPPERSPARSEGRIDTOPOLOGY_INL
 #define SOFA_COMPONENT_MAPPING_BARYCENTRICMAPPERSPARSEGRIDTOPOLOGY_INL
 #include "BarycentricMapperSparseGridTopology.h"
+#include <SofaBaseMechanics/BarycentricMappers/BarycentricPointLocator.h>
 #include <sofa/core/visual/VisualParams.h>
 namespace sofa
 {
@@ -99,17 +100,55 @@ void BarycentricMapperSparseGridTopology<In,Out>::init ( const typename Out::Vec
 
     if ( m_fromTopology->isVolume() )
     {
-        for ( unsigned int i=0; i<out.size(); i++ )
+        simulation::TaskScheduler* scheduler = this->m_parallelInit ? simulation::TaskScheduler::getInstance() : nullptr;
+
+        helper::vector<int> cubes ( out.size() );
+        helper::vector<Vector3> coefs ( out.size() );
+        BarycentricPointLocator::forEachPoint ( scheduler, out.size(), [&] ( std::size_t i )
+        {
+            cubes[i] = m_fromTopology->findCube ( Vector3 ( Out::getCPos(out[i]) ), coefs[i][0], coefs[i][1], coefs[i][2] );
+        } );
+
+        if ( std::find ( cubes.begin(), cubes.end(), -1 ) != cubes.end() )
         {
-            Vector3 coefs;
-            int cube = m_fromTopology->findCube ( Vector3 ( Out::getCPos(out[i]) ), coefs[0], coefs[1], coefs[2] );
-            if ( cube==-1 )
+            // The points outside of the grid are mapped in the nearest cube (boundary cube if the grid is not built with
+            // the marching cubes), whose center is searched with a spatial index instead of testing all the cubes
+            BarycentricPointLocator locator;
+            helper::vector<int> candidates;
+            helper::vector<Vector3> corners;
+            for ( unsigned int w=0; w<m_fromTopology->getNbHexahedra(); w++ )
             {
-                cube = m_fromTopology->findNearestCube ( Vector3 ( Out::getCPos(out[i]) ), coefs[0], coefs[1], coefs[2] );
+                if ( !m_fromTopology->isUsingMC() && m_fromTopology->getType(w) != topology::SparseGridTopology::BOUNDARY ) continue;
+                const topology::SparseGridTopology::Hexa& c = m_fromTopology->getHexahedron ( w );
+                const std::size_t e = locator.addElement();
+                corners.push_back ( m_fromTopology->getPointPos ( c[0] ) );
+                corners.push_back ( m_fromTopology->getPointPos ( c[6] ) );
+                locator.addPoint ( e, corners[2*e] );
+                locator.addPoint ( e, corners[2*e+1] );
+                candidates.push_back ( int(w) );
             }
-            Vector3 baryCoords = coefs;
-            this->addPointInCube ( cube, baryCoords.ptr() );
+            locator.build();
+
+            BarycentricPointLocator::forEachPoint ( scheduler, out.size(), [&] ( std::size_t i )
+            {
+                if ( cubes[i] != -1 ) return;
+                const Vector3 pos = Out::getCPos(out[i]);
+                if ( candidates.empty() )
+                {
+                    cubes[i] = m_fromTopology->findNearestCube ( pos, coefs[i][0], coefs[i][1], coefs[i][2] );
+                    return;
+                }
+                double distance;
+                const int e = locator.findNearest ( pos, [&] ( int e ) { return ( pos - ( corners[2*e]+corners[2*e+1] ) * .5 ).norm2(); }, distance );
+                const Vector3 diagonal = corners[2*e+1] - corners[2*e];
+                for ( int a=0; a<3; a++ )
+                    coefs[i][a] = ( pos[a] - corners[2*e][a] ) / diagonal[a];
+                cubes[i] = candidates[e];
+            } );
         }
+
+        for ( unsigned int i=0; i<out.size(); i++ )
+            this->addPointInCube ( cubes[i], coefs[i].ptr() );
     }
 }
 
@@ -91,6 +91,8 @@ public:
 
     bool isEmpty();
 
+    bool setFrozenMap(bool frozen, bool parallel) override;
+
 protected:
 
     struct Key
@@ -143,6 +145,23 @@ protected:
     MatrixType* m_matrixJ {nullptr};
     bool m_updateJ {false};
 
+    /// Frozen mapping: for each output point, the NbPoints input indices and weights (CSR layout with a constant row size)
+    enum { NbPoints = Element::static_size };
+    bool m_frozen {false};
+    bool m_parallel {false};
+    helper::vector<unsigned int> m_frozenIndices;
+    helper::vector<Real> m_frozenWeights;
+    /// Transpose of the frozen mapping: for each input point, the output points and weights it contributes to (CSR layout)
+    helper::vector<unsigned int> m_transposeBegin;
+    helper::vector<unsigned int> m_transposeRows;
+    helper::vector<Real> m_transposeWeights;
+    helper::vector<char> m_transposeMask;
+    int m_frozenMapCounter {-1};
+    int m_frozenTopologyRevision {-1};
+
+    /// Rebuilds the frozen layout if the map or the revision of the input topology changed since it was built
+    void updateFrozenMap();
+
     helper::vector<Mat3x3d> m_bases;
     helper::vector<Vector3> m_centers;
 
@@ -24,6 +24,13 @@
 #include <sofa/core/visual/VisualParams.h>
 
 #include "BarycentricMapperTopologyContainer.h"
+#include <SofaBaseMechanics/BarycentricMappers/BarycentricPointLocator.h>
+#include <sofa/simulation/ParallelForEach.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SOFA_BARYCENTRICMAPPER_HAVE_SSE2
+#include <emmintrin.h>
+#endif
 
 namespace sofa
 {
@@ -41,6 +48,36 @@ using defaulttype::Vec3d;
 using defaulttype::Vec3i;
 typedef typename core::topology::BaseMeshTopology::SeqEdges SeqEdges;
 
+/// Weighted sum of the n values of src at the given indices, used by the frozen mapping
+template<class TValue, class TReal>
+inline TValue frozenWeightedSum(const TValue* src, const unsigned int* indices, const TReal* weights, const unsigned int n)
+{
+    TValue sum;
+    for (unsigned int k=0; k<n; k++)
+        sum += src[indices[k]] * weights[k];
+    return sum;
+}
+
+#ifdef SOFA_BARYCENTRICMAPPER_HAVE_SSE2
+/// SSE2 version for 3D double vectors: the x,y components of each input are loaded in one register
+template<>
+inline Vec3d frozenWeightedSum(const Vec3d* src, const unsigned int* indices, const double* weights, const unsigned int n)
+{
+    __m128d xy = _mm_setzero_pd();
+    double z = 0.0;
+    for (unsigned int k=0; k<n; k++)
+    {
+        const double* p = src[indices[k]].ptr();
+        xy = _mm_add_pd(xy, _mm_mul_pd(_mm_loadu_pd(p), _mm_set1_pd(weights[k])));
+        z += p[2] * weights[k];
+    }
+    Vec3d sum;
+    _mm_storeu_pd(sum.ptr(), xy);
+    sum[2] = z;
+    return sum;
+}
+#endif
+
 template <class In, class Out, class MappingDataType, class Element>
 BarycentricMapperTopologyContainer<In,Out,MappingDataType,Element>::BarycentricMapperTopologyContainer(core::topology::BaseMeshTopology* fromTopology,
                                                                                                        topology::PointSetTopologyContainer* toTopology)
@@ -141,65 +178,49 @@ void BarycentricMapperTopologyContainer<In,Out,MappingDataType,Element>::compute
 template <class In, class Out, class MappingDataType, class Element>
 void BarycentricMapperTopologyContainer<In,Out,MappingDataType,Element>::init ( const typename Out::VecCoord& out, const typename In::VecCoord& in )
 {
-    initHashing(in);
     this->clear ( int(out.size()) );
     computeBasesAndCenters(in);
 
-    // Compute distances to get nearest element and corresponding bary coef
     const helper::vector<Element>& elements = getElements();
-    for ( unsigned int i=0; i<out.size(); i++ )
-    {
-        Vector3 outPos = Out::getCPos(out[i]);
-        NearestParams nearestParams;
+    if (elements.empty())
+        return;
 
-        // Search nearest element in grid cell
-        Vec3i gridIds = getGridIndices(outPos);
-        Key key(gridIds[0],gridIds[1],gridIds[2]);
+    // The elements are indexed by the bounding box of their vertices and of the region in which
+    // computeDistance considers a point inside
+    BarycentricPointLocator locator;
+    locator.clear(elements.size());
+    for ( unsigned int e = 0; e < elements.size(); e++ )
+    {
+        locator.addElement();
+        for ( unsigned int j = 0; j < elements[e].size(); j++ )
+            locator.addPoint(e, in[elements[e][j]]);
+        locator.addBarycentricRegion(e, in[elements[e][0]], m_bases[e]);
+    }
+    locator.build();
 
-        auto it_entries = m_hashTable.find(key);
-        if( it_entries != m_hashTable.end() )
+    // Compute distances to get nearest element and corresponding bary coef
+    helper::vector<NearestParams> nearest(out.size());
+    simulation::TaskScheduler* scheduler = this->m_parallelInit ? simulation::TaskScheduler::getInstance() : nullptr;
+    BarycentricPointLocator::forEachPoint(scheduler, out.size(), [&](std::size_t i)
+    {
+        const Vector3 outPos = Out::getCPos(out[i]);
+        auto measure = [&](int e)
         {
-            for(auto entry : it_entries->second)
-            {
-                Vector3 inPos = in[elements[entry][0]];
-                checkDistanceFromElement(entry, outPos, inPos, nearestParams);
-            }
-        }
+            const Vector3 bary = m_bases[e] * ( outPos - in[elements[e][0]] );
+            double dist;
+            computeDistance(dist, bary);
+            if ( dist>0 )
+                dist = ( outPos-m_centers[e] ).norm2();
+            return dist;
+        };
+
+        NearestParams& nearestParams = nearest[i];
+        nearestParams.elementId = (unsigned int)locator.findNearest(outPos, measure, nearestParams.distance);
+        nearestParams.baryCoords = m_bases[nearestParams.elementId] * ( outPos - in[elements[nearestParams.elementId][0]] );
+    });
 
-        if(nearestParams.elementId==std::numeric_limits<unsigned int>::max()) // No element in grid cell, perform exhaustive search
-        {
-            for ( unsigned int e = 0; e < elements.size(); e++ )
-            {
-                Vector3 inPos = in[elements[e][0]];
-                checkDistanceFromElement(e, outPos, inPos, nearestParams);
-            }
-            addPointInElement(nearestParams.elementId, nearestParams.baryCoords.ptr());
-        }
-        else if(fabs(nearestParams.distance)>m_gridCellSize/2.) // Nearest element in grid cell may not be optimal, check neighbors
-        {
-            Vec3i centerGridIds = gridIds;
-            for(int xId=-1; xId<=1; xId++)
-                for(int yId=-1; yId<=1; yId++)
-                    for(int zId=-1; zId<=1; zId++)
-                    {
-                        gridIds = Vec3i(centerGridIds[0]+xId,centerGridIds[1]+yId,centerGridIds[2]+zId);
-                        Key key(gridIds[0],gridIds[1],gridIds[2]);
-
-                        auto it_entries = m_hashTable.find(key);
-                        if( it_entries != m_hashTable.end() )
-                        {
-                            for(auto entry : it_entries->second)
-                            {
-                                Vector3 inPos = in[elements[entry][0]];
-                                checkDistanceFromElement(entry, outPos, inPos, nearestParams);
-                            }
-                        }
-                    }
-            addPointInElement(nearestParams.elementId, nearestParams.baryCoords.ptr());
-        }
-        else
-            addPointInElement(nearestParams.elementId, nearestParams.baryCoords.ptr());
-    }
+    for ( unsigned int i=0; i<out.size(); i++ )
+        addPointInElement(nearest[i].elementId, nearest[i].baryCoords.ptr());
 }
 
 
@@ -249,7 +270,9 @@ template <class In, class Out, class MappingDataType, class Element>
 void BarycentricMapperTopologyContainer<In,Out,MappingDataType,Element>::applyJT ( typename In::MatrixDeriv& out, const typename Out::MatrixDeriv& in )
 {
     typename Out::MatrixDeriv::RowConstIterator rowItEnd = in.end();
-    const helper::vector< Element >& elements = getElements();
+    if (m_frozen)
+        updateFrozenMap();
+    const helper::vector< Element > elements = m_frozen ? helper::vector< Element >() : getElements();
 
     for (typename Out::MatrixDeriv::RowConstIterator rowIt = in.begin(); rowIt != rowItEnd; ++rowIt)
     {
@@ -265,6 +288,13 @@ void BarycentricMapperTopologyContainer<In,Out,MappingDataType,Element>::applyJT
                 unsigned indexIn = colIt.index();
                 InDeriv data = InDeriv(Out::getDPos(colIt.val()));
 
+                if (m_frozen)
+                {
+                    for (unsigned int j=0; j<NbPoints; j++)
+                        o.addCol(m_frozenIndices[indexIn*NbPoints+j], data*m_frozenWeights[indexIn*NbPoints+j]);
+                    continue;
+                }
+
                 const Element& element = elements[d_map.getValue()[indexIn].in_index];
 
                 helper::vector<SReal> baryCoef = getBaryCoef(d_map.getValue()[indexIn].baryCoords);
@@ -311,9 +341,58 @@ const defaulttype::BaseMatrix* BarycentricMapperTopologyContainer<In,Out,Mapping
 template <class In, class Out, class MappingDataType, class Element>
 void BarycentricMapperTopologyContainer<In,Out,MappingDataType,Element>::applyJT ( typename In::VecDeriv& out, const typename Out::VecDeriv& in )
 {
+    ForceMask& mask = *this->maskFrom;
+
+    if (m_frozen)
+    {
+        updateFrozenMap();
+        const ForceMask& maskTo = *this->maskTo;
+        const std::size_t size = std::min(maskTo.size(), in.size());
+        if (m_parallel)
+        {
+            // each input point gathers the contributions of its output points: no concurrent writes
+            auto applyJTRange = [&](std::size_t first, std::size_t last)
+            {
+                for (std::size_t v=first; v<last; v++)
+                {
+                    typename Out::DPos sum;
+                    bool active = false;
+                    for (unsigned int e=m_transposeBegin[v]; e<m_transposeBegin[v+1]; e++)
+                    {
+                        const unsigned int i = m_transposeRows[e];
+                        if( i>=size || !maskTo.getEntry(i) ) continue;
+                        sum += Out::getDPos(in[i]) * m_transposeWeights[e];
+                        active = true;
+                    }
+                    if (active)
+                        out[v] += sum;
+                    m_transposeMask[v] = active;
+                }
+            };
+            simulation::parallelForEachRange(*simulation::TaskScheduler::getInstance(), std::size_t(0), m_transposeMask.size(), applyJTRange, 1024);
+            for (std::size_t v=0; v<m_transposeMask.size(); v++)
+                if (m_transposeMask[v])
+                    mask.insertEntry(v);
+        }
+        else
+        {
+            for (std::size_t i=0; i<size; i++)
+            {
+                if( !maskTo.getEntry(i) ) continue;
+                const typename Out::DPos inPos = Out::getDPos(in[i]);
+                for (unsigned int j=0; j<NbPoints; j++)
+                {
+                    const unsigned int index = m_frozenIndices[i*NbPoints+j];
+                    out[index] += inPos * m_frozenWeights[i*NbPoints+j];
+                    mask.insertEntry(index);
+                }
+            }
+        }
+        return;
+    }
+
     const helper::vector<Element>& elements = getElements();
 
-    ForceMask& mask = *this->maskFrom;
     for( size_t i=0 ; i<this->maskTo->size() ; ++i)
     {
         if( !this->maskTo->getEntry(i) ) continue;
@@ -336,6 +415,26 @@ void BarycentricMapperTopologyContainer<In,Out,MappingDataType,Element>::applyJ
 {
     out.resize( d_map.getValue().size() );
 
+    if (m_frozen)
+    {
+        updateFrozenMap();
+        const ForceMask& maskTo = *this->maskTo;
+        auto applyJRange = [&](std::size_t first, std::size_t last)
+        {
+            for (std::size_t i=first; i<last; i++)
+            {
+                if( maskTo.isActivated() && !maskTo.getEntry(i) ) continue;
+                Out::setDPos(out[i], frozenWeightedSum(in.data(), &m_frozenIndices[i*NbPoints], &m_frozenWeights[i*NbPoints], NbPoints));
+            }
+        };
+        const std::size_t size = std::min(maskTo.size(), out.size());
+        if (m_parallel)
+            simulation::parallelForEachRange(*simulation::TaskScheduler::getInstance(), std::size_t(0), size, applyJRange, 1024);
+        else
+            applyJRange(0, size);
+        return;
+    }
+
     const helper::vector<Element>& elements = getElements();
 
     for( size_t i=0 ; i<this->maskTo->size() ; ++i)
@@ -361,6 +460,71 @@ void BarycentricMapperTopologyContainer<In,Out,MappingDataType,Element>::resize(
     toModel->resize(d_map.getValue().size());
 }
 
+template<class In, class Out, class MappingDataType, class Element>
+bool BarycentricMapperTopologyContainer<In,Out,MappingDataType,Element>::setFrozenMap(bool frozen, bool parallel)
+{
+    m_frozen = frozen;
+    m_parallel = parallel;
+    m_frozenMapCounter = -1;
+    if (m_frozen)
+        updateFrozenMap();
+    return true;
+}
+
+template<class In, class Out, class MappingDataType, class Element>
+void BarycentricMapperTopologyContainer<In,Out,MappingDataType,Element>::updateFrozenMap()
+{
+    // the layout stores the vertices of the elements, so it is also outdated after a topological change
+    const int topologyRevision = m_fromTopology->getRevision();
+    if (m_frozenMapCounter == d_map.getCounter() && m_frozenTopologyRevision == topologyRevision)
+        return;
+
+    const helper::vector<MappingDataType>& map = d_map.getValue();
+    const helper::vector<Element>& elements = getElements();
+
+    m_frozenIndices.resize(map.size()*NbPoints);
+    m_frozenWeights.resize(map.size()*NbPoints);
+    unsigned int nbIn = 0;
+    for (size_t i=0; i<map.size(); i++)
+    {
+        const Element& element = elements[map[i].in_index];
+        helper::vector<SReal> baryCoef = getBaryCoef(map[i].baryCoords);
+        for (unsigned int j=0; j<NbPoints; j++)
+        {
+            m_frozenIndices[i*NbPoints+j] = element[j];
+            m_frozenWeights[i*NbPoints+j] = Real(baryCoef[j]);
+            nbIn = std::max(nbIn, (unsigned int)element[j]+1);
+        }
+    }
+
+    m_transposeBegin.clear();
+    m_transposeRows.clear();
+    m_transposeWeights.clear();
+    if (m_parallel)
+    {
+        // counting sort of the entries by input point, the output points of each input point being in increasing order
+        m_transposeBegin.assign(nbIn+1, 0);
+        for (unsigned int index : m_frozenIndices)
+            m_transposeBegin[index+1]++;
+        for (unsigned int v=0; v<nbIn; v++)
+            m_transposeBegin[v+1] += m_transposeBegin[v];
+
+        helper::vector<unsigned int> position(m_transposeBegin.begin(), m_transposeBegin.end()-1);
+        m_transposeRows.resize(m_frozenIndices.size());
+        m_transposeWeights.resize(m_frozenIndices.size());
+        for (size_t e=0; e<m_frozenIndices.size(); e++)
+        {
+            const unsigned int p = position[m_frozenIndices[e]]++;
+            m_transposeRows[p] = (unsigned int)(e / NbPoints);
+            m_transposeWeights[p] = m_frozenWeights[e];
+        }
+        m_transposeMask.resize(nbIn);
+    }
+
+    m_frozenMapCounter = d_map.getCounter();
+    m_frozenTopologyRevision = topologyRevision;
+}
+
 template<class In, class Out, class MappingDataType, class Element>
 bool BarycentricMapperTopologyContainer<In,Out,MappingDataType,Element>::isEmpty()
 {
@@ -374,6 +538,21 @@ void BarycentricMapperTopologyContainer<In,Out,MappingDataType,Element>::apply (
 {
     out.resize( d_map.getValue().size() );
 
+    if (m_frozen)
+    {
+        updateFrozenMap();
+        auto applyRange = [&](std::size_t first, std::size_t last)
+        {
+            for (std::size_t i=first; i<last; i++)
+                Out::setCPos(out[i], frozenWeightedSum(in.data(), &m_frozenIndices[i*NbPoints], &m_frozenWeights[i*NbPoints], NbPoints));
+        };
+        if (m_parallel)
+            simulation::parallelForEachRange(*simulation::TaskScheduler::getInstance(), std::size_t(0), out.size(), applyRange, 1024);
+        else
+            applyRange(0, out.size());
+        return;
+    }
+
     const helper::vector<Element>& elements = getElements();
     for ( unsigned int i=0; i<d_map.getValue().size(); i++ )
     {
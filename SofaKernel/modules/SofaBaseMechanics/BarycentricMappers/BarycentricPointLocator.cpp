@@ -0,0 +1,157 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2019 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#include "BarycentricPointLocator.h"
+
+#include <cmath>
+
+namespace sofa
+{
+
+namespace component
+{
+
+namespace mapping
+{
+
+void BarycentricPointLocator::clear(std::size_t nbElements)
+{
+    m_boxMin.clear();
+    m_boxMax.clear();
+    m_boxMin.reserve(nbElements);
+    m_boxMax.reserve(nbElements);
+    m_cellBegin.clear();
+    m_cellElements.clear();
+}
+
+std::size_t BarycentricPointLocator::addElement()
+{
+    const double max = std::numeric_limits<double>::max();
+    m_boxMin.push_back(Vector3(max, max, max));
+    m_boxMax.push_back(Vector3(-max, -max, -max));
+    return m_boxMin.size()-1;
+}
+
+void BarycentricPointLocator::addPoint(std::size_t e, const Vector3& p)
+{
+    for (int a=0; a<3; a++)
+    {
+        m_boxMin[e][a] = std::min(m_boxMin[e][a], p[a]);
+        m_boxMax[e][a] = std::max(m_boxMax[e][a], p[a]);
+    }
+}
+
+void BarycentricPointLocator::addBarycentricRegion(std::size_t e, const Vector3& origin, const Mat3x3d& baryBase)
+{
+    // the columns of the inverse of baryBase are the edges of the region
+    Mat3x3d edges;
+    if (!defaulttype::invertMatrix(edges, baryBase))
+        return;
+
+    const double vMin = -0.01, vMax = 1.0;
+    for (int a=0; a<3; a++)
+    {
+        double lower = origin[a], upper = origin[a];
+        for (int k=0; k<3; k++)
+        {
+            lower += std::min(vMin*edges[a][k], vMax*edges[a][k]);
+            upper += std::max(vMin*edges[a][k], vMax*edges[a][k]);
+        }
+        m_boxMin[e][a] = std::min(m_boxMin[e][a], lower);
+        m_boxMax[e][a] = std::max(m_boxMax[e][a], upper);
+    }
+}
+
+void BarycentricPointLocator::build()
+{
+    m_cellBegin.clear();
+    m_cellElements.clear();
+    const std::size_t nbElements = m_boxMin.size();
+    if (nbElements == 0)
+        return;
+
+    // the cell size is the average extent of the boxes, enlarged if the grid would have too many cells
+    Vector3 gridMin = m_boxMin[0], gridMax = m_boxMax[0];
+    double averageExtent = 0.0;
+    for (std::size_t e=0; e<nbElements; e++)
+    {
+        for (int a=0; a<3; a++)
+        {
+            gridMin[a] = std::min(gridMin[a], m_boxMin[e][a]);
+            gridMax[a] = std::max(gridMax[a], m_boxMax[e][a]);
+        }
+        const Vector3 extent = m_boxMax[e] - m_boxMin[e];
+        averageExtent += std::max(extent[0], std::max(extent[1], extent[2]));
+    }
+    averageExtent /= double(nbElements);
+
+    const Vector3 gridExtent = gridMax - gridMin;
+    const double maxNbCells = 4.0 * double(nbElements) + 64.0;
+    m_cellSize = averageExtent;
+    if (!(m_cellSize > 0.0))
+        m_cellSize = std::max(gridExtent[0], std::max(gridExtent[1], gridExtent[2]));
+    if (!(m_cellSize > 0.0))
+        m_cellSize = 1.0;
+    while ((std::floor(gridExtent[0]/m_cellSize)+1) * (std::floor(gridExtent[1]/m_cellSize)+1) * (std::floor(gridExtent[2]/m_cellSize)+1) > maxNbCells)
+        m_cellSize *= 1.25;
+
+    m_origin = gridMin;
+    for (int a=0; a<3; a++)
+        m_size[a] = int(std::floor(gridExtent[a]/m_cellSize)) + 1;
+
+    // registration of the elements in the cells overlapped by their box (CSR layout, counting then filling)
+    const std::size_t nbCells = std::size_t(m_size[0]) * m_size[1] * m_size[2];
+    m_cellBegin.assign(nbCells+1, 0);
+    for (int pass=0; pass<2; pass++)
+    {
+        helper::vector<unsigned int> position;
+        if (pass == 1)
+        {
+            for (std::size_t cell=0; cell<nbCells; cell++)
+                m_cellBegin[cell+1] += m_cellBegin[cell];
+            position.assign(m_cellBegin.begin(), m_cellBegin.end()-1);
+            m_cellElements.resize(m_cellBegin[nbCells]);
+        }
+
+        for (std::size_t e=0; e<nbElements; e++)
+        {
+            const int i0 = cellIndex(m_boxMin[e][0],0), i1 = cellIndex(m_boxMax[e][0],0);
+            const int j0 = cellIndex(m_boxMin[e][1],1), j1 = cellIndex(m_boxMax[e][1],1);
+            const int k0 = cellIndex(m_boxMin[e][2],2), k1 = cellIndex(m_boxMax[e][2],2);
+            for (int k=k0; k<=k1; k++)
+                for (int j=j0; j<=j1; j++)
+                    for (int i=i0; i<=i1; i++)
+                    {
+                        const std::size_t cell = (std::size_t(k)*m_size[1]+j)*m_size[0]+i;
+                        if (pass == 0)
+                            m_cellBegin[cell+1]++;
+                        else
+                            m_cellElements[position[cell]++] = (unsigned int)e;
+                    }
+        }
+    }
+}
+
+} // namespace mapping
+
+} // namespace component
+
+} // namespace sofa
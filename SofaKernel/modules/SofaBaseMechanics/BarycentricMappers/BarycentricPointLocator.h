@@ -0,0 +1,188 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2019 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#ifndef SOFA_COMPONENT_MAPPING_BARYCENTRICPOINTLOCATOR_H
+#define SOFA_COMPONENT_MAPPING_BARYCENTRICPOINTLOCATOR_H
+#include <SofaBaseMechanics/config.h>
+
+#include <sofa/defaulttype/Vec.h>
+#include <sofa/defaulttype/Mat.h>
+#include <sofa/helper/vector.h>
+#include <sofa/simulation/ParallelForEach.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <limits>
+
+namespace sofa
+{
+
+namespace component
+{
+
+namespace mapping
+{
+
+/// Spatial index used by the barycentric mappers (and MeshBarycentricMapperEngine) to find the element
+/// in which, or nearest to which, each mapped point lies without testing all the elements for each point.
+///
+/// Each element is registered in the cells of a uniform grid overlapped by its bounding box. A query visits
+/// the cells in rings of increasing distance around the point, and stops when the elements not visited yet
+/// cannot be nearer than the best one: the result is the same as the exhaustive search of the mappers.
+class SOFA_BASE_MECHANICS_API BarycentricPointLocator
+{
+public:
+    typedef defaulttype::Vector3 Vector3;
+    typedef defaulttype::Mat3x3d Mat3x3d;
+
+    /// Removes all the elements and reserves the bounding boxes of nbElements elements
+    void clear(std::size_t nbElements);
+
+    /// Adds an element with an empty bounding box, returns its index
+    std::size_t addElement();
+
+    /// Extends the bounding box of element e to contain the point p
+    void addPoint(std::size_t e, const Vector3& p);
+
+    /// Extends the bounding box of element e to contain its barycentric region, i.e. the points p whose
+    /// coordinates v = baryBase * (p - origin) are in [-0.01,1]^3. It contains the region in which the
+    /// mappers consider a point inside a triangle, quad, tetrahedron or hexahedron.
+    void addBarycentricRegion(std::size_t e, const Vector3& origin, const Mat3x3d& baryBase);
+
+    /// Builds the grid from the bounding boxes of the elements
+    void build();
+
+    std::size_t getNbElements() const { return m_boxMin.size(); }
+
+    /// Returns the element with the smallest measure for the point pos, and the measure in distance
+    /// (-1 if there is no element). measure(e) must be positive outside the barycentric region of the
+    /// element, and not larger than the squared distance between pos and the element bounding box
+    /// in that case (e.g. the squared distance to the center of the element). Ties are broken by the
+    /// smallest element index.
+    template<class Measure>
+    int findNearest(const Vector3& pos, const Measure& measure, double& distance) const;
+
+    /// Calls locate(i) for each point i in [0,n), with the tasks of the scheduler if it is not null
+    template<class Locate>
+    static void forEachPoint(simulation::TaskScheduler* scheduler, std::size_t n, const Locate& locate)
+    {
+        if (scheduler)
+        {
+            simulation::parallelForEach(*scheduler, std::size_t(0), n, locate, 64);
+        }
+        else
+        {
+            for (std::size_t i=0; i<n; i++)
+                locate(i);
+        }
+    }
+
+protected:
+    int cellIndex(double x, int axis) const;
+
+    helper::vector<Vector3> m_boxMin;
+    helper::vector<Vector3> m_boxMax;
+
+    Vector3 m_origin;
+    double m_cellSize {1.0};
+    int m_size[3] {0, 0, 0};
+    helper::vector<unsigned int> m_cellBegin; ///< first entry of each cell in m_cellElements (CSR layout)
+    helper::vector<unsigned int> m_cellElements;
+};
+
+inline int BarycentricPointLocator::cellIndex(double x, int axis) const
+{
+    const double c = (x - m_origin[axis]) / m_cellSize;
+    if (!(c > 0.0))
+        return 0;
+    if (c >= double(m_size[axis]-1))
+        return m_size[axis]-1;
+    return int(c);
+}
+
+template<class Measure>
+int BarycentricPointLocator::findNearest(const Vector3& pos, const Measure& measure, double& distance) const
+{
+    int nearest = -1;
+    distance = std::numeric_limits<double>::max();
+    if (m_cellBegin.empty())
+        return nearest;
+
+    const int c[3] = { cellIndex(pos[0],0), cellIndex(pos[1],1), cellIndex(pos[2],2) };
+    int maxRing = 0;
+    for (int a=0; a<3; a++)
+        maxRing = std::max(maxRing, std::max(c[a], m_size[a]-1-c[a]));
+
+    auto visitCell = [&](int i, int j, int k)
+    {
+        const unsigned int cell = (unsigned int)((k*m_size[1]+j)*m_size[0]+i);
+        for (unsigned int entry=m_cellBegin[cell]; entry<m_cellBegin[cell+1]; entry++)
+        {
+            const int e = int(m_cellElements[entry]);
+            const double d = measure(e);
+            if (d < distance || (d == distance && e < nearest))
+            {
+                distance = d;
+                nearest = e;
+            }
+        }
+    };
+
+    for (int r=0; r<=maxRing; r++)
+    {
+        // cells at Chebyshev distance r from the cell of pos
+        const int i0 = std::max(c[0]-r, 0), i1 = std::min(c[0]+r, m_size[0]-1);
+        const int j0 = std::max(c[1]-r, 0), j1 = std::min(c[1]+r, m_size[1]-1);
+        for (int i=i0; i<=i1; i++)
+        {
+            for (int j=j0; j<=j1; j++)
+            {
+                if (std::abs(i-c[0]) == r || std::abs(j-c[1]) == r)
+                {
+                    for (int k=std::max(c[2]-r, 0); k<=std::min(c[2]+r, m_size[2]-1); k++)
+                        visitCell(i, j, k);
+                }
+                else
+                {
+                    if (c[2]-r >= 0)
+                        visitCell(i, j, c[2]-r);
+                    if (r > 0 && c[2]+r < m_size[2])
+                        visitCell(i, j, c[2]+r);
+                }
+            }
+        }
+
+        // the elements which are not visited yet are at least r cells away from pos
+        const double ringDistance = r * m_cellSize;
+        if (nearest >= 0 && distance < ringDistance * ringDistance)
+            break;
+    }
+
+    return nearest;
+}
+
+} // namespace mapping
+
+} // namespace component
+
+} // namespace sofa
+
+#endif
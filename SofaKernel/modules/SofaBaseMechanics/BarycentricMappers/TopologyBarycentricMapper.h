@@ -77,6 +77,14 @@ public:
     const topology::PointSetTopologyContainer *getToTopology() const {return m_toTopology;}
 
     virtual void updateForceMask(){/*mask is already filled in the mapper's applyJT*/}
+
+    /// Freezes the mapping into a compact index/weight layout used by apply, applyJ and applyJT,
+    /// evaluated in parallel if requested. Returns false if the mapper does not support it.
+    virtual bool setFrozenMap(bool frozen, bool parallel) { SOFA_UNUSED(parallel); return !frozen; }
+
+    /// Locates the mapped points in parallel with the task scheduler in init
+    void setParallelInit(bool parallel) { m_parallelInit = parallel; }
+
     virtual void resize( core::State<Out>* toModel ) = 0;
 
     void processTopologicalChanges(const typename Out::VecCoord& out, const typename In::VecCoord& in, core::topology::Topology* t) {
@@ -96,6 +104,7 @@ protected:
 
     core::topology::BaseMeshTopology*    m_fromTopology;
     topology::PointSetTopologyContainer* m_toTopology;
+    bool m_parallelInit {false};
 };
 
 #if !defined(SOFA_COMPONENT_MAPPING_TOPOLOGYBARYCENTRICMAPPER_CPP)
@@ -78,6 +78,9 @@ public:
 
 public:
     Data< bool > useRestPosition; ///< Use the rest position of the input and output models to initialize the mapping    
+    Data< bool > d_frozenMap; ///< Freeze the mapping after init into a compact index/weight layout used by apply, applyJ and applyJT
+    Data< bool > d_parallelFrozenMap; ///< Evaluate the frozen mapping in parallel, applyJT using its precomputed transpose
+    Data< bool > d_parallelInit; ///< Locate the mapped points in parallel when the mapping is initialized
 
     SingleLink<BarycentricMapping<In,Out>,Mapper,BaseLink::FLAG_STRONGLINK> d_mapper;
     SingleLink<BarycentricMapping<In,Out>,BaseMeshTopology,BaseLink::FLAG_STRONGLINK> d_input_topology;
@@ -53,6 +53,7 @@
 #include <sofa/helper/system/config.h>
 
 #include <sofa/simulation/Simulation.h>
+#include <sofa/simulation/TaskScheduler.h>
 
 #include <algorithm>
 #include <iostream>
@@ -98,6 +99,9 @@ static bool is_a(const V * topology) {
 template <class TIn, class TOut>
 BarycentricMapping<TIn, TOut>::BarycentricMapping(core::State<In>* from, core::State<Out>* to, typename Mapper::SPtr mapper)
     : Inherit1 ( from, to )
+    , d_frozenMap(initData(&d_frozenMap, false, "frozenMap", "Freeze the mapping after init into a compact index/weight layout used by apply, applyJ and applyJT (only for topology container mappers)"))
+    , d_parallelFrozenMap(initData(&d_parallelFrozenMap, false, "parallelFrozenMap", "Evaluate the frozen mapping in parallel, applyJT using its precomputed transpose"))
+    , d_parallelInit(initData(&d_parallelInit, false, "parallelInit", "Locate the mapped points in parallel when the mapping is initialized"))
     , d_mapper(initLink("mapper","Internal mapper created depending on the type of topology"), mapper)
     , d_input_topology(initLink("input_topology", "Input topology container (usually the surrounding domain)."))
     , d_output_topology(initLink("output_topology", "Output topology container (usually the immersed domain)."))
@@ -111,6 +115,9 @@ BarycentricMapping<TIn, TOut>::BarycentricMapping(core::State<In>* from, core::S
 template <class TIn, class TOut>
 BarycentricMapping<TIn, TOut>::BarycentricMapping (core::State<In>* from, core::State<Out>* to, BaseMeshTopology * input_topology )
     : Inherit1 ( from, to )
+    , d_frozenMap(initData(&d_frozenMap, false, "frozenMap", "Freeze the mapping after init into a compact index/weight layout used by apply, applyJ and applyJT (only for topology container mappers)"))
+    , d_parallelFrozenMap(initData(&d_parallelFrozenMap, false, "parallelFrozenMap", "Evaluate the frozen mapping in parallel, applyJT using its precomputed transpose"))
+    , d_parallelInit(initData(&d_parallelInit, false, "parallelInit", "Locate the mapped points in parallel when the mapping is initialized"))
     , d_mapper (initLink("mapper","Internal mapper created depending on the type of topology"))
     , d_input_topology(initLink("input_topology", "Input topology container (usually the surrounding domain)."))
     , d_output_topology(initLink("output_topology", "Output topology container (usually the immersed domain)."))
@@ -278,11 +285,26 @@ void BarycentricMapping<TIn, TOut>::init()
     if (!this->toModel)
         return;
 
+    if (d_parallelInit.getValue())
+    {
+        simulation::TaskScheduler::getInstance();
+    }
+    d_mapper->setParallelInit(d_parallelInit.getValue());
+
     if (useRestPosition.getValue())
         d_mapper->init ( ((const core::State<Out> *)this->toModel)->read(core::ConstVecCoordId::restPosition())->getValue(), ((const core::State<In> *)this->fromModel)->read(core::ConstVecCoordId::restPosition())->getValue() );
     else
         d_mapper->init (((const core::State<Out> *)this->toModel)->read(core::ConstVecCoordId::position())->getValue(), ((const core::State<In> *)this->fromModel)->read(core::ConstVecCoordId::position())->getValue() );
 
+    if (d_parallelFrozenMap.getValue())
+    {
+        simulation::TaskScheduler::getInstance();
+    }
+    if (!d_mapper->setFrozenMap(d_frozenMap.getValue(), d_parallelFrozenMap.getValue()))
+    {
+        msg_warning() << "The mapper " << d_mapper->getClassName() << " does not support frozenMap: it is evaluated entry by entry.";
+    }
+
     this->m_componentstate = ComponentState::Valid ;
 }
 
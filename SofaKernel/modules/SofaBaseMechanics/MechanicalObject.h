@@ -340,6 +340,8 @@ public:
 
     void vMultiOp(const core::ExecParams* params, const VMultiOp& ops) override;
 
+    SReal vMultiOpDot(const core::ExecParams* params, const VMultiOp& ops, core::ConstVecId a, core::ConstVecId b) override;
+
     void vThreshold(core::VecId a, SReal threshold ) override;
 
     SReal vDot(const core::ExecParams* params, core::ConstVecId a, core::ConstVecId b) override;
@@ -433,6 +435,16 @@ protected :
 
     /// @}
 
+    /**
+     * @brief Evaluates all the operations of a vMultiOp in a single pass over the flat arrays of reals of the vectors.
+     *
+     * The vectors are processed by blocks small enough to stay in cache, all the operations being applied to
+     * a block before moving to the next one. If dot is not null, the scalar product of a and b is accumulated
+     * in the same pass, once the block is updated.
+     * Returns false, without modifying anything, if the operations or the data types are not supported.
+     */
+    bool vMultiOpFused(const core::ExecParams* params, const VMultiOp& ops, core::ConstVecId a, core::ConstVecId b, SReal* dot);
+
     /**
     * @brief Internal function : Draw indices in 3d coordinates.
     */
@@ -23,6 +23,7 @@
 #define SOFA_COMPONENT_MECHANICALOBJECT_INL
 
 #include <SofaBaseMechanics/MechanicalObject.h>
+#include <SofaBaseMechanics/MechanicalObjectVecOps.h>
 #include <sofa/core/visual/VisualParams.h>
 #include <SofaBaseLinearSolver/SparseMatrix.h>
 #include <sofa/core/topology/BaseTopology.h>
@@ -38,8 +39,10 @@
 #include <sofa/simulation/Visitor.h>
 #endif
 
+#include <algorithm>
 #include <cassert>
 #include <iostream>
+#include <type_traits>
 
 #ifdef SOFA_HAVE_NEW_TOPOLOGYCHANGES
 #include <SofaBaseTopology/TopologyData.inl>
@@ -2265,10 +2268,150 @@ void MechanicalObject<DataTypes>::vMultiOp(const core::ExecParams* params, const
             newPos[i] += v23[i]*f_3;
         }
     }
-    else // no optimization for now for other cases
+    else if (!vMultiOpFused(params, ops, core::ConstVecId::null(), core::ConstVecId::null(), nullptr))
         Inherited::vMultiOp(params, ops);
 }
 
+template <class DataTypes>
+SReal MechanicalObject<DataTypes>::vMultiOpDot(const core::ExecParams* params, const VMultiOp& ops, core::ConstVecId a, core::ConstVecId b)
+{
+    SReal r = 0.0;
+    if (vMultiOpFused(params, ops, a, b, &r))
+        return r;
+    return Inherited::vMultiOpDot(params, ops, a, b);
+}
+
+template <class DataTypes>
+bool MechanicalObject<DataTypes>::vMultiOpFused(const core::ExecParams* params, const VMultiOp& ops, core::ConstVecId a, core::ConstVecId b, SReal* dot)
+{
+    typedef MechanicalObjectVecOps<Real> VecOps;
+
+    // derivatives are handled as flat arrays of reals, which is the case of the vector and rigid types
+    const unsigned int derivSize = DataTypes::deriv_total_size;
+    if (sizeof(Deriv) != derivSize * sizeof(Real))
+        return false;
+    // coordinates are only handled when they are combined as the derivatives (vector types)
+    const bool flatCoord = std::is_same<Coord, Deriv>::value;
+
+    const size_t size = (size_t)this->getSize();
+    auto isSupported = [&](core::ConstVecId v)
+    {
+        if (v.type == sofa::core::V_DERIV)
+            return v.index < vectorsDeriv.size() && vectorsDeriv[v.index] != nullptr && vectorsDeriv[v.index]->getValue(params).size() == size;
+        if (v.type == sofa::core::V_COORD && flatCoord)
+            return v.index < vectorsCoord.size() && vectorsCoord[v.index] != nullptr && vectorsCoord[v.index]->getValue(params).size() == size;
+        return false;
+    };
+    auto flatRead = [&](core::ConstVecId v) -> const Real*
+    {
+        if (v.type == sofa::core::V_DERIV)
+            return reinterpret_cast<const Real*>(vectorsDeriv[v.index]->getValue(params).data());
+        return reinterpret_cast<const Real*>(vectorsCoord[v.index]->getValue(params).data());
+    };
+
+    // check all the operations before modifying anything
+    for (size_t k = 0; k < ops.size(); ++k)
+    {
+        const core::VecId r = ops[k].first.getId(this);
+        if (r.isNull() || !(r.type == sofa::core::V_DERIV || (r.type == sofa::core::V_COORD && flatCoord)))
+            return false;
+        for (size_t j = 0; j < ops[k].second.size(); ++j)
+        {
+            const core::ConstVecId v = ops[k].second[j].first.getId(this);
+            if (v.isNull() || (r.type == sofa::core::V_DERIV && v.type != sofa::core::V_DERIV))
+                return false;
+        }
+    }
+    if (dot && (a.isNull() || b.isNull()))
+        return false;
+
+    // allocate the missing results, sources are only checked afterwards as they can be the result of a previous operation
+    for (size_t k = 0; k < ops.size(); ++k)
+    {
+        const core::VecId r = ops[k].first.getId(this);
+        if (r.type == sofa::core::V_DERIV)
+            this->write(core::VecDerivId(r));
+        else
+            this->write(core::VecCoordId(r));
+        if (!isSupported(r))
+            return false;
+    }
+    for (size_t k = 0; k < ops.size(); ++k)
+        for (size_t j = 0; j < ops[k].second.size(); ++j)
+            if (!isSupported(ops[k].second[j].first.getId(this)))
+                return false;
+    if (dot && (!isSupported(a) || !isSupported(b)))
+        return false;
+
+    typedef std::pair<const Real*, Real> Operand;
+    helper::vector< helper::vector<Operand> > operands(ops.size());
+    helper::vector<bool> aliased(ops.size(), false);
+    for (size_t k = 0; k < ops.size(); ++k)
+    {
+        const Real* r = flatRead(ops[k].first.getId(this));
+        for (size_t j = 0; j < ops[k].second.size(); ++j)
+        {
+            operands[k].push_back(Operand(flatRead(ops[k].second[j].first.getId(this)), (Real)ops[k].second[j].second));
+            // the result is only allowed to be the first operand of a vOp, here it is computed in a temporary block
+            if (j > 0 && operands[k][j].first == r)
+                aliased[k] = true;
+        }
+    }
+    const Real* pa = dot ? flatRead(a) : nullptr;
+    const Real* pb = dot ? flatRead(b) : nullptr;
+
+    helper::vector<Real*> results(ops.size());
+    for (size_t k = 0; k < ops.size(); ++k)
+    {
+        const core::VecId r = ops[k].first.getId(this);
+        if (r.type == sofa::core::V_DERIV)
+            results[k] = reinterpret_cast<Real*>(this->write(core::VecDerivId(r))->beginEdit(params)->data());
+        else
+            results[k] = reinterpret_cast<Real*>(this->write(core::VecCoordId(r))->beginEdit(params)->data());
+    }
+
+    const size_t n = size * derivSize;
+    const size_t blockSize = 1024;
+    Real tmp[blockSize];
+    SReal d = 0.0;
+    for (size_t first = 0; first < n; first += blockSize)
+    {
+        const size_t len = std::min(blockSize, n - first);
+        for (size_t k = 0; k < ops.size(); ++k)
+        {
+            Real* r = results[k] + first;
+            const helper::vector<Operand>& op = operands[k];
+            if (op.empty())
+            {
+                std::fill(r, r + len, Real(0));
+                continue;
+            }
+            Real* acc = aliased[k] ? tmp : r;
+            if (op[0].first + first != acc || op[0].second != Real(1))
+                VecOps::eq(acc, op[0].first + first, op[0].second, len);
+            for (size_t j = 1; j < op.size(); ++j)
+                VecOps::peq(acc, op[j].first + first, op[j].second, len);
+            if (acc != r)
+                std::copy(acc, acc + len, r);
+        }
+        if (dot)
+            d += VecOps::dot(pa + first, pb + first, len);
+    }
+
+    for (size_t k = 0; k < ops.size(); ++k)
+    {
+        const core::VecId r = ops[k].first.getId(this);
+        if (r.type == sofa::core::V_DERIV)
+            this->write(core::VecDerivId(r))->endEdit(params);
+        else
+            this->write(core::VecCoordId(r))->endEdit(params);
+    }
+
+    if (dot)
+        *dot = d;
+    return true;
+}
+
 template <class T> inline void clear( T& t )
 {
     t.clear();
@@ -0,0 +1,167 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2019 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#ifndef SOFA_COMPONENT_CONTAINER_MECHANICALOBJECTVECOPS_H
+#define SOFA_COMPONENT_CONTAINER_MECHANICALOBJECTVECOPS_H
+#include "config.h"
+
+#include <cstddef>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SOFA_MECHANICALOBJECT_HAVE_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace sofa
+{
+
+namespace component
+{
+
+namespace container
+{
+
+/// Kernels used by MechanicalObject::vMultiOp on the flat arrays of reals of state vectors.
+///
+/// Each kernel performs the same operation on each scalar as the corresponding vOp loop,
+/// so that the fused path gives the same results as a sequence of vOp calls.
+template<class Real>
+struct MechanicalObjectVecOps
+{
+    /// r = a*f
+    static void eq(Real* r, const Real* a, Real f, std::size_t n)
+    {
+        for (std::size_t i = 0; i < n; ++i)
+            r[i] = a[i] * f;
+    }
+
+    /// r += a*f
+    static void peq(Real* r, const Real* a, Real f, std::size_t n)
+    {
+        for (std::size_t i = 0; i < n; ++i)
+            r[i] += a[i] * f;
+    }
+
+    /// return the scalar product of a and b
+    static Real dot(const Real* a, const Real* b, std::size_t n)
+    {
+        Real r = 0;
+        for (std::size_t i = 0; i < n; ++i)
+            r += a[i] * b[i];
+        return r;
+    }
+};
+
+#ifdef SOFA_MECHANICALOBJECT_HAVE_SSE2
+template<>
+struct MechanicalObjectVecOps<double>
+{
+    static void eq(double* r, const double* a, double f, std::size_t n)
+    {
+        const __m128d vf = _mm_set1_pd(f);
+        std::size_t i = 0;
+        for (; i + 4 <= n; i += 4)
+        {
+            _mm_storeu_pd(r + i,     _mm_mul_pd(_mm_loadu_pd(a + i),     vf));
+            _mm_storeu_pd(r + i + 2, _mm_mul_pd(_mm_loadu_pd(a + i + 2), vf));
+        }
+        for (; i < n; ++i)
+            r[i] = a[i] * f;
+    }
+
+    static void peq(double* r, const double* a, double f, std::size_t n)
+    {
+        const __m128d vf = _mm_set1_pd(f);
+        std::size_t i = 0;
+        for (; i + 4 <= n; i += 4)
+        {
+            _mm_storeu_pd(r + i,     _mm_add_pd(_mm_loadu_pd(r + i),     _mm_mul_pd(_mm_loadu_pd(a + i),     vf)));
+            _mm_storeu_pd(r + i + 2, _mm_add_pd(_mm_loadu_pd(r + i + 2), _mm_mul_pd(_mm_loadu_pd(a + i + 2), vf)));
+        }
+        for (; i < n; ++i)
+            r[i] += a[i] * f;
+    }
+
+    static double dot(const double* a, const double* b, std::size_t n)
+    {
+        __m128d s0 = _mm_setzero_pd();
+        __m128d s1 = _mm_setzero_pd();
+        std::size_t i = 0;
+        for (; i + 4 <= n; i += 4)
+        {
+            s0 = _mm_add_pd(s0, _mm_mul_pd(_mm_loadu_pd(a + i),     _mm_loadu_pd(b + i)));
+            s1 = _mm_add_pd(s1, _mm_mul_pd(_mm_loadu_pd(a + i + 2), _mm_loadu_pd(b + i + 2)));
+        }
+        double s[2];
+        _mm_storeu_pd(s, _mm_add_pd(s0, s1));
+        double r = s[0] + s[1];
+        for (; i < n; ++i)
+            r += a[i] * b[i];
+        return r;
+    }
+};
+
+template<>
+struct MechanicalObjectVecOps<float>
+{
+    static void eq(float* r, const float* a, float f, std::size_t n)
+    {
+        const __m128 vf = _mm_set1_ps(f);
+        std::size_t i = 0;
+        for (; i + 4 <= n; i += 4)
+            _mm_storeu_ps(r + i, _mm_mul_ps(_mm_loadu_ps(a + i), vf));
+        for (; i < n; ++i)
+            r[i] = a[i] * f;
+    }
+
+    static void peq(float* r, const float* a, float f, std::size_t n)
+    {
+        const __m128 vf = _mm_set1_ps(f);
+        std::size_t i = 0;
+        for (; i + 4 <= n; i += 4)
+            _mm_storeu_ps(r + i, _mm_add_ps(_mm_loadu_ps(r + i), _mm_mul_ps(_mm_loadu_ps(a + i), vf)));
+        for (; i < n; ++i)
+            r[i] += a[i] * f;
+    }
+
+    static float dot(const float* a, const float* b, std::size_t n)
+    {
+        __m128 s0 = _mm_setzero_ps();
+        std::size_t i = 0;
+        for (; i + 4 <= n; i += 4)
+            s0 = _mm_add_ps(s0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+        float s[4];
+        _mm_storeu_ps(s, s0);
+        float r = (s[0] + s[1]) + (s[2] + s[3]);
+        for (; i < n; ++i)
+            r += a[i] * b[i];
+        return r;
+    }
+};
+#endif
+
+} // namespace container
+
+} // namespace component
+
+} // namespace sofa
+
+#endif
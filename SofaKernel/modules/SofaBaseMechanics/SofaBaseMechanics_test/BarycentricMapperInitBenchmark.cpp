@@ -0,0 +1,152 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2019 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#include <SofaBaseMechanics/BarycentricMappers/BarycentricMapperTetrahedronSetTopology.h>
+#include <SofaBaseMechanics/BarycentricMappers/BarycentricMapperMeshTopology.h>
+#include <SofaBaseTopology/TetrahedronSetTopologyContainer.h>
+#include <SofaBaseTopology/MeshTopology.h>
+#include <sofa/simulation/DefaultTaskScheduler.h>
+#include <sofa/helper/RandomGenerator.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+// startup benchmark of the barycentric mappers: init time against the size of the mesh
+namespace
+{
+    using sofa::defaulttype::Vector3;
+    using sofa::defaulttype::Vec3dTypes;
+    using sofa::core::topology::BaseMeshTopology;
+    using sofa::core::objectmodel::New;
+    using sofa::component::topology::TetrahedronSetTopologyContainer;
+    using sofa::component::topology::MeshTopology;
+    typedef sofa::component::mapping::BarycentricMapperTetrahedronSetTopology<Vec3dTypes,Vec3dTypes> TetrahedronMapper;
+    typedef sofa::component::mapping::BarycentricMapperMeshTopology<Vec3dTypes,Vec3dTypes> MeshMapper;
+    
+    
+    // tetrahedra of a jittered grid of n*n*n cubes in [0,1]^3, each cube being split in 6 tetrahedra
+    void createTetrahedra(int n, Vec3dTypes::VecCoord& points, BaseMeshTopology::SeqTetrahedra& tetrahedra)
+    {
+        sofa::helper::RandomGenerator random(13);
+        const double h = 1.0 / n;
+        for (int k=0; k<=n; k++)
+            for (int j=0; j<=n; j++)
+                for (int i=0; i<=n; i++)
+                    points.push_back(Vector3(i*h + random.random<double>(-0.1,0.1)*h, j*h + random.random<double>(-0.1,0.1)*h, k*h + random.random<double>(-0.1,0.1)*h));
+        
+        auto point = [n](int i, int j, int k) { return (unsigned int)((k*(n+1)+j)*(n+1)+i); };
+        for (int k=0; k<n; k++)
+            for (int j=0; j<n; j++)
+                for (int i=0; i<n; i++)
+                {
+                    const unsigned int p[8] = { point(i,j,k), point(i+1,j,k), point(i+1,j+1,k), point(i,j+1,k),
+                                                point(i,j,k+1), point(i+1,j,k+1), point(i+1,j+1,k+1), point(i,j+1,k+1) };
+                    tetrahedra.push_back(BaseMeshTopology::Tetra(p[0],p[5],p[1],p[6]));
+                    tetrahedra.push_back(BaseMeshTopology::Tetra(p[0],p[1],p[2],p[6]));
+                    tetrahedra.push_back(BaseMeshTopology::Tetra(p[0],p[2],p[3],p[6]));
+                    tetrahedra.push_back(BaseMeshTopology::Tetra(p[0],p[3],p[7],p[6]));
+                    tetrahedra.push_back(BaseMeshTopology::Tetra(p[0],p[7],p[4],p[6]));
+                    tetrahedra.push_back(BaseMeshTopology::Tetra(p[0],p[4],p[5],p[6]));
+                }
+    }
+    
+    template<class Function>
+    double measure(Function run, const int repetitions)
+    {
+        std::vector<double> times;
+        for (int i = 0; i < repetitions; ++i)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            run();
+            const auto end = std::chrono::steady_clock::now();
+            times.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+        }
+        std::sort(times.begin(), times.end());
+        return times[times.size() / 2];
+    }
+    
+} // namespace
+
+
+int main(int argc, char** argv)
+{
+    const unsigned int hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+    const unsigned int nbThreads = argc > 1 ? unsigned(std::atoi(argv[1])) : hardwareThreads;
+    const int maxResolution = argc > 2 ? std::atoi(argv[2]) : 32;
+    const int pointsPerTetrahedron = argc > 3 ? std::atoi(argv[3]) : 2;
+    const int repetitions = argc > 4 ? std::atoi(argv[4]) : 3;
+    
+    sofa::simulation::TaskScheduler* scheduler = sofa::simulation::TaskScheduler::create(sofa::simulation::DefaultTaskScheduler::name());
+    scheduler->init(nbThreads);
+    
+    std::cout << "barycentric mapper init, " << nbThreads << " threads, median of " << repetitions << " repetitions (ms)" << std::endl;
+    std::cout << std::setw(12) << "tetrahedra" << std::setw(12) << "points"
+              << std::setw(14) << "TetraSet" << std::setw(14) << "TetraSet mt"
+              << std::setw(14) << "Mesh" << std::setw(14) << "Mesh mt" << std::endl;
+    
+    for (int n = 4; n <= maxResolution; n *= 2)
+    {
+        Vec3dTypes::VecCoord in;
+        BaseMeshTopology::SeqTetrahedra tetrahedra;
+        createTetrahedra(n, in, tetrahedra);
+        
+        // mapped points inside and around the mesh
+        sofa::helper::RandomGenerator random(5);
+        Vec3dTypes::VecCoord out(tetrahedra.size() * pointsPerTetrahedron);
+        for (auto& p : out)
+            p = Vector3(random.random<double>(-0.1,1.1), random.random<double>(-0.1,1.1), random.random<double>(-0.1,1.1));
+        
+        TetrahedronSetTopologyContainer::SPtr container = New<TetrahedronSetTopologyContainer>();
+        MeshTopology::SPtr mesh = New<MeshTopology>();
+        container->setNbPoints(int(in.size()));
+        for (const auto& p : in)
+            mesh->addPoint(p[0], p[1], p[2]);
+        for (const auto& t : tetrahedra)
+        {
+            container->addTetra(t[0], t[1], t[2], t[3]);
+            mesh->addTetra(t[0], t[1], t[2], t[3]);
+        }
+        
+        double times[4];
+        for (int parallel = 0; parallel < 2; ++parallel)
+        {
+            TetrahedronMapper::SPtr tetrahedronMapper = New<TetrahedronMapper>(container.get(), nullptr);
+            tetrahedronMapper->setParallelInit(parallel != 0);
+            times[parallel] = measure([&]() { tetrahedronMapper->init(out, in); }, repetitions);
+            
+            MeshMapper::SPtr meshMapper = New<MeshMapper>(mesh.get(), nullptr);
+            meshMapper->setParallelInit(parallel != 0);
+            times[2+parallel] = measure([&]() { meshMapper->clear(); meshMapper->init(out, in); }, repetitions);
+        }
+        
+        std::cout << std::setw(12) << tetrahedra.size() << std::setw(12) << out.size() << std::fixed << std::setprecision(1)
+                  << std::setw(14) << times[0] << std::setw(14) << times[1]
+                  << std::setw(14) << times[2] << std::setw(14) << times[3] << std::endl;
+    }
+    
+    scheduler->stop();
+    return 0;
+}
@@ -22,6 +22,8 @@
 #include <SofaBaseMechanics/BarycentricMapping.h>
 #include <SofaBaseMechanics/BarycentricMappers/BarycentricMapperTriangleSetTopology.h>
 using sofa::component::mapping::BarycentricMapperTriangleSetTopology;
+#include <SofaBaseMechanics/BarycentricMappers/BarycentricMapperTetrahedronSetTopology.h>
+using sofa::component::mapping::BarycentricMapperTetrahedronSetTopology;
 using sofa::component::mapping::BarycentricMapping;
 
 #include <SofaBaseTopology/TriangleSetTopologyContainer.h>
@@ -51,6 +53,10 @@ using sofa::component::container::MechanicalObject ;
 
 using sofa::defaulttype::Vec3dTypes;
 
+#include <sofa/core/topology/TopologyChange.h>
+#include <sofa/simulation/DefaultTaskScheduler.h>
+#include <sofa/helper/RandomGenerator.h>
+
 template <class In, class Out>
 struct BarycentricMapperTriangleSetTopologyTest :  public Test, public BarycentricMapperTriangleSetTopology<In,Out>
 {
@@ -144,3 +150,140 @@ TEST_F(BarycentricMapperTriangleSetTopologyTest_d, initHashing)
 }
 
 
+struct TetrahedronTopologyHolder
+{
+    TetrahedronSetTopologyContainer::SPtr m_tetrahedronTopology { New<TetrahedronSetTopologyContainer>() };
+};
+
+/// Compares the frozen mapping to the mapping evaluated entry by entry
+struct BarycentricMapperFrozenMapTest : public TetrahedronTopologyHolder, public Test, public BarycentricMapperTetrahedronSetTopology<Vec3dTypes,Vec3dTypes>
+{
+    typedef BarycentricMapperTetrahedronSetTopology<Vec3dTypes,Vec3dTypes> Inherit;
+    typedef Vec3dTypes::VecCoord VecCoord;
+    typedef Vec3dTypes::VecDeriv VecDeriv;
+
+    ForceMask m_maskFrom;
+    ForceMask m_maskTo;
+    VecCoord m_in;
+    VecDeriv m_dx, m_force;
+
+    BarycentricMapperFrozenMapTest()
+        : Inherit(m_tetrahedronTopology.get(), nullptr)
+    {}
+
+    void SetUp() override
+    {
+        const int nbIn = 200, nbTetra = 300, nbOut = 5000;
+        sofa::helper::RandomGenerator random(7);
+
+        for (int i=0; i<nbIn; i++)
+        {
+            m_in.push_back(Vector3(random.random<double>(-1.,1.), random.random<double>(-1.,1.), random.random<double>(-1.,1.)));
+            m_dx.push_back(Vector3(random.random<double>(-1.,1.), random.random<double>(-1.,1.), random.random<double>(-1.,1.)));
+        }
+        m_tetrahedronTopology->setNbPoints(nbIn);
+        for (int t=0; t<nbTetra; t++)
+        {
+            const int a = (int)random.random<long>(0, nbIn);
+            m_tetrahedronTopology->addTetra(a, (a+1+t)%nbIn, (a+3+t)%nbIn, (a+7+t)%nbIn);
+        }
+
+        clear(nbOut);
+        for (int i=0; i<nbOut; i++)
+        {
+            const SReal bary[3] = { random.random<SReal>(0.,0.3), random.random<SReal>(0.,0.3), random.random<SReal>(0.,0.3) };
+            addPointInTetra((int)random.random<long>(0, nbTetra), bary);
+            m_force.push_back(Vector3(random.random<double>(-1.,1.), random.random<double>(-1.,1.), random.random<double>(-1.,1.)));
+        }
+
+        m_maskFrom.assign(nbIn, true);
+        m_maskTo.assign(nbOut, true);
+        this->maskFrom = &m_maskFrom;
+        this->maskTo = &m_maskTo;
+    }
+
+    void compareToEntryByEntry(bool parallel)
+    {
+        VecCoord x, frozenX;
+        VecDeriv v, frozenV;
+        VecDeriv f(m_in.size()), frozenF(m_in.size());
+
+        EXPECT_TRUE(setFrozenMap(false, false));
+        apply(x, m_in);
+        applyJ(v, m_dx);
+        applyJT(f, m_force);
+
+        EXPECT_TRUE(setFrozenMap(true, parallel));
+        apply(frozenX, m_in);
+        applyJ(frozenV, m_dx);
+        applyJT(frozenF, m_force);
+
+        ASSERT_EQ(x.size(), frozenX.size());
+        ASSERT_EQ(v.size(), frozenV.size());
+        for (size_t i=0; i<x.size(); i++)
+        {
+            for (int c=0; c<3; c++)
+            {
+                EXPECT_NEAR(x[i][c], frozenX[i][c], 1e-12);
+                EXPECT_NEAR(v[i][c], frozenV[i][c], 1e-12);
+            }
+        }
+        for (size_t i=0; i<f.size(); i++)
+            for (int c=0; c<3; c++)
+                EXPECT_NEAR(f[i][c], frozenF[i][c], 1e-10);
+    }
+};
+
+TEST_F(BarycentricMapperFrozenMapTest, sequential)
+{
+    compareToEntryByEntry(false);
+}
+
+TEST_F(BarycentricMapperFrozenMapTest, parallel)
+{
+    sofa::simulation::TaskScheduler* scheduler = sofa::simulation::TaskScheduler::create(sofa::simulation::DefaultTaskScheduler::name());
+    scheduler->init(4);
+    compareToEntryByEntry(true);
+    scheduler->stop();
+}
+
+TEST_F(BarycentricMapperFrozenMapTest, mapChange)
+{
+    VecCoord x, frozenX;
+    EXPECT_TRUE(setFrozenMap(true, false));
+    apply(frozenX, m_in);
+
+    // the frozen layout follows the changes of the map
+    const SReal bary[3] = { 0.25, 0.25, 0.25 };
+    addPointInTetra(0, bary);
+    apply(frozenX, m_in);
+    EXPECT_TRUE(setFrozenMap(false, false));
+    apply(x, m_in);
+
+    ASSERT_EQ(x.size(), frozenX.size());
+    for (int c=0; c<3; c++)
+        EXPECT_NEAR(x.back()[c], frozenX.back()[c], 1e-12);
+}
+
+TEST_F(BarycentricMapperFrozenMapTest, topologyChange)
+{
+    const SReal bary[3] = { 0.1, 0.2, 0.3 };
+    addPointInTetra(0, bary);
+    VecCoord x, frozenX;
+    EXPECT_TRUE(setFrozenMap(true, false));
+    apply(frozenX, m_in);
+
+    // the frozen layout follows the changes of the elements, notified through the topology change list
+    {
+        sofa::helper::WriteAccessor< sofa::Data< sofa::helper::vector<BaseMeshTopology::Tetrahedron> > > tetrahedra = m_tetrahedronTopology->getTetrahedronDataArray();
+        tetrahedra[0] = BaseMeshTopology::Tetrahedron(tetrahedra[0][3], tetrahedra[0][2], tetrahedra[0][1], tetrahedra[0][0]);
+    }
+    m_tetrahedronTopology->addTopologyChange(new sofa::core::topology::EndingEvent());
+    apply(frozenX, m_in);
+    EXPECT_TRUE(setFrozenMap(false, false));
+    apply(x, m_in);
+
+    ASSERT_EQ(x.size(), frozenX.size());
+    for (int c=0; c<3; c++)
+        EXPECT_NEAR(x.back()[c], frozenX.back()[c], 1e-12);
+}
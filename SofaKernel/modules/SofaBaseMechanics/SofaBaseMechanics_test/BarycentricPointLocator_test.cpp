@@ -0,0 +1,205 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2019 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#include <SofaBaseMechanics/BarycentricMappers/BarycentricPointLocator.h>
+using sofa::component::mapping::BarycentricPointLocator;
+
+#include <SofaBaseMechanics/BarycentricMappers/BarycentricMapperTetrahedronSetTopology.h>
+using sofa::component::mapping::BarycentricMapperTetrahedronSetTopology;
+
+#include <SofaBaseTopology/TetrahedronSetTopologyContainer.h>
+using sofa::component::topology::TetrahedronSetTopologyContainer;
+
+#include <sofa/simulation/DefaultTaskScheduler.h>
+#include <sofa/helper/RandomGenerator.h>
+
+#include <gtest/gtest.h>
+
+namespace
+{
+
+using sofa::defaulttype::Vector3;
+using sofa::defaulttype::Mat3x3d;
+using sofa::defaulttype::Vec3dTypes;
+using sofa::core::topology::BaseMeshTopology;
+using sofa::core::objectmodel::New;
+
+/// Tetrahedra of a jittered grid of n*n*n cubes in [0,1]^3, each cube being split in 6 tetrahedra
+void createTetrahedra(int n, sofa::helper::vector<Vector3>& points, BaseMeshTopology::SeqTetrahedra& tetrahedra)
+{
+    sofa::helper::RandomGenerator random(13);
+    const double h = 1.0 / n;
+    for (int k=0; k<=n; k++)
+        for (int j=0; j<=n; j++)
+            for (int i=0; i<=n; i++)
+                points.push_back(Vector3(i*h + random.random<double>(-0.1,0.1)*h, j*h + random.random<double>(-0.1,0.1)*h, k*h + random.random<double>(-0.1,0.1)*h));
+
+    auto point = [n](int i, int j, int k) { return (unsigned int)((k*(n+1)+j)*(n+1)+i); };
+    for (int k=0; k<n; k++)
+        for (int j=0; j<n; j++)
+            for (int i=0; i<n; i++)
+            {
+                const unsigned int p[8] = { point(i,j,k), point(i+1,j,k), point(i+1,j+1,k), point(i,j+1,k),
+                                            point(i,j,k+1), point(i+1,j,k+1), point(i+1,j+1,k+1), point(i,j+1,k+1) };
+                tetrahedra.push_back(BaseMeshTopology::Tetra(p[0],p[5],p[1],p[6]));
+                tetrahedra.push_back(BaseMeshTopology::Tetra(p[0],p[1],p[2],p[6]));
+                tetrahedra.push_back(BaseMeshTopology::Tetra(p[0],p[2],p[3],p[6]));
+                tetrahedra.push_back(BaseMeshTopology::Tetra(p[0],p[3],p[7],p[6]));
+                tetrahedra.push_back(BaseMeshTopology::Tetra(p[0],p[7],p[4],p[6]));
+                tetrahedra.push_back(BaseMeshTopology::Tetra(p[0],p[4],p[5],p[6]));
+            }
+}
+
+struct BarycentricPointLocator_test : public ::testing::Test
+{
+    sofa::helper::vector<Vector3> m_points;
+    BaseMeshTopology::SeqTetrahedra m_tetrahedra;
+    sofa::helper::vector<Mat3x3d> m_bases;
+    sofa::helper::vector<Vector3> m_centers;
+    sofa::helper::vector<Vector3> m_queries;
+
+    void SetUp() override
+    {
+        createTetrahedra(6, m_points, m_tetrahedra);
+        for (const auto& t : m_tetrahedra)
+        {
+            Mat3x3d m, mt, base;
+            m[0] = m_points[t[1]]-m_points[t[0]];
+            m[1] = m_points[t[2]]-m_points[t[0]];
+            m[2] = m_points[t[3]]-m_points[t[0]];
+            mt.transpose(m);
+            base.invert(mt);
+            m_bases.push_back(base);
+            m_centers.push_back((m_points[t[0]]+m_points[t[1]]+m_points[t[2]]+m_points[t[3]])*0.25);
+        }
+
+        // points inside and around the mesh
+        sofa::helper::RandomGenerator random(5);
+        for (int i=0; i<2000; i++)
+            m_queries.push_back(Vector3(random.random<double>(-0.5,1.5), random.random<double>(-0.5,1.5), random.random<double>(-0.5,1.5)));
+    }
+
+    /// Same measure as the barycentric mappers for tetrahedra
+    double measure(const Vector3& pos, int e) const
+    {
+        const Vector3 v = m_bases[e] * (pos - m_points[m_tetrahedra[e][0]]);
+        double d = std::max(std::max(-v[0],-v[1]), std::max(-v[2],v[0]+v[1]+v[2]-1));
+        if (d>0) d = (pos-m_centers[e]).norm2();
+        return d;
+    }
+};
+
+TEST_F(BarycentricPointLocator_test, sameResultAsExhaustiveSearch)
+{
+    BarycentricPointLocator locator;
+    locator.clear(m_tetrahedra.size());
+    for (std::size_t e=0; e<m_tetrahedra.size(); e++)
+    {
+        locator.addElement();
+        for (unsigned int j=0; j<4; j++)
+            locator.addPoint(e, m_points[m_tetrahedra[e][j]]);
+        locator.addBarycentricRegion(e, m_points[m_tetrahedra[e][0]], m_bases[e]);
+    }
+    locator.build();
+
+    for (const Vector3& pos : m_queries)
+    {
+        int expected = -1;
+        double expectedDistance = 1e10;
+        for (std::size_t e=0; e<m_tetrahedra.size(); e++)
+        {
+            const double d = measure(pos, int(e));
+            if (d < expectedDistance) { expectedDistance = d; expected = int(e); }
+        }
+
+        double distance;
+        const int nearest = locator.findNearest(pos, [&](int e) { return measure(pos, e); }, distance);
+        EXPECT_EQ(expected, nearest) << "point " << pos;
+        EXPECT_EQ(expectedDistance, distance);
+    }
+}
+
+TEST_F(BarycentricPointLocator_test, emptyLocator)
+{
+    BarycentricPointLocator locator;
+    locator.clear(0);
+    locator.build();
+    double distance;
+    EXPECT_EQ(-1, locator.findNearest(Vector3(0,0,0), [](int) { return 0.0; }, distance));
+}
+
+
+/// Barycentric mapper initialized from the points to locate
+struct TetrahedronMapperInit_test : public BarycentricPointLocator_test
+{
+    typedef BarycentricMapperTetrahedronSetTopology<Vec3dTypes,Vec3dTypes> Mapper;
+
+    Vec3dTypes::VecCoord mapPoints(bool parallel)
+    {
+        TetrahedronSetTopologyContainer::SPtr topology = New<TetrahedronSetTopologyContainer>();
+        topology->setNbPoints(int(m_points.size()));
+        for (const auto& t : m_tetrahedra)
+            topology->addTetra(t[0], t[1], t[2], t[3]);
+
+        Mapper::SPtr mapper = New<Mapper>(topology.get(), nullptr);
+        mapper->setParallelInit(parallel);
+
+        Vec3dTypes::VecCoord in(m_points.begin(), m_points.end());
+        Vec3dTypes::VecCoord out(m_queries.begin(), m_queries.end());
+        mapper->init(out, in);
+
+        Vec3dTypes::VecCoord mapped;
+        mapper->apply(mapped, in);
+        return mapped;
+    }
+};
+
+TEST_F(TetrahedronMapperInit_test, pointsInsideAreMappedOnThemselves)
+{
+    const Vec3dTypes::VecCoord mapped = mapPoints(false);
+    ASSERT_EQ(m_queries.size(), mapped.size());
+    for (std::size_t i=0; i<m_queries.size(); i++)
+    {
+        const Vector3& p = m_queries[i];
+        if (p[0] > 0.1 && p[0] < 0.9 && p[1] > 0.1 && p[1] < 0.9 && p[2] > 0.1 && p[2] < 0.9)
+        {
+            for (int c=0; c<3; c++)
+                EXPECT_NEAR(p[c], mapped[i][c], 1e-10);
+        }
+    }
+}
+
+TEST_F(TetrahedronMapperInit_test, parallelInit)
+{
+    const Vec3dTypes::VecCoord sequential = mapPoints(false);
+
+    sofa::simulation::TaskScheduler* scheduler = sofa::simulation::TaskScheduler::create(sofa::simulation::DefaultTaskScheduler::name());
+    scheduler->init(4);
+    const Vec3dTypes::VecCoord parallel = mapPoints(true);
+    scheduler->stop();
+
+    ASSERT_EQ(sequential.size(), parallel.size());
+    for (std::size_t i=0; i<sequential.size(); i++)
+        for (int c=0; c<3; c++)
+            EXPECT_EQ(sequential[i][c], parallel[i][c]);
+}
+
+} // namespace
@@ -22,6 +22,7 @@
 #include <SofaBaseMechanics/MechanicalObject.inl>
 
 #include <SofaTest/Sofa_test.h>
+#include <sofa/helper/RandomGenerator.h>
 using BaseTest = sofa::Sofa_test<SReal>;
 
 namespace sofa
@@ -110,6 +111,130 @@ TYPED_TEST(MechanicalObject_test, checkThatPositionDefaultValueIsAVectorOfValueI
     TestHelpers::CheckPosition(this->mechanicalObject);
 }
 
+template<typename T>
+struct MechanicalObjectVMultiOp_test : public BaseTest
+{
+    typedef component::container::MechanicalObject<T> MechanicalObject;
+    typedef typename T::VecDeriv VecDeriv;
+    typedef typename T::VecCoord VecCoord;
+    typedef typename T::Real Real;
+    typedef core::behavior::BaseMechanicalState::VMultiOp VMultiOp;
+    typedef core::behavior::BaseMechanicalState::VMultiOpEntry VMultiOpEntry;
+
+    typename MechanicalObject::SPtr fused;
+    typename MechanicalObject::SPtr reference;
+
+    void SetUp() override
+    {
+        // not a multiple of the size of the blocks processed by the fused operations
+        const size_t n = 1001;
+        fused = core::objectmodel::New<MechanicalObject>();
+        reference = core::objectmodel::New<MechanicalObject>();
+        fused->resize(n);
+        reference->resize(n);
+        sofa::helper::RandomGenerator random(17);
+        const core::VecDerivId derivs[3] = { core::VecDerivId::velocity(), core::VecDerivId::force(), core::VecDerivId::dx() };
+        for (const core::VecDerivId& id : derivs)
+        {
+            helper::WriteAccessor< Data<VecDeriv> > v1 = *fused->write(id);
+            helper::WriteAccessor< Data<VecDeriv> > v2 = *reference->write(id);
+            // resize() only touches the vectors which are already set
+            v1.resize(n);
+            for (size_t i = 0; i < n; ++i)
+                for (size_t c = 0; c < (size_t)T::deriv_total_size; ++c)
+                    defaulttype::DataTypeInfo<typename T::Deriv>::setValue(v1[i], c, random.random<Real>(-1, 1));
+            v2.wref() = v1.ref();
+        }
+        helper::WriteAccessor< Data<VecCoord> > x1 = *fused->write(core::VecCoordId::position());
+        helper::WriteAccessor< Data<VecCoord> > x2 = *reference->write(core::VecCoordId::position());
+        for (size_t i = 0; i < n; ++i)
+            T::set(x1[i], random.random<Real>(-1, 1), random.random<Real>(-1, 1), random.random<Real>(-1, 1));
+        x2.wref() = x1.ref();
+    }
+
+    /// v = v + f*0.5 + dx*0.25 ; dx = v*-2 + dx, the result of the second operation being one of its operands
+    VMultiOp derivOps() const
+    {
+        VMultiOp ops(2);
+        ops[0] = VMultiOpEntry(core::VecDerivId::velocity(), core::VecDerivId::velocity(), 1.0, core::VecDerivId::force(), 0.5);
+        ops[0].second.push_back(std::make_pair(core::ConstMultiVecId(core::VecDerivId::dx()), 0.25));
+        ops[1] = VMultiOpEntry(core::VecDerivId::dx(), core::VecDerivId::velocity(), -2.0, core::VecDerivId::dx(), 1.0);
+        return ops;
+    }
+
+    void applyReferenceDerivOps()
+    {
+        reference->vOp(nullptr, core::VecDerivId::velocity(), core::VecDerivId::velocity(), core::VecDerivId::force(), 0.5);
+        reference->vOp(nullptr, core::VecDerivId::velocity(), core::VecDerivId::velocity(), core::VecDerivId::dx(), 0.25);
+        reference->vOp(nullptr, core::VecDerivId::dx(), core::VecDerivId::dx(), core::VecDerivId::velocity(), -2.0);
+    }
+
+    void compareDerivs()
+    {
+        const core::VecDerivId derivs[2] = { core::VecDerivId::velocity(), core::VecDerivId::dx() };
+        const Real epsilon = std::numeric_limits<Real>::epsilon() * 10;
+        for (const core::VecDerivId& id : derivs)
+        {
+            const VecDeriv& v1 = fused->read(core::ConstVecDerivId(id))->getValue();
+            const VecDeriv& v2 = reference->read(core::ConstVecDerivId(id))->getValue();
+            ASSERT_EQ(v2.size(), v1.size());
+            for (size_t i = 0; i < v1.size(); ++i)
+                for (size_t c = 0; c < (size_t)T::deriv_total_size; ++c)
+                {
+                    Real a, b;
+                    defaulttype::DataTypeInfo<typename T::Deriv>::getValue(v1[i], c, a);
+                    defaulttype::DataTypeInfo<typename T::Deriv>::getValue(v2[i], c, b);
+                    ASSERT_NEAR(b, a, epsilon) << id << " " << i << " " << c;
+                }
+        }
+    }
+};
+
+typedef ::testing::Types<Vec3Types, Vec3fTypes, Vec1Types, Rigid3Types> VMultiOpDataTypesList;
+TYPED_TEST_CASE(MechanicalObjectVMultiOp_test, VMultiOpDataTypesList);
+
+TYPED_TEST(MechanicalObjectVMultiOp_test, sameResultsAsSequentialVOp)
+{
+    this->fused->vMultiOp(nullptr, this->derivOps());
+    this->applyReferenceDerivOps();
+    this->compareDerivs();
+}
+
+TYPED_TEST(MechanicalObjectVMultiOp_test, fusedDotProduct)
+{
+    typedef typename TypeParam::Real Real;
+    const SReal dot = this->fused->vMultiOpDot(nullptr, this->derivOps(), core::VecDerivId::dx(), core::VecDerivId::velocity());
+    this->applyReferenceDerivOps();
+    this->compareDerivs();
+    const SReal expected = this->reference->vDot(nullptr, core::VecDerivId::dx(), core::VecDerivId::velocity());
+    EXPECT_NEAR(expected, dot, std::fabs(expected) * std::numeric_limits<Real>::epsilon() * 1000);
+}
+
+TYPED_TEST(MechanicalObjectVMultiOp_test, positionUpdate)
+{
+    typedef typename TypeParam::VecCoord VecCoord;
+    typedef typename TypeParam::Real Real;
+    // x = x + v*0.01 after v = v + f*0.5
+    typename TestFixture::VMultiOp ops(2);
+    ops[0] = typename TestFixture::VMultiOpEntry(core::VecDerivId::velocity(), core::VecDerivId::velocity(), core::VecDerivId::force(), 0.5);
+    ops[1] = typename TestFixture::VMultiOpEntry(core::VecCoordId::position(), core::VecCoordId::position(), core::VecDerivId::velocity(), 0.01);
+    this->fused->vMultiOp(nullptr, ops);
+    this->reference->vOp(nullptr, core::VecDerivId::velocity(), core::VecDerivId::velocity(), core::VecDerivId::force(), 0.5);
+    this->reference->vOp(nullptr, core::VecCoordId::position(), core::VecCoordId::position(), core::VecDerivId::velocity(), 0.01);
+
+    const VecCoord& x1 = this->fused->read(core::ConstVecCoordId::position())->getValue();
+    const VecCoord& x2 = this->reference->read(core::ConstVecCoordId::position())->getValue();
+    ASSERT_EQ(x2.size(), x1.size());
+    for (size_t i = 0; i < x1.size(); ++i)
+        for (size_t c = 0; c < (size_t)TypeParam::coord_total_size; ++c)
+        {
+            Real a, b;
+            defaulttype::DataTypeInfo<typename TypeParam::Coord>::getValue(x1[i], c, a);
+            defaulttype::DataTypeInfo<typename TypeParam::Coord>::getValue(x2[i], c, b);
+            ASSERT_NEAR(b, a, std::numeric_limits<Real>::epsilon() * 10) << i << " " << c;
+        }
+}
+
 } // namespace
 
 } // namespace sofa
@@ -0,0 +1,208 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2019 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#ifndef SOFA_COMPONENT_TOPOLOGY_COMPRESSEDAROUNDARRAY_H
+#define SOFA_COMPONENT_TOPOLOGY_COMPRESSEDAROUNDARRAY_H
+#include "config.h"
+
+#include <sofa/helper/vector.h>
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <utility>
+
+namespace sofa
+{
+
+namespace component
+{
+
+namespace topology
+{
+
+/** Array of the elements around each owner (vertex, edge...), like the vertex shells of the topology containers.
+ *
+ *  For a static mesh, the lists are stored in compressed row form: the elements of owner i are
+ *  indices[offsets[i]] to indices[offsets[i+1]-1]. This avoids one allocation per owner and keeps the
+ *  lists contiguous. They are read without copy through range().
+ *
+ *  The interface of a vector of lists is kept for the existing code: the lists are expanded on the first
+ *  access through operator[] or getLists(). A const access keeps the compressed form, which remains used
+ *  by range(), so that concurrent readers are safe. A non-const access is a modification of the topology:
+ *  the compressed form is released and the lists are used from then on.
+ */
+template<class ID>
+class CompressedAroundArray
+{
+public:
+    typedef sofa::helper::vector<ID> List;
+    typedef sofa::helper::vector<List> ListArray;
+
+    /// Read-only view on the elements around one owner, valid until the array is modified
+    class Range
+    {
+    public:
+        typedef const ID* const_iterator;
+
+        Range() : m_begin(nullptr), m_end(nullptr) {}
+        Range(const ID* begin, const ID* end) : m_begin(begin), m_end(end) {}
+
+        const_iterator begin() const { return m_begin; }
+        const_iterator end() const { return m_end; }
+        std::size_t size() const { return std::size_t(m_end - m_begin); }
+        bool empty() const { return m_begin == m_end; }
+        const ID& operator[](std::size_t i) const { return m_begin[i]; }
+
+    protected:
+        const ID* m_begin;
+        const ID* m_end;
+    };
+
+    CompressedAroundArray() : m_compressed(false), m_hasLists(true) {}
+
+    CompressedAroundArray(const CompressedAroundArray& other)
+        : m_lists(other.getLists()), m_compressed(false), m_hasLists(true)
+    {
+    }
+
+    CompressedAroundArray& operator=(const CompressedAroundArray& other)
+    {
+        if (this != &other)
+            *this = other.getLists();
+        return *this;
+    }
+
+    CompressedAroundArray& operator=(const ListArray& lists)
+    {
+        releaseCompressed();
+        m_lists = lists;
+        return *this;
+    }
+
+    /// Sets the compressed lists: offsets has size()+1 entries and offsets.back() == indices.size()
+    void setCompressed(sofa::helper::vector<std::size_t>& offsets, sofa::helper::vector<ID>& indices)
+    {
+        m_lists.clear();
+        m_offsets.swap(offsets);
+        m_indices.swap(indices);
+        m_compressed = true;
+        m_hasLists = false;
+    }
+
+    /// True while the lists are stored in compressed form
+    bool isCompressed() const { return m_compressed; }
+
+    std::size_t size() const
+    {
+        return m_compressed ? m_offsets.size() - 1 : m_lists.size();
+    }
+
+    bool empty() const { return size() == 0; }
+
+    /// Elements around owner i, read without expanding the lists. Empty if i is out of range.
+    Range range(std::size_t i) const
+    {
+        if (i >= size())
+            return Range();
+        if (m_compressed)
+            return Range(m_indices.data() + m_offsets[i], m_indices.data() + m_offsets[i + 1]);
+        const List& list = m_lists[i];
+        return Range(list.data(), list.data() + list.size());
+    }
+
+    /// Copy of the elements around owner i in increasing order, read without expanding the lists
+    List getSortedList(std::size_t i) const
+    {
+        const Range r = range(i);
+        List list;
+        list.assign(r.begin(), r.end());
+        std::sort(list.begin(), list.end());
+        return list;
+    }
+
+    /// Lists of all owners, expanded from the compressed form if needed
+    const ListArray& getLists() const
+    {
+        if (!m_hasLists.load(std::memory_order_acquire))
+        {
+            std::lock_guard<std::mutex> lock(m_expandMutex);
+            if (!m_hasLists.load(std::memory_order_relaxed))
+            {
+                m_lists.resize(m_offsets.size() - 1);
+                for (std::size_t i = 0; i + 1 < m_offsets.size(); ++i)
+                    m_lists[i].assign(m_indices.begin() + m_offsets[i], m_indices.begin() + m_offsets[i + 1]);
+                m_hasLists.store(true, std::memory_order_release);
+            }
+        }
+        return m_lists;
+    }
+
+    operator const ListArray&() const { return getLists(); }
+
+    const List& operator[](std::size_t i) const { return getLists()[i]; }
+
+    /// Lists of all owners for modification: the compressed form is released
+    ListArray& getListsForModification()
+    {
+        getLists();
+        releaseCompressed();
+        return m_lists;
+    }
+
+    List& operator[](std::size_t i) { return getListsForModification()[i]; }
+
+    void resize(std::size_t n) { getListsForModification().resize(n); }
+
+    void push_back(const List& list) { getListsForModification().push_back(list); }
+
+    void clear()
+    {
+        releaseCompressed();
+        m_lists.clear();
+    }
+
+protected:
+    void releaseCompressed()
+    {
+        if (!m_compressed)
+            return;
+        sofa::helper::vector<std::size_t>().swap(m_offsets);
+        sofa::helper::vector<ID>().swap(m_indices);
+        m_compressed = false;
+        m_hasLists = true;
+    }
+
+    mutable ListArray m_lists;
+    sofa::helper::vector<std::size_t> m_offsets;
+    sofa::helper::vector<ID> m_indices;
+    bool m_compressed;
+    mutable std::atomic<bool> m_hasLists;
+    mutable std::mutex m_expandMutex;
+};
+
+} // namespace topology
+
+} // namespace component
+
+} // namespace sofa
+
+#endif // SOFA_COMPONENT_TOPOLOGY_COMPRESSEDAROUNDARRAY_H
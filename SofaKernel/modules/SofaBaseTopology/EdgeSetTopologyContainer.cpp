@@ -20,6 +20,7 @@
 * Contact information: contact@sofa-framework.org                             *
 ******************************************************************************/
 #include <SofaBaseTopology/EdgeSetTopologyContainer.h>
+#include <SofaBaseTopology/TopologyArrayBuilder.h>
 #include <sofa/core/visual/VisualParams.h>
 
 #include <sofa/core/ObjectFactory.h>
@@ -57,9 +58,15 @@ EdgeSetTopologyContainer::EdgeSetTopologyContainer()
     : PointSetTopologyContainer( )
     , d_edge(initData(&d_edge, "edges", "List of edge indices"))
     , m_checkConnexity(initData(&m_checkConnexity, false, "checkConnexity", "It true, will check the connexity of the mesh."))
+    , d_parallelInit(initData(&d_parallelInit, false, "parallelInit", "Build the topology arrays (edges, faces, shells) with parallel tasks"))
 {
 }
 
+simulation::TaskScheduler* EdgeSetTopologyContainer::getInitTaskScheduler() const
+{
+    return d_parallelInit.getValue() ? simulation::TaskScheduler::getInstance() : nullptr;
+}
+
 
 void EdgeSetTopologyContainer::init()
 {
@@ -122,22 +129,26 @@ void EdgeSetTopologyContainer::createEdgesAroundVertexArray()
     if (nbPoints == 0) // in case only Data have been copied and not going thourgh AddTriangle methods.
         this->setNbPoints(d_initPoints.getValue().size());
 
-    m_edgesAroundVertex.resize(getNbPoints());
+    bool consistent = true;
     for (unsigned int edgeId=0; edgeId<edges.size(); ++edgeId)
     {
         const Edge& edge = edges[edgeId];
-        // adding edge in the edge shell of both points
-        
         if (edge[0] >= unsigned(nbPoints) || edge[1] >= unsigned(nbPoints))
         {
             msg_warning() << "EdgesAroundVertex creation failed, Edge buffer is not concistent with number of points: Edge: " << edge << " for: " << nbPoints << " points.";
-            continue;
+            consistent = false;
         }
-
-        m_edgesAroundVertex[ edge[0] ].push_back(edgeId);
-        m_edgesAroundVertex[ edge[1] ].push_back(edgeId);
     }
 
+    // adding edge in the edge shell of both points, skipping inconsistent edges
+    topologyarray::buildAroundArray(getInitTaskScheduler(), edges.size(), 2, getNbPoints(), [&](size_t edgeId, unsigned int j) -> PointID
+    {
+        const Edge& edge = edges[edgeId];
+        if (!consistent && (edge[0] >= unsigned(nbPoints) || edge[1] >= unsigned(nbPoints)))
+            return PointID(InvalidID);
+        return edge[j];
+    }, m_edgesAroundVertex);
+
     if (m_checkConnexity.getValue())
         this->checkConnexity();
 }
@@ -182,7 +193,7 @@ EdgeSetTopologyContainer::EdgeID EdgeSetTopologyContainer::getEdgeIndex(PointID
         return InvalidID;
     }
 
-    const sofa::helper::vector< EdgeID >& es1 = getEdgesAroundVertex(v1);
+    const EdgesAroundVertexRange es1 = m_edgesAroundVertex.range(v1);
     if (es1.empty())
         return InvalidID;
 
@@ -243,7 +254,7 @@ bool EdgeSetTopologyContainer::checkTopology() const
             // loop on all edges around vertex
             for (size_t i = 0; i < m_edgesAroundVertex.size(); ++i)
 			{
-				const sofa::helper::vector<EdgeID> &es = m_edgesAroundVertex[i];
+				const EdgesAroundVertexRange es = m_edgesAroundVertex.range(i);
 				for (size_t j = 0; j < es.size(); ++j)
 				{
                     const Edge& edge = m_edge[es[j]];
@@ -419,7 +430,7 @@ const EdgeSetTopologyContainer::VecEdgeID EdgeSetTopologyContainer::getElementAr
 
     for(size_t i = 0; i<2; ++i) // for each node of the edge
     {
-        const EdgesAroundVertex& edgeAV = this->getEdgesAroundVertex(the_edge[i]);
+        const EdgesAroundVertexRange edgeAV = getEdgesAroundVertexRange(the_edge[i]);
         if (edgeAV.empty()) {
             msg_error() << "No edge found aroud of vertex id: " << the_edge[i] << ". Should at least found edge id: " << elem;
             continue;
@@ -520,19 +531,24 @@ const sofa::helper::vector< sofa::helper::vector<EdgeSetTopologyContainer::EdgeI
     if(CHECK_TOPOLOGY)
         msg_warning_when(m_edgesAroundVertex.empty()) << "EdgesAroundVertex shell array is empty.";
 
-    return m_edgesAroundVertex;
+    return m_edgesAroundVertex.getLists();
 }
 
 const EdgeSetTopologyContainer::EdgesAroundVertex& EdgeSetTopologyContainer::getEdgesAroundVertex(PointID id)
 {
     if(id < m_edgesAroundVertex.size())
-        return m_edgesAroundVertex[id];
+        return m_edgesAroundVertex.getLists()[id];
     else if(CHECK_TOPOLOGY)
         msg_error() << "EdgesAroundVertex array access out of bounds: " << id << " >= " << m_edgesAroundVertex.size();
 
     return InvalidSet;
 }
 
+EdgeSetTopologyContainer::EdgesAroundVertexRange EdgeSetTopologyContainer::getEdgesAroundVertexRange(PointID id) const
+{
+    return m_edgesAroundVertex.range(id);
+}
+
 sofa::helper::vector< EdgeSetTopologyContainer::EdgeID > &EdgeSetTopologyContainer::getEdgesAroundVertexForModification(const PointID i)
 {
     if(!hasEdgesAroundVertex())	// this method should only be called when the shell array exists
@@ -24,10 +24,16 @@
 #include "config.h"
 
 #include <SofaBaseTopology/PointSetTopologyContainer.h>
+#include <SofaBaseTopology/CompressedAroundArray.h>
 
 namespace sofa
 {
 
+namespace simulation
+{
+class TaskScheduler;
+}
+
 namespace component
 {
 
@@ -48,6 +54,7 @@ public:
     typedef BaseMeshTopology::Edge                  Edge;
     typedef BaseMeshTopology::SeqEdges              SeqEdges;
     typedef BaseMeshTopology::EdgesAroundVertex     EdgesAroundVertex;
+    typedef CompressedAroundArray<EdgeID>::Range    EdgesAroundVertexRange;
     typedef sofa::helper::vector<EdgeID>            VecEdgeID;
 
 
@@ -98,6 +105,14 @@ public:
      */
     const EdgesAroundVertex& getEdgesAroundVertex(PointID id) override;
 
+    /** \brief Returns the edges around a vertex without copying them, also when the shell array
+     * is stored in compressed form. The range is valid until the topology changes.
+     *
+     * @param id The ID of the vertex.
+     * @return An empty range if the vertex is out of range.
+     */
+    EdgesAroundVertexRange getEdgesAroundVertexRange(PointID id) const;
+
     /// @}
 
 
@@ -227,10 +242,13 @@ protected:
      */
     virtual EdgesAroundVertex &getEdgesAroundVertexForModification(const PointID i);
 
+    /// Task scheduler building the topology arrays if d_parallelInit is set, nullptr to build them in the calling thread
+    simulation::TaskScheduler* getInitTaskScheduler() const;
+
 protected:
 
     /** the array that stores the set of edge-vertex shells, ie for each vertex gives the set of adjacent edges */
-    sofa::helper::vector< EdgesAroundVertex > m_edgesAroundVertex;
+    CompressedAroundArray<EdgeID> m_edgesAroundVertex;
 
 
     /// Boolean used to know if the topology Data of this container is dirty
@@ -249,6 +267,8 @@ public:
 
     Data <bool> m_checkConnexity; ///< It true, will check the connexity of the mesh.
 
+    Data <bool> d_parallelInit; ///< Build the topology arrays (edges, faces, shells) with parallel tasks
+
 
 };
 
@@ -21,6 +21,7 @@
 ******************************************************************************/
 
 #include <SofaBaseTopology/HexahedronSetTopologyContainer.h>
+#include <SofaBaseTopology/TopologyArrayBuilder.h>
 #include <sofa/core/visual/VisualParams.h>
 #include <sofa/core/ObjectFactory.h>
 
@@ -125,30 +126,15 @@ void HexahedronSetTopologyContainer::createEdgeSetArray()
         clearHexahedraAroundEdge();
     }
 
-    // create a temporary map to find redundant edges
-    std::map<Edge,EdgeID> edgeMap;
     helper::WriteAccessor< Data< sofa::helper::vector<Edge> > > m_edge = d_edge;
     helper::ReadAccessor< Data< sofa::helper::vector<Hexahedron> > > m_hexahedron = d_hexahedron;
 
-    /// create the m_edge array at the same time than it fills the m_edgesInHexahedron array
-    for(size_t i=0; i<m_hexahedron.size(); ++i)
+    // edges are stored with their vertices in lexicographic order
+    topologyarray::buildEdges(getInitTaskScheduler(), m_hexahedron.size(), 12, [&](size_t i, unsigned int j)
     {
         const Hexahedron &t = m_hexahedron[i];
-        for(PointID j=0; j<12; ++j)
-        {
-            PointID v1 = t[edgesInHexahedronArray[j][0]];
-            PointID v2 = t[edgesInHexahedronArray[j][1]];
-            const Edge e((v1<v2) ? Edge(v1,v2) : Edge(v2,v1));
-
-            if(edgeMap.find(e)==edgeMap.end())
-            {
-                // edge not in edgeMap so create a new one
-                const size_t edgeIndex = edgeMap.size();
-                edgeMap[e] = (EdgeID)edgeIndex;
-                m_edge.push_back(e);
-            }
-        }
-    }
+        return Edge(t[edgesInHexahedronArray[j][0]], t[edgesInHexahedronArray[j][1]]);
+    }, false, m_edge, (sofa::helper::vector<EdgesInHexahedron>*)nullptr);
 }
 
 void HexahedronSetTopologyContainer::createEdgesInHexahedronArray()
@@ -162,21 +148,15 @@ void HexahedronSetTopologyContainer::createEdgesInHexahedronArray()
     if (hasEdgesInHexahedron()) // created by upper topology
         return;
 
-    m_edgesInHexahedron.resize( getNumberOfHexahedra());
+    helper::ReadAccessor< Data< sofa::helper::vector<Edge> > > m_edge = d_edge;
     helper::ReadAccessor< Data< sofa::helper::vector<Hexahedron> > > m_hexahedron = d_hexahedron;
 
-    for(size_t i=0; i<m_hexahedron.size(); ++i)
+    // edges which are not found are set to InvalidID
+    topologyarray::findEdges(getInitTaskScheduler(), m_edge, m_hexahedron.size(), 12, [&](size_t i, unsigned int j)
     {
         const Hexahedron &t = m_hexahedron[i];
-
-        // adding edge i in the edge shell of both points
-        for(PointID j=0; j<12; ++j)
-        {
-            EdgeID edgeIndex = getEdgeIndex(t[edgesInHexahedronArray[j][0]],
-                    t[edgesInHexahedronArray[j][1]]);
-            m_edgesInHexahedron[i][j] = edgeIndex;
-        }
-    }
+        return Edge(t[edgesInHexahedronArray[j][0]], t[edgesInHexahedronArray[j][1]]);
+    }, m_edgesInHexahedron);
 }
 
 void HexahedronSetTopologyContainer::createQuadSetArray()
@@ -192,176 +172,47 @@ void HexahedronSetTopologyContainer::createQuadSetArray()
         clearHexahedraAroundQuad();
     }
 
-    // create a temporary map to find redundant quads
-    std::map<Quad, QuadID> quadMap;
     helper::WriteAccessor< Data< sofa::helper::vector<Quad> > > m_quad = d_quad;
     helper::ReadAccessor< Data< sofa::helper::vector<Hexahedron> > > m_hexahedron = d_hexahedron;
 
-    for(size_t i=0; i<m_hexahedron.size(); ++i)
+    // quad j of hexahedron i, rotated such that its first vertex is the smallest one
+    auto orientedQuad = [&](size_t i, unsigned int j)
     {
         const Hexahedron &h = m_hexahedron[i];
+        PointID v[4];
+        for (unsigned int k=0; k<4; ++k)
+            v[k] = h[sofa::core::topology::quadsOrientationInHexahedronArray[j][k]];
 
-        unsigned int v[4], val;
-
-        // Quad 0 :
-        v[0]=h[0];
-        v[1]=h[3];
-        v[2]=h[2];
-        v[3]=h[1];
-
-        // sort v such that v[0] is the smallest one
-        while ((v[0]>v[1]) || (v[0]>v[2]) || (v[0]>v[3]))
-        {
-            val = v[0];
-            v[0]=v[1];
-            v[1]=v[2];
-            v[2]=v[3];
-            v[3]=val;
-        }
-
-        // sort vertices in lexicographics order
-        QuadID quadIndex;
-        Quad qu(v[0],v[3],v[2],v[1]);
-        std::map<Quad,QuadID>::iterator itt = quadMap.find(qu);
-        if(itt==quadMap.end())
-        {
-            // quad not in edgeMap so create a new one
-            quadIndex=(QuadID)m_quad.size();
-            quadMap[qu]=quadIndex;
-            qu=Quad(v[0],v[1],v[2],v[3]);
-            quadMap[qu]=quadIndex;
-            m_quad.push_back(qu);
-        }
-
-        // Quad 1 :
-        v[0]=h[4];
-        v[1]=h[5];
-        v[2]=h[6];
-        v[3]=h[7];
-        // sort v such that v[0] is the smallest one
-        while ((v[0]>v[1]) || (v[0]>v[2]) || (v[0]>v[3]))
-        {
-            val=v[0];
-            v[0]=v[1];
-            v[1]=v[2];
-            v[2]=v[3];
-            v[3]=val;
-        }
-        // sort vertices in lexicographics order
-        qu=Quad(v[0],v[3],v[2],v[1]);
-        itt=quadMap.find(qu);
-        if(itt==quadMap.end())
-        {
-            // quad not in edgeMap so create a new one
-            quadIndex=(QuadID)m_quad.size();
-            quadMap[qu]=quadIndex;
-            qu=Quad(v[0],v[1],v[2],v[3]);
-            quadMap[qu]=quadIndex;
-            m_quad.push_back(qu);
-        }
-
-        // Quad 2 :
-        v[0]=h[0]; v[1]=h[1]; v[2]=h[5]; v[3]=h[4];
-        // sort v such that v[0] is the smallest one
-        while ((v[0]>v[1]) || (v[0]>v[2]) || (v[0]>v[3]))
-        {
-            val=v[0];
-            v[0]=v[1];
-            v[1]=v[2];
-            v[2]=v[3];
-            v[3]=val;
-        }
-        // sort vertices in lexicographics order
-        qu=Quad(v[0],v[3],v[2],v[1]);
-        itt=quadMap.find(qu);
-        if(itt==quadMap.end())
-        {
-            // quad not in edgeMap so create a new one
-            quadIndex=(QuadID)m_quad.size();
-            quadMap[qu]=quadIndex;
-            qu=Quad(v[0],v[1],v[2],v[3]);
-            quadMap[qu]=quadIndex;
-            m_quad.push_back(qu);
-        }
-
-        // Quad 3 :
-        v[0]=h[1]; v[1]=h[2]; v[2]=h[6]; v[3]=h[5];
-        // sort v such that v[0] is the smallest one
         while ((v[0]>v[1]) || (v[0]>v[2]) || (v[0]>v[3]))
         {
-            val=v[0];
+            PointID val=v[0];
             v[0]=v[1];
             v[1]=v[2];
             v[2]=v[3];
             v[3]=val;
         }
-        // sort vertices in lexicographics order
-        qu=Quad(v[0],v[3],v[2],v[1]);
-        itt=quadMap.find(qu);
-        if(itt==quadMap.end())
-        {
-            // quad not in edgeMap so create a new one
-            quadIndex=(QuadID)m_quad.size();
-            quadMap[qu]=quadIndex;
-            qu=Quad(v[0],v[1],v[2],v[3]);
-            quadMap[qu]=quadIndex;
-            m_quad.push_back(qu);
-        }
+        return Quad(v[0], v[1], v[2], v[3]);
+    };
 
-        // Quad 4 :
-        v[0]=h[2];
-        v[1]=h[3];
-        v[2]=h[7];
-        v[3]=h[6];
-        // sort v such that v[0] is the smallest one
-        while ((v[0]>v[1]) || (v[0]>v[2]) || (v[0]>v[3]))
-        {
-            val=v[0];
-            v[0]=v[1];
-            v[1]=v[2];
-            v[2]=v[3];
-            v[3]=val;
-        }
-        // sort vertices in lexicographics order
-        qu=Quad(v[0],v[3],v[2],v[1]);
-        itt=quadMap.find(qu);
-        if(itt==quadMap.end())
-        {
-            // quad not in edgeMap so create a new one
-            quadIndex=(QuadID)m_quad.size();
-            quadMap[qu]=quadIndex;
-            qu=Quad(v[0],v[1],v[2],v[3]);
-            quadMap[qu]=quadIndex;
-            m_quad.push_back(qu);
-        }
-
-        // Quad 5 :
-        v[0]=h[3];
-        v[1]=h[0];
-        v[2]=h[4];
-        v[3]=h[7];
-        // sort v such that v[0] is the smallest one
-        while ((v[0]>v[1]) || (v[0]>v[2]) || (v[0]>v[3]))
-        {
-            val=v[0];
-            v[0]=v[1];
-            v[1]=v[2];
-            v[2]=v[3];
-            v[3]=val;
-        }
-        // sort vertices in lexicographics order
-        qu=Quad(v[0],v[3],v[2],v[1]);
-        itt=quadMap.find(qu);
-        if(itt==quadMap.end())
-        {
-            // quad not in edgeMap so create a new one
-            quadIndex=(QuadID)m_quad.size();
-            quadMap[qu]=quadIndex;
-            qu=Quad(v[0],v[1],v[2],v[3]);
-            quadMap[qu]=quadIndex;
-            m_quad.push_back(qu);
-        }
-    }
+    // quads with the same vertices in the same cyclic order are the same, whatever their orientation
+    helper::vector<QuadID> ids, firstOccurrence;
+    topologyarray::buildUniqueIds<4>(getInitTaskScheduler(), m_hexahedron.size() * 6, [&](size_t occurrence, PointID* v)
+    {
+        const Quad qu = orientedQuad(occurrence / 6, occurrence % 6);
+        v[0] = qu[0];
+        v[1] = std::min(qu[1], qu[3]);
+        v[2] = qu[2];
+        v[3] = std::max(qu[1], qu[3]);
+    }, ids, firstOccurrence);
+
+    // the first occurrence gives the orientation of the quad
+    const size_t offset = m_quad.size();
+    m_quad.resize(offset + firstOccurrence.size());
+    topologyarray::forEachRange(getInitTaskScheduler(), 0, firstOccurrence.size(), [&](size_t first, size_t last)
+    {
+        for (size_t id = first; id < last; ++id)
+            m_quad[offset + id] = orientedQuad(firstOccurrence[id] / 6, firstOccurrence[id] % 6);
+    }, 1024);
 }
 
 void HexahedronSetTopologyContainer::createQuadsInHexahedronArray()
@@ -375,39 +226,33 @@ void HexahedronSetTopologyContainer::createQuadsInHexahedronArray()
     if(hasQuadsInHexahedron())// created by upper topology
         return;
 
-    m_quadsInHexahedron.resize( getNumberOfHexahedra());
+    helper::ReadAccessor< Data< sofa::helper::vector<Quad> > > m_quad = d_quad;
     helper::ReadAccessor< Data< sofa::helper::vector<Hexahedron> > > m_hexahedron = d_hexahedron;
 
+    // quads are found from their vertices, whatever their order
+    helper::vector<QuadID> ids;
+    topologyarray::findIds<4>(getInitTaskScheduler(), m_quad.size(), [&](size_t i, PointID* v)
+    {
+        const Quad &qu = m_quad[i];
+        std::copy(qu.begin(), qu.end(), v);
+        std::sort(v, v + 4);
+    }, m_hexahedron.size() * 6, [&](size_t occurrence, PointID* v)
+    {
+        const Hexahedron &h = m_hexahedron[occurrence / 6];
+        for (unsigned int k=0; k<4; ++k)
+            v[k] = h[sofa::core::topology::quadsOrientationInHexahedronArray[occurrence % 6][k]];
+        std::sort(v, v + 4);
+    }, ids);
+
+    // adding the 6 quads in the quad list of the ith hexahedron  i
+    m_quadsInHexahedron.resize( getNumberOfHexahedra());
     for(size_t i = 0; i < getNumberOfHexahedra(); ++i)
     {
-        const Hexahedron &h=m_hexahedron[i];
-        QuadID quadIndex;
-
-        // adding the 6 quads in the quad list of the ith hexahedron  i
-        // Quad 0 :
-        quadIndex=getQuadIndex(h[0],h[3],h[2],h[1]);
-        assert(quadIndex!= InvalidID);
-        m_quadsInHexahedron[i][0]=quadIndex;
-        // Quad 1 :
-        quadIndex=getQuadIndex(h[4],h[5],h[6],h[7]);
-        assert(quadIndex!= InvalidID);
-        m_quadsInHexahedron[i][1]=quadIndex;
-        // Quad 2 :
-        quadIndex=getQuadIndex(h[0],h[1],h[5],h[4]);
-        assert(quadIndex!= InvalidID);
-        m_quadsInHexahedron[i][2]=quadIndex;
-        // Quad 3 :
-        quadIndex=getQuadIndex(h[1],h[2],h[6],h[5]);
-        assert(quadIndex!= InvalidID);
-        m_quadsInHexahedron[i][3]=quadIndex;
-        // Quad 4 :
-        quadIndex=getQuadIndex(h[2],h[3],h[7],h[6]);
-        assert(quadIndex!= InvalidID);
-        m_quadsInHexahedron[i][4]=quadIndex;
-        // Quad 5 :
-        quadIndex=getQuadIndex(h[3],h[0],h[4],h[7]);
-        assert(quadIndex!= InvalidID);
-        m_quadsInHexahedron[i][5]=quadIndex;
+        for (unsigned int j=0; j<6; ++j)
+        {
+            assert(ids[i * 6 + j] != InvalidID);
+            m_quadsInHexahedron[i][j] = ids[i * 6 + j];
+        }
     }
 }
 
@@ -419,16 +264,13 @@ void HexahedronSetTopologyContainer::createHexahedraAroundVertexArray()
     if (getNbPoints() == 0) // in case only Data have been copied and not going thourgh AddTriangle methods.
         this->setNbPoints(d_initPoints.getValue().size());
 
-    m_hexahedraAroundVertex.resize( getNbPoints() );
     helper::ReadAccessor< Data< sofa::helper::vector<Hexahedron> > > m_hexahedron = d_hexahedron;
 
-    for(size_t i=0; i<m_hexahedron.size(); ++i)
+    // adding hexahedron i in the vertex shell of its points
+    topologyarray::buildAroundArray(getInitTaskScheduler(), m_hexahedron.size(), 8, getNbPoints(), [&](size_t i, unsigned int j) -> PointID
     {
-        HexahedronID hexaID = (HexahedronID)i;
-        // adding vertex i in the vertex shell
-        for(unsigned int j=0; j<8; ++j)
-            m_hexahedraAroundVertex[ m_hexahedron[i][j]  ].push_back(hexaID);
-    }
+        return m_hexahedron[i][j];
+    }, m_hexahedraAroundVertex);
 }
 
 void HexahedronSetTopologyContainer::createHexahedraAroundEdgeArray ()
@@ -438,16 +280,11 @@ void HexahedronSetTopologyContainer::createHexahedraAroundEdgeArray ()
     if(!hasEdgesInHexahedron())
         createEdgesInHexahedronArray();
 
-    m_hexahedraAroundEdge.resize(getNumberOfEdges());
-    for(size_t i=0; i<getNumberOfHexahedra(); ++i)
+    // adding hexahedron i in the edge shell of its edges
+    topologyarray::buildAroundArray(getInitTaskScheduler(), getNumberOfHexahedra(), 12, getNumberOfEdges(), [&](size_t i, unsigned int j) -> EdgeID
     {
-        HexahedronID hexaID = (HexahedronID)i;
-        // adding edge i in the edge shell
-        for(unsigned int j=0; j<12; ++j)
-        {
-            m_hexahedraAroundEdge[ m_edgesInHexahedron[i][j] ].push_back(hexaID);
-        }
-    }
+        return m_edgesInHexahedron[i][j];
+    }, m_hexahedraAroundEdge);
 }
 
 void HexahedronSetTopologyContainer::createHexahedraAroundQuadArray()
@@ -457,16 +294,11 @@ void HexahedronSetTopologyContainer::createHexahedraAroundQuadArray()
     if(!hasQuadsInHexahedron())
         createQuadsInHexahedronArray();
 
-    m_hexahedraAroundQuad.resize( getNumberOfQuads());
-    for(size_t i=0; i<getNumberOfHexahedra(); ++i)
+    // adding hexahedron i in the quad shell of its quads
+    topologyarray::buildAroundArray(getInitTaskScheduler(), getNumberOfHexahedra(), 6, getNumberOfQuads(), [&](size_t i, unsigned int j) -> QuadID
     {
-        HexahedronID hexaID = (HexahedronID)i;
-        // adding quad i in the edge shell of both points
-        for(unsigned int j=0; j<6; ++j)
-        {
-            m_hexahedraAroundQuad[ m_quadsInHexahedron[i][j] ].push_back(hexaID);
-        }
-    }
+        return m_quadsInHexahedron[i][j];
+    }, m_hexahedraAroundQuad);
 }
 
 const sofa::helper::vector<HexahedronSetTopologyContainer::Hexahedron> &HexahedronSetTopologyContainer::getHexahedronArray()
@@ -488,23 +320,14 @@ core::topology::Topology::HexahedronID HexahedronSetTopologyContainer::getHexahe
         return InvalidID;
     }
 
-    sofa::helper::vector<HexahedronID> set1 = getHexahedraAroundVertex(v1);
-    sofa::helper::vector<HexahedronID> set2 = getHexahedraAroundVertex(v2);
-    sofa::helper::vector<HexahedronID> set3 = getHexahedraAroundVertex(v3);
-    sofa::helper::vector<HexahedronID> set4 = getHexahedraAroundVertex(v4);
-    sofa::helper::vector<HexahedronID> set5 = getHexahedraAroundVertex(v5);
-    sofa::helper::vector<HexahedronID> set6 = getHexahedraAroundVertex(v6);
-    sofa::helper::vector<HexahedronID> set7 = getHexahedraAroundVertex(v7);
-    sofa::helper::vector<HexahedronID> set8 = getHexahedraAroundVertex(v8);
-
-    sort(set1.begin(), set1.end());
-    sort(set2.begin(), set2.end());
-    sort(set3.begin(), set3.end());
-    sort(set4.begin(), set4.end());
-    sort(set5.begin(), set5.end());
-    sort(set6.begin(), set6.end());
-    sort(set7.begin(), set7.end());
-    sort(set8.begin(), set8.end());
+    sofa::helper::vector<HexahedronID> set1 = m_hexahedraAroundVertex.getSortedList(v1);
+    sofa::helper::vector<HexahedronID> set2 = m_hexahedraAroundVertex.getSortedList(v2);
+    sofa::helper::vector<HexahedronID> set3 = m_hexahedraAroundVertex.getSortedList(v3);
+    sofa::helper::vector<HexahedronID> set4 = m_hexahedraAroundVertex.getSortedList(v4);
+    sofa::helper::vector<HexahedronID> set5 = m_hexahedraAroundVertex.getSortedList(v5);
+    sofa::helper::vector<HexahedronID> set6 = m_hexahedraAroundVertex.getSortedList(v6);
+    sofa::helper::vector<HexahedronID> set7 = m_hexahedraAroundVertex.getSortedList(v7);
+    sofa::helper::vector<HexahedronID> set8 = m_hexahedraAroundVertex.getSortedList(v8);
 
     // The destination vector must be large enough to contain the result.
     sofa::helper::vector<HexahedronID> out1(set1.size()+set2.size());
@@ -578,7 +401,7 @@ const sofa::helper::vector< HexahedronSetTopologyContainer::HexahedraAroundVerte
     if(CHECK_TOPOLOGY)
         msg_warning_when(!hasHexahedraAroundVertex()) << "HexahedraAroundVertex shell array is empty.";
 
-    return m_hexahedraAroundVertex;
+    return m_hexahedraAroundVertex.getLists();
 }
 
 const sofa::helper::vector< HexahedronSetTopologyContainer::HexahedraAroundEdge > &HexahedronSetTopologyContainer::getHexahedraAroundEdgeArray()
@@ -688,13 +511,18 @@ const sofa::helper::vector< QuadSetTopologyContainer::QuadsInHexahedron> &Hexahe
 const HexahedronSetTopologyContainer::HexahedraAroundVertex &HexahedronSetTopologyContainer::getHexahedraAroundVertex(PointID id)
 {
     if (id < m_hexahedraAroundVertex.size())
-        return m_hexahedraAroundVertex[id];
+        return m_hexahedraAroundVertex.getLists()[id];
     else if (CHECK_TOPOLOGY)
         msg_error() << "HexahedraAroundVertex array access out of bounds: " << id << " >= " << m_hexahedraAroundVertex.size();
 
     return InvalidSet;
 }
 
+HexahedronSetTopologyContainer::HexahedraAroundVertexRange HexahedronSetTopologyContainer::getHexahedraAroundVertexRange(PointID id) const
+{
+    return m_hexahedraAroundVertex.range(id);
+}
+
 const HexahedronSetTopologyContainer::HexahedraAroundEdge &HexahedronSetTopologyContainer::getHexahedraAroundEdge(EdgeID id)
 {
     if (id < m_hexahedraAroundEdge.size())
@@ -848,7 +676,7 @@ bool HexahedronSetTopologyContainer::checkTopology() const
 		{
 			for (size_t i = 0; i < m_hexahedraAroundVertex.size(); ++i)
 			{
-				const sofa::helper::vector<HexahedronID> &tvs = m_hexahedraAroundVertex[i];
+				const HexahedraAroundVertexRange tvs = m_hexahedraAroundVertex.range(i);
 				for (size_t j = 0; j < tvs.size(); ++j)
 				{
 					bool check_hexa_vertex_shell = (m_hexahedron[tvs[j]][0] == i)
@@ -1075,7 +903,7 @@ const HexahedronSetTopologyContainer::VecHexaID HexahedronSetTopologyContainer::
 
     for(unsigned int i = 0; i<8; ++i) // for each node of the hexahedron
     {
-        HexahedraAroundVertex hexaAV = this->getHexahedraAroundVertex(the_hexa[i]);
+        const HexahedraAroundVertexRange hexaAV = getHexahedraAroundVertexRange(the_hexa[i]);
 
         for (size_t j = 0; j<hexaAV.size(); ++j) // for each hexahedron around the node
         {
@@ -76,6 +76,7 @@ public:
     typedef core::topology::BaseMeshTopology::Hexa				         Hexa;
     typedef core::topology::BaseMeshTopology::SeqHexahedra			      SeqHexahedra;
     typedef core::topology::BaseMeshTopology::HexahedraAroundVertex		HexahedraAroundVertex;
+    typedef CompressedAroundArray<HexahedronID>::Range                  HexahedraAroundVertexRange;
     typedef core::topology::BaseMeshTopology::HexahedraAroundEdge		HexahedraAroundEdge;
     typedef core::topology::BaseMeshTopology::HexahedraAroundQuad		HexahedraAroundQuad;
     typedef core::topology::BaseMeshTopology::EdgesInHexahedron		   EdgesInHexahedron;
@@ -165,6 +166,14 @@ public:
      */
     const HexahedraAroundVertex& getHexahedraAroundVertex(PointID id) override;
 
+    /** \brief Returns the hexahedra around a vertex without copying them, also when the shell array
+     * is stored in compressed form. The range is valid until the topology changes.
+     *
+     * @param id The ID of the vertex.
+     * @return An empty range if the vertex is out of range.
+     */
+    HexahedraAroundVertexRange getHexahedraAroundVertexRange(PointID id) const;
+
 
     /** \brief Get the hexahedra around an edge.
      *
@@ -450,7 +459,7 @@ protected:
     sofa::helper::vector<QuadsInHexahedron> m_quadsInHexahedron;
 
     /// for each vertex provides the set of hexahedra adjacent to that vertex.
-    sofa::helper::vector< HexahedraAroundVertex > m_hexahedraAroundVertex;
+    CompressedAroundArray<HexahedronID> m_hexahedraAroundVertex;
 
     /// for each edge provides the set of hexahedra adjacent to that edge.
     sofa::helper::vector< HexahedraAroundEdge > m_hexahedraAroundEdge;
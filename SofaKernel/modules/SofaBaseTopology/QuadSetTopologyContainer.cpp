@@ -21,6 +21,7 @@
 ******************************************************************************/
 
 #include <SofaBaseTopology/QuadSetTopologyContainer.h>
+#include <SofaBaseTopology/TopologyArrayBuilder.h>
 #include <sofa/core/visual/VisualParams.h>
 
 #include <sofa/core/ObjectFactory.h>
@@ -118,15 +119,11 @@ void QuadSetTopologyContainer::createQuadsAroundVertexArray()
     if (getNbPoints() == 0) // in case only Data have been copied and not going thourgh AddTriangle methods.
         this->setNbPoints(d_initPoints.getValue().size());
 
-    m_quadsAroundVertex.resize(getNbPoints());
-    for (size_t i=0; i<m_quad.size(); ++i)
+    // adding quad i in the quad shell of all points
+    topologyarray::buildAroundArray(getInitTaskScheduler(), m_quad.size(), 4, getNbPoints(), [&](size_t i, unsigned int j) -> PointID
     {
-        // adding quad i in the quad shell of all points
-        for (size_t j=0; j<4; ++j)
-        {
-            m_quadsAroundVertex[ m_quad[i][j] ].push_back((QuadID)i);
-        }
-    }
+        return m_quad[i][j];
+    }, m_quadsAroundVertex);
 }
 
 void QuadSetTopologyContainer::createQuadsAroundEdgeArray()
@@ -166,15 +163,11 @@ void QuadSetTopologyContainer::createQuadsAroundEdgeArray()
         return;
     }
 
-    m_quadsAroundEdge.resize(numEdges);
-    for (size_t i=0; i<numQuads; ++i)
+    // adding quad i in the quad shell of all edges
+    topologyarray::buildAroundArray(getInitTaskScheduler(), numQuads, 4, numEdges, [&](size_t i, unsigned int j) -> EdgeID
     {
-        // adding quad i in the quad shell of all edges
-        for (size_t j=0; j<4; ++j)
-        {
-            m_quadsAroundEdge[ m_edgesInQuad[i][j] ].push_back((QuadID)i);
-        }
-    }
+        return m_edgesInQuad[i][j];
+    }, m_quadsAroundEdge);
 }
 
 void QuadSetTopologyContainer::createEdgeSetArray()
@@ -194,31 +187,15 @@ void QuadSetTopologyContainer::createEdgeSetArray()
             clearQuadsAroundEdge();
     }
 
-    // create a temporary map to find redundant edges
-    std::map<Edge, EdgeID> edgeMap;
     helper::WriteAccessor< Data< sofa::helper::vector<Edge> > > m_edge = d_edge;
     helper::ReadAccessor< Data< sofa::helper::vector<Quad> > > m_quad = d_quad;
 
-    for (size_t i=0; i<m_quad.size(); ++i)
+    // edges are stored with their vertices in lexicographic order
+    topologyarray::buildEdges(getInitTaskScheduler(), m_quad.size(), 4, [&](size_t i, unsigned int j)
     {
         const Quad &t = m_quad[i];
-        for(size_t j=0; j<4; ++j)
-        {
-            const PointID v1 = t[(j+1)%4];
-            const PointID v2 = t[(j+2)%4];
-
-            // sort vertices in lexicographic order
-            const Edge e = ((v1<v2) ? Edge(v1,v2) : Edge(v2,v1));
-
-            if(edgeMap.find(e) == edgeMap.end())
-            {
-                // edge not in edgeMap so create a new one
-                const EdgeID edgeIndex = (EdgeID)edgeMap.size();
-                edgeMap[e] = edgeIndex;
-                m_edge.push_back(e);
-            }
-        }
-    }
+        return Edge(t[(j+1)%4], t[(j+2)%4]);
+    }, false, m_edge, (sofa::helper::vector<EdgesInQuad>*)nullptr);
 }
 
 void QuadSetTopologyContainer::createEdgesInQuadArray()
@@ -242,20 +219,16 @@ void QuadSetTopologyContainer::createEdgesInQuadArray()
     }
 
     const size_t numQuads = getNumberOfQuads();
-    m_edgesInQuad.resize( numQuads );
     helper::ReadAccessor< Data< sofa::helper::vector<Quad> > > m_quad = d_quad;
+    helper::ReadAccessor< Data< sofa::helper::vector<Edge> > > m_edge = d_edge;
 
-    for(size_t i=0; i<numQuads; ++i)
+    const size_t notFound = topologyarray::findEdges(getInitTaskScheduler(), m_edge, numQuads, 4, [&](size_t i, unsigned int j)
     {
         const Quad &t = m_quad[i];
-        // adding edge i in the edge shell of both points
-        for (size_t j=0; j<4; ++j)
-        {
-            EdgeID edgeIndex = getEdgeIndex(t[(j+1)%4],t[(j+2)%4]);
-            assert(edgeIndex != InvalidID);
-            m_edgesInQuad[i][j]=edgeIndex;
-        }
-    }
+        return Edge(t[(j+1)%4], t[(j+2)%4]);
+    }, m_edgesInQuad);
+    assert(notFound == numQuads * 4);
+    SOFA_UNUSED(notFound);
 }
 
 const sofa::helper::vector<QuadSetTopologyContainer::Quad> &QuadSetTopologyContainer::getQuadArray()
@@ -285,15 +258,10 @@ QuadSetTopologyContainer::QuadID QuadSetTopologyContainer::getQuadIndex(PointID
         return InvalidID;
     }
 
-    sofa::helper::vector<QuadID> set1 = getQuadsAroundVertex(v1);
-    sofa::helper::vector<QuadID> set2 = getQuadsAroundVertex(v2);
-    sofa::helper::vector<QuadID> set3 = getQuadsAroundVertex(v3);
-    sofa::helper::vector<QuadID> set4 = getQuadsAroundVertex(v4);
-
-    sort(set1.begin(), set1.end());
-    sort(set2.begin(), set2.end());
-    sort(set3.begin(), set3.end());
-    sort(set4.begin(), set4.end());
+    sofa::helper::vector<QuadID> set1 = m_quadsAroundVertex.getSortedList(v1);
+    sofa::helper::vector<QuadID> set2 = m_quadsAroundVertex.getSortedList(v2);
+    sofa::helper::vector<QuadID> set3 = m_quadsAroundVertex.getSortedList(v3);
+    sofa::helper::vector<QuadID> set4 = m_quadsAroundVertex.getSortedList(v4);
 
     // The destination vector must be large enough to contain the result.
     sofa::helper::vector<QuadID> out1(set1.size()+set2.size());
@@ -338,7 +306,7 @@ const sofa::helper::vector< QuadSetTopologyContainer::QuadsAroundVertex > &QuadS
     if(CHECK_TOPOLOGY)	// this method should only be called when the shell array exists
         msg_warning_when(!hasQuadsAroundVertex()) << "QuadsAroundVertex shell array is empty.";
 
-    return m_quadsAroundVertex;
+    return m_quadsAroundVertex.getLists();
 }
 
 const sofa::helper::vector< QuadSetTopologyContainer::QuadsAroundEdge > &QuadSetTopologyContainer::getQuadsAroundEdgeArray()
@@ -360,13 +328,18 @@ const sofa::helper::vector< QuadSetTopologyContainer::EdgesInQuad> &QuadSetTopol
 const QuadSetTopologyContainer::QuadsAroundVertex& QuadSetTopologyContainer::getQuadsAroundVertex(PointID id)
 {
     if (id < m_quadsAroundVertex.size())
-        return m_quadsAroundVertex[id];
+        return m_quadsAroundVertex.getLists()[id];
     else if (CHECK_TOPOLOGY)
         msg_error() << "QuadsAroundVertex array access out of bounds: " << id << " >= " << m_quadsAroundVertex.size();
 
     return InvalidSet;
 }
 
+QuadSetTopologyContainer::QuadsAroundVertexRange QuadSetTopologyContainer::getQuadsAroundVertexRange(PointID id) const
+{
+    return m_quadsAroundVertex.range(id);
+}
+
 const QuadSetTopologyContainer::QuadsAroundEdge& QuadSetTopologyContainer::getQuadsAroundEdge(EdgeID id)
 {
     if (id < m_quadsAroundEdge.size())
@@ -469,7 +442,7 @@ bool QuadSetTopologyContainer::checkTopology() const
 		{
 			for (size_t i = 0; i < m_quadsAroundVertex.size(); ++i)
 			{
-				const sofa::helper::vector<QuadID> &tvs = m_quadsAroundVertex[i];
+				const QuadsAroundVertexRange tvs = m_quadsAroundVertex.range(i);
 				for (size_t j = 0; j < tvs.size(); ++j)
 				{
 					if ((m_quad[tvs[j]][0] != i)
@@ -659,7 +632,7 @@ const QuadSetTopologyContainer::VecQuadID QuadSetTopologyContainer::getElementAr
 
     for(size_t i = 0; i<4; ++i) // for each node of the Quad
     {
-        QuadsAroundVertex quadAV = this->getQuadsAroundVertex(the_quad[i]);
+        const QuadsAroundVertexRange quadAV = getQuadsAroundVertexRange(the_quad[i]);
 
         for (size_t j = 0; j<quadAV.size(); ++j) // for each Quad around the node
         {
@@ -763,9 +736,6 @@ bool QuadSetTopologyContainer::hasQuadsAroundEdge() const
 
 void QuadSetTopologyContainer::clearQuadsAroundVertex()
 {
-    for(size_t i=0; i<m_quadsAroundVertex.size(); ++i)
-        m_quadsAroundVertex[i].clear();
-
     m_quadsAroundVertex.clear();
 }
 
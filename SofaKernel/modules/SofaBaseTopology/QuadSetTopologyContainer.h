@@ -52,6 +52,7 @@ public:
     typedef BaseMeshTopology::SeqQuads			SeqQuads;
     typedef BaseMeshTopology::EdgesInQuad			EdgesInQuad;
     typedef BaseMeshTopology::QuadsAroundVertex		QuadsAroundVertex;
+    typedef CompressedAroundArray<QuadID>::Range    QuadsAroundVertexRange;
     typedef BaseMeshTopology::QuadsAroundEdge		QuadsAroundEdge;
     typedef sofa::helper::vector<QuadID>                  VecQuadID;
 
@@ -117,6 +118,14 @@ public:
      */
     const QuadsAroundVertex& getQuadsAroundVertex(PointID id) override;
 
+    /** \brief Returns the quads around a vertex without copying them, also when the shell array
+     * is stored in compressed form. The range is valid until the topology changes.
+     *
+     * @param id The ID of the vertex.
+     * @return An empty range if the vertex is out of range.
+     */
+    QuadsAroundVertexRange getQuadsAroundVertexRange(PointID id) const;
+
 
     /** \brief Returns the set of quads adjacent to a given edge.
      *
@@ -314,7 +323,7 @@ protected:
     sofa::helper::vector<EdgesInQuad> m_edgesInQuad;
 
     /// for each vertex provides the set of quads adjacent to that vertex.
-    sofa::helper::vector< QuadsAroundVertex > m_quadsAroundVertex;
+    CompressedAroundArray<QuadID> m_quadsAroundVertex;
 
     /// for each edge provides the set of quads adjacent to that edge.
     sofa::helper::vector< QuadsAroundEdge > m_quadsAroundEdge;
@@ -0,0 +1,183 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2019 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+
+#include <SofaBaseTopology/TopologyArrayBuilder.h>
+#include <sofa/simulation/DefaultTaskScheduler.h>
+#include <sofa/helper/testing/BaseTest.h>
+
+#include <map>
+#include <cstdlib>
+
+using namespace sofa::component::topology;
+using namespace sofa::helper::testing;
+using sofa::core::topology::Topology;
+
+
+class TopologyArrayBuilder_test : public BaseTest
+{
+public:
+    typedef Topology::Edge Edge;
+    typedef sofa::helper::fixed_array<Topology::EdgeID, 3> EdgesInElement;
+
+    // random triangles with many shared edges, large enough to be split between several threads
+    unsigned int nbPoints = 2000;
+    sofa::helper::vector<Topology::Triangle> triangles;
+    // the arrays are built with 4 threads, then in the calling thread
+    std::vector<sofa::simulation::TaskScheduler*> schedulers;
+
+    void SetUp() override
+    {
+        std::srand(42);
+        triangles.resize(60000);
+        for (Topology::Triangle& t : triangles)
+            for (unsigned int k = 0; k < 3; ++k)
+                t[k] = std::rand() % nbPoints;
+
+        sofa::simulation::TaskScheduler* scheduler = sofa::simulation::TaskScheduler::create(sofa::simulation::DefaultTaskScheduler::name());
+        scheduler->init(4);
+        schedulers = { scheduler, nullptr };
+    }
+
+    void TearDown() override
+    {
+        sofa::simulation::TaskScheduler::getInstance()->stop();
+    }
+
+    Edge edgeOf(size_t i, unsigned int j) const
+    {
+        const Topology::Triangle& t = triangles[i];
+        return Edge(t[(j+1)%3], t[(j+2)%3]);
+    }
+};
+
+
+TEST_F(TopologyArrayBuilder_test, buildEdges)
+{
+    // reference numbering by order of first occurrence
+    std::map<Edge, Topology::EdgeID> edgeMap;
+    sofa::helper::vector<Edge> expectedEdges;
+    sofa::helper::vector<EdgesInElement> expectedEdgesIn(triangles.size());
+    for (size_t i = 0; i < triangles.size(); ++i)
+    {
+        for (unsigned int j = 0; j < 3; ++j)
+        {
+            const Edge e = edgeOf(i, j);
+            const Edge key = (e[0] < e[1]) ? e : Edge(e[1], e[0]);
+            if (edgeMap.find(key) == edgeMap.end())
+            {
+                edgeMap[key] = Topology::EdgeID(expectedEdges.size());
+                expectedEdges.push_back(e);
+            }
+            expectedEdgesIn[i][j] = edgeMap[key];
+        }
+    }
+
+    for (sofa::simulation::TaskScheduler* scheduler : schedulers)
+    {
+        sofa::helper::vector<Edge> edges;
+        sofa::helper::vector<EdgesInElement> edgesIn;
+        topologyarray::buildEdges(scheduler, triangles.size(), 3, [&](size_t i, unsigned int j) { return edgeOf(i, j); },
+                                  true, edges, &edgesIn);
+
+        ASSERT_EQ(edges.size(), expectedEdges.size());
+        for (size_t e = 0; e < edges.size(); ++e)
+        {
+            EXPECT_EQ(edges[e][0], expectedEdges[e][0]);
+            EXPECT_EQ(edges[e][1], expectedEdges[e][1]);
+        }
+        ASSERT_EQ(edgesIn.size(), expectedEdgesIn.size());
+        for (size_t i = 0; i < edgesIn.size(); ++i)
+            for (unsigned int j = 0; j < 3; ++j)
+                EXPECT_EQ(edgesIn[i][j], expectedEdgesIn[i][j]);
+
+        // finding the edges again gives the same indices
+        sofa::helper::vector<EdgesInElement> foundEdgesIn;
+        const size_t notFound = topologyarray::findEdges(scheduler, edges, triangles.size(), 3, [&](size_t i, unsigned int j) { return edgeOf(i, j); },
+                                                         foundEdgesIn);
+        EXPECT_EQ(notFound, triangles.size() * 3);
+        for (size_t i = 0; i < foundEdgesIn.size(); ++i)
+            for (unsigned int j = 0; j < 3; ++j)
+                EXPECT_EQ(foundEdgesIn[i][j], expectedEdgesIn[i][j]);
+    }
+}
+
+
+TEST_F(TopologyArrayBuilder_test, buildAroundArray)
+{
+    sofa::helper::vector< sofa::helper::vector<Topology::TriangleID> > expected(nbPoints);
+    for (size_t i = 0; i < triangles.size(); ++i)
+        for (unsigned int j = 0; j < 3; ++j)
+            expected[triangles[i][j]].push_back(Topology::TriangleID(i));
+
+    for (sofa::simulation::TaskScheduler* scheduler : schedulers)
+    {
+        sofa::helper::vector< sofa::helper::vector<Topology::TriangleID> > around;
+        topologyarray::buildAroundArray(scheduler, triangles.size(), 3, nbPoints, [&](size_t i, unsigned int j) -> Topology::PointID
+        {
+            return triangles[i][j];
+        }, around);
+
+        ASSERT_EQ(around.size(), expected.size());
+        for (size_t p = 0; p < around.size(); ++p)
+            EXPECT_EQ(around[p], expected[p]);
+    }
+}
+
+
+TEST_F(TopologyArrayBuilder_test, compressedAroundArray)
+{
+    sofa::helper::vector< sofa::helper::vector<Topology::TriangleID> > expected;
+    topologyarray::buildAroundArray(schedulers[0], triangles.size(), 3, nbPoints, [&](size_t i, unsigned int j) -> Topology::PointID
+    {
+        return triangles[i][j];
+    }, expected);
+
+    CompressedAroundArray<Topology::TriangleID> around;
+    topologyarray::buildAroundArray(schedulers[0], triangles.size(), 3, nbPoints, [&](size_t i, unsigned int j) -> Topology::PointID
+    {
+        return triangles[i][j];
+    }, around);
+
+    ASSERT_TRUE(around.isCompressed());
+    ASSERT_EQ(around.size(), expected.size());
+    for (size_t p = 0; p < around.size(); ++p)
+    {
+        const CompressedAroundArray<Topology::TriangleID>::Range range = around.range(p);
+        ASSERT_EQ(range.size(), expected[p].size());
+        for (size_t k = 0; k < range.size(); ++k)
+            EXPECT_EQ(range[k], expected[p][k]);
+    }
+    EXPECT_TRUE(around.range(nbPoints).empty());
+
+    // reading the lists keeps the compressed form
+    const CompressedAroundArray<Topology::TriangleID>& constAround = around;
+    EXPECT_EQ(constAround.getLists(), expected);
+    EXPECT_EQ(constAround[0], expected[0]);
+    EXPECT_TRUE(around.isCompressed());
+
+    // modifying them releases it
+    around[0].push_back(Topology::TriangleID(triangles.size()));
+    EXPECT_FALSE(around.isCompressed());
+    EXPECT_EQ(around.size(), expected.size());
+    EXPECT_EQ(around.range(0).size(), expected[0].size() + 1);
+    EXPECT_EQ(around.range(1).size(), expected[1].size());
+}
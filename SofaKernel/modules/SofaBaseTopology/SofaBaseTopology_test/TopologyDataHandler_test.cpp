@@ -0,0 +1,191 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2019 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+
+#include <sofa/core/topology/BaseMeshTopology.h>
+#include <SofaBaseTopology/TopologyDataHandler.inl>
+#include <SofaBaseTopology/TopologySubsetDataHandler.inl>
+#include <sofa/helper/testing/BaseTest.h>
+
+#include <algorithm>
+#include <cstdlib>
+
+using namespace sofa::component::topology;
+using namespace sofa::helper::testing;
+using sofa::core::topology::BaseMeshTopology;
+using sofa::core::topology::BaseTopologyData;
+using sofa::core::topology::PointsRemoved;
+using sofa::core::topology::TopologyChange;
+
+typedef sofa::helper::vector<unsigned int> IndexVector;
+
+
+/// Handler of a per-point Data recording the values given to the destroy function
+class PointDataHandler : public TopologyDataHandler<BaseMeshTopology::Point, IndexVector>
+{
+public:
+    PointDataHandler(BaseTopologyData<IndexVector>* data) : TopologyDataHandler<BaseMeshTopology::Point, IndexVector>(data) {}
+
+    void applyDestroyFunction(unsigned int, unsigned int& t) override { destroyed.push_back(t); }
+
+    IndexVector destroyed;
+};
+
+/// Handler of a subset of the points
+class PointSubsetHandler : public TopologySubsetDataHandler<BaseMeshTopology::Point, IndexVector>
+{
+public:
+    PointSubsetHandler(BaseTopologyData<IndexVector>* data) : TopologySubsetDataHandler<BaseMeshTopology::Point, IndexVector>(data) {}
+};
+
+
+class TopologyDataHandler_test : public BaseTest
+{
+public:
+    unsigned int nbPoints = 5000;
+
+    /// Removes the given points from the Data with a single event, as a topology modifier does
+    void removePoints(sofa::core::topology::TopologyHandler& handler, const IndexVector& removed, unsigned int dataSize)
+    {
+        PointsRemoved event(removed);
+        std::list<const TopologyChange*> changes;
+        changes.push_back(&event);
+        handler.ApplyTopologyChanges(changes, dataSize);
+    }
+
+    /// Random distinct point indices, in decreasing order as the topology modifiers send them
+    IndexVector randomPoints(unsigned int nb)
+    {
+        IndexVector all(nbPoints);
+        for (unsigned int i = 0; i < nbPoints; ++i)
+            all[i] = i;
+        std::random_shuffle(all.begin(), all.end(), [](int n) { return std::rand() % n; });
+        IndexVector points;
+        points.assign(all.begin(), all.begin() + nb);
+        std::sort(points.begin(), points.end(), std::greater<unsigned int>());
+        return points;
+    }
+
+    /// Removal of the subset entries, searching the subset for each removed point
+    static void referenceSubsetRemove(IndexVector& data, const IndexVector& index, unsigned int lastElementIndex)
+    {
+        for (unsigned int i = 0; i < index.size(); ++i)
+        {
+            const unsigned int it1 = (unsigned int)(std::find(data.begin(), data.end(), index[i]) - data.begin());
+            const unsigned int it2 = (unsigned int)(std::find(data.begin(), data.end(), lastElementIndex) - data.begin());
+            if (it2 < data.size())
+                data[it2] = index[i];
+            if (it1 < data.size())
+            {
+                data[it1] = data.back();
+                data.pop_back();
+            }
+            --lastElementIndex;
+        }
+    }
+
+    void SetUp() override
+    {
+        std::srand(42);
+    }
+};
+
+
+TEST_F(TopologyDataHandler_test, removeSwapsWithLast)
+{
+    BaseTopologyData<IndexVector> data;
+    PointDataHandler handler(&data);
+
+    // each value is the index of its point
+    IndexVector values(nbPoints);
+    for (unsigned int i = 0; i < nbPoints; ++i)
+        values[i] = i;
+    data.setValue(values);
+
+    const IndexVector removed = randomPoints(300);
+    removePoints(handler, removed, nbPoints);
+
+    IndexVector expected = values;
+    unsigned int last = nbPoints - 1;
+    for (unsigned int i : removed)
+        std::swap(expected[i], expected[last--]);
+    expected.resize(nbPoints - removed.size());
+
+    EXPECT_EQ(data.getValue(), expected);
+    EXPECT_EQ(handler.destroyed, removed);
+}
+
+
+TEST_F(TopologyDataHandler_test, subsetRemove)
+{
+    for (unsigned int subsetSize : { 0u, 1u, 50u, 1000u, 5000u })
+    {
+        BaseTopologyData<IndexVector> data;
+        PointSubsetHandler handler(&data);
+
+        const IndexVector subset = randomPoints(subsetSize);
+        data.setValue(subset);
+
+        const IndexVector removed = randomPoints(200);
+        removePoints(handler, removed, nbPoints);
+
+        IndexVector expected = subset;
+        referenceSubsetRemove(expected, removed, nbPoints - 1);
+        EXPECT_EQ(data.getValue(), expected) << "subset of " << subsetSize << " points";
+    }
+}
+
+
+TEST_F(TopologyDataHandler_test, subsetRemoveLastEntry)
+{
+    BaseTopologyData<IndexVector> data;
+    PointSubsetHandler handler(&data);
+
+    // point 4 is the last entry of the subset, point 6 is the last point of the topology and is renumbered as 4
+    data.setValue({ 1, 6, 4 });
+    removePoints(handler, { 4, 0, 2 }, 7);
+
+    // the renumbered point 4 is then the last point when point 2 is removed
+    EXPECT_EQ(data.getValue(), IndexVector({ 1, 2 }));
+}
+
+
+TEST_F(TopologyDataHandler_test, subsetRemoveWithDuplicates)
+{
+    BaseTopologyData<IndexVector> data;
+    PointSubsetHandler handler(&data);
+
+    IndexVector subset = randomPoints(100);
+    subset.push_back(subset[10]);
+    subset.push_back(nbPoints - 1);
+    subset.push_back(nbPoints - 1);
+    data.setValue(subset);
+
+    IndexVector removed = randomPoints(50);
+    removed.push_back(subset[10]);
+    std::sort(removed.begin(), removed.end(), std::greater<unsigned int>());
+    removed.erase(std::unique(removed.begin(), removed.end()), removed.end());
+    removePoints(handler, removed, nbPoints);
+
+    IndexVector expected = subset;
+    referenceSubsetRemove(expected, removed, nbPoints - 1);
+    EXPECT_EQ(data.getValue(), expected);
+}
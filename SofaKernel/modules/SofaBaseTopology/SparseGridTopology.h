@@ -156,6 +156,8 @@ public:
 
     /// return the type of the i-th cube
     virtual Type getType( int i );
+    /// true if the grid is built from voxels with the marching cubes
+    bool isUsingMC() const { return _usingMC; }
 
     /// return the stiffness coefficient of the i-th cube
     virtual float getStiffnessCoef(int elementIdx);
@@ -21,6 +21,7 @@
 ******************************************************************************/
 
 #include <SofaBaseTopology/TetrahedronSetTopologyContainer.h>
+#include <SofaBaseTopology/TopologyArrayBuilder.h>
 #include <sofa/core/visual/VisualParams.h>
 #include <sofa/core/ObjectFactory.h>
 
@@ -121,32 +122,15 @@ void TetrahedronSetTopologyContainer::createEdgeSetArray()
         clearTetrahedraAroundEdge();
     }
 
-    // create a temporary map to find redundant edges
-    std::map<Edge,EdgeID> edgeMap;
     helper::WriteAccessor< Data< sofa::helper::vector<Edge> > > m_edge = d_edge;
     helper::ReadAccessor< Data< sofa::helper::vector<Tetrahedron> > > m_tetrahedron = d_tetrahedron;
 
-    /// create the m_edge array at the same time than it fills the m_edgesInTetrahedron array
-    for (size_t i = 0; i < m_tetrahedron.size(); ++i)
+    // edges are stored with their vertices in lexicographic order
+    topologyarray::buildEdges(getInitTaskScheduler(), m_tetrahedron.size(), 6, [&](size_t i, unsigned int j)
     {
         const Tetrahedron &t = m_tetrahedron[i];
-        for (EdgeID j=0; j<6; ++j)
-        {
-            const PointID v1 = t[edgesInTetrahedronArray[j][0]];
-            const PointID v2 = t[edgesInTetrahedronArray[j][1]];
-
-            // sort vertices in lexicographic order
-            const Edge e((v1<v2) ? Edge(v1,v2) : Edge(v2,v1));
-
-            if (edgeMap.find(e)==edgeMap.end())
-            {
-                // edge not in edgeMap so create a new one
-                const size_t edgeIndex = edgeMap.size();
-                edgeMap[e] = (EdgeID)edgeIndex;
-                m_edge.push_back(e);
-            }
-        }
-    }
+        return Edge(t[edgesInTetrahedronArray[j][0]], t[edgesInTetrahedronArray[j][1]]);
+    }, false, m_edge, (sofa::helper::vector<EdgesInTetrahedron>*)nullptr);
 }
 
 void TetrahedronSetTopologyContainer::createEdgesInTetrahedronArray()
@@ -165,79 +149,34 @@ void TetrahedronSetTopologyContainer::createEdgesInTetrahedronArray()
     helper::ReadAccessor< Data< sofa::helper::vector<Tetrahedron> > > m_tetrahedron = d_tetrahedron;
     if (hasEdges())
     {
-        /// there are already existing edges : must use an inefficient method. Parse all triangles and find the edge that match each triangle edge
+        /// there are already existing edges : find the edge that match each tetrahedron edge
         const size_t numTetra = getNumberOfTetrahedra();
-        const EdgeID numEdges = (EdgeID)getNumberOfEdges();
         helper::ReadAccessor< Data< sofa::helper::vector<Edge> > > m_edge = d_edge;
 
-        m_edgesInTetrahedron.resize(numTetra);
-        /// create a multi map where the key is a vertex index and the content is the indices of edges adjacent to that vertex.
-        std::multimap<PointID, EdgeID> edgesAroundVertexMap;
-        std::multimap<PointID, EdgeID>::iterator it;
-
-        for (EdgeID edge=0; edge<numEdges; ++edge)  //Todo: check if not better using multimap <PointID ,TriangleID> and for each edge, push each triangle present in both shell
-        {
-            edgesAroundVertexMap.insert(std::pair<PointID, EdgeID> (m_edge[edge][0],edge));
-            edgesAroundVertexMap.insert(std::pair<PointID, EdgeID> (m_edge[edge][1],edge));
-        }
-        for ( size_t i = 0 ; (i < numTetra) && (foundEdge == true) ; ++i )
+        const size_t notFound = topologyarray::findEdges(getInitTaskScheduler(), m_edge, numTetra, 6, [&](size_t i, unsigned int j)
         {
             const Tetrahedron &t = m_tetrahedron[i];
-            // adding edge i in the edge shell of both points
-            for ( EdgeID j = 0 ; (j < 6) && (foundEdge == true) ; ++j )
-            {
+            return Edge(t[edgesInTetrahedronArray[j][0]], t[edgesInTetrahedronArray[j][1]]);
+        }, m_edgesInTetrahedron);
 
-                //finding edge i in edge array
-                std::pair<std::multimap<PointID, EdgeID>::iterator, std::multimap<PointID, EdgeID>::iterator > itPair=edgesAroundVertexMap.equal_range(t[edgesInTetrahedronArray[j][0]]);
-
-                foundEdge=false;
-                for(it=itPair.first; (it!=itPair.second) && (foundEdge==false); ++it)
-                {
-                    EdgeID edge = (*it).second;
-                    if ( (m_edge[edge][0] == t[edgesInTetrahedronArray[j][0]] && m_edge[edge][1] == t[edgesInTetrahedronArray[j][1]]) || (m_edge[edge][0] == t[edgesInTetrahedronArray[j][1]] && m_edge[edge][1] == t[edgesInTetrahedronArray[j][0]]))
-                    {
-                        m_edgesInTetrahedron[i][j] = edge;
-                        foundEdge=true;
-                    }
-                }
-                if (CHECK_TOPOLOGY)
-                    msg_warning_when(!foundEdge) << " In getTetrahedronArray, cannot find edge for tetrahedron " << i << "and edge "<< j;
-            }
+        if (notFound < numTetra * 6)
+        {
+            foundEdge = false;
+            if (CHECK_TOPOLOGY)
+                msg_warning() << " In getTetrahedronArray, cannot find edge for tetrahedron " << notFound / 6 << "and edge "<< notFound % 6;
         }
     }
 
     if(!hasEdges() || foundEdge == false) // To optimize, this method should be called without creating edgesArray before.
     {
-        /// create edge array and triangle edge array at the same time
-        const size_t numTetra = getNumberOfTetrahedra();
-        m_edgesInTetrahedron.resize (numTetra);
-
-        // create a temporary map to find redundant edges
-        std::map<Edge,EdgeID> edgeMap;
+        /// create the m_edge array at the same time than it fills the m_edgesInTetrahedron array
         helper::WriteAccessor< Data< sofa::helper::vector<Edge> > > m_edge = d_edge;
 
-        /// create the m_edge array at the same time than it fills the m_edgesInTetrahedron array
-        for (size_t i = 0; i < m_tetrahedron.size(); ++i)
+        topologyarray::buildEdges(getInitTaskScheduler(), m_tetrahedron.size(), 6, [&](size_t i, unsigned int j)
         {
             const Tetrahedron &t = m_tetrahedron[i];
-            for (EdgeID j=0; j<6; ++j)
-            {
-                const PointID v1 = t[edgesInTetrahedronArray[j][0]];
-                const PointID v2 = t[edgesInTetrahedronArray[j][1]];
-
-                // sort vertices in lexicographic order
-                const Edge e((v1<v2) ? Edge(v1,v2) : Edge(v2,v1));
-
-                if (edgeMap.find(e)==edgeMap.end())
-                {
-                    // edge not in edgeMap so create a new one
-                    const size_t edgeIndex = edgeMap.size();
-                    edgeMap[e] = (EdgeID)edgeIndex;
-                    m_edge.push_back(e);
-                }
-                m_edgesInTetrahedron[i][j] = edgeMap[e];
-            }
-        }
+            return Edge(t[edgesInTetrahedronArray[j][0]], t[edgesInTetrahedronArray[j][1]]);
+        }, false, m_edge, &m_edgesInTetrahedron);
     }
 
 }
@@ -255,49 +194,66 @@ void TetrahedronSetTopologyContainer::createTriangleSetArray()
         clearTetrahedraAroundTriangle();
     }
 
-    // create a temporary map to find redundant triangles
-    std::map<Triangle,TriangleID> triangleMap;
     helper::WriteAccessor< Data< sofa::helper::vector<Triangle> > > m_triangle = d_triangle;
     helper::ReadAccessor< Data< sofa::helper::vector<Tetrahedron> > > m_tetrahedron = d_tetrahedron;
 
-    /// create the m_edge array at the same time than it fills the m_edgesInTetrahedron array
-    for (size_t i=0; i<m_tetrahedron.size(); ++i)
+    // triangle j of tetrahedron i, rotated such that its first vertex is the smallest one
+    auto orientedTriangle = [&](size_t i, unsigned int j)
     {
         const Tetrahedron &t = m_tetrahedron[i];
+        PointID v[3];
+        for (PointID k=0; k<3; ++k)
+            v[k] = t[sofa::core::topology::trianglesOrientationInTetrahedronArray[j][k]];
 
-        for (TriangleID j=0; j<4; ++j)
+        while ((v[0]>v[1]) || (v[0]>v[2]))
         {
-            PointID v[3];
-            for (PointID k=0; k<3; ++k)
-                v[k] = t[sofa::core::topology::trianglesOrientationInTetrahedronArray[j][k]];
+            PointID val=v[0];
+            v[0]=v[1];
+            v[1]=v[2];
+            v[2]=val;
+        }
+        return Triangle(v[0], v[1], v[2]);
+    };
 
-            // sort v such that v[0] is the smallest one
-            while ((v[0]>v[1]) || (v[0]>v[2]))
+    // triangles with the same vertices are the same, whatever their orientation
+    const size_t nbOccurrences = m_tetrahedron.size() * 4;
+    helper::vector<TriangleID> ids, firstOccurrence;
+    topologyarray::buildUniqueIds<3>(getInitTaskScheduler(), nbOccurrences, [&](size_t occurrence, PointID* v)
+    {
+        const Triangle tr = orientedTriangle(occurrence / 4, occurrence % 4);
+        v[0] = tr[0];
+        v[1] = std::min(tr[1], tr[2]);
+        v[2] = std::max(tr[1], tr[2]);
+    }, ids, firstOccurrence);
+
+    // the first occurrence gives the orientation of the triangle
+    const size_t offset = m_triangle.size();
+    m_triangle.resize(offset + firstOccurrence.size());
+    std::vector<char> duplicate(nbOccurrences, 0);
+    topologyarray::forEachRange(getInitTaskScheduler(), 0, nbOccurrences, [&](size_t first, size_t last)
+    {
+        for (size_t occurrence = first; occurrence < last; ++occurrence)
+        {
+            const TriangleID id = ids[occurrence];
+            const Triangle tr = orientedTriangle(occurrence / 4, occurrence % 4);
+            if (firstOccurrence[id] == occurrence)
             {
-                PointID val=v[0];
-                v[0]=v[1];
-                v[1]=v[2];
-                v[2]=val;
+                m_triangle[offset + id] = tr;
             }
-
-            // check if a triangle with an opposite orientation already exists
-            Triangle tr = Triangle(v[0], v[2], v[1]);
-
-            if (triangleMap.find(tr) == triangleMap.end())
+            else
             {
-                // triangle not in triangleMap so create a new one
-                tr = Triangle(v[0], v[1], v[2]);
-                if (triangleMap.find(tr) == triangleMap.end())
-                {
-                    triangleMap[tr] = (TriangleID)m_triangle.size();
-                    m_triangle.push_back(tr);
-                }
-                else
-                {
-					msg_error() << "Duplicate triangle " << tr << " in tetra " << i <<" : " << t;
-                }
+                // same vertices with the same orientation
+                const Triangle first = orientedTriangle(firstOccurrence[id] / 4, firstOccurrence[id] % 4);
+                if (tr[1] == first[1] && tr[2] == first[2])
+                    duplicate[occurrence] = 1;
             }
         }
+    }, 1024);
+
+    for (size_t occurrence = 0; occurrence < nbOccurrences; ++occurrence)
+    {
+        if (duplicate[occurrence])
+            msg_error() << "Duplicate triangle " << orientedTriangle(occurrence / 4, occurrence % 4) << " in tetra " << occurrence / 4 <<" : " << m_tetrahedron[occurrence / 4];
     }
 }
 
@@ -312,8 +268,29 @@ void TetrahedronSetTopologyContainer::createTrianglesInTetrahedronArray()
     if(hasTrianglesInTetrahedron()) // created by upper topology
         return;
 
-    m_trianglesInTetrahedron.resize( getNumberOfTetrahedra());
     helper::ReadAccessor< Data< sofa::helper::vector<Tetrahedron> > > m_tetrahedron = d_tetrahedron;
+    helper::ReadAccessor< Data< sofa::helper::vector<Triangle> > > m_triangle = d_triangle;
+
+    // triangles are found from their vertices, whatever their orientation
+    auto sortedVertices = [](PointID a, PointID b, PointID c, PointID* v)
+    {
+        v[0] = a; v[1] = b; v[2] = c;
+        std::sort(v, v + 3);
+    };
+
+    helper::vector<TriangleID> ids;
+    topologyarray::findIds<3>(getInitTaskScheduler(), m_triangle.size(), [&](size_t i, PointID* v)
+    {
+        const Triangle &tr = m_triangle[i];
+        sortedVertices(tr[0], tr[1], tr[2], v);
+    }, m_tetrahedron.size() * 4, [&](size_t occurrence, PointID* v)
+    {
+        const Tetrahedron &t = m_tetrahedron[occurrence / 4];
+        const unsigned int j = occurrence % 4;
+        sortedVertices(t[(j+1)%4], t[(j+2)%4], t[(j+3)%4], v);
+    }, ids);
+
+    m_trianglesInTetrahedron.resize( getNumberOfTetrahedra());
     for(size_t i = 0; i < m_tetrahedron.size(); ++i)
     {
         const Tetrahedron &t=m_tetrahedron[i];
@@ -321,7 +298,7 @@ void TetrahedronSetTopologyContainer::createTrianglesInTetrahedronArray()
         // adding triangles in the triangle list of the ith tetrahedron  i
         for (TriangleID j=0; j<4; ++j)
         {
-            TriangleID triangleIndex = getTriangleIndex(t[(j+1)%4], t[(j+2)%4], t[(j+3)%4]);
+            TriangleID triangleIndex = ids[i * 4 + j];
             if (triangleIndex != InvalidID){
                    m_trianglesInTetrahedron[i][j] = triangleIndex;
             }
@@ -347,17 +324,13 @@ void TetrahedronSetTopologyContainer::createTetrahedraAroundVertexArray()
     if (getNbPoints() == 0) // in case only Data have been copied and not going thourgh AddTriangle methods.
         this->setNbPoints(d_initPoints.getValue().size());
 
-    m_tetrahedraAroundVertex.resize( getNbPoints() );
     helper::ReadAccessor< Data< sofa::helper::vector<Tetrahedron> > > m_tetrahedron = d_tetrahedron;
 
-    for (size_t i = 0; i < getNumberOfTetrahedra(); ++i)
+    // adding tetrahedron i in the shell of its points
+    topologyarray::buildAroundArray(getInitTaskScheduler(), m_tetrahedron.size(), 4, getNbPoints(), [&](size_t i, unsigned int j) -> PointID
     {
-        // adding edge i in the edge shell of both points
-        for (PointID j=0; j<4; ++j)
-        {
-            m_tetrahedraAroundVertex[ m_tetrahedron[i][j]  ].push_back( (TetrahedronID)i );
-        }
-    }
+        return m_tetrahedron[i][j];
+    }, m_tetrahedraAroundVertex);
 }
 
 void TetrahedronSetTopologyContainer::createTetrahedraAroundEdgeArray ()
@@ -368,15 +341,11 @@ void TetrahedronSetTopologyContainer::createTetrahedraAroundEdgeArray ()
     if(!hasEdgesInTetrahedron())
         createEdgesInTetrahedronArray();
 
-    m_tetrahedraAroundEdge.resize(getNumberOfEdges());
-    for (size_t i=0; i< getNumberOfTetrahedra(); ++i)
+    // adding tetrahedron i in the shell of its edges
+    topologyarray::buildAroundArray(getInitTaskScheduler(), getNumberOfTetrahedra(), 6, getNumberOfEdges(), [&](size_t i, unsigned int j) -> EdgeID
     {
-        // adding edge i in the edge shell of both points
-        for (EdgeID j=0; j<6; ++j)
-        {
-            m_tetrahedraAroundEdge[ m_edgesInTetrahedron[i][j] ].push_back( (TetrahedronID)i );
-        }
-    }
+        return m_edgesInTetrahedron[i][j];
+    }, m_tetrahedraAroundEdge);
 }
 
 void TetrahedronSetTopologyContainer::createTetrahedraAroundTriangleArray ()
@@ -417,16 +386,11 @@ void TetrahedronSetTopologyContainer::createTetrahedraAroundTriangleArray ()
         return;
     }
 
-    m_tetrahedraAroundTriangle.resize(numTriangles);
-
-    for (size_t i=0; i<numTetra; ++i)
+    // adding tetrahedron i in the shell of all neighbors triangles
+    topologyarray::buildAroundArray(getInitTaskScheduler(), numTetra, 4, numTriangles, [&](size_t i, unsigned int j) -> TriangleID
     {
-        // adding tetrahedron i in the shell of all neighbors triangles
-        for (TriangleID j=0; j<4; ++j)
-        {
-            m_tetrahedraAroundTriangle[ m_trianglesInTetrahedron[i][j] ].push_back( (TetrahedronID)i );
-        }
-    }
+        return m_trianglesInTetrahedron[i][j];
+    }, m_tetrahedraAroundTriangle);
 }
 
 const sofa::helper::vector<TetrahedronSetTopologyContainer::Tetrahedron> &TetrahedronSetTopologyContainer::getTetrahedronArray()
@@ -458,15 +422,10 @@ TetrahedronSetTopologyContainer::TetrahedronID TetrahedronSetTopologyContainer::
         return InvalidID;
     }
 
-    sofa::helper::vector<TetrahedronID> set1 = getTetrahedraAroundVertex(v1);
-    sofa::helper::vector<TetrahedronID> set2 = getTetrahedraAroundVertex(v2);
-    sofa::helper::vector<TetrahedronID> set3 = getTetrahedraAroundVertex(v3);
-    sofa::helper::vector<TetrahedronID> set4 = getTetrahedraAroundVertex(v4);
-
-    sort(set1.begin(), set1.end());
-    sort(set2.begin(), set2.end());
-    sort(set3.begin(), set3.end());
-    sort(set4.begin(), set4.end());
+    sofa::helper::vector<TetrahedronID> set1 = m_tetrahedraAroundVertex.getSortedList(v1);
+    sofa::helper::vector<TetrahedronID> set2 = m_tetrahedraAroundVertex.getSortedList(v2);
+    sofa::helper::vector<TetrahedronID> set3 = m_tetrahedraAroundVertex.getSortedList(v3);
+    sofa::helper::vector<TetrahedronID> set4 = m_tetrahedraAroundVertex.getSortedList(v4);
 
     // The destination vector must be large enough to contain the result.
     sofa::helper::vector<TetrahedronID> out1(set1.size()+set2.size());
@@ -511,7 +470,7 @@ const sofa::helper::vector< TetrahedronSetTopologyContainer::TetrahedraAroundVer
     if (CHECK_TOPOLOGY)
         msg_warning_when(!hasTetrahedraAroundVertex()) << "TetrahedraAroundVertex shell array is empty.";
 
-    return m_tetrahedraAroundVertex;
+    return m_tetrahedraAroundVertex.getLists();
 }
 
 const sofa::helper::vector< TetrahedronSetTopologyContainer::TetrahedraAroundEdge > &TetrahedronSetTopologyContainer::getTetrahedraAroundEdgeArray()
@@ -563,13 +522,18 @@ const sofa::helper::vector< TetrahedronSetTopologyContainer::TrianglesInTetrahed
 const TetrahedronSetTopologyContainer::TetrahedraAroundVertex &TetrahedronSetTopologyContainer::getTetrahedraAroundVertex(const PointID id)
 {
     if (id < m_tetrahedraAroundVertex.size())
-        return m_tetrahedraAroundVertex[id];
+        return m_tetrahedraAroundVertex.getLists()[id];
     else if (CHECK_TOPOLOGY)
         msg_error() << "TetrahedraAroundVertexArray array access out of bounds: " << id << " >= " << m_tetrahedraAroundVertex.size();
 
     return InvalidSet;
 }
 
+TetrahedronSetTopologyContainer::TetrahedraAroundVertexRange TetrahedronSetTopologyContainer::getTetrahedraAroundVertexRange(PointID id) const
+{
+    return m_tetrahedraAroundVertex.range(id);
+}
+
 const TetrahedronSetTopologyContainer::TetrahedraAroundEdge &TetrahedronSetTopologyContainer::getTetrahedraAroundEdge(const EdgeID id)
 {
     if (id < m_tetrahedraAroundEdge.size())
@@ -702,7 +666,7 @@ bool TetrahedronSetTopologyContainer::checkTopology() const
             std::set <int> tetrahedronSet;
             for (size_t i = 0; i < m_tetrahedraAroundVertex.size(); ++i)
             {
-                const sofa::helper::vector<TetrahedronID> &tvs = m_tetrahedraAroundVertex[i];
+                const TetrahedraAroundVertexRange tvs = m_tetrahedraAroundVertex.range(i);
                 for (size_t j = 0; j < tvs.size(); ++j)
                 {
                     const Tetrahedron& tetrahedron = m_tetrahedron[tvs[j]];
@@ -1010,7 +974,7 @@ const TetrahedronSetTopologyContainer::VecTetraID TetrahedronSetTopologyContaine
 
     for(PointID i = 0; i<4; ++i) // for each node of the tetra
     {
-        TetrahedraAroundVertex tetraAV = this->getTetrahedraAroundVertex(the_tetra[i]);
+        const TetrahedraAroundVertexRange tetraAV = getTetrahedraAroundVertexRange(the_tetra[i]);
 
         for (size_t j = 0; j<tetraAV.size(); ++j) // for each tetra around the node
         {
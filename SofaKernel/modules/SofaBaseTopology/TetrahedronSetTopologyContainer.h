@@ -56,6 +56,7 @@ public:
     typedef core::topology::BaseMeshTopology::Tetra                       Tetra;
     typedef core::topology::BaseMeshTopology::SeqTetrahedra               SeqTetrahedra;
     typedef core::topology::BaseMeshTopology::TetrahedraAroundVertex      TetrahedraAroundVertex;
+    typedef CompressedAroundArray<TetrahedronID>::Range                   TetrahedraAroundVertexRange;
     typedef core::topology::BaseMeshTopology::TetrahedraAroundEdge        TetrahedraAroundEdge;
     typedef core::topology::BaseMeshTopology::TetrahedraAroundTriangle    TetrahedraAroundTriangle;
     typedef core::topology::BaseMeshTopology::EdgesInTetrahedron          EdgesInTetrahedron;
@@ -139,6 +140,14 @@ public:
      */
     const TetrahedraAroundVertex& getTetrahedraAroundVertex(PointID id) override;
 
+    /** \brief Returns the tetrahedra around a vertex without copying them, also when the shell array
+     * is stored in compressed form. The range is valid until the topology changes.
+     *
+     * @param id The ID of the vertex.
+     * @return An empty range if the vertex is out of range.
+     */
+    TetrahedraAroundVertexRange getTetrahedraAroundVertexRange(PointID id) const;
+
 
     /** \brief Returns the set of tetrahedra adjacent to a given edge.
      *
@@ -482,7 +491,7 @@ protected:
     sofa::helper::vector<TrianglesInTetrahedron> m_trianglesInTetrahedron;
 
     /// for each vertex provides the set of tetrahedra adjacent to that vertex.
-    sofa::helper::vector< TetrahedraAroundVertex > m_tetrahedraAroundVertex;
+    CompressedAroundArray<TetrahedronID> m_tetrahedraAroundVertex;
 
     /// for each edge provides the set of tetrahedra adjacent to that edge.
     sofa::helper::vector< TetrahedraAroundEdge > m_tetrahedraAroundEdge;
@@ -0,0 +1,469 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2019 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#ifndef SOFA_COMPONENT_TOPOLOGY_TOPOLOGYARRAYBUILDER_H
+#define SOFA_COMPONENT_TOPOLOGY_TOPOLOGYARRAYBUILDER_H
+#include "config.h"
+
+#include <SofaBaseTopology/CompressedAroundArray.h>
+#include <sofa/core/topology/Topology.h>
+#include <sofa/simulation/ParallelForEach.h>
+#include <sofa/helper/vector.h>
+
+#include <algorithm>
+#include <vector>
+
+namespace sofa
+{
+
+namespace component
+{
+
+namespace topology
+{
+
+/** Helpers building the topology arrays (sub-elements, elements in / around another element)
+ *  by sorting instead of std::map / std::multimap lookups.
+ *  The work is split over the tasks of the given TaskScheduler, or done in the calling thread when
+ *  no scheduler is given. The results do not depend on the number of threads: they are the same as
+ *  the ones of the sequential insertion loops (sub-elements numbered by order of first occurrence,
+ *  "around" lists in increasing order).
+ */
+namespace topologyarray
+{
+
+typedef core::topology::Topology::index_type index_type;
+
+/// Occurrence of a sub-element (edge, triangle, quad) given by N vertices in a canonical order
+template<unsigned int N>
+struct Key
+{
+    index_type vertices[N];
+    index_type occurrence;
+
+    bool operator!=(const Key& other) const
+    {
+        for (unsigned int i = 0; i < N; ++i)
+            if (vertices[i] != other.vertices[i]) return true;
+        return false;
+    }
+};
+
+/// number of chunks used to split n items over the threads of the scheduler, 1 without scheduler
+inline std::size_t chunkCount(simulation::TaskScheduler* scheduler, const std::size_t n)
+{
+    if (!scheduler) return 1;
+    const std::size_t minChunkSize = 4096;
+    return std::max<std::size_t>(1, std::min<std::size_t>(scheduler->getThreadCount() * 4, n / minChunkSize));
+}
+
+/// function(i) for each i in [first, last), from the tasks of the scheduler if there is one
+template<class Function>
+void forEach(simulation::TaskScheduler* scheduler, const std::size_t first, const std::size_t last, const Function& function)
+{
+    if (scheduler)
+        simulation::parallelForEach(*scheduler, first, last, function);
+    else
+        for (std::size_t i = first; i < last; ++i) function(i);
+}
+
+/// function(chunkFirst, chunkLast) on chunks of [first, last), from the tasks of the scheduler if there is one
+template<class Function>
+void forEachRange(simulation::TaskScheduler* scheduler, const std::size_t first, const std::size_t last, const Function& function, const std::size_t grainSize)
+{
+    if (scheduler)
+        simulation::parallelForEachRange(*scheduler, first, last, function, grainSize);
+    else if (first < last)
+        function(first, last);
+}
+
+/// Stable LSD radix sort of the keys by lexicographic order of their vertices.
+/// Bytes which are the same for all the keys are skipped.
+template<unsigned int N>
+void sortKeys(simulation::TaskScheduler* scheduler, std::vector< Key<N> >& keys)
+{
+    const std::size_t n = keys.size();
+    if (n < 2) return;
+
+    const std::size_t nbChunks = chunkCount(scheduler, n);
+    const std::size_t chunkSize = (n + nbChunks - 1) / nbChunks;
+
+    // bits which differ among the keys
+    std::vector< index_type > chunkAnd(nbChunks * N, index_type(~0u)), chunkOr(nbChunks * N, 0);
+    forEach(scheduler, 0, nbChunks, [&](const std::size_t c)
+    {
+        for (std::size_t i = c * chunkSize, end = std::min(n, (c + 1) * chunkSize); i < end; ++i)
+        {
+            for (unsigned int w = 0; w < N; ++w)
+            {
+                chunkAnd[c * N + w] &= keys[i].vertices[w];
+                chunkOr[c * N + w] |= keys[i].vertices[w];
+            }
+        }
+    });
+
+    index_type varying[N];
+    for (unsigned int w = 0; w < N; ++w)
+    {
+        index_type a = index_type(~0u), o = 0;
+        for (std::size_t c = 0; c < nbChunks; ++c)
+        {
+            a &= chunkAnd[c * N + w];
+            o |= chunkOr[c * N + w];
+        }
+        varying[w] = a ^ o;
+    }
+
+    std::vector< Key<N> > buffer(n);
+    std::vector< std::size_t > offsets(nbChunks * 256);
+
+    for (int w = N - 1; w >= 0; --w)
+    {
+        for (unsigned int shift = 0; shift < 8 * sizeof(index_type); shift += 8)
+        {
+            if (((varying[w] >> shift) & 0xff) == 0) continue;
+
+            std::fill(offsets.begin(), offsets.end(), 0);
+            forEach(scheduler, 0, nbChunks, [&](const std::size_t c)
+            {
+                std::size_t* count = &offsets[c * 256];
+                for (std::size_t i = c * chunkSize, end = std::min(n, (c + 1) * chunkSize); i < end; ++i)
+                    ++count[(keys[i].vertices[w] >> shift) & 0xff];
+            });
+
+            // digits first, then chunks, for stability
+            std::size_t offset = 0;
+            for (unsigned int d = 0; d < 256; ++d)
+            {
+                for (std::size_t c = 0; c < nbChunks; ++c)
+                {
+                    const std::size_t count = offsets[c * 256 + d];
+                    offsets[c * 256 + d] = offset;
+                    offset += count;
+                }
+            }
+
+            forEach(scheduler, 0, nbChunks, [&](const std::size_t c)
+            {
+                std::size_t* offset = &offsets[c * 256];
+                for (std::size_t i = c * chunkSize, end = std::min(n, (c + 1) * chunkSize); i < end; ++i)
+                    buffer[offset[(keys[i].vertices[w] >> shift) & 0xff]++] = keys[i];
+            });
+
+            keys.swap(buffer);
+        }
+    }
+}
+
+/// Exclusive prefix sum of values, returns the total
+template<class T>
+T exclusiveScan(simulation::TaskScheduler* scheduler, std::vector<T>& values)
+{
+    const std::size_t n = values.size();
+    const std::size_t nbChunks = chunkCount(scheduler, n);
+    const std::size_t chunkSize = (n + nbChunks - 1) / nbChunks;
+
+    std::vector<T> sums(nbChunks, T(0));
+    forEach(scheduler, 0, nbChunks, [&](const std::size_t c)
+    {
+        for (std::size_t i = c * chunkSize, end = std::min(n, (c + 1) * chunkSize); i < end; ++i)
+            sums[c] += values[i];
+    });
+
+    T total = T(0);
+    for (std::size_t c = 0; c < nbChunks; ++c)
+    {
+        const T sum = sums[c];
+        sums[c] = total;
+        total += sum;
+    }
+
+    forEach(scheduler, 0, nbChunks, [&](const std::size_t c)
+    {
+        T sum = sums[c];
+        for (std::size_t i = c * chunkSize, end = std::min(n, (c + 1) * chunkSize); i < end; ++i)
+        {
+            const T value = values[i];
+            values[i] = sum;
+            sum += value;
+        }
+    });
+
+    return total;
+}
+
+/** Numbers the distinct sub-elements among nbOccurrences occurrences, by order of first occurrence.
+ *  key(i, vertices) fills the N canonical vertices of occurrence i.
+ *  On return, ids[i] is the index of the sub-element of occurrence i, and firstOccurrence[id] is the
+ *  first occurrence of sub-element id.
+ */
+template<unsigned int N, class KeyFunction>
+void buildUniqueIds(simulation::TaskScheduler* scheduler, const std::size_t nbOccurrences, const KeyFunction& key,
+                    helper::vector<index_type>& ids, helper::vector<index_type>& firstOccurrence)
+{
+    const std::size_t n = nbOccurrences;
+
+    std::vector< Key<N> > keys(n);
+    forEachRange(scheduler, 0, n, [&](const std::size_t first, const std::size_t last)
+    {
+        for (std::size_t i = first; i < last; ++i)
+        {
+            key(i, keys[i].vertices);
+            keys[i].occurrence = index_type(i);
+        }
+    }, 1024);
+
+    sortKeys(scheduler, keys);
+
+    // the first occurrence of a sub-element is the head of its group of equal keys (stable sort)
+    std::vector<index_type> newId(n, 0);
+    forEachRange(scheduler, 0, n, [&](const std::size_t first, const std::size_t last)
+    {
+        for (std::size_t p = first; p < last; ++p)
+            if (p == 0 || keys[p] != keys[p - 1]) newId[keys[p].occurrence] = 1;
+    }, 1024);
+
+    const index_type nbIds = exclusiveScan(scheduler, newId);
+
+    firstOccurrence.resize(nbIds);
+    ids.resize(n);
+    forEachRange(scheduler, 0, n, [&](const std::size_t first, const std::size_t last)
+    {
+        // start from the head of the group containing the first position
+        std::size_t head = first;
+        while (head > 0 && !(keys[head] != keys[head - 1])) --head;
+
+        index_type id = newId[keys[head].occurrence];
+        for (std::size_t p = first; p < last; ++p)
+        {
+            if (p > head && keys[p] != keys[p - 1])
+            {
+                head = p;
+                id = newId[keys[p].occurrence];
+            }
+            if (p == head) firstOccurrence[id] = keys[p].occurrence;
+            ids[keys[p].occurrence] = id;
+        }
+    }, 1024);
+}
+
+/** Finds nbQueries sub-elements among nbElements existing ones, comparing their canonical vertices.
+ *  elementKey(i, vertices) and queryKey(i, vertices) fill the N canonical vertices of an existing
+ *  sub-element and of a query. ids[q] receives the first existing sub-element matching query q, or InvalidID.
+ */
+template<unsigned int N, class ElementKeyFunction, class QueryKeyFunction>
+void findIds(simulation::TaskScheduler* scheduler, const std::size_t nbElements, const ElementKeyFunction& elementKey,
+             const std::size_t nbQueries, const QueryKeyFunction& queryKey,
+             helper::vector<index_type>& ids)
+{
+    helper::vector<index_type> allIds, firstOccurrence;
+    buildUniqueIds<N>(scheduler, nbElements + nbQueries, [&](const std::size_t i, index_type* vertices)
+    {
+        if (i < nbElements) elementKey(i, vertices);
+        else queryKey(i - nbElements, vertices);
+    }, allIds, firstOccurrence);
+
+    ids.resize(nbQueries);
+    forEachRange(scheduler, 0, nbQueries, [&](const std::size_t first, const std::size_t last)
+    {
+        for (std::size_t q = first; q < last; ++q)
+        {
+            const index_type element = firstOccurrence[allIds[nbElements + q]];
+            ids[q] = (element < nbElements) ? element : index_type(core::topology::Topology::InvalidID);
+        }
+    }, 1024);
+}
+
+/** Appends to edges the distinct edges of nbElements elements having nbEdgesPerElement edges each,
+ *  edgeVertices(e, j) returning edge j of element e. Edges are numbered by order of first occurrence
+ *  and stored either as returned by edgeVertices (keepOrientation) or with sorted vertices.
+ *  If edgesInElement is given, it receives the indices of the edges of each element.
+ */
+template<class EdgeArray, class EdgesInElementArray, class EdgeFunction>
+void buildEdges(simulation::TaskScheduler* scheduler, const std::size_t nbElements, const unsigned int nbEdgesPerElement, const EdgeFunction& edgeVertices,
+                const bool keepOrientation, EdgeArray& edges, EdgesInElementArray* edgesInElement)
+{
+    typedef core::topology::Topology::Edge Edge;
+
+    helper::vector<index_type> ids, firstOccurrence;
+    buildUniqueIds<2>(scheduler, nbElements * nbEdgesPerElement, [&](const std::size_t i, index_type* vertices)
+    {
+        const Edge e = edgeVertices(i / nbEdgesPerElement, i % nbEdgesPerElement);
+        vertices[0] = std::min(e[0], e[1]);
+        vertices[1] = std::max(e[0], e[1]);
+    }, ids, firstOccurrence);
+
+    const std::size_t offset = edges.size();
+    edges.resize(offset + firstOccurrence.size());
+    forEachRange(scheduler, 0, firstOccurrence.size(), [&](const std::size_t first, const std::size_t last)
+    {
+        for (std::size_t id = first; id < last; ++id)
+        {
+            const Edge e = edgeVertices(firstOccurrence[id] / nbEdgesPerElement, firstOccurrence[id] % nbEdgesPerElement);
+            edges[offset + id] = (keepOrientation || e[0] < e[1]) ? e : Edge(e[1], e[0]);
+        }
+    }, 1024);
+
+    if (edgesInElement)
+    {
+        edgesInElement->resize(nbElements);
+        forEachRange(scheduler, 0, nbElements, [&](const std::size_t first, const std::size_t last)
+        {
+            for (std::size_t e = first; e < last; ++e)
+                for (unsigned int j = 0; j < nbEdgesPerElement; ++j)
+                    (*edgesInElement)[e][j] = index_type(offset + ids[e * nbEdgesPerElement + j]);
+        }, 1024);
+    }
+}
+
+/** Finds the edges of nbElements elements among existing edges, edgeVertices(e, j) returning edge j
+ *  of element e, whatever the orientation. edgesInElement receives the indices of the edges of each
+ *  element (InvalidID when not found).
+ *  Returns the first (element * nbEdgesPerElement + j) which is not found, or nbElements * nbEdgesPerElement.
+ */
+template<class EdgeArray, class EdgesInElementArray, class EdgeFunction>
+std::size_t findEdges(simulation::TaskScheduler* scheduler, const EdgeArray& edges, const std::size_t nbElements, const unsigned int nbEdgesPerElement,
+                      const EdgeFunction& edgeVertices, EdgesInElementArray& edgesInElement)
+{
+    typedef core::topology::Topology::Edge Edge;
+
+    helper::vector<index_type> ids;
+    findIds<2>(scheduler, edges.size(), [&](const std::size_t i, index_type* vertices)
+    {
+        const Edge& e = edges[i];
+        vertices[0] = std::min(e[0], e[1]);
+        vertices[1] = std::max(e[0], e[1]);
+    }, nbElements * nbEdgesPerElement, [&](const std::size_t i, index_type* vertices)
+    {
+        const Edge e = edgeVertices(i / nbEdgesPerElement, i % nbEdgesPerElement);
+        vertices[0] = std::min(e[0], e[1]);
+        vertices[1] = std::max(e[0], e[1]);
+    }, ids);
+
+    edgesInElement.resize(nbElements);
+    std::size_t notFound = ids.size();
+    for (std::size_t i = 0; i < ids.size(); ++i)
+    {
+        edgesInElement[i / nbEdgesPerElement][i % nbEdgesPerElement] = ids[i];
+        if (ids[i] == index_type(core::topology::Topology::InvalidID) && notFound == ids.size())
+            notFound = i;
+    }
+    return notFound;
+}
+
+/** Sorts the references of nbElements elements to nbOwners owners (vertices, edges, ...), each element
+ *  referencing arity owners given by owner(element, k). On return, the elements around owner o are
+ *  keys[begin[o]] to keys[begin[o+1]-1], in increasing order. References to owners out of range are
+ *  at the end of keys, after begin[nbOwners].
+ */
+template<class OwnerFunction>
+void sortOwnerKeys(simulation::TaskScheduler* scheduler, const std::size_t nbElements, const unsigned int arity, const std::size_t nbOwners,
+                   const OwnerFunction& owner, std::vector< Key<1> >& keys, std::vector<std::size_t>& begin)
+{
+    const std::size_t n = nbElements * arity;
+
+    keys.resize(n);
+    forEachRange(scheduler, 0, nbElements, [&](const std::size_t first, const std::size_t last)
+    {
+        for (std::size_t e = first; e < last; ++e)
+        {
+            for (unsigned int k = 0; k < arity; ++k)
+            {
+                Key<1>& key = keys[e * arity + k];
+                key.vertices[0] = owner(e, k);
+                key.occurrence = index_type(e);
+            }
+        }
+    }, 1024);
+
+    sortKeys(scheduler, keys);
+
+    // CSR offsets: begin[o] is the first position of owner o in the sorted keys
+    begin.assign(nbOwners + 1, n);
+    forEachRange(scheduler, 0, n, [&](const std::size_t first, const std::size_t last)
+    {
+        for (std::size_t p = first; p < last; ++p)
+        {
+            const std::size_t o = keys[p].vertices[0];
+            const std::size_t previous = (p == 0) ? std::size_t(0) : std::size_t(keys[p - 1].vertices[0]) + 1;
+            if (p > 0 && o + 1 == previous) continue;
+            for (std::size_t i = previous; i <= std::min(o, nbOwners); ++i)
+                begin[i] = p;
+        }
+    }, 1024);
+}
+
+/** Builds the array of the elements around each of nbOwners owners (vertices, edges, ...).
+ *  Each of the nbElements elements references arity owners given by owner(element, k).
+ *  around[o] lists the elements referencing o in increasing order, once per reference, like a
+ *  push_back loop over the elements does. References to owners out of range are ignored.
+ */
+template<class AroundArray, class OwnerFunction>
+void buildAroundArray(simulation::TaskScheduler* scheduler, const std::size_t nbElements, const unsigned int arity, const std::size_t nbOwners,
+                      const OwnerFunction& owner, AroundArray& around)
+{
+    std::vector< Key<1> > keys;
+    std::vector<std::size_t> begin;
+    sortOwnerKeys(scheduler, nbElements, arity, nbOwners, owner, keys, begin);
+
+    around.clear();
+    around.resize(nbOwners);
+    forEachRange(scheduler, 0, nbOwners, [&](const std::size_t first, const std::size_t last)
+    {
+        for (std::size_t o = first; o < last; ++o)
+        {
+            around[o].resize(begin[o + 1] - begin[o]);
+            for (std::size_t p = begin[o], i = 0; p < begin[o + 1]; ++p, ++i)
+                around[o][i] = keys[p].occurrence;
+        }
+    }, 256);
+}
+
+/// Same as above, the lists being stored in compressed form
+template<class ID, class OwnerFunction>
+void buildAroundArray(simulation::TaskScheduler* scheduler, const std::size_t nbElements, const unsigned int arity, const std::size_t nbOwners,
+                      const OwnerFunction& owner, CompressedAroundArray<ID>& around)
+{
+    std::vector< Key<1> > keys;
+    std::vector<std::size_t> begin;
+    sortOwnerKeys(scheduler, nbElements, arity, nbOwners, owner, keys, begin);
+
+    helper::vector<std::size_t> offsets;
+    offsets.assign(begin.begin(), begin.end());
+    helper::vector<ID> indices(begin.back());
+    forEachRange(scheduler, 0, indices.size(), [&](const std::size_t first, const std::size_t last)
+    {
+        for (std::size_t p = first; p < last; ++p)
+            indices[p] = ID(keys[p].occurrence);
+    }, 4096);
+
+    around.setCompressed(offsets, indices);
+}
+
+} // namespace topologyarray
+
+} // namespace topology
+
+} // namespace component
+
+} // namespace sofa
+
+#endif // SOFA_COMPONENT_TOPOLOGY_TOPOLOGYARRAYBUILDER_H
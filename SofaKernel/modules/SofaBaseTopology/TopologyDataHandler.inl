@@ -23,6 +23,7 @@
 #define SOFA_COMPONENT_TOPOLOGY_TOPOLOGYDATAHANDLER_INL
 
 #include <SofaBaseTopology/TopologyDataHandler.h>
+#include <utility>
 //#include <sofa/core/topology/TopologyHandler.inl>
 
 namespace sofa
@@ -104,21 +105,28 @@ void TopologyDataHandler <TopologyElementType, VecT>::move( const sofa::helper::
 template <typename TopologyElementType, typename VecT>
 void TopologyDataHandler <TopologyElementType, VecT>::remove( const sofa::helper::vector<unsigned int> &index )
 {
-		
-	container_type& data = *(m_topologyData->beginEdit());
-	if (data.size()>0) {
-		unsigned int last = (unsigned)data.size() -1;
-
-		for (unsigned int i = 0; i < index.size(); ++i)
-		{
-			this->applyDestroyFunction( index[i], data[index[i]] );
-			this->swap( index[i], last );
-			--last;
-		}
-
-		data.resize( data.size() - index.size() );
-	}
-	m_topologyData->endEdit();
+    if (index.empty()) return;
+
+    // The whole batch of removed elements is processed in a single edit of the Data:
+    // values are swapped in place instead of going through swap(), which would open
+    // and close an edit (and dirty the outputs of the Data) for each removed element.
+    container_type& data = *(m_topologyData->beginEdit());
+    if (data.size()>0)
+    {
+        using std::swap;
+        unsigned int last = (unsigned)data.size() -1;
+
+        for (unsigned int i = 0; i < index.size(); ++i)
+        {
+            this->applyDestroyFunction( index[i], data[index[i]] );
+            if (index[i] != last)
+                swap( data[index[i]], data[last] );
+            --last;
+        }
+
+        data.resize( data.size() - index.size() );
+    }
+    m_topologyData->endEdit();
 }
 
 
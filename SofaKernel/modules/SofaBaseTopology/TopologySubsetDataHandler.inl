@@ -23,6 +23,7 @@
 #define SOFA_COMPONENT_TOPOLOGY_TOPOLOGYSUBSETDATAHANDLER_INL
 
 #include <SofaBaseTopology/TopologySubsetDataHandler.h>
+#include <unordered_map>
 
 namespace sofa
 {
@@ -97,59 +98,83 @@ template <typename TopologyElementType, typename VecT>
 void TopologySubsetDataHandler <TopologyElementType, VecT>::remove( const sofa::helper::vector<unsigned int> &index )
 {
     container_type& data = *(m_topologyData->beginEdit());
-    unsigned int it1;
-    unsigned int it2;
 
-    for (unsigned int i = 0; i < index.size(); ++i)
+    // Position of each element in the subset, built once for the whole list of removed
+    // elements instead of searching the subset twice for each of them. If the subset
+    // contains an element twice, the positions are not used and the subset is searched.
+    std::unordered_map<unsigned int, unsigned int> positions;
+    bool uniqueElements = true;
+
+    auto buildPositions = [&]()
+    {
+        positions.clear();
+        positions.reserve(data.size());
+        uniqueElements = true;
+        for (unsigned int it = 0; it < data.size() && uniqueElements; ++it)
+            uniqueElements = positions.insert(std::make_pair((unsigned int)data[it], it)).second;
+    };
+
+    auto find = [&](unsigned int elem) -> unsigned int
     {
-        it1=0;
-        while(it1<data.size())
+        if (uniqueElements)
         {
-            if(data[it1]==index[i])
-                break;
-            else
-                it1+=1;
+            auto p = positions.find(elem);
+            return (p != positions.end()) ? p->second : (unsigned int)data.size();
         }
+        unsigned int it = 0;
+        while (it < data.size() && data[it] != elem)
+            ++it;
+        return it;
+    };
 
-
-        if (it1<data.size())
+    auto assign = [&](unsigned int it, unsigned int elem)
+    {
+        if (data[it] == elem)
+            return;
+        if (uniqueElements)
         {
-            it2=0;
-            while(it2<data.size())
-            {
-                if(data[it2]==this->lastElementIndex)
-                    break;
-                else
-                    it2+=1;
-            }
+            auto p = positions.find((unsigned int)data[it]);
+            if (p != positions.end() && p->second == it)
+                positions.erase(p);
+            positions[elem] = it;
+        }
+        data[it] = elem;
+    };
 
-            if (it2<data.size())
-                data[it2]=index[i];
+    buildPositions();
 
-            data[it1]=data[data.size()-1];
-           size_t size_before = data.size();
+    for (unsigned int i = 0; i < index.size(); ++i)
+    {
+        const unsigned int it1 = find(index[i]);
+        const unsigned int it2 = find(this->lastElementIndex);
+
+        // the last element is renumbered with the index of the removed one
+        if (it2 < data.size())
+            assign(it2, index[i]);
+
+        if (it1 < data.size())
+        {
+            const unsigned int back = (unsigned int)data.size() - 1;
+            assign(it1, data[back]);
+            size_t size_before = data.size();
 
             // Call destroy function implemented in specific component
-            this->applyDestroyFunction(index[i], data[data.size()-1]);
+            this->applyDestroyFunction(index[i], data[back]);
 
             // As applyDestroyFunction could already perfom the suppression, if implemented. Size is checked again. If no change this handler really perform the suppresion
             if (size_before == data.size())
-                data.resize(data.size() - 1);
-        }
-        else
-        {
-            it2=0;
-            while(it2<data.size())
             {
-                if(data[it2]==this->lastElementIndex)
-                    break;
-                else
-                    it2+=1;
+                if (uniqueElements)
+                {
+                    auto p = positions.find((unsigned int)data[back]);
+                    if (p != positions.end() && p->second == back)
+                        positions.erase(p);
+                }
+                data.resize(back);
             }
-
-            if (it2<data.size())
+            else
             {
-                data[it2]=index[i];
+                buildPositions();
             }
         }
         --this->lastElementIndex;
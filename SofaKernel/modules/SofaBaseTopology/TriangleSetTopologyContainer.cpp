@@ -20,6 +20,7 @@
 * Contact information: contact@sofa-framework.org                             *
 ******************************************************************************/
 #include <SofaBaseTopology/TriangleSetTopologyContainer.h>
+#include <SofaBaseTopology/TopologyArrayBuilder.h>
 #include <sofa/core/visual/VisualParams.h>
 
 #include <sofa/core/ObjectFactory.h>
@@ -126,13 +127,11 @@ void TriangleSetTopologyContainer::createTrianglesAroundVertexArray()
     if (nbPoints == 0) // in case only Data have been copied and not going thourgh AddTriangle methods.
         this->setNbPoints(d_initPoints.getValue().size());
 
-    m_trianglesAroundVertex.resize(getNbPoints());
-    for (size_t i = 0; i < m_triangle.size(); ++i)
+    // adding triangle i in the triangle shell of its points
+    topologyarray::buildAroundArray(getInitTaskScheduler(), m_triangle.size(), 3, getNbPoints(), [&](size_t i, unsigned int j) -> PointID
     {
-        // adding edge i in the edge shell of both points
-        for (unsigned int j=0; j<3; ++j)
-            m_trianglesAroundVertex[ m_triangle[i][j]  ].push_back( (TriangleID)i );
-    }
+        return m_triangle[i][j];
+    }, m_trianglesAroundVertex);
 }
 
 void TriangleSetTopologyContainer::createTrianglesAroundEdgeArray ()
@@ -172,19 +171,43 @@ void TriangleSetTopologyContainer::createTrianglesAroundEdgeArray ()
         return;
     }
 
-    m_trianglesAroundEdge.resize( numEdges );
-    for (size_t i = 0; i < numTriangles; ++i)
+    // adding triangle i in the triangle shell of all edges
+    topologyarray::buildAroundArray(getInitTaskScheduler(), numTriangles, 3, numEdges, [&](size_t i, unsigned int j) -> EdgeID
     {
-        const Triangle &t = getTriangle((TriangleID)i);
-        // adding triangle i in the triangle shell of all edges
-        for (unsigned int j=0; j<3; ++j)
+        return m_edgesInTriangle[i][j];
+    }, m_trianglesAroundEdge);
+
+    // triangles on the left of an edge are inserted at the front of its shell, the ones on the right at the back
+    helper::ReadAccessor< Data< sofa::helper::vector<Edge> > > m_edge = d_edge;
+    helper::ReadAccessor< Data< sofa::helper::vector<Triangle> > > m_triangle = d_triangle;
+    topologyarray::forEachRange(getInitTaskScheduler(), 0, numEdges, [&](size_t first, size_t last)
+    {
+        sofa::helper::vector<TriangleID> left, right;
+        for (size_t edgeId = first; edgeId < last; ++edgeId)
         {
-            if (d_edge.getValue()[m_edgesInTriangle[i][j]][0] == t[(j + 1) % 3])
-                m_trianglesAroundEdge[m_edgesInTriangle[i][j]].insert(m_trianglesAroundEdge[m_edgesInTriangle[i][j]].begin(), (TriangleID)i); // triangle is on the left of the edge
-            else
-                m_trianglesAroundEdge[m_edgesInTriangle[i][j]].push_back((TriangleID)i); // triangle is on the right of the edge
+            TrianglesAroundEdge& shell = m_trianglesAroundEdge[edgeId];
+            left.clear();
+            right.clear();
+            for (size_t k = 0; k < shell.size(); )
+            {
+                const TriangleID triangleId = shell[k];
+                const Triangle& t = m_triangle[triangleId];
+                for (unsigned int j=0; j<3; ++j)
+                {
+                    if (m_edgesInTriangle[triangleId][j] != edgeId)
+                        continue;
+                    if (m_edge[edgeId][0] == t[(j + 1) % 3])
+                        left.push_back(triangleId); // triangle is on the left of the edge
+                    else
+                        right.push_back(triangleId); // triangle is on the right of the edge
+                }
+                while (k < shell.size() && shell[k] == triangleId)
+                    ++k;
+            }
+            shell.assign(left.rbegin(), left.rend());
+            shell.insert(shell.end(), right.begin(), right.end());
         }
-    }
+    }, 256);
 }
 
 void TriangleSetTopologyContainer::createEdgeSetArray()
@@ -204,32 +227,15 @@ void TriangleSetTopologyContainer::createEdgeSetArray()
             clearTrianglesAroundEdge();
     }
 
-    // create a temporary map to find redundant edges
-    std::map<Edge, EdgeID> edgeMap;
     helper::WriteAccessor< Data< sofa::helper::vector<Edge> > > m_edge = d_edge;
     helper::ReadAccessor< Data< sofa::helper::vector<Triangle> > > m_triangle = d_triangle;
 
-    for (size_t i=0; i<m_triangle.size(); ++i)
+    // edges keep the orientation of their first triangle, to have oriented edges on the border of the triangulation
+    topologyarray::buildEdges(getInitTaskScheduler(), m_triangle.size(), 3, [&](size_t i, unsigned int j)
     {
         const Triangle &t = m_triangle[i];
-        for(unsigned int j=0; j<3; ++j)
-        {
-            const PointID v1 = t[(j+1)%3];
-            const PointID v2 = t[(j+2)%3];
-
-            // sort vertices in lexicographic order
-            const Edge e = ((v1<v2) ? Edge(v1,v2) : Edge(v2,v1));
-
-            if(edgeMap.find(e) == edgeMap.end())
-            {
-                // edge not in edgeMap so create a new one
-                const size_t edgeIndex = edgeMap.size();
-                edgeMap[e] = (EdgeID)edgeIndex;
-                //m_edge.push_back(e); Changed to have oriented edges on the border of the triangulation
-                m_edge.push_back(Edge(v1,v2));
-            }
-        }
-    }
+        return Edge(t[(j+1)%3], t[(j+2)%3]);
+    }, true, m_edge, (sofa::helper::vector<EdgesInTriangle>*)nullptr);
 }
 
 void TriangleSetTopologyContainer::createEdgesInTriangleArray()
@@ -250,88 +256,38 @@ void TriangleSetTopologyContainer::createEdgesInTriangleArray()
 
     if (hasEdges())
     {
-        /// there are already existing edges : must use an inefficient method. Parse all triangles and find the edge that match each triangle edge
+        /// there are already existing edges : find the edge that match each triangle edge
         helper::ReadAccessor< Data< sofa::helper::vector<Edge> > > m_edge = d_edge;
         const size_t numTriangles = getNumberOfTriangles();
-        const size_t numEdges = getNumberOfEdges();
-
-        m_edgesInTriangle.resize(numTriangles);
-        /// create a multi map where the key is a vertex index and the content is the indices of edges adjacent to that vertex.
-        std::multimap<PointID, EdgeID> edgesAroundVertexMap;
-        std::multimap<PointID, EdgeID>::iterator it;
 
-        for (size_t edge=0; edge<numEdges; ++edge)  //Todo: check if not better using multimap <PointID ,TriangleID> and for each edge, push each triangle present in both shell
-        {
-            edgesAroundVertexMap.insert(std::pair<PointID, EdgeID> (m_edge[edge][0], (EdgeID)edge));
-            edgesAroundVertexMap.insert(std::pair<PointID, EdgeID> (m_edge[edge][1], (EdgeID)edge));
-        }
-        for ( size_t i = 0 ; (i < numTriangles) && (foundEdge == true) ; ++i )
+        const size_t notFound = topologyarray::findEdges(getInitTaskScheduler(), m_edge, numTriangles, 3, [&](size_t i, unsigned int j)
         {
             const Triangle &t = m_triangle[i];
-            // adding edge i in the edge shell of both points
-            for ( unsigned int j = 0 ; (j < 3) && (foundEdge == true) ; ++j )
-            {
-                //finding edge i in edge array
-                std::pair<std::multimap<PointID, EdgeID>::iterator, std::multimap<PointID, EdgeID>::iterator > itPair=edgesAroundVertexMap.equal_range(t[(j+1)%3]);
+            return Edge(t[(j+1)%3], t[(j+2)%3]);
+        }, m_edgesInTriangle);
 
-                foundEdge=false;
-                for(it=itPair.first; (it!=itPair.second) && (foundEdge==false); ++it)
-                {
-                    EdgeID edge = (*it).second;
-                    if ( (m_edge[edge][0] == t[(j+1)%3] && m_edge[edge][1] == t[(j+2)%3]) || (m_edge[edge][0] == t[(j+2)%3] && m_edge[edge][1] == t[(j+1)%3]))
-                    {
-                        m_edgesInTriangle[i][j] = edge;
-                        foundEdge=true;
-                    }
-                }
-
-                if (!foundEdge)
-                {
-                    msg_error() << "Cannot find edge " << j
-                        << " [" << t[(j + 1) % 3] << ", " << t[(j + 2) % 3] << "]"
-                        << " in triangle " << i;
-                    m_edgesInTriangle.clear();
-                    return;
-                }
-            }
+        if (notFound < numTriangles * 3)
+        {
+            const size_t i = notFound / 3;
+            const unsigned int j = notFound % 3;
+            const Triangle &t = m_triangle[i];
+            msg_error() << "Cannot find edge " << j
+                << " [" << t[(j + 1) % 3] << ", " << t[(j + 2) % 3] << "]"
+                << " in triangle " << i;
+            m_edgesInTriangle.clear();
+            return;
         }
     }
     if(!hasEdges() || foundEdge == false) // To optimize, this method should be called without creating edgesArray before.
     {
         /// create edge array and triangle edge array at the same time
-        const size_t numTriangles = getNumberOfTriangles();
-        m_edgesInTriangle.resize(numTriangles);
-
-
-        // create a temporary map to find redundant edges
-        std::map<Edge, EdgeID> edgeMap;
         helper::WriteAccessor< Data< sofa::helper::vector<Edge> > > m_edge = d_edge;
 
-        for (size_t i=0; i<m_triangle.size(); ++i)
+        topologyarray::buildEdges(getInitTaskScheduler(), m_triangle.size(), 3, [&](size_t i, unsigned int j)
         {
             const Triangle &t = m_triangle[i];
-            for(unsigned int j=0; j<3; ++j)
-            {
-                const PointID v1 = t[(j+1)%3];
-                const PointID v2 = t[(j+2)%3];
-
-                // sort vertices in lexicographic order
-                const Edge e = ((v1<v2) ? Edge(v1,v2) : Edge(v2,v1));
-
-                if(edgeMap.find(e) == edgeMap.end())
-                {
-                    // edge not in edgeMap so create a new one
-                    const size_t edgeIndex = edgeMap.size();
-                    /// add new edge
-                    edgeMap[e] = (EdgeID)edgeIndex;
-//			  m_edge.push_back(e);
-                    m_edge.push_back(Edge(v1,v2));
-
-                }
-
-                m_edgesInTriangle[i][j] = edgeMap[e];
-            }
-        }
+            return Edge(t[(j+1)%3], t[(j+2)%3]);
+        }, true, m_edge, &m_edgesInTriangle);
     }
 
 }
@@ -471,13 +427,9 @@ TriangleSetTopologyContainer::TriangleID TriangleSetTopologyContainer::getTriang
         return InvalidID;
     }
 
-    sofa::helper::vector<TriangleID> set1 = getTrianglesAroundVertex(v1);
-    sofa::helper::vector<TriangleID> set2 = getTrianglesAroundVertex(v2);
-    sofa::helper::vector<TriangleID> set3 = getTrianglesAroundVertex(v3);
-
-    sort(set1.begin(), set1.end());
-    sort(set2.begin(), set2.end());
-    sort(set3.begin(), set3.end());
+    sofa::helper::vector<TriangleID> set1 = m_trianglesAroundVertex.getSortedList(v1);
+    sofa::helper::vector<TriangleID> set2 = m_trianglesAroundVertex.getSortedList(v2);
+    sofa::helper::vector<TriangleID> set3 = m_trianglesAroundVertex.getSortedList(v3);
 
     // The destination vector must be large enough to contain the result.
     sofa::helper::vector<TriangleID> out1(set1.size()+set2.size());
@@ -512,7 +464,7 @@ const sofa::helper::vector< TriangleSetTopologyContainer::TrianglesAroundVertex
     if(CHECK_TOPOLOGY)	// this method should only be called when the shell array exists
         msg_warning_when(!hasTrianglesAroundVertex()) << "TrianglesAroundVertex shell array is empty.";
 
-    return m_trianglesAroundVertex;
+    return m_trianglesAroundVertex.getLists();
 }
 
 const sofa::helper::vector< TriangleSetTopologyContainer::TrianglesAroundEdge > &TriangleSetTopologyContainer::getTrianglesAroundEdgeArray()
@@ -534,13 +486,18 @@ const sofa::helper::vector<TriangleSetTopologyContainer::EdgesInTriangle> &Trian
 const TriangleSetTopologyContainer::TrianglesAroundVertex& TriangleSetTopologyContainer::getTrianglesAroundVertex(PointID id)
 {
     if (id < m_trianglesAroundVertex.size())
-        return m_trianglesAroundVertex[id];
+        return m_trianglesAroundVertex.getLists()[id];
     else if (CHECK_TOPOLOGY)
         msg_error() << "TrianglesAroundVertex array access out of bounds: " << id << " >= " << m_trianglesAroundVertex.size();
 
     return InvalidSet;
 }
 
+TriangleSetTopologyContainer::TrianglesAroundVertexRange TriangleSetTopologyContainer::getTrianglesAroundVertexRange(PointID id) const
+{
+    return m_trianglesAroundVertex.range(id);
+}
+
 const TriangleSetTopologyContainer::TrianglesAroundEdge& TriangleSetTopologyContainer::getTrianglesAroundEdge(EdgeID id)
 {
     if (id < m_trianglesAroundEdge.size())
@@ -683,7 +640,7 @@ bool TriangleSetTopologyContainer::checkTopology() const
 
             for (size_t i = 0; i < m_trianglesAroundVertex.size(); ++i)
             {
-                const sofa::helper::vector<TriangleID> &tvs = m_trianglesAroundVertex[i];
+                const TrianglesAroundVertexRange tvs = m_trianglesAroundVertex.range(i);
                 for (size_t j = 0; j < tvs.size(); ++j)
                 {
                     const Triangle& triangle = m_triangle[tvs[j]];
@@ -916,7 +873,7 @@ const TriangleSetTopologyContainer::VecTriangleID TriangleSetTopologyContainer::
 
     for(PointID i = 0; i<3; ++i) // for each node of the triangle
     {
-        TrianglesAroundVertex triAV = this->getTrianglesAroundVertex(the_tri[i]);
+        const TrianglesAroundVertexRange triAV = getTrianglesAroundVertexRange(the_tri[i]);
 
         for (size_t j = 0; j<triAV.size(); ++j) // for each triangle around the node
         {
@@ -1023,9 +980,6 @@ bool TriangleSetTopologyContainer::hasBorderElementLists() const
 
 void TriangleSetTopologyContainer::clearTrianglesAroundVertex()
 {
-    for(size_t i=0; i<m_trianglesAroundVertex.size(); ++i)
-        m_trianglesAroundVertex[i].clear();
-
     m_trianglesAroundVertex.clear();
 }
 
@@ -54,6 +54,7 @@ public:
     typedef core::topology::BaseMeshTopology::SeqTriangles                 SeqTriangles;
     typedef core::topology::BaseMeshTopology::EdgesInTriangle              EdgesInTriangle;
     typedef core::topology::BaseMeshTopology::TrianglesAroundVertex        TrianglesAroundVertex;
+    typedef CompressedAroundArray<TriangleID>::Range                       TrianglesAroundVertexRange;
     typedef core::topology::BaseMeshTopology::TrianglesAroundEdge          TrianglesAroundEdge;
     typedef sofa::helper::vector<TriangleID>                               VecTriangleID;
 
@@ -120,6 +121,14 @@ public:
      */
     const TrianglesAroundVertex& getTrianglesAroundVertex(PointID id) override;
 
+    /** \brief Returns the triangles around a vertex without copying them, also when the shell array
+     * is stored in compressed form. The range is valid until the topology changes.
+     *
+     * @param id The ID of the vertex.
+     * @return An empty range if the vertex is out of range.
+     */
+    TrianglesAroundVertexRange getTrianglesAroundVertexRange(PointID id) const;
+
 
     /** \brief Returns the set of triangles adjacent to a given edge.
      *
@@ -344,7 +353,7 @@ protected:
     sofa::helper::vector<EdgesInTriangle> m_edgesInTriangle;
 
     /// for each vertex provides the set of triangles adjacent to that vertex.
-    sofa::helper::vector< TrianglesAroundVertex > m_trianglesAroundVertex;
+    CompressedAroundArray<TriangleID> m_trianglesAroundVertex;
 
     /// for each edge provides the set of triangles adjacent to that edge.
     sofa::helper::vector< TrianglesAroundEdge > m_trianglesAroundEdge;
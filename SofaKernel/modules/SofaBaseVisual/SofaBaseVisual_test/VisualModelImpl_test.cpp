@@ -23,6 +23,7 @@
 #include <gtest/gtest.h>
 #include <SofaBaseVisual/VisualModelImpl.h>
 #include <sofa/defaulttype/VecTypes.h>
+#include <sofa/simulation/DefaultTaskScheduler.h>
 
 namespace sofa {
 
@@ -120,4 +121,100 @@ TEST( VisualModelImpl_test , checkThatMembersAreCorrectlyConstructed )
     ASSERT_EQ(1u, visualModel.xforms.size());
 }
 
+/// Wavy grid of n x n vertices, with triangles on one half and quads on the other half
+static void createGrid(StubVisualModelImpl& visualModel, unsigned int n)
+{
+    typedef component::visualmodel::VisualModelImpl VisualModelImpl;
+    VisualModelImpl::VecCoord positions;
+    VisualModelImpl::VecTexCoord texcoords;
+    for (unsigned int j = 0; j < n; ++j)
+        for (unsigned int i = 0; i < n; ++i)
+        {
+            positions.push_back(VisualModelImpl::Coord(i, j, std::sin(0.3 * i) * std::cos(0.2 * j)));
+            texcoords.push_back(VisualModelImpl::TexCoord(i / float(n), j / float(n)));
+        }
+    VisualModelImpl::VecTriangle triangles;
+    VisualModelImpl::VecQuad quads;
+    for (unsigned int j = 0; j + 1 < n; ++j)
+        for (unsigned int i = 0; i + 1 < n; ++i)
+        {
+            const unsigned int v = j * n + i;
+            if (j < n / 2)
+            {
+                triangles.push_back(VisualModelImpl::Triangle(v, v + 1, v + n + 1));
+                triangles.push_back(VisualModelImpl::Triangle(v, v + n + 1, v + n));
+            }
+            else
+                quads.push_back(VisualModelImpl::Quad(v, v + 1, v + n + 1, v + n));
+        }
+    visualModel.setVertices(&positions);
+    visualModel.setVtexcoords(&texcoords);
+    visualModel.setTriangles(&triangles);
+    visualModel.setQuads(&quads);
+    visualModel.m_computeTangents.setValue(true);
+}
+
+// The normals and tangents gathered from the faces are the same as the accumulated ones
+TEST( VisualModelImpl_test , parallelNormalsAndTangents )
+{
+    StubVisualModelImpl visualModel;
+    createGrid(visualModel, 64);
+
+    visualModel.computeNormals();
+    visualModel.computeTangents();
+    const component::visualmodel::VisualModelImpl::VecDeriv normals = visualModel.getVnormals();
+    const component::visualmodel::VisualModelImpl::VecCoord tangents = visualModel.getVtangents();
+    const component::visualmodel::VisualModelImpl::VecCoord bitangents = visualModel.getVbitangents();
+
+    simulation::TaskScheduler* scheduler = simulation::TaskScheduler::create(simulation::DefaultTaskScheduler::name());
+    scheduler->init(4);
+    visualModel.d_parallelNormals.setValue(true);
+    visualModel.computeNormals();
+    visualModel.computeTangents();
+    scheduler->stop();
+
+    ASSERT_EQ(normals.size(), visualModel.getVnormals().size());
+    for (std::size_t i = 0; i < normals.size(); ++i)
+    {
+        EXPECT_EQ(normals[i], visualModel.getVnormals()[i]) << i;
+        EXPECT_EQ(tangents[i], visualModel.getVtangents()[i]) << i;
+        EXPECT_EQ(bitangents[i], visualModel.getVbitangents()[i]) << i;
+    }
+}
+
+// Only the normals around the vertices moved beyond the threshold are updated
+TEST( VisualModelImpl_test , normalsUpdateThreshold )
+{
+    typedef component::visualmodel::VisualModelImpl VisualModelImpl;
+    StubVisualModelImpl visualModel;
+    const unsigned int n = 16;
+    createGrid(visualModel, n);
+    visualModel.d_normalsUpdateThreshold.setValue(0.1);
+    visualModel.computeNormals();
+    const VisualModelImpl::VecDeriv initialNormals = visualModel.getVnormals();
+
+    // below the threshold: nothing changes
+    VisualModelImpl::VecCoord positions = visualModel.getVertices();
+    positions[n * 4 + 4][2] += 0.05;
+    visualModel.setVertices(&positions);
+    visualModel.computeNormals();
+    EXPECT_EQ(initialNormals, visualModel.getVnormals());
+
+    // beyond the threshold: same normals as a full computation
+    positions[n * 4 + 4][2] += 0.5;
+    positions[n * 12 + 8][0] += 0.5;
+    visualModel.setVertices(&positions);
+    visualModel.computeNormals();
+    const VisualModelImpl::VecDeriv partialNormals = visualModel.getVnormals();
+    EXPECT_NE(initialNormals, partialNormals);
+
+    StubVisualModelImpl reference;
+    createGrid(reference, n);
+    reference.setVertices(&positions);
+    reference.computeNormals();
+    ASSERT_EQ(reference.getVnormals().size(), partialNormals.size());
+    for (std::size_t i = 0; i < partialNormals.size(); ++i)
+        EXPECT_EQ(reference.getVnormals()[i], partialNormals[i]) << i;
+}
+
 } //sofa
@@ -42,6 +42,9 @@
 #include <sofa/helper/io/MeshOBJ.h>
 #include <sofa/helper/rmath.h>
 #include <sofa/helper/accessor.h>
+#include <sofa/simulation/ParallelForEach.h>
+#include <algorithm>
+#include <functional>
 #include <sstream>
 #include <map>
 #include <memory>
@@ -202,6 +205,9 @@ VisualModelImpl::VisualModelImpl() //const std::string &name, std::string filena
     , m_quads           (initData   (&m_quads, "quads", "quads of the model"))
     , m_vertPosIdx      (initData   (&m_vertPosIdx, "vertPosIdx", "If vertices have multiple normals/texcoords stores vertices position indices"))
     , m_vertNormIdx     (initData   (&m_vertNormIdx, "vertNormIdx", "If vertices have multiple normals/texcoords stores vertices normal indices"))
+    , d_parallelNormals (initData   (&d_parallelNormals, false, "parallelNormals", "Compute normals and tangents with parallel tasks, each vertex gathering the contributions of its faces"))
+    , d_normalsUpdateThreshold (initData (&d_normalsUpdateThreshold, (SReal)0, "normalsUpdateThreshold", "If positive, only recompute the normals around the vertices which moved more than this distance since their last update"))
+    , m_incidenceNbVertices(0)
     , fileMesh          (initData   (&fileMesh, "filename"," Path to an ogl model"))
     , texturename       (initData   (&texturename, "texturename", "Name of the Texture"))
     , m_translation     (initData   (&m_translation, Vec3Real(), "translation", "Initial Translation of the object"))
@@ -237,6 +243,8 @@ VisualModelImpl::VisualModelImpl() //const std::string &name, std::string filena
 
     m_edges.setAutoLink(false); // disable linking of edges by default
 
+    m_incidenceCounters[0] = m_incidenceCounters[1] = m_incidenceCounters[2] = -1;
+
     // add one identity matrix
     xforms.resize(1);
 }
@@ -916,6 +924,12 @@ void VisualModelImpl::computeNormals()
     //const VecCoord& vertices = m_vertices2.getValue();
     if (vertices.empty() || (!m_updateNormals.getValue() && (m_vnormals.getValue()).size() == (vertices).size())) return;
 
+    if (d_parallelNormals.getValue() || d_normalsUpdateThreshold.getValue() > 0)
+    {
+        computeNormalsByIncidence();
+        return;
+    }
+
     const VecTriangle& triangles = m_triangles.getValue();
     const VecQuad& quads = m_quads.getValue();
     const helper::vector<int> &vertNormIdx = m_vertNormIdx.getValue();
@@ -1042,6 +1056,12 @@ void VisualModelImpl::computeTangents()
 {
     if (!m_computeTangents.getValue() || !m_vtexcoords.getValue().size()) return;
 
+    if (d_parallelNormals.getValue())
+    {
+        computeTangentsByIncidence();
+        return;
+    }
+
     const VecTriangle& triangles = m_triangles.getValue();
     const VecQuad& quads = m_quads.getValue();
     const VecCoord& vertices = getVertices();
@@ -1132,6 +1152,305 @@ void VisualModelImpl::computeTangents()
     m_vbitangents.endEdit();
 }
 
+void VisualModelImpl::FaceIncidence::build(std::size_t nbRows, const VecTriangle& triangles, const VecQuad& quads, const helper::vector<int>& rowOfVertex)
+{
+    auto row = [&rowOfVertex](unsigned int v) -> std::size_t { return rowOfVertex.empty() ? v : (std::size_t)rowOfVertex[v]; };
+
+    rowBegin.assign(nbRows + 1, 0);
+    for (const Triangle& t : triangles)
+        for (unsigned int c = 0; c < 3; ++c)
+            ++rowBegin[row(t[c]) + 1];
+    for (const Quad& q : quads)
+        for (unsigned int c = 0; c < 4; ++c)
+            ++rowBegin[row(q[c]) + 1];
+    for (std::size_t r = 0; r < nbRows; ++r)
+        rowBegin[r + 1] += rowBegin[r];
+
+    // fill the rows in the order of the faces, as the sequential accumulation
+    contributions.resize(rowBegin[nbRows]);
+    helper::vector<unsigned int> next(rowBegin.begin(), rowBegin.end() - 1);
+    const unsigned int nbTriangles = (unsigned int)triangles.size();
+    for (unsigned int i = 0; i < nbTriangles; ++i)
+        for (unsigned int c = 0; c < 3; ++c)
+            contributions[next[row(triangles[i][c])]++] = i;
+    for (unsigned int i = 0; i < quads.size(); ++i)
+        for (unsigned int c = 0; c < 4; ++c)
+            contributions[next[row(quads[i][c])]++] = nbTriangles + 4 * i + c;
+}
+
+bool VisualModelImpl::updateFaceIncidence()
+{
+    const std::size_t nbVertices = getVertices().size();
+    if (m_incidenceCounters[0] == m_triangles.getCounter() && m_incidenceCounters[1] == m_quads.getCounter()
+            && m_incidenceCounters[2] == m_vertNormIdx.getCounter() && m_incidenceNbVertices == nbVertices)
+        return false;
+
+    const helper::vector<int> &vertNormIdx = m_vertNormIdx.getValue();
+    std::size_t nbNormals = nbVertices;
+    if (!vertNormIdx.empty())
+        nbNormals = (std::size_t)(*std::max_element(vertNormIdx.begin(), vertNormIdx.end()) + 1);
+    m_normalIncidence.build(nbNormals, m_triangles.getValue(), m_quads.getValue(), vertNormIdx);
+    m_vertexIncidence = FaceIncidence();
+    m_incidenceCounters[0] = m_triangles.getCounter();
+    m_incidenceCounters[1] = m_quads.getCounter();
+    m_incidenceCounters[2] = m_vertNormIdx.getCounter();
+    m_incidenceNbVertices = nbVertices;
+    return true;
+}
+
+void VisualModelImpl::computeNormalsByIncidence()
+{
+    const VecCoord& vertices = getVertices();
+    const VecTriangle& triangles = m_triangles.getValue();
+    const VecQuad& quads = m_quads.getValue();
+    const helper::vector<int> &vertNormIdx = m_vertNormIdx.getValue();
+    const std::size_t nbTriangles = triangles.size();
+    const std::size_t nbFaces = nbTriangles + quads.size();
+
+    // minimum number of faces or normals processed by a task
+    const std::size_t grainSize = 1024;
+    simulation::TaskScheduler* scheduler = d_parallelNormals.getValue() ? simulation::TaskScheduler::getInstance() : nullptr;
+    auto forEachRange = [scheduler](std::size_t size, const std::function<void(std::size_t, std::size_t)>& function)
+    {
+        if (scheduler)
+            simulation::parallelForEachRange(*scheduler, 0, size, function, grainSize);
+        else
+            function(0, size);
+    };
+
+    const bool rebuilt = updateFaceIncidence();
+    const std::size_t nbNormals = m_normalIncidence.rowBegin.size() - 1;
+
+    auto computeFace = [&](std::size_t f)
+    {
+        if (f < nbTriangles)
+        {
+            const Coord& v1 = vertices[triangles[f][0]];
+            const Coord& v2 = vertices[triangles[f][1]];
+            const Coord& v3 = vertices[triangles[f][2]];
+            m_faceNormals[f] = cross(v2-v1, v3-v1);
+        }
+        else
+        {
+            const Quad& q = quads[f - nbTriangles];
+            const Coord & v1 = vertices[q[0]];
+            const Coord & v2 = vertices[q[1]];
+            const Coord & v3 = vertices[q[2]];
+            const Coord & v4 = vertices[q[3]];
+            Coord* n = &m_faceNormals[nbTriangles + 4 * (f - nbTriangles)];
+            n[0] = cross(v2-v1, v4-v1);
+            n[1] = cross(v3-v2, v1-v2);
+            n[2] = cross(v4-v3, v2-v3);
+            n[3] = cross(v1-v4, v3-v4);
+        }
+    };
+
+    auto gatherNormal = [&](std::size_t r, Coord& normal)
+    {
+        normal.clear();
+        for (unsigned int k = m_normalIncidence.rowBegin[r]; k < m_normalIncidence.rowBegin[r + 1]; ++k)
+            normal += m_faceNormals[m_normalIncidence.contributions[k]];
+        normal.normalize();
+    };
+
+    const SReal threshold = d_normalsUpdateThreshold.getValue();
+    const bool partialUpdate = threshold > 0 && !rebuilt
+            && m_normalsReferencePositions.size() == vertices.size()
+            && m_vnormals.getValue().size() == vertices.size()
+            && (vertNormIdx.empty() || m_indexedNormals.size() == nbNormals);
+
+    if (!partialUpdate)
+    {
+        m_faceNormals.resize(nbTriangles + 4 * quads.size());
+        forEachRange(nbFaces, [&](std::size_t first, std::size_t last)
+        {
+            for (std::size_t f = first; f < last; ++f)
+                computeFace(f);
+        });
+
+        VecDeriv& normals = *(m_vnormals.beginEdit());
+        normals.resize(vertices.size());
+        VecCoord& indexedNormals = vertNormIdx.empty() ? normals : m_indexedNormals;
+        indexedNormals.resize(nbNormals);
+        forEachRange(nbNormals, [&](std::size_t first, std::size_t last)
+        {
+            for (std::size_t r = first; r < last; ++r)
+                gatherNormal(r, indexedNormals[r]);
+        });
+        if (!vertNormIdx.empty())
+        {
+            for (std::size_t i = 0; i < vertices.size(); i++)
+                normals[i] = m_indexedNormals[vertNormIdx[i]];
+        }
+        m_vnormals.endEdit();
+
+        if (threshold > 0)
+            m_normalsReferencePositions = vertices;
+        return;
+    }
+
+    // Only the faces around the moved vertices and the normals around these faces are updated
+    const SReal threshold2 = threshold * threshold;
+    auto normalOf = [&vertNormIdx](unsigned int v) -> std::size_t { return vertNormIdx.empty() ? v : (std::size_t)vertNormIdx[v]; };
+    m_dirtyFaces.assign(nbFaces, 0);
+    m_dirtyNormals.assign(nbNormals, 0);
+    helper::vector<unsigned int> faces;
+    for (std::size_t v = 0; v < vertices.size(); ++v)
+    {
+        if ((vertices[v] - m_normalsReferencePositions[v]).norm2() <= threshold2)
+            continue;
+        m_normalsReferencePositions[v] = vertices[v];
+        const std::size_t r = normalOf((unsigned int)v);
+        for (unsigned int k = m_normalIncidence.rowBegin[r]; k < m_normalIncidence.rowBegin[r + 1]; ++k)
+        {
+            const unsigned int c = m_normalIncidence.contributions[k];
+            const unsigned int f = c < nbTriangles ? c : (unsigned int)(nbTriangles + (c - nbTriangles) / 4);
+            if (!m_dirtyFaces[f])
+            {
+                m_dirtyFaces[f] = 1;
+                faces.push_back(f);
+            }
+        }
+    }
+    if (faces.empty())
+        return;
+
+    helper::vector<unsigned int> dirtyNormals;
+    for (unsigned int f : faces)
+    {
+        const unsigned int nbCorners = f < nbTriangles ? 3 : 4;
+        for (unsigned int c = 0; c < nbCorners; ++c)
+        {
+            const std::size_t r = normalOf(f < nbTriangles ? triangles[f][c] : quads[f - nbTriangles][c]);
+            if (!m_dirtyNormals[r])
+            {
+                m_dirtyNormals[r] = 1;
+                dirtyNormals.push_back((unsigned int)r);
+            }
+        }
+    }
+
+    forEachRange(faces.size(), [&](std::size_t first, std::size_t last)
+    {
+        for (std::size_t i = first; i < last; ++i)
+            computeFace(faces[i]);
+    });
+
+    VecDeriv& normals = *(m_vnormals.beginEdit());
+    VecCoord& indexedNormals = vertNormIdx.empty() ? normals : m_indexedNormals;
+    forEachRange(dirtyNormals.size(), [&](std::size_t first, std::size_t last)
+    {
+        for (std::size_t i = first; i < last; ++i)
+            gatherNormal(dirtyNormals[i], indexedNormals[dirtyNormals[i]]);
+    });
+    if (!vertNormIdx.empty())
+    {
+        for (std::size_t i = 0; i < vertices.size(); i++)
+            if (m_dirtyNormals[vertNormIdx[i]])
+                normals[i] = m_indexedNormals[vertNormIdx[i]];
+    }
+    m_vnormals.endEdit();
+}
+
+void VisualModelImpl::computeTangentsByIncidence()
+{
+    const VecTriangle& triangles = m_triangles.getValue();
+    const VecQuad& quads = m_quads.getValue();
+    const VecCoord& vertices = getVertices();
+    const VecTexCoord& texcoords = m_vtexcoords.getValue();
+    const helper::vector<int> &vertNormIdx = m_vertNormIdx.getValue();
+    const std::size_t nbTriangles = triangles.size();
+    const std::size_t nbFaces = nbTriangles + quads.size();
+
+    // the tangents are per vertex, even if the normals are shared
+    updateFaceIncidence();
+    const FaceIncidence* incidence = &m_normalIncidence;
+    if (!vertNormIdx.empty())
+    {
+        if (m_vertexIncidence.rowBegin.empty())
+            m_vertexIncidence.build(vertices.size(), triangles, quads, helper::vector<int>());
+        incidence = &m_vertexIncidence;
+    }
+
+    const std::size_t grainSize = 1024;
+    simulation::TaskScheduler* scheduler = simulation::TaskScheduler::getInstance();
+
+    m_faceTangents.resize(nbTriangles + 4 * quads.size());
+    const bool fixMergedUVSeams = m_fixMergedUVSeams.getValue();
+    simulation::parallelForEachRange(*scheduler, 0, nbFaces, [&](std::size_t first, std::size_t last)
+    {
+        for (std::size_t f = first; f < last; ++f)
+        {
+            if (f < nbTriangles)
+            {
+                const Triangle& tri = triangles[f];
+                const Coord v1 = vertices[tri[0]];
+                const Coord v2 = vertices[tri[1]];
+                const Coord v3 = vertices[tri[2]];
+                TexCoord t1 = texcoords[tri[0]];
+                TexCoord t2 = texcoords[tri[1]];
+                TexCoord t3 = texcoords[tri[2]];
+                if (fixMergedUVSeams)
+                {
+                    for (unsigned int j=0; j<t1.size(); ++j)
+                    {
+                        t2[j] += helper::rnear(t1[j]-t2[j]);
+                        t3[j] += helper::rnear(t1[j]-t3[j]);
+                    }
+                }
+                m_faceTangents[f] = computeTangent(v1, v2, v3, t1, t2, t3);
+            }
+            else
+            {
+                const Quad& q = quads[f - nbTriangles];
+                const Coord & v1 = vertices[q[0]];
+                const Coord & v2 = vertices[q[1]];
+                const Coord & v3 = vertices[q[2]];
+                const Coord & v4 = vertices[q[3]];
+                const TexCoord t1 = texcoords[q[0]];
+                const TexCoord t2 = texcoords[q[1]];
+                const TexCoord t3 = texcoords[q[2]];
+                const TexCoord t4 = texcoords[q[3]];
+
+                // same splits as computeTangents
+                Coord t123 = computeTangent  (v1, v2, v3, t1, t2, t3);
+                Coord t234 = computeTangent  (v2, v3, v4, t2, t3, t4);
+                Coord t341 = computeTangent  (v3, v4, v1, t3, t4, t1);
+                Coord t412 = computeTangent  (v4, v1, v2, t4, t1, t2);
+
+                Coord* t = &m_faceTangents[nbTriangles + 4 * (f - nbTriangles)];
+                t[0] = t123        + t341 + t412;
+                t[1] = t123 + t234        + t412;
+                t[2] = t123 + t234 + t341;
+                t[3] =        t234 + t341 + t412;
+            }
+        }
+    }, grainSize);
+
+    const VecCoord& normals = m_vnormals.getValue();
+    VecCoord& tangents = *(m_vtangents.beginEdit());
+    VecCoord& bitangents = *(m_vbitangents.beginEdit());
+    tangents.resize(vertices.size());
+    bitangents.resize(vertices.size());
+    simulation::parallelForEachRange(*scheduler, 0, vertices.size(), [&](std::size_t first, std::size_t last)
+    {
+        for (std::size_t i = first; i < last; ++i)
+        {
+            // the bitangents are only derived from the normals and the accumulated tangents
+            Coord t;
+            t.clear();
+            for (unsigned int k = incidence->rowBegin[i]; k < incidence->rowBegin[i + 1]; ++k)
+                t += m_faceTangents[incidence->contributions[k]];
+
+            const Coord& n = normals[i];
+            bitangents[i] = sofa::defaulttype::cross(n, t.normalized());
+            tangents[i] = sofa::defaulttype::cross(bitangents[i], n);
+        }
+    }, grainSize);
+    m_vtangents.endEdit();
+    m_vbitangents.endEdit();
+}
+
 void VisualModelImpl::computeBBox(const core::ExecParams* params, bool)
 {
     const VecCoord& x = getVertices(); //m_vertices.getValue(params);
@@ -135,6 +135,32 @@ public:
     /// If it is empty then each vertex correspond to one normal
     Data< helper::vector<int> > m_vertNormIdx;
 
+    Data<bool> d_parallelNormals; ///< compute normals and tangents with parallel tasks, each vertex gathering the contributions of its faces
+    Data<SReal> d_normalsUpdateThreshold; ///< if positive, only recompute the normals around the vertices which moved more than this distance since their last update
+
+    /// Faces around each normal (or vertex), stored in compressed rows.
+    /// Each row lists the contributions of the faces to the normal, in the order they are
+    /// accumulated by the sequential computation: the triangles, then the corners of the quads.
+    /// Contribution i < nbTriangles is triangle i, otherwise it is corner (i-nbTriangles)%4 of quad (i-nbTriangles)/4.
+    struct FaceIncidence
+    {
+        helper::vector<unsigned int> rowBegin; ///< first entry of each row, plus the end of the last row
+        helper::vector<unsigned int> contributions;
+
+        /// Build the rows of the faces around the vertices, or around rowOfVertex[vertex] if it is not empty
+        void build(std::size_t nbRows, const VecTriangle& triangles, const VecQuad& quads, const helper::vector<int>& rowOfVertex);
+    };
+    FaceIncidence m_normalIncidence; ///< faces around each normal
+    FaceIncidence m_vertexIncidence; ///< faces around each vertex, if different from the normals (see m_vertNormIdx)
+    int m_incidenceCounters[3]; ///< counters of the triangles, quads and normal indices when the incidence was built
+    std::size_t m_incidenceNbVertices;
+    VecCoord m_faceNormals; ///< contributions of the faces to the normals
+    VecCoord m_indexedNormals; ///< normals of m_vertNormIdx
+    VecCoord m_normalsReferencePositions; ///< positions of the vertices when their normals were last computed (see d_normalsUpdateThreshold)
+    helper::vector<char> m_dirtyFaces;
+    helper::vector<char> m_dirtyNormals;
+    VecCoord m_faceTangents; ///< contributions of the faces to the tangents
+
     /// Rendering method.
     virtual void internalDraw(const core::visual::VisualParams* /*vparams*/, bool /*transparent*/) {}
 
@@ -381,6 +407,12 @@ public:
     virtual void computeMesh();
     virtual void computeNormals();
     virtual void computeTangents();
+    /// Rebuild the face incidence if the mesh changed, returns true if it was rebuilt
+    bool updateFaceIncidence();
+    /// Compute the normals by gathering the contributions of the faces around each normal (see d_parallelNormals and d_normalsUpdateThreshold)
+    void computeNormalsByIncidence();
+    /// Compute the tangents by gathering the contributions of the faces around each vertex (see d_parallelNormals)
+    void computeTangentsByIncidence();
     void computeBBox(const core::ExecParams* params, bool=false) override;
     virtual void computeUVSphereProjection();
 
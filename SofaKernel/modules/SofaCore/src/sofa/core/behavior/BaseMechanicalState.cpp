@@ -82,6 +82,15 @@ void BaseMechanicalState::vMultiOp(const ExecParams* params, const VMultiOp& ops
     }
 }
 
+/// Perform vMultiOp(ops) and compute the scalar product of two of the resulting vectors.
+///
+/// By default the reduction is a separate pass, computed with vDot.
+SReal BaseMechanicalState::vMultiOpDot(const ExecParams* params, const VMultiOp& ops, ConstVecId a, ConstVecId b)
+{
+    vMultiOp(params, ops);
+    return vDot(params, a, b);
+}
+
 /// Handle state Changes from a given Topology
 void BaseMechanicalState::handleStateChange(core::topology::Topology* /*t*/)
 {
@@ -163,6 +163,13 @@ public:
     /// By default this method decompose the computation into multiple vOp calls.
     virtual void vMultiOp(const ExecParams* params, const VMultiOp& ops);
 
+    /// \brief Perform vMultiOp(ops), then return the scalar product of the resulting vectors a and b.
+    ///
+    /// This is used to fold the reduction that usually follows an update into the same pass over the data,
+    /// such as $x = x + p*alpha, r = r - q*alpha, rho = r.r$ in a conjugate gradient step.
+    /// By default this method calls vMultiOp followed by vDot.
+    virtual SReal vMultiOpDot(const ExecParams* params, const VMultiOp& ops, ConstVecId a, ConstVecId b);
+
     /// Compute the scalar products between two vectors.
     virtual SReal vDot(const ExecParams* params, ConstVecId a, ConstVecId b) = 0;
 
@@ -69,6 +69,7 @@ public:
     virtual void v_op(core::MultiVecId v, core::ConstMultiVecId a, core::ConstMultiVecId b, SReal f=1.0) = 0; ///< v=a+b*f
     virtual void v_multiop(const core::behavior::BaseMechanicalState::VMultiOp& o) = 0;
     virtual void v_dot(core::ConstMultiVecId a, core::ConstMultiVecId b) = 0; ///< a dot b ( get result using finish )
+    virtual void v_multiop_dot(const core::behavior::BaseMechanicalState::VMultiOp& o, core::ConstMultiVecId a, core::ConstMultiVecId b) { v_multiop(o); v_dot(a, b); } ///< v_multiop(o) then a dot b, in a single pass when supported by the states ( get result using finish )
     virtual void v_norm(core::ConstMultiVecId a, unsigned l)=0; ///< Compute the norm of a vector ( get result using finish ). The type of norm is set by parameter l. Use 0 for the infinite norm. Note that the 2-norm is more efficiently computed using the square root of the dot product.
     virtual void v_threshold(core::MultiVecId a, SReal threshold) = 0; ///< nullify the values below the given threshold
 
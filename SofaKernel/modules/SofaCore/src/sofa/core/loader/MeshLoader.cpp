@@ -21,7 +21,17 @@
 ******************************************************************************/
 #include <sofa/core/loader/MeshLoader.h>
 #include <sofa/helper/io/Mesh.h>
+#include <sofa/helper/io/MappedFile.h>
+#include <sofa/helper/io/TextParsing.h>
+#include <sofa/helper/system/FileSystem.h>
+#include <cstdint>
+#include <cstdio>
 #include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <sys/stat.h>
 
 namespace sofa
 {
@@ -67,6 +77,9 @@ MeshLoader::MeshLoader() : BaseLoader()
   , d_rotation(initData(&d_rotation, Vec3(), "rotation", "Rotation of the DOFs"))
   , d_scale(initData(&d_scale, Vec3(1.0, 1.0, 1.0), "scale3d", "Scale of the DOFs in 3 dimensions"))
   , d_transformation(initData(&d_transformation, Matrix4::s_identity, "transformation", "4x4 Homogeneous matrix to transform the DOFs (when present replace any)"))
+  , d_parallelParsing(initData(&d_parallelParsing, false, "parallelParsing", "Parse the file on several threads, for the loaders supporting it"))
+  , d_binaryCache(initData(&d_binaryCache, false, "binaryCache", "Keep the loaded mesh in a binary cache file, reused while the file and the loader parameters are unchanged"))
+  , d_cacheDirectory(initData(&d_cacheDirectory, "cacheDirectory", "Directory of the binary cache files (default: the directory of the loaded file)"))
   , d_previousTransformation( Matrix4::s_identity )
 {
     addAlias(&d_tetrahedra, "tetras");
@@ -82,6 +95,9 @@ MeshLoader::MeshLoader() : BaseLoader()
     d_scale.setAutoLink(false);
     d_transformation.setAutoLink(false);
     d_transformation.setDirtyValue();
+    d_parallelParsing.setAutoLink(false);
+    d_binaryCache.setAutoLink(false);
+    d_cacheDirectory.setAutoLink(false);
 
     d_positions.setPersistent(false);
     d_polylines.setPersistent(false);
@@ -135,7 +151,7 @@ void MeshLoader::parse(sofa::core::objectmodel::BaseObjectDescription* arg)
 
     bool success = false;
     if (canLoad())
-        success = load(/*m_filename.getFullPath().c_str()*/);
+        success = loadWithCache();
 
     // File not loaded, component is set to invalid
     if (!success)
@@ -901,6 +917,292 @@ void MeshLoader::copyMeshToData(sofa::helper::io::Mesh* _mesh)
 
 }
 
+
+namespace
+{
+
+const char meshCacheMagic[8] = { 'S', 'O', 'F', 'A', 'M', 'S', 'H', 'C' };
+const std::uint32_t meshCacheVersion = 1;
+
+enum MeshCacheEntryKind { RAW_VALUES = 0, TEXT_VALUE = 1 };
+
+bool getFileStatus(const std::string& filename, std::uint64_t& size, std::int64_t& modificationTime)
+{
+    struct stat status;
+    if (stat(filename.c_str(), &status) != 0)
+        return false;
+    size = std::uint64_t(status.st_size);
+    modificationTime = std::int64_t(status.st_mtime);
+    return true;
+}
+
+bool getFileHash(const std::string& filename, std::uint64_t& hash)
+{
+    helper::io::MappedFile file;
+    if (!file.open(filename))
+        return false;
+    hash = helper::io::text::hashBytes(file.begin(), file.size());
+    return true;
+}
+
+/// Vectors of fixed size elements are stored as raw memory, the other types as text.
+bool isStoredAsRawValues(const defaulttype::AbstractTypeInfo* info)
+{
+    return info->ValidInfo() && info->Container() && !info->FixedSize() && !info->Text()
+            && info->SimpleLayout() && info->BaseType()->FixedSize() && info->BaseType()->SimpleCopy();
+}
+
+template<class T>
+void put(std::string& out, const T& value)
+{
+    out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+void putString(std::string& out, const std::string& value)
+{
+    put<std::uint32_t>(out, std::uint32_t(value.size()));
+    out.append(value);
+}
+
+struct CacheReader
+{
+    const char* p;
+    const char* end;
+
+    template<class T>
+    bool get(T& value)
+    {
+        if (std::size_t(end - p) < sizeof(T))
+            return false;
+        std::memcpy(&value, p, sizeof(T));
+        p += sizeof(T);
+        return true;
+    }
+
+    bool getBytes(std::uint64_t size, const char*& bytes)
+    {
+        if (std::uint64_t(end - p) < size)
+            return false;
+        bytes = p;
+        p += size;
+        return true;
+    }
+
+    bool getString(std::string& value)
+    {
+        std::uint32_t size = 0;
+        const char* bytes = nullptr;
+        if (!get(size) || !getBytes(size, bytes))
+            return false;
+        value.assign(bytes, size);
+        return true;
+    }
+};
+
+} // anonymous namespace
+
+bool MeshLoader::loadWithCache()
+{
+    if (!d_binaryCache.getValue())
+        return load();
+
+    // The cache key covers the file and every parameter set on the loader
+    std::ostringstream parameters;
+    parameters << getClassName() << '\n' << m_filename.getFullPath() << '\n';
+    for (objectmodel::BaseData* data : getDataFields())
+    {
+        if (!data->isSet() || data == &d_parallelParsing || data == &d_binaryCache || data == &d_cacheDirectory
+                || data->getName() == "name" || data->getName() == "printLog")
+            continue;
+        parameters << data->getName() << '=' << data->getValueString() << '\n';
+    }
+    const std::string parametersText = parameters.str();
+    const unsigned long long parametersKey = helper::io::text::hashBytes(parametersText.data(), parametersText.size());
+    const std::string cacheFilename = getCacheFilename(parametersKey);
+
+    if (readCache(cacheFilename, parametersKey))
+    {
+        msg_info() << "Mesh restored from the cache file '" << cacheFilename << "'.";
+        return true;
+    }
+
+    const VecData& fields = getDataFields();
+    const std::size_t nbFields = fields.size();
+    std::vector<int> counters;
+    counters.reserve(nbFields);
+    for (objectmodel::BaseData* data : fields)
+        counters.push_back(data->getCounter());
+
+    if (!load())
+        return false;
+
+    if (getDataFields().size() != nbFields)
+    {
+        msg_info() << "Loading '" << m_filename.getFullPath() << "' created new Data, the mesh is not kept in the cache.";
+        return true;
+    }
+
+    helper::vector<objectmodel::BaseData*> loadedData;
+    for (std::size_t i = 0; i < nbFields; ++i)
+    {
+        objectmodel::BaseData* data = fields[i];
+        if (data->getCounter() != counters[i] && data != &m_filename && data->getParent() == nullptr)
+            loadedData.push_back(data);
+    }
+
+    if (!writeCache(cacheFilename, parametersKey, loadedData))
+    {
+        msg_warning() << "Unable to write the cache file '" << cacheFilename << "'.";
+    }
+    return true;
+}
+
+std::string MeshLoader::getCacheFilename(unsigned long long parametersKey) const
+{
+    const std::string filename = m_filename.getFullPath();
+    std::string directory = d_cacheDirectory.getValue();
+    if (directory.empty())
+        directory = helper::system::FileSystem::getParentDirectory(filename);
+    if (directory.empty())
+        directory = ".";
+
+    std::ostringstream cacheFilename;
+    cacheFilename << directory << '/' << helper::system::FileSystem::stripDirectory(filename)
+                  << '.' << std::hex << std::setw(16) << std::setfill('0') << parametersKey << ".sofacache";
+    return cacheFilename.str();
+}
+
+bool MeshLoader::readCache(const std::string& cacheFilename, unsigned long long parametersKey)
+{
+    helper::io::MappedFile file;
+    if (!file.open(cacheFilename))
+        return false;
+
+    CacheReader in = { file.begin(), file.end() };
+    const char* magic = nullptr;
+    std::uint32_t version = 0;
+    std::uint64_t key = 0, sourceSize = 0, sourceHash = 0;
+    std::int64_t sourceTime = 0;
+    std::uint32_t nbEntries = 0;
+    if (!in.getBytes(sizeof(meshCacheMagic), magic) || std::memcmp(magic, meshCacheMagic, sizeof(meshCacheMagic)) != 0
+            || !in.get(version) || version != meshCacheVersion
+            || !in.get(key) || key != parametersKey
+            || !in.get(sourceSize) || !in.get(sourceTime) || !in.get(sourceHash) || !in.get(nbEntries))
+        return false;
+
+    // The content is only hashed again when the file was touched since the cache was written
+    const std::string filename = m_filename.getFullPath();
+    std::uint64_t size = 0, hash = 0;
+    std::int64_t time = 0;
+    if (!getFileStatus(filename, size, time) || size != sourceSize)
+        return false;
+    if (time != sourceTime && (!getFileHash(filename, hash) || hash != sourceHash))
+        return false;
+
+    struct Entry
+    {
+        objectmodel::BaseData* data;
+        std::uint8_t kind;
+        std::uint64_t count;
+        std::uint64_t byteLength;
+        const char* bytes;
+    };
+    std::vector<Entry> entries(nbEntries);
+    for (Entry& entry : entries)
+    {
+        std::string name, typeName;
+        std::uint64_t valueSize = 0;
+        if (!in.getString(name) || !in.getString(typeName) || !in.get(entry.kind) || !in.get(valueSize)
+                || !in.get(entry.count) || !in.get(entry.byteLength) || !in.getBytes(entry.byteLength, entry.bytes))
+            return false;
+
+        entry.data = findData(name);
+        if (entry.data == nullptr)
+            return false;
+        const defaulttype::AbstractTypeInfo* info = entry.data->getValueTypeInfo();
+        if (info->name() != typeName)
+            return false;
+        if (entry.kind == RAW_VALUES && (!isStoredAsRawValues(info) || valueSize != info->byteSize()
+                                         || entry.byteLength != entry.count * valueSize))
+            return false;
+    }
+
+    for (const Entry& entry : entries)
+    {
+        if (entry.kind == RAW_VALUES)
+        {
+            const defaulttype::AbstractTypeInfo* info = entry.data->getValueTypeInfo();
+            void* value = entry.data->beginEditVoidPtr();
+            info->setSize(value, std::size_t(entry.count));
+            if (entry.count > 0)
+                std::memcpy(info->getValuePtr(value), entry.bytes, std::size_t(entry.byteLength));
+            entry.data->endEditVoidPtr();
+        }
+        else
+        {
+            entry.data->read(std::string(entry.bytes, std::size_t(entry.byteLength)));
+        }
+    }
+    return true;
+}
+
+bool MeshLoader::writeCache(const std::string& cacheFilename, unsigned long long parametersKey,
+                            const helper::vector<objectmodel::BaseData*>& loadedData)
+{
+    const std::string filename = m_filename.getFullPath();
+    std::uint64_t size = 0, hash = 0;
+    std::int64_t time = 0;
+    if (!getFileStatus(filename, size, time) || !getFileHash(filename, hash))
+        return false;
+
+    std::string out;
+    out.append(meshCacheMagic, sizeof(meshCacheMagic));
+    put<std::uint32_t>(out, meshCacheVersion);
+    put<std::uint64_t>(out, parametersKey);
+    put<std::uint64_t>(out, size);
+    put<std::int64_t>(out, time);
+    put<std::uint64_t>(out, hash);
+    put<std::uint32_t>(out, std::uint32_t(loadedData.size()));
+
+    for (objectmodel::BaseData* data : loadedData)
+    {
+        const defaulttype::AbstractTypeInfo* info = data->getValueTypeInfo();
+        putString(out, data->getName());
+        putString(out, info->name());
+        if (isStoredAsRawValues(info))
+        {
+            const void* value = data->getValueVoidPtr();
+            const std::uint64_t count = info->size(value);
+            const std::uint64_t byteLength = count * info->byteSize();
+            put<std::uint8_t>(out, RAW_VALUES);
+            put<std::uint64_t>(out, info->byteSize());
+            put<std::uint64_t>(out, count);
+            put<std::uint64_t>(out, byteLength);
+            if (count > 0)
+                out.append(static_cast<const char*>(info->getValuePtr(value)), std::size_t(byteLength));
+        }
+        else
+        {
+            const std::string text = data->getValueString();
+            put<std::uint8_t>(out, TEXT_VALUE);
+            put<std::uint64_t>(out, 1);
+            put<std::uint64_t>(out, 1);
+            put<std::uint64_t>(out, text.size());
+            out.append(text);
+        }
+    }
+
+    // Written aside and renamed, so that a concurrent run never reads a partial cache
+    const std::string temporaryFilename = cacheFilename + ".tmp";
+    {
+        std::ofstream file(temporaryFilename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!file.is_open() || !file.write(out.data(), std::streamsize(out.size())))
+            return false;
+    }
+    std::remove(cacheFilename.c_str());
+    return std::rename(temporaryFilename.c_str(), cacheFilename.c_str()) == 0;
+}
+
 } // namespace loader
 
 } // namespace core
@@ -180,6 +180,10 @@ public:
     Data< Vec3 > d_scale; ///< Scale of the DOFs in 3 dimensions
     Data< defaulttype::Matrix4 > d_transformation; ///< 4x4 Homogeneous matrix to transform the DOFs (when present replace any)
 
+    Data< bool > d_parallelParsing; ///< Parse the file on several threads, for the loaders supporting it
+    Data< bool > d_binaryCache; ///< Keep the loaded mesh in a binary cache file, reused while the file and the loader parameters are unchanged
+    Data< std::string > d_cacheDirectory; ///< Directory of the binary cache files (default: the directory of the loaded file)
+
 
     virtual void updateMesh();
     virtual void updateElements();
@@ -227,6 +231,18 @@ protected:
 
     /// Temporary method that will copy all buffers from a io::Mesh into the corresponding Data. Will be removed as soon as work on unifying meshloader is finished
     void copyMeshToData(helper::io::Mesh* _mesh);
+
+    /// @name Binary cache of the loaded Data.
+    /// The cache stores the Data modified by load() and is keyed by the file, its size, its modification
+    /// time and content hash, and the values of the loader parameters.
+    /// @{
+    /// Call load(), or restore the loaded Data from the cache when it is enabled and up to date.
+    bool loadWithCache();
+    std::string getCacheFilename(unsigned long long parametersKey) const;
+    bool readCache(const std::string& cacheFilename, unsigned long long parametersKey);
+    bool writeCache(const std::string& cacheFilename, unsigned long long parametersKey,
+                    const helper::vector<objectmodel::BaseData*>& loadedData);
+    /// @}
 };
 
 
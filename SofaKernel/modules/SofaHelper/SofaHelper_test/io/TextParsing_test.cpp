@@ -0,0 +1,130 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2019 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#include <sofa/helper/io/TextParsing.h>
+
+#include <sofa/helper/testing/BaseTest.h>
+using sofa::helper::testing::BaseTest ;
+
+#include <cstring>
+#include <locale>
+#include <sstream>
+
+namespace sofa {
+
+using namespace helper::io;
+
+class TextParsing_test : public BaseTest
+{
+protected:
+    /// Parse the string with text::parseValue and with the stream operator, and compare.
+    template<class T>
+    void checkSameAsStream(const std::string& s)
+    {
+        const char* p = s.c_str();
+        T value = T();
+        const bool parsed = text::parseValue(p, s.c_str() + s.size(), value);
+
+        std::istringstream in(s);
+        in.imbue(std::locale::classic());
+        T expected = T();
+        in >> expected;
+
+        EXPECT_EQ(bool(in), parsed) << s;
+        if (parsed)
+        {
+            EXPECT_EQ(expected, value) << s;
+        }
+    }
+};
+
+TEST_F(TextParsing_test, parseDoubleAsStream)
+{
+    for (const char* s : { "0", "1", "-1", "+2.5", "3.14159265358979", "1e10", "-1.5E-7", "0.1",
+                           "123456789012345678901234567890", "1e-320", "1e400", ".5", "5.", "  42.25 ",
+                           "\t-0.0", "1.7976931348623157e308", "2.2250738585072014e-308", "x", "", "-" })
+        checkSameAsStream<double>(s);
+}
+
+TEST_F(TextParsing_test, parseFloatAsStream)
+{
+    for (const char* s : { "0", "-1", "0.1", "3.4028235e38", "1e-40", "16777217", "1.17549435e-38", "abc" })
+        checkSameAsStream<float>(s);
+}
+
+TEST_F(TextParsing_test, parseIntegerAsStream)
+{
+    for (const char* s : { "0", "42", "-42", "+7", "2147483647", "-2147483648", "2147483648", "12abc", "a" })
+    {
+        checkSameAsStream<int>(s);
+        checkSameAsStream<long long>(s);
+    }
+    for (const char* s : { "0", "4294967295", "4294967296", "65535", "65536" })
+    {
+        checkSameAsStream<unsigned int>(s);
+        checkSameAsStream<unsigned short>(s);
+    }
+}
+
+TEST_F(TextParsing_test, parseStopsAtEndOfLine)
+{
+    const std::string s = "1.5 2\n3";
+    const char* p = s.c_str();
+    const char* end = p + s.size();
+    double a = 0, b = 0, c = 0;
+    EXPECT_TRUE(text::parseValue(p, end, a));
+    EXPECT_TRUE(text::parseValue(p, end, b));
+    EXPECT_FALSE(text::parseValue(p, end, c));
+    EXPECT_EQ(1.5, a);
+    EXPECT_EQ(2.0, b);
+    EXPECT_EQ('\n', *p);
+}
+
+TEST_F(TextParsing_test, splitLines)
+{
+    const std::string s = "v 1 2 3\nv 4 5 6\nf 1 2 3\n\nv 7 8 9";
+    const char* begin = s.c_str();
+    const char* end = begin + s.size();
+    for (std::size_t nbChunks : { 1u, 2u, 3u, 100u })
+    {
+        const std::vector<const char*> bounds = text::splitLines(begin, end, nbChunks);
+        ASSERT_GE(bounds.size(), 2u);
+        EXPECT_LE(bounds.size(), nbChunks + 1);
+        EXPECT_EQ(begin, bounds.front());
+        EXPECT_EQ(end, bounds.back());
+        for (std::size_t i = 1; i + 1 < bounds.size(); ++i)
+        {
+            EXPECT_LT(bounds[i-1], bounds[i]);
+            EXPECT_EQ('\n', bounds[i][-1]);
+        }
+    }
+}
+
+TEST_F(TextParsing_test, hashBytes)
+{
+    const char a[] = "some file content";
+    const char b[] = "some file contenT";
+    EXPECT_EQ(text::hashBytes(a, std::strlen(a)), text::hashBytes(a, std::strlen(a)));
+    EXPECT_NE(text::hashBytes(a, std::strlen(a)), text::hashBytes(b, std::strlen(b)));
+    EXPECT_NE(text::hashBytes(a, std::strlen(a), 1), text::hashBytes(a, std::strlen(a), 2));
+}
+
+} // namespace sofa
@@ -21,6 +21,7 @@
 ******************************************************************************/
 #define SOFA_HELPER_ADVANCEDTIMER_CPP
 #include <sofa/helper/AdvancedTimer.h>
+#include <sofa/helper/TraceRecorder.h>
 
 #include <sofa/helper/system/thread/CTime.h>
 #include <sofa/helper/vector.h>
@@ -359,6 +360,7 @@ bool AdvancedTimer::isActive()
 
 void AdvancedTimer::stepBegin(IdStep id)
 {
+    if (TraceRecorder::isEnabled()) TraceRecorder::beginStep(id);
     helper::vector<Record>* curRecords = getCurRecords();
     if (!curRecords) return;
     Record r;
@@ -370,6 +372,7 @@ void AdvancedTimer::stepBegin(IdStep id)
 
 void AdvancedTimer::stepBegin(IdStep id, IdObj obj)
 {
+    if (TraceRecorder::isEnabled()) TraceRecorder::beginStep(id);
     helper::vector<Record>* curRecords = getCurRecords();
     if (!curRecords) return;
     Record r;
@@ -382,6 +385,7 @@ void AdvancedTimer::stepBegin(IdStep id, IdObj obj)
 
 void AdvancedTimer::stepEnd  (IdStep id)
 {
+    if (TraceRecorder::isEnabled()) TraceRecorder::endStep(id);
     helper::vector<Record>* curRecords = getCurRecords();
     if (!curRecords) return;
     if (syncCallBack) (*syncCallBack)(syncCallBackData);
@@ -394,6 +398,7 @@ void AdvancedTimer::stepEnd  (IdStep id)
 
 void AdvancedTimer::stepEnd  (IdStep id, IdObj obj)
 {
+    if (TraceRecorder::isEnabled()) TraceRecorder::endStep(id);
     helper::vector<Record>* curRecords = getCurRecords();
     if (!curRecords) return;
     Record r;
@@ -406,6 +411,11 @@ void AdvancedTimer::stepEnd  (IdStep id, IdObj obj)
 
 void AdvancedTimer::stepNext (IdStep prevId, IdStep nextId)
 {
+    if (TraceRecorder::isEnabled())
+    {
+        TraceRecorder::endStep(prevId);
+        TraceRecorder::beginStep(nextId);
+    }
     helper::vector<Record>* curRecords = getCurRecords();
     if (!curRecords) return;
     Record r;
@@ -421,6 +431,7 @@ void AdvancedTimer::stepNext (IdStep prevId, IdStep nextId)
 
 void AdvancedTimer::step     (IdStep id)
 {
+    if (TraceRecorder::isEnabled()) TraceRecorder::instantStep(id);
     helper::vector<Record>* curRecords = getCurRecords();
     if (!curRecords) return;
     if (syncCallBack) (*syncCallBack)(syncCallBackData);
@@ -433,6 +444,7 @@ void AdvancedTimer::step     (IdStep id)
 
 void AdvancedTimer::step     (IdStep id, IdObj obj)
 {
+    if (TraceRecorder::isEnabled()) TraceRecorder::instantStep(id);
     helper::vector<Record>* curRecords = getCurRecords();
     if (!curRecords) return;
     if (syncCallBack) (*syncCallBack)(syncCallBackData);
@@ -483,70 +495,115 @@ void AdvancedTimer::end(const char* idStr)
 void AdvancedTimer::stepBegin(const char* idStr)
 {
     helper::vector<Record>* curRecords = getCurRecords();
-    if (!curRecords) return;
+    if (!curRecords)
+    {
+        // the ids are only created when a timer is active, the trace records the string
+        if (TraceRecorder::isEnabled()) TraceRecorder::begin(idStr);
+        return;
+    }
     stepBegin(IdStep(idStr));
 }
 
 void AdvancedTimer::stepBegin(const char* idStr, const char* objStr)
 {
     helper::vector<Record>* curRecords = getCurRecords();
-    if (!curRecords) return;
+    if (!curRecords)
+    {
+        if (TraceRecorder::isEnabled()) TraceRecorder::begin(idStr);
+        return;
+    }
     stepBegin(IdStep(idStr), IdObj(objStr));
 }
 
 void AdvancedTimer::stepBegin(const char* idStr, const std::string& objStr)
 {
     helper::vector<Record>* curRecords = getCurRecords();
-    if (!curRecords) return;
+    if (!curRecords)
+    {
+        if (TraceRecorder::isEnabled()) TraceRecorder::begin(idStr);
+        return;
+    }
     stepBegin(IdStep(idStr), IdObj(objStr));
 }
 
 void AdvancedTimer::stepEnd  (const char* idStr)
 {
     helper::vector<Record>* curRecords = getCurRecords();
-    if (!curRecords) return;
+    if (!curRecords)
+    {
+        if (TraceRecorder::isEnabled()) TraceRecorder::end(idStr);
+        return;
+    }
     stepEnd  (IdStep(idStr));
 }
 
 void AdvancedTimer::stepEnd  (const char* idStr, const char* objStr)
 {
     helper::vector<Record>* curRecords = getCurRecords();
-    if (!curRecords) return;
+    if (!curRecords)
+    {
+        if (TraceRecorder::isEnabled()) TraceRecorder::end(idStr);
+        return;
+    }
     stepEnd  (IdStep(idStr), IdObj(objStr));
 }
 
 void AdvancedTimer::stepEnd  (const char* idStr, const std::string& objStr)
 {
     helper::vector<Record>* curRecords = getCurRecords();
-    if (!curRecords) return;
+    if (!curRecords)
+    {
+        if (TraceRecorder::isEnabled()) TraceRecorder::end(idStr);
+        return;
+    }
     stepEnd  (IdStep(idStr), IdObj(objStr));
 }
 
 void AdvancedTimer::stepNext (const char* prevIdStr, const char* nextIdStr)
 {
     helper::vector<Record>* curRecords = getCurRecords();
-    if (!curRecords) return;
+    if (!curRecords)
+    {
+        if (TraceRecorder::isEnabled())
+        {
+            TraceRecorder::end(prevIdStr);
+            TraceRecorder::begin(nextIdStr);
+        }
+        return;
+    }
     stepNext (IdStep(prevIdStr), IdStep(nextIdStr));
 }
 
 void AdvancedTimer::step     (const char* idStr)
 {
     helper::vector<Record>* curRecords = getCurRecords();
-    if (!curRecords) return;
+    if (!curRecords)
+    {
+        if (TraceRecorder::isEnabled()) TraceRecorder::instant(idStr);
+        return;
+    }
     step     (IdStep(idStr));
 }
 
 void AdvancedTimer::step     (const char* idStr, const char* objStr)
 {
     helper::vector<Record>* curRecords = getCurRecords();
-    if (!curRecords) return;
+    if (!curRecords)
+    {
+        if (TraceRecorder::isEnabled()) TraceRecorder::instant(idStr);
+        return;
+    }
     step     (IdStep(idStr), IdObj(objStr));
 }
 
 void AdvancedTimer::step     (const char* idStr, const std::string& objStr)
 {
     helper::vector<Record>* curRecords = getCurRecords();
-    if (!curRecords) return;
+    if (!curRecords)
+    {
+        if (TraceRecorder::isEnabled()) TraceRecorder::instant(idStr);
+        return;
+    }
     step     (IdStep(idStr), IdObj(objStr));
 }
 
@@ -0,0 +1,372 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2019 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#include <sofa/helper/TraceRecorder.h>
+#include <sofa/helper/AdvancedTimer.h>
+#include <sofa/helper/system/thread/thread_specific_ptr.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define SOFA_TRACE_RECORDER_TSC
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#endif
+
+
+namespace sofa
+{
+
+namespace helper
+{
+
+std::atomic<bool> TraceRecorder::s_enabled(false);
+
+namespace
+{
+
+typedef std::uint64_t TraceTime;
+
+/// Time stamp counter when available, converted when the trace is written.
+/// CTime::getFastTime is not used as it only has a microsecond resolution without SOFA_RDTSC.
+inline TraceTime now()
+{
+#ifdef SOFA_TRACE_RECORDER_TSC
+    return __rdtsc();
+#else
+    return TraceTime(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+}
+
+struct TraceEvent
+{
+    TraceTime time;
+    unsigned int name;
+    char phase; ///< 'B', 'E' or 'i' as in the Chrome trace event format
+};
+
+/// Ring buffer of the events of one thread, allocated by its first event.
+/// Only its thread writes the events and adds the names, the names are read by the writer under the mutex.
+struct ThreadBuffer
+{
+    ThreadBuffer()
+        : mask(0)
+        , count(0)
+    {
+    }
+
+    std::unique_ptr<TraceEvent[]> events;
+    std::size_t mask;
+    std::atomic<std::uint64_t> count; ///< number of events recorded since the last clear
+
+    std::mutex namesMutex;
+    std::vector<std::string> names;
+    std::map<std::string, unsigned int> nameIds;
+    std::string threadName;
+
+    /// Last name index found for each string address, to avoid the map lookup for string literals
+    struct CachedName
+    {
+        const char* str = nullptr;
+        unsigned int name = 0;
+    };
+    CachedName cache[256];
+
+    /// Name index + 1 of the AdvancedTimer step ids of this thread, 0 if not known yet
+    std::vector<unsigned int> stepNames;
+
+    unsigned int intern(const std::string& str)
+    {
+        std::lock_guard<std::mutex> lock(namesMutex);
+        auto it = nameIds.find(str);
+        if (it != nameIds.end())
+            return it->second;
+        const unsigned int name = (unsigned int)names.size();
+        names.push_back(str);
+        nameIds[str] = name;
+        return name;
+    }
+
+    unsigned int nameOf(const char* str)
+    {
+        CachedName& cached = cache[(reinterpret_cast<std::uintptr_t>(str) >> 3) & 255];
+        if (str && cached.str == str && std::strcmp(names[cached.name].c_str(), str) == 0)
+            return cached.name;
+        cached.name = intern(str ? std::string(str) : std::string());
+        cached.str = str;
+        return cached.name;
+    }
+
+    unsigned int nameOfStep(unsigned int stepId)
+    {
+        if (stepId < stepNames.size() && stepNames[stepId])
+            return stepNames[stepId] - 1;
+        // the ids of the steps are specific to each thread
+        const unsigned int name = intern(AdvancedTimer::IdStep::IdFactory::getName(stepId));
+        if (stepId >= stepNames.size())
+            stepNames.resize(stepId + 1, 0);
+        stepNames[stepId] = name + 1;
+        return name;
+    }
+
+    void allocate();
+
+    void record(unsigned int name, char phase)
+    {
+        if (!events)
+            allocate();
+        const std::uint64_t i = count.load(std::memory_order_relaxed);
+        TraceEvent& e = events[i & mask];
+        e.time = now();
+        e.name = name;
+        e.phase = phase;
+        count.store(i + 1, std::memory_order_release);
+    }
+};
+
+struct TraceRegistry
+{
+    std::mutex mutex;
+    std::vector< std::unique_ptr<ThreadBuffer> > buffers; ///< kept after the end of their thread, to be written
+    std::size_t bufferSize = std::size_t(1) << 16;
+    const TraceTime origin = now();
+    const std::chrono::steady_clock::time_point steadyOrigin = std::chrono::steady_clock::now();
+
+    /// Conversion of the times to microseconds, measured since the origin
+    double microsecondsPerTick() const
+    {
+#ifdef SOFA_TRACE_RECORDER_TSC
+        const double elapsed = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - steadyOrigin).count();
+        const TraceTime ticks = now() - origin;
+        return (ticks > 0 && elapsed > 0) ? elapsed / double(ticks) : 0.0;
+#else
+        return 1e-3;
+#endif
+    }
+};
+
+TraceRegistry& getRegistry()
+{
+    static TraceRegistry registry;
+    return registry;
+}
+
+void ThreadBuffer::allocate()
+{
+    TraceRegistry& registry = getRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    events.reset(new TraceEvent[registry.bufferSize]);
+    mask = registry.bufferSize - 1;
+}
+
+ThreadBuffer* getThreadBuffer()
+{
+    SOFA_THREAD_SPECIFIC_PTR(ThreadBuffer, buffer);
+    if (buffer == nullptr)
+    {
+        TraceRegistry& registry = getRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        ThreadBuffer* b = new ThreadBuffer;
+        registry.buffers.emplace_back(b);
+        buffer = b;
+    }
+    return buffer;
+}
+
+void writeJsonString(std::ostream& out, const std::string& str)
+{
+    out << '"';
+    for (const char c : str)
+    {
+        switch (c)
+        {
+        case '"': out << "\\\""; break;
+        case '\\': out << "\\\\"; break;
+        case '\n': out << "\\n"; break;
+        case '\t': out << "\\t"; break;
+        case '\r': out << "\\r"; break;
+        default:
+            if ((unsigned char)c < 0x20)
+                out << "\\u" << std::hex << std::setw(4) << std::setfill('0') << int(c) << std::dec << std::setfill(' ');
+            else
+                out << c;
+        }
+    }
+    out << '"';
+}
+
+} // anonymous namespace
+
+void TraceRecorder::setEnabled(bool enabled)
+{
+    if (enabled)
+        getRegistry(); // the origin of the times
+    s_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+void TraceRecorder::setBufferSize(std::size_t nbEvents)
+{
+    std::size_t size = 16;
+    while (size < nbEvents)
+        size *= 2;
+    TraceRegistry& registry = getRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    registry.bufferSize = size;
+}
+
+std::size_t TraceRecorder::getBufferSize()
+{
+    TraceRegistry& registry = getRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    return registry.bufferSize;
+}
+
+void TraceRecorder::setThreadName(const std::string& name)
+{
+    ThreadBuffer* buffer = getThreadBuffer();
+    std::lock_guard<std::mutex> lock(buffer->namesMutex);
+    buffer->threadName = name;
+}
+
+void TraceRecorder::begin(const char* name)
+{
+    ThreadBuffer* buffer = getThreadBuffer();
+    buffer->record(buffer->nameOf(name), 'B');
+}
+
+void TraceRecorder::end(const char* name)
+{
+    ThreadBuffer* buffer = getThreadBuffer();
+    buffer->record(buffer->nameOf(name), 'E');
+}
+
+void TraceRecorder::instant(const char* name)
+{
+    ThreadBuffer* buffer = getThreadBuffer();
+    buffer->record(buffer->nameOf(name), 'i');
+}
+
+void TraceRecorder::beginStep(unsigned int stepId)
+{
+    ThreadBuffer* buffer = getThreadBuffer();
+    buffer->record(buffer->nameOfStep(stepId), 'B');
+}
+
+void TraceRecorder::endStep(unsigned int stepId)
+{
+    ThreadBuffer* buffer = getThreadBuffer();
+    buffer->record(buffer->nameOfStep(stepId), 'E');
+}
+
+void TraceRecorder::instantStep(unsigned int stepId)
+{
+    ThreadBuffer* buffer = getThreadBuffer();
+    buffer->record(buffer->nameOfStep(stepId), 'i');
+}
+
+void TraceRecorder::clear()
+{
+    TraceRegistry& registry = getRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    for (auto& buffer : registry.buffers)
+        buffer->count.store(0, std::memory_order_relaxed);
+}
+
+void TraceRecorder::writeChromeTrace(std::ostream& out)
+{
+    TraceRegistry& registry = getRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+
+    const std::ios_base::fmtflags flags = out.flags();
+    const std::streamsize precision = out.precision();
+    out << std::fixed << std::setprecision(3);
+    const double microsecondsPerTick = registry.microsecondsPerTick();
+
+    out << "{\"traceEvents\":[";
+    bool first = true;
+    for (std::size_t t = 0; t < registry.buffers.size(); ++t)
+    {
+        ThreadBuffer& buffer = *registry.buffers[t];
+        std::lock_guard<std::mutex> namesLock(buffer.namesMutex);
+        const std::size_t tid = t + 1;
+
+        out << (first ? "\n" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << tid << ",\"args\":{\"name\":";
+        writeJsonString(out, buffer.threadName.empty() ? "Thread " + std::to_string(tid) : buffer.threadName);
+        out << "}}";
+        first = false;
+
+        const std::uint64_t count = buffer.events ? buffer.count.load(std::memory_order_acquire) : 0;
+        const std::uint64_t size = std::min<std::uint64_t>(count, buffer.mask + 1);
+        int depth = 0;
+        for (std::uint64_t i = count - size; i < count; ++i)
+        {
+            const TraceEvent& e = buffer.events[i & buffer.mask];
+            // the beginning of the spans may have been overwritten
+            if (e.phase == 'E')
+            {
+                if (depth == 0)
+                    continue;
+                --depth;
+            }
+            else if (e.phase == 'B')
+            {
+                ++depth;
+            }
+
+            out << ",\n{\"name\":";
+            writeJsonString(out, e.name < buffer.names.size() ? buffer.names[e.name] : std::string());
+            out << ",\"ph\":\"" << e.phase << "\",\"ts\":" << double(std::int64_t(e.time - registry.origin)) * microsecondsPerTick << ",\"pid\":1,\"tid\":" << tid;
+            if (e.phase == 'i')
+                out << ",\"s\":\"t\"";
+            out << "}";
+        }
+    }
+    out << "\n],\"displayTimeUnit\":\"ms\"}\n";
+
+    out.flags(flags);
+    out.precision(precision);
+}
+
+bool TraceRecorder::writeChromeTrace(const std::string& filename)
+{
+    std::ofstream out(filename.c_str());
+    if (!out.good())
+        return false;
+    writeChromeTrace(out);
+    return out.good();
+}
+
+} // namespace helper
+
+} // namespace sofa
@@ -0,0 +1,95 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2019 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#ifndef SOFA_HELPER_TRACERECORDER_H
+#define SOFA_HELPER_TRACERECORDER_H
+#include <sofa/helper/helper.h>
+
+#include <atomic>
+#include <iosfwd>
+#include <string>
+
+
+namespace sofa
+{
+
+namespace helper
+{
+
+/**
+  Low overhead recorder of timelines, one per thread, which can be written as a Chrome trace
+  (JSON trace event format, opened by chrome://tracing and the Perfetto UI).
+
+  When enabled, AdvancedTimer steps are recorded on the timeline of the thread calling
+  stepBegin/stepEnd, even if no AdvancedTimer is active, and the tasks run by the
+  DefaultTaskScheduler are recorded on the timelines of its worker threads.
+
+  Usage example :
+
+    TraceRecorder::setEnabled(true);
+    ... // simulation steps
+    TraceRecorder::writeChromeTrace("trace.json");
+
+  Each thread writes in its own ring buffer without any lock: when a buffer is full, its oldest
+  events are overwritten. Only the first use of a name on a thread takes a lock.
+  The trace should be written while the recorded threads are not recording.
+ */
+class SOFA_HELPER_API TraceRecorder
+{
+public:
+    static bool isEnabled() { return s_enabled.load(std::memory_order_relaxed); }
+    static void setEnabled(bool enabled);
+
+    /// Number of events kept per thread, rounded up to a power of two. Only applies to the threads recording for the first time.
+    static void setBufferSize(std::size_t nbEvents);
+    static std::size_t getBufferSize();
+
+    /// Name of the timeline of the calling thread
+    static void setThreadName(const std::string& name);
+
+    /// Begin a span named by a null terminated string on the calling thread
+    static void begin(const char* name);
+    /// End the span begun with the same name on the calling thread
+    static void end(const char* name);
+    /// Record an instant event on the calling thread
+    static void instant(const char* name);
+
+    /// Same as begin, end and instant, for an id of AdvancedTimer::IdStep
+    static void beginStep(unsigned int stepId);
+    static void endStep(unsigned int stepId);
+    static void instantStep(unsigned int stepId);
+
+    /// Remove the recorded events of all the threads
+    static void clear();
+
+    /// Write the recorded events in the Chrome trace event format
+    static void writeChromeTrace(std::ostream& out);
+    static bool writeChromeTrace(const std::string& filename);
+
+protected:
+    static std::atomic<bool> s_enabled;
+};
+
+} // namespace helper
+
+} // namespace sofa
+
+#endif // SOFA_HELPER_TRACERECORDER_H
@@ -0,0 +1,132 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2019 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#include <sofa/helper/io/MappedFile.h>
+#include <sofa/helper/system/config.h>
+
+#ifndef WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <fstream>
+
+namespace sofa
+{
+
+namespace helper
+{
+
+namespace io
+{
+
+MappedFile::MappedFile()
+    : m_data(nullptr)
+    , m_size(0)
+    , m_mapped(false)
+    , m_opened(false)
+{
+}
+
+MappedFile::MappedFile(const std::string& filename, AccessPattern pattern)
+    : MappedFile()
+{
+    open(filename, pattern);
+}
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+void MappedFile::close()
+{
+#ifndef WIN32
+    if (m_mapped)
+        munmap(const_cast<char*>(m_data), m_size);
+#endif
+    m_data = nullptr;
+    m_size = 0;
+    m_mapped = false;
+    m_opened = false;
+    std::vector<char>().swap(m_buffer);
+}
+
+bool MappedFile::open(const std::string& filename, AccessPattern pattern)
+{
+    close();
+    SOFA_UNUSED(pattern);
+
+#ifndef WIN32
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode))
+    {
+        ::close(fd);
+        return false;
+    }
+    if (st.st_size > 0)
+    {
+        void* p = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p != MAP_FAILED)
+        {
+            m_data = static_cast<const char*>(p);
+            m_size = (size_t)st.st_size;
+            m_mapped = true;
+#if defined(MADV_SEQUENTIAL) && defined(MADV_RANDOM)
+            madvise(p, m_size, (pattern == Random) ? MADV_RANDOM : MADV_SEQUENTIAL);
+#endif
+        }
+    }
+    ::close(fd);
+#endif
+
+    if (!m_mapped)
+    {
+        std::ifstream file(filename.c_str(), std::ifstream::binary | std::ifstream::ate);
+        if (!file.is_open())
+            return false;
+        const std::streamoff size = file.tellg();
+        if (size < 0)
+            return false;
+        m_buffer.resize((size_t)size);
+        file.seekg(0);
+        if (!m_buffer.empty() && !file.read(m_buffer.data(), m_buffer.size()))
+        {
+            m_buffer.clear();
+            return false;
+        }
+        m_data = m_buffer.data();
+        m_size = m_buffer.size();
+    }
+    m_opened = true;
+    return true;
+}
+
+} // namespace io
+
+} // namespace helper
+
+} // namespace sofa
@@ -0,0 +1,79 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2019 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#ifndef SOFA_HELPER_IO_MAPPEDFILE_H
+#define SOFA_HELPER_IO_MAPPEDFILE_H
+
+#include <sofa/helper/helper.h>
+
+#include <string>
+#include <vector>
+
+namespace sofa
+{
+
+namespace helper
+{
+
+namespace io
+{
+
+/// \brief Read-only view of the whole content of a file.
+///
+/// The file is memory mapped when the platform allows it, otherwise it is
+/// read at once into a buffer owned by this object.
+class SOFA_HELPER_API MappedFile
+{
+public:
+    /// Expected order of the reads, used to advise the system on the pages to load ahead
+    enum AccessPattern { Sequential, Random };
+
+    MappedFile();
+    explicit MappedFile(const std::string& filename, AccessPattern pattern = Sequential);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const std::string& filename, AccessPattern pattern = Sequential);
+    void close();
+
+    bool isOpen() const { return m_opened; }
+
+    const char* begin() const { return m_data; }
+    const char* end() const { return m_data + m_size; }
+    std::size_t size() const { return m_size; }
+
+private:
+    const char* m_data;
+    std::size_t m_size;
+    bool m_mapped;
+    bool m_opened;
+    std::vector<char> m_buffer;
+};
+
+} // namespace io
+
+} // namespace helper
+
+} // namespace sofa
+
+#endif // SOFA_HELPER_IO_MAPPEDFILE_H
@@ -21,6 +21,8 @@
 ******************************************************************************/
 #include <sofa/helper/io/File.h>
 #include <sofa/helper/io/MeshGmsh.h>
+#include <sofa/helper/io/MappedFile.h>
+#include <sofa/helper/io/TextParsing.h>
 #include <sofa/helper/system/FileRepository.h>
 #include <sofa/helper/system/SetDirectory.h>
 #include <sofa/helper/system/Locale.h>
@@ -52,35 +54,29 @@ void MeshGmsh::init (std::string filename)
     }
     loaderType = "gmsh";
 
-    std::ifstream file(filename);
-    if (!file.good()) return;
+    MappedFile file;
+    if (!file.open(filename)) return;
 
     unsigned int gmshFormat = 0;
-    std::string cmd;
+    const char* p = file.begin();
+    const char* end = file.end();
 
     // -- Looking for Gmsh version of this file.
-    std::getline(file, cmd); //Version
-    std::istringstream versionReader(cmd);
-    std::string version;
-    versionReader >> version;
-    if (version == "$MeshFormat") // Reading gmsh 2.0 file
+    const char* line = p;
+    p = text::nextLine(p, end);
+    if (text::readWord(line, p) == "$MeshFormat") // Reading gmsh 2.0 file
     {
         gmshFormat = 2;
-        std::string line;
-        std::getline(file, line); // we don't nedd this line
-        std::getline(file, cmd);
-        std::istringstream endMeshReader(cmd);
-        std::string endMesh;
-        endMeshReader >> endMesh;
-
-        if (endMesh != std::string("$EndMeshFormat")) // it should end with $EndMeshFormat
+        p = text::nextLine(p, end); // we don't nedd this line
+        line = p;
+        p = text::nextLine(p, end);
+        if (text::readWord(line, p) != "$EndMeshFormat") // it should end with $EndMeshFormat
         {
-            file.close();
             return;
         }
         else
         {
-            std::getline(file, cmd); // First Command
+            p = text::nextLine(p, end); // First Command
         }
     }
     else
@@ -88,10 +84,33 @@ void MeshGmsh::init (std::string filename)
         gmshFormat = 1;
     }
 
-    readGmsh(file, gmshFormat);
-    file.close();
+    readGmsh(p, end, gmshFormat);
+}
+
+namespace
+{
+
+/// Next white space separated word, like the stream operator.
+std::string nextWord(const char*& p, const char* end)
+{
+    p = text::skipSpaces(p, end);
+    const char* b = p;
+    p = text::wordEnd(p, end);
+    return std::string(b, p);
 }
 
+/// Next number, like the stream operator: value is left untouched on failure.
+template<class T>
+void nextValue(const char*& p, const char* end, T& value)
+{
+    p = text::skipSpaces(p, end);
+    T v;
+    if (text::parseValue(p, end, v))
+        value = v;
+}
+
+} // anonymous namespace
+
 
 void MeshGmsh::addInGroup(helper::vector< sofa::core::loader::PrimitiveGroup>& group, int tag, int /*eid*/) 
 {
@@ -119,7 +138,7 @@ void MeshGmsh::normalizeGroup(helper::vector< sofa::core::loader::PrimitiveGroup
 }
 
 
-bool MeshGmsh::readGmsh(std::ifstream &file, const unsigned int gmshFormat)
+bool MeshGmsh::readGmsh(const char* p, const char* end, const unsigned int gmshFormat)
 {
     int npoints = 0;
     int nlines = 0;
@@ -131,20 +150,24 @@ bool MeshGmsh::readGmsh(std::ifstream &file, const unsigned int gmshFormat)
     std::string cmd;
 
     // --- Loading Vertices ---
-    file >> npoints; //nb points
+    nextValue(p, end, npoints); //nb points
 
     std::vector<int> pmap; // map for reordering vertices possibly not well sorted
     for (int i = 0; i<npoints; ++i)
     {
         int index = i;
         double x, y, z;
-        file >> index >> x >> y >> z;
+        x = y = z = 0;
+        nextValue(p, end, index);
+        nextValue(p, end, x);
+        nextValue(p, end, y);
+        nextValue(p, end, z);
         m_vertices.push_back(sofa::defaulttype::Vector3(x, y, z));
         if ((int)pmap.size() <= index) pmap.resize(index + 1);
         pmap[index] = i; // In case of hole or swit
     }
     
-    file >> cmd;
+    cmd = nextWord(p, end);
     if (cmd != "$ENDNOD" && cmd != "$EndNodes")
     {
         msg_error("MeshGmsh") << "'$ENDNOD' or '$EndNodes' expected, found '" << cmd << "'";
@@ -152,7 +175,7 @@ bool MeshGmsh::readGmsh(std::ifstream &file, const unsigned int gmshFormat)
     }
 
     // --- Loading Elements ---
-    file >> cmd;
+    cmd = nextWord(p, end);
     if (cmd != "$ELM" && cmd != "$Elements")
     {
         msg_error("MeshGmsh") << "'$ELM' or '$Elements' expected, found '" << cmd << "'";
@@ -160,7 +183,7 @@ bool MeshGmsh::readGmsh(std::ifstream &file, const unsigned int gmshFormat)
     }
 
     int nelems = 0;
-    file >> nelems;
+    nextValue(p, end, nelems);
 
     for (int i = 0; i<nelems; ++i) // for each elem
     {
@@ -170,17 +193,23 @@ bool MeshGmsh::readGmsh(std::ifstream &file, const unsigned int gmshFormat)
             // version 1.0 format is
             // elm-number elm-type reg-phys reg-elem number-of-nodes <node-number-list ...>
             int rphys = -1, relem = -1;
-            file >> index >> etype >> rphys >> relem >> nnodes;
+            nextValue(p, end, index);
+            nextValue(p, end, etype);
+            nextValue(p, end, rphys);
+            nextValue(p, end, relem);
+            nextValue(p, end, nnodes);
         }
         else /*if (gmshFormat == 2)*/
         {
             // version 2.0 format is
             // elm-number elm-type number-of-tags < tag > ... node-number-list
-            file >> index >> etype >> ntags;
+            nextValue(p, end, index);
+            nextValue(p, end, etype);
+            nextValue(p, end, ntags);
 
             for (int t = 0; t<ntags; t++)
             {
-                file >> tag;
+                nextValue(p, end, tag);
                 // read the tag but don't use it
             }
 
@@ -228,7 +257,7 @@ bool MeshGmsh::readGmsh(std::ifstream &file, const unsigned int gmshFormat)
         for (int n = 0; n<nnodes; ++n)
         {
             int t = 0;
-            file >> t;
+            nextValue(p, end, t);
             nodes[n] = (((unsigned int)t)<pmap.size()) ? pmap[t] : 0;
         }
 
@@ -322,8 +351,7 @@ bool MeshGmsh::readGmsh(std::ifstream &file, const unsigned int gmshFormat)
             break;
         default:
             //if the type is not handled, skip rest of the line
-            std::string tmp;
-            std::getline(file, tmp);
+            p = text::nextLine(p, end);
         }
     }
 
@@ -332,7 +360,7 @@ bool MeshGmsh::readGmsh(std::ifstream &file, const unsigned int gmshFormat)
     normalizeGroup(m_tetrahedraGroups);
     normalizeGroup(m_hexahedraGroups);
 
-    file >> cmd;
+    cmd = nextWord(p, end);
     if (cmd != "$ENDELM" && cmd != "$EndElements")
     {
         msg_error("MeshGmsh") << "'$ENDELM' or '$EndElements' expected, found '" << cmd << "'";
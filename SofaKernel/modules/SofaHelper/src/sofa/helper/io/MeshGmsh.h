@@ -47,7 +47,7 @@ public:
 
 protected:
 
-    bool readGmsh(std::ifstream &file, const unsigned int gmshFormat);
+    bool readGmsh(const char* p, const char* end, const unsigned int gmshFormat);
 
     void addInGroup(helper::vector< sofa::core::loader::PrimitiveGroup>& group, int tag, int eid);
 
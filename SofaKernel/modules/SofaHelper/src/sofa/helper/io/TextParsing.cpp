@@ -0,0 +1,298 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2019 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#include <sofa/helper/io/TextParsing.h>
+
+#include <cstdint>
+#include <limits>
+#include <locale>
+#include <sstream>
+
+namespace sofa
+{
+
+namespace helper
+{
+
+namespace io
+{
+
+namespace text
+{
+
+namespace
+{
+
+/// Decimal number split in its significant digits and its power of ten.
+struct DecimalScan
+{
+    const char* begin;
+    const char* end;
+    bool negative;
+    bool exact;            ///< false if the significant digits do not fit in the mantissa
+    std::uint64_t mantissa;
+    int exponent;
+};
+
+bool scanDecimal(const char* p, const char* end, DecimalScan& scan)
+{
+    scan.begin = p;
+    scan.negative = false;
+    scan.exact = true;
+    scan.mantissa = 0;
+    scan.exponent = 0;
+
+    if (p < end && (*p == '-' || *p == '+'))
+    {
+        scan.negative = (*p == '-');
+        ++p;
+    }
+
+    int digits = 0;
+    bool any = false;
+    for (; p < end && *p >= '0' && *p <= '9'; ++p)
+    {
+        any = true;
+        if (digits < 19)
+        {
+            scan.mantissa = scan.mantissa * 10 + std::uint64_t(*p - '0');
+            if (scan.mantissa != 0)
+                ++digits;
+        }
+        else
+        {
+            scan.exact = false;
+        }
+    }
+    if (p < end && *p == '.')
+    {
+        ++p;
+        for (; p < end && *p >= '0' && *p <= '9'; ++p)
+        {
+            any = true;
+            if (digits < 19)
+            {
+                scan.mantissa = scan.mantissa * 10 + std::uint64_t(*p - '0');
+                --scan.exponent;
+                if (scan.mantissa != 0)
+                    ++digits;
+            }
+            else
+            {
+                scan.exact = false;
+            }
+        }
+    }
+    if (!any)
+        return false;
+
+    if (p < end && (*p == 'e' || *p == 'E'))
+    {
+        const char* q = p + 1;
+        bool negativeExponent = false;
+        if (q < end && (*q == '-' || *q == '+'))
+        {
+            negativeExponent = (*q == '-');
+            ++q;
+        }
+        if (q < end && *q >= '0' && *q <= '9')
+        {
+            int e = 0;
+            for (; q < end && *q >= '0' && *q <= '9'; ++q)
+            {
+                if (e < 100000)
+                    e = e * 10 + (*q - '0');
+            }
+            scan.exponent += negativeExponent ? -e : e;
+            p = q;
+        }
+    }
+    scan.end = p;
+    return true;
+}
+
+/// Parse the word at p with a classic locale stream, as a last resort.
+template<class T>
+bool parseWithStream(const char*& p, const char* end, T& value)
+{
+    const char* b = skipBlanks(p, end);
+    const char* e = wordEnd(b, end);
+    if (b == e)
+        return false;
+
+    std::istringstream in(std::string(b, e));
+    in.imbue(std::locale::classic());
+    T v = T();
+    in >> v;
+    value = v; // as the stream operators, which store the saturated value on overflow
+    if (in.fail())
+        return false;
+    const std::streamoff consumed = in.eof() ? std::streamoff(e - b) : std::streamoff(in.tellg());
+    p = b + consumed;
+    return true;
+}
+
+template<class T>
+bool parseInteger(const char*& p, const char* end, T& value)
+{
+    const char* b = skipBlanks(p, end);
+    const char* q = b;
+    bool negative = false;
+    if (q < end && (*q == '-' || *q == '+'))
+    {
+        negative = (*q == '-');
+        ++q;
+    }
+    if (negative && !std::numeric_limits<T>::is_signed)
+        return parseWithStream(p, end, value);
+
+    const char* digits = q;
+    std::uint64_t v = 0;
+    for (; q < end && *q >= '0' && *q <= '9' && q - digits < 18; ++q)
+        v = v * 10 + std::uint64_t(*q - '0');
+    if (q == digits)
+        return false;
+    if (q < end && *q >= '0' && *q <= '9')
+        return parseWithStream(p, end, value); // too many digits to be sure of the range
+
+    // the magnitude of the minimum of a signed type is its maximum plus one
+    const std::uint64_t limit = std::uint64_t(std::numeric_limits<T>::max()) + (negative ? 1 : 0);
+    if (v > limit)
+        return parseWithStream(p, end, value);
+
+    value = negative ? T(-(long long)v) : T(v);
+    p = q;
+    return true;
+}
+
+const double exactPowersOf10[] =
+{
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+const float exactPowersOf10f[] =
+{
+    1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f
+};
+
+} // anonymous namespace
+
+bool parseValue(const char*& p, const char* end, double& value)
+{
+    const char* b = skipBlanks(p, end);
+    DecimalScan scan;
+    if (!scanDecimal(b, end, scan))
+        return parseWithStream(p, end, value);
+
+    // Both the mantissa and the power of ten are exact doubles: a single rounding gives the right value
+    if (scan.exact && scan.mantissa <= (std::uint64_t(1) << 53) && scan.exponent >= -22 && scan.exponent <= 22)
+    {
+        double v = double(scan.mantissa);
+        if (scan.exponent < 0)
+            v /= exactPowersOf10[-scan.exponent];
+        else
+            v *= exactPowersOf10[scan.exponent];
+        value = scan.negative ? -v : v;
+        p = scan.end;
+        return true;
+    }
+    return parseWithStream(p, end, value);
+}
+
+bool parseValue(const char*& p, const char* end, float& value)
+{
+    const char* b = skipBlanks(p, end);
+    DecimalScan scan;
+    if (!scanDecimal(b, end, scan))
+        return parseWithStream(p, end, value);
+
+    if (scan.exact && scan.mantissa <= (std::uint64_t(1) << 24) && scan.exponent >= -10 && scan.exponent <= 10)
+    {
+        float v = float(scan.mantissa);
+        if (scan.exponent < 0)
+            v /= exactPowersOf10f[-scan.exponent];
+        else
+            v *= exactPowersOf10f[scan.exponent];
+        value = scan.negative ? -v : v;
+        p = scan.end;
+        return true;
+    }
+    return parseWithStream(p, end, value);
+}
+
+bool parseValue(const char*& p, const char* end, long long& value) { return parseInteger(p, end, value); }
+bool parseValue(const char*& p, const char* end, unsigned long long& value) { return parseInteger(p, end, value); }
+bool parseValue(const char*& p, const char* end, int& value) { return parseInteger(p, end, value); }
+bool parseValue(const char*& p, const char* end, unsigned int& value) { return parseInteger(p, end, value); }
+bool parseValue(const char*& p, const char* end, long& value) { return parseInteger(p, end, value); }
+bool parseValue(const char*& p, const char* end, unsigned long& value) { return parseInteger(p, end, value); }
+bool parseValue(const char*& p, const char* end, short& value) { return parseInteger(p, end, value); }
+bool parseValue(const char*& p, const char* end, unsigned short& value) { return parseInteger(p, end, value); }
+
+std::vector<const char*> splitLines(const char* begin, const char* end, std::size_t nbChunks)
+{
+    std::vector<const char*> bounds;
+    bounds.push_back(begin);
+    if (nbChunks < 1)
+        nbChunks = 1;
+    const std::size_t size = std::size_t(end - begin);
+    for (std::size_t i = 1; i < nbChunks; ++i)
+    {
+        const char* target = begin + size / nbChunks * i;
+        if (target <= bounds.back())
+            continue;
+        const char* p = (target[-1] == '\n') ? target : nextLine(target, end);
+        if (p > bounds.back() && p < end)
+            bounds.push_back(p);
+    }
+    if (end > bounds.back() || bounds.size() == 1)
+        bounds.push_back(end);
+    return bounds;
+}
+
+unsigned long long hashBytes(const char* data, std::size_t size, unsigned long long seed)
+{
+    const std::uint64_t multiplier = 0x9E3779B97F4A7C15ull;
+    std::uint64_t h = seed ^ (std::uint64_t(size) * multiplier);
+    std::size_t i = 0;
+    for (; i + 8 <= size; i += 8)
+    {
+        std::uint64_t w;
+        std::memcpy(&w, data + i, 8);
+        h = (h ^ w) * multiplier;
+        h ^= h >> 29;
+    }
+    std::uint64_t w = 0;
+    if (i < size)
+        std::memcpy(&w, data + i, size - i);
+    h = (h ^ w) * multiplier;
+    h ^= h >> 32;
+    return h;
+}
+
+} // namespace text
+
+} // namespace io
+
+} // namespace helper
+
+} // namespace sofa
@@ -0,0 +1,142 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2019 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#ifndef SOFA_HELPER_IO_TEXTPARSING_H
+#define SOFA_HELPER_IO_TEXTPARSING_H
+
+#include <sofa/helper/helper.h>
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace sofa
+{
+
+namespace helper
+{
+
+namespace io
+{
+
+/// Locale independent helpers to parse text files held in memory (see MappedFile).
+///
+/// All the functions work on a [p, end) range of characters and never read past end.
+/// The number parsers give the same values as the standard stream operators with the
+/// classic locale: the common cases are converted exactly with integer arithmetic,
+/// the others fall back to the standard library.
+namespace text
+{
+
+inline bool isBlank(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+inline bool isSpace(char c)
+{
+    return isBlank(c) || c == '\n';
+}
+
+/// Skip spaces and tabs, but not the end of line.
+inline const char* skipBlanks(const char* p, const char* end)
+{
+    while (p < end && isBlank(*p))
+        ++p;
+    return p;
+}
+
+/// Skip all white spaces, including the ends of line.
+inline const char* skipSpaces(const char* p, const char* end)
+{
+    while (p < end && isSpace(*p))
+        ++p;
+    return p;
+}
+
+/// Position of the '\n' ending the line containing p, or end.
+inline const char* lineEnd(const char* p, const char* end)
+{
+    if (p >= end)
+        return end;
+    const char* e = static_cast<const char*>(std::memchr(p, '\n', end - p));
+    return e ? e : end;
+}
+
+/// Beginning of the line following the one containing p, or end.
+inline const char* nextLine(const char* p, const char* end)
+{
+    const char* e = lineEnd(p, end);
+    return e < end ? e + 1 : end;
+}
+
+/// End of the word starting at p.
+inline const char* wordEnd(const char* p, const char* end)
+{
+    while (p < end && !isSpace(*p))
+        ++p;
+    return p;
+}
+
+/// Read the next word of the current line, after skipping blanks.
+inline std::string readWord(const char*& p, const char* end)
+{
+    const char* b = skipBlanks(p, end);
+    p = wordEnd(b, end);
+    return std::string(b, p);
+}
+
+/// True if the word [b, e) is equal to the given null terminated string.
+inline bool isWord(const char* b, const char* e, const char* word)
+{
+    const std::size_t n = std::strlen(word);
+    return std::size_t(e - b) == n && std::memcmp(b, word, n) == 0;
+}
+
+/// Parse a number after skipping blanks (not the ends of line).
+/// On success p is moved after the number, otherwise it is left untouched and false is returned.
+SOFA_HELPER_API bool parseValue(const char*& p, const char* end, double& value);
+SOFA_HELPER_API bool parseValue(const char*& p, const char* end, float& value);
+SOFA_HELPER_API bool parseValue(const char*& p, const char* end, long long& value);
+SOFA_HELPER_API bool parseValue(const char*& p, const char* end, unsigned long long& value);
+SOFA_HELPER_API bool parseValue(const char*& p, const char* end, int& value);
+SOFA_HELPER_API bool parseValue(const char*& p, const char* end, unsigned int& value);
+SOFA_HELPER_API bool parseValue(const char*& p, const char* end, long& value);
+SOFA_HELPER_API bool parseValue(const char*& p, const char* end, unsigned long& value);
+SOFA_HELPER_API bool parseValue(const char*& p, const char* end, short& value);
+SOFA_HELPER_API bool parseValue(const char*& p, const char* end, unsigned short& value);
+
+/// Split [begin, end) in at most nbChunks ranges of similar sizes, cut at the beginning of lines.
+/// Returns the boundaries of the ranges: chunk i is [bounds[i], bounds[i+1]).
+SOFA_HELPER_API std::vector<const char*> splitLines(const char* begin, const char* end, std::size_t nbChunks);
+
+/// 64 bits hash of a memory block, to detect modified files.
+SOFA_HELPER_API unsigned long long hashBytes(const char* data, std::size_t size, unsigned long long seed = 0);
+
+} // namespace text
+
+} // namespace io
+
+} // namespace helper
+
+} // namespace sofa
+
+#endif // SOFA_HELPER_IO_TEXTPARSING_H
@@ -138,16 +138,14 @@ void EulerImplicitSolver::solve(const core::ExecParams* params, SReal dt, sofa::
     {
         // new more powerful visitors
 
-        // force in the current configuration
-        b.eq(f,1.0/tr);                                                                         // b = f0
+        // force in the current configuration, integrated over a time step
+        b.eq(f,h);                                                                              // b = h f0
         if (verbose)
             msg_info() << "EulerImplicitSolver, f = " << f;
 
-        // add the change of force due to stiffness + Rayleigh damping
-        mop.addMBKv(b, -f_rayleighMass.getValue(), 1, h+f_rayleighStiffness.getValue()); // b =  f0 + ( rm M + B + (h+rs) K ) v
-
-        // integration over a time step
-        b.teq(h*tr);                                                                        // b = h(f0 + ( rm M + B + (h+rs) K ) v )
+        // add the change of force due to stiffness + Rayleigh damping, the factors already include h*tr
+        // so that the right-hand side does not need another pass to be scaled
+        mop.addMBKv(b, -f_rayleighMass.getValue()*h*tr, h*tr, (h+f_rayleighStiffness.getValue())*h*tr); // b = h(f0 + tr( rm M + B + (h+rs) K ) v )
     }
 
     if (verbose)
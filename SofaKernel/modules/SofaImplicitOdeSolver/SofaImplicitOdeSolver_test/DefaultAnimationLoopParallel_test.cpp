@@ -0,0 +1,109 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2019 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#include <SofaTest/Sofa_test.h>
+#include <SofaTest/TestMessageHandler.h>
+
+#include <sofa/simulation/Simulation.h>
+#include <sofa/simulation/DefaultTaskScheduler.h>
+#include <SofaSimulationGraph/DAGSimulation.h>
+#include <SofaSimulationCommon/SceneLoaderXML.h>
+#include <SofaBaseMechanics/MechanicalObject.h>
+
+#include <sstream>
+
+namespace sofa {
+
+using simulation::Node;
+using simulation::TaskScheduler;
+typedef component::container::MechanicalObject<defaulttype::Vec3Types> MechanicalObject3;
+
+/** Check that DefaultAnimationLoop gives the same results when the independent subtrees with a solver are solved
+in parallel tasks. The scene has independent objects with internal springs, and two objects linked by a spring,
+which must be solved in the order of the traversal.
+*/
+struct DefaultAnimationLoopParallel_test : public Sofa_test<>
+{
+    std::string createScene(bool parallel)
+    {
+        std::stringstream scene;
+        scene << "<Node name='root' gravity='0 -10 0' dt='0.01'>"
+                 "  <DefaultAnimationLoop parallelODESolving='" << parallel << "'/>";
+        const char* names[] = { "Object0", "Object1", "Object2", "CoupledA", "Object3", "CoupledB", "Object4" };
+        for (int i = 0; i < 7; ++i)
+        {
+            scene << "  <Node name='" << names[i] << "'>"
+                     "    <EulerImplicitSolver rayleighStiffness='0.1' rayleighMass='0.1'/>"
+                     "    <CGLinearSolver template='GraphScattered' iterations='100' tolerance='1e-12' threshold='1e-12'/>"
+                     "    <MechanicalObject template='Vec3d' name='dofs' position='" << i << " 0 0  " << i << " 1 0  " << i + 0.5 << " 2 0'/>"
+                     "    <UniformMass totalMass='" << 1 + i << "'/>"
+                     "    <FixedConstraint indices='0'/>"
+                     "    <StiffSpringForceField object1='@dofs' object2='@dofs' spring='0 1 100 0 1  1 2 100 0 1'/>"
+                     "  </Node>";
+        }
+        scene << "  <StiffSpringForceField object1='@CoupledA/dofs' object2='@CoupledB/dofs' spring='2 2 50 0 2'/>"
+                 "</Node>";
+        return scene.str();
+    }
+
+    std::vector<MechanicalObject3::VecCoord> simulate(bool parallel)
+    {
+        const std::string scene = createScene(parallel);
+        Node::SPtr root = simulation::SceneLoaderXML::loadFromMemory("testscene", scene.c_str(), scene.size());
+        simulation::getSimulation()->init(root.get());
+        for (int step = 0; step < 50; ++step)
+            simulation::getSimulation()->animate(root.get(), 0.01);
+
+        std::vector<MechanicalObject3::VecCoord> positions;
+        for (MechanicalObject3* dofs : root->getTreeObjects<MechanicalObject3>())
+            positions.push_back(dofs->read(core::ConstVecCoordId::position())->getValue());
+
+        simulation::getSimulation()->unload(root);
+        return positions;
+    }
+};
+
+TEST_F(DefaultAnimationLoopParallel_test, sameResultsAsSequential)
+{
+    EXPECT_MSG_NOEMIT(Error);
+
+    simulation::setSimulation(new simulation::graph::DAGSimulation());
+    TaskScheduler* scheduler = TaskScheduler::create(simulation::DefaultTaskScheduler::name());
+    scheduler->init(4);
+
+    const std::vector<MechanicalObject3::VecCoord> sequential = simulate(false);
+    const std::vector<MechanicalObject3::VecCoord> parallel = simulate(true);
+    scheduler->stop();
+
+    ASSERT_EQ(sequential.size(), 7u);
+    ASSERT_EQ(sequential.size(), parallel.size());
+    for (std::size_t i = 0; i < sequential.size(); ++i)
+    {
+        ASSERT_EQ(sequential[i].size(), parallel[i].size());
+        for (std::size_t j = 0; j < sequential[i].size(); ++j)
+            EXPECT_EQ(sequential[i][j], parallel[i][j]) << "object " << i << " point " << j;
+    }
+
+    // the objects fell
+    EXPECT_LT(sequential[0][2][1], 2.0);
+}
+
+} // namespace sofa
@@ -22,8 +22,10 @@
 #ifndef SOFA_COMPONENT_LOADER_BASEVTKREADER_INL
 #define SOFA_COMPONENT_LOADER_BASEVTKREADER_INL
 #include <SofaLoader/BaseVTKReader.h>
+#include <sofa/helper/io/TextParsing.h>
 
 #include <string>
+#include <type_traits>
 #include <istream>
 #include <fstream>
 
@@ -43,6 +45,46 @@ namespace basevtkreader
 using std::istringstream ;
 using sofa::defaulttype::Vec ;
 
+/// Numbers read from ascii files with the locale independent parser of helper::io::text.
+/// Characters keep the stream semantics (one character per value).
+template<class T>
+struct TextParsable : std::integral_constant<bool, std::is_arithmetic<T>::value && (sizeof(T) > 1)> {};
+
+template<int N, class T>
+struct TextParsable< Vec<N,T> > : TextParsable<T> {};
+
+template<class T>
+inline bool parseTextValue(const char*& p, const char* end, T& value)
+{
+    return helper::io::text::parseValue(p, end, value);
+}
+
+template<int N, class T>
+inline bool parseTextValue(const char*& p, const char* end, Vec<N,T>& value)
+{
+    for (int c=0; c<N; ++c)
+        if (!parseTextValue(p, end, value[c]))
+            return false;
+    return true;
+}
+
+template<class T>
+inline void readTextLine(const string& line, T* data, int& i, int n, std::true_type)
+{
+    const char* p = line.data();
+    const char* end = p + line.size();
+    while (i < n && parseTextValue(p, end, data[i]))
+        ++i;
+}
+
+template<class T>
+inline void readTextLine(const string& line, T* data, int& i, int n, std::false_type)
+{
+    istringstream ln(line);
+    while (i < n && ln >> data[i])
+        ++i;
+}
+
 template<class T>
 const void* BaseVTKReader::VTKDataIO<T>::getData()
 {
@@ -156,9 +198,7 @@ bool BaseVTKReader::VTKDataIO<T>::read(istream& in, int n, int binary)
         while(i < dataSize && !in.eof() && !in.bad())
         {
             std::getline(in, line);
-            istringstream ln(line);
-            while (i < n && ln >> data[i])
-                ++i;
+            readTextLine(line, data, i, n, TextParsable<T>());
         }
         if (i < n)
         {
@@ -23,7 +23,13 @@
 #include <SofaLoader/MeshObjLoader.h>
 #include <sofa/core/visual/VisualParams.h>
 #include <sofa/helper/system/SetDirectory.h>
+#include <sofa/helper/io/MappedFile.h>
+#include <sofa/helper/io/TextParsing.h>
+#include <sofa/simulation/ParallelForEach.h>
+#include <algorithm>
+#include <cstring>
 #include <fstream>
+#include <limits>
 
 namespace sofa
 {
@@ -113,17 +119,17 @@ bool MeshObjLoader::load()
     bool fileRead = false;
 
     // -- Loading file
-    const char* filename = m_filename.getFullPath().c_str();
-    std::ifstream file(filename);
+    const std::string filename = m_filename.getFullPath();
+    helper::io::MappedFile file;
 
-    if (!file.good())
+    if (!file.open(filename))
     {
         msg_error() << "Error: MeshObjLoader: Cannot read file '" << m_filename << "'.";
         return false;
     }
 
     // -- Reading file
-    fileRead = this->readOBJ (file,filename);
+    fileRead = this->readOBJ (file.begin(), file.end(), filename.c_str());
     file.close();
 
     return fileRead;
@@ -155,7 +161,129 @@ void MeshObjLoader::addGroup (const PrimitiveGroup& g)
     d_quadsGroups.endEdit();
 }
 
-bool MeshObjLoader::readOBJ (std::ifstream &file, const char* filename)
+namespace
+{
+
+/// Marks a missing index in a face corner (e.g. no texture coordinate in "1//2")
+const int noIndex = std::numeric_limits<int>::min();
+
+/// Statement of an OBJ file which cannot be parsed independently of the previous ones.
+struct ObjDirective
+{
+    std::string keyword;
+    helper::vector<std::string> words;
+    std::size_t nbFacesBefore; ///< number of faces of the chunk before this statement
+};
+
+/// Face or line of an OBJ file, with its corners as written in the file.
+struct ObjFace
+{
+    std::size_t firstCorner;
+    std::size_t nbCorners;
+    /// Number of positions, texture coordinates and normals of the chunk before this face, to resolve the relative indices
+    std::size_t nbDefinedBefore[3];
+};
+
+/// Result of the parsing of a range of lines of an OBJ file.
+struct ObjChunk
+{
+    helper::vector<Vector3> positions;
+    helper::vector<Vector2> texCoords;
+    helper::vector<Vector3> normals;
+    std::vector<int> corners; ///< position, texture coordinate and normal indices of each corner
+    std::vector<ObjFace> faces;
+    std::vector<ObjDirective> directives;
+};
+
+template<int N>
+defaulttype::Vec<N, SReal> parseVec(const char* p, const char* end)
+{
+    defaulttype::Vec<N, SReal> v;
+    for (int i = 0; i < N; ++i)
+    {
+        double value = 0;
+        if (!helper::io::text::parseValue(p, end, value))
+            break;
+        v[i] = (SReal)value;
+    }
+    return v;
+}
+
+/// Index as read by atoi, for the indices of the face corners.
+int parseIndex(const char* b, const char* e)
+{
+    int value = 0;
+    if (!helper::io::text::parseValue(b, e, value))
+        return 0;
+    return value;
+}
+
+void parseObjChunk(const char* p, const char* end, ObjChunk& chunk)
+{
+    using namespace helper::io::text;
+    while (p < end)
+    {
+        const char* le = lineEnd(p, end);
+        const char* b = skipBlanks(p, le);
+        const char* e = wordEnd(b, le);
+        p = le < end ? le + 1 : end;
+        if (b == e)
+            continue;
+
+        if (isWord(b, e, "v"))
+        {
+            chunk.positions.push_back(parseVec<3>(e, le));
+        }
+        else if (isWord(b, e, "vn"))
+        {
+            chunk.normals.push_back(parseVec<3>(e, le));
+        }
+        else if (isWord(b, e, "vt"))
+        {
+            chunk.texCoords.push_back(parseVec<2>(e, le));
+        }
+        else if (isWord(b, e, "l") || isWord(b, e, "f"))
+        {
+            ObjFace face;
+            face.firstCorner = chunk.corners.size() / 3;
+            face.nbDefinedBefore[0] = chunk.positions.size();
+            face.nbDefinedBefore[1] = chunk.texCoords.size();
+            face.nbDefinedBefore[2] = chunk.normals.size();
+            for (const char* w = skipBlanks(e, le); w < le; w = skipBlanks(w, le))
+            {
+                const char* we = wordEnd(w, le);
+                for (int j = 0; j < 3; ++j)
+                {
+                    const char* se = static_cast<const char*>(std::memchr(w, '/', we - w));
+                    if (!se)
+                        se = we;
+                    chunk.corners.push_back(se > w ? parseIndex(w, se) : noIndex);
+                    w = se < we ? se + 1 : we;
+                }
+                w = we;
+            }
+            face.nbCorners = chunk.corners.size() / 3 - face.firstCorner;
+            chunk.faces.push_back(face);
+        }
+        else if (isWord(b, e, "mtllib") || isWord(b, e, "usemtl") || isWord(b, e, "g"))
+        {
+            ObjDirective directive;
+            directive.keyword.assign(b, e);
+            directive.nbFacesBefore = chunk.faces.size();
+            for (const char* w = skipBlanks(e, le); w < le; w = skipBlanks(w, le))
+            {
+                const char* we = wordEnd(w, le);
+                directive.words.push_back(std::string(w, we));
+                w = we;
+            }
+            chunk.directives.push_back(directive);
+        }
+    }
+}
+
+} // anonymous namespace
+
+bool MeshObjLoader::readOBJ (const char* begin, const char* end, const char* filename)
 {
  
     const bool handleSeams = d_handleSeams.getValue();
@@ -190,8 +318,31 @@ bool MeshObjLoader::readOBJ (std::ifstream &file, const char* filename)
     d_trianglesGroups.beginEdit()->clear(); d_trianglesGroups.endEdit();
     d_quadsGroups.beginEdit()->clear(); d_quadsGroups.endEdit();
 
+    // The lines are parsed by independent chunks, possibly in parallel,
+    // then the statements are replayed in the order of the file.
+    simulation::TaskScheduler* scheduler = d_parallelParsing.getValue() ? simulation::TaskScheduler::getInstance() : nullptr;
+    const std::size_t nbChunks = scheduler ? 4 * std::max(1u, scheduler->getThreadCount()) : 1;
+    const std::vector<const char*> bounds = helper::io::text::splitLines(begin, end, nbChunks);
+    std::vector<ObjChunk> chunks(bounds.size() - 1);
+    auto parseChunk = [&](std::size_t c) { parseObjChunk(bounds[c], bounds[c+1], chunks[c]); };
+    if (scheduler)
+        simulation::parallelForEach(*scheduler, 0, chunks.size(), parseChunk);
+    else
+        for (std::size_t c = 0; c < chunks.size(); ++c)
+            parseChunk(c);
+
+    std::size_t nbPositions = 0, nbTexCoords = 0, nbNormals = 0;
+    for (const ObjChunk& chunk : chunks)
+    {
+        nbPositions += chunk.positions.size();
+        nbTexCoords += chunk.texCoords.size();
+        nbNormals += chunk.normals.size();
+    }
+    my_positions.reserve(nbPositions);
+    my_texCoords.reserve(nbTexCoords);
+    my_normals.reserve(nbNormals);
+
     int vtn[3];
-    Vector3 result;
     helper::WriteAccessor<Data<helper::vector< PrimitiveGroup> > > my_faceGroups[NBFACETYPE] =
     {
         d_edgesGroups,
@@ -203,123 +354,95 @@ bool MeshObjLoader::readOBJ (std::ifstream &file, const char* filename)
     int curMaterialId = -1;
     int nbFaces[NBFACETYPE] = {0}; // number of edges, triangles, quads
     int groupF0[NBFACETYPE] = {0}; // first primitives indices in current group for edges, triangles, quads
-    std::string line;
-    while( std::getline(file,line) )
+    for (const ObjChunk& chunk : chunks)
     {
-        if (line.empty()) continue;
-        std::istringstream values(line);
-        std::string token;
-        values >> token;
+        const std::size_t definedBefore[3] = { my_positions.size(), my_texCoords.size(), my_normals.size() };
+        my_positions.insert(my_positions.end(), chunk.positions.begin(), chunk.positions.end());
+        my_texCoords.insert(my_texCoords.end(), chunk.texCoords.begin(), chunk.texCoords.end());
+        my_normals.insert(my_normals.end(), chunk.normals.begin(), chunk.normals.end());
 
-        if (token == "#")
-        {
-            // comment
-        }
-        else if (token == "v")
-        {
-            // vertex
-            values >> result[0] >> result[1] >> result[2];
-            my_positions.push_back(Vector3(result[0],result[1], result[2]));
-        }
-        else if (token == "vn")
+        std::size_t nextDirective = 0;
+        for (std::size_t fi = 0; fi <= chunk.faces.size(); ++fi)
         {
-            // normal 
-            values >> result[0] >> result[1] >> result[2];
-            my_normals.push_back(Vector3(result[0],result[1], result[2]));
-        }
-        else if (token == "vt")
-        {
-            // texcoord
-            values >> result[0] >> result[1];
-            my_texCoords.push_back(Vector2(result[0],result[1]));
-        }
-        else if ((token == "mtllib") && d_loadMaterial.getValue())
-        {
-            while (!values.eof())
+            for (; nextDirective < chunk.directives.size() && chunk.directives[nextDirective].nbFacesBefore == fi; ++nextDirective)
             {
-                std::string materialLibaryName;
-                values >> materialLibaryName;
-                std::string mtlfile = sofa::helper::system::SetDirectory::GetRelativeFromFile(materialLibaryName.c_str(), filename);
-                this->readMTL(mtlfile.c_str(), my_materials);
-            }
-        }
-        else if (token == "usemtl" || token == "g")
-        {
-            // end of current group
-            //curGroup.nbp = nbf - curGroup.p0;
-            for (int ft = 0; ft < NBFACETYPE; ++ft)
-                if (nbFaces[ft] > groupF0[ft])
+                const ObjDirective& directive = chunk.directives[nextDirective];
+                if (directive.keyword == "mtllib")
                 {
-                    my_faceGroups[ft].push_back(PrimitiveGroup(groupF0[ft], nbFaces[ft]-groupF0[ft], curMaterialName, curGroupName, curMaterialId));
-                    groupF0[ft] = nbFaces[ft];
+                    if (d_loadMaterial.getValue())
+                    {
+                        for (const std::string& materialLibaryName : directive.words)
+                        {
+                            std::string mtlfile = sofa::helper::system::SetDirectory::GetRelativeFromFile(materialLibaryName.c_str(), filename);
+                            this->readMTL(mtlfile.c_str(), my_materials);
+                        }
+                    }
+                    continue;
                 }
-            if (token == "usemtl")
-            {
-                values >> curMaterialName;
-                curMaterialId = -1;
-                helper::vector<Material>::iterator it = my_materials.begin();
-                helper::vector<Material>::iterator itEnd = my_materials.end();
-                for (; it != itEnd; ++it)
+
+                // end of current group
+                for (int ft = 0; ft < NBFACETYPE; ++ft)
+                    if (nbFaces[ft] > groupF0[ft])
+                    {
+                        my_faceGroups[ft].push_back(PrimitiveGroup(groupF0[ft], nbFaces[ft]-groupF0[ft], curMaterialName, curGroupName, curMaterialId));
+                        groupF0[ft] = nbFaces[ft];
+                    }
+                if (directive.keyword == "usemtl")
                 {
-                    if (it->name == curMaterialName)
+                    curMaterialName = directive.words.empty() ? std::string() : directive.words[0];
+                    curMaterialId = -1;
+                    helper::vector<Material>::iterator it = my_materials.begin();
+                    helper::vector<Material>::iterator itEnd = my_materials.end();
+                    for (; it != itEnd; ++it)
                     {
-                        (*it).activated = true;
-                        if (!material.activated)
-                            material = *it;
-                        curMaterialId = it - my_materials.begin();
-                        break;
+                        if (it->name == curMaterialName)
+                        {
+                            (*it).activated = true;
+                            if (!material.activated)
+                                material = *it;
+                            curMaterialId = it - my_materials.begin();
+                            break;
+                        }
                     }
                 }
-            }
-            else if (token == "g")
-            {
-                curGroupName.clear();
-                while (!values.eof())
+                else // "g"
                 {
-                    std::string g;
-                    values >> g;
-                    if (!curGroupName.empty())
-                        curGroupName += " ";
-                    curGroupName += g;
+                    curGroupName.clear();
+                    for (const std::string& g : directive.words)
+                    {
+                        if (!curGroupName.empty())
+                            curGroupName += " ";
+                        curGroupName += g;
+                    }
                 }
             }
-        }
-        else if (token == "l" || token == "f")
-        {
+            if (fi == chunk.faces.size())
+                break;
+
             // face
+            const ObjFace& face = chunk.faces[fi];
             nodes.clear();
             nIndices.clear();
             tIndices.clear();
 
-            while (!values.eof())
+            for (std::size_t corner = face.firstCorner; corner < face.firstCorner + face.nbCorners; ++corner)
             {
-                std::string face;
-                values >> face;
-                if (face.empty()) continue;
                 for (int j = 0; j < 3; j++)
                 {
+                    const int index = chunk.corners[3*corner+j];
                     vtn[j] = -1;
-                    std::string::size_type pos = face.find('/');
-                    std::string tmp = face.substr(0, pos);
-                    if (pos == std::string::npos)
-                        face = "";
+                    if (index == noIndex)
+                        continue;
+
+                    vtn[j] = index;
+                    if (vtn[j] >= 1)
+                        vtn[j] -=1; // -1 because the numerotation begins at 1 and a vector begins at 0
+                    else if (vtn[j] < 0)
+                        vtn[j] += int(definedBefore[j] + face.nbDefinedBefore[j]);
                     else
                     {
-                        face = face.substr(pos + 1);
-                    }
-
-                    if (!tmp.empty())
-                    {
-                        vtn[j] = atoi(tmp.c_str());
-                        if (vtn[j] >= 1)
-                            vtn[j] -=1; // -1 because the numerotation begins at 1 and a vector begins at 0
-                        else if (vtn[j] < 0)
-                            vtn[j] += (j==0) ? my_positions.size() : (j==1) ? my_texCoords.size() : my_normals.size();
-                        else
-                        {
-                            msg_error() << "Invalid index " << tmp;
-                            vtn[j] = -1;
-                        }
+                        msg_error() << "Invalid index " << index;
+                        vtn[j] = -1;
                     }
                 }
 
@@ -363,11 +486,6 @@ bool MeshObjLoader::readOBJ (std::ifstream &file, const char* filename)
                 ++nbFaces[MeshObjLoader::TRIANGLE];
                 faceType = MeshObjLoader::TRIANGLE;
             }
-
-        }
-        else
-        {
-
         }
     }
 
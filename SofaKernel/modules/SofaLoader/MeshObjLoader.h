@@ -56,7 +56,7 @@ public:
     }
 
 protected:
-    bool readOBJ (std::ifstream &file, const char* filename);
+    bool readOBJ (const char* begin, const char* end, const char* filename);
     bool readMTL (const char* filename, helper::vector <sofa::helper::types::Material>& d_materials);
     void addGroup (const sofa::core::loader::PrimitiveGroup& g);
 
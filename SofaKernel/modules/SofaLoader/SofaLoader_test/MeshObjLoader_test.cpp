@@ -24,10 +24,13 @@
 #include <SofaTest/Sofa_test.h>
 
 #include <SofaLoader/MeshObjLoader.h>
+#include <sofa/simulation/DefaultTaskScheduler.h>
 
 #include <sofa/helper/BackTrace.h>
 using sofa::helper::BackTrace ;
 
+#include <boost/filesystem.hpp>
+
 using namespace sofa::component::loader;
 
 namespace sofa
@@ -76,6 +79,25 @@ public :
         EXPECT_EQ((size_t)normalPerVertexNb, this->d_normals.getValue().size());
     }
 
+    /// Load the mesh and return the loaded geometry and topology as strings, to compare loadings.
+    std::vector<std::string> loadedValues(std::string filename)
+    {
+        this->setFilename(sofa::helper::system::DataRepository.getFile(filename));
+        this->d_positions.setValue({});
+        this->d_triangles.setValue({});
+        this->d_quads.setValue({});
+        this->d_normals.setValue({});
+        this->d_texCoords.setValue({});
+
+        EXPECT_TRUE(this->loadWithCache());
+        std::vector<std::string> values;
+        const std::vector<sofa::core::objectmodel::BaseData*> datas = { &this->d_positions, &this->d_edges, &this->d_triangles,
+                                                                        &this->d_quads, &this->d_normals, &this->d_texCoords };
+        for (sofa::core::objectmodel::BaseData* data : datas)
+            values.push_back(data->getValueString());
+        return values;
+    }
+
 };
 
 /** MeshObjLoader::load()
@@ -97,5 +119,45 @@ TEST_F(MeshObjLoader_test, LoadCall)
     loadTest("mesh/torus.obj", 800, 0, 1600,  0, 0, 0, 0, 0, 0, 861, 0);
 }
 
+/// The parallel parsing gives the same mesh as the sequential one
+TEST_F(MeshObjLoader_test, ParallelParsing)
+{
+    using sofa::simulation::TaskScheduler;
+    TaskScheduler* scheduler = TaskScheduler::create(sofa::simulation::DefaultTaskScheduler::name());
+    scheduler->init(4);
+
+    for (const char* filename : { "mesh/dragon.obj", "mesh/caducee_base.obj", "mesh/torus.obj", "mesh/box.obj" })
+    {
+        this->d_parallelParsing.setValue(false);
+        const std::vector<std::string> sequential = loadedValues(filename);
+        this->d_parallelParsing.setValue(true);
+        EXPECT_EQ(sequential, loadedValues(filename)) << filename;
+    }
+    this->d_parallelParsing.setValue(false);
+    scheduler->stop();
+}
+
+/// The second loading reads the binary cache written by the first one
+TEST_F(MeshObjLoader_test, BinaryCache)
+{
+    const boost::filesystem::path cacheDirectory = boost::filesystem::temp_directory_path() / "MeshObjLoader_test_cache";
+    boost::filesystem::remove_all(cacheDirectory);
+    boost::filesystem::create_directories(cacheDirectory);
+    this->d_cacheDirectory.setValue(cacheDirectory.string());
+
+    for (const char* filename : { "mesh/torus.obj", "mesh/cube.obj" })
+    {
+        this->d_binaryCache.setValue(false);
+        const std::vector<std::string> reference = loadedValues(filename);
+
+        this->d_binaryCache.setValue(true);
+        EXPECT_EQ(reference, loadedValues(filename)) << filename;
+        EXPECT_FALSE(boost::filesystem::is_empty(cacheDirectory)) << filename;
+        EXPECT_EQ(reference, loadedValues(filename)) << filename;
+    }
+    this->d_binaryCache.setValue(false);
+    boost::filesystem::remove_all(cacheDirectory);
+}
+
 } // namespace meshobjloader_test
 } // namespace sofa
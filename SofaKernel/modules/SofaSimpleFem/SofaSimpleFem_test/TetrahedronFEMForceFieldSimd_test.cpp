@@ -0,0 +1,175 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2019 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#include <SofaSimpleFem/TetrahedronFEMForceFieldSimd.h>
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace sofa
+{
+
+using namespace component::forcefield::tetrahedronfem;
+
+namespace
+{
+
+/// Random batches of tetrahedra, deformed and rotated, with random material coefficients
+template<class Real>
+struct RandomBatches
+{
+    typedef TetrahedronFEMBatch<Real> Batch;
+
+    std::vector<Batch> batches;
+    std::vector<Real> x;
+
+    RandomBatches(unsigned int nbElements)
+    {
+        std::mt19937 generator(1234);
+        std::uniform_real_distribution<double> uniform(-1.0, 1.0);
+        const double reference[4][3] = { {0,0,0}, {1,0,0}, {0,1,0}, {0,0,1} };
+
+        const unsigned int size = Batch::Size;
+        for (unsigned int first = 0; first < nbElements; first += size)
+        {
+            Batch batch;
+            batch.nbElements = std::min(size, nbElements - first);
+            for (unsigned int l = 0; l < size; ++l)
+            {
+                // rotation of angle 2 around a random axis, to exercise large rotations
+                double axis[3] = { uniform(generator), uniform(generator), uniform(generator) + 2 };
+                const double n = std::sqrt(axis[0]*axis[0] + axis[1]*axis[1] + axis[2]*axis[2]);
+                for (int j = 0; j < 3; ++j)
+                    axis[j] /= n;
+                const double c = std::cos(2.0), s = std::sin(2.0);
+                double R[3][3];
+                for (int i = 0; i < 3; ++i)
+                    for (int j = 0; j < 3; ++j)
+                        R[i][j] = (1 - c) * axis[i] * axis[j] + (i == j ? c : 0);
+                R[0][1] -= s * axis[2]; R[1][0] += s * axis[2];
+                R[0][2] += s * axis[1]; R[2][0] -= s * axis[1];
+                R[1][2] -= s * axis[0]; R[2][1] += s * axis[0];
+
+                batch.element[l] = first + l;
+                const double center[3] = { 3 * uniform(generator), 3 * uniform(generator), 3 * uniform(generator) };
+                for (unsigned int v = 0; v < 4; ++v)
+                {
+                    batch.vertex[v][l] = (unsigned int)(x.size() / 3);
+                    double p[3];
+                    for (int j = 0; j < 3; ++j)
+                        p[j] = reference[v][j] + 0.1 * uniform(generator);
+                    for (int i = 0; i < 3; ++i)
+                        x.push_back(Real(center[i] + R[i][0]*p[0] + R[i][1]*p[1] + R[i][2]*p[2]));
+                }
+                for (unsigned int v = 0; v < 3; ++v)
+                    for (unsigned int j = 0; j < 3; ++j)
+                        batch.restEdge[v][j][l] = Real(reference[v+1][j]);
+                for (unsigned int v = 0; v < 4; ++v)
+                    for (unsigned int j = 0; j < 3; ++j)
+                        batch.shape[v][j][l] = Real(uniform(generator));
+                for (unsigned int k = 0; k < 12; ++k)
+                    batch.stiffness[k][l] = Real(2 + uniform(generator));
+            }
+            batches.push_back(batch);
+        }
+    }
+
+    std::vector<Real> computeForces(SimdInstructionSet isa, RotationMethod method)
+    {
+        std::vector<Real> f(x.size(), Real(0));
+        addCorotationalForces(isa, method, &batches[0], &batches[0] + batches.size(), &x[0], &f[0]);
+        return f;
+    }
+};
+
+template<class Real>
+void checkInstructionSets(RotationMethod method, Real tolerance)
+{
+    RandomBatches<Real> reference(21);
+    const std::vector<Real> referenceForces = reference.computeForces(SIMD_NONE, method);
+
+    Real maxForce = 0;
+    for (const Real f : referenceForces)
+        maxForce = std::max(maxForce, std::abs(f));
+    ASSERT_GT(maxForce, 0);
+
+    // the rotations are orthonormal
+    for (const TetrahedronFEMBatch<Real>& batch : reference.batches)
+    {
+        for (unsigned int l = 0; l < batch.nbElements; ++l)
+        {
+            for (int i = 0; i < 3; ++i)
+            {
+                for (int j = 0; j < 3; ++j)
+                {
+                    Real dot = 0;
+                    for (int k = 0; k < 3; ++k)
+                        dot += batch.rotation[i][k][l] * batch.rotation[j][k][l];
+                    EXPECT_NEAR(dot, i == j ? 1 : 0, tolerance);
+                }
+            }
+        }
+    }
+
+    for (int isa = SIMD_NONE + 1; isa <= getBestSimdInstructionSet(); ++isa)
+    {
+        SCOPED_TRACE(getSimdInstructionSetName(SimdInstructionSet(isa)));
+        RandomBatches<Real> batches(21);
+        const std::vector<Real> forces = batches.computeForces(SimdInstructionSet(isa), method);
+
+        ASSERT_EQ(referenceForces.size(), forces.size());
+        for (std::size_t i = 0; i < forces.size(); ++i)
+            EXPECT_NEAR(referenceForces[i], forces[i], tolerance * maxForce);
+
+        for (std::size_t b = 0; b < batches.batches.size(); ++b)
+            for (unsigned int l = 0; l < batches.batches[b].nbElements; ++l)
+                for (int i = 0; i < 3; ++i)
+                    for (int j = 0; j < 3; ++j)
+                        EXPECT_NEAR(reference.batches[b].rotation[i][j][l], batches.batches[b].rotation[i][j][l], tolerance);
+    }
+}
+
+} // anonymous namespace
+
+TEST(TetrahedronFEMForceFieldSimd_test, largeDouble)
+{
+    checkInstructionSets<double>(ROTATION_LARGE, 1e-10);
+}
+
+TEST(TetrahedronFEMForceFieldSimd_test, polarDouble)
+{
+    checkInstructionSets<double>(ROTATION_POLAR, 1e-7);
+}
+
+TEST(TetrahedronFEMForceFieldSimd_test, largeFloat)
+{
+    checkInstructionSets<float>(ROTATION_LARGE, 1e-4f);
+}
+
+TEST(TetrahedronFEMForceFieldSimd_test, polarFloat)
+{
+    checkInstructionSets<float>(ROTATION_POLAR, 1e-3f);
+}
+
+} // namespace sofa
@@ -34,6 +34,10 @@ using sofa::simulation::Node ;
 using sofa::simulation::SceneLoaderXML ;
 using sofa::core::ExecParams ;
 
+#include <sofa/simulation/DefaultTaskScheduler.h>
+using sofa::simulation::TaskScheduler ;
+using sofa::simulation::DefaultTaskScheduler ;
+
 namespace sofa {
 
 using namespace modeling;
@@ -133,6 +137,182 @@ struct TetrahedronFEMForceField_test : public ForceField_test<_TetrahedronFEMFor
 
         EXPECT_EQ(fem->getComponentState(), ComponentState::Invalid) ;
     }
+
+    /// Load a grid of tetrahedra with the given method, and deterministic deformed positions and displacements
+    ForceType* loadDeformedGrid(const std::string& method, Data<VecCoord>& positions, Data<VecDeriv>& velocities, Data<VecDeriv>& displacements)
+    {
+        this->clearSceneGraph();
+
+        std::stringstream scene ;
+        scene << "<?xml version='1.0'?>"
+                 "<Node 	name='Root'>                                \n"
+                 "  <Node name='FEMnode'>                               \n"
+                 "    <RegularGridTopology n='7 6 5' min='0 0 0' max='6 5 4'/>\n"
+                 "    <MechanicalObject name='dofs'/>                   \n"
+                 "    <TetrahedronFEMForceField name='fem' youngModulus='5000' poissonRatio='0.3' method='" << method << "'/>\n"
+                 "  </Node>                                             \n"
+                 "</Node>                                               \n" ;
+
+        Node::SPtr root = SceneLoaderXML::loadFromMemory ("testscene",
+                                                          scene.str().c_str(),
+                                                          scene.str().size()) ;
+        root->init(ExecParams::defaultInstance()) ;
+        m_root = root;
+
+        ForceType* fem = dynamic_cast<ForceType*>(root->getTreeNode("FEMnode")->getObject("fem")) ;
+        if (fem == nullptr)
+            return nullptr;
+
+        // deterministic deformation of the rest shape
+        {
+            VecCoord& p = *positions.beginEdit();
+            VecDeriv& dx = *displacements.beginEdit();
+            p = fem->_initialPoints.getValue();
+            dx.resize(p.size());
+            for (std::size_t i = 0; i < p.size(); ++i)
+            {
+                const Real a = Real(i % 7) / 7, b = Real(i % 5) / 5, c = Real(i % 3) / 3;
+                p[i] += Deriv(Real(0.1) * a * b, Real(0.2) * b - Real(0.1) * c, Real(0.15) * a * c);
+                dx[i] = Deriv(c - a, a * b, b - c) * Real(0.01);
+            }
+            positions.endEdit();
+            displacements.endEdit();
+        }
+        velocities.setValue(VecDeriv(positions.getValue().size()));
+        return fem;
+    }
+
+    /// Compute addForce and addDForce on a deformed grid with the given method, sequentially and with parallel tasks
+    void checkParallelMatchesSequential(const std::string& method)
+    {
+        Data<VecCoord> positions;
+        Data<VecDeriv> velocities, displacements;
+        ForceType* fem = loadDeformedGrid(method, positions, velocities, displacements);
+        ASSERT_NE(fem, nullptr) ;
+
+        core::MechanicalParams mparams;
+        mparams.setKFactor(1.0);
+
+        auto computeForces = [&](VecDeriv& f, VecDeriv& df)
+        {
+            Data<VecDeriv> forces, dforces;
+            fem->addForce(&mparams, forces, positions, velocities);
+            fem->addDForce(&mparams, dforces, displacements);
+            f = forces.getValue();
+            df = dforces.getValue();
+        };
+
+        VecDeriv sequentialF, sequentialDF;
+        fem->d_parallel.setValue(false);
+        computeForces(sequentialF, sequentialDF);
+
+        TaskScheduler* scheduler = TaskScheduler::create(DefaultTaskScheduler::name());
+        fem->d_parallel.setValue(true);
+
+        scheduler->init(4);
+        VecDeriv parallelF, parallelDF;
+        computeForces(parallelF, parallelDF);
+
+        scheduler->init(2);
+        VecDeriv parallelF2, parallelDF2;
+        computeForces(parallelF2, parallelDF2);
+        scheduler->stop();
+
+        ASSERT_EQ(sequentialF.size(), parallelF.size());
+        ASSERT_EQ(sequentialDF.size(), parallelDF.size());
+        const Real tolerance = 1e-10;
+        for (std::size_t i = 0; i < sequentialF.size(); ++i)
+        {
+            for (unsigned int j = 0; j < 3; ++j)
+            {
+                EXPECT_NEAR(sequentialF[i][j], parallelF[i][j], tolerance * (1 + std::abs(sequentialF[i][j])));
+                EXPECT_NEAR(sequentialDF[i][j], parallelDF[i][j], tolerance * (1 + std::abs(sequentialDF[i][j])));
+
+                // the parallel result does not depend on the number of threads
+                EXPECT_EQ(parallelF[i][j], parallelF2[i][j]);
+                EXPECT_EQ(parallelDF[i][j], parallelDF2[i][j]);
+            }
+        }
+    }
+
+    /// Compare the forces of the batched SIMD kernels with the scalar ones, sequentially and with parallel tasks
+    void checkSimdMatchesScalar(const std::string& method)
+    {
+        Data<VecCoord> positions;
+        Data<VecDeriv> velocities, displacements;
+        ForceType* fem = loadDeformedGrid(method, positions, velocities, displacements);
+        ASSERT_NE(fem, nullptr) ;
+
+        // large rigid rotation around z on top of the deformation
+        {
+            const Real c = std::cos(Real(0.6)), s = std::sin(Real(0.6));
+            for (Coord& p : *positions.beginEdit())
+                p = Coord(c * p[0] - s * p[1], s * p[0] + c * p[1], p[2]);
+            positions.endEdit();
+        }
+
+        core::MechanicalParams mparams;
+        mparams.setKFactor(1.0);
+
+        // addDForce uses the rotations computed by addForce
+        auto computeForces = [&](VecDeriv& f, VecDeriv& df)
+        {
+            Data<VecDeriv> forces, dforces;
+            fem->addForce(&mparams, forces, positions, velocities);
+            fem->addDForce(&mparams, dforces, displacements);
+            f = forces.getValue();
+            df = dforces.getValue();
+        };
+
+        VecDeriv scalarF, scalarDF;
+        fem->d_simd.setValue(false);
+        computeForces(scalarF, scalarDF);
+
+        VecDeriv simdF, simdDF;
+        fem->d_simd.setValue(true);
+        computeForces(simdF, simdDF);
+
+        TaskScheduler* scheduler = TaskScheduler::create(DefaultTaskScheduler::name());
+        fem->d_parallel.setValue(true);
+        scheduler->init(4);
+        VecDeriv parallelF, parallelDF;
+        computeForces(parallelF, parallelDF);
+        scheduler->init(2);
+        VecDeriv parallelF2, parallelDF2;
+        computeForces(parallelF2, parallelDF2);
+        scheduler->stop();
+
+        Real maxF = 0, maxDF = 0;
+        for (std::size_t i = 0; i < scalarF.size(); ++i)
+        {
+            for (unsigned int j = 0; j < 3; ++j)
+            {
+                maxF = std::max(maxF, std::abs(scalarF[i][j]));
+                maxDF = std::max(maxDF, std::abs(scalarDF[i][j]));
+            }
+        }
+        ASSERT_GT(maxF, 0);
+
+        // the polar decompositions stop on a relative criterion of 1e-8 (1e-6 in single precision)
+        const Real tolerance = (sizeof(Real) == sizeof(double)) ? Real(1e-7) : Real(1e-3);
+        ASSERT_EQ(scalarF.size(), simdF.size());
+        ASSERT_EQ(scalarF.size(), parallelF.size());
+        for (std::size_t i = 0; i < scalarF.size(); ++i)
+        {
+            for (unsigned int j = 0; j < 3; ++j)
+            {
+                EXPECT_NEAR(scalarF[i][j], simdF[i][j], tolerance * maxF);
+                EXPECT_NEAR(scalarDF[i][j], simdDF[i][j], tolerance * maxDF);
+                EXPECT_NEAR(scalarF[i][j], parallelF[i][j], tolerance * maxF);
+                EXPECT_NEAR(scalarDF[i][j], parallelDF[i][j], tolerance * maxDF);
+
+                EXPECT_EQ(parallelF[i][j], parallelF2[i][j]);
+                EXPECT_EQ(parallelDF[i][j], parallelDF2[i][j]);
+            }
+        }
+    }
+
+    Node::SPtr m_root;
 };
 
 // ========= Define the list of types to instanciate.
@@ -169,4 +349,18 @@ TYPED_TEST(TetrahedronFEMForceField_test, checkGracefullHandlingWhenTopologyIsMi
     this->checkGracefullHandlingWhenTopologyIsMissing();
 }
 
+TYPED_TEST(TetrahedronFEMForceField_test, checkParallelMatchesSequential)
+{
+    this->checkParallelMatchesSequential("small");
+    this->checkParallelMatchesSequential("large");
+    this->checkParallelMatchesSequential("polar");
+    this->checkParallelMatchesSequential("svd");
+}
+
+TYPED_TEST(TetrahedronFEMForceField_test, checkSimdMatchesScalar)
+{
+    this->checkSimdMatchesScalar("large");
+    this->checkSimdMatchesScalar("polar");
+}
+
 } // namespace sofa
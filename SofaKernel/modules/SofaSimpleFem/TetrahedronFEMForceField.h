@@ -34,6 +34,8 @@
 
 #include <sofa/helper/ColorMap.h>
 
+#include "TetrahedronFEMForceFieldSimd.h"
+
 // corotational tetrahedron from
 // @InProceedings{NPF05,
 //   author       = "Nesme, Matthieu and Payan, Yohan and Faure, Fran\c{c}ois",
@@ -228,6 +230,9 @@ public:
 
     Data<bool>  _updateStiffness; ///< udpate structures (precomputed in init) using stiffness parameters in each iteration (set listening=1)
 
+    Data<bool> d_parallel; ///< compute addForce and addDForce with parallel tasks over colors of elements sharing no vertex (not used with computeGlobalMatrix)
+    Data<bool> d_simd; ///< compute the forces of the large and polar methods with the batched SIMD kernels (not used with plasticity, updateStiffnessMatrix or computeGlobalMatrix)
+
     /// Link to be set to the topology container in the component graph. 
     SingleLink<TetrahedronFEMForceField<DataTypes>, sofa::core::topology::BaseMeshTopology, BaseLink::FLAG_STOREPATH|BaseLink::FLAG_STRONGLINK> l_topology;
 
@@ -320,6 +325,32 @@ protected:
 
     void handleTopologyChange() override { needUpdateTopology = true; }
 
+    /// @name Parallel element loop
+    /// Elements are grouped by colors such that two elements of the same color share no vertex:
+    /// the elements of a color can be processed concurrently without write conflicts and every vertex
+    /// receives the contributions in the same order whatever the number of threads.
+    /// @{
+    helper::vector<Index> m_coloredElements; ///< element indices sorted by color
+    helper::vector<std::size_t> m_colorOffsets; ///< elements of color c are m_coloredElements[m_colorOffsets[c]] to m_coloredElements[m_colorOffsets[c+1]-1]
+    void computeElementColors();
+    void accumulateForceColored( Vector& f, const Vector & p );
+    void applyStiffnessColored( Vector& f, const Vector& x, SReal fact );
+    /// @}
+
+    /// @name Batched SIMD forces (large and polar methods)
+    /// The constant data of the elements are packed by groups of ElementBatch::Size in structure-of-arrays form.
+    /// When the element loop is parallel, a batch only holds elements of the same color.
+    /// @{
+    typedef tetrahedronfem::TetrahedronFEMBatch<Real> ElementBatch;
+    helper::vector<ElementBatch> m_batches;
+    helper::vector<std::size_t> m_batchOffsets; ///< batches of group g (a color, or all the elements) are m_batches[m_batchOffsets[g]] to m_batches[m_batchOffsets[g+1]-1]
+    bool m_coloredBatches;
+    tetrahedronfem::SimdInstructionSet m_simdInstructionSet;
+    bool useBatchedForces() const;
+    void computeBatches( bool colored );
+    void accumulateForceBatched( Vector& f, const Vector & p );
+    /// @}
+
     void computeVonMisesStress();
     void handleEvent(core::objectmodel::Event *event) override;
 };
@@ -33,6 +33,8 @@
 #include <SofaBaseLinearSolver/CompressedRowSparseMatrix.h>
 #include <sofa/simulation/AnimateBeginEvent.h>
 #include <sofa/simulation/AnimateEndEvent.h>
+#include <sofa/simulation/TaskScheduler.h>
+#include <sofa/simulation/ParallelForEach.h>
 
 
 namespace sofa
@@ -73,6 +75,8 @@ TetrahedronFEMForceField<DataTypes>::TetrahedronFEMForceField()
     , _showStressAlpha(initData(&_showStressAlpha, 1.0f, "showStressAlpha", "Alpha for vonMises visualisation"))
     , _showVonMisesStressPerNode(initData(&_showVonMisesStressPerNode,false,"showVonMisesStressPerNode","draw points  showing vonMises stress interpolated in nodes"))
     , _updateStiffness(initData(&_updateStiffness,false,"updateStiffness","udpate structures (precomputed in init) using stiffness parameters in each iteration (set listening=1)"))
+    , d_parallel(initData(&d_parallel,false,"parallel","compute the element forces in parallel tasks. The result does not depend on the number of threads. Not used with computeGlobalMatrix"))
+    , d_simd(initData(&d_simd,false,"simd","compute the forces of the large and polar methods with batched kernels using the best SIMD instruction set of the CPU (SSE2, AVX2). Not used with plasticity, updateStiffnessMatrix or computeGlobalMatrix"))
     , l_topology(initLink("topology", "link to the tetrahedron topology container"))
 {
     _poissonRatio.setRequired(true);
@@ -85,6 +89,8 @@ TetrahedronFEMForceField<DataTypes>::TetrahedronFEMForceField()
     this->addAlias(&_assembling, "assembling");
     minYoung = 0.0;
     maxYoung = 0.0;
+    m_coloredBatches = false;
+    m_simdInstructionSet = tetrahedronfem::SIMD_NONE;
 }
 
 
@@ -1258,6 +1264,264 @@ inline void TetrahedronFEMForceField<DataTypes>::accumulateForceSVD( Vector& f,
 
 
 
+//////////////////////////////////////////////////////////////////////
+////////////////////////  parallel element loop  /////////////////////
+//////////////////////////////////////////////////////////////////////
+
+template<class DataTypes>
+void TetrahedronFEMForceField<DataTypes>::computeElementColors()
+{
+    // greedy coloring: each element takes the first color not used by the elements already colored
+    // around its vertices. Colors are searched in windows of 64 using a bitmask per vertex,
+    // the elements which do not find a free color in the window are postponed to the next window.
+    typedef std::uint64_t ColorMask;
+    const unsigned int windowSize = sizeof(ColorMask) * 8;
+
+    const VecElement& elements = *_indexedElements;
+
+    std::size_t nbPoints = 0;
+    for (const Element& element : elements)
+        for (unsigned int v = 0; v < 4; ++v)
+            nbPoints = std::max(nbPoints, std::size_t(element[v]) + 1);
+
+    helper::vector<unsigned int> elementColors(elements.size(), 0);
+    helper::vector<Index> remaining(elements.size());
+    for (std::size_t i = 0; i < elements.size(); ++i)
+        remaining[i] = Index(i);
+
+    helper::vector<ColorMask> vertexMasks;
+    helper::vector<Index> postponed;
+    unsigned int nbColors = 0;
+    for (unsigned int window = 0; !remaining.empty(); window += windowSize)
+    {
+        vertexMasks.assign(nbPoints, 0);
+        postponed.clear();
+        for (const Index i : remaining)
+        {
+            const Element& element = elements[i];
+            const ColorMask used = vertexMasks[element[0]] | vertexMasks[element[1]] | vertexMasks[element[2]] | vertexMasks[element[3]];
+            if (used == ~ColorMask(0))
+            {
+                postponed.push_back(i);
+                continue;
+            }
+            unsigned int color = 0;
+            while (used & (ColorMask(1) << color))
+                ++color;
+            for (unsigned int v = 0; v < 4; ++v)
+                vertexMasks[element[v]] |= ColorMask(1) << color;
+            elementColors[i] = window + color;
+            nbColors = std::max(nbColors, window + color + 1);
+        }
+        remaining.swap(postponed);
+    }
+
+    // counting sort of the elements by color
+    m_colorOffsets.assign(nbColors + 1, 0);
+    for (const unsigned int color : elementColors)
+        ++m_colorOffsets[color + 1];
+    for (unsigned int c = 0; c < nbColors; ++c)
+        m_colorOffsets[c + 1] += m_colorOffsets[c];
+
+    helper::vector<std::size_t> insertPosition(m_colorOffsets.begin(), m_colorOffsets.end() - 1);
+    m_coloredElements.resize(elements.size());
+    for (std::size_t i = 0; i < elements.size(); ++i)
+        m_coloredElements[insertPosition[elementColors[i]]++] = Index(i);
+
+    msg_info() << elements.size() << " elements split in " << nbColors << " colors for the parallel loops";
+}
+
+template<class DataTypes>
+void TetrahedronFEMForceField<DataTypes>::accumulateForceColored( Vector& f, const Vector & p )
+{
+    if (m_coloredElements.size() != _indexedElements->size())
+        computeElementColors();
+
+    // minimum number of elements processed by a task
+    const std::size_t grainSize = 64;
+
+    simulation::TaskScheduler* scheduler = simulation::TaskScheduler::getInstance();
+    const typename VecElement::const_iterator elementsBegin = _indexedElements->begin();
+    const int elementMethod = method;
+
+    auto accumulateRange = [&](const std::size_t first, const std::size_t last)
+    {
+        for (std::size_t k = first; k < last; ++k)
+        {
+            const Index i = m_coloredElements[k];
+            const typename VecElement::const_iterator it = elementsBegin + i;
+            switch(elementMethod)
+            {
+            case SMALL : accumulateForceSmall( f, p, it, i ); break;
+            case LARGE : accumulateForceLarge( f, p, it, i ); break;
+            case POLAR : accumulateForcePolar( f, p, it, i ); break;
+            case SVD :   accumulateForceSVD( f, p, it, i ); break;
+            }
+        }
+    };
+
+    for (std::size_t c = 0; c + 1 < m_colorOffsets.size(); ++c)
+    {
+        simulation::parallelForEachRange(*scheduler, m_colorOffsets[c], m_colorOffsets[c+1], accumulateRange, grainSize);
+    }
+}
+
+template<class DataTypes>
+void TetrahedronFEMForceField<DataTypes>::applyStiffnessColored( Vector& f, const Vector& x, SReal fact )
+{
+    if (m_coloredElements.size() != _indexedElements->size())
+        computeElementColors();
+
+    // minimum number of elements processed by a task
+    const std::size_t grainSize = 128;
+
+    simulation::TaskScheduler* scheduler = simulation::TaskScheduler::getInstance();
+    const VecElement& elements = *_indexedElements;
+    const bool isSmall = (method == SMALL);
+
+    auto applyRange = [&](const std::size_t first, const std::size_t last)
+    {
+        for (std::size_t k = first; k < last; ++k)
+        {
+            const Index i = m_coloredElements[k];
+            const Element& element = elements[i];
+            if (isSmall)
+                applyStiffnessSmall( f, x, i, element[0], element[1], element[2], element[3], fact );
+            else
+                applyStiffnessCorotational( f, x, i, element[0], element[1], element[2], element[3], fact );
+        }
+    };
+
+    for (std::size_t c = 0; c + 1 < m_colorOffsets.size(); ++c)
+    {
+        simulation::parallelForEachRange(*scheduler, m_colorOffsets[c], m_colorOffsets[c+1], applyRange, grainSize);
+    }
+}
+
+
+//////////////////////////////////////////////////////////////////////
+////////////////////////  batched SIMD forces  ///////////////////////
+//////////////////////////////////////////////////////////////////////
+
+template<class DataTypes>
+bool TetrahedronFEMForceField<DataTypes>::useBatchedForces() const
+{
+    // the batches only hold the constant part of the strain-displacement and material stiffness matrices
+    return d_simd.getValue()
+            && (method == LARGE || method == POLAR)
+            && !_assembling.getValue()
+            && !_updateStiffnessMatrix.getValue()
+            && _plasticMaxThreshold.getValue() <= 0;
+}
+
+template<class DataTypes>
+void TetrahedronFEMForceField<DataTypes>::computeBatches( bool colored )
+{
+    const VecElement& elements = *_indexedElements;
+    const unsigned int batchSize = ElementBatch::Size;
+
+    if (colored && m_coloredElements.size() != elements.size())
+        computeElementColors();
+
+    m_batches.clear();
+    m_batchOffsets.assign(1, 0);
+    const std::size_t nbGroups = colored ? m_colorOffsets.size() - 1 : 1;
+    for (std::size_t g = 0; g < nbGroups; ++g)
+    {
+        const std::size_t groupBegin = colored ? m_colorOffsets[g] : 0;
+        const std::size_t groupEnd = colored ? m_colorOffsets[g+1] : elements.size();
+        for (std::size_t first = groupBegin; first < groupEnd; first += batchSize)
+        {
+            ElementBatch batch;
+            batch.nbElements = (unsigned int)std::min<std::size_t>(batchSize, groupEnd - first);
+            for (unsigned int l = 0; l < batchSize; ++l)
+            {
+                // unused lanes repeat the first element, without stiffness
+                const bool used = (l < batch.nbElements);
+                const std::size_t k = first + (used ? l : 0);
+                const Index i = colored ? m_coloredElements[k] : Index(k);
+
+                batch.element[l] = i;
+                for (unsigned int v = 0; v < 4; ++v)
+                    batch.vertex[v][l] = elements[i][v];
+
+                const helper::fixed_array<Coord,4>& rest = _rotatedInitialElements[i];
+                for (unsigned int v = 0; v < 3; ++v)
+                    for (unsigned int j = 0; j < 3; ++j)
+                        batch.restEdge[v][j][l] = rest[v+1][j] - rest[0][j];
+
+                const StrainDisplacement& J = strainDisplacements[i];
+                for (unsigned int v = 0; v < 4; ++v)
+                {
+                    batch.shape[v][0][l] = J[3*v][0];
+                    batch.shape[v][1][l] = J[3*v][3];
+                    batch.shape[v][2][l] = J[3*v][5];
+                }
+
+                const MaterialStiffness& K = materialsStiffnesses[i];
+                for (unsigned int r = 0; r < 3; ++r)
+                    for (unsigned int c = 0; c < 3; ++c)
+                        batch.stiffness[3*r+c][l] = used ? K[r][c] : Real(0);
+                for (unsigned int d = 3; d < 6; ++d)
+                    batch.stiffness[6+d][l] = used ? K[d][d] : Real(0);
+            }
+            m_batches.push_back(batch);
+        }
+        m_batchOffsets.push_back(m_batches.size());
+    }
+    m_coloredBatches = colored;
+}
+
+template<class DataTypes>
+void TetrahedronFEMForceField<DataTypes>::accumulateForceBatched( Vector& f, const Vector & p )
+{
+    if (_indexedElements->empty())
+        return;
+
+    const bool colored = d_parallel.getValue();
+    if (m_batches.empty() || m_coloredBatches != colored)
+        computeBatches(colored);
+
+    const tetrahedronfem::RotationMethod rotationMethod = (method == LARGE) ? tetrahedronfem::ROTATION_LARGE : tetrahedronfem::ROTATION_POLAR;
+    const tetrahedronfem::SimdInstructionSet isa = m_simdInstructionSet;
+    const Real* x = p[0].ptr();
+    Real* forces = f[0].ptr();
+
+    auto accumulateBatches = [&](const std::size_t first, const std::size_t last)
+    {
+        ElementBatch* batches = &m_batches[0];
+        tetrahedronfem::addCorotationalForces(isa, rotationMethod, batches + first, batches + last, x, forces);
+
+        for (std::size_t b = first; b < last; ++b)
+        {
+            const ElementBatch& batch = batches[b];
+            for (unsigned int l = 0; l < batch.nbElements; ++l)
+            {
+                Transformation& R = rotations[batch.element[l]];
+                for (unsigned int r = 0; r < 3; ++r)
+                    for (unsigned int c = 0; c < 3; ++c)
+                        R[r][c] = batch.rotation[c][r][l];
+            }
+        }
+    };
+
+    if (colored)
+    {
+        // minimum number of batches processed by a task
+        const std::size_t grainSize = 8;
+        simulation::TaskScheduler* scheduler = simulation::TaskScheduler::getInstance();
+        for (std::size_t g = 0; g + 1 < m_batchOffsets.size(); ++g)
+        {
+            simulation::parallelForEachRange(*scheduler, m_batchOffsets[g], m_batchOffsets[g+1], accumulateBatches, grainSize);
+        }
+    }
+    else
+    {
+        accumulateBatches(0, m_batches.size());
+    }
+}
+
+
 ///////////////////////////////////////////////////////////////////////////////////////
 ////////////////  specific methods for corotational large, polar, svd  ////////////////
 ///////////////////////////////////////////////////////////////////////////////////////
@@ -1340,6 +1604,13 @@ void TetrahedronFEMForceField<DataTypes>::init()
     if (_updateStiffness.getValue())
         this->f_listening.setValue(true);
 
+    if (d_parallel.getValue())
+        simulation::TaskScheduler::getInstance();
+
+    m_simdInstructionSet = tetrahedronfem::getBestSimdInstructionSet();
+    if (d_simd.getValue())
+        msg_info() << "batched forces computed with the " << tetrahedronfem::getSimdInstructionSetName(m_simdInstructionSet) << " instruction set";
+
     // ParallelDataThrd is used to build the matrix asynchronusly (when listening = true)
     // This feature is activated when callin handleEvent with ParallelizeBuildEvent
     // At init parallelDataSimu == parallelDataThrd (and it's the case since handleEvent is called)
@@ -1484,6 +1755,9 @@ inline void TetrahedronFEMForceField<DataTypes>::reinit()
     }
 
     setMethod(f_method.getValue() );
+    m_coloredElements.clear();
+    m_colorOffsets.clear();
+    m_batches.clear();
     const VecCoord& p = this->mstate->read(core::ConstVecCoordId::restPosition())->getValue();
     _initialPoints.setValue(p);
     strainDisplacements.resize( _indexedElements->size() );
@@ -1625,6 +1899,22 @@ inline void TetrahedronFEMForceField<DataTypes>::addForce (const core::Mechanica
         needUpdateTopology = false;
     }
 
+    if (useBatchedForces())
+    {
+        accumulateForceBatched( f, p );
+        d_f.endEdit();
+        updateVonMisesStress = true;
+        return;
+    }
+
+    if (d_parallel.getValue() && !_assembling.getValue())
+    {
+        accumulateForceColored( f, p );
+        d_f.endEdit();
+        updateVonMisesStress = true;
+        return;
+    }
+
     unsigned int i;
     typename VecElement::const_iterator it;
     switch(method)
@@ -1679,7 +1969,11 @@ inline void TetrahedronFEMForceField<DataTypes>::addDForce(const core::Mechanica
     unsigned int i;
     typename VecElement::const_iterator it;
 
-    if( method == SMALL )
+    if( d_parallel.getValue() )
+    {
+        applyStiffnessColored( df, dx, kFactor );
+    }
+    else if( method == SMALL )
     {
         for(it = _indexedElements->begin(), i = 0 ; it != _indexedElements->end() ; ++it, ++i)
         {
@@ -0,0 +1,184 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2019 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#include "TetrahedronFEMForceFieldSimd.inl"
+#include <cmath>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+
+namespace sofa
+{
+
+namespace component
+{
+
+namespace forcefield
+{
+
+namespace tetrahedronfem
+{
+
+#ifdef SOFA_SIMPLE_FEM_HAVE_SSE2
+// defined in TetrahedronFEMForceFieldSimd_sse2.cpp
+void addCorotationalForcesSSE2(RotationMethod method, TetrahedronFEMBatch<float>* first, TetrahedronFEMBatch<float>* last, const float* x, float* f);
+void addCorotationalForcesSSE2(RotationMethod method, TetrahedronFEMBatch<double>* first, TetrahedronFEMBatch<double>* last, const double* x, double* f);
+#endif
+
+#ifdef SOFA_SIMPLE_FEM_HAVE_AVX2
+// defined in TetrahedronFEMForceFieldSimd_avx2.cpp
+void addCorotationalForcesAVX2(RotationMethod method, TetrahedronFEMBatch<float>* first, TetrahedronFEMBatch<float>* last, const float* x, float* f);
+void addCorotationalForcesAVX2(RotationMethod method, TetrahedronFEMBatch<double>* first, TetrahedronFEMBatch<double>* last, const double* x, double* f);
+#endif
+
+namespace
+{
+
+/// one real, for the portable version of the kernel
+template<class T>
+struct PackScalar
+{
+    typedef T Real;
+    typedef bool Mask;
+    enum { Width = 1 };
+
+    T v;
+
+    PackScalar() {}
+    PackScalar(T value) : v(value) {}
+
+    static PackScalar load(const T* p) { return *p; }
+    static void store(T* p, const PackScalar a) { *p = a.v; }
+    static PackScalar set(const T a) { return a; }
+    static PackScalar sqrt(const PackScalar a) { return std::sqrt(a.v); }
+    static PackScalar abs(const PackScalar a) { return std::fabs(a.v); }
+    static PackScalar max(const PackScalar a, const PackScalar b) { return a.v > b.v ? a.v : b.v; }
+    static Mask greater(const PackScalar a, const PackScalar b) { return a.v > b.v; }
+    static Mask notEqual(const PackScalar a, const PackScalar b) { return a.v != b.v; }
+    static Mask maskAnd(const Mask a, const Mask b) { return a && b; }
+    static PackScalar select(const Mask m, const PackScalar a, const PackScalar b) { return m ? a : b; }
+    static bool any(const Mask m) { return m; }
+
+    friend PackScalar operator+(const PackScalar a, const PackScalar b) { return a.v + b.v; }
+    friend PackScalar operator-(const PackScalar a, const PackScalar b) { return a.v - b.v; }
+    friend PackScalar operator*(const PackScalar a, const PackScalar b) { return a.v * b.v; }
+    friend PackScalar operator/(const PackScalar a, const PackScalar b) { return a.v / b.v; }
+};
+
+bool cpuSupportsAVX2()
+{
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7)
+        return false;
+    __cpuid(info, 1);
+    const bool fma = (info[2] & (1 << 12)) != 0;
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    if (!fma || !osxsave || (_xgetbv(0) & 0x6) != 0x6) // the OS saves the AVX registers
+        return false;
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return false;
+#endif
+}
+
+SimdInstructionSet detectBestSimdInstructionSet()
+{
+#ifdef SOFA_SIMPLE_FEM_HAVE_AVX2
+    if (cpuSupportsAVX2())
+        return SIMD_AVX2;
+#endif
+#ifdef SOFA_SIMPLE_FEM_HAVE_SSE2
+    return SIMD_SSE2;
+#else
+    return SIMD_NONE;
+#endif
+}
+
+template<class Real>
+void dispatchCorotationalForces(SimdInstructionSet isa, RotationMethod method,
+                                TetrahedronFEMBatch<Real>* first, TetrahedronFEMBatch<Real>* last,
+                                const Real* x, Real* f)
+{
+    switch (isa)
+    {
+#ifdef SOFA_SIMPLE_FEM_HAVE_AVX2
+    case SIMD_AVX2:
+        addCorotationalForcesAVX2(method, first, last, x, f);
+        return;
+#endif
+#ifdef SOFA_SIMPLE_FEM_HAVE_SSE2
+    case SIMD_SSE2:
+        addCorotationalForcesSSE2(method, first, last, x, f);
+        return;
+#endif
+    default:
+        CorotationalKernel< PackScalar<Real> >::addForces(method, first, last, x, f);
+        return;
+    }
+}
+
+} // anonymous namespace
+
+SimdInstructionSet getBestSimdInstructionSet()
+{
+    static const SimdInstructionSet best = detectBestSimdInstructionSet();
+    return best;
+}
+
+const char* getSimdInstructionSetName(SimdInstructionSet isa)
+{
+    switch (isa)
+    {
+    case SIMD_SSE2: return "SSE2";
+    case SIMD_AVX2: return "AVX2";
+    default: return "none";
+    }
+}
+
+void addCorotationalForces(SimdInstructionSet isa, RotationMethod method,
+                           TetrahedronFEMBatch<float>* first, TetrahedronFEMBatch<float>* last,
+                           const float* x, float* f)
+{
+    dispatchCorotationalForces(isa, method, first, last, x, f);
+}
+
+void addCorotationalForces(SimdInstructionSet isa, RotationMethod method,
+                           TetrahedronFEMBatch<double>* first, TetrahedronFEMBatch<double>* last,
+                           const double* x, double* f)
+{
+    dispatchCorotationalForces(isa, method, first, last, x, f);
+}
+
+} // namespace tetrahedronfem
+
+} // namespace forcefield
+
+} // namespace component
+
+} // namespace sofa
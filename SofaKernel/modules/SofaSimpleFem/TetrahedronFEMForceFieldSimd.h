@@ -0,0 +1,112 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2019 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#ifndef SOFA_COMPONENT_FORCEFIELD_TETRAHEDRONFEMFORCEFIELDSIMD_H
+#define SOFA_COMPONENT_FORCEFIELD_TETRAHEDRONFEMFORCEFIELDSIMD_H
+#include "config.h"
+
+#include <cstddef>
+
+/// SSE2 is part of the x86-64 baseline: its kernels are compiled with the default flags.
+/// The AVX2 kernels are compiled in a separate file with specific flags, SOFA_SIMPLE_FEM_HAVE_AVX2 is defined by CMake.
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SOFA_SIMPLE_FEM_HAVE_SSE2
+#endif
+
+namespace sofa
+{
+
+namespace component
+{
+
+namespace forcefield
+{
+
+/// Batched corotational kernels used by TetrahedronFEMForceField for the large and polar methods.
+///
+/// The elements are packed by groups of TetrahedronFEMBatch::Size in structure-of-arrays form,
+/// so that the rotation, strain and force of several tetrahedra are computed at once in SIMD registers.
+/// This header is included by the translation units compiled with specific instruction sets:
+/// it must not define any non-template inline function.
+namespace tetrahedronfem
+{
+
+/// Instruction sets of the batched kernels, in increasing order of width
+enum SimdInstructionSet
+{
+    SIMD_NONE = 0,  ///< portable scalar code, one lane at a time
+    SIMD_SSE2,      ///< 128 bits registers: 2 doubles or 4 floats
+    SIMD_AVX2       ///< 256 bits registers with FMA: 4 doubles or 8 floats
+};
+
+/// Corotational method of the batched kernel
+enum RotationMethod
+{
+    ROTATION_LARGE = 0, ///< rotation from the first edge and first face (QR)
+    ROTATION_POLAR      ///< rotation from the polar decomposition of the edges
+};
+
+/// Per element data of a group of tetrahedra, in structure-of-arrays form.
+///
+/// The strain-displacement matrix of a corotational tetrahedron has only three distinct coefficients
+/// per vertex and its material stiffness matrix has a 3x3 block plus 3 diagonal terms:
+/// only these coefficients are stored.
+/// Unused lanes (after nbElements) hold a copy of the first element with a null stiffness.
+template<class Real>
+struct TetrahedronFEMBatch
+{
+    enum { Size = 8 };
+
+    unsigned int nbElements;            ///< number of used lanes
+    unsigned int element[Size];         ///< index of the element in each lane
+    unsigned int vertex[4][Size];       ///< indices of the four vertices
+    Real restEdge[3][3][Size];          ///< initial position of vertices 1,2,3 relative to vertex 0, in the initial element frame
+    Real shape[4][3][Size];             ///< J[3v][0], J[3v][3], J[3v][5] of the strain-displacement matrix J, for each vertex v
+    Real stiffness[12][Size];           ///< K[0..2][0..2] row by row, then K[3][3], K[4][4], K[5][5]
+    Real rotation[3][3][Size];          ///< output: rotation from the world to the deformed element frame (R_0_2)
+};
+
+/// Best instruction set supported by both this build and the running CPU
+SOFA_SIMPLE_FEM_API SimdInstructionSet getBestSimdInstructionSet();
+
+/// Human readable name of an instruction set
+SOFA_SIMPLE_FEM_API const char* getSimdInstructionSetName(SimdInstructionSet isa);
+
+/// Compute the rotation of the elements of the batches [first,last) from the positions x (3 reals per vertex),
+/// store it in each batch, and accumulate the elastic forces in f (3 reals per vertex).
+/// The batches are processed in order, lane after lane, so the accumulation order is deterministic.
+/// isa must not be better than getBestSimdInstructionSet().
+SOFA_SIMPLE_FEM_API void addCorotationalForces(SimdInstructionSet isa, RotationMethod method,
+                                               TetrahedronFEMBatch<float>* first, TetrahedronFEMBatch<float>* last,
+                                               const float* x, float* f);
+SOFA_SIMPLE_FEM_API void addCorotationalForces(SimdInstructionSet isa, RotationMethod method,
+                                               TetrahedronFEMBatch<double>* first, TetrahedronFEMBatch<double>* last,
+                                               const double* x, double* f);
+
+} // namespace tetrahedronfem
+
+} // namespace forcefield
+
+} // namespace component
+
+} // namespace sofa
+
+#endif // SOFA_COMPONENT_FORCEFIELD_TETRAHEDRONFEMFORCEFIELDSIMD_H
@@ -0,0 +1,275 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2019 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#ifndef SOFA_COMPONENT_FORCEFIELD_TETRAHEDRONFEMFORCEFIELDSIMD_INL
+#define SOFA_COMPONENT_FORCEFIELD_TETRAHEDRONFEMFORCEFIELDSIMD_INL
+
+#include "TetrahedronFEMForceFieldSimd.h"
+#include <limits>
+
+namespace sofa
+{
+
+namespace component
+{
+
+namespace forcefield
+{
+
+namespace tetrahedronfem
+{
+
+/// Batched corotational kernel, written once for all the instruction sets.
+///
+/// P is a pack of P::Width reals providing load, store, set, sqrt, abs, max, greater, notEqual,
+/// maskAnd, select, any and the arithmetic operators. Each translation unit compiled for an
+/// instruction set instantiates this kernel with its own packs, declared in an anonymous namespace.
+/// The code mirrors accumulateForceLarge, accumulateForcePolar and computeForce of TetrahedronFEMForceField,
+/// with the positions taken relative to the first vertex of each element.
+template<class P>
+struct CorotationalKernel
+{
+    typedef typename P::Real Real;
+    typedef typename P::Mask Mask;
+    typedef TetrahedronFEMBatch<Real> Batch;
+    enum { Size = Batch::Size, Width = P::Width };
+
+    /// maximum number of iterations of the polar decomposition (the scalar version has no limit)
+    enum { MaxPolarIterations = 64 };
+
+    static P dot(const P a[3], const P b[3])
+    {
+        return a[0]*b[0] + a[1]*b[1] + a[2]*b[2];
+    }
+
+    static void cross(const P a[3], const P b[3], P c[3])
+    {
+        c[0] = a[1]*b[2] - a[2]*b[1];
+        c[1] = a[2]*b[0] - a[0]*b[2];
+        c[2] = a[0]*b[1] - a[1]*b[0];
+    }
+
+    /// same as Vec::normalize: the vector is left unchanged when its norm is too small
+    static void normalize(P v[3])
+    {
+        const P one = P::set(Real(1));
+        const P norm = P::sqrt(dot(v, v));
+        const P scale = P::select(P::greater(norm, P::set(std::numeric_limits<Real>::epsilon())), one / norm, one);
+        v[0] = v[0] * scale;
+        v[1] = v[1] * scale;
+        v[2] = v[2] * scale;
+    }
+
+    static P oneNorm(const P m[3][3])
+    {
+        P norm = P::abs(m[0][0]) + P::abs(m[1][0]) + P::abs(m[2][0]);
+        norm = P::max(norm, P::abs(m[0][1]) + P::abs(m[1][1]) + P::abs(m[2][1]));
+        return P::max(norm, P::abs(m[0][2]) + P::abs(m[1][2]) + P::abs(m[2][2]));
+    }
+
+    static P infNorm(const P m[3][3])
+    {
+        P norm = P::abs(m[0][0]) + P::abs(m[0][1]) + P::abs(m[0][2]);
+        norm = P::max(norm, P::abs(m[1][0]) + P::abs(m[1][1]) + P::abs(m[1][2]));
+        return P::max(norm, P::abs(m[2][0]) + P::abs(m[2][1]) + P::abs(m[2][2]));
+    }
+
+    /// rotation of computeRotationLarge: rows are the first edge, the normal of the first face and their cross product
+    static void computeRotationLarge(const P e[3][3], P R[3][3])
+    {
+        P* ex = R[0];
+        P* ey = R[1];
+        P* ez = R[2];
+        for (int j = 0; j < 3; ++j)
+        {
+            ex[j] = e[0][j];
+            ey[j] = e[1][j];
+        }
+        normalize(ex);
+        normalize(ey);
+        cross(ex, ey, ez);
+        normalize(ez);
+        cross(ez, ex, ey);
+        normalize(ey);
+    }
+
+    /// rotation of helper::Decompose::polarDecomposition of the matrix whose rows are the edges.
+    /// The lanes stop iterating independently, when they reach the same criterion as the scalar version.
+    static void computeRotationPolar(const P e[3][3], P R[3][3])
+    {
+        const P zero = P::set(Real(0));
+        const P half = P::set(Real(0.5));
+        const P tolerance = P::set(Real(sizeof(Real) == sizeof(float) ? 1e-6 : 1e-8)); // Decompose<Real>::zeroTolerance()
+
+        // Mk = M^T
+        P Mk[3][3];
+        for (int i = 0; i < 3; ++i)
+            for (int j = 0; j < 3; ++j)
+                Mk[i][j] = e[j][i];
+
+        P M_oneNorm = oneNorm(Mk);
+        P M_infNorm = infNorm(Mk);
+        Mask active = P::greater(M_oneNorm, P::set(Real(-1))); // all the lanes
+
+        for (int iteration = 0; iteration < MaxPolarIterations && P::any(active); ++iteration)
+        {
+            P MadjTk[3][3];
+            cross(Mk[1], Mk[2], MadjTk[0]);
+            cross(Mk[2], Mk[0], MadjTk[1]);
+            cross(Mk[0], Mk[1], MadjTk[2]);
+
+            const P det = dot(Mk[0], MadjTk[0]);
+            active = P::maskAnd(active, P::notEqual(det, zero));
+
+            const P MadjT_one = oneNorm(MadjTk);
+            const P MadjT_inf = infNorm(MadjTk);
+            const P gamma = P::sqrt(P::sqrt((MadjT_one * MadjT_inf) / (M_oneNorm * M_infNorm)) / P::abs(det));
+            const P g1 = gamma * half;
+            const P g2 = half / (gamma * det);
+
+            P E_oneNorm = zero;
+            for (int j = 0; j < 3; ++j)
+            {
+                P columnAbsSum = zero;
+                for (int i = 0; i < 3; ++i)
+                {
+                    const P next = Mk[i][j] * g1 + MadjTk[i][j] * g2;
+                    columnAbsSum = columnAbsSum + P::abs(Mk[i][j] - next);
+                    Mk[i][j] = P::select(active, next, Mk[i][j]);
+                }
+                E_oneNorm = P::max(E_oneNorm, columnAbsSum);
+            }
+
+            M_oneNorm = oneNorm(Mk);
+            M_infNorm = infNorm(Mk);
+            active = P::maskAnd(active, P::greater(E_oneNorm, M_oneNorm * tolerance));
+        }
+
+        // R = Mk^T
+        for (int i = 0; i < 3; ++i)
+            for (int j = 0; j < 3; ++j)
+                R[i][j] = Mk[j][i];
+    }
+
+    /// compute the forces of the lanes [offset, offset+Width) of a batch, from its gathered positions
+    static void computeLanes(Batch& batch, RotationMethod method, const Real (&position)[4][3][Size],
+                             Real (&force)[4][3][Size], const int offset)
+    {
+        // edges from the first vertex
+        P e[3][3];
+        for (int k = 0; k < 3; ++k)
+        {
+            for (int j = 0; j < 3; ++j)
+            {
+                e[k][j] = P::load(&position[k+1][j][offset]) - P::load(&position[0][j][offset]);
+            }
+        }
+
+        P R[3][3];
+        if (method == ROTATION_LARGE)
+            computeRotationLarge(e, R);
+        else
+            computeRotationPolar(e, R);
+
+        for (int i = 0; i < 3; ++i)
+            for (int j = 0; j < 3; ++j)
+                P::store(&batch.rotation[i][j][offset], R[i][j]);
+
+        // displacement in the element frame, null for the first vertex
+        P D[3][3];
+        for (int k = 0; k < 3; ++k)
+        {
+            for (int i = 0; i < 3; ++i)
+            {
+                D[k][i] = P::load(&batch.restEdge[k][i][offset]) - (R[i][0]*e[k][0] + R[i][1]*e[k][1] + R[i][2]*e[k][2]);
+            }
+        }
+
+        // strain JtD
+        P a[4], b[4], c[4];
+        for (int v = 0; v < 4; ++v)
+        {
+            a[v] = P::load(&batch.shape[v][0][offset]);
+            b[v] = P::load(&batch.shape[v][1][offset]);
+            c[v] = P::load(&batch.shape[v][2][offset]);
+        }
+        P JtD[6];
+        JtD[0] = a[1]*D[0][0] + a[2]*D[1][0] + a[3]*D[2][0];
+        JtD[1] = b[1]*D[0][1] + b[2]*D[1][1] + b[3]*D[2][1];
+        JtD[2] = c[1]*D[0][2] + c[2]*D[1][2] + c[3]*D[2][2];
+        JtD[3] = b[1]*D[0][0] + a[1]*D[0][1] + b[2]*D[1][0] + a[2]*D[1][1] + b[3]*D[2][0] + a[3]*D[2][1];
+        JtD[4] = c[1]*D[0][1] + b[1]*D[0][2] + c[2]*D[1][1] + b[2]*D[1][2] + c[3]*D[2][1] + b[3]*D[2][2];
+        JtD[5] = c[1]*D[0][0] + a[1]*D[0][2] + c[2]*D[1][0] + a[2]*D[1][2] + c[3]*D[2][0] + a[3]*D[2][2];
+
+        // stress KJtD
+        P K[12];
+        for (int i = 0; i < 12; ++i)
+            K[i] = P::load(&batch.stiffness[i][offset]);
+        P KJtD[6];
+        KJtD[0] = K[0]*JtD[0] + K[1]*JtD[1] + K[2]*JtD[2];
+        KJtD[1] = K[3]*JtD[0] + K[4]*JtD[1] + K[5]*JtD[2];
+        KJtD[2] = K[6]*JtD[0] + K[7]*JtD[1] + K[8]*JtD[2];
+        KJtD[3] = K[9]*JtD[3];
+        KJtD[4] = K[10]*JtD[4];
+        KJtD[5] = K[11]*JtD[5];
+
+        // forces J*KJtD in the element frame, rotated back to the world frame
+        for (int v = 0; v < 4; ++v)
+        {
+            const P F0 = a[v]*KJtD[0] + b[v]*KJtD[3] + c[v]*KJtD[5];
+            const P F1 = b[v]*KJtD[1] + a[v]*KJtD[3] + c[v]*KJtD[4];
+            const P F2 = c[v]*KJtD[2] + b[v]*KJtD[4] + a[v]*KJtD[5];
+            for (int j = 0; j < 3; ++j)
+                P::store(&force[v][j][offset], R[0][j]*F0 + R[1][j]*F1 + R[2][j]*F2);
+        }
+    }
+
+    static void addForces(RotationMethod method, Batch* first, Batch* last, const Real* x, Real* f)
+    {
+        Real position[4][3][Size];
+        Real force[4][3][Size];
+        for (Batch* batch = first; batch != last; ++batch)
+        {
+            for (int v = 0; v < 4; ++v)
+                for (int l = 0; l < Size; ++l)
+                    for (int j = 0; j < 3; ++j)
+                        position[v][j][l] = x[3*batch->vertex[v][l] + j];
+
+            for (int offset = 0; offset < Size; offset += Width)
+                computeLanes(*batch, method, position, force, offset);
+
+            for (unsigned int l = 0; l < batch->nbElements; ++l)
+                for (int v = 0; v < 4; ++v)
+                    for (int j = 0; j < 3; ++j)
+                        f[3*batch->vertex[v][l] + j] += force[v][j][l];
+        }
+    }
+};
+
+} // namespace tetrahedronfem
+
+} // namespace forcefield
+
+} // namespace component
+
+} // namespace sofa
+
+#endif // SOFA_COMPONENT_FORCEFIELD_TETRAHEDRONFEMFORCEFIELDSIMD_INL
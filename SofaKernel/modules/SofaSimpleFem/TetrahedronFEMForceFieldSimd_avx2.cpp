@@ -0,0 +1,125 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2019 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+// This file is compiled with the AVX2 and FMA instruction sets enabled (see CMakeLists.txt):
+// only the anonymous namespace and the kernel instantiated on its packs may be defined here,
+// any inline function shared with the other translation units could be compiled with AVX2 instructions.
+#include "TetrahedronFEMForceFieldSimd.inl"
+
+#ifdef __AVX2__
+#include <immintrin.h>
+
+namespace sofa
+{
+
+namespace component
+{
+
+namespace forcefield
+{
+
+namespace tetrahedronfem
+{
+
+namespace
+{
+
+/// 4 doubles in an AVX register
+struct PackAVX2d
+{
+    typedef double Real;
+    typedef PackAVX2d Mask;
+    enum { Width = 4 };
+
+    __m256d v;
+
+    PackAVX2d() {}
+    PackAVX2d(__m256d value) : v(value) {}
+
+    static PackAVX2d load(const double* p) { return _mm256_loadu_pd(p); }
+    static void store(double* p, const PackAVX2d a) { _mm256_storeu_pd(p, a.v); }
+    static PackAVX2d set(const double a) { return _mm256_set1_pd(a); }
+    static PackAVX2d sqrt(const PackAVX2d a) { return _mm256_sqrt_pd(a.v); }
+    static PackAVX2d abs(const PackAVX2d a) { return _mm256_andnot_pd(_mm256_set1_pd(-0.0), a.v); }
+    static PackAVX2d max(const PackAVX2d a, const PackAVX2d b) { return _mm256_max_pd(a.v, b.v); }
+    static Mask greater(const PackAVX2d a, const PackAVX2d b) { return _mm256_cmp_pd(a.v, b.v, _CMP_GT_OQ); }
+    static Mask notEqual(const PackAVX2d a, const PackAVX2d b) { return _mm256_cmp_pd(a.v, b.v, _CMP_NEQ_UQ); }
+    static Mask maskAnd(const Mask a, const Mask b) { return _mm256_and_pd(a.v, b.v); }
+    static PackAVX2d select(const Mask m, const PackAVX2d a, const PackAVX2d b) { return _mm256_blendv_pd(b.v, a.v, m.v); }
+    static bool any(const Mask m) { return _mm256_movemask_pd(m.v) != 0; }
+
+    friend PackAVX2d operator+(const PackAVX2d a, const PackAVX2d b) { return _mm256_add_pd(a.v, b.v); }
+    friend PackAVX2d operator-(const PackAVX2d a, const PackAVX2d b) { return _mm256_sub_pd(a.v, b.v); }
+    friend PackAVX2d operator*(const PackAVX2d a, const PackAVX2d b) { return _mm256_mul_pd(a.v, b.v); }
+    friend PackAVX2d operator/(const PackAVX2d a, const PackAVX2d b) { return _mm256_div_pd(a.v, b.v); }
+};
+
+/// 8 floats in an AVX register
+struct PackAVX2f
+{
+    typedef float Real;
+    typedef PackAVX2f Mask;
+    enum { Width = 8 };
+
+    __m256 v;
+
+    PackAVX2f() {}
+    PackAVX2f(__m256 value) : v(value) {}
+
+    static PackAVX2f load(const float* p) { return _mm256_loadu_ps(p); }
+    static void store(float* p, const PackAVX2f a) { _mm256_storeu_ps(p, a.v); }
+    static PackAVX2f set(const float a) { return _mm256_set1_ps(a); }
+    static PackAVX2f sqrt(const PackAVX2f a) { return _mm256_sqrt_ps(a.v); }
+    static PackAVX2f abs(const PackAVX2f a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a.v); }
+    static PackAVX2f max(const PackAVX2f a, const PackAVX2f b) { return _mm256_max_ps(a.v, b.v); }
+    static Mask greater(const PackAVX2f a, const PackAVX2f b) { return _mm256_cmp_ps(a.v, b.v, _CMP_GT_OQ); }
+    static Mask notEqual(const PackAVX2f a, const PackAVX2f b) { return _mm256_cmp_ps(a.v, b.v, _CMP_NEQ_UQ); }
+    static Mask maskAnd(const Mask a, const Mask b) { return _mm256_and_ps(a.v, b.v); }
+    static PackAVX2f select(const Mask m, const PackAVX2f a, const PackAVX2f b) { return _mm256_blendv_ps(b.v, a.v, m.v); }
+    static bool any(const Mask m) { return _mm256_movemask_ps(m.v) != 0; }
+
+    friend PackAVX2f operator+(const PackAVX2f a, const PackAVX2f b) { return _mm256_add_ps(a.v, b.v); }
+    friend PackAVX2f operator-(const PackAVX2f a, const PackAVX2f b) { return _mm256_sub_ps(a.v, b.v); }
+    friend PackAVX2f operator*(const PackAVX2f a, const PackAVX2f b) { return _mm256_mul_ps(a.v, b.v); }
+    friend PackAVX2f operator/(const PackAVX2f a, const PackAVX2f b) { return _mm256_div_ps(a.v, b.v); }
+};
+
+} // anonymous namespace
+
+void addCorotationalForcesAVX2(RotationMethod method, TetrahedronFEMBatch<float>* first, TetrahedronFEMBatch<float>* last, const float* x, float* f)
+{
+    CorotationalKernel<PackAVX2f>::addForces(method, first, last, x, f);
+}
+
+void addCorotationalForcesAVX2(RotationMethod method, TetrahedronFEMBatch<double>* first, TetrahedronFEMBatch<double>* last, const double* x, double* f)
+{
+    CorotationalKernel<PackAVX2d>::addForces(method, first, last, x, f);
+}
+
+} // namespace tetrahedronfem
+
+} // namespace forcefield
+
+} // namespace component
+
+} // namespace sofa
+
+#endif // __AVX2__
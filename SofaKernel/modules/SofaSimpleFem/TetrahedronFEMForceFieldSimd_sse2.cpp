@@ -0,0 +1,122 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2019 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#include "TetrahedronFEMForceFieldSimd.inl"
+
+#ifdef SOFA_SIMPLE_FEM_HAVE_SSE2
+#include <emmintrin.h>
+
+namespace sofa
+{
+
+namespace component
+{
+
+namespace forcefield
+{
+
+namespace tetrahedronfem
+{
+
+namespace
+{
+
+/// 2 doubles in a SSE2 register
+struct PackSSE2d
+{
+    typedef double Real;
+    typedef PackSSE2d Mask;
+    enum { Width = 2 };
+
+    __m128d v;
+
+    PackSSE2d() {}
+    PackSSE2d(__m128d value) : v(value) {}
+
+    static PackSSE2d load(const double* p) { return _mm_loadu_pd(p); }
+    static void store(double* p, const PackSSE2d a) { _mm_storeu_pd(p, a.v); }
+    static PackSSE2d set(const double a) { return _mm_set1_pd(a); }
+    static PackSSE2d sqrt(const PackSSE2d a) { return _mm_sqrt_pd(a.v); }
+    static PackSSE2d abs(const PackSSE2d a) { return _mm_andnot_pd(_mm_set1_pd(-0.0), a.v); }
+    static PackSSE2d max(const PackSSE2d a, const PackSSE2d b) { return _mm_max_pd(a.v, b.v); }
+    static Mask greater(const PackSSE2d a, const PackSSE2d b) { return _mm_cmpgt_pd(a.v, b.v); }
+    static Mask notEqual(const PackSSE2d a, const PackSSE2d b) { return _mm_cmpneq_pd(a.v, b.v); }
+    static Mask maskAnd(const Mask a, const Mask b) { return _mm_and_pd(a.v, b.v); }
+    static PackSSE2d select(const Mask m, const PackSSE2d a, const PackSSE2d b) { return _mm_or_pd(_mm_and_pd(m.v, a.v), _mm_andnot_pd(m.v, b.v)); }
+    static bool any(const Mask m) { return _mm_movemask_pd(m.v) != 0; }
+
+    friend PackSSE2d operator+(const PackSSE2d a, const PackSSE2d b) { return _mm_add_pd(a.v, b.v); }
+    friend PackSSE2d operator-(const PackSSE2d a, const PackSSE2d b) { return _mm_sub_pd(a.v, b.v); }
+    friend PackSSE2d operator*(const PackSSE2d a, const PackSSE2d b) { return _mm_mul_pd(a.v, b.v); }
+    friend PackSSE2d operator/(const PackSSE2d a, const PackSSE2d b) { return _mm_div_pd(a.v, b.v); }
+};
+
+/// 4 floats in a SSE2 register
+struct PackSSE2f
+{
+    typedef float Real;
+    typedef PackSSE2f Mask;
+    enum { Width = 4 };
+
+    __m128 v;
+
+    PackSSE2f() {}
+    PackSSE2f(__m128 value) : v(value) {}
+
+    static PackSSE2f load(const float* p) { return _mm_loadu_ps(p); }
+    static void store(float* p, const PackSSE2f a) { _mm_storeu_ps(p, a.v); }
+    static PackSSE2f set(const float a) { return _mm_set1_ps(a); }
+    static PackSSE2f sqrt(const PackSSE2f a) { return _mm_sqrt_ps(a.v); }
+    static PackSSE2f abs(const PackSSE2f a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a.v); }
+    static PackSSE2f max(const PackSSE2f a, const PackSSE2f b) { return _mm_max_ps(a.v, b.v); }
+    static Mask greater(const PackSSE2f a, const PackSSE2f b) { return _mm_cmpgt_ps(a.v, b.v); }
+    static Mask notEqual(const PackSSE2f a, const PackSSE2f b) { return _mm_cmpneq_ps(a.v, b.v); }
+    static Mask maskAnd(const Mask a, const Mask b) { return _mm_and_ps(a.v, b.v); }
+    static PackSSE2f select(const Mask m, const PackSSE2f a, const PackSSE2f b) { return _mm_or_ps(_mm_and_ps(m.v, a.v), _mm_andnot_ps(m.v, b.v)); }
+    static bool any(const Mask m) { return _mm_movemask_ps(m.v) != 0; }
+
+    friend PackSSE2f operator+(const PackSSE2f a, const PackSSE2f b) { return _mm_add_ps(a.v, b.v); }
+    friend PackSSE2f operator-(const PackSSE2f a, const PackSSE2f b) { return _mm_sub_ps(a.v, b.v); }
+    friend PackSSE2f operator*(const PackSSE2f a, const PackSSE2f b) { return _mm_mul_ps(a.v, b.v); }
+    friend PackSSE2f operator/(const PackSSE2f a, const PackSSE2f b) { return _mm_div_ps(a.v, b.v); }
+};
+
+} // anonymous namespace
+
+void addCorotationalForcesSSE2(RotationMethod method, TetrahedronFEMBatch<float>* first, TetrahedronFEMBatch<float>* last, const float* x, float* f)
+{
+    CorotationalKernel<PackSSE2f>::addForces(method, first, last, x, f);
+}
+
+void addCorotationalForcesSSE2(RotationMethod method, TetrahedronFEMBatch<double>* first, TetrahedronFEMBatch<double>* last, const double* x, double* f)
+{
+    CorotationalKernel<PackSSE2d>::addForces(method, first, last, x, f);
+}
+
+} // namespace tetrahedronfem
+
+} // namespace forcefield
+
+} // namespace component
+
+} // namespace sofa
+
+#endif // SOFA_SIMPLE_FEM_HAVE_SSE2
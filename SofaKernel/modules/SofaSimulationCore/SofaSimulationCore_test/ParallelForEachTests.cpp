@@ -0,0 +1,78 @@
+#include <sofa/simulation/ParallelForEach.h>
+#include <sofa/simulation/DefaultTaskScheduler.h>
+#include <sofa/helper/testing/BaseTest.h>
+
+#include <vector>
+
+namespace sofa
+{
+
+    // every index of the range is visited exactly once
+    static void checkEachIndexVisitedOnce(const unsigned int nbThread, const std::size_t grainSize)
+    {
+        simulation::TaskScheduler* scheduler = simulation::TaskScheduler::create(simulation::DefaultTaskScheduler::name());
+        scheduler->init(nbThread);
+        
+        const std::size_t first = 3;
+        const std::size_t last = 10000;
+        std::vector<int> visits(last, 0);
+        
+        simulation::parallelForEach(*scheduler, first, last, [&visits](const std::size_t i)
+        {
+            ++visits[i];
+        }, grainSize);
+        
+        scheduler->stop();
+        
+        for (std::size_t i = 0; i < last; ++i)
+        {
+            EXPECT_EQ(visits[i], i < first ? 0 : 1);
+        }
+    }
+    
+    TEST(ParallelForEachTests, Single)
+    {
+        checkEachIndexVisitedOnce(1, 1);
+        return;
+    }
+    
+    TEST(ParallelForEachTests, Multi)
+    {
+        checkEachIndexVisitedOnce(4, 1);
+        checkEachIndexVisitedOnce(4, 64);
+        checkEachIndexVisitedOnce(4, 100000);
+        return;
+    }
+    
+    // the chunks are contiguous and cover the range
+    TEST(ParallelForEachTests, Range)
+    {
+        simulation::TaskScheduler* scheduler = simulation::TaskScheduler::create(simulation::DefaultTaskScheduler::name());
+        scheduler->init(4);
+        
+        const std::size_t last = 1000;
+        std::vector<int> visits(last, 0);
+        std::atomic<std::size_t> total(0);
+        
+        simulation::parallelForEachRange(*scheduler, 0, last, [&](const std::size_t chunkFirst, const std::size_t chunkLast)
+        {
+            EXPECT_LT(chunkFirst, chunkLast);
+            for (std::size_t i = chunkFirst; i < chunkLast; ++i)
+            {
+                ++visits[i];
+            }
+            total += chunkLast - chunkFirst;
+        }, 10);
+        
+        scheduler->stop();
+        
+        EXPECT_EQ(total.load(), last);
+        for (std::size_t i = 0; i < last; ++i)
+        {
+            EXPECT_EQ(visits[i], 1);
+        }
+        return;
+    }
+    
+
+} // namespace sofa
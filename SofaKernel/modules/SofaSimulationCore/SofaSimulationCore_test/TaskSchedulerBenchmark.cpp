@@ -0,0 +1,317 @@
+/******************************************************************************
+* Micro-benchmark of the task queues on fork/join trees.
+*
+* The same binary tree of lightweight tasks (recursive sum of the integers
+* from 1 to N, see IntSumTask) is run:
+*  - on a minimal work-stealing pool using the previous spin-locked std::deque,
+*  - on the same pool using the lock-free WorkStealingDeque,
+*  - on the DefaultTaskScheduler,
+*  - on the DefaultTaskScheduler recording its tasks with the TraceRecorder,
+*    to estimate the cost of a trace event.
+*
+* usage: SofaSimulationCore_benchmark [nbThreads] [log2(N)] [repetitions]
+******************************************************************************/
+#include "TaskSchedulerTestTasks.h"
+
+#include <sofa/simulation/TaskScheduler.h>
+#include <sofa/simulation/DefaultTaskScheduler.h>
+#include <sofa/simulation/WorkStealingDeque.h>
+#include <sofa/simulation/Locks.h>
+#include <sofa/helper/TraceRecorder.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <deque>
+#include <memory>
+#include <iostream>
+#include <iomanip>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    using namespace sofa::simulation;
+    
+    
+    // the task queue of the DefaultTaskScheduler before the lock-free deque
+    template<class T>
+    class SpinLockDeque
+    {
+    public:
+        
+        explicit SpinLockDeque(std::int64_t) {}
+        
+        void push(T item)
+        {
+            ScopedLock lock(m_mutex);
+            m_items.push_back(item);
+        }
+        
+        bool pop(T& item)
+        {
+            ScopedLock lock(m_mutex);
+            if (m_items.empty())
+                return false;
+            item = m_items.back();
+            m_items.pop_back();
+            return true;
+        }
+        
+        bool steal(T& item)
+        {
+            ScopedLock lock(m_mutex);
+            if (m_items.empty())
+                return false;
+            item = m_items.front();
+            m_items.pop_front();
+            return true;
+        }
+        
+    private:
+        
+        SpinLock m_mutex;
+        std::deque<T> m_items;
+    };
+    
+    
+    // minimal fork/join pool: same scheduling policy as the DefaultTaskScheduler
+    // (LIFO pop, FIFO steal from a random victim, exponential backoff), only the queue changes
+    template<template<class> class Deque>
+    class ForkJoinPool
+    {
+    public:
+        
+        class Worker;
+        
+        class SumJob
+        {
+        public:
+            SumJob(const std::int64_t first, const std::int64_t last, std::int64_t* const sum, std::atomic<int>* pending)
+            : m_first(first), m_last(last), m_sum(sum), m_pending(pending)
+            {}
+            
+            void run(Worker& worker)
+            {
+                const std::int64_t count = m_last - m_first;
+                if (count < 1)
+                {
+                    *m_sum = m_first;
+                }
+                else
+                {
+                    const std::int64_t mid = m_first + (count / 2);
+                    std::int64_t x, y;
+                    std::atomic<int> pending(2);
+                    SumJob job0(m_first, mid, &x, &pending);
+                    SumJob job1(mid + 1, m_last, &y, &pending);
+                    worker.push(&job0);
+                    worker.push(&job1);
+                    worker.workUntilDone(pending);
+                    *m_sum = x + y;
+                }
+                m_pending->fetch_sub(1, std::memory_order_release);
+            }
+            
+        private:
+            const std::int64_t m_first;
+            const std::int64_t m_last;
+            std::int64_t* const m_sum;
+            std::atomic<int>* m_pending;
+        };
+        
+        class Worker
+        {
+        public:
+            Worker(ForkJoinPool* pool, const std::uint32_t index)
+            : m_pool(pool), m_queue(256), m_randomState(index * 2654435761u + 1u)
+            {}
+            
+            void push(SumJob* job) { m_queue.push(job); }
+            
+            void workUntilDone(const std::atomic<int>& pending)
+            {
+                ExponentialBackoff backoff;
+                while (pending.load(std::memory_order_acquire) > 0)
+                {
+                    SumJob* job;
+                    if (m_queue.pop(job) || steal(job))
+                    {
+                        job->run(*this);
+                        backoff.reset();
+                    }
+                    else
+                    {
+                        backoff.pause();
+                    }
+                }
+            }
+            
+            void loop()
+            {
+                ExponentialBackoff backoff;
+                while (!m_pool->m_stop.load(std::memory_order_relaxed))
+                {
+                    SumJob* job;
+                    if (m_queue.pop(job) || steal(job))
+                    {
+                        job->run(*this);
+                        backoff.reset();
+                    }
+                    else
+                    {
+                        backoff.pause();
+                    }
+                }
+            }
+            
+        private:
+            
+            bool steal(SumJob*& job)
+            {
+                const std::size_t count = m_pool->m_workers.size();
+                std::uint32_t x = m_randomState;
+                x ^= x << 13; x ^= x >> 17; x ^= x << 5;
+                m_randomState = x;
+                for (std::size_t i = 0; i < count; ++i)
+                {
+                    Worker* victim = m_pool->m_workers[(x + i) % count].get();
+                    if (victim != this && victim->m_queue.steal(job))
+                        return true;
+                }
+                return false;
+            }
+            
+            ForkJoinPool* m_pool;
+            Deque<SumJob*> m_queue;
+            std::uint32_t m_randomState;
+        };
+        
+        explicit ForkJoinPool(const unsigned int nbThreads)
+        : m_stop(false)
+        {
+            for (unsigned int i = 0; i < nbThreads; ++i)
+            {
+                m_workers.emplace_back(new Worker(this, i));
+            }
+            // worker 0 is the calling thread
+            for (unsigned int i = 1; i < nbThreads; ++i)
+            {
+                Worker* worker = m_workers[i].get();
+                m_threads.emplace_back([worker]() { worker->loop(); });
+            }
+        }
+        
+        ~ForkJoinPool()
+        {
+            m_stop.store(true);
+            for (auto& thread : m_threads)
+            {
+                thread.join();
+            }
+        }
+        
+        std::int64_t sum(const std::int64_t N)
+        {
+            std::int64_t result = 0;
+            std::atomic<int> pending(1);
+            SumJob root(1, N, &result, &pending);
+            m_workers[0]->push(&root);
+            m_workers[0]->workUntilDone(pending);
+            return result;
+        }
+        
+    private:
+        
+        std::atomic<bool> m_stop;
+        std::vector< std::unique_ptr<Worker> > m_workers;
+        std::vector<std::thread> m_threads;
+    };
+    
+    
+    struct Timing
+    {
+        double min;
+        double median;
+        bool valid;
+    };
+    
+    template<class Function>
+    Timing measure(Function run, const std::int64_t N, const int repetitions)
+    {
+        std::vector<double> times;
+        bool valid = true;
+        for (int i = 0; i < repetitions; ++i)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            const std::int64_t result = run(N);
+            const auto end = std::chrono::steady_clock::now();
+            times.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+            valid = valid && (result == N * (N + 1) / 2);
+        }
+        std::sort(times.begin(), times.end());
+        return { times.front(), times[times.size() / 2], valid };
+    }
+    
+    void print(const char* name, const Timing& timing)
+    {
+        std::cout << std::left << std::setw(28) << name
+                  << std::right << std::fixed << std::setprecision(3)
+                  << std::setw(12) << timing.min
+                  << std::setw(12) << timing.median
+                  << (timing.valid ? "" : "   WRONG RESULT") << std::endl;
+    }
+    
+} // namespace
+
+
+int main(int argc, char** argv)
+{
+    const unsigned int hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+    const unsigned int nbThreads = argc > 1 ? unsigned(std::atoi(argv[1])) : hardwareThreads;
+    const int log2N = argc > 2 ? std::atoi(argv[2]) : 20;
+    const int repetitions = argc > 3 ? std::atoi(argv[3]) : 10;
+    const std::int64_t N = std::int64_t(1) << log2N;
+    
+    std::cout << "fork/join tree of " << 2 * N - 1 << " tasks, " << nbThreads << " threads, "
+              << repetitions << " repetitions" << std::endl;
+    std::cout << std::left << std::setw(28) << "queue"
+              << std::right << std::setw(12) << "min (ms)" << std::setw(12) << "median (ms)" << std::endl;
+    
+    {
+        ForkJoinPool<SpinLockDeque> pool(nbThreads);
+        print("spinlock std::deque", measure([&](std::int64_t n) { return pool.sum(n); }, N, repetitions));
+    }
+    {
+        ForkJoinPool<WorkStealingDeque> pool(nbThreads);
+        print("lock-free Chase-Lev deque", measure([&](std::int64_t n) { return pool.sum(n); }, N, repetitions));
+    }
+    {
+        TaskScheduler* scheduler = TaskScheduler::create(DefaultTaskScheduler::name());
+        scheduler->init(nbThreads);
+        auto run = [&](std::int64_t n)
+        {
+            CpuTask::Status status;
+            std::int64_t result = 0;
+            sofa::IntSumTask task(1, n, &result, &status);
+            scheduler->addTask(&task);
+            scheduler->workUntilDone(&status);
+            return result;
+        };
+        const Timing untraced = measure(run, N, repetitions);
+        print("DefaultTaskScheduler", untraced);
+        
+        sofa::helper::TraceRecorder::setEnabled(true);
+        const Timing traced = measure(run, N, repetitions);
+        sofa::helper::TraceRecorder::setEnabled(false);
+        print("DefaultTaskScheduler traced", traced);
+        
+        // two events per task, recorded in parallel by the threads
+        const double nbEventsPerThread = 2.0 * double(2 * N - 1) / nbThreads;
+        std::cout << "trace event cost: " << std::setprecision(1)
+                  << (traced.min - untraced.min) * 1e6 / nbEventsPerThread << " ns" << std::endl;
+        scheduler->stop();
+    }
+    
+    return 0;
+}
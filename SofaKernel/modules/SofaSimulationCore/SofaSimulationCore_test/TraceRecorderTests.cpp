@@ -0,0 +1,107 @@
+#include "TaskSchedulerTestTasks.h"
+
+#include <sofa/simulation/TaskScheduler.h>
+#include <sofa/simulation/DefaultTaskScheduler.h>
+#include <sofa/helper/TraceRecorder.h>
+#include <sofa/helper/AdvancedTimer.h>
+#include <sofa/helper/testing/BaseTest.h>
+
+#include <sstream>
+#include <thread>
+
+namespace sofa
+{
+
+    using helper::TraceRecorder;
+
+    static std::size_t countOccurrences(const std::string& str, const std::string& pattern)
+    {
+        std::size_t count = 0;
+        for (std::size_t pos = str.find(pattern); pos != std::string::npos; pos = str.find(pattern, pos + 1))
+            ++count;
+        return count;
+    }
+
+    static std::string writeTrace()
+    {
+        std::ostringstream out;
+        TraceRecorder::writeChromeTrace(out);
+        return out.str();
+    }
+
+
+    // the tasks are recorded on the timelines of the named worker threads
+    TEST(TraceRecorderTests, WorkerThreads)
+    {
+        TraceRecorder::clear();
+        TraceRecorder::setEnabled(true);
+
+        simulation::TaskScheduler* scheduler = simulation::TaskScheduler::create(simulation::DefaultTaskScheduler::name());
+        scheduler->init(4);
+        simulation::CpuTask::Status status;
+        int64_t result = 0;
+        IntSumTask task(1, 1 << 12, &result, &status);
+        scheduler->addTask(&task);
+        scheduler->workUntilDone(&status);
+        scheduler->stop();
+
+        TraceRecorder::setEnabled(false);
+        const std::string trace = writeTrace();
+
+        EXPECT_EQ(0u, trace.find("{\"traceEvents\":["));
+        EXPECT_NE(std::string::npos, trace.find("\"args\":{\"name\":\"Main\"}"));
+        EXPECT_NE(std::string::npos, trace.find("\"args\":{\"name\":\"Worker1\"}"));
+        const std::size_t nbBegin = countOccurrences(trace, "\"name\":\"Task\",\"ph\":\"B\"");
+        EXPECT_LT(0u, nbBegin);
+        EXPECT_EQ(nbBegin, countOccurrences(trace, "\"name\":\"Task\",\"ph\":\"E\""));
+    }
+
+    // the AdvancedTimer steps are recorded even without an active timer
+    TEST(TraceRecorderTests, AdvancedTimerSteps)
+    {
+        TraceRecorder::clear();
+        TraceRecorder::setEnabled(true);
+        helper::AdvancedTimer::stepBegin("TraceRecorderStep");
+        helper::AdvancedTimer::step("TraceRecorder \"event\"");
+        helper::AdvancedTimer::stepEnd("TraceRecorderStep");
+        TraceRecorder::setEnabled(false);
+        helper::AdvancedTimer::stepBegin("TraceRecorderDisabled");
+        helper::AdvancedTimer::stepEnd("TraceRecorderDisabled");
+
+        const std::string trace = writeTrace();
+        EXPECT_EQ(1u, countOccurrences(trace, "\"name\":\"TraceRecorderStep\",\"ph\":\"B\""));
+        EXPECT_EQ(1u, countOccurrences(trace, "\"name\":\"TraceRecorderStep\",\"ph\":\"E\""));
+        EXPECT_EQ(1u, countOccurrences(trace, "\"name\":\"TraceRecorder \\\"event\\\"\",\"ph\":\"i\""));
+        EXPECT_EQ(std::string::npos, trace.find("TraceRecorderDisabled"));
+    }
+
+    // only the last events are kept, without the ends of the overwritten spans
+    TEST(TraceRecorderTests, RingBuffer)
+    {
+        const std::size_t bufferSize = TraceRecorder::getBufferSize();
+        TraceRecorder::setBufferSize(16);
+        TraceRecorder::clear();
+        TraceRecorder::setEnabled(true);
+        std::thread thread([]()
+        {
+            TraceRecorder::setThreadName("RingBuffer");
+            TraceRecorder::begin("Outer");
+            for (int i = 0; i < 100; ++i)
+            {
+                TraceRecorder::begin("Inner");
+                TraceRecorder::end("Inner");
+            }
+            TraceRecorder::end("Outer");
+        });
+        thread.join();
+        TraceRecorder::setEnabled(false);
+        TraceRecorder::setBufferSize(bufferSize);
+
+        const std::string trace = writeTrace();
+        EXPECT_NE(std::string::npos, trace.find("\"args\":{\"name\":\"RingBuffer\"}"));
+        EXPECT_EQ(0u, countOccurrences(trace, "\"name\":\"Outer\""));
+        EXPECT_EQ(7u, countOccurrences(trace, "\"name\":\"Inner\",\"ph\":\"B\""));
+        EXPECT_EQ(7u, countOccurrences(trace, "\"name\":\"Inner\",\"ph\":\"E\""));
+    }
+
+} // namespace sofa
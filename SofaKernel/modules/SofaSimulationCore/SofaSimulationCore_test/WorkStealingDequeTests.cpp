@@ -0,0 +1,132 @@
+#include <sofa/simulation/WorkStealingDeque.h>
+#include <sofa/helper/testing/BaseTest.h>
+
+#include <thread>
+#include <vector>
+#include <atomic>
+
+namespace sofa
+{
+
+    using simulation::WorkStealingDeque;
+    
+    
+    // the owner pops in LIFO order and the thieves steal in FIFO order
+    TEST(WorkStealingDequeTests, PopAndStealOrder)
+    {
+        WorkStealingDeque<int> deque(4);
+        for (int i = 0; i < 3; ++i)
+        {
+            deque.push(i);
+        }
+        EXPECT_EQ(deque.size(), 3);
+        
+        int item = -1;
+        EXPECT_TRUE(deque.steal(item));
+        EXPECT_EQ(item, 0);
+        EXPECT_TRUE(deque.pop(item));
+        EXPECT_EQ(item, 2);
+        EXPECT_TRUE(deque.pop(item));
+        EXPECT_EQ(item, 1);
+        
+        EXPECT_FALSE(deque.pop(item));
+        EXPECT_FALSE(deque.steal(item));
+        EXPECT_TRUE(deque.empty());
+        return;
+    }
+    
+    // pushing above the initial capacity grows the buffer and keeps all the items
+    TEST(WorkStealingDequeTests, Grow)
+    {
+        WorkStealingDeque<int> deque(4);
+        EXPECT_EQ(deque.capacity(), 4);
+        
+        // move top away from 0 so that the copy wraps around the circular buffer
+        int item = -1;
+        deque.push(-1);
+        deque.push(-2);
+        EXPECT_TRUE(deque.steal(item));
+        EXPECT_TRUE(deque.steal(item));
+        
+        const int N = 1000;
+        for (int i = 0; i < N; ++i)
+        {
+            deque.push(i);
+        }
+        EXPECT_GE(deque.capacity(), N);
+        EXPECT_EQ(deque.size(), N);
+        
+        for (int i = N - 1; i >= 0; --i)
+        {
+            EXPECT_TRUE(deque.pop(item));
+            EXPECT_EQ(item, i);
+        }
+        EXPECT_TRUE(deque.empty());
+        return;
+    }
+    
+    // concurrent thieves: every pushed item is taken exactly once
+    TEST(WorkStealingDequeTests, ConcurrentSteal)
+    {
+        const int N = 1 << 16;
+        const int nbThieves = 3;
+        
+        WorkStealingDeque<int> deque(16);
+        std::vector< std::atomic<int> > taken(N);
+        for (auto& t : taken)
+        {
+            t.store(0);
+        }
+        
+        std::atomic<bool> done(false);
+        std::vector<std::thread> thieves;
+        for (int i = 0; i < nbThieves; ++i)
+        {
+            thieves.emplace_back([&]()
+            {
+                int item;
+                while (!done.load() || !deque.empty())
+                {
+                    if (deque.steal(item))
+                    {
+                        taken[item].fetch_add(1);
+                    }
+                }
+            });
+        }
+        
+        // the owner interleaves pushes and pops
+        int item;
+        for (int i = 0; i < N; ++i)
+        {
+            deque.push(i);
+            if ((i % 3) == 0 && deque.pop(item))
+            {
+                taken[item].fetch_add(1);
+            }
+        }
+        while (deque.pop(item))
+        {
+            taken[item].fetch_add(1);
+        }
+        done.store(true);
+        
+        for (auto& thief : thieves)
+        {
+            thief.join();
+        }
+        
+        int errors = 0;
+        for (auto& t : taken)
+        {
+            if (t.load() != 1)
+            {
+                ++errors;
+            }
+        }
+        EXPECT_EQ(errors, 0);
+        return;
+    }
+    
+
+} // namespace sofa
@@ -48,6 +48,7 @@ AnimateVisitor::AnimateVisitor(const core::ExecParams* params, SReal dt)
     : Visitor(params)
     , dt(dt)
     , firstNodeVisited(false)
+    , deferredNodes(nullptr)
 {
 }
 
@@ -55,6 +56,7 @@ AnimateVisitor::AnimateVisitor(const core::ExecParams* params)
     : Visitor(params)
     , dt(0)
     , firstNodeVisited(false)
+    , deferredNodes(nullptr)
 {
 }
 
@@ -136,58 +138,76 @@ Visitor::Result AnimateVisitor::processNodeTopDown(simulation::Node* node)
     }
     if (!node->solver.empty() )
     {
-        sofa::helper::AdvancedTimer::StepVar timer("Mechanical",node);
-        SReal nextTime = node->getTime() + dt;
-        {
-            IntegrateBeginEvent evBegin;
-            PropagateEventVisitor eventPropagation( this->params, &evBegin);
-            eventPropagation.execute(node);
-        }
-
-        MechanicalBeginIntegrationVisitor beginVisitor(this->params, dt);
-        node->execute(&beginVisitor);
-
-        sofa::core::MechanicalParams m_mparams(*this->params);
-        m_mparams.setDt(dt);
-
-        {
-            unsigned int constraintId=0;
-            core::ConstraintParams cparams;
-            simulation::MechanicalAccumulateConstraint(&cparams, core::MatrixDerivId::constraintJacobian(),constraintId).execute(node);
-        }
-
-        for( unsigned i=0; i<node->solver.size(); i++ )
-        {
-            ctime_t t0 = begin(node, node->solver[i]);
-            node->solver[i]->solve(params, getDt());
-            end(node, node->solver[i], t0);
-        }
-
-        MechanicalProjectPositionAndVelocityVisitor(&m_mparams, nextTime,
-                                                    sofa::core::VecCoordId::position(), sofa::core::VecDerivId::velocity()
-                                                    ).execute( node );
-        MechanicalPropagateOnlyPositionAndVelocityVisitor(&m_mparams, nextTime,
-                                                          VecCoordId::position(),
-                                                          VecDerivId::velocity(), true).execute( node );
-
-        MechanicalEndIntegrationVisitor endVisitor(this->params, dt);
-        node->execute(&endVisitor);
-
-        {
-            IntegrateEndEvent evBegin;
-            PropagateEventVisitor eventPropagation(this->params, &evBegin);
-            eventPropagation.execute(node);
-        }
-
+        if (deferredNodes)
+            deferredNodes->push_back(node);
+        else
+            solveNode(node);
         return RESULT_PRUNE;
     }
     {
         // process InteractionForceFields
-        for_each(this, node, node->interactionForceField, &AnimateVisitor::fwdInteractionForceField);
+        if (deferredNodes && !node->interactionForceField.empty())
+            deferredNodes->push_back(node);
+        else
+            for_each(this, node, node->interactionForceField, &AnimateVisitor::fwdInteractionForceField);
         return RESULT_CONTINUE;
     }
 }
 
+void AnimateVisitor::processDeferredNode(simulation::Node* node)
+{
+    if (!node->solver.empty())
+        solveNode(node);
+    else
+        for_each(this, node, node->interactionForceField, &AnimateVisitor::fwdInteractionForceField);
+}
+
+void AnimateVisitor::solveNode(simulation::Node* node)
+{
+    sofa::helper::AdvancedTimer::StepVar timer("Mechanical",node);
+    SReal nextTime = node->getTime() + dt;
+    {
+        IntegrateBeginEvent evBegin;
+        PropagateEventVisitor eventPropagation( this->params, &evBegin);
+        eventPropagation.execute(node);
+    }
+
+    MechanicalBeginIntegrationVisitor beginVisitor(this->params, dt);
+    node->execute(&beginVisitor);
+
+    sofa::core::MechanicalParams m_mparams(*this->params);
+    m_mparams.setDt(dt);
+
+    {
+        unsigned int constraintId=0;
+        core::ConstraintParams cparams;
+        simulation::MechanicalAccumulateConstraint(&cparams, core::MatrixDerivId::constraintJacobian(),constraintId).execute(node);
+    }
+
+    for( unsigned i=0; i<node->solver.size(); i++ )
+    {
+        ctime_t t0 = begin(node, node->solver[i]);
+        node->solver[i]->solve(params, getDt());
+        end(node, node->solver[i], t0);
+    }
+
+    MechanicalProjectPositionAndVelocityVisitor(&m_mparams, nextTime,
+                                                sofa::core::VecCoordId::position(), sofa::core::VecDerivId::velocity()
+                                                ).execute( node );
+    MechanicalPropagateOnlyPositionAndVelocityVisitor(&m_mparams, nextTime,
+                                                      VecCoordId::position(),
+                                                      VecDerivId::velocity(), true).execute( node );
+
+    MechanicalEndIntegrationVisitor endVisitor(this->params, dt);
+    node->execute(&endVisitor);
+
+    {
+        IntegrateEndEvent evBegin;
+        PropagateEventVisitor eventPropagation(this->params, &evBegin);
+        eventPropagation.execute(node);
+    }
+}
+
 } // namespace simulation
 
 } // namespace sofa
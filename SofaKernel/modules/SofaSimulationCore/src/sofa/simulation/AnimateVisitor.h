@@ -47,6 +47,7 @@ class SOFA_SIMULATION_CORE_API AnimateVisitor : public Visitor
 protected :
     SReal dt;
     bool firstNodeVisited;
+    helper::vector<simulation::Node*>* deferredNodes;
 public:
     AnimateVisitor(const core::ExecParams* params = core::ExecParams::defaultInstance());
     AnimateVisitor(const core::ExecParams* params, SReal dt);
@@ -60,6 +61,17 @@ public:
     virtual void processOdeSolver(simulation::Node* node, core::behavior::OdeSolver* obj);
 
     Result processNodeTopDown(simulation::Node* node) override;
+
+    /// If not null, the nodes with a solver and the nodes with interaction force fields are not processed
+    /// during the traversal but appended to this list, in the traversal order, to be processed later
+    /// with processDeferredNode.
+    void setDeferredNodes(helper::vector<simulation::Node*>* nodes) { deferredNodes = nodes; }
+
+    /// Solve the subtree of a node with a solver, or add the interaction forces of a node without solver
+    void processDeferredNode(simulation::Node* node);
+
+    /// Integrate the subtree of a node with a solver over one time step
+    void solveNode(simulation::Node* node);
     //virtual void processNodeBottomUp(simulation::Node* node);
 
     /// Specify whether this action can be parallelized.
@@ -32,6 +32,12 @@
 #include <sofa/simulation/AnimateEndEvent.h>
 #include <sofa/simulation/UpdateMappingEndEvent.h>
 #include <sofa/simulation/UpdateBoundingBoxVisitor.h>
+#include <sofa/simulation/TaskScheduler.h>
+
+#include <sofa/core/BaseMapping.h>
+#include <sofa/core/behavior/BaseInteractionConstraint.h>
+#include <sofa/core/behavior/BaseInteractionForceField.h>
+#include <sofa/core/behavior/BaseInteractionProjectiveConstraintSet.h>
 
 #include <sofa/helper/system/SetDirectory.h>
 #include <sofa/helper/AdvancedTimer.h>
@@ -41,6 +47,8 @@
 #include <cstdlib>
 #include <cmath>
 #include <algorithm>
+#include <map>
+#include <stack>
 
 namespace sofa
 {
@@ -59,6 +67,7 @@ This loop do the following steps:
 
 DefaultAnimationLoop::DefaultAnimationLoop(simulation::Node* _gnode)
     : Inherit()
+    , d_parallelODESolving(initData(&d_parallelODESolving, false, "parallelODESolving", "If true, the subtrees with a solver which do not interact with the rest of the scene are solved in parallel tasks"))
     , gnode(_gnode)
 {
     //assert(gnode);
@@ -73,6 +82,11 @@ void DefaultAnimationLoop::init()
 {
     if (!gnode)
         gnode = dynamic_cast<simulation::Node*>(this->getContext());
+
+    if (d_parallelODESolving.getValue())
+    {
+        TaskScheduler::getInstance();
+    }
 }
 
 void DefaultAnimationLoop::setNode( simulation::Node* n )
@@ -80,6 +94,160 @@ void DefaultAnimationLoop::setNode( simulation::Node* n )
     gnode=n;
 }
 
+namespace
+{
+
+/// Task integrating the subtree of a node with a solver
+class SolveNodeTask : public CpuTask
+{
+public:
+    SolveNodeTask(CpuTask::Status* status, AnimateVisitor& visitor, simulation::Node* node)
+        : CpuTask(status)
+        , m_visitor(visitor)
+        , m_node(node)
+    {}
+
+    MemoryAlloc run() final
+    {
+        m_visitor.solveNode(m_node);
+        return MemoryAlloc::Stack;
+    }
+
+private:
+    AnimateVisitor& m_visitor;
+    simulation::Node* m_node;
+};
+
+} // anonymous namespace
+
+void DefaultAnimationLoop::animateParallel(AnimateVisitor& act)
+{
+    // the collision pipeline runs during the traversal, the solvers and interaction force fields are processed after
+    helper::vector<simulation::Node*> nodes;
+    act.setDeferredNodes(&nodes);
+    gnode->execute ( act );
+    act.setDeferredNodes(nullptr);
+
+    const helper::vector<bool> independent = findIndependentSubtrees(nodes);
+
+    TaskScheduler* scheduler = TaskScheduler::getInstance();
+    CpuTask::Status status;
+    std::vector<SolveNodeTask> tasks;
+    tasks.reserve(nodes.size());
+    for (std::size_t i = 0; i < nodes.size(); ++i)
+    {
+        if (independent[i])
+        {
+            tasks.emplace_back(&status, act, nodes[i]);
+            scheduler->addTask(&tasks.back());
+        }
+    }
+
+    // the other nodes are processed in the order of the traversal while the tasks run
+    for (std::size_t i = 0; i < nodes.size(); ++i)
+    {
+        if (!independent[i])
+            act.processDeferredNode(nodes[i]);
+    }
+
+    scheduler->workUntilDone(&status);
+}
+
+helper::vector<bool> DefaultAnimationLoop::findIndependentSubtrees(const helper::vector<simulation::Node*>& nodes) const
+{
+    helper::vector<bool> independent(nodes.size(), false);
+    std::map<simulation::Node*, int> nodeSubtree;
+    std::map<core::behavior::BaseMechanicalState*, int> stateSubtree;
+
+    // assign the nodes and the mechanical states to the subtree of their solver
+    for (std::size_t i = 0; i < nodes.size(); ++i)
+    {
+        if (nodes[i]->solver.empty())
+            continue;
+
+        const int subtree = (int)i;
+        independent[i] = true;
+        std::stack<simulation::Node*> stack;
+        stack.push(nodes[i]);
+        while (!stack.empty())
+        {
+            simulation::Node* node = stack.top();
+            stack.pop();
+
+            const auto inserted = nodeSubtree.insert(std::make_pair(node, subtree));
+            if (!inserted.second)
+            {
+                // node shared by two subtrees of the graph
+                if (inserted.first->second != subtree)
+                {
+                    independent[inserted.first->second] = false;
+                    independent[i] = false;
+                }
+                continue;
+            }
+
+            if (node->mechanicalState)
+                stateSubtree[node->mechanicalState.get()] = subtree;
+
+            for (const auto& child : node->child)
+                stack.push(child.get());
+        }
+    }
+
+    // nodes with a parent outside of their subtree
+    for (const auto& entry : nodeSubtree)
+    {
+        if (entry.first == nodes[entry.second])
+            continue;
+
+        for (core::objectmodel::BaseNode* parent : entry.first->getParents())
+        {
+            const auto it = nodeSubtree.find(static_cast<simulation::Node*>(parent));
+            if (it == nodeSubtree.end() || it->second != entry.second)
+                independent[entry.second] = false;
+        }
+    }
+
+    // components connecting a subtree to another subtree or to the rest of the scene
+    auto checkComponent = [&](core::objectmodel::BaseObject* obj, const helper::vector<core::behavior::BaseMechanicalState*>& states)
+    {
+        const auto node = nodeSubtree.find(dynamic_cast<simulation::Node*>(obj->getContext()));
+        helper::vector<int> subtrees(1, node == nodeSubtree.end() ? -1 : node->second);
+        for (core::behavior::BaseMechanicalState* state : states)
+        {
+            if (state == nullptr)
+                continue;
+            const auto it = stateSubtree.find(state);
+            subtrees.push_back(it == stateSubtree.end() ? -1 : it->second);
+        }
+
+        if (std::count(subtrees.begin(), subtrees.end(), subtrees[0]) != (std::ptrdiff_t)subtrees.size())
+        {
+            for (int subtree : subtrees)
+            {
+                if (subtree >= 0)
+                    independent[subtree] = false;
+            }
+        }
+    };
+
+    for (core::behavior::BaseInteractionForceField* obj : gnode->getTreeObjects<core::behavior::BaseInteractionForceField>())
+        checkComponent(obj, { obj->getMechModel1(), obj->getMechModel2() });
+    for (core::behavior::BaseInteractionConstraint* obj : gnode->getTreeObjects<core::behavior::BaseInteractionConstraint>())
+        checkComponent(obj, { obj->getMechModel1(), obj->getMechModel2() });
+    for (core::behavior::BaseInteractionProjectiveConstraintSet* obj : gnode->getTreeObjects<core::behavior::BaseInteractionProjectiveConstraintSet>())
+        checkComponent(obj, { obj->getMechModel1(), obj->getMechModel2() });
+    for (core::BaseMapping* obj : gnode->getTreeObjects<core::BaseMapping>())
+    {
+        helper::vector<core::behavior::BaseMechanicalState*> states = obj->getMechFrom();
+        const helper::vector<core::behavior::BaseMechanicalState*> to = obj->getMechTo();
+        states.insert(states.end(), to.begin(), to.end());
+        checkComponent(obj, states);
+    }
+
+    return independent;
+}
+
 void DefaultAnimationLoop::step(const core::ExecParams* params, SReal dt)
 {
     if (dt == 0)
@@ -113,7 +281,10 @@ void DefaultAnimationLoop::step(const core::ExecParams* params, SReal dt)
 
     sofa::helper::AdvancedTimer::stepBegin("AnimateVisitor");
     AnimateVisitor act(params, dt);
-    gnode->execute ( act );
+    if (d_parallelODESolving.getValue())
+        animateParallel(act);
+    else
+        gnode->execute ( act );
     sofa::helper::AdvancedTimer::stepEnd("AnimateVisitor");
 
 
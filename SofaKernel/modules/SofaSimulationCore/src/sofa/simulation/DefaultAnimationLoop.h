@@ -41,6 +41,8 @@ namespace sofa
 namespace simulation
 {
 
+class AnimateVisitor;
+
 /**
  *  \brief Default Animation Loop to be created when no AnimationLoop found on simulation::node.
  *
@@ -54,6 +56,9 @@ public:
     typedef sofa::core::objectmodel::BaseContext BaseContext;
     typedef sofa::core::objectmodel::BaseObjectDescription BaseObjectDescription;
     SOFA_CLASS(DefaultAnimationLoop,sofa::core::behavior::BaseAnimationLoop);
+
+    Data<bool> d_parallelODESolving; ///< solve the independent subtrees with a solver in parallel tasks
+
 protected:
     DefaultAnimationLoop(simulation::Node* gnode = nullptr);
 
@@ -84,6 +89,15 @@ protected :
 
     simulation::Node* gnode;  ///< the node controlled by the loop
 
+    /// Run the AnimateVisitor, solving the independent subtrees in parallel tasks
+    void animateParallel(AnimateVisitor& act);
+
+    /// For each node of the list, returns true if the node has a solver and its subtree does not interact
+    /// with the rest of the scene, so that it can be solved concurrently with any other node.
+    /// The subtrees must not share nodes, and no interaction force field, interaction constraint
+    /// or mapping may connect the mechanical states of a subtree to the rest of the scene.
+    helper::vector<bool> findIndependentSubtrees(const helper::vector<simulation::Node*>& nodes) const;
+
 };
 
 } // namespace simulation
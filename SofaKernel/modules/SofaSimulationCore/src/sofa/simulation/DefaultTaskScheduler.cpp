@@ -1,6 +1,7 @@
 #include <sofa/simulation/DefaultTaskScheduler.h>
 
 #include <sofa/helper/system/thread/thread_specific_ptr.h>
+#include <sofa/helper/TraceRecorder.h>
 
 #include <cassert>
 
@@ -57,6 +58,8 @@ namespace sofa
             // init global static thread local var
             workerThreadIndex = new WorkerThread(this, 0, "Main  ");
             _threads[std::this_thread::get_id()] = workerThreadIndex;// new WorkerThread(this, 0, "Main  ");
+            helper::TraceRecorder::setThreadName("Main");
+            m_workers.push_back(_threads[std::this_thread::get_id()]);
             
         }
         
@@ -120,12 +123,15 @@ namespace sofa
                 m_threadCount = NbThread;
             }
             
+            m_workers.reserve(m_threadCount);
+            
             /* start worker threads */
             for( unsigned int i=1; i<m_threadCount; ++i)
             {
                 WorkerThread* thread = new WorkerThread(this, int(i));
                 thread->create_and_attach(this);
                 _threads[thread->getId()] = thread;
+                m_workers.push_back(thread);
                 thread->start(this);
             }
             
@@ -175,6 +181,8 @@ namespace sofa
                 WorkerThread* mainThread = mainThreadIt->second;
                 _threads.clear();
                 _threads[std::this_thread::get_id()] = mainThread;
+                m_workers.clear();
+                m_workers.push_back(mainThread);
             }
             
             return;
@@ -229,7 +237,8 @@ namespace sofa
         WorkerThread::WorkerThread(DefaultTaskScheduler* const& pScheduler, const int index, const std::string& name)
         : m_name(name + std::to_string(index))
         , m_type(0)
-        , m_tasks()
+        , m_tasks(Max_TasksPerThread)
+        , m_randomState(std::uint32_t(index) * 2654435761u + 1u)
         , m_taskScheduler(pScheduler)
         {
             assert(pScheduler);
@@ -284,16 +293,27 @@ namespace sofa
             
             //workerThreadIndex = this;
             //TaskSchedulerDefault::_threads[std::this_thread::get_id()] = this;
+
+            helper::TraceRecorder::setThreadName(m_name);
             
             // main loop
             while ( !m_taskScheduler->isClosing() )
             {
                 Idle();
                 
+                ExponentialBackoff backoff;
                 while ( m_taskScheduler->m_mainTaskStatus != nullptr)
                 {
                     
-                    doWork(nullptr);
+                    if (doWork(nullptr))
+                    {
+                        backoff.reset();
+                    }
+                    else
+                    {
+                        // nothing to pop or steal: back off instead of hammering the other queues
+                        backoff.pause();
+                    }
                     
                     
                     if (m_taskScheduler->isClosing() )
@@ -326,8 +346,9 @@ namespace sofa
             return;
         }
         
-        void WorkerThread::doWork(Task::Status* status)
+        bool WorkerThread::doWork(Task::Status* status)
         {
+            bool hasWorked = false;
             
             for (;;)// do
             {
@@ -337,21 +358,23 @@ namespace sofa
                 {
                     // run task in the queue
                     runTask(task);
+                    hasWorked = true;
                     
                     
                     if (status && !status->isBusy())
-                        return;
+                        return hasWorked;
                 }
                 
                 // check if main work is finished 
                 if (m_taskScheduler->m_mainTaskStatus == nullptr)
-                    return;
+                    return hasWorked;
                 
                 if (!stealTask(&task))
-                    return;
+                    return hasWorked;
                 
                 // run the stolen task
                 runTask(task);
+                hasWorked = true;
                 
             } //;;while (stealTasks());	
 
@@ -363,6 +386,10 @@ namespace sofa
             Task::Status* prevStatus = m_currentStatus;
             m_currentStatus = task->getStatus();
             
+            // the tasks appear on the timeline of the thread running them
+            const bool traced = helper::TraceRecorder::isEnabled();
+            if (traced)
+                helper::TraceRecorder::begin("Task");
             {
                 if (task->run() & Task::MemoryAlloc::Dynamic)
                 {
@@ -373,15 +400,27 @@ namespace sofa
                 }
             }
             
+            if (traced)
+                helper::TraceRecorder::end("Task");
+
             m_currentStatus->setBusy(false);
             m_currentStatus = prevStatus;
         }
         
         void WorkerThread::workUntilDone(Task::Status* status)
         {
+            ExponentialBackoff backoff;
             while (status->isBusy())
             {
-                doWork(status);
+                if (doWork(status))
+                {
+                    backoff.reset();
+                }
+                else
+                {
+                    // the remaining tasks are running on other threads
+                    backoff.pause();
+                }
             }
             
             if (m_taskScheduler->m_mainTaskStatus == status)
@@ -395,11 +434,8 @@ namespace sofa
         {
             TASK_SCHEDULER_PROFILER(Pop);
             
-            simulation::ScopedLock lock( m_taskMutex );
-            if (!m_tasks.empty() )
+            if (m_tasks.pop(*task))
             {
-                *task = m_tasks.back();
-                m_tasks.pop_back();
                 return true;
             }
             *task = nullptr;
@@ -418,10 +454,9 @@ namespace sofa
             {
                 TASK_SCHEDULER_PROFILER(Push);
                 
-                simulation::ScopedLock lock(m_taskMutex);
                 int taskId = task->getStatus()->setBusy(true);
                 task->m_id = taskId;
-                m_tasks.push_back(task);
+                m_tasks.push(task);
             }
             
             
@@ -452,24 +487,28 @@ namespace sofa
             {
                 //TASK_SCHEDULER_PROFILER(StealTask);
                 
-                for (auto it : m_taskScheduler->_threads)
+                const std::vector<WorkerThread*>& workers = m_taskScheduler->m_workers;
+                const std::size_t workerCount = workers.size();
+                
+                // random first victim: spread the thieves over the queues instead of all
+                // of them contending on the first thread
+                const std::size_t first = workerCount > 1 ? nextRandom() % workerCount : 0;
+                
+                for (std::size_t i = 0; i < workerCount; ++i)
                 {
-                    // if this is the main thread continue
-                    if (std::this_thread::get_id() == it.first)
+                    WorkerThread* otherThread = workers[(first + i) % workerCount];
+                    
+                    // skip our own queue
+                    if (otherThread == this)
                     {
                         continue;
                     }
                     
-                    WorkerThread* otherThread = it.second;
-                    
                     {
                         TASK_SCHEDULER_PROFILER(Steal);
                         
-                        simulation::ScopedLock lock(otherThread->m_taskMutex);
-                        if (!otherThread->m_tasks.empty())
+                        if (otherThread->m_tasks.steal(*task))
                         {
-                            *task = otherThread->m_tasks.front();
-                            otherThread->m_tasks.pop_front();
                             return true;
                         }
                     }
@@ -480,6 +519,17 @@ namespace sofa
             return false;
         }
         
+        std::uint32_t WorkerThread::nextRandom()
+        {
+            // xorshift32
+            std::uint32_t x = m_randomState;
+            x ^= x << 13;
+            x ^= x >> 17;
+            x ^= x << 5;
+            m_randomState = x;
+            return x;
+        }
+        
 
 	} // namespace simulation
 
@@ -34,13 +34,14 @@
 #include <condition_variable>
 #include <memory>
 #include <map>
-#include <deque>
+#include <vector>
 #include <string> 
 #include <mutex>
 
 
 // workerthread
 #include <sofa/simulation/Locks.h>
+#include <sofa/simulation/WorkStealingDeque.h>
 
 
 namespace sofa  {
@@ -92,9 +93,7 @@ namespace sofa  {
             
             const std::thread::id getId();
             
-            const std::deque<Task*>* getTasksQueue() { return &m_tasks; }
-            
-            std::uint64_t getTaskCount() { return m_tasks.size(); }
+            std::uint64_t getTaskCount() { return std::uint64_t(m_tasks.size()); }
             
             int GetWorkerIndex();
             
@@ -117,10 +116,14 @@ namespace sofa  {
             // pop task from queue
             bool popTask(Task** ppTask);
             
-            // steal and queue some task from another thread
+            // steal some task from another thread, starting from a random victim
             bool stealTask(Task** task);
             
-            void doWork(Task::Status* status);
+            // run tasks until the status is done or no task can be found: return true if any task was run
+            bool doWork(Task::Status* status);
+            
+            // xorshift random generator used to select the victim of stealTask
+            std::uint32_t nextRandom();
             
             // boost thread main loop
             void run(void);
@@ -134,6 +137,7 @@ namespace sofa  {
             
             enum
             {
+                // initial capacity of the queue, it grows when full
                 Max_TasksPerThread = 256
             };
             
@@ -141,9 +145,10 @@ namespace sofa  {
             
             const int m_type;
             
-            simulation::SpinLock m_taskMutex;
+            // lock-free: pushed and popped by this thread, stolen by the others
+            WorkStealingDeque<Task*> m_tasks;
             
-            std::deque<Task*> m_tasks;
+            std::uint32_t m_randomState;
             
             std::thread  m_stdThread;
             
@@ -216,6 +221,9 @@ namespace sofa  {
             //static thread_local WorkerThread* _workerThreadIndex;
             static std::map< std::thread::id, WorkerThread*> _threads;
             
+            // same workers as _threads, indexed for the random victim selection in WorkerThread::stealTask
+            std::vector<WorkerThread*> m_workers;
+            
             const Task::Status*	m_mainTaskStatus;
             
             std::mutex  m_wakeUpMutex;
@@ -25,6 +25,13 @@
 #include <thread>
 #include <atomic>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SOFA_SIMULATION_CPU_RELAX() _mm_pause()
+#else
+#define SOFA_SIMULATION_CPU_RELAX() std::atomic_signal_fence(std::memory_order_seq_cst)
+#endif
+
 namespace sofa
 {
 
@@ -97,6 +104,50 @@ namespace sofa
             
             SpinLock& m_spinlock;
         };
+        
+        
+        
+        // exponential backoff used by threads polling for work:
+        // spin with cpu pause instructions, doubling the count at each call,
+        // then fall back to yielding the time slice to the OS
+        class ExponentialBackoff
+        {
+            enum
+            {
+                MAX_SPIN_COUNT = 1 << 10
+            };
+            
+        public:
+            
+            ExponentialBackoff()
+            : m_spinCount(1)
+            {}
+            
+            void pause()
+            {
+                if (m_spinCount <= MAX_SPIN_COUNT)
+                {
+                    for (unsigned int i = 0; i < m_spinCount; ++i)
+                    {
+                        SOFA_SIMULATION_CPU_RELAX();
+                    }
+                    m_spinCount <<= 1;
+                }
+                else
+                {
+                    std::this_thread::yield();
+                }
+            }
+            
+            void reset()
+            {
+                m_spinCount = 1;
+            }
+            
+        private:
+            
+            unsigned int m_spinCount;
+        };
 
 	} // namespace simulation
 
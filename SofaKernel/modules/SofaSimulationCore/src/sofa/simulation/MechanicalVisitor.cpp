@@ -680,6 +680,12 @@ Visitor::Result MechanicalVMultiOpVisitor::fwdMappedMechanicalState(VisitorConte
 }
 
 
+Visitor::Result MechanicalVMultiOpDotVisitor::fwdMechanicalState(VisitorContext* ctx, core::behavior::BaseMechanicalState* mm)
+{
+    *ctx->nodeData += mm->vMultiOpDot(this->params, ops, a.getId(mm), b.getId(mm) );
+    return RESULT_CONTINUE;
+}
+
 Visitor::Result MechanicalVDotVisitor::fwdMechanicalState(VisitorContext* ctx, core::behavior::BaseMechanicalState* mm)
 {
     *ctx->nodeData += mm->vDot(this->params, a.getId(mm),b.getId(mm) );
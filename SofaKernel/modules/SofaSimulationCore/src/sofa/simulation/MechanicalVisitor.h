@@ -798,6 +798,42 @@ protected:
     VMultiOp ops;
 };
 
+/** Perform a sequence of linear vector accumulation operations, then compute the dot product of two of the resulting vectors.
+*
+*  This is used to compute in one pass over the data operations such as $x = x + p*alpha, r = r - q*alpha, rho = r.r$.
+*/
+class SOFA_SIMULATION_CORE_API MechanicalVMultiOpDotVisitor : public MechanicalVMultiOpVisitor
+{
+public:
+    sofa::core::ConstMultiVecId a;
+    sofa::core::ConstMultiVecId b;
+    MechanicalVMultiOpDotVisitor(const sofa::core::ExecParams* params, const VMultiOp& o, sofa::core::ConstMultiVecId a, sofa::core::ConstMultiVecId b, SReal* t)
+        : MechanicalVMultiOpVisitor(params, o), a(a), b(b)
+    {
+#ifdef SOFA_DUMP_VISITOR_INFO
+        setReadWriteVectors();
+#endif
+        rootData = t;
+    }
+
+    Result fwdMechanicalState(VisitorContext* ctx, core::behavior::BaseMechanicalState* mm) override;
+
+    const char* getClassName() const override { return "MechanicalVMultiOpDotVisitor"; }
+
+    bool writeNodeData() const override
+    {
+        return true;
+    }
+#ifdef SOFA_DUMP_VISITOR_INFO
+    void setReadWriteVectors() override
+    {
+        MechanicalVMultiOpVisitor::setReadWriteVectors();
+        addReadVector(a);
+        addReadVector(b);
+    }
+#endif
+};
+
 /** Compute the dot product of two vectors */
 class SOFA_SIMULATION_CORE_API MechanicalVDotVisitor : public BaseMechanicalVisitor
 {
@@ -0,0 +1,126 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2019 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#ifndef ParallelForEach_h__
+#define ParallelForEach_h__
+
+#include <sofa/simulation/TaskScheduler.h>
+
+#include <algorithm>
+#include <vector>
+#include <cstddef>
+
+
+namespace sofa
+{
+
+	namespace simulation
+	{
+
+        /** Task running a function on a sub-range [first, last) of indices */
+        template<class Function>
+        class RangeTask : public CpuTask
+        {
+        public:
+            
+            RangeTask(CpuTask::Status* status, const Function& function, const std::size_t first, const std::size_t last)
+            : CpuTask(status)
+            , m_function(function)
+            , m_first(first)
+            , m_last(last)
+            {}
+            
+            MemoryAlloc run() final
+            {
+                m_function(m_first, m_last);
+                return MemoryAlloc::Stack;
+            }
+            
+        private:
+            
+            const Function& m_function;
+            const std::size_t m_first;
+            const std::size_t m_last;
+        };
+        
+        
+        /** Split the range of indices [first, last) into contiguous chunks of at least grainSize
+         *  indices and call function(chunkFirst, chunkLast) on each chunk from the tasks of the scheduler.
+         *  Returns when all the chunks are done.
+         *  The range is split in a fixed number of chunks which only depends on its size, the grain size
+         *  and the number of threads of the scheduler.
+         *  With a single thread or a range smaller than two grains, the function is called directly.
+         */
+        template<class Function>
+        void parallelForEachRange(TaskScheduler& scheduler, const std::size_t first, const std::size_t last, const Function& function, const std::size_t grainSize = 1)
+        {
+            if (last <= first)
+            {
+                return;
+            }
+            
+            const std::size_t count = last - first;
+            const std::size_t threadCount = scheduler.getThreadCount();
+            if (threadCount < 2 || count < 2 * grainSize)
+            {
+                function(first, last);
+                return;
+            }
+            
+            // a few chunks per thread to balance the load with work stealing
+            const std::size_t chunksPerThread = 4;
+            const std::size_t chunkSize = std::max(std::max(grainSize, std::size_t(1)), (count + threadCount * chunksPerThread - 1) / (threadCount * chunksPerThread));
+            const std::size_t chunkCount = (count + chunkSize - 1) / chunkSize;
+            
+            CpuTask::Status status;
+            std::vector< RangeTask<Function> > tasks;
+            tasks.reserve(chunkCount);
+            for (std::size_t i = 0; i < chunkCount; ++i)
+            {
+                const std::size_t chunkFirst = first + i * chunkSize;
+                tasks.emplace_back(&status, function, chunkFirst, std::min(last, chunkFirst + chunkSize));
+            }
+            for (auto& task : tasks)
+            {
+                scheduler.addTask(&task);
+            }
+            scheduler.workUntilDone(&status);
+        }
+        
+        /** Same as parallelForEachRange, but function(i) is called on each index i of [first, last) */
+        template<class Function>
+        void parallelForEach(TaskScheduler& scheduler, const std::size_t first, const std::size_t last, const Function& function, const std::size_t grainSize = 1)
+        {
+            parallelForEachRange(scheduler, first, last, [&function](const std::size_t chunkFirst, const std::size_t chunkLast)
+            {
+                for (std::size_t i = chunkFirst; i < chunkLast; ++i)
+                {
+                    function(i);
+                }
+            }, grainSize);
+        }
+
+	} // namespace simulation
+
+} // namespace sofa
+
+
+#endif // ParallelForEach_h__
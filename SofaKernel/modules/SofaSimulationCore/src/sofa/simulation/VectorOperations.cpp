@@ -146,6 +146,12 @@ void VectorOperations::v_dot( sofa::core::ConstMultiVecId a, sofa::core::ConstMu
     MechanicalVDotVisitor(params, a,b,&result).setTags(ctx->getTags()).execute( ctx, executeVisitor.precomputedTraversalOrder );
 }
 
+void VectorOperations::v_multiop_dot(const core::behavior::BaseMechanicalState::VMultiOp& o, sofa::core::ConstMultiVecId a, sofa::core::ConstMultiVecId b)
+{
+    result = 0;
+    MechanicalVMultiOpDotVisitor(params, o, a, b, &result).setTags(ctx->getTags()).execute( ctx, executeVisitor.precomputedTraversalOrder );
+}
+
 void VectorOperations::v_norm( sofa::core::ConstMultiVecId a, unsigned l)
 {
     MechanicalVNormVisitor vis(params, a,l);
@@ -0,0 +1,204 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2019 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#ifndef WorkStealingDeque_h__
+#define WorkStealingDeque_h__
+
+#include <atomic>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <cassert>
+
+
+namespace sofa
+{
+
+	namespace simulation
+	{
+
+        /** Lock-free, growable work-stealing deque (Chase-Lev).
+         *
+         *  The owner thread pushes and pops at the bottom (LIFO) while any other thread
+         *  can steal from the top (FIFO). Only the steal and the pop of the last element
+         *  need a CAS, the common push/pop path is wait-free.
+         *  Memory orderings follow Le, Pop, Cohen and Zappa Nardelli,
+         *  "Correct and Efficient Work-Stealing for Weak Memory Models" (PPoPP 2013).
+         *
+         *  T must be trivially copyable (typically a pointer).
+         *  When full, the circular buffer is doubled. Retired buffers are kept alive until
+         *  the deque is destroyed because a concurrent thief may still be reading from them.
+         */
+        template<class T>
+        class WorkStealingDeque
+        {
+        public:
+            
+            explicit WorkStealingDeque(const std::int64_t initialCapacity = 256)
+            : m_top(0)
+            , m_bottom(0)
+            {
+                std::int64_t capacity = 1;
+                while (capacity < initialCapacity)
+                {
+                    capacity <<= 1;
+                }
+                m_buffers.emplace_back(new Buffer(capacity));
+                m_buffer.store(m_buffers.back().get(), std::memory_order_relaxed);
+            }
+            
+            WorkStealingDeque(const WorkStealingDeque&) = delete;
+            WorkStealingDeque& operator=(const WorkStealingDeque&) = delete;
+            
+            // owner thread only: push an item at the bottom, grow the buffer if needed
+            void push(T item)
+            {
+                const std::int64_t b = m_bottom.load(std::memory_order_relaxed);
+                const std::int64_t t = m_top.load(std::memory_order_acquire);
+                Buffer* buffer = m_buffer.load(std::memory_order_relaxed);
+                
+                if (b - t > buffer->capacity() - 1)
+                {
+                    buffer = grow(buffer, b, t);
+                }
+                
+                buffer->put(b, item);
+                std::atomic_thread_fence(std::memory_order_release);
+                m_bottom.store(b + 1, std::memory_order_relaxed);
+            }
+            
+            // owner thread only: pop the most recently pushed item
+            bool pop(T& item)
+            {
+                const std::int64_t b = m_bottom.load(std::memory_order_relaxed) - 1;
+                Buffer* buffer = m_buffer.load(std::memory_order_relaxed);
+                m_bottom.store(b, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                std::int64_t t = m_top.load(std::memory_order_relaxed);
+                
+                if (t > b)
+                {
+                    // empty queue
+                    m_bottom.store(b + 1, std::memory_order_relaxed);
+                    return false;
+                }
+                
+                item = buffer->get(b);
+                if (t == b)
+                {
+                    // last item: race against the thieves
+                    const bool won = m_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+                    m_bottom.store(b + 1, std::memory_order_relaxed);
+                    return won;
+                }
+                return true;
+            }
+            
+            // any thread: steal the oldest item
+            bool steal(T& item)
+            {
+                std::int64_t t = m_top.load(std::memory_order_acquire);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                const std::int64_t b = m_bottom.load(std::memory_order_acquire);
+                
+                if (t >= b)
+                {
+                    return false;
+                }
+                
+                Buffer* buffer = m_buffer.load(std::memory_order_acquire);
+                item = buffer->get(t);
+                return m_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+            }
+            
+            // approximated when called concurrently with push/pop/steal
+            std::int64_t size() const
+            {
+                const std::int64_t b = m_bottom.load(std::memory_order_relaxed);
+                const std::int64_t t = m_top.load(std::memory_order_relaxed);
+                return b > t ? b - t : 0;
+            }
+            
+            bool empty() const { return size() == 0; }
+            
+            std::int64_t capacity() const { return m_buffer.load(std::memory_order_relaxed)->capacity(); }
+            
+        private:
+            
+            class Buffer
+            {
+            public:
+                
+                explicit Buffer(const std::int64_t capacity)
+                : m_capacity(capacity)
+                , m_mask(capacity - 1)
+                , m_items(new std::atomic<T>[capacity])
+                {
+                    assert((capacity & m_mask) == 0);
+                }
+                
+                std::int64_t capacity() const { return m_capacity; }
+                
+                T get(const std::int64_t i) const { return m_items[i & m_mask].load(std::memory_order_relaxed); }
+                
+                void put(const std::int64_t i, T item) { m_items[i & m_mask].store(item, std::memory_order_relaxed); }
+                
+            private:
+                
+                const std::int64_t m_capacity;
+                const std::int64_t m_mask;
+                std::unique_ptr<std::atomic<T>[]> m_items;
+            };
+            
+            Buffer* grow(Buffer* buffer, const std::int64_t b, const std::int64_t t)
+            {
+                Buffer* newBuffer = new Buffer(buffer->capacity() * 2);
+                for (std::int64_t i = t; i < b; ++i)
+                {
+                    newBuffer->put(i, buffer->get(i));
+                }
+                m_buffers.emplace_back(newBuffer);
+                m_buffer.store(newBuffer, std::memory_order_release);
+                return newBuffer;
+            }
+            
+            enum
+            {
+                CACHE_LINE = 64
+            };
+            
+            // top is written by the thieves, bottom by the owner: keep them on separate cache lines
+            std::atomic<std::int64_t> m_top;
+            char m_topPadding[CACHE_LINE - sizeof(std::atomic<std::int64_t>)];
+            std::atomic<std::int64_t> m_bottom;
+            char m_bottomPadding[CACHE_LINE - sizeof(std::atomic<std::int64_t>)];
+            std::atomic<Buffer*> m_buffer;
+            
+            // owned buffers, only modified by the owner thread
+            std::vector< std::unique_ptr<Buffer> > m_buffers;
+        };
+
+	} // namespace simulation
+
+} // namespace sofa
+
+
+#endif // WorkStealingDeque_h__
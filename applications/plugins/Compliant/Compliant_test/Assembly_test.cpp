@@ -539,12 +539,14 @@ struct Assembly_test : public CompliantSolver_test
         and the (anti-)symmetric upper part is skipped for convenience.
 
       \param n the number of particles in each sub-string. The total number is 2*n.
+      \param parallelAssembly assemble the mapping levels concurrently (CompliantImplicitSolver::parallel_assembly)
+      \param reuseAssemblyPattern keep the sparse product patterns between time steps (CompliantImplicitSolver::reuse_assembly_pattern)
 
       \post \f$ P= \left( \begin{array}{c|c|c} O_3 & & \\ \hline & I_{3(n-1)} & \\ \hline  & & I_{3(n-1)}   \end{array} \right)\f$
       \post dv is null because equilibrium
       \post lambda intensities are: (1) decreasing within first string, (2) decreasing within second string, (3) weight of the second string to connect it to the first string:  g*(2*n-1),... g*(n),   g*(*n-2),... g, g*(*n-1)
       */
-    void testAttachedConnectedHardStrings( unsigned n )
+    void testAttachedConnectedHardStrings( unsigned n, bool parallelAssembly=false, bool reuseAssemblyPattern=false )
     {
         Node::SPtr root = clearScene();
         SReal g=10;
@@ -558,6 +560,8 @@ struct Assembly_test : public CompliantSolver_test
         root->addObject( linearSolver);
         complianceSolver->alpha.setValue(1.0);
         complianceSolver->beta.setValue(1.0);
+        complianceSolver->parallel_assembly.setValue(parallelAssembly);
+        complianceSolver->reuse_assembly_pattern.setValue(reuseAssemblyPattern);
         linearsolver::LDLTResponse::SPtr response = addNew<linearsolver::LDLTResponse>(root);
         (void) response;
 
@@ -1151,6 +1155,42 @@ TEST_F( Assembly_test, testAttachedConnectedHardStrings )
     ASSERT_TRUE(vectorsAreEqual( expected.lambda, complianceSolver->getLambda() ));
     //    cout<<"testAttachedConnectedHardString results compared"<< endl;
 }
+TEST_F( Assembly_test, testParallelAssembly )
+{
+    unsigned numParticles=4, numSteps=2;
+    ::testing::Message() << "Assembly_test: hard strings of " << numParticles << " particles connected using a MultiMapping, assembled sequentially then in parallel";
+
+    // reference: sequential assembly, recomputing the patterns at each step
+    testAttachedConnectedHardStrings(numParticles);
+    std::vector<SparseMatrix> H, P, J, C;
+    std::vector<Vector> dv, lambda;
+    for( unsigned step=0; step<numSteps; step++ )
+    {
+        sofa::simulation::getSimulation()->animate(getRoot().get(),1.0);
+        H.push_back(complianceSolver->H());
+        P.push_back(complianceSolver->P());
+        J.push_back(complianceSolver->J());
+        C.push_back(complianceSolver->C());
+        dv.push_back(complianceSolver->getDv());
+        lambda.push_back(complianceSolver->getLambda());
+    }
+
+    // parallel assembly, with and without reusing the patterns of the previous step
+    for( unsigned reuse=0; reuse<2; reuse++ )
+    {
+        testAttachedConnectedHardStrings(numParticles, true, reuse!=0);
+        for( unsigned step=0; step<numSteps; step++ )
+        {
+            sofa::simulation::getSimulation()->animate(getRoot().get(),1.0);
+            ASSERT_TRUE(matricesAreEqual( H[step], complianceSolver->H() ));
+            ASSERT_TRUE(matricesAreEqual( P[step], complianceSolver->P() ));
+            ASSERT_TRUE(matricesAreEqual( J[step], complianceSolver->J() ));
+            ASSERT_TRUE(matricesAreEqual( C[step], complianceSolver->C() ));
+            ASSERT_TRUE(vectorsAreEqual( dv[step], complianceSolver->getDv() ));
+            ASSERT_TRUE(vectorsAreEqual( lambda[step], complianceSolver->getLambda() ));
+        }
+    }
+}
 TEST_F( Assembly_test, testRigidConnectedToString )
 {
     unsigned numParticles=2;
@@ -0,0 +1,138 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2019 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU General Public License as published by the Free  *
+* Software Foundation; either version 2 of the License, or (at your option)   *
+* any later version.                                                          *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for    *
+* more details.                                                               *
+*                                                                             *
+* You should have received a copy of the GNU General Public License along     *
+* with this program. If not, see <http://www.gnu.org/licenses/>.              *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#include <sofa/config.h>
+#include <Compliant/utils/sparse.h>
+
+#include <gtest/gtest.h>
+
+#include <random>
+
+
+namespace sofa {
+
+typedef Eigen::SparseMatrix<SReal, Eigen::RowMajor> rmat;
+typedef sparse::prod_pattern<SReal> pattern_type;
+
+/// random sparse matrix, the pattern only depends on the seed
+static rmat random_matrix(unsigned rows, unsigned cols, unsigned seed, SReal scale = 1.0) {
+    std::mt19937 generator(seed);
+    std::uniform_int_distribution<unsigned> column(0, cols - 1);
+    std::uniform_real_distribution<SReal> value(-1.0, 1.0);
+
+    std::vector< Eigen::Triplet<SReal> > triplets;
+    for(unsigned i = 0; i < rows; ++i) {
+        for(unsigned k = 0; k < 3; ++k) {
+            triplets.push_back( Eigen::Triplet<SReal>(i, column(generator), scale * value(generator)) );
+        }
+    }
+
+    rmat res(rows, cols);
+    res.setFromTriplets(triplets.begin(), triplets.end());
+    return res;
+}
+
+/// multiplies all the values, keeping the pattern
+static rmat scaled(const rmat& m, SReal factor) {
+    rmat res = m;
+    for(int i = 0, n = res.nonZeros(); i < n; ++i) res.valuePtr()[i] *= factor;
+    return res;
+}
+
+static void expect_same(const rmat& a, const rmat& b) {
+    ASSERT_EQ( a.rows(), b.rows() );
+    ASSERT_EQ( a.cols(), b.cols() );
+    ASSERT_EQ( a.nonZeros(), b.nonZeros() );
+    for(int i = 0; i <= a.outerSize(); ++i) EXPECT_EQ( a.outerIndexPtr()[i], b.outerIndexPtr()[i] );
+    for(int i = 0, n = a.nonZeros(); i < n; ++i) {
+        EXPECT_EQ( a.innerIndexPtr()[i], b.innerIndexPtr()[i] );
+        EXPECT_EQ( a.valuePtr()[i], b.valuePtr()[i] );
+    }
+}
+
+/// the pattern is reused as long as the operand patterns are the same,
+/// giving exactly the same result as the symbolic product
+TEST(SparseProduct_test, reusedPattern)
+{
+    const rmat A0 = random_matrix(20, 30, 1), B0 = random_matrix(30, 40, 2);
+    const rmat A1 = random_matrix(20, 25, 3), B1 = random_matrix(25, 40, 4);
+
+    pattern_type pattern;
+    rmat res;
+
+    pattern_type::operands_type lhs, rhs;
+    lhs.push_back(&A0); rhs.push_back(&B0);
+    lhs.push_back(&A1); rhs.push_back(&B1);
+
+    pattern(res, lhs, rhs);
+    EXPECT_FALSE( pattern.reused() );
+
+    rmat expected;
+    sparse::fast_prod(expected, A0, B0);
+    sparse::fast_add_prod(expected, A1, B1);
+    expect_same(res, expected);
+
+    // same patterns, new values
+    const rmat A0s = scaled(A0, 2.5), B1s = scaled(B1, -0.3);
+    lhs[0] = &A0s; rhs[1] = &B1s;
+
+    rmat res2;
+    pattern(res2, lhs, rhs);
+    EXPECT_TRUE( pattern.reused() );
+
+    sparse::fast_prod(expected, A0s, B0);
+    sparse::fast_add_prod(expected, A1, B1s);
+    expect_same(res2, expected);
+}
+
+/// a change in an operand pattern triggers a new symbolic product
+TEST(SparseProduct_test, changedPattern)
+{
+    const rmat A = random_matrix(20, 30, 5), B = random_matrix(30, 40, 6);
+    const rmat C = random_matrix(30, 40, 7);
+
+    pattern_type pattern;
+    rmat res;
+
+    pattern(res, pattern_type::operands_type(1, &A), pattern_type::operands_type(1, &B));
+    EXPECT_FALSE( pattern.reused() );
+
+    pattern(res, pattern_type::operands_type(1, &A), pattern_type::operands_type(1, &C));
+    EXPECT_FALSE( pattern.reused() );
+
+    rmat expected;
+    sparse::fast_prod(expected, A, C);
+    expect_same(res, expected);
+
+    // a different number of terms does not match either
+    pattern_type::operands_type lhs(2, &A), rhs(2, &C);
+    pattern(res, lhs, rhs);
+    EXPECT_FALSE( pattern.reused() );
+
+    pattern(res, lhs, rhs);
+    EXPECT_TRUE( pattern.reused() );
+
+    sparse::fast_prod(expected, A, C);
+    sparse::fast_add_prod(expected, A, C);
+    expect_same(res, expected);
+}
+
+}
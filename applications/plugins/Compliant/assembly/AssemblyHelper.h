@@ -169,7 +169,8 @@ static Eigen::SparseMatrix<real, Eigen::RowMajor> shifted_matrix( const Eigen::S
         res.innerIndexPtr()[i] += off; // where the shifting occurs
     }
 
-    memcpy(res.outerIndexPtr(), m.outerIndexPtr(), (m.outerSize()+1)*sizeof(typename Eigen::SparseMatrix<real, Eigen::RowMajor>::Index));
+    // the outer indices are StorageIndex, which is not Index since Eigen 3.3
+    memcpy(res.outerIndexPtr(), m.outerIndexPtr(), (m.outerSize()+1)*sizeof(*m.outerIndexPtr()));
 
     assert( !res.innerNonZeroPtr() ); // should be NULL because compressed // *res.innerNonZeroPtr() = *m.innerNonZeroPtr();
 
@@ -5,6 +5,7 @@
 #include <SofaBaseLinearSolver/DefaultMultiMatrixAccessor.h>
 
 #include <sofa/helper/cast.h>
+#include <sofa/simulation/ParallelForEach.h>
 #include "../utils/scoped.h"
 #include "../utils/sparse.h"
 
@@ -25,6 +26,8 @@ using namespace core::behavior;
 AssemblyVisitor::AssemblyVisitor(const core::MechanicalParams* mparams)
 	: base( mparams ),
       mparams( mparams ),
+      parallel(false),
+      cache(nullptr),
 	  start_node(nullptr),
 	  _processed(nullptr)
 {
@@ -511,7 +514,8 @@ AssemblyVisitor::process_type* AssemblyVisitor::process() const {
 	size_c = off_c;
 
     // prefix mapping concatenation and stuff
-    std::for_each(prefix.begin(), prefix.end(), process_helper(*res, graph) ); 	// TODO merge with offsets computation ?
+    if( parallel || cache ) process_levels(*res);
+    else std::for_each(prefix.begin(), prefix.end(), process_helper(*res, graph) ); 	// TODO merge with offsets computation ?
 
 
     // special treatment for interaction forcefields
@@ -533,8 +537,10 @@ AssemblyVisitor::process_type* AssemblyVisitor::process() const {
             if( itoff != offsets.end() ) Jp1 = shift_right<rmat>( itoff->second, it->ff->getMechModel2()->getMatrixSize(), size_m);
         }
 
-        if( !empty(Jp0) ) add( it->J, shift_left<rmat>( 0, it->ff->getMechModel1()->getMatrixSize(), it->H.rows() ) * Jp0 );
-        if( !empty(Jp1) ) add( it->J, shift_left<rmat>( it->ff->getMechModel1()->getMatrixSize(), it->ff->getMechModel2()->getMatrixSize(), it->H.rows() ) * Jp1 );
+        // the product is accumulated in place, as summing the (col-major) product expression
+        // with the row-major J does not compile
+        if( !empty(Jp0) ) add_prod( it->J, shift_left<rmat>( 0, it->ff->getMechModel1()->getMatrixSize(), it->H.rows() ), Jp0 );
+        if( !empty(Jp1) ) add_prod( it->J, shift_left<rmat>( it->ff->getMechModel1()->getMatrixSize(), it->ff->getMechModel2()->getMatrixSize(), it->H.rows() ), Jp1 );
     }
 
 	return res;
@@ -542,6 +548,201 @@ AssemblyVisitor::process_type* AssemblyVisitor::process() const {
 
 
 
+// sum of products, without pattern reuse (same as consecutive add_prod)
+static void sum_prod(AssemblyVisitor::rmat& res,
+                     const sparse::prod_pattern<SReal>::operands_type& lhs,
+                     const sparse::prod_pattern<SReal>::operands_type& rhs) {
+    for(unsigned k = 0, n = lhs.size(); k < n; ++k) {
+        sparse::fast_prod(res, *lhs[k], *rhs[k], k > 0);
+    }
+}
+
+
+// full mapping of a mapped dof, as the sum of its mapping blocks times
+// the full mappings of its parents. operands are fetched beforehand so
+// that products of a same level can be computed concurrently.
+struct mapping_product {
+    typedef sparse::prod_pattern<SReal> pattern_type;
+
+    AssemblyVisitor::rmat* Jc;
+    pattern_type::operands_type lhs, rhs;
+    pattern_type* pattern;
+
+    AssemblyVisitor::rmat* geometricStiffnessJc;
+    pattern_type::operands_type geometricLhs, geometricRhs;
+    pattern_type* geometricPattern;
+
+    mapping_product() : Jc(nullptr), pattern(nullptr),
+                        geometricStiffnessJc(nullptr), geometricPattern(nullptr) { }
+
+    void operator()() const {
+        if( pattern ) (*pattern)(*Jc, lhs, rhs);
+        else sum_prod(*Jc, lhs, rhs);
+
+        if( geometricStiffnessJc ) {
+            if( geometricPattern ) (*geometricPattern)(*geometricStiffnessJc, geometricLhs, geometricRhs);
+            else sum_prod(*geometricStiffnessJc, geometricLhs, geometricRhs);
+        }
+    }
+};
+
+
+// same as process_helper, but mapped dofs are gathered by depth in the
+// mapping graph: a full mapping only depends on the full mappings of
+// its parents, so that every dof of a level can be processed at once.
+void AssemblyVisitor::process_levels(process_type& res) const {
+    scoped::timer step("assembly: mapping levels");
+
+    const unsigned& size_m = res.size_m;
+    fullmapping_type& full = res.fullmapping;
+    offset_type& offsets = res.offset.master;
+
+    // depth of each vertex (prefix order puts parents first)
+    std::vector<unsigned> depth( boost::num_vertices(graph), 0 );
+    std::vector< std::vector<unsigned> > levels;
+
+    for(unsigned i = 0, n = prefix.size(); i < n; ++i) {
+        const unsigned v = prefix[i];
+
+        unsigned d = 0;
+        for( graph_type::out_edge_range e = boost::out_edges(v, graph); e.first != e.second; ++e.first) {
+            d = std::max(d, depth[ boost::target(*e.first, graph) ] + 1);
+        }
+        depth[v] = d;
+
+        const chunk* c = graph[v].data;
+        if( c->master() || !c->mechanical ) continue;
+
+        if( levels.size() <= d ) levels.resize(d + 1);
+        levels[d].push_back(v);
+    }
+
+    simulation::TaskScheduler* scheduler = simulation::TaskScheduler::getInstance();
+
+    for(unsigned l = 0, nl = levels.size(); l < nl; ++l) {
+        const std::vector<unsigned>& level = levels[l];
+
+        // fetch operands sequentially: the maps are only modified here
+        std::vector<mapping_product> products( level.size() );
+        std::vector< helper::OwnershipSPtr<rmat> > jacobians;
+        std::list<rmat> shifts;
+
+        for(unsigned i = 0, n = level.size(); i < n; ++i) {
+            const unsigned v = level[i];
+            const chunk* c = graph[v].data;
+            mapping_product& prod = products[i];
+
+            prod.Jc = &full[ c->dofs ];
+            assert( empty(*prod.Jc) );
+
+            product_cache::entry* entry = cache ? &cache->map[ c->dofs ] : nullptr;
+            if( entry ) prod.pattern = &entry->full;
+
+            unsigned localOffsetParentInMapped = 0; // only used for multimappings
+            if( boost::out_degree(v, graph) > 1 && notempty(c->Ktilde) ) {
+                prod.geometricStiffnessJc = &res.fullmappinggeometricstiffness[ c->dofs ];
+                if( entry ) prod.geometricPattern = &entry->geometric;
+            }
+
+            for( graph_type::out_edge_range e = boost::out_edges(v, graph); e.first != e.second; ++e.first) {
+                const chunk* p = graph[ boost::target(*e.first, graph) ].data;
+
+                rmat& Jp = full[ p->dofs ];
+
+                jacobians.push_back( convertSPtr<rmat>( graph[*e.first].data->J ) );
+                const rmat& jc = *jacobians.back();
+
+                if( zero(jc) ) continue;
+
+                if( p->master() && empty(Jp) ) {
+                    Jp = shift_right<rmat>( find(offsets, p->dofs), p->size, size_m);
+                }
+
+                if( empty(Jp) ) continue;
+
+                prod.lhs.push_back( &jc );
+                prod.rhs.push_back( &Jp );
+
+                if( prod.geometricStiffnessJc ) {
+                    shifts.push_back( shift_left<rmat>( localOffsetParentInMapped, p->size, c->Ktilde->rows() ) );
+                    prod.geometricLhs.push_back( &shifts.back() );
+                    prod.geometricRhs.push_back( &Jp );
+                    localOffsetParentInMapped += p->size;
+                }
+            }
+        }
+
+        if( parallel ) {
+            simulation::parallelForEach(*scheduler, 0, products.size(), [&products](const std::size_t i)
+            {
+                products[i]();
+            });
+        } else {
+            for(unsigned i = 0, n = products.size(); i < n; ++i) products[i]();
+        }
+    }
+}
+
+
+void AssemblyVisitor::mapped_responses(std::vector<rmat>& res) const {
+    scoped::timer step("assembly: mapped responses");
+
+    typedef sparse::prod_pattern<real> pattern_type;
+
+    struct response {
+        unsigned index;
+        const rmat* Jc;
+        const rmat* H;
+        product_cache::entry* entry;
+    };
+
+    // fetch operands sequentially: the maps are only modified here
+    std::vector<response> responses;
+    for( unsigned i = 0, n = prefix.size() ; i < n ; ++i ) {
+        const chunk& c = *graph[ prefix[i] ].data;
+
+        if( !c.mechanical || c.master() || zero(c.H) ) continue;
+
+        fullmapping_type::const_iterator it = _processed->fullmapping.find( c.dofs );
+        if( it == _processed->fullmapping.end() || zero(it->second) ) continue;
+
+        response r;
+        r.index = i;
+        r.Jc = &it->second;
+        r.H = &c.H;
+        r.entry = cache ? &cache->map[ c.dofs ] : nullptr;
+        responses.push_back( r );
+    }
+
+    res.clear();
+    res.resize( prefix.size() );
+
+    auto compute = [&](const std::size_t k)
+    {
+        const response& r = responses[k];
+
+        rmat dl;
+        const rmat lt = r.Jc->transpose();
+        const pattern_type::operands_type dlLhs(1, r.H), dlRhs(1, r.Jc);
+        const pattern_type::operands_type ltdlLhs(1, &lt), ltdlRhs(1, &dl);
+
+        if( r.entry ) {
+            r.entry->dl(dl, dlLhs, dlRhs);
+            r.entry->ltdl(res[r.index], ltdlLhs, ltdlRhs);
+        } else {
+            sum_prod(dl, dlLhs, dlRhs);
+            sum_prod(res[r.index], ltdlLhs, ltdlRhs);
+        }
+    };
+
+    if( parallel ) {
+        simulation::parallelForEach(*simulation::TaskScheduler::getInstance(), 0, responses.size(), compute);
+    } else {
+        for(std::size_t k = 0, n = responses.size(); k < n; ++k) compute(k);
+    }
+}
+
+
 // this is meant to optimize L^T D L products
 inline const AssemblyVisitor::rmat& AssemblyVisitor::ltdl(const rmat& l, const rmat& d) const
 {
@@ -766,6 +967,11 @@ void AssemblyVisitor::assemble(system_type& res) const {
 
 
 
+    // mapped response matrices J^T H J
+    std::vector<rmat> responses;
+    if( parallel || cache ) mapped_responses(responses);
+
+
 	// master/compliant offsets
 	unsigned off_m = 0;
 	unsigned off_c = 0;
@@ -806,7 +1012,10 @@ void AssemblyVisitor::assemble(system_type& res) const {
                 assert( Jc.cols() == int(_processed->size_m) );
 
                 // actual response matrix mapping
-                if( !zero(c.H) ) add_H(ltdl(Jc, c.H), 0);
+                if( !zero(c.H) ) {
+                    if( responses.empty() ) add_H(ltdl(Jc, c.H), 0);
+                    else add_H(responses[i], 0);
+                }
             }
 
 
@@ -15,6 +15,23 @@
 namespace sofa {
 namespace simulation {
 
+/// sparse product patterns kept from one assembly to the next, so that
+/// products whose operands kept the same sparsity are only recomputed
+/// numerically (see sparse::prod_pattern)
+struct AssemblyProductCache {
+    struct entry {
+        sparse::prod_pattern<SReal> full;      ///< full mapping
+        sparse::prod_pattern<SReal> geometric; ///< full mapping for the geometric stiffness
+        sparse::prod_pattern<SReal> dl, ltdl;  ///< mapped response matrix J^T H J
+    };
+
+    typedef std::map<const core::behavior::BaseMechanicalState*, entry> map_type;
+    map_type map;
+
+    void clear() { map.clear(); }
+};
+
+
 // a visitor for system assembly: sending the visitor will fetch
 // data, and actual system assembly is performed using
 // ::assemble(), yielding an AssembledSystem
@@ -48,6 +65,17 @@ public:
     AssemblyVisitor(const core::MechanicalParams* mparams);
     ~AssemblyVisitor() override;
 
+    typedef AssemblyProductCache product_cache;
+
+    /// assemble the mapping graph level by level, independent dofs of a
+    /// same level (in particular independent subtrees) being processed
+    /// concurrently by the TaskScheduler
+    bool parallel;
+
+    /// when given, sparse products reuse the patterns stored in this
+    /// cache (not owned, must outlive the assembly)
+    product_cache* cache;
+
 //protected:
 //    MultiVecDerivId _velId;
 
@@ -237,6 +265,13 @@ private:
     const rmat& ltdl(const rmat& l, const rmat& d) const;
     void add_ltdl(rmat& res, const rmat& l, const rmat& d) const;
 
+    // mapping concatenation by levels of the graph (parallel and/or cached)
+    void process_levels(process_type& res) const;
+
+    // J^T H J for every mechanical mapped dof (parallel and/or cached),
+    // indexed as prefix
+    void mapped_responses(std::vector<rmat>& res) const;
+
 };
 
 
@@ -60,7 +60,7 @@ void initExternalModule()
         component::collision::CompliantSolverMerger::add();
 
         // previous Eigen versions have a critical bug (v.noalias()+=w does not work in some situations)
-        static_assert( EIGEN_WORLD_VERSION>=3 && EIGEN_MAJOR_VERSION>=2 && EIGEN_MINOR_VERSION>=5, "" );
+        static_assert( EIGEN_VERSION_AT_LEAST(3,2,5), "" );
 
 #if COMPLIANT_HAVE_SOFAPYTHON
         static std::string docstring=R"(
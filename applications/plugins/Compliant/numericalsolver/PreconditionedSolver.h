@@ -39,9 +39,11 @@ class SOFA_Compliant_API PreconditionedSolver {
                 p->compute(sys.H);
             else
             {
-                AssembledSystem::cmat identity(sys.H.rows(),sys.H.cols());
+                // both terms are row-major, as summing sparse matrices of different storage orders does not compile
+                AssembledSystem::rmat projected = sys.P.transpose()*sys.H*sys.P;
+                AssembledSystem::rmat identity(sys.H.rows(),sys.H.cols());
                 identity.setIdentity();
-                p->compute( sys.P.transpose()*sys.H*sys.P + identity * std::numeric_limits<SReal>::epsilon() );
+                p->compute( projected + identity * std::numeric_limits<SReal>::epsilon() );
             }
         }
 
@@ -60,9 +60,20 @@ using namespace core::behavior;
             true,
             "neglecting_compliance_forces_in_geometric_stiffness",
             "isn't the name clear enough?"))
+
+          , parallel_assembly(initData(&parallel_assembly,
+            false,
+            "parallel_assembly",
+            "assemble independent subtrees of the mapping graph concurrently (requires an initialized TaskScheduler)"))
+
+          , reuse_assembly_pattern(initData(&reuse_assembly_pattern,
+            false,
+            "reuse_assembly_pattern",
+            "keep the sparsity patterns of the assembly products between time steps, only recomputing values while they are unchanged"))
     {
         storeDSol = false;
         assemblyVisitor = NULL;
+        assemblyCache = NULL;
 
         helper::OptionsGroup stabilizationOptions;
         stabilizationOptions.setNbItems( NB_STABILIZATION );
@@ -140,6 +151,7 @@ using namespace core::behavior;
 
     CompliantImplicitSolver::~CompliantImplicitSolver() {
         if( assemblyVisitor ) delete assemblyVisitor;
+        if( assemblyCache ) delete assemblyCache;
     }
 
     void CompliantImplicitSolver::reset() {
@@ -157,6 +169,8 @@ using namespace core::behavior;
         vop.v_free( lagrange.id(), false, true );
         vop.v_free( _ck.id(), false, true );
         vop.v_free( _acc.id() );
+
+        if( assemblyCache ) assemblyCache->clear();
     }
 
 
@@ -506,6 +520,15 @@ using namespace core::behavior;
         if( assemblyVisitor ) delete assemblyVisitor;
         assemblyVisitor = new simulation::AssemblyVisitor(mparams);
 
+        assemblyVisitor->parallel = parallel_assembly.getValue();
+        if( reuse_assembly_pattern.getValue() ) {
+            if( !assemblyCache ) assemblyCache = new simulation::AssemblyProductCache();
+            assemblyVisitor->cache = assemblyCache;
+        } else if( assemblyCache ) {
+            delete assemblyCache;
+            assemblyCache = NULL;
+        }
+
         // fetch nodes/data
         {
             scoped::timer step("assembly: fetch data");
@@ -21,6 +21,7 @@ namespace sofa {
 
 namespace simulation {
 class AssemblyVisitor;
+struct AssemblyProductCache;
 
 namespace common {
 class MechanicalOperations;
@@ -186,12 +187,18 @@ class SOFA_Compliant_API CompliantImplicitSolver : public sofa::core::behavior::
 
     Data<bool> neglecting_compliance_forces_in_geometric_stiffness; ///< isn't the name clear enough?
 
+    Data<bool> parallel_assembly; ///< assemble independent mapping subtrees concurrently
+    Data<bool> reuse_assembly_pattern; ///< keep sparse product patterns between time steps
+
 
   protected:
 
     // keep a pointer on the visitor used to assemble
     simulation::AssemblyVisitor *assemblyVisitor;
 
+    // sparse product patterns kept between assemblies
+    simulation::AssemblyProductCache *assemblyCache;
+
     /// a derivable function creating and calling the assembly visitor to create an AssembledSystem
     virtual void perform_assembly( const core::MechanicalParams *mparams, system_type& sys );
 				
@@ -38,6 +38,7 @@ void ConstantCompliantImplicitSolver::perform_assembly( const core::MechanicalPa
     if( assemblyVisitor ) return;
 
     assemblyVisitor = new simulation::AssemblyVisitor(mparams);
+    assemblyVisitor->parallel = parallel_assembly.getValue();
 
     // fetch nodes/data
     send( *assemblyVisitor );
@@ -30,7 +30,8 @@ void CompliantLDLTPreconditioner::compute( const AssembledSystem::rmat& H )
             // if singular, try to regularize by adding a tiny diagonal matrix
             AssembledSystem::rmat identity(H.rows(),H.cols());
             identity.setIdentity();
-            preconditioner.compute( (H + identity * std::numeric_limits<SReal>::epsilon()).selfadjointView<Eigen::Lower>() );
+            const AssembledSystem::rmat regularized = H + identity * std::numeric_limits<SReal>::epsilon();
+            preconditioner.compute( regularized.selfadjointView<Eigen::Lower>() );
 
             if( preconditioner.info() != Eigen::Success )
             {
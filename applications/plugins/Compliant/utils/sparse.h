@@ -3,6 +3,9 @@
 
 #include <Eigen/Sparse>
 
+#include <vector>
+#include <algorithm>
+
 
 // easily restore default behavior
 #define SPARSE_USE_DEFAULT_PRODUCT 0
@@ -195,6 +198,164 @@ static void fast_add_prod(ResultType& res, const Lhs& lhs, const Rhs& rhs) {
 }
 
 
+
+// sparsity pattern of a sum of row-major sparse products res = sum_k
+// lhs_k * rhs_k. the pattern is recorded on a first (symbolic +
+// numeric) evaluation; as long as every operand keeps the same
+// sparsity pattern, later evaluations only recompute the values in
+// place, in the same order as fast_prod (hence the same results).
+template<class U>
+class prod_pattern {
+public:
+    typedef Eigen::SparseMatrix<U, Eigen::RowMajor> mat;
+    typedef std::vector<const mat*> operands_type;
+
+    // eigen default sparse storage index
+    typedef int index_type;
+
+    prod_pattern() : rows(0), cols(0), hit(false) { }
+
+    // res = sum_k lhs[k] * rhs[k]
+    void operator()(mat& res, const operands_type& lhs, const operands_type& rhs) {
+        assert( lhs.size() == rhs.size() );
+        hit = false;
+
+        if( !lhs.empty() && match(lhs, rhs) ) {
+            numeric(res, lhs, rhs);
+            return;
+        }
+
+        res.resize(0, 0);
+        for(unsigned k = 0, n = lhs.size(); k < n; ++k) {
+            fast_prod(res, *lhs[k], *rhs[k], k > 0);
+        }
+
+        record(res, lhs, rhs);
+    }
+
+    // true iff the last evaluation only recomputed values
+    bool reused() const { return hit; }
+
+    void clear() {
+        signature.clear();
+        outer.clear();
+        inner.clear();
+        rows = cols = 0;
+    }
+
+private:
+
+    std::vector<index_type> signature; // sizes and patterns of all operands
+    std::vector<index_type> outer, inner; // result pattern
+    index_type rows, cols;
+    bool hit;
+
+    static bool compressed(const mat& m) {
+        return m.isCompressed();
+    }
+
+    static void push(std::vector<index_type>& sig, const mat& m) {
+        const index_type nnz = m.nonZeros();
+        sig.push_back( m.rows() );
+        sig.push_back( m.cols() );
+        sig.push_back( nnz );
+        sig.insert(sig.end(), m.outerIndexPtr(), m.outerIndexPtr() + m.outerSize() + 1);
+        sig.insert(sig.end(), m.innerIndexPtr(), m.innerIndexPtr() + nnz);
+    }
+
+    // compares m to the signature starting at pos, advances pos
+    bool same(std::size_t& pos, const mat& m) const {
+        if( !compressed(m) ) return false;
+
+        const index_type nnz = m.nonZeros();
+        const std::size_t size = 3 + m.outerSize() + 1 + nnz;
+        if( pos + size > signature.size() ) return false;
+
+        const index_type* sig = &signature[pos];
+        if( sig[0] != m.rows() || sig[1] != m.cols() || sig[2] != nnz ) return false;
+        sig += 3;
+
+        if( !std::equal(m.outerIndexPtr(), m.outerIndexPtr() + m.outerSize() + 1, sig) ) return false;
+        sig += m.outerSize() + 1;
+
+        if( !std::equal(m.innerIndexPtr(), m.innerIndexPtr() + nnz, sig) ) return false;
+
+        pos += size;
+        return true;
+    }
+
+    bool match(const operands_type& lhs, const operands_type& rhs) {
+        if( signature.empty() ) return false;
+
+        std::size_t pos = 0;
+        for(unsigned k = 0, n = lhs.size(); k < n; ++k) {
+            if( !same(pos, *lhs[k]) || !same(pos, *rhs[k]) ) return false;
+        }
+
+        hit = (pos == signature.size());
+        return hit;
+    }
+
+    void record(const mat& res, const operands_type& lhs, const operands_type& rhs) {
+        clear();
+
+        for(unsigned k = 0, n = lhs.size(); k < n; ++k) {
+            // uncompressed operands cannot be walked with raw pointers
+            if( !compressed(*lhs[k]) || !compressed(*rhs[k]) ) {
+                signature.clear();
+                return;
+            }
+            push(signature, *lhs[k]);
+            push(signature, *rhs[k]);
+        }
+
+        assert( res.isCompressed() );
+        rows = res.rows();
+        cols = res.cols();
+        outer.assign(res.outerIndexPtr(), res.outerIndexPtr() + res.outerSize() + 1);
+        inner.assign(res.innerIndexPtr(), res.innerIndexPtr() + res.nonZeros());
+    }
+
+    void numeric(mat& res, const operands_type& lhs, const operands_type& rhs) const {
+        res.resize(rows, cols);
+        res.resizeNonZeros( inner.size() );
+
+        std::copy(outer.begin(), outer.end(), res.outerIndexPtr());
+        std::copy(inner.begin(), inner.end(), res.innerIndexPtr());
+
+        // dense accumulator, only the entries of the pattern are ever
+        // touched so they are reset after each row
+        std::vector<U> work(cols, U(0));
+
+        U* values = res.valuePtr();
+
+        for(index_type i = 0; i < rows; ++i) {
+
+            for(unsigned k = 0, n = lhs.size(); k < n; ++k) {
+                const mat& l = *lhs[k];
+                const mat& r = *rhs[k];
+
+                for(index_type p = l.outerIndexPtr()[i], pe = l.outerIndexPtr()[i + 1]; p < pe; ++p) {
+                    const index_type j = l.innerIndexPtr()[p];
+                    const U x = l.valuePtr()[p];
+
+                    for(index_type q = r.outerIndexPtr()[j], qe = r.outerIndexPtr()[j + 1]; q < qe; ++q) {
+                        work[ r.innerIndexPtr()[q] ] += x * r.valuePtr()[q];
+                    }
+                }
+            }
+
+            for(index_type p = outer[i], pe = outer[i + 1]; p < pe; ++p) {
+                U& w = work[ inner[p] ];
+                values[p] = w;
+                w = 0;
+            }
+        }
+    }
+
+};
+
+
 }
 
 
@@ -0,0 +1,202 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2019 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#include <SofaSimulationGraph/testing/BaseSimulationTest.h>
+using sofa::helper::testing::BaseSimulationTest;
+
+#include <SofaSimulationGraph/SimpleApi.h>
+using sofa::simulation::Node;
+
+#include <SofaBaseMechanics/MechanicalObject.h>
+#include <SofaSphFluid/SPHFluidForceField.h>
+#include <SofaSphFluid/SpatialGridContainer.h>
+#include <sofa/core/MechanicalParams.h>
+
+#include <random>
+
+using sofa::defaulttype::Vec3Types;
+
+namespace
+{
+
+typedef Vec3Types::Coord Coord;
+typedef Vec3Types::Deriv Deriv;
+typedef Vec3Types::VecCoord VecCoord;
+typedef Vec3Types::VecDeriv VecDeriv;
+typedef Vec3Types::Real Real;
+
+/// Gives access to the density computed for each particle
+class SPHFluidForceFieldTester : public sofa::component::forcefield::SPHFluidForceField<Vec3Types>
+{
+public:
+    SOFA_CLASS(SPHFluidForceFieldTester, SOFA_TEMPLATE(sofa::component::forcefield::SPHFluidForceField, Vec3Types));
+
+    Real getDensity(const std::size_t i) const { return m_particles[i].density; }
+};
+
+/// Compares the cell list of SPHFluidForceField (useCellList=true) to the neighbor search of the
+/// SpatialGridContainer (useCellList=false), which is the reference.
+class SPHFluidForceField_test : public BaseSimulationTest
+{
+public:
+    /// radius of the particles, and width of the cells of both grids
+    const Real h = 0.5;
+
+    struct Fluid
+    {
+        Node::SPtr node;
+        sofa::component::container::MechanicalObject<Vec3Types>::SPtr mstate;
+        SPHFluidForceFieldTester::SPtr forceField;
+    };
+
+    sofa::simulation::Simulation::SPtr m_simulation;
+    Node::SPtr m_root;
+
+    void SetUp() override
+    {
+        m_simulation = sofa::simpleapi::createSimulation();
+        m_root = sofa::simpleapi::createRootNode(m_simulation, "root");
+    }
+
+    void TearDown() override
+    {
+        m_simulation->unload(m_root);
+    }
+
+    Fluid createFluid(const std::string& name, const VecCoord& x, const VecDeriv& v, const bool useCellList)
+    {
+        Fluid fluid;
+        fluid.node = sofa::simpleapi::createChild(m_root, name);
+
+        fluid.mstate = sofa::core::objectmodel::New< sofa::component::container::MechanicalObject<Vec3Types> >();
+        fluid.mstate->resize(x.size());
+        *fluid.mstate->write(sofa::core::VecCoordId::position()) = x;
+        *fluid.mstate->write(sofa::core::VecDerivId::velocity()) = v;
+        fluid.node->addObject(fluid.mstate);
+
+        if (!useCellList)
+        {
+            auto grid = sofa::core::objectmodel::New< sofa::component::container::SpatialGridContainer<Vec3Types> >();
+            grid->d_cellWidth.setValue(h);
+            fluid.node->addObject(grid);
+        }
+
+        fluid.forceField = sofa::core::objectmodel::New<SPHFluidForceFieldTester>();
+        fluid.forceField->d_particleRadius.setValue(h);
+        fluid.forceField->d_particleMass.setValue(1);
+        fluid.forceField->d_density0.setValue(15);
+        fluid.forceField->d_pressureStiffness.setValue(100);
+        fluid.forceField->d_viscosity.setValue(10);
+        fluid.forceField->d_surfaceTension.setValue(1000);
+        fluid.forceField->d_useCellList.setValue(useCellList);
+        fluid.node->addObject(fluid.forceField);
+        return fluid;
+    }
+
+    /// Random particles in a box of 4x4x4 cells, with lattice particles exactly on the cell borders of both
+    /// grids, some of them at exactly the radius of each other
+    void createParticles(VecCoord& x, VecDeriv& v) const
+    {
+        std::mt19937 generator(42);
+        std::uniform_real_distribution<Real> position(0, 4*h);
+        std::uniform_real_distribution<Real> velocity(-1, 1);
+
+        for (int i = 0; i <= 4; ++i)
+            for (int j = 0; j <= 4; ++j)
+                for (int k = 0; k <= 4; ++k)
+                    x.push_back(Coord(i*h, j*h, k*h));
+        for (int i = 0; i < 400; ++i)
+            x.push_back(Coord(position(generator), position(generator), position(generator)));
+        for (std::size_t i = 0; i < x.size(); ++i)
+            v.push_back(Deriv(velocity(generator), velocity(generator), velocity(generator)));
+    }
+
+    VecDeriv computeForce(const Fluid& fluid)
+    {
+        sofa::core::objectmodel::Data<VecDeriv> f;
+        fluid.forceField->addForce(sofa::core::MechanicalParams::defaultInstance(), f,
+                                   *fluid.mstate->read(sofa::core::ConstVecCoordId::position()),
+                                   *fluid.mstate->read(sofa::core::ConstVecDerivId::velocity()));
+        return f.getValue();
+    }
+
+    void compareToReference(const int kernelType, const int viscosityType, const int surfaceTensionType)
+    {
+        VecCoord x;
+        VecDeriv v;
+        createParticles(x, v);
+
+        std::ostringstream name;
+        name << kernelType << viscosityType << surfaceTensionType;
+        Fluid reference = createFluid("reference" + name.str(), x, v, false);
+        Fluid cellList = createFluid("cellList" + name.str(), x, v, true);
+        for (const Fluid* fluid : { &reference, &cellList })
+        {
+            fluid->forceField->d_kernelType.setValue(kernelType);
+            fluid->forceField->d_viscosityType.setValue(viscosityType);
+            fluid->forceField->d_surfaceTensionType.setValue(surfaceTensionType);
+        }
+        m_simulation->init(m_root.get());
+
+        const VecDeriv fReference = computeForce(reference);
+        const VecDeriv fCellList = computeForce(cellList);
+
+        // the neighbors are not visited in the same order, so the sums are only equal up to rounding
+        ASSERT_EQ(fReference.size(), x.size());
+        ASSERT_EQ(fCellList.size(), x.size());
+        for (std::size_t i = 0; i < x.size(); ++i)
+        {
+            const Real density = reference.forceField->getDensity(i);
+            EXPECT_NEAR(density, cellList.forceField->getDensity(i), 1e-10 * density) << "particle " << i;
+            const Real tolerance = 1e-9 * std::max(Real(1), fReference[i].norm());
+            for (int a = 0; a < 3; ++a)
+                EXPECT_NEAR(fReference[i][a], fCellList[i][a], tolerance) << "particle " << i << ", axis " << a;
+        }
+    }
+};
+
+TEST_F(SPHFluidForceField_test, cellListMatchesSpatialGrid)
+{
+    for (int kernelType = 0; kernelType < 2; ++kernelType)
+    {
+        for (int viscosityType = 0; viscosityType < 3; ++viscosityType)
+        {
+            for (int surfaceTensionType = 0; surfaceTensionType < 3; ++surfaceTensionType)
+            {
+                SCOPED_TRACE(::testing::Message() << "kernelType=" << kernelType << " viscosityType=" << viscosityType
+                                                  << " surfaceTensionType=" << surfaceTensionType);
+                compareToReference(kernelType, viscosityType, surfaceTensionType);
+            }
+        }
+    }
+}
+
+TEST_F(SPHFluidForceField_test, cellListEmpty)
+{
+    Fluid reference = createFluid("reference", VecCoord(), VecDeriv(), false);
+    Fluid cellList = createFluid("cellList", VecCoord(), VecDeriv(), true);
+    m_simulation->init(m_root.get());
+
+    EXPECT_TRUE(computeForce(reference).empty());
+    EXPECT_TRUE(computeForce(cellList).empty());
+}
+
+} // namespace
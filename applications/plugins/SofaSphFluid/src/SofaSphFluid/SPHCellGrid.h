@@ -0,0 +1,352 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2019 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#ifndef SOFA_COMPONENT_FORCEFIELD_SPHCELLGRID_H
+#define SOFA_COMPONENT_FORCEFIELD_SPHCELLGRID_H
+#include <SofaSphFluid/config.h>
+
+#include <sofa/simulation/ParallelForEach.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+
+namespace sofa
+{
+
+namespace component
+{
+
+namespace forcefield
+{
+
+/** Compact cell list used for SPH neighbor queries.
+ *
+ *  The particles are sorted by cell, the cells being ordered along a Z-order (Morton) curve, so that
+ *  the particles of a cell are contiguous in the sorted order and neighboring cells are close in memory.
+ *  The sort is a stable least-significant-digit radix sort made of parallel counting sort passes, so the
+ *  result does not depend on the number of threads.
+ *
+ *  Cells are at least cellSize wide: every particle closer than cellSize to a particle of a cell lies in
+ *  one of the 3^N cells around it (including itself), given by getNeighborCells().
+ */
+template<class Coord>
+class SPHCellGrid
+{
+public:
+    typedef typename Coord::value_type Real;
+    typedef std::uint64_t Key;
+    enum { N = Coord::spatial_dimensions };
+    enum { NbNeighborCells = (N == 1) ? 3 : (N == 2) ? 9 : 27 };
+
+    /// Rebuild the grid for the n positions x.
+    void build(const Coord* x, const std::size_t n, const Real cellSize, simulation::TaskScheduler& scheduler)
+    {
+        m_nbParticles = n;
+        m_order.resize(n);
+        m_particleCell.resize(n);
+        if (n == 0)
+        {
+            m_cellStart.assign(1, 0);
+            m_cellKeys.clear();
+            m_neighborCells.clear();
+            return;
+        }
+
+        const std::size_t nbChunks = std::min(n, std::max(std::size_t(1), std::size_t(scheduler.getThreadCount()) * 4));
+        auto chunkBegin = [n, nbChunks](const std::size_t c) { return n * c / nbChunks; };
+
+        // Bounding box, reduced per chunk
+        std::vector<Coord> chunkMin(nbChunks), chunkMax(nbChunks);
+        simulation::parallelForEach(scheduler, 0, nbChunks, [&](const std::size_t c)
+        {
+            Coord bmin = x[chunkBegin(c)];
+            Coord bmax = bmin;
+            for (std::size_t i = chunkBegin(c) + 1; i < chunkBegin(c + 1); ++i)
+            {
+                for (int k = 0; k < N; ++k)
+                {
+                    bmin[k] = std::min(bmin[k], x[i][k]);
+                    bmax[k] = std::max(bmax[k], x[i][k]);
+                }
+            }
+            chunkMin[c] = bmin;
+            chunkMax[c] = bmax;
+        });
+        m_origin = chunkMin[0];
+        Coord bmax = chunkMax[0];
+        for (std::size_t c = 1; c < nbChunks; ++c)
+        {
+            for (int k = 0; k < N; ++k)
+            {
+                m_origin[k] = std::min(m_origin[k], chunkMin[c][k]);
+                bmax[k] = std::max(bmax[k], chunkMax[c][k]);
+            }
+        }
+
+        // Cell coordinates start at 1 so that the neighbors of any occupied cell have valid coordinates.
+        // Cells are enlarged if the domain would not fit in the bits available per axis.
+        const Key maxCoord = (Key(1) << BitsPerAxis) - 3;
+        m_cellSize = cellSize;
+        for (int k = 0; k < N; ++k)
+            m_cellSize = std::max(m_cellSize, (bmax[k] - m_origin[k]) / Real(maxCoord));
+        m_invCellSize = Real(1) / m_cellSize;
+
+        Key maxCell = 0;
+        for (int k = 0; k < N; ++k)
+            maxCell = std::max(maxCell, cellCoord(bmax[k], k) + 1);
+        m_bitsPerAxis = 1;
+        while ((Key(1) << m_bitsPerAxis) <= maxCell)
+            ++m_bitsPerAxis;
+
+        // Morton key of the cell of each particle
+        m_keys.resize(n);
+        simulation::parallelForEach(scheduler, 0, nbChunks, [&](const std::size_t c)
+        {
+            for (std::size_t i = chunkBegin(c); i < chunkBegin(c + 1); ++i)
+            {
+                Key coords[N];
+                for (int k = 0; k < N; ++k)
+                    coords[k] = cellCoord(x[i][k], k);
+                m_keys[i] = encode(coords);
+                m_order[i] = (unsigned int)i;
+            }
+        });
+
+        radixSort(nbChunks, chunkBegin, scheduler);
+        buildCells(nbChunks, chunkBegin, scheduler);
+        buildNeighborCells(scheduler);
+    }
+
+    std::size_t getNbParticles() const { return m_nbParticles; }
+    std::size_t getNbCells() const { return m_cellKeys.size(); }
+
+    /// Original index of each particle, in sorted order
+    const std::vector<unsigned int>& getSortedIndices() const { return m_order; }
+
+    /// Sorted particles of cell c are in [getCellBegin(c), getCellEnd(c))
+    std::size_t getCellBegin(const std::size_t c) const { return m_cellStart[c]; }
+    std::size_t getCellEnd(const std::size_t c) const { return m_cellStart[c + 1]; }
+
+    /// Cell of each sorted particle
+    const std::vector<unsigned int>& getParticleCells() const { return m_particleCell; }
+
+    /// The NbNeighborCells cells around cell c (including c), -1 for empty cells
+    const int* getNeighborCells(const std::size_t c) const { return &m_neighborCells[c * NbNeighborCells]; }
+
+    Real getCellSize() const { return m_cellSize; }
+
+    /// Squared distance from x to the box of cell c, used to skip the neighbor cells out of reach
+    Real getCellDistance2(const std::size_t c, const Real* x) const
+    {
+        Real d2 = 0;
+        for (int k = 0; k < N; ++k)
+        {
+            const Real below = m_cellCorners[c][k] - x[k];
+            const Real above = x[k] - (m_cellCorners[c][k] + m_cellSize);
+            const Real d = std::max(Real(0), std::max(below, above));
+            d2 += d*d;
+        }
+        return d2;
+    }
+
+protected:
+    enum { BitsPerAxis = 21 }; ///< 63 bits keys in 3D
+    enum { RadixBits = 8 };
+    enum { RadixSize = 1 << RadixBits };
+
+    Key cellCoord(const Real x, const int k) const
+    {
+        const Real c = std::floor((x - m_origin[k]) * m_invCellSize);
+        const Key maxCoord = (Key(1) << BitsPerAxis) - 2;
+        if (!(c >= Real(0)))
+            return 1;
+        return std::min(Key(c) + 1, maxCoord);
+    }
+
+    Key encode(const Key* coords) const
+    {
+        Key key = 0;
+        for (unsigned int b = 0; b < m_bitsPerAxis; ++b)
+            for (int k = 0; k < N; ++k)
+                key |= ((coords[k] >> b) & 1) << (b * N + k);
+        return key;
+    }
+
+    void decode(Key key, Key* coords) const
+    {
+        for (int k = 0; k < N; ++k)
+            coords[k] = 0;
+        for (unsigned int b = 0; b < m_bitsPerAxis; ++b)
+            for (int k = 0; k < N; ++k)
+                coords[k] |= ((key >> (b * N + k)) & 1) << b;
+    }
+
+    /// Stable sort of (m_keys, m_order) by key, RadixBits bits per counting sort pass
+    template<class ChunkBegin>
+    void radixSort(const std::size_t nbChunks, const ChunkBegin& chunkBegin, simulation::TaskScheduler& scheduler)
+    {
+        const std::size_t n = m_nbParticles;
+        m_tmpKeys.resize(n);
+        m_tmpOrder.resize(n);
+        m_histogram.resize(nbChunks * RadixSize);
+
+        const unsigned int keyBits = m_bitsPerAxis * N;
+        for (unsigned int shift = 0; shift < keyBits; shift += RadixBits)
+        {
+            std::fill(m_histogram.begin(), m_histogram.end(), std::size_t(0));
+            simulation::parallelForEach(scheduler, 0, nbChunks, [&](const std::size_t c)
+            {
+                std::size_t* h = &m_histogram[c * RadixSize];
+                for (std::size_t i = chunkBegin(c); i < chunkBegin(c + 1); ++i)
+                    ++h[(m_keys[i] >> shift) & (RadixSize - 1)];
+            });
+
+            // Exclusive scan in (digit, chunk) order keeps the sort stable
+            std::size_t offset = 0;
+            bool singleDigit = false;
+            for (std::size_t d = 0; d < RadixSize; ++d)
+            {
+                std::size_t digitCount = 0;
+                for (std::size_t c = 0; c < nbChunks; ++c)
+                {
+                    std::size_t& h = m_histogram[c * RadixSize + d];
+                    const std::size_t count = h;
+                    h = offset;
+                    offset += count;
+                    digitCount += count;
+                }
+                if (digitCount == n)
+                    singleDigit = true;
+            }
+            if (singleDigit)
+                continue;
+
+            simulation::parallelForEach(scheduler, 0, nbChunks, [&](const std::size_t c)
+            {
+                std::size_t* h = &m_histogram[c * RadixSize];
+                for (std::size_t i = chunkBegin(c); i < chunkBegin(c + 1); ++i)
+                {
+                    const std::size_t dst = h[(m_keys[i] >> shift) & (RadixSize - 1)]++;
+                    m_tmpKeys[dst] = m_keys[i];
+                    m_tmpOrder[dst] = m_order[i];
+                }
+            });
+            m_keys.swap(m_tmpKeys);
+            m_order.swap(m_tmpOrder);
+        }
+    }
+
+    /// Contiguous ranges of sorted particles sharing the same key
+    template<class ChunkBegin>
+    void buildCells(const std::size_t nbChunks, const ChunkBegin& chunkBegin, simulation::TaskScheduler& scheduler)
+    {
+        std::vector<std::size_t> chunkCells(nbChunks + 1, 0);
+        simulation::parallelForEach(scheduler, 0, nbChunks, [&](const std::size_t c)
+        {
+            std::size_t count = 0;
+            for (std::size_t i = chunkBegin(c); i < chunkBegin(c + 1); ++i)
+                if (i == 0 || m_keys[i] != m_keys[i - 1])
+                    ++count;
+            chunkCells[c + 1] = count;
+        });
+        for (std::size_t c = 0; c < nbChunks; ++c)
+            chunkCells[c + 1] += chunkCells[c];
+
+        const std::size_t nbCells = chunkCells[nbChunks];
+        m_cellKeys.resize(nbCells);
+        m_cellStart.resize(nbCells + 1);
+        m_cellStart[nbCells] = m_nbParticles;
+        simulation::parallelForEach(scheduler, 0, nbChunks, [&](const std::size_t c)
+        {
+            std::size_t cell = chunkCells[c];
+            for (std::size_t i = chunkBegin(c); i < chunkBegin(c + 1); ++i)
+            {
+                if (i == 0 || m_keys[i] != m_keys[i - 1])
+                {
+                    m_cellKeys[cell] = m_keys[i];
+                    m_cellStart[cell] = i;
+                    ++cell;
+                }
+                m_particleCell[i] = (unsigned int)(cell - 1);
+            }
+        });
+    }
+
+    void buildNeighborCells(simulation::TaskScheduler& scheduler)
+    {
+        const std::size_t nbCells = m_cellKeys.size();
+        m_neighborCells.resize(nbCells * NbNeighborCells);
+        m_cellCorners.resize(nbCells);
+        simulation::parallelForEachRange(scheduler, 0, nbCells, [&](const std::size_t first, const std::size_t last)
+        {
+            for (std::size_t c = first; c < last; ++c)
+            {
+                Key coords[N];
+                decode(m_cellKeys[c], coords);
+                for (int k = 0; k < N; ++k)
+                    m_cellCorners[c][k] = m_origin[k] + Real(coords[k] - 1) * m_cellSize;
+                int* neighbors = &m_neighborCells[c * NbNeighborCells];
+                for (int o = 0; o < NbNeighborCells; ++o)
+                {
+                    Key ncoords[N];
+                    int offset = o;
+                    for (int k = 0; k < N; ++k)
+                    {
+                        ncoords[k] = coords[k] + (offset % 3) - 1;
+                        offset /= 3;
+                    }
+                    const Key nkey = encode(ncoords);
+                    const auto it = std::lower_bound(m_cellKeys.begin(), m_cellKeys.end(), nkey);
+                    neighbors[o] = (it != m_cellKeys.end() && *it == nkey) ? int(it - m_cellKeys.begin()) : -1;
+                }
+            }
+        }, 64);
+    }
+
+    std::size_t m_nbParticles = 0;
+    Coord m_origin;
+    Real m_cellSize = 0;
+    Real m_invCellSize = 0;
+    unsigned int m_bitsPerAxis = 1;
+
+    std::vector<Key> m_keys;
+    std::vector<unsigned int> m_order;
+    std::vector<Key> m_tmpKeys;
+    std::vector<unsigned int> m_tmpOrder;
+    std::vector<std::size_t> m_histogram;
+
+    std::vector<Key> m_cellKeys;
+    std::vector<std::size_t> m_cellStart;
+    std::vector<unsigned int> m_particleCell;
+    std::vector<int> m_neighborCells;
+    std::vector<Coord> m_cellCorners;
+};
+
+} // namespace forcefield
+
+} // namespace component
+
+} // namespace sofa
+
+#endif // SOFA_COMPONENT_FORCEFIELD_SPHCELLGRID_H
@@ -28,6 +28,7 @@
 #include <sofa/core/behavior/MechanicalState.h>
 #include <SofaSphFluid/SpatialGridContainer.h>
 #include <SofaSphFluid/SPHKernel.h>
+#include <SofaSphFluid/SPHCellGrid.h>
 #include <sofa/helper/rmath.h>
 #include <vector>
 #include <cmath>
@@ -78,6 +79,7 @@ public:
     Data< int > d_viscosityType; ///< 0 = none, 1 = default viscosity using kernel Laplacian, 2 = artificial viscosity
     Data< int > d_surfaceTensionType; ///< 0 = none, 1 = default surface tension using kernel Laplacian, 2 = cohesion forces surface tension from Becker et al. 2007
     Data< bool > d_debugGrid;
+    Data< bool > d_useCellList; ///< find neighbors with a cell list rebuilt in parallel every step, and compute the SPH passes in parallel over the sorted particles
 protected:
     struct Particle
     {
@@ -96,6 +98,43 @@ protected:
 
     Grid* m_grid;
 
+    /// Particle data in the order of the cell list, with one array per coordinate so that the loops over
+    /// the candidate neighbors of the cells run over contiguous memory
+    struct SortedParticles
+    {
+        enum { N = Coord::spatial_dimensions };
+        std::vector<Real> x[N];
+        std::vector<Real> v[N];
+        std::vector<Real> density;
+        std::vector<Real> pressure;
+        std::vector<Real> curvature;
+        std::vector<Deriv> normal;
+
+        /// neighbors of particle i (sorted indices and r/h) are in [neighborBegin[i], neighborBegin[i+1])
+        std::vector<unsigned int> neighborBegin;
+        std::vector<unsigned int> neighborIndex;
+        std::vector<Real> neighborDistance;
+        std::vector< std::vector<unsigned int> > chunkIndex;
+        std::vector< std::vector<Real> > chunkDistance;
+
+        void resize(std::size_t n)
+        {
+            neighborBegin.resize(n + 1);
+            for (int a = 0; a < N; ++a)
+            {
+                x[a].resize(n);
+                v[a].resize(n);
+            }
+            density.resize(n);
+            pressure.resize(n);
+            curvature.resize(n);
+            normal.resize(n);
+        }
+    };
+
+    SPHCellGrid<Coord> m_cellGrid;
+    SortedParticles m_sortedParticles;
+
     SPHFluidForceFieldInternalData<DataTypes> data;
     friend class SPHFluidForceFieldInternalData<DataTypes>;
 
@@ -190,6 +229,12 @@ protected:
     void computeNeighbors(const core::MechanicalParams* mparams, const DataVecCoord& d_x, const DataVecDeriv& d_v);
     template<class Kd, class Kp, class Kv, class Kc>
     void computeForce(const core::MechanicalParams* mparams, DataVecDeriv& d_f, const DataVecCoord& d_x, const DataVecDeriv& d_v);
+    /// Rebuild the cell list and the neighbors of all particles, in sorted order
+    void computeNeighborsCellList(const DataVecCoord& d_x, const DataVecDeriv& d_v);
+    /// Same as computeForce, but each particle gathers the contributions of all its neighbors from the
+    /// cell list, in parallel over the particles
+    template<class Kd, class Kp, class Kv, class Kc>
+    void computeForceCellList(DataVecDeriv& d_f, const DataVecCoord& d_x, const DataVecDeriv& d_v);
 };
 
 #if  !defined(SOFA_COMPONENT_FORCEFIELD_SPHFLUIDFORCEFIELD_CPP)
@@ -29,6 +29,7 @@
 #include <cmath>
 #include <iostream>
 #include <sofa/helper/AdvancedTimer.h>
+#include <sofa/simulation/ParallelForEach.h>
 
 #if __cplusplus >= 201703L
 #include <execution>
@@ -56,6 +57,7 @@ SPHFluidForceField<DataTypes>::SPHFluidForceField()
     , d_viscosityType(initData(&d_viscosityType, 1, "viscosityType", "0 = none, 1 = default d_viscosity using kernel Laplacian, 2 = artificial d_viscosity"))
     , d_surfaceTensionType(initData(&d_surfaceTensionType, 1, "surfaceTensionType", "0 = none, 1 = default surface tension using kernel Laplacian, 2 = cohesion forces surface tension from Becker et al. 2007"))
     , d_debugGrid(initData(&d_debugGrid, false, "debugGrid", "If true will store additionnal information on the grid to check neighbors and draw them"))
+    , d_useCellList(initData(&d_useCellList, false, "useCellList", "If true, neighbors are found with a cell list sorted along a Z-order curve, rebuilt in parallel every step, and the SpatialGridContainer is not used. Neighbor lists are not stored, so they are not drawn"))
     , m_grid(nullptr)
 {
 
@@ -77,7 +79,7 @@ void SPHFluidForceField<DataTypes>::init()
     sout << sendl;
 
     this->getContext()->get(m_grid); //new Grid(d_particleRadius.getValue());
-    if (m_grid==nullptr)
+    if (m_grid==nullptr && !d_useCellList.getValue())
         msg_error() << "SpatialGridContainer not found by SPHFluidForceField, slow O(n2) method will be used !!!";
 
     const unsigned n = this->mstate->getSize();
@@ -106,6 +108,29 @@ void SPHFluidForceField<DataTypes>::init()
 template<class DataTypes>
 void SPHFluidForceField<DataTypes>::addForce(const core::MechanicalParams* mparams, DataVecDeriv& d_f, const DataVecCoord& d_x, const DataVecDeriv& d_v)
 {
+    if (d_useCellList.getValue())
+    {
+        switch(d_kernelType.getValue())
+        {
+        default:
+            msg_error() << "Unsupported d_kernelType " << d_kernelType.getValue();
+            // fallthrough
+        case 0: // default
+            computeForceCellList <SPHKernel<SPH_KERNEL_DEFAULT_DENSITY,Deriv>,
+                                 SPHKernel<SPH_KERNEL_DEFAULT_PRESSURE,Deriv>,
+                                 SPHKernel<SPH_KERNEL_DEFAULT_VISCOSITY,Deriv>,
+                                 SPHKernel<SPH_KERNEL_DEFAULT_DENSITY,Deriv> > (d_f, d_x, d_v);
+            break;
+        case 1: // cubic
+            computeForceCellList <SPHKernel<SPH_KERNEL_CUBIC,Deriv>,
+                                 SPHKernel<SPH_KERNEL_CUBIC,Deriv>,
+                                 SPHKernel<SPH_KERNEL_CUBIC,Deriv>,
+                                 SPHKernel<SPH_KERNEL_CUBIC,Deriv> > (d_f, d_x, d_v);
+            break;
+        }
+        return;
+    }
+
     computeNeighbors(mparams, d_x, d_v);
 
     switch(d_kernelType.getValue())
@@ -404,6 +429,285 @@ void SPHFluidForceField<DataTypes>::computeForce(const core::MechanicalParams* /
 }
 
 
+template<class DataTypes>
+void SPHFluidForceField<DataTypes>::computeNeighborsCellList(const DataVecCoord& d_x, const DataVecDeriv& d_v)
+{
+    enum { N = Coord::spatial_dimensions };
+    typedef SPHCellGrid<Coord> CellGrid;
+
+    helper::ReadAccessor<DataVecCoord> x = d_x;
+    helper::ReadAccessor<DataVecDeriv> v = d_v;
+
+    const Real h = d_particleRadius.getValue();
+    const Real h2 = h*h;
+    const std::size_t n = x.size();
+
+    simulation::TaskScheduler* scheduler = simulation::TaskScheduler::getInstance();
+    m_cellGrid.build(n ? &x[0] : nullptr, n, h, *scheduler);
+    const std::vector<unsigned int>& order = m_cellGrid.getSortedIndices();
+
+    SortedParticles& s = m_sortedParticles;
+    s.resize(n);
+    simulation::parallelForEachRange(*scheduler, 0, n, [&](const std::size_t first, const std::size_t last)
+    {
+        for (std::size_t i = first; i < last; ++i)
+        {
+            const unsigned int p = order[i];
+            for (int a = 0; a < N; ++a)
+            {
+                s.x[a][i] = x[p][a];
+                s.v[a][i] = v[p][a];
+            }
+        }
+    }, 1024);
+
+    // Each chunk of cells appends the neighbors of its particles to its own buffers, which are then
+    // concatenated. The candidates are the particles of the neighbor cells within reach, contiguous in
+    // sorted order: each one is written to the buffer and only kept (by advancing the end of the buffer)
+    // if it is inside the radius, so that the distance loop has no branch.
+    const std::size_t nbCells = m_cellGrid.getNbCells();
+    const std::size_t nbChunks = std::min(nbCells, std::max(std::size_t(1), std::size_t(scheduler->getThreadCount()) * 4));
+    s.chunkIndex.resize(nbChunks);
+    s.chunkDistance.resize(nbChunks);
+    auto chunkFirstCell = [nbCells, nbChunks](const std::size_t c) { return nbCells * c / nbChunks; };
+
+    simulation::parallelForEach(*scheduler, 0, nbChunks, [&](const std::size_t chunk)
+    {
+        std::vector<unsigned int>& index = s.chunkIndex[chunk];
+        std::vector<Real>& distance = s.chunkDistance[chunk];
+        std::size_t size = 0;
+        const Real* sx[N];
+        for (int a = 0; a < N; ++a)
+            sx[a] = s.x[a].data();
+        for (std::size_t c = chunkFirstCell(chunk); c < chunkFirstCell(chunk + 1); ++c)
+        {
+            const int* neighborCells = m_cellGrid.getNeighborCells(c);
+            for (std::size_t i = m_cellGrid.getCellBegin(c); i < m_cellGrid.getCellEnd(c); ++i)
+            {
+                Real xi[N];
+                for (int a = 0; a < N; ++a)
+                    xi[a] = sx[a][i];
+
+                int cells[CellGrid::NbNeighborCells];
+                int nbReachedCells = 0;
+                std::size_t nbCandidates = 0;
+                for (int nc = 0; nc < CellGrid::NbNeighborCells; ++nc)
+                {
+                    if (neighborCells[nc] < 0 || m_cellGrid.getCellDistance2(neighborCells[nc], xi) >= h2) continue;
+                    cells[nbReachedCells++] = neighborCells[nc];
+                    nbCandidates += m_cellGrid.getCellEnd(neighborCells[nc]) - m_cellGrid.getCellBegin(neighborCells[nc]);
+                }
+                if (size + nbCandidates > index.size())
+                {
+                    index.resize(2 * (size + nbCandidates));
+                    distance.resize(2 * (size + nbCandidates));
+                }
+
+                const std::size_t first = size;
+                unsigned int* candidateIndex = index.data();
+                Real* candidateDistance = distance.data();
+                for (int nc = 0; nc < nbReachedCells; ++nc)
+                {
+                    const std::size_t end = m_cellGrid.getCellEnd(cells[nc]);
+                    for (std::size_t j = m_cellGrid.getCellBegin(cells[nc]); j < end; ++j)
+                    {
+                        Real r2 = 0;
+                        for (int a = 0; a < N; ++a)
+                        {
+                            const Real d = sx[a][j] - xi[a];
+                            r2 += d*d;
+                        }
+                        candidateIndex[size] = (unsigned int)j;
+                        candidateDistance[size] = r2;
+                        size += (r2 < h2) & (j != i);
+                    }
+                }
+                for (std::size_t e = first; e < size; ++e)
+                    candidateDistance[e] = (Real)sqrt(candidateDistance[e]/h2);
+                s.neighborBegin[i] = (unsigned int)(size - first);
+            }
+        }
+        index.resize(size);
+        distance.resize(size);
+    });
+
+    std::vector<std::size_t> chunkOffset(nbChunks + 1, 0);
+    for (std::size_t chunk = 0; chunk < nbChunks; ++chunk)
+        chunkOffset[chunk + 1] = chunkOffset[chunk] + s.chunkIndex[chunk].size();
+    s.neighborIndex.resize(chunkOffset[nbChunks]);
+    s.neighborDistance.resize(chunkOffset[nbChunks]);
+    s.neighborBegin[n] = (unsigned int)chunkOffset[nbChunks];
+
+    simulation::parallelForEach(*scheduler, 0, nbChunks, [&](const std::size_t chunk)
+    {
+        std::copy(s.chunkIndex[chunk].begin(), s.chunkIndex[chunk].end(), s.neighborIndex.begin() + chunkOffset[chunk]);
+        std::copy(s.chunkDistance[chunk].begin(), s.chunkDistance[chunk].end(), s.neighborDistance.begin() + chunkOffset[chunk]);
+        // counts to offsets
+        std::size_t offset = chunkOffset[chunk];
+        const std::size_t last = m_cellGrid.getCellBegin(chunkFirstCell(chunk + 1));
+        for (std::size_t i = m_cellGrid.getCellBegin(chunkFirstCell(chunk)); i < last; ++i)
+        {
+            const unsigned int count = s.neighborBegin[i];
+            s.neighborBegin[i] = (unsigned int)offset;
+            offset += count;
+        }
+    });
+}
+
+
+template<class DataTypes> template<class TKd, class TKp, class TKv, class TKc>
+void SPHFluidForceField<DataTypes>::computeForceCellList(DataVecDeriv& d_f, const DataVecCoord& d_x, const DataVecDeriv& d_v)
+{
+    enum { N = Coord::spatial_dimensions };
+
+    helper::WriteAccessor<DataVecDeriv> f = d_f;
+
+    const Real h = d_particleRadius.getValue();
+    const Real h2 = h*h;
+    const Real m = d_particleMass.getValue();
+    const Real m2 = m*m;
+    const Real d0 = d_density0.getValue();
+    const Real k = d_pressureStiffness.getValue();
+    const Real viscosity = d_viscosity.getValue();
+    const int viscosityT = (viscosity == 0) ? 0 : d_viscosityType.getValue();
+    const Real surfaceTension = d_surfaceTension.getValue();
+    const int surfaceTensionT = (surfaceTension <= 0) ? 0 : d_surfaceTensionType.getValue();
+    m_lastTime = (Real)this->getContext()->getTime();
+
+    computeNeighborsCellList(d_x, d_v);
+
+    const std::size_t n = d_x.getValue().size();
+    f.resize(n);
+    dforces.clear();
+    m_particles.resize(n);
+
+    TKd Kd(h);
+    TKp Kp(h);
+    TKv Kv(h);
+    TKc Kc(h);
+
+    simulation::TaskScheduler* scheduler = simulation::TaskScheduler::getInstance();
+    const std::size_t grainSize = 256;
+    const std::vector<unsigned int>& order = m_cellGrid.getSortedIndices();
+    SortedParticles& s = m_sortedParticles;
+
+    // Each particle gathers the contributions of its neighbors, so that the particles can be processed
+    // in parallel. The per-neighbor data is stored contiguously, in the cell order of the particles.
+
+    // Compute density and pressure
+    simulation::parallelForEachRange(*scheduler, 0, n, [&](const std::size_t first, const std::size_t last)
+    {
+        const Real density0 = m*Kd.W(0); // density from current particle
+        for (std::size_t i = first; i < last; ++i)
+        {
+            Real density = density0;
+            for (unsigned int e = s.neighborBegin[i]; e < s.neighborBegin[i+1]; ++e)
+                density += m*Kd.W(s.neighborDistance[e]);
+            s.density[i] = density;
+            s.pressure[i] = k*(density - d0);
+        }
+    }, grainSize);
+
+    // Compute surface normal and curvature
+    if (surfaceTensionT == 1)
+    {
+        simulation::parallelForEachRange(*scheduler, 0, n, [&](const std::size_t first, const std::size_t last)
+        {
+            for (std::size_t i = first; i < last; ++i)
+            {
+                const Real mi = m / s.density[i];
+                Deriv normal;
+                Real curvature = 0;
+                for (unsigned int e = s.neighborBegin[i]; e < s.neighborBegin[i+1]; ++e)
+                {
+                    const unsigned int j = s.neighborIndex[e];
+                    const Real r_h = s.neighborDistance[e];
+                    Deriv dij;
+                    for (int a = 0; a < N; ++a)
+                        dij[a] = s.x[a][i] - s.x[a][j];
+                    const Real dm = m / s.density[j] - mi;
+                    // same orientation as the pairwise loop, where the normal is
+                    // added to the particle of lower index and removed from the other
+                    normal += Kc.gradW(dij, r_h) * ((order[i] < order[j]) ? dm : -dm);
+                    curvature += Kc.laplacianW(r_h) * dm;
+                }
+                s.normal[i] = normal;
+                s.curvature[i] = curvature;
+            }
+        }, grainSize);
+    }
+
+    // Compute the forces, and scatter them with the particle data back to the original order
+    simulation::parallelForEachRange(*scheduler, 0, n, [&](const std::size_t first, const std::size_t last)
+    {
+        for (std::size_t i = first; i < last; ++i)
+        {
+            const Real densityI = s.density[i];
+            const Real pressureI = s.pressure[i] / (densityI*densityI);
+            Deriv fi;
+            for (unsigned int e = s.neighborBegin[i]; e < s.neighborBegin[i+1]; ++e)
+            {
+                const unsigned int j = s.neighborIndex[e];
+                const Real r_h = s.neighborDistance[e];
+                const Real densityJ = s.density[j];
+                Deriv dij, vij;
+                for (int a = 0; a < N; ++a)
+                {
+                    dij[a] = s.x[a][i] - s.x[a][j];
+                    vij[a] = s.v[a][i] - s.v[a][j];
+                }
+
+                // Pressure
+                Real pressureFV = ( - m2 * (pressureI + s.pressure[j] / (densityJ*densityJ)) );
+
+                // Viscosity
+                switch(viscosityT)
+                {
+                case 1:
+                    fi += vij * ( - m2 * viscosity / (densityI * densityJ) * Kv.laplacianW(r_h) );
+                    break;
+                case 2:
+                {
+                    const Real vx = dot(vij, dij);
+                    if (vx < 0)
+                    {
+                        pressureFV += (vx * viscosity * h * m / ((r_h*r_h + 0.01f*h2)*(densityI+densityJ)*0.5f));
+                    }
+                    break;
+                }
+                default:
+                    break;
+                }
+
+                fi += Kp.gradW(dij, r_h) * pressureFV;
+            }
+
+            const unsigned int p = order[i];
+            Particle& Pi = m_particles[p];
+            Pi.density = densityI;
+            Pi.pressure = s.pressure[i];
+            Pi.neighbors.clear();
+            if (surfaceTensionT == 1)
+            {
+                Pi.normal = s.normal[i];
+                Pi.curvature = s.curvature[i];
+                Real nn = Pi.normal.norm();
+                if (nn > 0.000001)
+                {
+                    fi += Pi.normal * ( - m * surfaceTension * Pi.curvature / nn );
+                }
+            }
+            else
+            {
+                Pi.normal.clear();
+                Pi.curvature = 0;
+            }
+            f[p] += fi;
+        }
+    }, grainSize);
+}
+
+
 template<class DataTypes>
 void SPHFluidForceField<DataTypes>::addDForce(const core::MechanicalParams* mparams, DataVecDeriv& d_df, const DataVecDeriv& d_dx)
 {
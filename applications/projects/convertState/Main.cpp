@@ -0,0 +1,58 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2019 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#include <SofaGeneralLoader/StateRecordFile.h>
+#include <iostream>
+#include <cstring>
+
+using sofa::component::misc::StateRecordFile;
+
+/// Convert a text state file written by WriteState into the binary format read by ReadState
+int main(int argc, char** argv)
+{
+    if (argc < 3)
+    {
+        std::cout << "USAGE: " << argv[0] << " input.txt[.gz] output.sstate [-float] [-compress]\n";
+        return 1;
+    }
+
+    StateRecordFile::ScalarType scalarType = StateRecordFile::DOUBLE;
+    StateRecordFile::Compression compression = StateRecordFile::NONE;
+    for (int i = 3; i < argc; ++i)
+    {
+        if (!strcmp(argv[i], "-float"))
+            scalarType = StateRecordFile::FLOAT;
+        else if (!strcmp(argv[i], "-compress"))
+            compression = StateRecordFile::ZLIB;
+        else
+        {
+            std::cerr << "Unknown option " << argv[i] << std::endl;
+            return 1;
+        }
+    }
+
+    if (!StateRecordFile::convertFromText(argv[1], argv[2], scalarType, compression))
+    {
+        std::cerr << "Error converting " << argv[1] << " to " << argv[2] << std::endl;
+        return 2;
+    }
+    return 0;
+}
@@ -0,0 +1,581 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2019 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU General Public License as published by the Free  *
+* Software Foundation; either version 2 of the License, or (at your option)   *
+* any later version.                                                          *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for    *
+* more details.                                                               *
+*                                                                             *
+* You should have received a copy of the GNU General Public License along     *
+* with this program. If not, see <http://www.gnu.org/licenses/>.              *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#include <sofa/helper/ArgumentParser.h>
+#include <sofa/helper/AdvancedTimer.h>
+#include <sofa/helper/BackTrace.h>
+#include <sofa/helper/system/FileRepository.h>
+#include <sofa/helper/system/PluginManager.h>
+#include <sofa/helper/system/thread/CTime.h>
+#include <sofa/helper/logging/Messaging.h>
+#include <sofa/simulation/Node.h>
+#include <SofaSimulationCommon/init.h>
+#include <SofaSimulationGraph/init.h>
+#include <SofaSimulationGraph/DAGSimulation.h>
+#include <SofaComponentBase/initComponentBase.h>
+#include <SofaComponentCommon/initComponentCommon.h>
+#include <SofaComponentGeneral/initComponentGeneral.h>
+#include <SofaComponentAdvanced/initComponentAdvanced.h>
+#include <SofaComponentMisc/initComponentMisc.h>
+
+#include <json.h>
+
+#ifdef SOFABENCHMARK_HAVE_SOFAHAPTICS
+#include <SofaHaptics/ForceFeedback.h>
+#include <sofa/core/behavior/MechanicalState.h>
+#include <sofa/defaulttype/RigidTypes.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+using sofa::helper::AdvancedTimer;
+using sofa::helper::StepData;
+using sofa::helper::system::DataRepository;
+using sofa::helper::system::PluginManager;
+using sofa::helper::system::thread::CTime;
+using sofa::simulation::Node;
+using json = sofa::helper::json;
+
+namespace
+{
+
+typedef std::chrono::steady_clock Clock;
+
+double elapsedMs(const Clock::time_point& start)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+/// Peak resident set size of the process since it started, in kilobytes.
+long peakResidentSetKb()
+{
+#ifdef WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return static_cast<long>(counters.PeakWorkingSetSize / 1024);
+    return 0;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return 0;
+#ifdef __APPLE__
+    return usage.ru_maxrss / 1024; // bytes on macOS
+#else
+    return usage.ru_maxrss;
+#endif
+#endif
+}
+
+/// Nearest-rank percentile of an already sorted sample, p in [0,100].
+double percentile(const std::vector<double>& sorted, double p)
+{
+    if (sorted.empty())
+        return 0.0;
+    const double rank = std::ceil(p / 100.0 * sorted.size());
+    const std::size_t index = rank < 1.0 ? 0 : static_cast<std::size_t>(rank) - 1;
+    return sorted[std::min(index, sorted.size() - 1)];
+}
+
+json stepStatistics(std::vector<double> stepTimes)
+{
+    json stats;
+    if (stepTimes.empty())
+        return stats;
+
+    std::sort(stepTimes.begin(), stepTimes.end());
+    double total = 0.0;
+    for (double t : stepTimes)
+        total += t;
+
+    stats["min"] = stepTimes.front();
+    stats["median"] = percentile(stepTimes, 50.0);
+    stats["mean"] = total / stepTimes.size();
+    stats["p95"] = percentile(stepTimes, 95.0);
+    stats["p99"] = percentile(stepTimes, 99.0);
+    stats["max"] = stepTimes.back();
+    return stats;
+}
+
+/// The nbSteps most expensive AdvancedTimer steps recorded under the "Animate" timer,
+/// sorted by decreasing total time.
+json topTimerSteps(unsigned int nbSteps)
+{
+    const double msPerTick = 1000.0 / static_cast<double>(CTime::getTicksPerSec());
+    std::map<AdvancedTimer::IdStep, StepData> stepData = AdvancedTimer::getStepData("Animate");
+
+    std::vector<const StepData*> steps;
+    for (const auto& it : stepData)
+    {
+        // level 0 is the "Animate" timer itself
+        if (it.second.level > 0 && it.second.num > 0)
+            steps.push_back(&it.second);
+    }
+    std::sort(steps.begin(), steps.end(), [](const StepData* a, const StepData* b)
+    {
+        return a->ttotal > b->ttotal;
+    });
+    if (steps.size() > nbSteps)
+        steps.resize(nbSteps);
+
+    json result = json::array();
+    for (const StepData* s : steps)
+    {
+        json step;
+        step["label"] = s->label;
+        step["level"] = s->level;
+        step["calls"] = s->num;
+        step["totalMs"] = s->ttotal * msPerTick;
+        step["meanMs"] = s->ttotal * msPerTick / s->num;
+        step["maxMs"] = s->tmax * msPerTick;
+        result.push_back(step);
+    }
+    return result;
+}
+
+#ifdef SOFABENCHMARK_HAVE_SOFAHAPTICS
+
+/// Calls the force feedback components of a scene at a fixed rate from its own thread, as a haptic
+/// device driver does, and records the duration of each tick and the period between ticks.
+class HapticLoop
+{
+public:
+    typedef sofa::component::controller::ForceFeedback ForceFeedback;
+    typedef sofa::defaulttype::SolidTypes<SReal>::Transform Transform;
+    typedef sofa::defaulttype::SolidTypes<SReal>::SpatialVector SpatialVector;
+
+    HapticLoop(Node* root, double rateHz)
+        : m_rateHz(rateHz)
+        , m_running(false)
+    {
+        root->get<ForceFeedback>(&m_forceFeedbacks, sofa::core::objectmodel::BaseContext::SearchDown);
+
+        // the tool stays where it is when the loop starts
+        for (ForceFeedback* forceFeedback : m_forceFeedbacks)
+        {
+            typedef sofa::defaulttype::Rigid3Types Rigid3Types;
+            Transform tool;
+            auto state = dynamic_cast<sofa::core::behavior::MechanicalState<Rigid3Types>*>(forceFeedback->getContext()->getMechanicalState());
+            if (state && !state->read(sofa::core::ConstVecCoordId::position())->getValue().empty())
+            {
+                const Rigid3Types::Coord& x = state->read(sofa::core::ConstVecCoordId::position())->getValue()[0];
+                tool = Transform(x.getCenter(), x.getOrientation());
+            }
+            m_tools.push_back(tool);
+        }
+    }
+
+    ~HapticLoop()
+    {
+        stop();
+    }
+
+    bool empty() const { return m_forceFeedbacks.empty(); }
+
+    void start()
+    {
+        // a minute of ticks, to keep the haptic thread from allocating
+        m_tickMs.reserve(std::size_t(m_rateHz * 60));
+        m_periodMs.reserve(std::size_t(m_rateHz * 60));
+        m_running = true;
+        m_thread = std::thread(&HapticLoop::run, this);
+    }
+
+    void stop()
+    {
+        m_running = false;
+        if (m_thread.joinable())
+            m_thread.join();
+    }
+
+    json report() const
+    {
+        const double periodMs = 1000.0 / m_rateHz;
+        json result;
+        result["rateHz"] = m_rateHz;
+        result["forceFeedbacks"] = m_forceFeedbacks.size();
+        result["ticks"] = m_tickMs.size();
+        result["overruns"] = std::count_if(m_tickMs.begin(), m_tickMs.end(), [periodMs](double t) { return t > periodMs; });
+        result["tickMs"] = stepStatistics(m_tickMs);
+        result["periodMs"] = stepStatistics(m_periodMs);
+        return result;
+    }
+
+private:
+    void run()
+    {
+        const Clock::duration period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / m_rateHz));
+        Clock::time_point next = Clock::now();
+        Clock::time_point previous;
+        SpatialVector velocity, wrench;
+
+        while (m_running)
+        {
+            std::this_thread::sleep_until(next);
+
+            const Clock::time_point tickStart = Clock::now();
+            if (previous != Clock::time_point())
+                m_periodMs.push_back(std::chrono::duration<double, std::milli>(tickStart - previous).count());
+            previous = tickStart;
+
+            for (std::size_t i = 0; i < m_forceFeedbacks.size(); ++i)
+                m_forceFeedbacks[i]->computeWrench(m_tools[i], velocity, wrench);
+
+            m_tickMs.push_back(elapsedMs(tickStart));
+
+            // late ticks are not caught up, as a device driver would not
+            next = std::max(next + period, Clock::now());
+        }
+    }
+
+    double m_rateHz;
+    std::vector<ForceFeedback*> m_forceFeedbacks;
+    std::vector<Transform> m_tools;
+    std::thread m_thread;
+    std::atomic<bool> m_running;
+    std::vector<double> m_tickMs;
+    std::vector<double> m_periodMs;
+};
+
+#endif // SOFABENCHMARK_HAVE_SOFAHAPTICS
+
+/// Load, initialize and animate one scene, returning its report (or a null json on failure).
+/// If hapticRate is not null, the force feedback components of the scene are called at this rate
+/// from another thread during the measured steps.
+json benchmarkScene(const std::string& filename, unsigned int nbWarmupSteps, unsigned int nbSteps, unsigned int nbTimerSteps, double hapticRate)
+{
+    sofa::simulation::Simulation* simulation = sofa::simulation::getSimulation();
+
+    Clock::time_point start = Clock::now();
+    Node::SPtr groot = simulation->load(filename.c_str());
+    const double loadMs = elapsedMs(start);
+    if (!groot)
+    {
+        msg_error("sofaBenchmark") << "Unable to load scene " << filename;
+        return json();
+    }
+
+    start = Clock::now();
+    simulation->init(groot.get());
+    const double initMs = elapsedMs(start);
+
+    for (unsigned int i = 0; i < nbWarmupSteps; ++i)
+        simulation->animate(groot.get(), groot->getDt());
+
+    // Keep the timer from printing its own report while the measured steps run.
+    AdvancedTimer::clearData("Animate");
+    AdvancedTimer::setEnabled("Animate", true);
+    AdvancedTimer::setInterval("Animate", nbSteps + 1);
+
+#ifdef SOFABENCHMARK_HAVE_SOFAHAPTICS
+    std::unique_ptr<HapticLoop> hapticLoop;
+    if (hapticRate > 0.0)
+    {
+        hapticLoop.reset(new HapticLoop(groot.get(), hapticRate));
+        if (hapticLoop->empty())
+            msg_warning("sofaBenchmark") << "No force feedback component in scene " << filename;
+        else
+            hapticLoop->start();
+    }
+#else
+    SOFA_UNUSED(hapticRate);
+#endif
+
+    std::vector<double> stepTimes;
+    stepTimes.reserve(nbSteps);
+    for (unsigned int i = 0; i < nbSteps; ++i)
+    {
+        start = Clock::now();
+        AdvancedTimer::begin("Animate");
+        simulation->animate(groot.get(), groot->getDt());
+        AdvancedTimer::end("Animate");
+        stepTimes.push_back(elapsedMs(start));
+    }
+
+#ifdef SOFABENCHMARK_HAVE_SOFAHAPTICS
+    if (hapticLoop)
+        hapticLoop->stop();
+#endif
+
+    json report;
+    report["scene"] = filename;
+    report["loadMs"] = loadMs;
+    report["initMs"] = initMs;
+    report["warmupSteps"] = nbWarmupSteps;
+    report["steps"] = nbSteps;
+    report["stepMs"] = stepStatistics(stepTimes);
+    report["peakRSSKb"] = peakResidentSetKb();
+    report["timerSteps"] = topTimerSteps(nbTimerSteps);
+#ifdef SOFABENCHMARK_HAVE_SOFAHAPTICS
+    if (hapticLoop && !hapticLoop->empty())
+        report["haptics"] = hapticLoop->report();
+#endif
+
+    AdvancedTimer::setEnabled("Animate", false);
+    AdvancedTimer::clearData("Animate");
+
+    simulation->unload(groot);
+    return report;
+}
+
+/// Compare the median and p95 step times of each scene against a previous report.
+/// Returns the number of scenes slower than the baseline by more than tolerance percent.
+unsigned int compareToBaseline(json& report, const json& baseline, double tolerance)
+{
+    unsigned int nbRegressions = 0;
+    const json& baseScenes = baseline["scenes"];
+    for (json& scene : report["scenes"])
+    {
+        auto base = std::find_if(baseScenes.begin(), baseScenes.end(), [&scene](const json& s)
+        {
+            return s["scene"] == scene["scene"];
+        });
+        if (base == baseScenes.end())
+        {
+            msg_warning("sofaBenchmark") << "No baseline for scene " << scene["scene"].get<std::string>();
+            continue;
+        }
+
+        json comparison;
+        bool regression = false;
+        for (const char* metric : { "median", "p95" })
+        {
+            const double current = scene["stepMs"][metric];
+            const double reference = (*base)["stepMs"][metric];
+            const double change = reference > 0.0 ? 100.0 * (current - reference) / reference : 0.0;
+            comparison[metric]["baselineMs"] = reference;
+            comparison[metric]["changePercent"] = change;
+            if (change > tolerance)
+            {
+                regression = true;
+                msg_error("sofaBenchmark") << scene["scene"].get<std::string>() << ": " << metric
+                                           << " step time " << current << " ms is " << change
+                                           << "% slower than the baseline (" << reference << " ms)";
+            }
+        }
+        comparison["regression"] = regression;
+        scene["baseline"] = comparison;
+        if (regression)
+            ++nbRegressions;
+    }
+    return nbRegressions;
+}
+
+} // anonymous namespace
+
+int main(int argc, char** argv)
+{
+    sofa::helper::BackTrace::autodump();
+
+    bool showHelp = false;
+    unsigned int nbWarmupSteps = 10;
+    unsigned int nbSteps = 100;
+    unsigned int nbTimerSteps = 10;
+    double tolerance = 5.0;
+    double hapticRate = 0.0;
+    std::string outputFile;
+    std::string baselineFile;
+    std::string dataPath;
+    std::vector<std::string> plugins;
+
+    sofa::helper::ArgumentParser argParser(argc, argv);
+    argParser.addArgument(
+        boost::program_options::value<bool>(&showHelp)
+        ->default_value(false)
+        ->implicit_value(true),
+        "help,h",
+        "Display this help message. Scenes are given as positional arguments, "
+        "or through a \".ini\" file containing one scene per line."
+    );
+    argParser.addArgument(
+        boost::program_options::value<unsigned int>(&nbWarmupSteps)->default_value(10),
+        "warmup,w",
+        "Number of untimed steps run after init"
+    );
+    argParser.addArgument(
+        boost::program_options::value<unsigned int>(&nbSteps)->default_value(100),
+        "steps,n",
+        "Number of measured steps"
+    );
+    argParser.addArgument(
+        boost::program_options::value<unsigned int>(&nbTimerSteps)->default_value(10),
+        "top,t",
+        "Number of AdvancedTimer steps reported per scene, by decreasing total time"
+    );
+    argParser.addArgument(
+        boost::program_options::value<std::string>(&outputFile),
+        "output,o",
+        "Write the JSON report to this file instead of the standard output"
+    );
+    argParser.addArgument(
+        boost::program_options::value<std::string>(&baselineFile),
+        "baseline,b",
+        "JSON report of a previous run to compare against"
+    );
+    argParser.addArgument(
+        boost::program_options::value<double>(&tolerance)->default_value(5.0),
+        "tolerance",
+        "Allowed slowdown in percent of the median and p95 step times before a scene counts as a regression"
+    );
+    argParser.addArgument(
+        boost::program_options::value<double>(&hapticRate)->default_value(0.0),
+        "haptics",
+        "Rate in Hz at which the force feedback components are called from a separate thread during the measured steps, "
+        "the duration of these calls and their period are reported (0 to disable)"
+    );
+    argParser.addArgument(
+        boost::program_options::value<std::vector<std::string>>(&plugins),
+        "load,l",
+        "load given plugins"
+    );
+    argParser.addArgument(
+        boost::program_options::value<std::string>(&dataPath),
+        "datapath,a",
+        "A colon-separated (semi-colon on Windows) list of directories to search for data files (scenes, resources...)"
+    );
+    argParser.parse();
+    const std::vector<std::string> fileArguments = argParser.getInputFileList();
+
+    if (showHelp || fileArguments.empty())
+    {
+        argParser.showHelp();
+        return showHelp ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    sofa::simulation::common::init();
+    sofa::simulation::graph::init();
+    sofa::component::initComponentBase();
+    sofa::component::initComponentCommon();
+    sofa::component::initComponentGeneral();
+    sofa::component::initComponentAdvanced();
+    sofa::component::initComponentMisc();
+    sofa::simulation::setSimulation(new sofa::simulation::graph::DAGSimulation());
+
+    for (const std::string& plugin : plugins)
+        PluginManager::getInstance().loadPlugin(plugin);
+    PluginManager::getInstance().init();
+
+    if (!dataPath.empty())
+        DataRepository.addLastPath(dataPath);
+
+#ifndef SOFABENCHMARK_HAVE_SOFAHAPTICS
+    if (hapticRate > 0.0)
+        msg_warning("sofaBenchmark") << "Built without SofaHaptics, the haptics option is ignored";
+#endif
+
+    std::vector<std::string> sceneFiles;
+    for (std::string currentFile : fileArguments)
+    {
+        DataRepository.findFile(currentFile);
+        if (currentFile.size() > 4 && currentFile.compare(currentFile.size() - 4, 4, ".ini") == 0)
+        {
+            // one scene per line, extra words on a line are ignored
+            std::ifstream iniFileStream(currentFile.c_str());
+            std::string line;
+            while (std::getline(iniFileStream, line))
+            {
+                std::istringstream lineStream(line);
+                std::string currentScene;
+                if (!(lineStream >> currentScene) || currentScene[0] == '#')
+                    continue;
+                DataRepository.findFile(currentScene);
+                sceneFiles.push_back(currentScene);
+            }
+        }
+        else
+        {
+            sceneFiles.push_back(currentFile);
+        }
+    }
+
+    json report;
+    report["warmupSteps"] = nbWarmupSteps;
+    report["steps"] = nbSteps;
+    report["scenes"] = json::array();
+
+    int exitCode = EXIT_SUCCESS;
+    for (const std::string& scene : sceneFiles)
+    {
+        msg_info("sofaBenchmark") << "Benchmarking " << scene;
+        json sceneReport = benchmarkScene(scene, nbWarmupSteps, nbSteps, nbTimerSteps, hapticRate);
+        if (sceneReport.is_null())
+        {
+            exitCode = EXIT_FAILURE;
+            continue;
+        }
+        report["scenes"].push_back(sceneReport);
+    }
+
+    if (!baselineFile.empty())
+    {
+        std::ifstream baselineStream(baselineFile.c_str());
+        json baseline;
+        try
+        {
+            baselineStream >> baseline;
+        }
+        catch (const std::exception& e)
+        {
+            msg_error("sofaBenchmark") << "Unable to read baseline " << baselineFile << ": " << e.what();
+            baseline = json();
+        }
+        if (baseline.is_object() && baseline["scenes"].is_array())
+        {
+            report["baselineTolerancePercent"] = tolerance;
+            if (compareToBaseline(report, baseline, tolerance) > 0)
+                exitCode = EXIT_FAILURE;
+        }
+        else
+        {
+            exitCode = EXIT_FAILURE;
+        }
+    }
+
+    if (outputFile.empty())
+    {
+        std::cout << report.dump(4) << std::endl;
+    }
+    else
+    {
+        std::ofstream outputStream(outputFile.c_str());
+        outputStream << report.dump(4) << std::endl;
+    }
+
+    sofa::simulation::common::cleanup();
+    sofa::simulation::graph::cleanup();
+    return exitCode;
+}
@@ -0,0 +1,21 @@
+#!/bin/bash
+# Compare the sequential and parallel element loops of TetrahedronFEMForceField,
+# with the scalar and the batched SIMD force kernels,
+# on bars of 16x16x(5*s+1) nodes (6750*s tetrahedra), from the SOFA root directory:
+#   examples/Benchmark/Performance/run-Bar16-fem-parallel.sh [runSofa]
+sofa=${1:-runSofa}
+for i in 1 2 4 8 16 32;
+do
+for p in 0 1;
+do
+for v in 0 1;
+do
+export s=$i
+export p
+export v
+echo Vec3d - $i - parallel=$p - simd=$v
+php examples/Benchmark/Performance/Bar16-fem-parallel-Vec3d.pscn > examples/Benchmark/Performance/Bar16-fem-parallel-Vec3d.scn
+$sofa -g batch -n 100 examples/Benchmark/Performance/Bar16-fem-parallel-Vec3d.scn 2>&1 | grep "iterations done"
+done
+done
+done
@@ -0,0 +1,13 @@
+#!/bin/bash
+# Measure the haptic loop of an LCPForceFeedback called at 1 kHz from its own thread while the
+# instrument rests on a s*s*s hexahedral FEM body, from the SOFA root directory:
+#   examples/Benchmark/Performance/run-HapticsLoop.sh [sofaBenchmark]
+# tickMs is the duration of each haptic tick, periodMs the time between two ticks.
+benchmark=${1:-sofaBenchmark}
+for i in 10 15 20 25;
+do
+export s=$i
+echo $((i*i*i)) points
+php examples/Benchmark/Performance/HapticsLoop.pscn > examples/Benchmark/Performance/HapticsLoop.scn
+$benchmark -w 10 -n 200 --haptics 1000 examples/Benchmark/Performance/HapticsLoop.scn 2>&1 | grep -A 22 '"haptics"'
+done
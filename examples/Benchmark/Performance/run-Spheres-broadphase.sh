@@ -0,0 +1,17 @@
+#!/bin/bash
+# Compare the broad phase detections on s*s*s spheres, each in its own collision model,
+# falling on a fixed layer of spheres, from the SOFA root directory:
+#   examples/Benchmark/Performance/run-Spheres-broadphase.sh [runSofa]
+sofa=${1:-runSofa}
+for i in 6 8 10 12;
+do
+for m in BruteForceDetection-0 DirectSAP-0 IncrSAP-0 BVHDetection-0 BVHDetection-1;
+do
+export s=$i
+export d=${m%-*}
+export p=${m#*-}
+echo $d - $((i*i*i)) spheres - parallel=$p
+php examples/Benchmark/Performance/Spheres-broadphase.pscn > examples/Benchmark/Performance/Spheres-broadphase.scn
+$sofa -g batch -n 100 examples/Benchmark/Performance/Spheres-broadphase.scn 2>&1 | grep "iterations done"
+done
+done
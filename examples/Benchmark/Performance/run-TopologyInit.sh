@@ -0,0 +1,19 @@
+#!/bin/bash
+# Time the creation of the topology arrays (edges, faces, shells) of the hexahedron, tetrahedron
+# and triangle containers built from s*s*s grids, from the SOFA root directory:
+#   examples/Benchmark/Performance/run-TopologyInit.sh [sofaBenchmark]
+# The arrays are built in the calling thread, then on the task scheduler threads (parallelInit),
+# initMs is the scene init time.
+benchmark=${1:-sofaBenchmark}
+for i in 20 40 60 80 100;
+do
+export s=$i
+echo $((i*i*i)) points - $(((i-1)*(i-1)*(i-1)*6)) tetrahedra
+for p in 0 1;
+do
+export parallel=$p
+echo parallelInit=$p
+php examples/Benchmark/Performance/TopologyInit.pscn > examples/Benchmark/Performance/TopologyInit.scn
+$benchmark -w 0 -n 1 examples/Benchmark/Performance/TopologyInit.scn 2>&1 | grep "initMs"
+done
+done
@@ -26,6 +26,9 @@
 #include <sofa/helper/AdvancedTimer.h>
 #include <sofa/core/ObjectFactory.h>
 #include "ConstraintStoreLambdaVisitor.h"
+#include <SofaConstraint/LCPConstraintSolver.h>
+#include <sofa/simulation/TaskScheduler.h>
+#include <sofa/simulation/ParallelForEach.h>
 #include <algorithm>
 
 namespace sofa
@@ -77,6 +80,13 @@ GenericConstraintSolver::GenericConstraintSolver()
     , d_computeConstraintForces(initData(&d_computeConstraintForces,false,
                                         "computeConstraintForces",
                                         "enable the storage of the constraintForces (default = False)."))
+    , d_warmStart(initData(&d_warmStart, false, "warmStart",
+                           "Initialize the forces with the ones of the previous step, for the constraints having the same persistent identifiers (contacts). Not used by the unbuilt resolution."))
+    , d_parallelResolution(initData(&d_parallelResolution, "parallelResolution",
+                                    "Resolution of the constraint blocks on the task scheduler (not used by the unbuilt resolution):\n"
+                                    "None: sequential projected Gauss-Seidel\n"
+                                    "ColoredGaussSeidel: projected Gauss-Seidel, the blocks which are not coupled in the compliance being solved in parallel\n"
+                                    "Jacobi: projected Jacobi, all the blocks being solved in parallel (use sor < 1 to ensure the convergence)"))
     , current_cp(&m_cpBuffer[0])
     , last_cp(nullptr)
 {
@@ -105,6 +115,9 @@ GenericConstraintSolver::GenericConstraintSolver()
 
     maxIt.setRequired(true);
     tolerance.setRequired(true);
+
+    sofa::helper::OptionsGroup parallelResolution(3, "None", "ColoredGaussSeidel", "Jacobi");
+    d_parallelResolution.setValue(parallelResolution);
 }
 
 GenericConstraintSolver::~GenericConstraintSolver()
@@ -140,6 +153,15 @@ void GenericConstraintSolver::init()
         dx.realloc(&vop,false,true);
         m_dxId = dx.id();
     }
+
+    if (d_parallelResolution.getValue().getSelectedId() != GenericConstraintProblem::SEQUENTIAL)
+    {
+        if (unbuilt.getValue())
+            msg_warning() << "'parallelResolution' is not used by the unbuilt resolution.";
+        simulation::TaskScheduler::getInstance();
+    }
+    m_previousConstraints.clear();
+    m_previousForces.clear();
 }
 
 void GenericConstraintSolver::cleanup()
@@ -231,6 +253,18 @@ bool GenericConstraintSolver::buildSystem(const core::ConstraintParams *cParams,
     MechanicalGetConstraintResolutionVisitor(cParams, current_cp->constraintsResolutions).execute(context);
     sofa::helper::AdvancedTimer::stepEnd("Get Constraint Resolutions");
 
+    if (d_warmStart.getValue() && !unbuilt.getValue())
+    {
+        sofa::helper::AdvancedTimer::StepVar vtimer("Get Constraint Info");
+        m_constraintBlockInfo.clear();
+        m_constraintIds.clear();
+        core::behavior::BaseConstraint::VecConstCoord positions;
+        core::behavior::BaseConstraint::VecConstDeriv directions;
+        core::behavior::BaseConstraint::VecConstArea areas;
+        MechanicalGetConstraintInfoVisitor(cParams, m_constraintBlockInfo, m_constraintIds, positions, directions, areas).execute(context);
+        computeInitialGuess();
+    }
+
     msg_info() <<"GenericConstraintSolver: "<<numConstraints<<" constraints";
 
     // Test if the nodes containing the constraint correction are active (not sleeping)
@@ -365,6 +399,7 @@ bool GenericConstraintSolver::solveSystem(const core::ConstraintParams * /*cPara
     current_cp->allVerified = allVerified.getValue();
     current_cp->sor = sor.getValue();
     current_cp->unbuilt = unbuilt.getValue();
+    current_cp->parallelResolution = (GenericConstraintProblem::ParallelResolution)d_parallelResolution.getValue().getSelectedId();
 
     if (unbuilt.getValue())
     {
@@ -386,6 +421,9 @@ bool GenericConstraintSolver::solveSystem(const core::ConstraintParams * /*cPara
         sofa::helper::AdvancedTimer::stepBegin("ConstraintsGaussSeidel");
         current_cp->gaussSeidel(0, this);
         sofa::helper::AdvancedTimer::stepEnd("ConstraintsGaussSeidel");
+
+        if (d_warmStart.getValue())
+            keepConstraintForces();
     }
 
     this->currentError.setValue(current_cp->currentError);
@@ -520,6 +558,53 @@ bool GenericConstraintSolver::applyCorrection(const core::ConstraintParams *cPar
 }
 
 
+void GenericConstraintSolver::computeInitialGuess()
+{
+    double* force = current_cp->getF();
+    const int dimension = current_cp->getDimension();
+    for (unsigned cb = 0; cb < m_constraintBlockInfo.size(); ++cb)
+    {
+        const ConstraintBlockInfo& info = m_constraintBlockInfo[cb];
+        if (!info.hasId) continue;
+        std::map<core::behavior::BaseConstraint*, ConstraintBlockBuf>::const_iterator previt = m_previousConstraints.find(info.parent);
+        if (previt == m_previousConstraints.end()) continue;
+        const ConstraintBlockBuf& buf = previt->second;
+        const int c0 = info.const0;
+        const int nbl = (info.nbLines < buf.nbLines) ? info.nbLines : buf.nbLines;
+        for (int c = 0; c < info.nbGroups; ++c)
+        {
+            std::map<PersistentID,int>::const_iterator it = buf.persistentToConstraintIdMap.find(m_constraintIds[info.offsetId + c]);
+            if (it == buf.persistentToConstraintIdMap.end()) continue;
+            const int prevIndex = it->second;
+            if (prevIndex >= 0 && prevIndex+nbl <= (int) m_previousForces.size() && c0 + (c+1)*info.nbLines <= dimension)
+            {
+                for (int l=0; l<nbl; ++l)
+                    force[c0 + c*info.nbLines + l] = m_previousForces[prevIndex + l];
+            }
+        }
+    }
+}
+
+void GenericConstraintSolver::keepConstraintForces()
+{
+    const double* force = current_cp->getF();
+    m_previousForces.assign(force, force + current_cp->getDimension());
+
+    // only the constraints of this step are kept, removed contacts are forgotten
+    m_previousConstraints.clear();
+    // fill info from current ids
+    for (unsigned cb = 0; cb < m_constraintBlockInfo.size(); ++cb)
+    {
+        const ConstraintBlockInfo& info = m_constraintBlockInfo[cb];
+        if (!info.parent) continue;
+        if (!info.hasId) continue;
+        ConstraintBlockBuf& buf = m_previousConstraints[info.parent];
+        buf.nbLines = info.nbLines;
+        for (int c = 0; c < info.nbGroups; ++c)
+            buf.persistentToConstraintIdMap[m_constraintIds[info.offsetId + c]] = info.const0 + c*info.nbLines;
+    }
+}
+
 ConstraintProblem* GenericConstraintSolver::getConstraintProblem()
 {
     return last_cp;
@@ -622,14 +707,13 @@ void GenericConstraintProblem::gaussSeidel(double timeout, GenericConstraintSolv
     double t0 = (double)sofa::helper::system::thread::CTime::getTime() ;
     double timeScale = 1.0 / (double)sofa::helper::system::thread::CTime::getTicksPerSec();
 
-    double *dfree = getDfree();
     double *force = getF();
     double **w = getW();
     double tol = tolerance;
 
     double *d = _d.ptr();
 
-    int i, j, k, l, nb;
+    int i, j, nb;
 
     double error=0.0;
 
@@ -680,6 +764,29 @@ void GenericConstraintProblem::gaussSeidel(double timeout, GenericConstraintSolv
         tabErrors.resize(dimension);
     }
 
+    // the parallel resolutions are only used from the solver, and not in the haptic thread
+    simulation::TaskScheduler* scheduler = nullptr;
+    sofa::helper::vector<double> previousForces, blockErrors;
+    sofa::helper::vector<char> blockVerified;
+    if(parallelResolution != SEQUENTIAL)
+    {
+        if(solver)
+            scheduler = simulation::TaskScheduler::getInstance();
+        if(scheduler)
+        {
+            sofa::helper::AdvancedTimer::stepBegin("ComputeBlockColors");
+            computeBlockColors(*scheduler);
+            sofa::helper::AdvancedTimer::stepEnd("ComputeBlockColors");
+            blockErrors.resize(blockLines.size());
+            blockVerified.resize(blockLines.size());
+            if(parallelResolution == JACOBI)
+                previousForces.resize(dimension);
+            sofa::helper::AdvancedTimer::valSet("GS colors", blockColors.size());
+        }
+        else
+            parallelResolution = SEQUENTIAL;
+    }
+
     for(i=0; i<maxIterations; i++)
     {
         bool constraintsAreVerified = true;
@@ -689,63 +796,54 @@ void GenericConstraintProblem::gaussSeidel(double timeout, GenericConstraintSolv
         }
 
         error=0.0;
-        for(j=0; j<dimension; ) // increment of j realized at the end of the loop
+        if(parallelResolution == SEQUENTIAL)
         {
-            //1. nbLines provide the dimension of the constraint
-            nb = constraintsResolutions[j]->getNbLines();
-
-            //2. for each line we compute the actual value of d
-            //   (a)d is set to dfree
-            
-            std::vector<double> errF(&force[j], &force[j+nb]);
-            std::copy_n(&dfree[j], nb, &d[j]);
+            for(j=0; j<dimension; ) // increment of j realized at the end of the loop
+            {
+                //1. nbLines provide the dimension of the constraint
+                nb = constraintsResolutions[j]->getNbLines();
 
-            //   (b) contribution of forces are added to d     => TODO => optimization (no computation when force= 0 !!)
-            for(k=0; k<dimension; k++)
-                for(l=0; l<nb; l++)
-                    d[j+l] += w[j+l][k] * force[k];
+                //2-4. the violation is computed, the constraint is solved and its error is measured
+                double contraintError = solveBlock(j, force, tol, nullptr, constraintsAreVerified);
 
-            //3. the specific resolution of the constraint(s) is called
-            constraintsResolutions[j]->resolution(j, w, d, force, dfree);
+                error += contraintError;
+                if(solver)
+                    tabErrors[j] = contraintError;
 
-            //4. the error is measured (displacement due to the new resolution (i.e. due to the new force))
-            double contraintError = 0.0;
-            if(nb > 1)
+                j += nb;
+            }
+        }
+        else
+        {
+            // Jacobi: the violations are computed from the forces of the previous iteration
+            const double* f = force;
+            if(parallelResolution == JACOBI)
             {
-                for(l=0; l<nb; l++)
-                {
-                    double lineError = 0.0;
-                    for (int m=0; m<nb; m++)
-                    {
-                        double dofError = w[j+l][j+m] * (force[j+m] - errF[m]);
-                        lineError += dofError * dofError;
-                    }
-                    lineError = sqrt(lineError);
-                    if(lineError > tol)
-                        constraintsAreVerified = false;
-
-                    contraintError += lineError;
-                }
+                std::copy_n(force, dimension, previousForces.begin());
+                f = previousForces.data();
             }
-            else
+
+            // the blocks of a color are not coupled, the order in which they are solved does not change the result
+            for(const helper::vector<int>& color : blockColors)
             {
-                contraintError = fabs(w[j][j] * (force[j] - errF[0]));
-                if(contraintError > tol)
-                    constraintsAreVerified = false;
+                simulation::parallelForEach(*scheduler, 0, color.size(), [&](const std::size_t c)
+                {
+                    const int b = color[c];
+                    bool verified = true;
+                    blockErrors[b] = solveBlock(blockLines[b], f, tol, &blockNeighbors[b], verified);
+                    blockVerified[b] = verified;
+                }, 8);
             }
 
-            if(constraintsResolutions[j]->getTolerance())
+            // errors are summed in the order of the blocks, to be independent of the number of threads
+            for(std::size_t b=0; b<blockLines.size(); ++b)
             {
-                if(contraintError > constraintsResolutions[j]->getTolerance())
+                error += blockErrors[b];
+                if(!blockVerified[b])
                     constraintsAreVerified = false;
-                contraintError *= tol / constraintsResolutions[j]->getTolerance();
+                if(solver)
+                    tabErrors[blockLines[b]] = blockErrors[b];
             }
-
-            error += contraintError;
-            if(solver)
-                tabErrors[j] = contraintError;
-
-            j += nb;
         }
 
         if(showGraphs)
@@ -842,6 +940,164 @@ void GenericConstraintProblem::gaussSeidel(double timeout, GenericConstraintSolv
 }
 
 
+double GenericConstraintProblem::solveBlock(int j, const double* f, double tol, const helper::vector<int>* neighbors, bool& verified)
+{
+    double *dfree = getDfree();
+    double *force = getF();
+    double **w = getW();
+    double *d = _d.ptr();
+
+    //1. nbLines provide the dimension of the constraint
+    const int nb = constraintsResolutions[j]->getNbLines();
+
+    //2. for each line we compute the actual value of d
+    //   (a)d is set to dfree
+    double errFBuffer[6];
+    std::vector<double> errFVector;
+    double* errF = errFBuffer;
+    if(nb > 6)
+    {
+        errFVector.resize(nb);
+        errF = errFVector.data();
+    }
+    std::copy_n(&force[j], nb, errF);
+    std::copy_n(&dfree[j], nb, &d[j]);
+
+    //   (b) contribution of forces are added to d
+    if(neighbors)
+    {
+        // only the blocks coupled with this one: the other terms are products by 0
+        for(const int b : *neighbors)
+        {
+            const int k0 = blockLines[b];
+            const int k1 = k0 + constraintsResolutions[k0]->getNbLines();
+            for(int k=k0; k<k1; k++)
+                for(int l=0; l<nb; l++)
+                    d[j+l] += w[j+l][k] * f[k];
+        }
+    }
+    else
+    {
+        for(int k=0; k<dimension; k++)
+            for(int l=0; l<nb; l++)
+                d[j+l] += w[j+l][k] * f[k];
+    }
+
+    //3. the specific resolution of the constraint(s) is called
+    constraintsResolutions[j]->resolution(j, w, d, force, dfree);
+
+    //4. the error is measured (displacement due to the new resolution (i.e. due to the new force))
+    double contraintError = 0.0;
+    if(nb > 1)
+    {
+        for(int l=0; l<nb; l++)
+        {
+            double lineError = 0.0;
+            for (int m=0; m<nb; m++)
+            {
+                double dofError = w[j+l][j+m] * (force[j+m] - errF[m]);
+                lineError += dofError * dofError;
+            }
+            lineError = sqrt(lineError);
+            if(lineError > tol)
+                verified = false;
+
+            contraintError += lineError;
+        }
+    }
+    else
+    {
+        contraintError = fabs(w[j][j] * (force[j] - errF[0]));
+        if(contraintError > tol)
+            verified = false;
+    }
+
+    if(constraintsResolutions[j]->getTolerance())
+    {
+        if(contraintError > constraintsResolutions[j]->getTolerance())
+            verified = false;
+        contraintError *= tol / constraintsResolutions[j]->getTolerance();
+    }
+
+    return contraintError;
+}
+
+void GenericConstraintProblem::computeBlockColors(simulation::TaskScheduler& scheduler)
+{
+    double **w = getW();
+
+    blockLines.clear();
+    helper::vector<int> lineBlock(dimension);
+    for(int j=0; j<dimension; j += constraintsResolutions[j]->getNbLines())
+    {
+        std::fill_n(&lineBlock[j], constraintsResolutions[j]->getNbLines(), (int)blockLines.size());
+        blockLines.push_back(j);
+    }
+    const std::size_t nbBlocks = blockLines.size();
+
+    // blocks having non-zero entries in the lines of each block
+    blockNeighbors.resize(nbBlocks);
+    simulation::parallelForEach(scheduler, 0, nbBlocks, [&](const std::size_t b)
+    {
+        helper::vector<int>& neighbors = blockNeighbors[b];
+        neighbors.clear();
+        const int j = blockLines[b];
+        const int nb = constraintsResolutions[j]->getNbLines();
+        for(int k=0; k<dimension; )
+        {
+            const int kb = lineBlock[k];
+            const int k1 = k + constraintsResolutions[k]->getNbLines();
+            bool coupled = false;
+            for(int l=0; l<nb && !coupled; l++)
+                for(int m=k; m<k1 && !coupled; m++)
+                    coupled = (w[j+l][m] != 0.0);
+            if(coupled)
+                neighbors.push_back(kb);
+            k = k1;
+        }
+    }, 8);
+
+    blockColors.clear();
+    if(parallelResolution == JACOBI)
+    {
+        blockColors.resize(1);
+        for(std::size_t b=0; b<nbBlocks; ++b)
+            blockColors[0].push_back((int)b);
+        return;
+    }
+
+    // greedy coloring in the order of the blocks: as W is not necessarily symmetric,
+    // a block gets a different color than all the previous blocks it is coupled with in either direction
+    helper::vector< helper::vector<int> > previousNeighbors(nbBlocks);
+    for(std::size_t b=0; b<nbBlocks; ++b)
+    {
+        for(const int n : blockNeighbors[b])
+        {
+            if(n < (int)b)
+                previousNeighbors[b].push_back(n);
+            else if(n > (int)b)
+                previousNeighbors[n].push_back((int)b);
+        }
+    }
+    helper::vector<int> blockColor(nbBlocks, -1);
+    helper::vector<std::size_t> usedBy; // for each color, 1 + the last block having a previous neighbor of this color
+    for(std::size_t b=0; b<nbBlocks; ++b)
+    {
+        for(const int n : previousNeighbors[b])
+            usedBy[blockColor[n]] = b + 1;
+        std::size_t color = 0;
+        while(color < usedBy.size() && usedBy[color] == b + 1)
+            ++color;
+        if(color == usedBy.size())
+        {
+            usedBy.push_back(0);
+            blockColors.resize(color + 1);
+        }
+        blockColor[b] = (int)color;
+        blockColors[color].push_back((int)b);
+    }
+}
+
 void GenericConstraintProblem::unbuiltGaussSeidel(double timeout, GenericConstraintSolver* solver)
 {
     if(!dimension)
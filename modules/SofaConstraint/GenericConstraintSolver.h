@@ -25,7 +25,20 @@
 
 #include <SofaConstraint/ConstraintSolverImpl.h>
 #include <sofa/core/behavior/BaseConstraintCorrection.h>
+#include <sofa/core/behavior/BaseConstraint.h>
 #include <SofaBaseLinearSolver/SparseMatrix.h>
+#include <sofa/helper/OptionsGroup.h>
+#include <map>
+
+namespace sofa
+{
+
+namespace simulation
+{
+class TaskScheduler;
+}
+
+}
 
 namespace sofa
 {
@@ -59,10 +72,19 @@ public:
 
     std::vector< ConstraintCorrections > cclist_elems;
 
+    /// How the constraint blocks are solved when the problem is solved by the GenericConstraintSolver (built version only)
+    enum ParallelResolution
+    {
+        SEQUENTIAL = 0,        ///< projected Gauss-Seidel, one block after the other
+        COLORED_GAUSS_SEIDEL,  ///< projected Gauss-Seidel, the blocks which are not coupled in W being solved in parallel
+        JACOBI                 ///< projected Jacobi, all the blocks being solved in parallel from the forces of the previous iteration
+    };
+    ParallelResolution parallelResolution;
+
 
     GenericConstraintProblem() : scaleTolerance(true), allVerified(false), sor(1.0)
       , sceneTime(0.0), currentError(0.0), currentIterations(0)
-      , change_sequence(false) {}
+      , change_sequence(false), parallelResolution(SEQUENTIAL) {}
     ~GenericConstraintProblem() override { freeConstraintResolutions(); }
 
     void clear(int nbConstraints) override;
@@ -74,6 +96,23 @@ public:
 
     int getNumConstraints();
     int getNumConstraintGroups();
+
+    /// Number of colors used by the last colored Gauss-Seidel resolution
+    int getNumColors() const { return (int)blockColors.size(); }
+
+protected:
+    /// Solves the constraint block starting at line j, its violation being computed from the forces f.
+    /// If neighbors is not null, only the lines of W of these blocks are used to compute the violation.
+    /// Returns the error of the block, and sets verified to false if the block is not verified.
+    double solveBlock(int j, const double* f, double tol, const helper::vector<int>* neighbors, bool& verified);
+
+    /// Finds the blocks coupled in W with each block, and groups the blocks in colors such that
+    /// the blocks of a color are not coupled together (all the blocks are in a single color for Jacobi)
+    void computeBlockColors(simulation::TaskScheduler& scheduler);
+
+    helper::vector<int> blockLines; ///< first line of each constraint block
+    helper::vector< helper::vector<int> > blockNeighbors; ///< for each block, the blocks having non-zero entries of W in its lines, in increasing order
+    helper::vector< helper::vector<int> > blockColors; ///< blocks of each color, in increasing order
 };
 
 class SOFA_CONSTRAINT_API GenericConstraintSolver : public ConstraintSolverImpl
@@ -123,6 +162,8 @@ public:
     Data<bool> reverseAccumulateOrder; ///< True to accumulate constraints from nodes in reversed order (can be necessary when using multi-mappings or interaction constraints not following the node hierarchy)
     Data<helper::vector< double >> d_constraintForces; ///< OUTPUT: The Data constraintForces is used to provide the intensities of constraint forces in the simulation. The user can easily check the constraint forces from the GenericConstraint component interface.
     Data<bool> d_computeConstraintForces; ///< The indices of the constraintForces to store in the constraintForce data field.
+    Data<bool> d_warmStart; ///< Initialize the forces with the ones of the previous step, for the constraints having the same persistent identifiers (contacts)
+    Data<sofa::helper::OptionsGroup> d_parallelResolution; ///< Resolution of the constraint blocks on the task scheduler: None, ColoredGaussSeidel or Jacobi
 
     sofa::core::MultiVecDerivId getLambda() const override;
     sofa::core::MultiVecDerivId getDx() const override;
@@ -131,6 +172,28 @@ protected:
 
     void clearConstraintProblemLocks();
 
+    /// Initializes the forces of the current problem with the forces of the previous step, for the constraints still present
+    void computeInitialGuess();
+    /// Stores the forces of the current problem with the persistent identifiers of its constraints
+    void keepConstraintForces();
+
+    typedef core::behavior::BaseConstraint::ConstraintBlockInfo ConstraintBlockInfo;
+    typedef core::behavior::BaseConstraint::PersistentID PersistentID;
+    typedef core::behavior::BaseConstraint::VecConstraintBlockInfo VecConstraintBlockInfo;
+    typedef core::behavior::BaseConstraint::VecPersistentID VecPersistentID;
+
+    class ConstraintBlockBuf
+    {
+    public:
+        std::map<PersistentID,int> persistentToConstraintIdMap;
+        int nbLines; ///< how many dofs (i.e. lines in the matrix) are used by each constraint
+    };
+
+    VecConstraintBlockInfo m_constraintBlockInfo; ///< constraint blocks of the current step, used for the warm start
+    VecPersistentID m_constraintIds; ///< persistent identifiers of the constraints of the current step
+    std::map<core::behavior::BaseConstraint*, ConstraintBlockBuf> m_previousConstraints;
+    helper::vector< double > m_previousForces;
+
     enum { CP_BUFFER_SIZE = 10 };
     sofa::helper::fixed_array<GenericConstraintProblem,CP_BUFFER_SIZE> m_cpBuffer;
     sofa::helper::fixed_array<bool,CP_BUFFER_SIZE> m_cpIsLocked;
@@ -25,6 +25,7 @@
 
 #include <sofa/core/behavior/ConstraintCorrection.h>
 #include <sofa/core/objectmodel/DataFileName.h>
+#include <sofa/helper/io/MappedFile.h>
 
 #include <SofaBaseLinearSolver/FullMatrix.h>
 
@@ -72,6 +73,7 @@ public:
 	Data<double> debugViewFrameScale; ///< Scale on computed node's frame
 	sofa::core::objectmodel::DataFileName f_fileCompliance; ///< Precomputed compliance matrix data file
 	Data<std::string> fileDir; ///< If not empty, the compliance will be saved in this repertory
+    Data<bool> d_memoryMapping; ///< If true, the compliance file is memory mapped instead of being read at init
     
 protected:
     PrecomputedConstraintCorrection(sofa::core::behavior::MechanicalState<DataTypes> *mm = nullptr);
@@ -127,8 +129,9 @@ public:
     struct InverseStorage
     {
         Real* data;
+        helper::io::MappedFile* file; ///< mapping of the compliance file, data then points to its read-only content
         int nbref;
-        InverseStorage() : data(nullptr), nbref(0) {}
+        InverseStorage() : data(nullptr), file(nullptr), nbref(0) {}
     };
 
     std::string invName;
@@ -182,6 +185,13 @@ protected:
      */
     bool loadCompliance(std::string fileName);
 
+    /**
+     * @brief Read or map the compliance matrix stored in the file at the given path.
+     *
+     * @return Loading success.
+     */
+    bool readComplianceFile(const std::string& path);
+
     /**
      * @brief Save compliance matrix into a file.
      */
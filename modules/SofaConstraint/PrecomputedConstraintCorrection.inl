@@ -69,6 +69,7 @@ PrecomputedConstraintCorrection<DataTypes>::PrecomputedConstraintCorrection(sofa
     , debugViewFrameScale(initData(&debugViewFrameScale, 1.0, "debugViewFrameScale", "Scale on computed node's frame"))
     , f_fileCompliance(initData(&f_fileCompliance, "fileCompliance", "Precomputed compliance matrix data file"))
     , fileDir(initData(&fileDir, "fileDir", "If not empty, the compliance will be saved in this repertory"))
+    , d_memoryMapping(initData(&d_memoryMapping, false, "memoryMapping", "If true, the compliance file is memory mapped instead of being read at init: only the rows used by the constraints are loaded, and the mapping is shared between processes"))
     , invM(nullptr)
     , appCompliance(nullptr)
     , nbRows(0), nbCols(0), dof_on_node(0), nbNodes(0)
@@ -104,7 +105,8 @@ void PrecomputedConstraintCorrection<DataTypes>::releaseInverse(std::string name
     std::map< std::string, InverseStorage >& registry = getInverseMap();
     if (--inv->nbref == 0)
     {
-        if (inv->data) delete[] inv->data;
+        if (inv->file) delete inv->file;
+        else if (inv->data) delete[] inv->data;
         registry.erase(name);
     }
 }
@@ -144,41 +146,65 @@ bool PrecomputedConstraintCorrection<DataTypes>::loadCompliance(std::string file
         std::string dir = fileDir.getValue();
         if (!dir.empty())
         {
-            std::ifstream compFileIn((dir + "/" + fileName).c_str(), std::ifstream::binary);
-            if (compFileIn.is_open())
-            {
-                invM->data = new Real[nbRows * nbCols];
-
-                msg_info() << "File " << dir + "/" + fileName << " found. Loading..." ;
-
-                compFileIn.read((char*)invM->data, nbCols * nbRows * sizeof(double));
-                compFileIn.close();
-
-                return true;
-            }
-            else
-                return false;
+            return readComplianceFile(dir + "/" + fileName);
         }
         else if (recompute.getValue() == false)
         {
             if(sofa::helper::system::DataRepository.findFile(fileName))
             {
-                invM->data = new Real[nbRows * nbCols];
+                return readComplianceFile(fileName);
+            }
+        }
 
-                std::ifstream compFileIn(fileName.c_str(), std::ifstream::binary);
+        return false;
+    }
+
+    return true;
+}
 
-                msg_info() << "File " << fileName << " found. Loading..." ;
 
-                compFileIn.read((char*)invM->data, nbCols * nbRows * sizeof(double));
-                compFileIn.close();
 
-                return true;
-            }
+template<class DataTypes>
+bool PrecomputedConstraintCorrection<DataTypes>::readComplianceFile(const std::string& path)
+{
+    const std::size_t fileSize = std::size_t(nbRows) * nbCols * sizeof(Real);
+
+    if (d_memoryMapping.getValue())
+    {
+        helper::io::MappedFile* file = new helper::io::MappedFile(path, helper::io::MappedFile::Random);
+        if (!file->isOpen() || file->size() != fileSize)
+        {
+            if (file->isOpen())
+                msg_error() << "File " << path << " has " << file->size() << " bytes, " << fileSize << " expected";
+            delete file;
+            return false;
         }
 
+        msg_info() << "File " << path << " found. Mapping..." ;
+
+        // the compliance is only read once loaded
+        invM->file = file;
+        invM->data = reinterpret_cast<Real*>(const_cast<char*>(file->begin()));
+        return true;
+    }
+
+    std::ifstream compFileIn(path.c_str(), std::ifstream::binary | std::ifstream::ate);
+    if (!compFileIn.is_open())
+        return false;
+
+    if (std::size_t(compFileIn.tellg()) != fileSize)
+    {
+        msg_error() << "File " << path << " has " << compFileIn.tellg() << " bytes, " << fileSize << " expected";
         return false;
     }
 
+    msg_info() << "File " << path << " found. Loading..." ;
+
+    invM->data = new Real[std::size_t(nbRows) * nbCols];
+    compFileIn.seekg(0);
+    compFileIn.read((char*)invM->data, fileSize);
+    compFileIn.close();
+
     return true;
 }
 
@@ -197,7 +223,7 @@ void PrecomputedConstraintCorrection<DataTypes>::saveCompliance(const std::strin
         filePathInSofaShare  = sofa::helper::system::DataRepository.getFirstPath() + "/" + fileName;
 
     std::ofstream compFileOut(filePathInSofaShare.c_str(), std::fstream::out | std::fstream::binary);
-    compFileOut.write((char*)invM->data, nbCols * nbRows * sizeof(double));
+    compFileOut.write((char*)invM->data, std::size_t(nbRows) * nbCols * sizeof(Real));
     compFileOut.close();
 }
 
@@ -25,6 +25,16 @@ using sofa::helper::testing::BaseSimulationTest;
 #include <SofaSimulationGraph/SimpleApi.h>
 using namespace sofa::simpleapi;
 
+#include <SofaConstraint/GenericConstraintSolver.h>
+using sofa::component::constraintset::GenericConstraintSolver;
+using sofa::component::constraintset::GenericConstraintProblem;
+
+#include <SofaConstraint/UnilateralInteractionConstraint.h>
+using sofa::component::constraintset::UnilateralConstraintResolution;
+
+#include <sofa/simulation/DefaultTaskScheduler.h>
+#include <sofa/helper/RandomGenerator.h>
+
 namespace
 {
 
@@ -59,6 +69,69 @@ struct GenericConstraintSolver_test : BaseSimulationTest
         ASSERT_NE(solver, nullptr);
         ASSERT_STREQ(solver->findData("constraintForces")->getValueString().c_str(), "");
     }
+
+    /// Fills a problem of n unilateral constraints, each coupled in W with a few random other ones
+    void fillProblem(GenericConstraintProblem& problem, int n)
+    {
+        sofa::helper::RandomGenerator random(42);
+        problem.clear(n);
+        double** w = problem.getW();
+        double* dfree = problem.getDfree();
+        for(int i=0; i<n; i++)
+        {
+            w[i][i] += 4.0;
+            for(int c=0; c<2; c++)
+            {
+                const int k = (int)random.random<long>(0, n);
+                if(k == i)
+                    continue;
+                const double v = random.random<double>(-0.5, 0.5);
+                w[i][k] += v;
+                w[k][i] += v;
+                w[i][i] += 1.0;
+                w[k][k] += 1.0;
+            }
+            dfree[i] = random.random<double>(-1.0, 1.0);
+            problem.constraintsResolutions[i] = new UnilateralConstraintResolution();
+        }
+        problem.tolerance = 1e-12;
+        problem.maxIterations = 10000;
+        problem.allVerified = true;
+    }
+
+    /// The parallel resolutions find the same forces as the sequential Gauss-Seidel
+    void parallelResolution(GenericConstraintProblem::ParallelResolution mode)
+    {
+        const int n = 200;
+        GenericConstraintSolver::SPtr solver = sofa::core::objectmodel::New<GenericConstraintSolver>();
+
+        sofa::simulation::TaskScheduler* scheduler = sofa::simulation::TaskScheduler::create(sofa::simulation::DefaultTaskScheduler::name());
+        scheduler->init(4);
+
+        GenericConstraintProblem sequential;
+        fillProblem(sequential, n);
+        sequential.gaussSeidel(0, solver.get());
+
+        GenericConstraintProblem parallel;
+        fillProblem(parallel, n);
+        parallel.parallelResolution = mode;
+        parallel.gaussSeidel(0, solver.get());
+
+        scheduler->stop();
+
+        EXPECT_LT(sequential.currentError, 1e-10);
+        EXPECT_LT(parallel.currentError, 1e-10);
+        EXPECT_GT(parallel.getNumColors(), 0);
+        if(mode == GenericConstraintProblem::JACOBI)
+        {
+            EXPECT_EQ(parallel.getNumColors(), 1);
+        }
+        for(int i=0; i<n; i++)
+        {
+            EXPECT_GE(parallel.getF()[i], 0.0);
+            EXPECT_NEAR(parallel.getF()[i], sequential.getF()[i], 1e-8);
+        }
+    }
 };
 
 /// run the tests
@@ -68,6 +141,16 @@ TEST_F(GenericConstraintSolver_test, checkConstraintForce)
     enableConstraintForce();
 }
 
+TEST_F(GenericConstraintSolver_test, coloredGaussSeidel)
+{
+    parallelResolution(GenericConstraintProblem::COLORED_GAUSS_SEIDEL);
+}
+
+TEST_F(GenericConstraintSolver_test, jacobi)
+{
+    parallelResolution(GenericConstraintProblem::JACOBI);
+}
+
 
 } /// namespace sofa
 
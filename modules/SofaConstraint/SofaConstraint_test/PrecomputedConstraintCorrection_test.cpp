@@ -0,0 +1,96 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2019 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#include <SofaSimulationGraph/testing/BaseSimulationTest.h>
+using sofa::helper::testing::BaseSimulationTest;
+
+#include <SofaConstraint/PrecomputedConstraintCorrection.h>
+#include <sofa/helper/system/FileRepository.h>
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+using namespace sofa::simulation;
+
+namespace
+{
+
+typedef sofa::component::constraintset::PrecomputedConstraintCorrection<sofa::defaulttype::Vec3Types> PrecomputedConstraintCorrection3;
+
+/** Test the PrecomputedConstraintCorrection class */
+struct PrecomputedConstraintCorrection_test: public BaseSimulationTest
+{
+    /// load a compliance file, read or mapped, and check its values
+    void loadCompliance(bool memoryMapping)
+    {
+        const std::string dir = sofa::helper::system::DataRepository.getFirstPath();
+        const unsigned int nbRows = 6; // two nodes with three dofs
+
+        // the name of the compliance file is built from the name of the node, the size and the time step
+        std::ostringstream fileName;
+        fileName << dir << "/precomputed-" << nbRows << "-" << 0.01 << ".comp";
+        std::vector<double> compliance(nbRows * nbRows);
+        for (unsigned int i = 0; i < compliance.size(); ++i)
+            compliance[i] = 0.5 * i;
+        {
+            std::ofstream file(fileName.str().c_str(), std::ofstream::binary);
+            file.write((const char*)compliance.data(), compliance.size() * sizeof(double));
+        }
+
+        std::ostringstream scene;
+        scene << "<Node dt='0.01'>\n"
+                 "   <RequiredPlugin name='SofaComponentAll'/>"
+                 "   <Node name='precomputed'>\n"
+                 "         <MechanicalObject position='0 0 0  1 0 0' />\n"
+                 "         <PrecomputedConstraintCorrection fileDir='" << dir << "' memoryMapping='" << memoryMapping << "' />\n"
+                 "   </Node>\n"
+                 "</Node>\n";
+        SceneInstance sceneinstance("xml", scene.str());
+        sceneinstance.initScene();
+
+        PrecomputedConstraintCorrection3* correction = nullptr;
+        sceneinstance.root->get(correction, sofa::core::objectmodel::BaseContext::SearchDown);
+        ASSERT_NE(correction, nullptr);
+
+        const double* values = correction->getInverse();
+        ASSERT_NE(values, nullptr);
+        for (unsigned int i = 0; i < compliance.size(); ++i)
+            EXPECT_EQ(values[i], compliance[i]);
+
+        std::remove(fileName.str().c_str());
+    }
+};
+
+/// run the tests
+TEST_F( PrecomputedConstraintCorrection_test, loadCompliance)
+{
+    EXPECT_MSG_NOEMIT(Error) ;
+    loadCompliance(false);
+}
+
+TEST_F( PrecomputedConstraintCorrection_test, mapCompliance)
+{
+    EXPECT_MSG_NOEMIT(Error) ;
+    loadCompliance(true);
+}
+
+}
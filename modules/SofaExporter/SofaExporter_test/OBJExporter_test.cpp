@@ -122,6 +122,39 @@ public:
             EXPECT_TRUE( FileSystem::exists(pathToCheck) ) << "Problem with '" << pathToCheck  << "'";
         }
     }
+
+    void checkAsynchronousWriteEachNbStep(const std::string& filename, std::vector<std::string> pathes, unsigned int numstep){
+        dataPath = pathes ;
+
+        EXPECT_MSG_NOEMIT(Error, Warning) ;
+        std::stringstream scene1;
+        scene1 <<
+                "<?xml version='1.0'?> \n"
+                "<Node 	name='Root' gravity='0 0 0' time='0' animate='0'   >       \n"
+                "   <DefaultAnimationLoop/>                                        \n"
+                "   <OBJExporter name='exporterB' printLog='true' filename='"<< filename << "' exportEveryNumberOfSteps='5' asynchronous='true' maxPendingExports='1' /> \n"
+                "</Node>                                                           \n" ;
+
+        Node::SPtr root = SceneLoaderXML::loadFromMemory ("testscene",
+                                                          scene1.str().c_str(),
+                                                          scene1.str().size()) ;
+
+        ASSERT_NE(root.get(), nullptr) ;
+        root->init(ExecParams::defaultInstance()) ;
+
+        for(unsigned int i=0;i<numstep;i++)
+        {
+            sofa::simulation::getSimulation()->animate(root.get(), 0.5);
+        }
+
+        /// Unloading the scene waits for the pending exports.
+        sofa::simulation::getSimulation()->unload(root) ;
+
+        for(auto& pathToCheck : pathes)
+        {
+            EXPECT_TRUE( FileSystem::exists(pathToCheck) ) << "Problem with '" << pathToCheck  << "'";
+        }
+    }
 };
 
 /// run the tests
@@ -159,4 +192,11 @@ TEST_F( OBJExporter_test, checkSimulationWriteEachNbStep) {
                                                  tempdir+"/exporterA00003.obj", tempdir+"/exporterA00003.mtl",
                                                  tempdir+"/exporterA00004.obj", tempdir+"/exporterA00004.mtl"}, 20)  ;
 }
+
+TEST_F( OBJExporter_test, checkAsynchronousWriteEachNbStep) {
+   this->checkAsynchronousWriteEachNbStep(tempdir, {tempdir+"/exporterB00001.obj", tempdir+"/exporterB00001.mtl",
+                                                   tempdir+"/exporterB00002.obj", tempdir+"/exporterB00002.mtl",
+                                                   tempdir+"/exporterB00003.obj", tempdir+"/exporterB00003.mtl",
+                                                   tempdir+"/exporterB00004.obj", tempdir+"/exporterB00004.mtl"}, 20)  ;
+}
 }
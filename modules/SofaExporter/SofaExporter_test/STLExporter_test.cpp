@@ -138,6 +138,42 @@ public:
             EXPECT_TRUE( FileSystem::exists(pathToCheck) ) << "Problem with '" << pathToCheck  << "'";
         }
     }
+
+    void checkAsynchronousWriteEachNbStep(const std::string& filename, std::vector<std::string> pathes, unsigned int numstep){
+        dataPath = pathes ;
+
+        EXPECT_MSG_NOEMIT(Error, Warning) ;
+        std::stringstream scene1;
+        scene1 <<
+                "<?xml version='1.0'?> \n"
+                "<Node 	name='Root' gravity='0 0 0' time='0' animate='0'   >       \n"
+                "   <DefaultAnimationLoop/>                                        \n"
+                "   <MechanicalObject position='0 1 2 3 4 5 6 7 8 9'/>             \n"
+                "   <MeshObjLoader name='loader' filename='mesh/liver-smooth.obj'/> \n"
+                "   <OglModel src='@loader'/>                                      \n"
+                "   <STLExporter name='exporterB' printLog='true' filename='"<< filename << "' exportEveryNumberOfSteps='5' asynchronous='true' maxPendingExports='1' /> \n"
+                "</Node>                                                           \n" ;
+
+        Node::SPtr root = SceneLoaderXML::loadFromMemory ("testscene",
+                                                          scene1.str().c_str(),
+                                                          scene1.str().size()) ;
+
+        ASSERT_NE(root.get(), nullptr) ;
+        root->init(ExecParams::defaultInstance()) ;
+
+        for(unsigned int i=0;i<numstep;i++)
+        {
+            sofa::simulation::getSimulation()->animate(root.get(), 0.5);
+        }
+
+        /// Unloading the scene waits for the pending exports.
+        sofa::simulation::getSimulation()->unload(root) ;
+
+        for(auto& pathToCheck : pathes)
+        {
+            EXPECT_TRUE( FileSystem::exists(pathToCheck) ) << "Problem with '" << pathToCheck  << "'";
+        }
+    }
 };
 
 /// run the tests
@@ -175,4 +211,11 @@ TEST_F( STLExporter_test, checkSimulationWriteEachNbStep) {
                                                  tempdir+"/exporterA00003.stl",
                                                  tempdir+"/exporterA00004.stl"}, 20)  ;
 }
+
+TEST_F( STLExporter_test, checkAsynchronousWriteEachNbStep) {
+   this->checkAsynchronousWriteEachNbStep(tempdir, {tempdir+"/exporterB00001.stl",
+                                                   tempdir+"/exporterB00002.stl",
+                                                   tempdir+"/exporterB00003.stl",
+                                                   tempdir+"/exporterB00004.stl"}, 20)  ;
+}
 }
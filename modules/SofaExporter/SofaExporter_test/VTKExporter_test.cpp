@@ -0,0 +1,161 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2019 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include <SofaExporter/config.h>
+
+#include <SofaSimulationGraph/DAGSimulation.h>
+using sofa::simulation::Node ;
+
+#include <SofaSimulationCommon/SceneLoaderXML.h>
+using sofa::simulation::SceneLoaderXML ;
+using sofa::core::ExecParams ;
+
+#include <sofa/helper/system/FileSystem.h>
+using sofa::helper::system::FileSystem ;
+
+#include <SofaTest/Sofa_test.h>
+
+#include <boost/filesystem.hpp>
+
+namespace
+{
+std::string tempdir = boost::filesystem::temp_directory_path().string() ;
+
+std::string readFile(const std::string& filename)
+{
+    std::ifstream file(filename.c_str(), std::ios::in | std::ios::binary);
+    std::stringstream content;
+    content << file.rdbuf();
+    return content.str();
+}
+
+class VTKExporter_test : public sofa::Sofa_test<>
+{
+public:
+    /// remove the file created...
+    std::vector<std::string> dataPath ;
+
+    void TearDown()
+    {
+        for(auto& pathToRemove : dataPath)
+        {
+            if(FileSystem::exists(pathToRemove))
+                FileSystem::removeAll(pathToRemove) ;
+        }
+    }
+
+    /// Export a small tetrahedral mesh with the given extra exporter attributes and
+    /// return the content of the written file.
+    std::string exportMesh(const std::string& filename, const std::string& attributes)
+    {
+        dataPath.push_back(filename) ;
+
+        std::stringstream scene;
+        scene <<
+                "<?xml version='1.0'?> \n"
+                "<Node name='Root' gravity='0 0 0' time='0' animate='0' >   \n"
+                "   <DefaultAnimationLoop/>                                     \n"
+                "   <RegularGridTopology name='grid' n='3 3 3' min='0 0 0' max='1 1 1' /> \n"
+                "   <MechanicalObject name='dofs' template='Vec3d' />          \n"
+                "   <VTKExporter name='exporter' filename='" << filename << "' overwrite='true' exportAtBegin='true' "
+                "               edges='0' hexas='1' pointsDataFields='dofs.position' " << attributes << " /> \n"
+                "</Node>                                                        \n" ;
+
+        Node::SPtr root = SceneLoaderXML::loadFromMemory ("testscene",
+                                                          scene.str().c_str(),
+                                                          scene.str().size()) ;
+
+        EXPECT_NE(root.get(), nullptr) ;
+        if (!root)
+            return "";
+
+        root->init(ExecParams::defaultInstance()) ;
+        sofa::simulation::getSimulation()->animate(root.get(), 0.5);
+
+        /// Unloading the scene waits for the pending exports.
+        sofa::simulation::getSimulation()->unload(root) ;
+
+        EXPECT_TRUE( FileSystem::exists(filename) ) << "Problem with '" << filename << "'" ;
+        return readFile(filename) ;
+    }
+};
+
+TEST_F( VTKExporter_test, checkAsynchronousAsciiIsIdentical)
+{
+    EXPECT_MSG_NOEMIT(Error, Warning) ;
+    const std::string synchronous = exportMesh(tempdir+"/vtkexporter_sync.vtu", "") ;
+    const std::string asynchronous = exportMesh(tempdir+"/vtkexporter_async.vtu", "asynchronous='true'") ;
+
+    ASSERT_FALSE( synchronous.empty() ) ;
+    EXPECT_NE( synchronous.find("<DataArray type=\"Float64\" Name=\"position\""), std::string::npos ) ;
+    EXPECT_EQ( synchronous, asynchronous ) ;
+}
+
+TEST_F( VTKExporter_test, checkAsynchronousLegacyIsIdentical)
+{
+    EXPECT_MSG_NOEMIT(Error, Warning) ;
+    const std::string synchronous = exportMesh(tempdir+"/vtkexporter_sync.vtk", "XMLformat='0'") ;
+    const std::string asynchronous = exportMesh(tempdir+"/vtkexporter_async.vtk", "XMLformat='0' asynchronous='true'") ;
+
+    ASSERT_FALSE( synchronous.empty() ) ;
+    EXPECT_EQ( synchronous, asynchronous ) ;
+}
+
+TEST_F( VTKExporter_test, checkAppendedArrays)
+{
+    EXPECT_MSG_NOEMIT(Error, Warning) ;
+    const std::string content = exportMesh(tempdir+"/vtkexporter_appended.vtu", "xmlArrayFormat='appended'") ;
+
+    EXPECT_NE( content.find("header_type=\"UInt64\""), std::string::npos ) ;
+    EXPECT_NE( content.find("format=\"appended\""), std::string::npos ) ;
+    EXPECT_EQ( content.find("compressor="), std::string::npos ) ;
+
+    const std::size_t begin = content.find("<AppendedData encoding=\"raw\">") ;
+    ASSERT_NE( begin, std::string::npos ) ;
+    const std::size_t underscore = content.find('_', begin) ;
+    ASSERT_NE( underscore, std::string::npos ) ;
+
+    /// The first appended block holds the 27 grid points as Float64 triplets.
+    std::uint64_t size = 0 ;
+    ASSERT_GT( content.size(), underscore + 1 + sizeof(size) ) ;
+    std::memcpy(&size, content.data() + underscore + 1, sizeof(size)) ;
+    EXPECT_EQ( size, 27u * 3u * sizeof(double) ) ;
+}
+
+#if SOFAEXPORTER_HAVE_ZLIB
+TEST_F( VTKExporter_test, checkCompressedAppendedArrays)
+{
+    EXPECT_MSG_NOEMIT(Error, Warning) ;
+    const std::string content = exportMesh(tempdir+"/vtkexporter_compressed.vtu",
+                                           "xmlArrayFormat='appended' compressArrays='true' asynchronous='true'") ;
+
+    EXPECT_NE( content.find("compressor=\"vtkZLibDataCompressor\""), std::string::npos ) ;
+    EXPECT_NE( content.find("<AppendedData encoding=\"raw\">"), std::string::npos ) ;
+}
+#endif // SOFAEXPORTER_HAVE_ZLIB
+
+}
@@ -34,6 +34,7 @@
 #include <SofaBaseMechanics/MechanicalObject.h>
 #include <SofaBaseMechanics/UniformMass.h>
 #include <SofaExporter/WriteState.h>
+#include <SofaGeneralLoader/StateRecordFile.h>
 
 namespace sofa {
 
@@ -77,7 +78,7 @@ namespace sofa {
         }
 
         // Create the scene and the components
-        void createScene(bool symplectic)
+        void createScene(bool symplectic, bool binary=false)
         {
             timeStep = 0.01;
             root->setGravity(Coord(0.0,0.0,gravity));
@@ -127,6 +128,13 @@ namespace sofa {
             }
             writeState->d_writeF.setValue(false);
             writeState->d_time.setValue(time);
+            if(binary)
+            {
+                writeState->d_filename.setValue(std::string(SOFAEXPORTER_BUILD_DIR)+"particleGravityX.sstate");
+                writeState->d_format.beginEdit()->setSelectedItem("binary");
+                writeState->d_format.endEdit();
+                writeState->d_binaryCompression.setValue(true);
+            }
             childNode->addObject(writeState);
 
             EXPECT_TRUE(childNode);
@@ -215,6 +223,34 @@ namespace sofa {
                               std::istreambuf_iterator<char>(f2.rdbuf()));
         }
 
+        /// The binary recording should hold the same frames as the reference text file
+        bool test_binary_export()
+        {
+            using sofa::component::misc::StateRecordFile;
+            using sofa::component::misc::StateRecordReader;
+
+            const std::string referenceFile = std::string(SOFAEXPORTER_BUILD_DIR)+"particleGravityX-reference.sstate";
+            if (!StateRecordFile::convertFromText(std::string(SOFAEXPORTER_TESTFILES_DIR)+"particleGravityX-reference.data", referenceFile))
+                return false;
+
+            StateRecordReader created, reference;
+            if (!created.open(std::string(SOFAEXPORTER_BUILD_DIR)+"particleGravityX.sstate") || !reference.open(referenceFile))
+                return false;
+            EXPECT_EQ(created.getNbFrames(), reference.getNbFrames());
+
+            StateRecordReader::Frame f1, f2;
+            for (size_t i=0; i<created.getNbFrames() && i<reference.getNbFrames(); ++i)
+            {
+                EXPECT_TRUE(created.readFrame(i, f1));
+                EXPECT_TRUE(reference.readFrame(i, f2));
+                EXPECT_NEAR(f1.time, f2.time, 1e-10);
+                EXPECT_TRUE(f1.present[StateRecordFile::POSITION]);
+                EXPECT_EQ(f1.values[StateRecordFile::POSITION].size(), f2.values[StateRecordFile::POSITION].size());
+                for (size_t j=0; j<f1.values[StateRecordFile::POSITION].size() && j<f2.values[StateRecordFile::POSITION].size(); ++j)
+                    EXPECT_NEAR(f1.values[StateRecordFile::POSITION][j], f2.values[StateRecordFile::POSITION][j], 1e-6);
+            }
+            return true;
+        }
 
         /// Unload the scene
         void TearDown()
@@ -256,4 +292,16 @@ namespace sofa {
         ASSERT_TRUE( this->test_export(false) );
         this->TearDown();
     }
+
+    // Test 3 : write position of a particle falling under gravity in the binary format
+    TYPED_TEST( WriteState_test , test_write_binary_position)
+    {
+        this->SetUp();
+        this->createScene(true, true);
+        this->initScene();
+        this->runScene();
+        this->TearDown();
+
+        ASSERT_TRUE( this->test_binary_export() );
+    }
 }
@@ -0,0 +1,117 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2019 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#include <SofaExporter/AsyncExportQueue.h>
+
+namespace sofa
+{
+
+namespace component
+{
+
+namespace misc
+{
+
+AsyncExportQueue::AsyncExportQueue()
+    : m_capacity(2)
+    , m_running(0)
+    , m_stop(false)
+{
+}
+
+AsyncExportQueue::~AsyncExportQueue()
+{
+    wait();
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_jobAvailable.notify_all();
+    if (m_thread.joinable())
+        m_thread.join();
+}
+
+void AsyncExportQueue::setCapacity(unsigned int capacity)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_capacity = capacity > 0 ? capacity : 1;
+}
+
+void AsyncExportQueue::push(const Job& job)
+{
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (!m_thread.joinable())
+            m_thread = std::thread(&AsyncExportQueue::run, this);
+        m_jobDone.wait(lock, [this] { return m_jobs.size() + m_running < m_capacity; });
+        m_jobs.push_back(job);
+    }
+    m_jobAvailable.notify_one();
+}
+
+void AsyncExportQueue::wait()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_jobDone.wait(lock, [this] { return m_jobs.empty() && m_running == 0; });
+}
+
+size_t AsyncExportQueue::getNbPending()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_jobs.size() + m_running;
+}
+
+std::vector<AsyncExportQueue::Result> AsyncExportQueue::takeResults()
+{
+    std::vector<Result> results;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    results.swap(m_results);
+    return results;
+}
+
+void AsyncExportQueue::run()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true)
+    {
+        m_jobAvailable.wait(lock, [this] { return m_stop || !m_jobs.empty(); });
+        if (m_jobs.empty())
+            return;
+
+        Job job = m_jobs.front();
+        m_jobs.pop_front();
+        ++m_running;
+        lock.unlock();
+
+        Result result = job();
+
+        lock.lock();
+        --m_running;
+        m_results.push_back(result);
+        m_jobDone.notify_all();
+    }
+}
+
+} // namespace misc
+
+} // namespace component
+
+} // namespace sofa
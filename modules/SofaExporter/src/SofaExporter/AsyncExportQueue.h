@@ -0,0 +1,103 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2019 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#ifndef SOFA_COMPONENT_MISC_ASYNCEXPORTQUEUE_H
+#define SOFA_COMPONENT_MISC_ASYNCEXPORTQUEUE_H
+#include <SofaExporter/config.h>
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace sofa
+{
+
+namespace component
+{
+
+namespace misc
+{
+
+/** Writes exported files on a background thread.
+ *
+ * Exporters snapshot the Data they need on the simulation thread and push a job
+ * serializing that snapshot. At most `capacity` jobs are in flight (queued or being
+ * written): with the default of 2, one snapshot is written while the next one is
+ * prepared. When the queue is full, push() waits for the worker, which bounds the
+ * memory held by the snapshots when the disk cannot keep up with the simulation.
+ *
+ * The outcome of each job is kept until takeResults() is called, so that messages
+ * are emitted from the simulation thread.
+*/
+class SOFA_SOFAEXPORTER_API AsyncExportQueue
+{
+public:
+    struct Result
+    {
+        bool success;
+        std::string message;
+    };
+    typedef std::function<Result()> Job;
+
+    AsyncExportQueue();
+    /// Wait for the pending jobs and stop the worker thread
+    ~AsyncExportQueue();
+
+    void setCapacity(unsigned int capacity);
+    unsigned int getCapacity() const { return m_capacity; }
+
+    /// Queue a job, waiting while the queue is full. The worker is started on the first call.
+    void push(const Job& job);
+
+    /// Wait until every pushed job has been written
+    void wait();
+
+    /// Number of jobs queued or being written
+    size_t getNbPending();
+
+    /// Results of the jobs completed since the last call
+    std::vector<Result> takeResults();
+
+protected:
+    void run();
+
+    std::thread m_thread;
+    std::mutex m_mutex;
+    std::condition_variable m_jobAvailable;
+    std::condition_variable m_jobDone;
+    std::deque<Job> m_jobs;
+    std::vector<Result> m_results;
+    unsigned int m_capacity;
+    unsigned int m_running;
+    bool m_stop;
+};
+
+} // namespace misc
+
+} // namespace component
+
+} // namespace sofa
+
+#endif
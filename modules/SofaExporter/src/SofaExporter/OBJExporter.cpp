@@ -30,6 +30,7 @@
 
 #include "OBJExporter.h"
 
+#include <memory>
 #include <sstream>
 
 #include <sofa/core/ObjectFactory.h>
@@ -62,6 +63,12 @@ int OBJExporterClass = core::RegisterObject("Export the scene under the Wavefron
         .addAlias("ObjExporter");
 
 
+OBJExporter::OBJExporter()
+    : d_asynchronous( initData(&d_asynchronous, false, "asynchronous", "write the files on a background thread, the scene being exported in memory first"))
+    , d_maxPendingExports( initData(&d_maxPendingExports, (unsigned int)2, "maxPendingExports", "maximum number of exports queued or being written when asynchronous, the simulation waits beyond"))
+{
+}
+
 OBJExporter::~OBJExporter()
 {
 }
@@ -82,12 +89,38 @@ bool OBJExporter::writeOBJ()
 
     if ( !(objfilename.size() > 3 && objfilename.substr(objfilename.size()-4)==".obj"))
         objfilename += ".obj";
-    std::ofstream outfile(objfilename.c_str());
 
     if ( !(mtlfilename.size() > 3 && mtlfilename.substr(objfilename.size()-4)==".obj"))
         mtlfilename += ".mtl";
     else
         mtlfilename = mtlfilename.substr(0, mtlfilename.size()-4) + ".mtl";
+
+    if (d_asynchronous.getValue())
+    {
+        reportExports();
+
+        /// The scene is exported in memory, only the file writes are deferred to the export thread.
+        std::shared_ptr<std::ostringstream> objstream = std::make_shared<std::ostringstream>();
+        std::shared_ptr<std::ostringstream> mtlstream = std::make_shared<std::ostringstream>();
+        ExportOBJVisitor exportOBJ(core::ExecParams::defaultInstance(), objstream.get(), mtlstream.get());
+        getContext()->executeVisitor(&exportOBJ);
+
+        m_exportQueue.setCapacity(d_maxPendingExports.getValue());
+        m_exportQueue.push([objstream, mtlstream, objfilename, mtlfilename]()
+        {
+            std::ofstream outfile(objfilename.c_str());
+            std::ofstream mtlfile(mtlfilename.c_str());
+            if(!outfile.is_open() || !mtlfile.is_open())
+                return misc::AsyncExportQueue::Result { false, "Unable to export OBJ...the file '" + objfilename + "' cannot be opened" };
+
+            outfile << objstream->str();
+            mtlfile << mtlstream->str();
+            return misc::AsyncExportQueue::Result { true, "Exporting OBJ in: " + objfilename + " with MTL in: " + mtlfilename };
+        });
+        return true;
+    }
+
+    std::ofstream outfile(objfilename.c_str());
     std::ofstream mtlfile(mtlfilename.c_str());
 
     if(!outfile.is_open())
@@ -113,6 +146,28 @@ bool OBJExporter::writeOBJ()
 }
 
 
+void OBJExporter::reportExports()
+{
+    for (const misc::AsyncExportQueue::Result& result : m_exportQueue.takeResults())
+    {
+        if (result.success)
+        {
+            msg_info() << result.message;
+        }
+        else
+        {
+            msg_warning() << result.message;
+        }
+    }
+}
+
+void OBJExporter::cleanup()
+{
+    BaseSimulationExporter::cleanup() ;
+    m_exportQueue.wait();
+    reportExports();
+}
+
 void OBJExporter::handleEvent(Event *event)
 {
     if (KeypressedEvent::checkEventType(event))
@@ -34,6 +34,7 @@
 #include <SofaExporter/config.h>
 
 #include <sofa/simulation/BaseSimulationExporter.h>
+#include <SofaExporter/AsyncExportQueue.h>
 
 #include <fstream>
 
@@ -55,13 +56,22 @@ class SOFA_SOFAEXPORTER_API OBJExporter : public BaseSimulationExporter
 public:
     SOFA_CLASS(OBJExporter, BaseSimulationExporter);
 
+    Data<bool>         d_asynchronous; ///< write the files on a background thread
+    Data<unsigned int> d_maxPendingExports; ///< maximum number of exports queued or being written
+
     bool write() override ;
     bool writeOBJ();
 
     void handleEvent(Event *event) override ;
+    void cleanup() override ;
 
 protected:
+    OBJExporter();
     ~OBJExporter() override;
+
+    void reportExports();
+
+    sofa::component::misc::AsyncExportQueue m_exportQueue;
 };
 
 }
@@ -27,6 +27,8 @@
 #include <string>
 #include <cstdlib>
 #include <cstdio>
+#include <cstring>
+#include <memory>
 
 #include <sofa/core/ObjectFactory.h>
 
@@ -66,6 +68,8 @@ STLExporter::STLExporter()
     , d_position( initData(&d_position, "position", "points coordinates"))
     , d_triangle( initData(&d_triangle, "triangle", "triangles indices"))
     , d_quad( initData(&d_quad, "quad", "quads indices"))
+    , d_asynchronous( initData(&d_asynchronous, false, "asynchronous", "snapshot the exported mesh and write the files on a background thread"))
+    , d_maxPendingExports( initData(&d_maxPendingExports, (unsigned int)2, "maxPendingExports", "maximum number of exports queued or being written when asynchronous, the simulation waits beyond"))
 {
     this->addAlias(&d_triangle, "triangles");
     this->addAlias(&d_quad, "quads");
@@ -128,41 +132,27 @@ bool STLExporter::write()
     return writeSTLBinary();
 }
 
-bool STLExporter::writeSTL(bool autonumbering)
+bool STLExporter::takeSnapshot(Snapshot& snapshot, bool autonumbering)
 {
-    if(m_componentstate != ComponentState::Valid)
-        return false ;
-
-    std::string filename = getOrCreateTargetPath(d_filename.getValue(), d_exportEveryNbSteps.getValue() && autonumbering) ;
-    filename += ".stl";
-
-    std::ofstream outfile(filename.c_str());
-    if( !outfile.is_open() )
-    {
-        msg_error() << "Unable to open file '" << filename << "'";
-        return false;
-    }
-
     helper::ReadAccessor< Data< helper::vector< BaseMeshTopology::Triangle > > > triangleIndices = d_triangle;
     helper::ReadAccessor< Data< helper::vector< BaseMeshTopology::Quad > > > quadIndices = d_quad;
     helper::ReadAccessor<Data<defaulttype::Vec3Types::VecCoord> > positionIndices = d_position;
 
-    helper::vector< BaseMeshTopology::Triangle > vecTri;
-
     if(positionIndices.empty())
     {
         msg_error() << "No positions in topology." ;
         return false ;
     }
+
+    helper::vector< BaseMeshTopology::Triangle >& vecTri = snapshot.triangles;
+    vecTri.clear();
     if(!triangleIndices.empty())
     {
-        for(unsigned int i=0;i<triangleIndices.size();i++)
-        {
-            vecTri.push_back(triangleIndices[i]);
-        }
+        vecTri.assign(triangleIndices.begin(), triangleIndices.end());
     }
     else if(!quadIndices.empty())
     {
+        vecTri.reserve(2*quadIndices.size());
         BaseMeshTopology::Triangle tri;
         for(unsigned int i=0;i<quadIndices.size();i++)
         {
@@ -183,12 +173,91 @@ bool STLExporter::writeSTL(bool autonumbering)
         return false;
     }
 
+    snapshot.position = positionIndices.ref();
+    snapshot.filename = getOrCreateTargetPath(d_filename.getValue(), d_exportEveryNbSteps.getValue() && autonumbering) ;
+    snapshot.filename += ".stl";
+    return true;
+}
+
+bool STLExporter::exportSnapshot(bool binary, bool autonumbering)
+{
+    if(m_componentstate != ComponentState::Valid)
+        return false ;
+
+    reportExports();
+
+    std::shared_ptr<Snapshot> snapshot = std::make_shared<Snapshot>();
+    if (!takeSnapshot(*snapshot, autonumbering))
+        return false;
+
+    if (d_asynchronous.getValue())
+    {
+        m_exportQueue.setCapacity(d_maxPendingExports.getValue());
+        m_exportQueue.push([snapshot, binary]()
+        {
+            return binary ? writeSTLBinary(*snapshot) : writeSTLAscii(*snapshot);
+        });
+        return true;
+    }
+
+    const misc::AsyncExportQueue::Result result = binary ? writeSTLBinary(*snapshot) : writeSTLAscii(*snapshot);
+    if (result.success)
+    {
+        msg_info() << result.message;
+    }
+    else
+    {
+        msg_error() << result.message;
+    }
+    return result.success;
+}
+
+void STLExporter::reportExports()
+{
+    for (const misc::AsyncExportQueue::Result& result : m_exportQueue.takeResults())
+    {
+        if (result.success)
+        {
+            msg_info() << result.message;
+        }
+        else
+        {
+            msg_error() << result.message;
+        }
+    }
+}
+
+void STLExporter::cleanup()
+{
+    BaseSimulationExporter::cleanup() ;
+    m_exportQueue.wait();
+    reportExports();
+}
+
+bool STLExporter::writeSTL(bool autonumbering)
+{
+    return exportSnapshot(false, autonumbering);
+}
+
+bool STLExporter::writeSTLBinary(bool autonumbering)
+{
+    return exportSnapshot(true, autonumbering);
+}
+
+misc::AsyncExportQueue::Result STLExporter::writeSTLAscii(const Snapshot& snapshot)
+{
+    std::ofstream outfile(snapshot.filename.c_str());
+    if( !outfile.is_open() )
+    {
+        return { false, "Unable to open file '" + snapshot.filename + "'" };
+    }
+
+    const helper::vector< BaseMeshTopology::Triangle >& vecTri = snapshot.triangles;
+    const defaulttype::Vec3Types::VecCoord& positionIndices = snapshot.position;
+
     /* Get number of facets */
     const int nbt = vecTri.size();
 
-    // Sets the floatfield format flag for the str stream to fixed
-    std::cout.precision(6);
-
     /* solid */
     outfile << "solid Exported from Sofa" << std::endl;
 
@@ -212,71 +281,22 @@ bool STLExporter::writeSTL(bool autonumbering)
 
     outfile.close();
 
-    msg_info() << "File '" << filename << "' written" ;
-    return true ;
+    return { true, "File '" + snapshot.filename + "' written" };
 }
 
-bool STLExporter::writeSTLBinary(bool autonumbering)
+misc::AsyncExportQueue::Result STLExporter::writeSTLBinary(const Snapshot& snapshot)
 {
-    if(m_componentstate != ComponentState::Valid)
-        return false ;
-
-    std::string filename = getOrCreateTargetPath(d_filename.getValue(),
-                                                 d_exportEveryNbSteps.getValue() && autonumbering) ;
-    filename += ".stl";
-
-    std::ofstream outfile(filename.c_str(), std::ios::out | std::ios::binary);
+    std::ofstream outfile(snapshot.filename.c_str(), std::ios::out | std::ios::binary);
     if( !outfile.is_open() )
     {
-        msg_error() << "Unable to open file '" << filename << "'";
-        return false;
-    }
-
-    helper::ReadAccessor< Data< helper::vector< BaseMeshTopology::Triangle > > > triangleIndices = d_triangle;
-    helper::ReadAccessor< Data< helper::vector< BaseMeshTopology::Quad > > > quadIndices = d_quad;
-    helper::ReadAccessor< Data< defaulttype::Vec3Types::VecCoord> > positionIndices = d_position;
-
-    helper::vector< BaseMeshTopology::Triangle > vecTri;
-
-    if(positionIndices.empty())
-    {
-        msg_error() << "No positions in topology." ;
-        return false;
-    }
-    if(!triangleIndices.empty())
-    {
-        for(unsigned int i=0;i<triangleIndices.size();i++)
-        {
-            vecTri.push_back(triangleIndices[i]);
-        }
-    }
-    else if(!quadIndices.empty())
-    {
-        BaseMeshTopology::Triangle tri;
-        for(unsigned int i=0;i<quadIndices.size();i++)
-        {
-            for(int j=0;j<3;j++)
-            {
-                tri[j] = quadIndices[i][j];
-            }
-            vecTri.push_back(tri);
-            tri[0] = quadIndices[i][0];
-            tri[1] = quadIndices[i][2];
-            tri[2] = quadIndices[i][3];
-            vecTri.push_back(tri);
-        }
-    }
-    else
-    {
-        msg_error() << "No triangles nor quads in topology.";
-        return false;
+        return { false, "Unable to open file '" + snapshot.filename + "'" };
     }
 
-    // Sets the floatfield format flag for the str stream to fixed
-    std::cout.precision(6);
+    const helper::vector< BaseMeshTopology::Triangle >& vecTri = snapshot.triangles;
+    const defaulttype::Vec3Types::VecCoord& positionIndices = snapshot.position;
 
     /* Creating header file */
-    char* buffer = new char [80];
+    char buffer[80];
     // Cleaning buffer
     for(int i=0;i<80;i++)
     {
@@ -289,35 +309,27 @@ bool STLExporter::writeSTLBinary(bool autonumbering)
     const unsigned int nbt = vecTri.size();
     outfile.write((char*)&nbt,4);
 
-    // Parsing facets
-    for(unsigned long i=0;i<nbt;i++)
+    // Parsing facets, 50 bytes each
+    std::vector<char> facets(50*(size_t)nbt, 0);
+    char* facet = facets.data();
+    for(unsigned long i=0;i<nbt;i++, facet += 50)
     {
-        /* normal */
-        float nul = 0.; // normals are set to 0
-        outfile.write((char*)&nul, 4);
-        outfile.write((char*)&nul, 4);
-        outfile.write((char*)&nul, 4);
+        /* normals are set to 0, vertices follow */
         for (int j=0;j<3;j++)
         {
-            /* vertices */
-            float iOne = (float)positionIndices[ vecTri[i][j] ][0];
-            float iTwo = (float)positionIndices[ vecTri[i][j] ][1];
-            float iThree = (float)positionIndices[ vecTri[i][j] ][2];
-            outfile.write( (char*)&iOne, 4);
-            outfile.write( (char*)&iTwo, 4);
-            outfile.write( (char*)&iThree, 4);
+            const float vertex[3] = { (float)positionIndices[ vecTri[i][j] ][0],
+                                      (float)positionIndices[ vecTri[i][j] ][1],
+                                      (float)positionIndices[ vecTri[i][j] ][2] };
+            memcpy(facet + 12 + 12*j, vertex, 12);
         }
 
         /* Attribute byte count */
-        // attribute count is currently not used, it's garbage
-        unsigned int zero = 0;
-        outfile.write((char*)&zero, 2);
+        // attribute count is currently not used, left to zero
     }
+    outfile.write(facets.data(), facets.size());
 
     outfile.close();
-    msg_info() << "File '" << filename << "' written" ;
-    delete[] buffer;
-    return true;
+    return { true, "File '" + snapshot.filename + "' written" };
 }
 
 void STLExporter::handleEvent(Event *event)
@@ -29,6 +29,7 @@
 #include <sofa/core/topology/BaseMeshTopology.h>
 
 #include <sofa/simulation/BaseSimulationExporter.h>
+#include <SofaExporter/AsyncExportQueue.h>
 
 ///////////////////////////// FORWARD DECLARATION //////////////////////////////////////////////////
 namespace sofa {
@@ -70,6 +71,8 @@ public:
     Data<defaulttype::Vec3Types::VecCoord>               d_position; ///< points coordinates
     Data< helper::vector< BaseMeshTopology::Triangle > > d_triangle; ///< triangles indices
     Data< helper::vector< BaseMeshTopology::Quad > >     d_quad; ///< quads indices
+    Data<bool>                                           d_asynchronous; ///< write the files on a background thread
+    Data<unsigned int>                                   d_maxPendingExports; ///< maximum number of exports queued or being written
 
     void doInit() override ;
     void doReInit() override ;
@@ -80,11 +83,29 @@ public:
     bool writeSTL(bool autonumbering=true);
     bool writeSTLBinary(bool autonumbering=true);
 
+    void cleanup() override ;
+
+    /// Copy of the exported mesh, written on the export thread when asynchronous is set
+    struct Snapshot
+    {
+        std::string filename;
+        defaulttype::Vec3Types::VecCoord position;
+        helper::vector< BaseMeshTopology::Triangle > triangles;
+    };
+
+    static misc::AsyncExportQueue::Result writeSTLAscii(const Snapshot& snapshot);
+    static misc::AsyncExportQueue::Result writeSTLBinary(const Snapshot& snapshot);
+
 protected:
     STLExporter();
     ~STLExporter() override;
 
 private:
+    bool takeSnapshot(Snapshot& snapshot, bool autonumbering);
+    bool exportSnapshot(bool binary, bool autonumbering);
+    void reportExports();
+
+    misc::AsyncExportQueue m_exportQueue;
     BaseMeshTopology*    m_inputtopology {nullptr};
     BaseMechanicalState* m_inputmstate   {nullptr};
     VisualModel*         m_inputvmodel   {nullptr};
@@ -28,6 +28,8 @@
 
 #include "VTKExporter.h"
 
+#include <cstring>
+#include <memory>
 #include <sstream>
 
 #include <sofa/core/ObjectFactory.h>
@@ -39,6 +41,10 @@
 #include <sofa/core/objectmodel/KeyreleasedEvent.h>
 #include <sofa/helper/logging/Messaging.h>
 
+#if SOFAEXPORTER_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
 namespace sofa
 {
 
@@ -67,6 +73,10 @@ VTKExporter::VTKExporter()
     , exportAtBegin( initData(&exportAtBegin, false, "exportAtBegin", "export file at the initialization"))
     , exportAtEnd( initData(&exportAtEnd, false, "exportAtEnd", "export file when the simulation is finished"))
     , overwrite( initData(&overwrite, false, "overwrite", "overwrite the file, otherwise create a new file at each export, with suffix in the filename"))
+    , d_xmlArrayFormat( initData(&d_xmlArrayFormat, helper::OptionsGroup(2,"ascii","appended"), "xmlArrayFormat", "format of the XML data arrays: ascii, or raw binary in an appended section"))
+    , d_compressArrays( initData(&d_compressArrays, false, "compressArrays", "compress the appended arrays with zlib"))
+    , d_asynchronous( initData(&d_asynchronous, false, "asynchronous", "snapshot the exported Data and write the files on a background thread"))
+    , d_maxPendingExports( initData(&d_maxPendingExports, (unsigned int)2, "maxPendingExports", "maximum number of exports queued or being written when asynchronous, the simulation waits beyond"))
 {
 }
 
@@ -145,89 +155,235 @@ void VTKExporter::fetchDataFields(const helper::vector<std::string>& strData, he
     }
 }
 
-void VTKExporter::writeData(const helper::vector<std::string>& objects, const helper::vector<std::string>& fields, const helper::vector<std::string>& names)
+namespace
 {
-    sofa::core::objectmodel::BaseContext* context = this->getContext();
 
-    for (unsigned int i=0 ; i<objects.size() ; i++)
+typedef VTKExporter::Snapshot Snapshot;
+
+template<class TValue, class TScalar>
+bool copyDataValues(core::objectmodel::BaseData* field, Snapshot::DataArray& array, Snapshot::ScalarType type, unsigned int vecSize)
+{
+    const core::objectmodel::TData< helper::vector<TValue> >* data = dynamic_cast<const core::objectmodel::TData< helper::vector<TValue> >* >(field);
+    if (!data)
+        return false;
+
+    const helper::vector<TValue>& values = data->virtualGetValue();
+    array.type = type;
+    array.vecSize = vecSize;
+    array.nbValues = values.size() * (sizeof(TValue) / sizeof(TScalar));
+    array.values.resize(values.size() * sizeof(TValue));
+    if (!values.empty())
+        std::memcpy(array.values.data(), values.data(), array.values.size());
+    return true;
+}
+
+const char* getXMLTypeName(Snapshot::ScalarType type)
+{
+    switch (type)
     {
-        core::objectmodel::BaseObject* obj = context->get<core::objectmodel::BaseObject> (objects[i]);
-        core::objectmodel::BaseData* field = nullptr;
-        if (obj)
+    case Snapshot::INT32: return "Int32";
+    case Snapshot::UINT32: return "UInt32";
+    case Snapshot::FLOAT32: return "Float32";
+    case Snapshot::FLOAT64: return "Float64";
+    default: return "";
+    }
+}
+
+/// Number of components written in the XML format, 0 for unsupported types
+unsigned int getXMLComponents(const Snapshot::DataArray& array)
+{
+    if (array.type == Snapshot::OTHER)
+        return 0;
+    return array.vecSize ? array.vecSize : 1;
+}
+
+std::string segmentString(std::string str, unsigned int n)
+{
+    std::string::size_type loc = 0;
+    unsigned int i=0;
+
+    loc = str.find(' ', 0);
+
+    while(loc != std::string::npos )
+    {
+        i++;
+        if (i == n)
         {
-            field = obj->findData(fields[i]);
+            str[loc] = '\n';
+            i=0;
         }
+        loc = str.find(' ', loc+1);
+    }
 
-        if (!obj || !field)
+    return str;
+}
+
+template<class T>
+void writeAsciiValues(std::ostream& out, const char* bytes, size_t nbValues, unsigned int n)
+{
+    for (size_t i=0; i<nbValues; ++i)
+    {
+        T value;
+        std::memcpy(&value, bytes + i*sizeof(T), sizeof(T));
+        out << value;
+        if (i+1 < nbValues)
+            out << ((n && (i+1)%n == 0) ? '\n' : ' ');
+    }
+}
+
+/// Same layout as the value string of the Data with a line break every n values
+void writeAsciiValues(std::ostream& out, const Snapshot::DataArray& array, unsigned int n)
+{
+    switch (array.type)
+    {
+    case Snapshot::INT32: writeAsciiValues<int>(out, array.values.data(), array.nbValues, n); break;
+    case Snapshot::UINT32: writeAsciiValues<unsigned int>(out, array.values.data(), array.nbValues, n); break;
+    case Snapshot::FLOAT32: writeAsciiValues<float>(out, array.values.data(), array.nbValues, n); break;
+    case Snapshot::FLOAT64: writeAsciiValues<double>(out, array.values.data(), array.nbValues, n); break;
+    default: out << segmentString(array.valueString, n); break;
+    }
+}
+
+template<class T>
+void appendValue(std::vector<char>& buffer, const T& value)
+{
+    const char* p = reinterpret_cast<const char*>(&value);
+    buffer.insert(buffer.end(), p, p+sizeof(T));
+}
+
+/// Append an array to the raw appended section, with the UInt64 headers of the VTK XML format.
+/// Compressed arrays are split in blocks deflated independently, as vtkZLibDataCompressor does.
+void appendArray(std::vector<char>& appended, const void* data, size_t size, bool compressed)
+{
+    const char* bytes = static_cast<const char*>(data);
+#if SOFAEXPORTER_HAVE_ZLIB
+    if (compressed)
+    {
+        const size_t blockSize = 1 << 16;
+        const size_t nbBlocks = (size + blockSize - 1) / blockSize;
+        std::vector< std::vector<char> > blocks(nbBlocks);
+        for (size_t b=0; b<nbBlocks; ++b)
         {
-            if (!obj)
-                msg_error() << "VTKExporter : error while fetching data field '" << msgendl
-                            << fields[i] << "' of object '" << objects[i] << msgendl
-                            << "', check object name"  << msgendl;
-            else if (!field)
-                msg_error() << "VTKExporter : error while fetching data field " << msgendl
-                            << fields[i] << " of object '" << objects[i] << msgendl
-                            << "', check field name " << msgendl;
+            const size_t rawSize = std::min(blockSize, size - b*blockSize);
+            uLongf compressedSize = compressBound((uLong)rawSize);
+            blocks[b].resize(compressedSize);
+            compress2(reinterpret_cast<Bytef*>(blocks[b].data()), &compressedSize,
+                      reinterpret_cast<const Bytef*>(bytes + b*blockSize), (uLong)rawSize, Z_BEST_SPEED);
+            blocks[b].resize(compressedSize);
         }
-        else
+        appendValue(appended, (uint64_t)nbBlocks);
+        appendValue(appended, (uint64_t)blockSize);
+        appendValue(appended, (uint64_t)(size % blockSize));
+        for (size_t b=0; b<nbBlocks; ++b)
+            appendValue(appended, (uint64_t)blocks[b].size());
+        for (size_t b=0; b<nbBlocks; ++b)
+            appended.insert(appended.end(), blocks[b].begin(), blocks[b].end());
+        return;
+    }
+#else
+    SOFA_UNUSED(compressed);
+#endif
+    appendValue(appended, (uint64_t)size);
+    appended.insert(appended.end(), bytes, bytes+size);
+}
+
+void writeLegacyData(std::ostream& out, const std::vector<Snapshot::DataArray>& arrays)
+{
+    for (const Snapshot::DataArray& array : arrays)
+    {
+        //Scalars
+        std::string line;
+        unsigned int sizeSeg=0;
+        if (array.vecSize == 0 && array.type == Snapshot::FLOAT32)
         {
-            //Scalars
-            std::string line;
-            unsigned int sizeSeg=0;
-            if (dynamic_cast<sofa::core::objectmodel::TData< helper::vector<float> >* >(field))
-            {
-                line = "float 1";
-                sizeSeg = 1;
-            }
-            if (dynamic_cast<sofa::core::objectmodel::TData<helper::vector<double> >* >(field))
-            {
-                line = "double 1";
-                sizeSeg = 1;
-            }
-            if (dynamic_cast<sofa::core::objectmodel::TData<helper::vector< defaulttype::Vec2f > >* > (field))
-            {
-                line = "float 2";
-                sizeSeg = 2;
-            }
-            if (dynamic_cast<sofa::core::objectmodel::TData<helper::vector< defaulttype::Vec2d > >* >(field))
-            {
-                line = "double 2";
-                sizeSeg = 2;
-            }
+            line = "float 1";
+            sizeSeg = 1;
+        }
+        if (array.vecSize == 0 && array.type == Snapshot::FLOAT64)
+        {
+            line = "double 1";
+            sizeSeg = 1;
+        }
+        if (array.vecSize == 2 && array.type == Snapshot::FLOAT32)
+        {
+            line = "float 2";
+            sizeSeg = 2;
+        }
+        if (array.vecSize == 2 && array.type == Snapshot::FLOAT64)
+        {
+            line = "double 2";
+            sizeSeg = 2;
+        }
 
-            //if this is a scalar
-            if (!line.empty())
+        //if this is a scalar
+        if (!line.empty())
+        {
+            out << "SCALARS" << " " << array.name << " ";
+            out << line << std::endl;
+            out << "LOOKUP_TABLE default" << std::endl;
+        }
+        else
+        {
+            //Vectors
+            if (array.vecSize == 3 && array.type == Snapshot::FLOAT32)
             {
-                *outfile << "SCALARS" << " " << names[i] << " ";
-                *outfile << line << std::endl;
-                *outfile << "LOOKUP_TABLE default" << std::endl;
+                line = "float";
+                sizeSeg = 3;
             }
-            else
+            if (array.vecSize == 3 && array.type == Snapshot::FLOAT64)
             {
-                //Vectors
-                if (dynamic_cast<sofa::core::objectmodel::TData<helper::vector< defaulttype::Vec3f > >* > (field))
-                {
-                    line = "float";
-                    sizeSeg = 3;
-                }
-                if (dynamic_cast<sofa::core::objectmodel::TData<helper::vector< defaulttype::Vec3d > >* >(field))
-                {
-                    line = "double";
-                    sizeSeg = 3;
-                }
-                *outfile << "VECTORS" << " " << names[i] << " ";
-                *outfile << line << std::endl;
+                line = "double";
+                sizeSeg = 3;
             }
+            out << "VECTORS" << " " << array.name << " ";
+            out << line << std::endl;
+        }
 
-            *outfile << segmentString(field->getValueString(),sizeSeg) << std::endl;
-            *outfile << std::endl;
-
+        writeAsciiValues(out, array, sizeSeg);
+        out << std::endl;
+        out << std::endl;
+    }
+}
 
+void writeXMLDataArrays(std::ostream& out, const std::vector<Snapshot::DataArray>& arrays, std::vector<char>* appended, bool compressed)
+{
+    for (const Snapshot::DataArray& array : arrays)
+    {
+        const unsigned int sizeSeg = getXMLComponents(array);
+        out << "        <DataArray type=\""<< getXMLTypeName(array.type) << "\" Name=\"" << array.name;
+        if(sizeSeg > 1)
+            out << "\" NumberOfComponents=\"" << sizeSeg;
+        if (appended && array.type != Snapshot::OTHER)
+        {
+            out << "\" format=\"appended\" offset=\"" << appended->size() << "\"/>" << std::endl;
+            appendArray(*appended, array.values.data(), array.values.size(), compressed);
+        }
+        else
+        {
+            out << "\" format=\"ascii\">" << std::endl;
+            writeAsciiValues(out, array, sizeSeg);
+            out << std::endl;
+            out << "        </DataArray>" << std::endl;
         }
     }
 }
 
-void VTKExporter::writeDataArray(const helper::vector<std::string>& objects, const helper::vector<std::string>& fields, const helper::vector<std::string>& names)
+template<class TElement>
+void appendConnectivity(std::vector<int32_t>& connectivity, std::vector<int32_t>& offsets, std::vector<uint8_t>& types,
+                        const helper::vector<TElement>& elements, uint8_t type)
+{
+    for (const TElement& e : elements)
+    {
+        for (unsigned int j=0; j<TElement::static_size; ++j)
+            connectivity.push_back((int32_t)e[j]);
+        offsets.push_back((int32_t)connectivity.size());
+        types.push_back(type);
+    }
+}
+
+} // anonymous namespace
+
+void VTKExporter::snapshotData(const helper::vector<std::string>& objects, const helper::vector<std::string>& fields, const helper::vector<std::string>& names, std::vector<Snapshot::DataArray>& arrays)
 {
     sofa::core::objectmodel::BaseContext* context = this->getContext();
 
@@ -245,115 +401,69 @@ void VTKExporter::writeDataArray(const helper::vector<std::string>& objects, con
             if (!obj)
                 msg_error() << "VTKExporter : error while fetching data field '" << msgendl
                             << fields[i] << "' of object '" << objects[i] << msgendl
-                            << "', check object name" << msgendl;
+                            << "', check object name"  << msgendl;
             else if (!field)
-                msg_error()  << "VTKExporter : error while fetching data field " << msgendl
-                             << fields[i] << " of object '" << objects[i] << msgendl
-                             << "', check field name " << msgendl;
+                msg_error() << "VTKExporter : error while fetching data field " << msgendl
+                            << fields[i] << " of object '" << objects[i] << msgendl
+                            << "', check field name " << msgendl;
+            continue;
         }
-        else
-        {
-            //Scalars
-            std::string type;
-            unsigned int sizeSeg=0;
-            if (dynamic_cast<sofa::core::objectmodel::TData< helper::vector<int> >* >(field))
-            {
-                type = "Int32";
-                sizeSeg = 1;
-            }
-            if (dynamic_cast<sofa::core::objectmodel::TData< helper::vector<unsigned int> >* >(field))
-            {
-                type = "UInt32";
-                sizeSeg = 1;
-            }
-            if (dynamic_cast<sofa::core::objectmodel::TData< helper::vector<float> >* >(field))
-            {
-                type = "Float32";
-                sizeSeg = 1;
-            }
-            if (dynamic_cast<sofa::core::objectmodel::TData<helper::vector<double> >* >(field))
-            {
-                type = "Float64";
-                sizeSeg = 1;
-            }
-
-            //Vectors
-            if (type.empty())
-            {
-                if (dynamic_cast<sofa::core::objectmodel::TData<helper::vector< defaulttype::Vec1f> >* >(field))
-                {
-                    type = "Float32";
-                    sizeSeg = 1;
-                }
-                if (dynamic_cast<sofa::core::objectmodel::TData<helper::vector< defaulttype::Vec1d> >* >(field))
-                {
-                    type = "Float64";
-                    sizeSeg = 1;
-                }
-
-                if (dynamic_cast<sofa::core::objectmodel::TData<helper::vector< defaulttype::Vec2f> >* >(field))
-                {
-                    type = "Float32";
-                    sizeSeg = 2;
-                }
-                if (dynamic_cast<sofa::core::objectmodel::TData<helper::vector< defaulttype::Vec2d> >* >(field))
-                {
-                    type = "Float64";
-                    sizeSeg = 2;
-                }
 
-                if (dynamic_cast<sofa::core::objectmodel::TData<helper::vector< defaulttype::Vec3f > >* > (field))
-                {
-                    type = "Float32";
-                    sizeSeg = 3;
-                }
-                if (dynamic_cast<sofa::core::objectmodel::TData<helper::vector< defaulttype::Vec3d > >* >(field))
-                {
-                    type = "Float64";
-                    sizeSeg = 3;
-                }
-            }
-            *outfile << "        <DataArray type=\""<< type << "\" Name=\"" << names[i];
-            if(sizeSeg > 1)
-                *outfile << "\" NumberOfComponents=\"" << sizeSeg;
-            *outfile << "\" format=\"ascii\">" << std::endl;
-            *outfile << segmentString(field->getValueString(),sizeSeg) << std::endl;
-            *outfile << "        </DataArray>" << std::endl;
+        arrays.push_back(Snapshot::DataArray());
+        Snapshot::DataArray& array = arrays.back();
+        array.name = names[i];
+        if (!copyDataValues<int, int>(field, array, Snapshot::INT32, 0)
+                && !copyDataValues<unsigned int, unsigned int>(field, array, Snapshot::UINT32, 0)
+                && !copyDataValues<float, float>(field, array, Snapshot::FLOAT32, 0)
+                && !copyDataValues<double, double>(field, array, Snapshot::FLOAT64, 0)
+                && !copyDataValues<defaulttype::Vec1f, float>(field, array, Snapshot::FLOAT32, 1)
+                && !copyDataValues<defaulttype::Vec1d, double>(field, array, Snapshot::FLOAT64, 1)
+                && !copyDataValues<defaulttype::Vec2f, float>(field, array, Snapshot::FLOAT32, 2)
+                && !copyDataValues<defaulttype::Vec2d, double>(field, array, Snapshot::FLOAT64, 2)
+                && !copyDataValues<defaulttype::Vec3f, float>(field, array, Snapshot::FLOAT32, 3)
+                && !copyDataValues<defaulttype::Vec3d, double>(field, array, Snapshot::FLOAT64, 3))
+        {
+            array.type = Snapshot::OTHER;
+            array.vecSize = 0;
+            array.nbValues = 0;
+            array.valueString = field->getValueString();
         }
     }
 }
 
-
-std::string VTKExporter::segmentString(std::string str, unsigned int n)
+void VTKExporter::takeSnapshot(Snapshot& snapshot)
 {
-    std::string::size_type loc = 0;
-    unsigned int i=0;
-
-    loc = str.find(' ', 0);
+    snapshot.xml = fileFormat.getValue();
+    snapshot.appended = snapshot.xml && d_xmlArrayFormat.getValue().getSelectedId() == 1;
+#if SOFAEXPORTER_HAVE_ZLIB
+    snapshot.compressed = snapshot.appended && d_compressArrays.getValue();
+#else
+    snapshot.compressed = false;
+#endif
 
-    while(loc != std::string::npos )
+    std::string filename = vtkFilename.getFullPath();
+    if (snapshot.xml)
     {
-        i++;
-        if (i == n)
+        std::ostringstream oss;
+        oss << nbFiles;
+
+        if ( filename.size() > 3 && filename.substr(filename.size()-4)==".vtu")
         {
-            str[loc] = '\n';
-            i=0;
+            if (!overwrite.getValue())
+                filename = filename.substr(0,filename.size()-4) + oss.str() + ".vtu";
+        }
+        else
+        {
+            if (!overwrite.getValue())
+                filename += oss.str();
+            filename += ".vtu";
         }
-        loc = str.find(' ', loc+1);
     }
+    else if (filename.size() > 3)
+    {
+        std::ostringstream oss;
+        oss << "_" << nbFiles;
 
-    return str;
-}
-
-
-void VTKExporter::writeVTKSimple()
-{
-    std::string filename = vtkFilename.getFullPath();
-
-    std::ostringstream oss;
-    oss << "_" << nbFiles;
-
-    if (filename.size() > 3) {
         std::string ext;
         std::string baseName;
         if (filename.substr(filename.size()-4)==".vtu") {
@@ -376,392 +486,379 @@ void VTKExporter::writeVTKSimple()
             filename = baseName + ext;
         else
             filename = baseName + oss.str() + ext;
-
-    }
-
-    /*if ( filename.size() > 3 && filename.substr(filename.size()-4)==".vtu")
-    {
-        if (!overwrite.getValue())
-            filename = filename.substr(0,filename.size()-4) + oss.str() + ".vtu";
-    }
-    else
-    {
-        if (!overwrite.getValue())
-            filename += oss.str();
-        filename += ".vtu";
-    }*/
-
-    outfile = new std::ofstream(filename.c_str());
-    if( !outfile->is_open() )
-    {
-        msg_error() << "Error creating file "<<filename;
-        delete outfile;
-        outfile = nullptr;
-        return;
     }
-
-    const helper::vector<std::string>& pointsData = dPointsDataFields.getValue();
-    const helper::vector<std::string>& cellsData = dCellsDataFields.getValue();
+    snapshot.filename = filename;
+    ++nbFiles;
 
     helper::ReadAccessor<Data<defaulttype::Vec3Types::VecCoord> > pointsPos = position;
-
     const size_t nbp = (!pointsPos.empty()) ? pointsPos.size() : topology->getNbPoints();
-
-    //Write header
-    *outfile << "# vtk DataFile Version 2.0" << std::endl;
-
-    //write Title
-    *outfile << "Exported VTK file" << std::endl;
-
-    //write Data type
-    *outfile << "ASCII" << std::endl;
-
-    *outfile << std::endl;
-
-    //write dataset (geometry, unstructured grid)
-    *outfile << "DATASET " << "UNSTRUCTURED_GRID" << std::endl;
-
-    *outfile << "POINTS " << nbp << " float" << std::endl;
-    //write Points
+    snapshot.pointsFromPositionData = !pointsPos.empty();
+    snapshot.points.resize(nbp);
     if (!pointsPos.empty())
     {
         for (size_t i=0 ; i<nbp; i++)
-        {
-            *outfile << pointsPos[i] << std::endl;
-        }
+            snapshot.points[i] = pointsPos[i];
     }
     else if (mstate && mstate->getSize() == (size_t)nbp)
     {
-        for (size_t i=0 ; i<mstate->getSize() ; i++)
-        {
-            *outfile << mstate->getPX(i) << " " << mstate->getPY(i) << " " << mstate->getPZ(i) << std::endl;
-        }
+        for (size_t i=0 ; i<nbp; i++)
+            snapshot.points[i] = defaulttype::Vec3d(mstate->getPX(i), mstate->getPY(i), mstate->getPZ(i));
     }
     else
     {
-        for (size_t i=0 ; i<nbp ; i++)
-        {
-            *outfile << topology->getPX(i) << " " << topology->getPY(i) << " " << topology->getPZ(i) << std::endl;
-        }
+        for (size_t i=0 ; i<nbp; i++)
+            snapshot.points[i] = defaulttype::Vec3d(topology->getPX(i), topology->getPY(i), topology->getPZ(i));
     }
 
-    *outfile << std::endl;
-
-    //Write Cells
-    size_t numberOfCells, totalSize;
-    numberOfCells = ( (writeEdges.getValue()) ? topology->getNbEdges() : 0 )
-            +( (writeTriangles.getValue()) ? topology->getNbTriangles() : 0 )
-            +( (writeQuads.getValue()) ? topology->getNbQuads() : 0 )
-            +( (writeTetras.getValue()) ? topology->getNbTetras() : 0 )
-            +( (writeHexas.getValue()) ? topology->getNbHexas() : 0 );
-    totalSize =     ( (writeEdges.getValue()) ? 3 * topology->getNbEdges() : 0 )
-            +( (writeTriangles.getValue()) ? 4 *topology->getNbTriangles() : 0 )
-            +( (writeQuads.getValue()) ? 5 *topology->getNbQuads() : 0 )
-            +( (writeTetras.getValue()) ? 5 *topology->getNbTetras() : 0 )
-            +( (writeHexas.getValue()) ? 9 *topology->getNbHexas() : 0 );
-
-
-    *outfile << "CELLS " << numberOfCells << " " << totalSize << std::endl;
-
+    snapshot.edges.clear();
+    snapshot.triangles.clear();
+    snapshot.quads.clear();
+    snapshot.tetras.clear();
+    snapshot.hexas.clear();
     if (writeEdges.getValue())
-    {
-        for (unsigned int i=0 ; i<topology->getNbEdges() ; i++)
-            *outfile << 2 << " " << topology->getEdge(i) << std::endl;
-    }
-
+        snapshot.edges = topology->getEdges();
     if (writeTriangles.getValue())
-    {
-        for (unsigned int i=0 ; i<topology->getNbTriangles() ; i++)
-            *outfile << 3 << " " <<  topology->getTriangle(i) << std::endl;
-    }
+        snapshot.triangles = topology->getTriangles();
     if (writeQuads.getValue())
-    {
-        for (unsigned int i=0 ; i<topology->getNbQuads() ; i++)
-            *outfile << 4 << " " << topology->getQuad(i) << std::endl;
-    }
-
+        snapshot.quads = topology->getQuads();
     if (writeTetras.getValue())
-    {
-        for (unsigned int i=0 ; i<topology->getNbTetras() ; i++)
-            *outfile << 4 << " " <<  topology->getTetra(i) << std::endl;
-    }
+        snapshot.tetras = topology->getTetrahedra();
     if (writeHexas.getValue())
+        snapshot.hexas = topology->getHexahedra();
+
+    snapshot.hasPointsData = !dPointsDataFields.getValue().empty();
+    snapshot.hasCellsData = !dCellsDataFields.getValue().empty();
+    snapshot.pointsData.clear();
+    snapshot.cellsData.clear();
+    if (snapshot.hasPointsData)
+        snapshotData(pointsDataObject, pointsDataField, pointsDataName, snapshot.pointsData);
+    if (snapshot.hasCellsData)
+        snapshotData(cellsDataObject, cellsDataField, cellsDataName, snapshot.cellsData);
+
+    if (snapshot.xml)
     {
-        for (unsigned int i=0 ; i<topology->getNbHexas() ; i++)
-            *outfile << 8 << " " <<  topology->getHexa(i) << std::endl;
+        msg_info() << "### VTKExporter[" << this->getName() << "] ###" << msgendl
+                   << "Nb points: " << nbp << msgendl
+                   << "Nb edges: " << snapshot.edges.size() << msgendl
+                   << "Nb triangles: " << snapshot.triangles.size() << msgendl
+                   << "Nb quads: " << snapshot.quads.size() << msgendl
+                   << "Nb tetras: " << snapshot.tetras.size() << msgendl
+                   << "Nb hexas: " << snapshot.hexas.size() << msgendl
+                   << "### ###" << msgendl
+                   << "Total nb cells: " << snapshot.getNbCells() << msgendl;
     }
+}
 
-    *outfile << std::endl;
+void VTKExporter::exportFile()
+{
+    if (!topology)
+        return;
 
-    *outfile << "CELL_TYPES " << numberOfCells << std::endl;
+    reportExports();
 
-    if (writeEdges.getValue())
-    {
-        for (unsigned int i=0 ; i<topology->getNbEdges() ; i++)
-            *outfile << 3 << std::endl;
-    }
+    std::shared_ptr<Snapshot> snapshot = std::make_shared<Snapshot>();
+    takeSnapshot(*snapshot);
 
-    if (writeTriangles.getValue())
+    if (d_asynchronous.getValue())
     {
-        for (unsigned int i=0 ; i<topology->getNbTriangles() ; i++)
-            *outfile << 5 << std::endl;
+        exportQueue.setCapacity(d_maxPendingExports.getValue());
+        exportQueue.push([snapshot]()
+        {
+            return snapshot->xml ? writeVTKXML(*snapshot) : writeVTKSimple(*snapshot);
+        });
     }
-    if (writeQuads.getValue())
+    else
     {
-        for (unsigned int i=0 ; i<topology->getNbQuads() ; i++)
-            *outfile << 9 << std::endl;
+        const AsyncExportQueue::Result result = snapshot->xml ? writeVTKXML(*snapshot) : writeVTKSimple(*snapshot);
+        if (result.success)
+        {
+            msg_info() << result.message;
+        }
+        else
+        {
+            msg_error() << result.message;
+        }
     }
+}
 
-    if (writeTetras.getValue())
-    {
-        for (unsigned int i=0 ; i<topology->getNbTetras() ; i++)
-            *outfile << 10 << std::endl;
-    }
-    if (writeHexas.getValue())
+void VTKExporter::reportExports()
+{
+    for (const AsyncExportQueue::Result& result : exportQueue.takeResults())
     {
-        for (unsigned int i=0 ; i<topology->getNbHexas() ; i++)
-            *outfile << 12 << std::endl;
+        if (result.success)
+        {
+            msg_info() << result.message;
+        }
+        else
+        {
+            msg_error() << result.message;
+        }
     }
+}
 
-    *outfile << std::endl;
-
-    //write dataset attributes
-    if (!pointsData.empty())
+AsyncExportQueue::Result VTKExporter::writeVTKSimple(const Snapshot& snapshot)
+{
+    const std::string& filename = snapshot.filename;
+    std::ofstream outfile(filename.c_str());
+    if( !outfile.is_open() )
     {
-        *outfile << "POINT_DATA " << nbp << std::endl;
-        writeData(pointsDataObject, pointsDataField, pointsDataName);
+        return { false, "Error creating file " + filename };
     }
 
-    if (!cellsData.empty())
-    {
-        *outfile << "CELL_DATA " << numberOfCells << std::endl;
-        writeData(cellsDataObject, cellsDataField, cellsDataName);
-    }
+    const size_t nbp = snapshot.points.size();
 
-    outfile->close();
+    //Write header
+    outfile << "# vtk DataFile Version 2.0" << std::endl;
 
-    ++nbFiles;
+    //write Title
+    outfile << "Exported VTK file" << std::endl;
 
-    msg_info() << "Export VTK in file " << filename << "  done.";
-}
+    //write Data type
+    outfile << "ASCII" << std::endl;
 
-void VTKExporter::writeVTKXML()
-{
-    std::string filename = vtkFilename.getFullPath();
+    outfile << std::endl;
 
-    std::ostringstream oss;
-    oss << nbFiles;
+    //write dataset (geometry, unstructured grid)
+    outfile << "DATASET " << "UNSTRUCTURED_GRID" << std::endl;
 
-    if ( filename.size() > 3 && filename.substr(filename.size()-4)==".vtu")
+    outfile << "POINTS " << nbp << " float" << std::endl;
+    //write Points
+    for (size_t i=0 ; i<nbp; i++)
     {
-        if (!overwrite.getValue())
-            filename = filename.substr(0,filename.size()-4) + oss.str() + ".vtu";
+        outfile << snapshot.points[i] << std::endl;
     }
-    else
+
+    outfile << std::endl;
+
+    //Write Cells
+    const size_t numberOfCells = snapshot.getNbCells();
+    const size_t totalSize = 3 * snapshot.edges.size()
+            + 4 * snapshot.triangles.size()
+            + 5 * snapshot.quads.size()
+            + 5 * snapshot.tetras.size()
+            + 9 * snapshot.hexas.size();
+
+    outfile << "CELLS " << numberOfCells << " " << totalSize << std::endl;
+
+    for (const auto& e : snapshot.edges)
+        outfile << 2 << " " << e << std::endl;
+    for (const auto& e : snapshot.triangles)
+        outfile << 3 << " " << e << std::endl;
+    for (const auto& e : snapshot.quads)
+        outfile << 4 << " " << e << std::endl;
+    for (const auto& e : snapshot.tetras)
+        outfile << 4 << " " << e << std::endl;
+    for (const auto& e : snapshot.hexas)
+        outfile << 8 << " " << e << std::endl;
+
+    outfile << std::endl;
+
+    outfile << "CELL_TYPES " << numberOfCells << std::endl;
+
+    for (size_t i=0 ; i<snapshot.edges.size() ; i++)
+        outfile << 3 << std::endl;
+    for (size_t i=0 ; i<snapshot.triangles.size() ; i++)
+        outfile << 5 << std::endl;
+    for (size_t i=0 ; i<snapshot.quads.size() ; i++)
+        outfile << 9 << std::endl;
+    for (size_t i=0 ; i<snapshot.tetras.size() ; i++)
+        outfile << 10 << std::endl;
+    for (size_t i=0 ; i<snapshot.hexas.size() ; i++)
+        outfile << 12 << std::endl;
+
+    outfile << std::endl;
+
+    //write dataset attributes
+    if (snapshot.hasPointsData)
     {
-        if (!overwrite.getValue())
-            filename += oss.str();
-        filename += ".vtu";
+        outfile << "POINT_DATA " << nbp << std::endl;
+        writeLegacyData(outfile, snapshot.pointsData);
     }
 
-    outfile = new std::ofstream(filename.c_str());
-    if( !outfile->is_open() )
+    if (snapshot.hasCellsData)
     {
-        msg_error() << "Error creating file "<<filename;
-        delete outfile;
-        outfile = nullptr;
-        return;
+        outfile << "CELL_DATA " << numberOfCells << std::endl;
+        writeLegacyData(outfile, snapshot.cellsData);
     }
-    const helper::vector<std::string>& pointsData = dPointsDataFields.getValue();
-    const helper::vector<std::string>& cellsData = dCellsDataFields.getValue();
 
-    helper::ReadAccessor<Data<defaulttype::Vec3Types::VecCoord> > pointsPos = position;
+    outfile.close();
 
-    const size_t nbp = (!pointsPos.empty()) ? pointsPos.size() : topology->getNbPoints();
+    return { true, "Export VTK in file " + filename + "  done." };
+}
 
-    size_t numberOfCells;
-    numberOfCells = ( (writeEdges.getValue()) ? topology->getNbEdges() : 0 )
-            +( (writeTriangles.getValue()) ? topology->getNbTriangles() : 0 )
-            +( (writeQuads.getValue()) ? topology->getNbQuads() : 0 )
-            +( (writeTetras.getValue()) ? topology->getNbTetras() : 0 )
-            +( (writeHexas.getValue()) ? topology->getNbHexas() : 0 );
-
-    msg_info() << "### VTKExporter[" << this->getName() << "] ###" << msgendl
-               << "Nb points: " << nbp << msgendl
-               << "Nb edges: " << ( (writeEdges.getValue()) ? topology->getNbEdges() : 0 ) << msgendl
-               << "Nb triangles: " << ( (writeTriangles.getValue()) ? topology->getNbTriangles() : 0 ) << msgendl
-               << "Nb quads: " << ( (writeQuads.getValue()) ? topology->getNbQuads() : 0 ) << msgendl
-               << "Nb tetras: " << ( (writeTetras.getValue()) ? topology->getNbTetras() : 0 ) << msgendl
-               << "Nb hexas: " << ( (writeHexas.getValue()) ? topology->getNbHexas() : 0 ) << msgendl
-               << "### ###" << msgendl
-               << "Total nb cells: " << numberOfCells << msgendl;
+AsyncExportQueue::Result VTKExporter::writeVTKXML(const Snapshot& snapshot)
+{
+    const std::string& filename = snapshot.filename;
+    std::ofstream outfile(filename.c_str(), snapshot.appended ? std::ios::out | std::ios::binary : std::ios::out);
+    if( !outfile.is_open() )
+    {
+        return { false, "Error creating file " + filename };
+    }
+
+    const size_t nbp = snapshot.points.size();
+    const size_t numberOfCells = snapshot.getNbCells();
+
+    std::vector<char> appendedData;
+    std::vector<char>* appended = snapshot.appended ? &appendedData : nullptr;
 
     //write header
-    *outfile << "<VTKFile type=\"UnstructuredGrid\" version=\"0.1\" byte_order=\"BigEndian\">" << std::endl;
-    *outfile << "  <UnstructuredGrid>" << std::endl;
+    if (appended)
+    {
+        const uint16_t one = 1;
+        const bool littleEndian = *reinterpret_cast<const char*>(&one) == 1;
+        outfile << "<VTKFile type=\"UnstructuredGrid\" version=\"1.0\" byte_order=\"" << (littleEndian ? "LittleEndian" : "BigEndian")
+                << "\" header_type=\"UInt64\"";
+        if (snapshot.compressed)
+            outfile << " compressor=\"vtkZLibDataCompressor\"";
+        outfile << ">" << std::endl;
+    }
+    else
+        outfile << "<VTKFile type=\"UnstructuredGrid\" version=\"0.1\" byte_order=\"BigEndian\">" << std::endl;
+    outfile << "  <UnstructuredGrid>" << std::endl;
 
     //write piece
-    *outfile << "    <Piece NumberOfPoints=\"" << nbp << "\" NumberOfCells=\""<< numberOfCells << "\">" << std::endl;
+    outfile << "    <Piece NumberOfPoints=\"" << nbp << "\" NumberOfCells=\""<< numberOfCells << "\">" << std::endl;
 
     //write point data
-    if (!pointsData.empty())
+    if (snapshot.hasPointsData)
     {
-        *outfile << "      <PointData>" << std::endl;
-        writeDataArray(pointsDataObject, pointsDataField, pointsDataName);
-        *outfile << "      </PointData>" << std::endl;
+        outfile << "      <PointData>" << std::endl;
+        writeXMLDataArrays(outfile, snapshot.pointsData, appended, snapshot.compressed);
+        outfile << "      </PointData>" << std::endl;
     }
     //write cell data
-    if (!cellsData.empty())
+    if (snapshot.hasCellsData)
     {
-        *outfile << "      <CellData>" << std::endl;
-        writeDataArray(cellsDataObject, cellsDataField, cellsDataName);
-        *outfile << "      </CellData>" << std::endl;
+        outfile << "      <CellData>" << std::endl;
+        writeXMLDataArrays(outfile, snapshot.cellsData, appended, snapshot.compressed);
+        outfile << "      </CellData>" << std::endl;
     }
 
-
-
     //write points
-    *outfile << "      <Points>" << std::endl;
-    *outfile << "        <DataArray type=\"Float32\" NumberOfComponents=\"3\" format=\"ascii\">" << std::endl;
-    if (!pointsPos.empty())
-    {
-        for (size_t i = 0 ; i < nbp; i++)
-        {
-            *outfile << "\t" << pointsPos[i] << std::endl;
-        }
-    }
-    else if (mstate && mstate->getSize() == (size_t)nbp)
+    outfile << "      <Points>" << std::endl;
+    if (appended)
     {
-        for (size_t i = 0; i < mstate->getSize(); i++)
-            *outfile << "          " << mstate->getPX(i) << " " << mstate->getPY(i) << " " << mstate->getPZ(i) << std::endl;
+        outfile << "        <DataArray type=\"Float64\" NumberOfComponents=\"3\" format=\"appended\" offset=\"" << appended->size() << "\"/>" << std::endl;
+        appendArray(*appended, snapshot.points.data(), snapshot.points.size() * sizeof(defaulttype::Vec3d), snapshot.compressed);
     }
     else
     {
-        for (size_t i = 0; i < nbp; i++)
-            *outfile << "          " << topology->getPX(i) << " " << topology->getPY(i) << " " << topology->getPZ(i) << std::endl;
+        outfile << "        <DataArray type=\"Float32\" NumberOfComponents=\"3\" format=\"ascii\">" << std::endl;
+        for (size_t i = 0 ; i < nbp; i++)
+        {
+            if (snapshot.pointsFromPositionData)
+                outfile << "\t" << snapshot.points[i] << std::endl;
+            else
+                outfile << "          " << snapshot.points[i] << std::endl;
+        }
+        outfile << "        </DataArray>" << std::endl;
     }
-    *outfile << "        </DataArray>" << std::endl;
-    *outfile << "      </Points>" << std::endl;
+    outfile << "      </Points>" << std::endl;
 
     //write cells
-    *outfile << "      <Cells>" << std::endl;
-    //write connectivity
-    *outfile << "        <DataArray type=\"Int32\" Name=\"connectivity\" format=\"ascii\">" << std::endl;
-    if (writeEdges.getValue())
-    {
-        for (unsigned int i=0 ; i<topology->getNbEdges() ; i++)
-            *outfile << "          " << topology->getEdge(i) << std::endl;
-    }
-
-    if (writeTriangles.getValue())
-    {
-        for (unsigned int i=0 ; i<topology->getNbTriangles() ; i++)
-            *outfile << "          " <<  topology->getTriangle(i) << std::endl;
-    }
-    if (writeQuads.getValue())
+    outfile << "      <Cells>" << std::endl;
+    if (appended)
     {
-        for (unsigned int i=0 ; i<topology->getNbQuads() ; i++)
-            *outfile << "          " << topology->getQuad(i) << std::endl;
+        std::vector<int32_t> connectivity;
+        std::vector<int32_t> offsets;
+        std::vector<uint8_t> types;
+        offsets.reserve(numberOfCells);
+        types.reserve(numberOfCells);
+        appendConnectivity(connectivity, offsets, types, snapshot.edges, 3);
+        appendConnectivity(connectivity, offsets, types, snapshot.triangles, 5);
+        appendConnectivity(connectivity, offsets, types, snapshot.quads, 9);
+        appendConnectivity(connectivity, offsets, types, snapshot.tetras, 10);
+        appendConnectivity(connectivity, offsets, types, snapshot.hexas, 12);
+
+        outfile << "        <DataArray type=\"Int32\" Name=\"connectivity\" format=\"appended\" offset=\"" << appended->size() << "\"/>" << std::endl;
+        appendArray(*appended, connectivity.data(), connectivity.size() * sizeof(int32_t), snapshot.compressed);
+        outfile << "        <DataArray type=\"Int32\" Name=\"offsets\" format=\"appended\" offset=\"" << appended->size() << "\"/>" << std::endl;
+        appendArray(*appended, offsets.data(), offsets.size() * sizeof(int32_t), snapshot.compressed);
+        outfile << "        <DataArray type=\"UInt8\" Name=\"types\" format=\"appended\" offset=\"" << appended->size() << "\"/>" << std::endl;
+        appendArray(*appended, types.data(), types.size(), snapshot.compressed);
     }
-    if (writeTetras.getValue())
-    {
-        for (unsigned int i=0 ; i<topology->getNbTetras() ; i++)
-            *outfile << "          " <<  topology->getTetra(i) << std::endl;
-    }
-    if (writeHexas.getValue())
-    {
-        for (unsigned int i=0 ; i<topology->getNbHexas() ; i++)
-            *outfile << "          " <<  topology->getHexa(i) << std::endl;
-    }
-    *outfile << "        </DataArray>" << std::endl;
-    //write offsets
-    int num = 0;
-    *outfile << "        <DataArray type=\"Int32\" Name=\"offsets\" format=\"ascii\">" << std::endl;
-    *outfile << "          ";
-    if (writeEdges.getValue())
+    else
     {
-        for (unsigned int i=0 ; i<topology->getNbEdges() ; i++)
+        //write connectivity
+        outfile << "        <DataArray type=\"Int32\" Name=\"connectivity\" format=\"ascii\">" << std::endl;
+        for (const auto& e : snapshot.edges)
+            outfile << "          " << e << std::endl;
+        for (const auto& e : snapshot.triangles)
+            outfile << "          " << e << std::endl;
+        for (const auto& e : snapshot.quads)
+            outfile << "          " << e << std::endl;
+        for (const auto& e : snapshot.tetras)
+            outfile << "          " << e << std::endl;
+        for (const auto& e : snapshot.hexas)
+            outfile << "          " << e << std::endl;
+        outfile << "        </DataArray>" << std::endl;
+        //write offsets
+        int num = 0;
+        outfile << "        <DataArray type=\"Int32\" Name=\"offsets\" format=\"ascii\">" << std::endl;
+        outfile << "          ";
+        for (size_t i=0 ; i<snapshot.edges.size() ; i++)
         {
             num += 2;
-            *outfile << num << " ";
+            outfile << num << " ";
         }
-    }
-    if (writeTriangles.getValue())
-    {
-        for (unsigned int i=0 ; i<topology->getNbTriangles() ; i++)
+        for (size_t i=0 ; i<snapshot.triangles.size() ; i++)
         {
             num += 3;
-            *outfile << num << " ";
+            outfile << num << " ";
         }
-    }
-    if (writeQuads.getValue())
-    {
-        for (unsigned int i=0 ; i<topology->getNbQuads() ; i++)
+        for (size_t i=0 ; i<snapshot.quads.size() ; i++)
         {
             num += 4;
-            *outfile << num << " ";
+            outfile << num << " ";
         }
-    }
-    if (writeTetras.getValue())
-    {
-        for (unsigned int i=0 ; i<topology->getNbTetras() ; i++)
+        for (size_t i=0 ; i<snapshot.tetras.size() ; i++)
         {
             num += 4;
-            *outfile << num << " ";
+            outfile << num << " ";
         }
-    }
-    if (writeHexas.getValue())
-    {
-        for (unsigned int i=0 ; i<topology->getNbHexas() ; i++)
+        for (size_t i=0 ; i<snapshot.hexas.size() ; i++)
         {
             num += 8;
-            *outfile << num << " ";
+            outfile << num << " ";
         }
+        outfile << std::endl;
+        outfile << "        </DataArray>" << std::endl;
+        //write types
+        outfile << "        <DataArray type=\"UInt8\" Name=\"types\" format=\"ascii\">" << std::endl;
+        outfile << "          ";
+        for (size_t i=0 ; i<snapshot.edges.size() ; i++)
+            outfile << 3 << " ";
+        for (size_t i=0 ; i<snapshot.triangles.size() ; i++)
+            outfile << 5 << " ";
+        for (size_t i=0 ; i<snapshot.quads.size() ; i++)
+            outfile << 9 << " ";
+        for (size_t i=0 ; i<snapshot.tetras.size() ; i++)
+            outfile << 10 << " ";
+        for (size_t i=0 ; i<snapshot.hexas.size() ; i++)
+            outfile << 12 << " ";
+        outfile << std::endl;
+        outfile << "        </DataArray>" << std::endl;
     }
-    *outfile << std::endl;
-    *outfile << "        </DataArray>" << std::endl;
-    //write types
-    *outfile << "        <DataArray type=\"UInt8\" Name=\"types\" format=\"ascii\">" << std::endl;
-    *outfile << "          ";
-    if (writeEdges.getValue())
-    {
-        for (unsigned int i=0 ; i<topology->getNbEdges() ; i++)
-            *outfile << 3 << " ";
-    }
-    if (writeTriangles.getValue())
-    {
-        for (unsigned int i=0 ; i<topology->getNbTriangles() ; i++)
-            *outfile << 5 << " ";
-    }
-    if (writeQuads.getValue())
-    {
-        for (unsigned int i=0 ; i<topology->getNbQuads() ; i++)
-            *outfile << 9 << " ";
-    }
-    if (writeTetras.getValue())
-    {
-        for (unsigned int i=0 ; i<topology->getNbTetras() ; i++)
-            *outfile << 10 << " ";
-    }
-    if (writeHexas.getValue())
-    {
-        for (unsigned int i=0 ; i<topology->getNbHexas() ; i++)
-            *outfile << 12 << " ";
-    }
-    *outfile << std::endl;
-    *outfile << "        </DataArray>" << std::endl;
-    *outfile << "      </Cells>" << std::endl;
+    outfile << "      </Cells>" << std::endl;
 
     //write end
-    *outfile << "    </Piece>" << std::endl;
-    *outfile << "  </UnstructuredGrid>" << std::endl;
-    *outfile << "</VTKFile>" << std::endl;
-    outfile->close();
-    ++nbFiles;
+    outfile << "    </Piece>" << std::endl;
+    outfile << "  </UnstructuredGrid>" << std::endl;
+    if (appended)
+    {
+        outfile << "  <AppendedData encoding=\"raw\">" << std::endl;
+        outfile << "   _";
+        outfile.write(appended->data(), appended->size());
+        outfile << std::endl;
+        outfile << "  </AppendedData>" << std::endl;
+    }
+    outfile << "</VTKFile>" << std::endl;
+    outfile.close();
 
-    msg_info() << "Export VTK XML in file " << filename << "  done.";
+    return { true, "Export VTK XML in file " + filename + "  done." };
 }
 
+
 void VTKExporter::writeParallelFile()
 {
     std::string filename = vtkFilename.getFullPath();
@@ -963,10 +1060,7 @@ void VTKExporter::handleEvent(sofa::core::objectmodel::Event *event)
 
         case 'E':
         case 'e':
-            if(fileFormat.getValue())
-                writeVTKXML();
-            else
-                writeVTKSimple();
+            exportFile();
             break;
 
         case 'F':
@@ -986,10 +1080,7 @@ void VTKExporter::handleEvent(sofa::core::objectmodel::Event *event)
         if(stepCounter >= maxStep)
         {
             stepCounter = 0;
-            if(fileFormat.getValue())
-                writeVTKXML();
-            else
-                writeVTKSimple();
+            exportFile();
         }
     }
 }
@@ -997,14 +1088,17 @@ void VTKExporter::handleEvent(sofa::core::objectmodel::Event *event)
 void VTKExporter::cleanup()
 {
     if (exportAtEnd.getValue())
-        (fileFormat.getValue()) ? writeVTKXML() : writeVTKSimple();
+        exportFile();
+
+    exportQueue.wait();
+    reportExports();
 
 }
 
 void VTKExporter::bwdInit()
 {
     if (exportAtBegin.getValue())
-        (fileFormat.getValue()) ? writeVTKXML() : writeVTKSimple();
+        exportFile();
 }
 
 }
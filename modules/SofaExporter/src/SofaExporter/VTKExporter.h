@@ -35,6 +35,8 @@
 #include <sofa/core/objectmodel/DataFileName.h>
 #include <sofa/core/topology/BaseMeshTopology.h>
 #include <sofa/core/behavior/BaseMechanicalState.h>
+#include <sofa/helper/OptionsGroup.h>
+#include <SofaExporter/AsyncExportQueue.h>
 
 #include <fstream>
 
@@ -52,20 +54,60 @@ class SOFA_SOFAEXPORTER_API VTKExporter : public core::objectmodel::BaseObject
 public:
     SOFA_CLASS(VTKExporter,core::objectmodel::BaseObject);
 
+    /// Copy of everything an export reads from the scene, so that the file can be written on another thread
+    struct Snapshot
+    {
+        /// Scalar type of a Data field, OTHER when the field is exported through its string value
+        enum ScalarType { INT32, UINT32, FLOAT32, FLOAT64, OTHER };
+
+        struct DataArray
+        {
+            std::string name;
+            ScalarType type;
+            unsigned int vecSize; ///< 0 for vectors of scalars, N for vectors of Vec<N>
+            std::vector<char> values; ///< raw values, unless type is OTHER
+            size_t nbValues;
+            std::string valueString; ///< value of the Data when type is OTHER
+        };
+
+        std::string filename;
+        bool xml;
+        bool appended;
+        bool compressed;
+        bool pointsFromPositionData; ///< points come from the position Data, which only changes the ascii layout
+        helper::vector<defaulttype::Vec3d> points;
+        core::topology::BaseMeshTopology::SeqEdges edges;
+        core::topology::BaseMeshTopology::SeqTriangles triangles;
+        core::topology::BaseMeshTopology::SeqQuads quads;
+        core::topology::BaseMeshTopology::SeqTetrahedra tetras;
+        core::topology::BaseMeshTopology::SeqHexahedra hexas;
+        std::vector<DataArray> pointsData;
+        std::vector<DataArray> cellsData;
+        bool hasPointsData; ///< pointsDataFields is not empty, even if no field could be fetched
+        bool hasCellsData;
+
+        size_t getNbCells() const { return edges.size() + triangles.size() + quads.size() + tetras.size() + hexas.size(); }
+    };
+
+    /// Write the snapshot, returning the outcome to report
+    static AsyncExportQueue::Result writeVTKSimple(const Snapshot& snapshot);
+    static AsyncExportQueue::Result writeVTKXML(const Snapshot& snapshot);
+
 protected:
     sofa::core::topology::BaseMeshTopology* topology;
     sofa::core::behavior::BaseMechanicalState* mstate;
     unsigned int stepCounter;
 
     std::ofstream* outfile;
+    AsyncExportQueue exportQueue;
 
     void fetchDataFields(const helper::vector<std::string>& strData, helper::vector<std::string>& objects, helper::vector<std::string>& fields, helper::vector<std::string>& names);
-    void writeVTKSimple();
-    void writeVTKXML();
+    /// Snapshot the current state and write it, on the export thread if asynchronous is set
+    void exportFile();
+    void takeSnapshot(Snapshot& snapshot);
+    void snapshotData(const helper::vector<std::string>& objects, const helper::vector<std::string>& fields, const helper::vector<std::string>& names, std::vector<Snapshot::DataArray>& arrays);
+    void reportExports();
     void writeParallelFile();
-    void writeData(const helper::vector<std::string>& objects, const helper::vector<std::string>& fields, const helper::vector<std::string>& names);
-    void writeDataArray(const helper::vector<std::string>& objects, const helper::vector<std::string>& fields, const helper::vector<std::string>& names);
-    std::string segmentString(std::string str, unsigned int n);
 
 public:
     sofa::core::objectmodel::DataFileName vtkFilename;
@@ -82,6 +124,10 @@ public:
     Data<bool> exportAtBegin; ///< export file at the initialization
     Data<bool> exportAtEnd; ///< export file when the simulation is finished
     Data<bool> overwrite; ///< overwrite the file, otherwise create a new file at each export, with suffix in the filename
+    Data<helper::OptionsGroup> d_xmlArrayFormat; ///< format of the XML data arrays: ascii or appended raw binary
+    Data<bool> d_compressArrays; ///< compress the appended arrays with zlib
+    Data<bool> d_asynchronous; ///< write the files on a background thread
+    Data<unsigned int> d_maxPendingExports; ///< maximum number of exports queued or being written when asynchronous
 
     int nbFiles;
 
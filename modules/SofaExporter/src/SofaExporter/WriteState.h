@@ -31,6 +31,8 @@
 #include <sofa/simulation/AnimateEndEvent.h>
 #include <sofa/defaulttype/DataTypeInfo.h>
 #include <sofa/simulation/Visitor.h>
+#include <sofa/helper/OptionsGroup.h>
+#include <SofaGeneralLoader/StateRecordFile.h>
 
 #if SOFAEXPORTER_HAVE_ZLIB
 #include <zlib.h>
@@ -52,6 +54,7 @@ namespace misc
  * The DoFs to print can be chosen using DOFsX and DOFsV
  * Stop to write the state if the kinematic energy reach a given threshold (stopAt)
  * The energy will be measured at each period determined by keperiod
+ * The binary format stores each export as an indexed frame (see StateRecordFile)
 */
 class SOFA_SOFAEXPORTER_API WriteState: public core::objectmodel::BaseObject
 {
@@ -69,6 +72,9 @@ public:
     Data < helper::vector<unsigned int> > d_DOFsV; ///< set the velocity DOFs to write
     Data < double > d_stopAt; ///< stop the simulation when the given threshold is reached
     Data < double > d_keperiod; ///< set the period to measure the kinetic energy increase
+    Data < helper::OptionsGroup > d_format; ///< file format: text or binary
+    Data < helper::OptionsGroup > d_binaryPrecision; ///< scalar type stored in binary files
+    Data < bool > d_binaryCompression; ///< deflate each frame of binary files
 
 protected:
     core::behavior::BaseMechanicalState* mmodel;
@@ -76,6 +82,7 @@ protected:
 #if SOFAEXPORTER_HAVE_ZLIB
     gzFile gzfile;
 #endif
+    StateRecordWriter binaryfile;
     unsigned int nextIteration;
     double lastTime;
     bool kineticEnergyThresholdReached;
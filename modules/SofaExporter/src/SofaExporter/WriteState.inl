@@ -52,6 +52,9 @@ WriteState::WriteState()
     , d_DOFsV( initData(&d_DOFsV, helper::vector<unsigned int>(0), "DOFsV", "set the velocity DOFs to write"))
     , d_stopAt( initData(&d_stopAt, 0.0, "stopAt", "stop the simulation when the given threshold is reached"))
     , d_keperiod( initData(&d_keperiod, 0.0, "keperiod", "set the period to measure the kinetic energy increase"))
+    , d_format( initData(&d_format, helper::OptionsGroup(2,"text","binary"), "format", "file format: text (optionally gzipped) or indexed binary frames readable by ReadState"))
+    , d_binaryPrecision( initData(&d_binaryPrecision, helper::OptionsGroup(2,"double","float"), "binaryPrecision", "scalar type stored in binary files"))
+    , d_binaryCompression( initData(&d_binaryCompression, false, "binaryCompression", "deflate each frame of binary files"))
     , mmodel(nullptr)
     , outfile(nullptr)
 #if SOFAEXPORTER_HAVE_ZLIB
@@ -92,7 +95,18 @@ void WriteState::init()
     ///////////// end of the tests.
 
     const std::string& filename = d_filename.getFullPath();
-    if (!filename.empty())
+    if (!filename.empty() && d_format.getValue().getSelectedId() == 1)
+    {
+        const StateRecordFile::ScalarType scalarType = d_binaryPrecision.getValue().getSelectedId() == 1 ?
+                    StateRecordFile::FLOAT : StateRecordFile::DOUBLE;
+        const StateRecordFile::Compression compression = d_binaryCompression.getValue() ?
+                    StateRecordFile::ZLIB : StateRecordFile::NONE;
+        if (!binaryfile.open(filename, scalarType, compression))
+        {
+            msg_error() << "Error creating binary file "<<filename;
+        }
+    }
+    else if (!filename.empty())
     {
 #if SOFAEXPORTER_HAVE_ZLIB
         if (filename.size() >= 3 && filename.substr(filename.size()-3)==".gz")
@@ -233,6 +247,7 @@ if (outfile)
 if (gzfile)
     gzclose(gzfile);
 #endif
+binaryfile.close();
 init();
 }
 void WriteState::reset()
@@ -257,6 +272,7 @@ void WriteState::handleEvent(sofa::core::objectmodel::Event* event)
 #if SOFAEXPORTER_HAVE_ZLIB
             && !gzfile
 #endif
+            && !binaryfile.isOpen()
            )
             return;
 
@@ -325,6 +341,41 @@ void WriteState::handleEvent(sofa::core::objectmodel::Event* event)
         }
         if (writeCurrent)
         {
+            if (binaryfile.isOpen())
+            {
+                binaryfile.beginFrame(time);
+                helper::vector<SReal> buffer;
+                const size_t size = mmodel->getSize();
+                if (d_writeX.getValue())
+                {
+                    buffer.resize(size * mmodel->getCoordDimension());
+                    mmodel->copyToBuffer(buffer.data(), core::VecId::position(), (unsigned int)buffer.size());
+                    binaryfile.addVector(StateRecordFile::POSITION, buffer.data(), buffer.size());
+                }
+                if (d_writeX0.getValue())
+                {
+                    buffer.resize(size * mmodel->getCoordDimension());
+                    mmodel->copyToBuffer(buffer.data(), core::VecId::restPosition(), (unsigned int)buffer.size());
+                    binaryfile.addVector(StateRecordFile::REST_POSITION, buffer.data(), buffer.size());
+                }
+                if (d_writeV.getValue())
+                {
+                    buffer.resize(size * mmodel->getDerivDimension());
+                    mmodel->copyToBuffer(buffer.data(), core::VecId::velocity(), (unsigned int)buffer.size());
+                    binaryfile.addVector(StateRecordFile::VELOCITY, buffer.data(), buffer.size());
+                }
+                if (d_writeF.getValue())
+                {
+                    buffer.resize(size * mmodel->getDerivDimension());
+                    mmodel->copyToBuffer(buffer.data(), core::VecId::force(), (unsigned int)buffer.size());
+                    binaryfile.addVector(StateRecordFile::FORCE, buffer.data(), buffer.size());
+                }
+                if (!binaryfile.endFrame())
+                {
+                    msg_error() << "Error writing binary file "<<d_filename.getFullPath();
+                }
+            }
+            else
 #if SOFAEXPORTER_HAVE_ZLIB
             if (gzfile)
             {
@@ -99,6 +99,7 @@ public:
 
     Data< sofa::helper::vector<sofa::helper::vector< unsigned int > > > f_interpolationIndices; ///< Indices of a linear interpolation
     Data< sofa::helper::vector<sofa::helper::vector< Real > > > f_interpolationValues; ///< Values of a linear interpolation
+    Data<bool> d_parallel; ///< Locate the mapped points in parallel with the task scheduler
 
 private:
 
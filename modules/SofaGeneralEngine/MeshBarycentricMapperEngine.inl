@@ -23,6 +23,7 @@
 #define SOFA_COMPONENT_ENGINE_MESHBARYCENTRICMAPPERENGINE_INL
 
 #include <SofaGeneralEngine/MeshBarycentricMapperEngine.h>
+#include <SofaBaseMechanics/BarycentricMappers/BarycentricPointLocator.h>
 #include <sofa/core/visual/VisualParams.h>
 
 namespace sofa
@@ -45,6 +46,7 @@ MeshBarycentricMapperEngine<DataTypes>::MeshBarycentricMapperEngine()
     , computeLinearInterpolation(initData(&computeLinearInterpolation, false, "computeLinearInterpolation", "if true, computes a linear interpolation (debug)"))
     , f_interpolationIndices(initData(&f_interpolationIndices, "LinearInterpolationIndices", "Indices of a linear interpolation"))
     , f_interpolationValues(initData(&f_interpolationValues, "LinearInterpolationValues", "Values of a linear interpolation"))
+    , d_parallel(initData(&d_parallel, false, "parallel", "Locate the mapped points in parallel with the task scheduler"))
 {
 }
 
@@ -136,6 +138,8 @@ void MeshBarycentricMapperEngine<DataTypes>::doUpdate()
 
     int outside = 0;
 
+    sofa::simulation::TaskScheduler* scheduler = d_parallel.getValue() ? sofa::simulation::TaskScheduler::getInstance() : nullptr;
+
     const sofa::core::topology::BaseMeshTopology::SeqTetrahedra& tetrahedra = TopoInput->getTetrahedra();
     const sofa::core::topology::BaseMeshTopology::SeqHexahedra& cubes = TopoInput->getHexahedra();
 
@@ -215,36 +219,61 @@ void MeshBarycentricMapperEngine<DataTypes>::doUpdate()
                 bases[c0+c].invert ( mt );
                 centers[c0+c] = ( (*in)[quads[c][0]]+(*in)[quads[c][1]]+(*in)[quads[c][2]]+(*in)[quads[c][3]] ) *0.25;
             }
-            for ( unsigned int i=0; i<(*out).size(); i++ )
+            component::mapping::BarycentricPointLocator locator;
+            locator.clear ( triangles.size() +quads.size() );
+            for ( unsigned int t = 0; t < triangles.size(); t++ )
+            {
+                locator.addElement();
+                for ( unsigned int j = 0; j < 3; j++ )
+                    locator.addPoint ( t, (*in)[triangles[t][j]] );
+                locator.addBarycentricRegion ( t, (*in)[triangles[t][0]], bases[t] );
+            }
+            for ( unsigned int c = 0; c < quads.size(); c++ )
+            {
+                locator.addElement();
+                for ( unsigned int j = 0; j < 4; j++ )
+                    locator.addPoint ( c0+c, (*in)[quads[c][j]] );
+                locator.addBarycentricRegion ( c0+c, (*in)[quads[c][0]], bases[c0+c] );
+            }
+            locator.build();
+
+            sofa::helper::vector<int> indices ( (*out).size() );
+            sofa::helper::vector<Vector3> coefs ( (*out).size() );
+            sofa::helper::vector<double> distances ( (*out).size() );
+            component::mapping::BarycentricPointLocator::forEachPoint ( scheduler, (*out).size(), [&] ( std::size_t i )
             {
                 Vector3 pos = DataTypes::getCPos((*out)[i]);
-                Vector3 coefs;
-                int index = -1;
-                double distance = 1e10;
-                for ( unsigned int t = 0; t < triangles.size(); t++ )
+                auto measure = [&] ( int e )
                 {
-                    Vec3d v = bases[t] * ( pos - (*in)[triangles[t][0]] );
-                    double d = std::max ( std::max ( -v[0],-v[1] ),std::max ( ( v[2]<0?-v[2]:v[2] )-0.01,v[0]+v[1]-1 ) );
-                    if ( d>0 ) d = ( pos-centers[t] ).norm2();
-                    if ( d<distance ) { coefs = v; distance = d; index = t; }
-                }
-                for ( unsigned int c = 0; c < quads.size(); c++ )
-                {
-                    Vec3d v = bases[c0+c] * ( pos - (*in)[quads[c][0]] );
+                    if ( e < c0 )
+                    {
+                        Vec3d v = bases[e] * ( pos - (*in)[triangles[e][0]] );
+                        double d = std::max ( std::max ( -v[0],-v[1] ),std::max ( ( v[2]<0?-v[2]:v[2] )-0.01,v[0]+v[1]-1 ) );
+                        if ( d>0 ) d = ( pos-centers[e] ).norm2();
+                        return d;
+                    }
+                    Vec3d v = bases[e] * ( pos - (*in)[quads[e-c0][0]] );
                     double d = std::max ( std::max ( -v[0],-v[1] ),std::max ( std::max ( v[1]-1,v[0]-1 ),std::max ( v[2]-0.01,-v[2]-0.01 ) ) );
-                    if ( d>0 ) d = ( pos-centers[c0+c] ).norm2();
-                    if ( d<distance ) { coefs = v; distance = d; index = c0+c; }
-                }
-                if ( distance>0 )
+                    if ( d>0 ) d = ( pos-centers[e] ).norm2();
+                    return d;
+                };
+                const int index = locator.findNearest ( pos, measure, distances[i] );
+                indices[i] = index;
+                coefs[i] = bases[index] * ( pos - (*in)[index < c0 ? triangles[index][0] : quads[index-c0][0]] );
+            } );
+
+            for ( unsigned int i=0; i<(*out).size(); i++ )
+            {
+                if ( distances[i]>0 )
                 {
                     ++outside;
                 }
-                if ( index < c0 ){
-                    std::cout<<"addPoint "<<i<<" in Triangle "<<index<<" coef bary :"<<coefs<<std::endl;
-                    addPointInTriangle ( index, coefs.ptr(),i );
+                if ( indices[i] < c0 ){
+                    std::cout<<"addPoint "<<i<<" in Triangle "<<indices[i]<<" coef bary :"<<coefs[i]<<std::endl;
+                    addPointInTriangle ( indices[i], coefs[i].ptr(),i );
                 }
                 else
-                    addPointInQuad ( index-c0, coefs.ptr() );
+                    addPointInQuad ( indices[i]-c0, coefs[i].ptr() );
             }
         }
     }
@@ -275,34 +304,59 @@ void MeshBarycentricMapperEngine<DataTypes>::doUpdate()
             bases[c0+c].invert ( mt );
             centers[c0+c] = ( (*in)[cubes[c][0]]+(*in)[cubes[c][1]]+(*in)[cubes[c][2]]+(*in)[cubes[c][3]]+(*in)[cubes[c][4]]+(*in)[cubes[c][5]]+(*in)[cubes[c][6]]+(*in)[cubes[c][7]] ) *0.125;
         }
-        for ( unsigned int i=0; i<(*out).size(); i++ )
+        component::mapping::BarycentricPointLocator locator;
+        locator.clear ( tetrahedra.size() +cubes.size() );
+        for ( unsigned int t = 0; t < tetrahedra.size(); t++ )
+        {
+            locator.addElement();
+            for ( unsigned int j = 0; j < 4; j++ )
+                locator.addPoint ( t, (*in)[tetrahedra[t][j]] );
+            locator.addBarycentricRegion ( t, (*in)[tetrahedra[t][0]], bases[t] );
+        }
+        for ( unsigned int c = 0; c < cubes.size(); c++ )
+        {
+            locator.addElement();
+            for ( unsigned int j = 0; j < 8; j++ )
+                locator.addPoint ( c0+c, (*in)[cubes[c][j]] );
+            locator.addBarycentricRegion ( c0+c, (*in)[cubes[c][0]], bases[c0+c] );
+        }
+        locator.build();
+
+        sofa::helper::vector<int> indices ( (*out).size() );
+        sofa::helper::vector<Vector3> coefs ( (*out).size() );
+        sofa::helper::vector<double> distances ( (*out).size() );
+        component::mapping::BarycentricPointLocator::forEachPoint ( scheduler, (*out).size(), [&] ( std::size_t i )
         {
             Vector3 pos = DataTypes::getCPos((*out)[i]);
-            Vector3 coefs;
-            int index = -1;
-            double distance = 1e10;
-            for ( unsigned int t = 0; t < tetrahedra.size(); t++ )
+            auto measure = [&] ( int e )
             {
-                Vector3 v = bases[t] * ( pos - (*in)[tetrahedra[t][0]] );
-                double d = std::max ( std::max ( -v[0],-v[1] ),std::max ( -v[2],v[0]+v[1]+v[2]-1 ) );
-                if ( d>0 ) d = ( pos-centers[t] ).norm2();
-                if ( d<distance ) { coefs = v; distance = d; index = t; }
-            }
-            for ( unsigned int c = 0; c < cubes.size(); c++ )
-            {
-                Vector3 v = bases[c0+c] * ( pos - (*in)[cubes[c][0]] );
+                if ( e < c0 )
+                {
+                    Vector3 v = bases[e] * ( pos - (*in)[tetrahedra[e][0]] );
+                    double d = std::max ( std::max ( -v[0],-v[1] ),std::max ( -v[2],v[0]+v[1]+v[2]-1 ) );
+                    if ( d>0 ) d = ( pos-centers[e] ).norm2();
+                    return d;
+                }
+                Vector3 v = bases[e] * ( pos - (*in)[cubes[e-c0][0]] );
                 double d = std::max ( std::max ( -v[0],-v[1] ),std::max ( std::max ( -v[2],v[0]-1 ),std::max ( v[1]-1,v[2]-1 ) ) );
-                if ( d>0 ) d = ( pos-centers[c0+c] ).norm2();
-                if ( d<distance ) { coefs = v; distance = d; index = c0+c; }
-            }
-            if ( distance>0 )
+                if ( d>0 ) d = ( pos-centers[e] ).norm2();
+                return d;
+            };
+            const int index = locator.findNearest ( pos, measure, distances[i] );
+            indices[i] = index;
+            coefs[i] = bases[index] * ( pos - (*in)[index < c0 ? tetrahedra[index][0] : cubes[index-c0][0]] );
+        } );
+
+        for ( unsigned int i=0; i<(*out).size(); i++ )
+        {
+            if ( distances[i]>0 )
             {
                 ++outside;
             }
-            if ( index < c0 )
-                addPointInTetra ( index, coefs.ptr() , i);
+            if ( indices[i] < c0 )
+                addPointInTetra ( indices[i], coefs[i].ptr() , i);
             else
-                addPointInCube ( index-c0, coefs.ptr() );
+                addPointInCube ( indices[i]-c0, coefs[i].ptr() );
         }
     }
 
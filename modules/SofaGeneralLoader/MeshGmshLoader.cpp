@@ -106,6 +106,7 @@ bool MeshGmshLoader::load()
 
         copyMeshToData(_mesh);
         delete _mesh;
+        fileRead = true;
     }
     else //if it enter this "else", it means there is a problem before in the factory or in canLoad()
     {
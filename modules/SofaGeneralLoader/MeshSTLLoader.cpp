@@ -23,6 +23,11 @@
 #include <sofa/helper/system/FileRepository.h>
 #include <SofaGeneralLoader/MeshSTLLoader.h>
 #include <sofa/core/visual/VisualParams.h>
+#include <sofa/helper/io/MappedFile.h>
+#include <sofa/helper/io/TextParsing.h>
+#include <sofa/simulation/ParallelForEach.h>
+
+#include <algorithm>
 
 #include <iostream>
 #include <fstream>
@@ -65,10 +70,9 @@ bool MeshSTLLoader::load()
         return false;
     }
 
-    std::ifstream file(filename);
-    if (!file.good())
+    helper::io::MappedFile file;
+    if (!file.open(sfilename))
     {
-        file.close();
         msg_error() << "Cannot read file '" << filename << "'.";
         return false;
     }
@@ -76,11 +80,9 @@ bool MeshSTLLoader::load()
     if( _forceBinary.getValue() )
         return this->readBinarySTL(filename); // -- Reading binary file
 
-    std::string test;
-    file >> test;
-
-    if ( test == "solid" )
-        return this->readSTL(file);
+    const char* word = helper::io::text::skipSpaces(file.begin(), file.end());
+    if ( helper::io::text::isWord(word, helper::io::text::wordEnd(word, file.end()), "solid") )
+        return this->readSTL(file.begin(), file.end());
     else
     {
         file.close(); // no longer need for an ascii-open file
@@ -208,11 +210,67 @@ bool MeshSTLLoader::readBinarySTL(const char *filename)
 }
 
 
-bool MeshSTLLoader::readSTL(std::ifstream& dataFile)
+namespace
 {
-    Vec3f result;
-    std::string line;
 
+/// Statements of an ascii STL file, in the order of the file.
+struct STLChunk
+{
+    enum Statement { FACET, VERTEX, ENDFACET, ENDSOLID };
+    std::vector<char> statements;
+    helper::vector<Vec3f> normals;
+    helper::vector<Vec3f> vertices;
+};
+
+Vec3f parseVec3f(const char* p, const char* end)
+{
+    Vec3f v;
+    for (int i = 0; i < 3; ++i)
+    {
+        if (!helper::io::text::parseValue(p, end, v[i]))
+            break;
+    }
+    return v;
+}
+
+void parseSTLChunk(const char* p, const char* end, STLChunk& chunk)
+{
+    using namespace helper::io::text;
+    while (p < end)
+    {
+        const char* le = lineEnd(p, end);
+        const char* b = skipBlanks(p, le);
+        const char* e = wordEnd(b, le);
+        p = le < end ? le + 1 : end;
+
+        if (isWord(b, e, "facet"))
+        {
+            // Normal
+            const char* n = wordEnd(skipBlanks(e, le), le);
+            chunk.statements.push_back(STLChunk::FACET);
+            chunk.normals.push_back(parseVec3f(n, le));
+        }
+        else if (isWord(b, e, "vertex"))
+        {
+            chunk.statements.push_back(STLChunk::VERTEX);
+            chunk.vertices.push_back(parseVec3f(e, le));
+        }
+        else if (isWord(b, e, "endfacet"))
+        {
+            chunk.statements.push_back(STLChunk::ENDFACET);
+        }
+        else if (isWord(b, e, "endsolid") || isWord(b, e, "end"))
+        {
+            chunk.statements.push_back(STLChunk::ENDSOLID);
+            return;
+        }
+    }
+}
+
+} // anonymous namespace
+
+bool MeshSTLLoader::readSTL(const char* begin, const char* end)
+{
     helper::vector<sofa::defaulttype::Vector3>& my_positions = *(d_positions.beginEdit());
     helper::vector<sofa::defaulttype::Vector3>& my_normals = *(d_normals.beginEdit());
     helper::vector<Triangle >& my_triangles = *(d_triangles.beginEdit());
@@ -224,67 +282,78 @@ bool MeshSTLLoader::readSTL(std::ifstream& dataFile)
 
     Triangle the_tri;
 
-    while (std::getline(dataFile, line))
-    {
-        if (line.empty()) continue;
-        std::istringstream values(line);
-
-        std::string bufferWord;
-        values >> bufferWord;
+    // The lines are parsed by independent chunks, possibly in parallel,
+    // then the vertices are merged in the order of the file.
+    simulation::TaskScheduler* scheduler = d_parallelParsing.getValue() ? simulation::TaskScheduler::getInstance() : nullptr;
+    const std::size_t nbChunks = scheduler ? 4 * std::max(1u, scheduler->getThreadCount()) : 1;
+    const std::vector<const char*> bounds = helper::io::text::splitLines(begin, end, nbChunks);
+    std::vector<STLChunk> chunks(bounds.size() - 1);
+    auto parseChunk = [&](std::size_t c) { parseSTLChunk(bounds[c], bounds[c+1], chunks[c]); };
+    if (scheduler)
+        simulation::parallelForEach(*scheduler, 0, chunks.size(), parseChunk);
+    else
+        for (std::size_t c = 0; c < chunks.size(); ++c)
+            parseChunk(c);
 
-        if (bufferWord == "facet")
-        {
-            // Normal
-            values >> bufferWord >> result[0] >> result[1] >> result[2];
-            my_normals.push_back(result);
-        }
-        else if (bufferWord == "vertex")
+    bool endOfSolid = false;
+    for (std::size_t c = 0; c < chunks.size() && !endOfSolid; ++c)
+    {
+        const STLChunk& chunk = chunks[c];
+        std::size_t nextNormal = 0, nextVertex = 0;
+        for (char statement : chunk.statements)
         {
-            // Vertex
-            values >> result[0] >> result[1] >> result[2];
-
-            if( useMap )
+            if (statement == STLChunk::FACET)
             {
-                auto it = my_map.find(result);
-                if( it == my_map.end() )
+                my_normals.push_back(chunk.normals[nextNormal++]);
+            }
+            else if (statement == STLChunk::VERTEX)
+            {
+                const Vec3f& result = chunk.vertices[nextVertex++];
+
+                if( useMap )
                 {
-                    the_tri[vertexCounter] = positionCounter;
-                    my_map[result] = positionCounter++;
-                    my_positions.push_back(result);
+                    auto it = my_map.find(result);
+                    if( it == my_map.end() )
+                    {
+                        the_tri[vertexCounter] = positionCounter;
+                        my_map[result] = positionCounter++;
+                        my_positions.push_back(result);
+                    }
+                    else
+                    {
+                        the_tri[vertexCounter] = it->second;
+                    }
                 }
                 else
                 {
-                    the_tri[vertexCounter] = it->second;
-                }
-            }
-            else
-            {
 
-                bool find = false;
-                for (size_t i=0; i<my_positions.size(); ++i)
-                    if ( (result[0] == my_positions[i][0]) && (result[1] == my_positions[i][1])  && (result[2] == my_positions[i][2]))
+                    bool find = false;
+                    for (size_t i=0; i<my_positions.size(); ++i)
+                        if ( (result[0] == my_positions[i][0]) && (result[1] == my_positions[i][1])  && (result[2] == my_positions[i][2]))
+                        {
+                            find = true;
+                            the_tri[vertexCounter] = static_cast<core::topology::Topology::PointID>(i);
+                            break;
+                        }
+
+                    if (!find)
                     {
-                        find = true;
-                        the_tri[vertexCounter] = static_cast<core::topology::Topology::PointID>(i);
-                        break;
+                        my_positions.push_back(result);
+                        the_tri[vertexCounter] = static_cast<core::topology::Topology::PointID>(my_positions.size()-1);
                     }
-
-                if (!find)
-                {
-                    my_positions.push_back(result);
-                    the_tri[vertexCounter] = static_cast<core::topology::Topology::PointID>(my_positions.size()-1);
                 }
+                vertexCounter++;
+            }
+            else if (statement == STLChunk::ENDFACET)
+            {
+                my_triangles.push_back(the_tri);
+                vertexCounter = 0;
+            }
+            else
+            {
+                endOfSolid = true;
+                break;
             }
-            vertexCounter++;
-        }
-        else if (bufferWord == "endfacet")
-        {
-            my_triangles.push_back(the_tri);
-            vertexCounter = 0;
-        }
-        else if (bufferWord == "endsolid" || bufferWord == "end")
-        {
-            break;
         }
     }
 
@@ -292,8 +361,6 @@ bool MeshSTLLoader::readSTL(std::ifstream& dataFile)
     d_triangles.endEdit();
     d_normals.endEdit();
 
-    dataFile.close();
-
     dmsg_info() << "done!" ;
 
     return true;
@@ -301,7 +368,6 @@ bool MeshSTLLoader::readSTL(std::ifstream& dataFile)
 
 
 
-
 } // namespace loader
 
 } // namespace component
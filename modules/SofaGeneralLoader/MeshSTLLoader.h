@@ -53,7 +53,7 @@ public:
 protected:
 
     // ascii
-    bool readSTL(std::ifstream& file);
+    bool readSTL(const char* begin, const char* end);
 
     // binary
     bool readBinarySTL(const char* filename);
@@ -22,6 +22,7 @@
 #ifndef SOFA_COMPONENT_MISC_READSTATE_H
 #define SOFA_COMPONENT_MISC_READSTATE_H
 #include <SofaGeneralLoader/config.h>
+#include <SofaGeneralLoader/StateRecordFile.h>
 
 #include <sofa/simulation/AnimateBeginEvent.h>
 #include <sofa/simulation/AnimateEndEvent.h>
@@ -43,6 +44,8 @@ namespace misc
 {
 
 /** Read State vectors from file at each timestep
+ * Binary recordings (see StateRecordFile) are detected from their header and
+ * accessed by time through their frame index instead of being parsed line by line.
 */
 class SOFA_GENERAL_LOADER_API ReadState: public core::objectmodel::BaseObject
 {
@@ -64,6 +67,9 @@ protected:
     double nextTime;
     double lastTime;
     double loopTime;
+    StateRecordReader binaryFile;
+    StateRecordReader::Frame binaryFrame;
+    int lastBinaryFrame;
 
     ReadState();
 
@@ -83,6 +89,11 @@ public:
     /// Read the next values in the file corresponding to the last timestep before the given time
     bool readNext(double time, std::vector<std::string>& lines);
 
+    /// Apply the frame of a binary recording corresponding to the last timestep before the given time
+    bool readBinaryFrame(double time);
+
+    bool isBinary() const { return binaryFile.isOpen(); }
+
     /// Pre-construction check method called by ObjectFactory.
     /// Check that DataTypes matches the MechanicalState.
     template<class T>
@@ -94,6 +105,9 @@ public:
     }
 
 
+protected:
+    /// Propagate the positions and velocities which have been read
+    void updateState();
 };
 
 
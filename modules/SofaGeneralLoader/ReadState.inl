@@ -27,6 +27,7 @@
 #include <sofa/simulation/MechanicalVisitor.h>
 #include <sofa/simulation/UpdateMappingVisitor.h>
 
+#include <cmath>
 #include <cstring>
 #include <sstream>
 
@@ -53,6 +54,7 @@ ReadState::ReadState()
     , nextTime(0)
     , lastTime(0)
     , loopTime(0)
+    , lastBinaryFrame(-1)
 {
     this->f_listening.setValue(true);
 }
@@ -87,12 +89,21 @@ void ReadState::reset()
         gzfile = nullptr;
     }
 #endif
+    binaryFile.close();
+    lastBinaryFrame = -1;
 
     const std::string& filename = d_filename.getFullPath();
     if (filename.empty())
     {
         msg_error() << "ERROR: empty filename";
     }
+    else if (StateRecordFile::isStateRecordFile(filename))
+    {
+        if (!binaryFile.open(filename))
+        {
+            msg_error() << "Error opening binary state file "<<filename;
+        }
+    }
 #if SOFAGENERALLOADER_HAVE_ZLIB
     else if (filename.size() >= 3 && filename.substr(filename.size()-3)==".gz")
     {
@@ -140,6 +151,13 @@ void ReadState::setTime(double time)
 void ReadState::processReadState(double time)
 {
     if (time == lastTime) return;
+    if (binaryFile.isOpen())
+    {
+        // binary recordings are indexed by time: seek directly to the requested frame
+        if (readBinaryFrame(time))
+            updateState();
+        return;
+    }
     setTime(time);
     processReadState();
 }
@@ -219,9 +237,72 @@ bool ReadState::readNext(double time, std::vector<std::string>& validLines)
     return true;
 }
 
+bool ReadState::readBinaryFrame(double time)
+{
+    if (!mmodel || !binaryFile.isOpen()) return false;
+    lastTime = time;
+    const size_t nbFrames = binaryFile.getNbFrames();
+    if (nbFrames == 0) return false;
+
+    const double duration = binaryFile.getFrameTime(nbFrames-1);
+    if (d_loop.getValue() && duration > 0 && time > duration)
+        time = std::fmod(time, duration);
+
+    const int frame = binaryFile.findFrame(time);
+    if (frame < 0 || frame == lastBinaryFrame) return false;
+    lastBinaryFrame = frame;
+
+    if (!binaryFile.readFrame(frame, binaryFrame))
+    {
+        msg_error() << "Error reading frame " << frame << " of " << d_filename.getFullPath();
+        return false;
+    }
+
+    bool updated = false;
+    if (binaryFrame.present[StateRecordFile::POSITION])
+    {
+        const helper::vector<SReal>& values = binaryFrame.values[StateRecordFile::POSITION];
+        const size_t dim = mmodel->getCoordDimension();
+        if (dim && values.size() % dim == 0)
+        {
+            if (values.size() / dim != mmodel->getSize())
+                mmodel->resize(values.size() / dim);
+            mmodel->copyFromBuffer(core::VecId::position(), values.data(), (unsigned int)values.size());
+            mmodel->applyScale(d_scalePos.getValue(), d_scalePos.getValue(), d_scalePos.getValue());
+            updated = true;
+        }
+        else
+        {
+            msg_error() << "Position of frame " << frame << " does not match the coordinates of " << mmodel->getName();
+        }
+    }
+    if (binaryFrame.present[StateRecordFile::VELOCITY])
+    {
+        const helper::vector<SReal>& values = binaryFrame.values[StateRecordFile::VELOCITY];
+        const size_t dim = mmodel->getDerivDimension();
+        if (dim && values.size() == dim * mmodel->getSize())
+        {
+            mmodel->copyFromBuffer(core::VecId::velocity(), values.data(), (unsigned int)values.size());
+            updated = true;
+        }
+        else
+        {
+            msg_error() << "Velocity of frame " << frame << " does not match the size of " << mmodel->getName();
+        }
+    }
+    return updated;
+}
+
 void ReadState::processReadState()
 {
     double time = getContext()->getTime() + d_shift.getValue();
+    if (binaryFile.isOpen())
+    {
+        if (readBinaryFrame(time))
+            updateState();
+        return;
+    }
+
     std::vector<std::string> validLines;
     if (!readNext(time, validLines)) return;
     bool updated = false;
@@ -245,14 +326,17 @@ void ReadState::processReadState()
     }
 
     if (updated)
-    {
-        sofa::simulation::MechanicalProjectPositionAndVelocityVisitor action0(core::MechanicalParams::defaultInstance());
-        this->getContext()->executeVisitor(&action0);
-        sofa::simulation::MechanicalPropagateOnlyPositionAndVelocityVisitor action1(core::MechanicalParams::defaultInstance());
-        this->getContext()->executeVisitor(&action1);
-        sofa::simulation::UpdateMappingVisitor action2(core::MechanicalParams::defaultInstance());
-        this->getContext()->executeVisitor(&action2);
-    }
+        updateState();
+}
+
+void ReadState::updateState()
+{
+    sofa::simulation::MechanicalProjectPositionAndVelocityVisitor action0(core::MechanicalParams::defaultInstance());
+    this->getContext()->executeVisitor(&action0);
+    sofa::simulation::MechanicalPropagateOnlyPositionAndVelocityVisitor action1(core::MechanicalParams::defaultInstance());
+    this->getContext()->executeVisitor(&action1);
+    sofa::simulation::UpdateMappingVisitor action2(core::MechanicalParams::defaultInstance());
+    this->getContext()->executeVisitor(&action2);
 }
 
 } // namespace misc
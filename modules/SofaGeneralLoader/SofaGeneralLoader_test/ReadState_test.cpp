@@ -28,6 +28,10 @@ using sofa::simulation::Node;
 #include <sofa/defaulttype/Vec.h>
 using sofa::defaulttype::Vec3;
 
+#include <SofaGeneralLoader/ReadState.h>
+using sofa::component::misc::ReadState;
+using sofa::component::misc::StateRecordFile;
+
 class ReadState_test : public BaseSimulationTest
 {
 public:
@@ -62,6 +66,44 @@ public:
         return true;
     }
 
+    /// Same as the default behavior with the binary conversion of the file, then seek back in time
+    bool testBinaryBehavior()
+    {
+        const std::string filename = std::string(SOFAGENERALLOADER_BUILD_DIR)+"particleGravityX_ReadState.sstate";
+        EXPECT_TRUE(StateRecordFile::convertFromText(std::string(SOFAGENERALLOADER_TESTFILES_DIR)+"particleGravityX.data",
+                                                     filename, StateRecordFile::DOUBLE, StateRecordFile::ZLIB));
+
+        double dt = 0.01;
+        sofa::simpleapi::importPlugin("SofaComponentAll") ;
+        auto simulation = sofa::simpleapi::createSimulation();
+        Node::SPtr root = sofa::simpleapi::createRootNode(simulation, "root");
+        root->setGravity(Vec3(0.0,0.0,0.0));
+        root->setDt(dt);
+
+        Node::SPtr childNode = sofa::simpleapi::createChild(root, "Particle");
+
+        auto meca = sofa::simpleapi::createObject(childNode, "MechanicalObject",
+                                                  {{"size", "1"}});
+
+        auto readState = sofa::simpleapi::createObject(childNode, "ReadState",
+                                                       {{"filename", filename}});
+
+        simulation->init(root.get());
+        for(int i=0; i<7; i++)
+        {
+            simulation->animate(root.get(), dt);
+        }
+
+        EXPECT_TRUE(dynamic_cast<ReadState*>(readState.get())->isBinary());
+        EXPECT_EQ(meca->findData("position")->getValueString(),
+                  std::string("0 0 -0.017658"));
+
+        dynamic_cast<ReadState*>(readState.get())->processReadState(0.02);
+        EXPECT_EQ(meca->findData("position")->getValueString(),
+                  std::string("0 0 -0.001962"));
+        return true;
+    }
+
     /// Run seven steps of simulation then check results
     bool testLoadFailure()
     {
@@ -89,6 +131,12 @@ TEST_F(ReadState_test , test_defaultBehavior)
     ASSERT_TRUE( this->testDefaultBehavior() );
 }
 
+/// Test : read positions from a binary recording and seek in it
+TEST_F(ReadState_test , test_binaryBehavior)
+{
+    ASSERT_TRUE( this->testBinaryBehavior() );
+}
+
 /// Test : when happens when unable to load the file ?
 TEST_F(ReadState_test , test_loadFailure)
 {
@@ -0,0 +1,180 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2019 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#include <SofaGeneralLoader/StateRecordFile.h>
+using sofa::component::misc::StateRecordFile;
+using sofa::component::misc::StateRecordWriter;
+using sofa::component::misc::StateRecordReader;
+
+#include <sofa/helper/testing/BaseTest.h>
+using sofa::helper::testing::BaseTest;
+
+#include <sofa/helper/RandomGenerator.h>
+
+#include <cmath>
+
+namespace
+{
+
+class StateRecordFile_test : public BaseTest
+{
+public:
+    /// Values recorded for each frame, the velocity only being written on even frames
+    std::vector< std::vector<SReal> > positions;
+    std::vector< std::vector<SReal> > velocities;
+
+    std::string filename(const std::string& name) const
+    {
+        return std::string(SOFAGENERALLOADER_BUILD_DIR) + name;
+    }
+
+    void writeFrames(StateRecordWriter& writer, size_t nbFrames)
+    {
+        sofa::helper::RandomGenerator random(42);
+        positions.resize(nbFrames);
+        velocities.resize(nbFrames);
+        for (size_t f=0; f<nbFrames; ++f)
+        {
+            positions[f].resize(3*(100+f));
+            for (SReal& v : positions[f])
+                v = random.random<double>(-1.0, 1.0);
+            velocities[f].assign(positions[f].size(), (SReal)f);
+
+            writer.beginFrame(0.01*f);
+            writer.addVector(StateRecordFile::POSITION, positions[f].data(), positions[f].size());
+            if (f%2 == 0)
+                writer.addVector(StateRecordFile::VELOCITY, velocities[f].data(), velocities[f].size());
+            ASSERT_TRUE(writer.endFrame());
+        }
+    }
+
+    void checkFrames(const StateRecordReader& reader, double tolerance)
+    {
+        ASSERT_EQ(reader.getNbFrames(), positions.size());
+        StateRecordReader::Frame frame;
+        for (size_t f=0; f<positions.size(); ++f)
+        {
+            ASSERT_TRUE(reader.readFrame(f, frame));
+            EXPECT_DOUBLE_EQ(frame.time, 0.01*f);
+            ASSERT_TRUE(frame.present[StateRecordFile::POSITION]);
+            EXPECT_FALSE(frame.present[StateRecordFile::REST_POSITION]);
+            EXPECT_FALSE(frame.present[StateRecordFile::FORCE]);
+            EXPECT_EQ(frame.present[StateRecordFile::VELOCITY], f%2 == 0);
+
+            const sofa::helper::vector<SReal>& x = frame.values[StateRecordFile::POSITION];
+            ASSERT_EQ(x.size(), positions[f].size());
+            for (size_t i=0; i<x.size(); ++i)
+                EXPECT_NEAR(x[i], positions[f][i], tolerance);
+            if (f%2 == 0)
+            {
+                EXPECT_EQ(frame.values[StateRecordFile::VELOCITY].size(), velocities[f].size());
+            }
+        }
+    }
+
+    void testRoundTrip(StateRecordFile::ScalarType scalarType, StateRecordFile::Compression compression, double tolerance)
+    {
+        const std::string file = filename("StateRecordFile_test.sstate");
+        {
+            StateRecordWriter writer;
+            ASSERT_TRUE(writer.open(file, scalarType, compression));
+            writeFrames(writer, 20);
+            ASSERT_TRUE(writer.close());
+        }
+
+        EXPECT_TRUE(StateRecordFile::isStateRecordFile(file));
+        StateRecordReader reader;
+        ASSERT_TRUE(reader.open(file));
+        EXPECT_EQ(reader.getScalarType(), scalarType);
+        checkFrames(reader, tolerance);
+    }
+};
+
+TEST_F(StateRecordFile_test, doubleRoundTrip)
+{
+    testRoundTrip(StateRecordFile::DOUBLE, StateRecordFile::NONE, 0.0);
+}
+
+TEST_F(StateRecordFile_test, floatRoundTrip)
+{
+    testRoundTrip(StateRecordFile::FLOAT, StateRecordFile::NONE, 1e-7);
+}
+
+TEST_F(StateRecordFile_test, compressedRoundTrip)
+{
+    testRoundTrip(StateRecordFile::DOUBLE, StateRecordFile::ZLIB, 0.0);
+}
+
+/// The frame found for a time is the last one recorded at or before it
+TEST_F(StateRecordFile_test, findFrame)
+{
+    testRoundTrip(StateRecordFile::DOUBLE, StateRecordFile::NONE, 0.0);
+    StateRecordReader reader;
+    ASSERT_TRUE(reader.open(filename("StateRecordFile_test.sstate")));
+    EXPECT_EQ(reader.findFrame(-1.0), -1);
+    EXPECT_EQ(reader.findFrame(0.0), 0);
+    EXPECT_EQ(reader.findFrame(0.055), 5);
+    EXPECT_EQ(reader.findFrame(0.19), 19);
+    EXPECT_EQ(reader.findFrame(10.0), 19);
+}
+
+/// A recording which was not closed has no index and is read by walking its frames
+TEST_F(StateRecordFile_test, interruptedRecording)
+{
+    const std::string file = filename("StateRecordFile_interrupted.sstate");
+    StateRecordWriter writer;
+    ASSERT_TRUE(writer.open(file, StateRecordFile::DOUBLE, StateRecordFile::ZLIB));
+    writeFrames(writer, 5);
+
+    StateRecordReader reader;
+    ASSERT_TRUE(reader.open(file));
+    checkFrames(reader, 0.0);
+}
+
+TEST_F(StateRecordFile_test, convertFromText)
+{
+    const std::string file = filename("particleGravityX.sstate");
+    ASSERT_TRUE(StateRecordFile::convertFromText(std::string(SOFAGENERALLOADER_TESTFILES_DIR)+"particleGravityX.data", file));
+
+    StateRecordReader reader;
+    ASSERT_TRUE(reader.open(file));
+    ASSERT_EQ(reader.getNbFrames(), 7u);
+
+    StateRecordReader::Frame frame;
+    ASSERT_TRUE(reader.readFrame(6, frame));
+    EXPECT_DOUBLE_EQ(frame.time, 0.06);
+    ASSERT_TRUE(frame.present[StateRecordFile::POSITION]);
+    EXPECT_FALSE(frame.present[StateRecordFile::VELOCITY]);
+    ASSERT_EQ(frame.values[StateRecordFile::POSITION].size(), 3u);
+    EXPECT_DOUBLE_EQ(frame.values[StateRecordFile::POSITION][2], -0.017658);
+
+    EXPECT_FALSE(StateRecordFile::convertFromText(std::string(SOFAGENERALLOADER_TESTFILES_DIR)+"invalidFile.txt", file));
+}
+
+TEST_F(StateRecordFile_test, invalidFile)
+{
+    StateRecordReader reader;
+    EXPECT_FALSE(reader.open(std::string(SOFAGENERALLOADER_TESTFILES_DIR)+"particleGravityX.data"));
+    EXPECT_FALSE(reader.isOpen());
+    EXPECT_FALSE(StateRecordFile::isStateRecordFile(std::string(SOFAGENERALLOADER_TESTFILES_DIR)+"particleGravityX.data"));
+}
+
+} // namespace
@@ -0,0 +1,471 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2019 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#include <SofaGeneralLoader/StateRecordFile.h>
+
+#if SOFAGENERALLOADER_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+
+namespace sofa
+{
+
+namespace component
+{
+
+namespace misc
+{
+
+namespace
+{
+
+const char magic[8] = { 'S','O','F','A','S','T','A','T' };
+const uint32_t version = 1;
+
+/// magic, version, scalar type, compression, reserved, index offset, number of frames
+const size_t headerSize = 8 + 4*4 + 8 + 8;
+const size_t indexOffsetPosition = 8 + 4*4;
+/// time, raw payload size, stored payload size, flags, reserved
+const size_t chunkHeaderSize = 8 + 4*4;
+/// time, chunk offset
+const size_t indexEntrySize = 8 + 8;
+
+enum ChunkFlags { CHUNK_DEFLATED = 1 };
+
+template<class T>
+void append(std::vector<char>& buffer, const T& value)
+{
+    const char* p = reinterpret_cast<const char*>(&value);
+    buffer.insert(buffer.end(), p, p+sizeof(T));
+}
+
+template<class T>
+void write(std::ofstream& file, const T& value)
+{
+    file.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template<class T>
+T get(const char* p)
+{
+    T value;
+    std::memcpy(&value, p, sizeof(T));
+    return value;
+}
+
+template<class TScalar>
+void decodeValues(const char* p, size_t size, helper::vector<SReal>& values)
+{
+    values.resize(size);
+    for (size_t i=0; i<size; ++i)
+        values[i] = (SReal)get<TScalar>(p + i*sizeof(TScalar));
+}
+
+} // anonymous namespace
+
+const char* StateRecordFile::getVectorName(Vector v)
+{
+    switch (v)
+    {
+    case POSITION: return "X";
+    case REST_POSITION: return "X0";
+    case VELOCITY: return "V";
+    case FORCE: return "F";
+    default: return "";
+    }
+}
+
+bool StateRecordFile::isStateRecordFile(const std::string& filename)
+{
+    std::ifstream file(filename.c_str(), std::ifstream::binary);
+    char buffer[sizeof(magic)];
+    if (!file.read(buffer, sizeof(magic)))
+        return false;
+    return std::equal(buffer, buffer+sizeof(magic), magic);
+}
+
+bool StateRecordFile::convertFromText(const std::string& textFilename, const std::string& binaryFilename,
+                                      ScalarType scalarType, Compression compression)
+{
+#if SOFAGENERALLOADER_HAVE_ZLIB
+    gzFile gzfile = nullptr;
+    if (textFilename.size() >= 3 && textFilename.substr(textFilename.size()-3)==".gz")
+    {
+        gzfile = gzopen(textFilename.c_str(),"rb");
+        if (!gzfile)
+            return false;
+    }
+#endif
+    std::ifstream infile;
+#if SOFAGENERALLOADER_HAVE_ZLIB
+    if (!gzfile)
+#endif
+    {
+        infile.open(textFilename.c_str());
+        if (!infile.is_open())
+            return false;
+    }
+
+    /// Returns the next line of the text file, without its end of line character
+    auto getLine = [&](std::string& line) -> bool
+    {
+#if SOFAGENERALLOADER_HAVE_ZLIB
+        if (gzfile)
+        {
+            line.clear();
+            char buf[4097];
+            while (gzgets(gzfile,buf,sizeof(buf))!=nullptr)
+            {
+                size_t l = strlen(buf);
+                if (l && buf[l-1] == '\n')
+                {
+                    buf[l-1] = '\0';
+                    line += buf;
+                    return true;
+                }
+                line += buf;
+            }
+            return !line.empty();
+        }
+#endif
+        return (bool)getline(infile, line);
+    };
+
+    StateRecordWriter writer;
+    bool good = writer.open(binaryFilename, scalarType, compression);
+
+    /// Each frame is written as soon as the next one begins, so that only one frame is kept in memory
+    bool inFrame = false;
+    std::string line;
+    std::vector<SReal> values;
+    while (good && getLine(line))
+    {
+        std::istringstream str(line);
+        std::string cmd;
+        if (!(str >> cmd))
+            continue;
+        if (cmd == "T=")
+        {
+            double time = 0;
+            str >> time;
+            if (inFrame && !writer.endFrame())
+                good = false;
+            writer.beginFrame(time);
+            inFrame = true;
+            continue;
+        }
+
+        Vector v;
+        if (cmd == "X=") v = POSITION;
+        else if (cmd == "X0=") v = REST_POSITION;
+        else if (cmd == "V=") v = VELOCITY;
+        else if (cmd == "F=") v = FORCE;
+        else continue;
+        if (!inFrame)
+            continue;
+
+        values.clear();
+        SReal value;
+        while (str >> value)
+            values.push_back(value);
+        writer.addVector(v, values.data(), values.size());
+    }
+
+#if SOFAGENERALLOADER_HAVE_ZLIB
+    if (gzfile)
+        gzclose(gzfile);
+#endif
+    if (good && inFrame && !writer.endFrame())
+        good = false;
+    return writer.close() && good;
+}
+
+
+StateRecordWriter::StateRecordWriter()
+    : m_scalarType(StateRecordFile::DOUBLE)
+    , m_compression(StateRecordFile::NONE)
+    , m_frameTime(0)
+{
+}
+
+StateRecordWriter::~StateRecordWriter()
+{
+    close();
+}
+
+bool StateRecordWriter::open(const std::string& filename, StateRecordFile::ScalarType scalarType, StateRecordFile::Compression compression)
+{
+    close();
+    m_scalarType = scalarType;
+    m_compression = compression;
+#if !SOFAGENERALLOADER_HAVE_ZLIB
+    m_compression = StateRecordFile::NONE;
+#endif
+    m_times.clear();
+    m_offsets.clear();
+
+    m_file.open(filename.c_str(), std::ofstream::binary | std::ofstream::trunc);
+    if (!m_file.is_open())
+        return false;
+
+    m_file.write(magic, sizeof(magic));
+    write(m_file, version);
+    write(m_file, (uint32_t)m_scalarType);
+    write(m_file, (uint32_t)m_compression);
+    write(m_file, (uint32_t)0);
+    write(m_file, (uint64_t)0);
+    write(m_file, (uint64_t)0);
+    return m_file.good();
+}
+
+void StateRecordWriter::beginFrame(double time)
+{
+    m_frameTime = time;
+    m_payload.clear();
+}
+
+void StateRecordWriter::addVector(StateRecordFile::Vector v, const SReal* values, size_t size)
+{
+    append(m_payload, (uint32_t)v);
+    append(m_payload, (uint32_t)size);
+    if (m_scalarType == StateRecordFile::FLOAT)
+    {
+        for (size_t i=0; i<size; ++i)
+            append(m_payload, (float)values[i]);
+    }
+    else
+    {
+        for (size_t i=0; i<size; ++i)
+            append(m_payload, (double)values[i]);
+    }
+}
+
+bool StateRecordWriter::endFrame()
+{
+    if (!m_file.is_open())
+        return false;
+
+    const char* stored = m_payload.data();
+    size_t storedSize = m_payload.size();
+    uint32_t flags = 0;
+#if SOFAGENERALLOADER_HAVE_ZLIB
+    if (m_compression == StateRecordFile::ZLIB && !m_payload.empty())
+    {
+        uLongf compressedSize = compressBound((uLong)m_payload.size());
+        m_compressed.resize(compressedSize);
+        if (compress2(reinterpret_cast<Bytef*>(m_compressed.data()), &compressedSize,
+                      reinterpret_cast<const Bytef*>(m_payload.data()), (uLong)m_payload.size(), Z_BEST_SPEED) == Z_OK
+            && compressedSize < m_payload.size())
+        {
+            stored = m_compressed.data();
+            storedSize = compressedSize;
+            flags |= CHUNK_DEFLATED;
+        }
+    }
+#endif
+
+    m_times.push_back(m_frameTime);
+    m_offsets.push_back((uint64_t)m_file.tellp());
+    write(m_file, m_frameTime);
+    write(m_file, (uint32_t)m_payload.size());
+    write(m_file, (uint32_t)storedSize);
+    write(m_file, flags);
+    write(m_file, (uint32_t)0);
+    m_file.write(stored, storedSize);
+    m_file.flush();
+    return m_file.good();
+}
+
+bool StateRecordWriter::close()
+{
+    if (!m_file.is_open())
+        return false;
+
+    const uint64_t indexOffset = (uint64_t)m_file.tellp();
+    for (size_t i=0; i<m_times.size(); ++i)
+    {
+        write(m_file, m_times[i]);
+        write(m_file, m_offsets[i]);
+    }
+    m_file.seekp(indexOffsetPosition);
+    write(m_file, indexOffset);
+    write(m_file, (uint64_t)m_times.size());
+    const bool good = m_file.good();
+    m_file.close();
+    return good;
+}
+
+
+StateRecordReader::StateRecordReader()
+    : m_data(nullptr)
+    , m_size(0)
+    , m_scalarType(StateRecordFile::DOUBLE)
+    , m_compression(StateRecordFile::NONE)
+{
+}
+
+StateRecordReader::~StateRecordReader()
+{
+    close();
+}
+
+void StateRecordReader::close()
+{
+    m_file.close();
+    m_data = nullptr;
+    m_size = 0;
+    m_times.clear();
+    m_offsets.clear();
+}
+
+bool StateRecordReader::open(const std::string& filename)
+{
+    close();
+
+    if (!m_file.open(filename, helper::io::MappedFile::Random))
+        return false;
+    m_data = m_file.begin();
+    m_size = m_file.size();
+
+    if (m_size < headerSize || !std::equal(m_data, m_data+sizeof(magic), magic)
+            || get<uint32_t>(m_data+8) != version)
+    {
+        close();
+        return false;
+    }
+    m_scalarType = (StateRecordFile::ScalarType)get<uint32_t>(m_data+12);
+    m_compression = (StateRecordFile::Compression)get<uint32_t>(m_data+16);
+    if (m_scalarType != StateRecordFile::DOUBLE && m_scalarType != StateRecordFile::FLOAT)
+    {
+        close();
+        return false;
+    }
+
+    if (!buildIndex())
+    {
+        close();
+        return false;
+    }
+    return true;
+}
+
+bool StateRecordReader::buildIndex()
+{
+    const uint64_t indexOffset = get<uint64_t>(m_data+indexOffsetPosition);
+    const uint64_t nbFrames = get<uint64_t>(m_data+indexOffsetPosition+8);
+    if (indexOffset >= headerSize && indexOffset <= m_size
+            && nbFrames <= (m_size - indexOffset) / indexEntrySize)
+    {
+        m_times.resize(nbFrames);
+        m_offsets.resize(nbFrames);
+        const char* p = m_data + indexOffset;
+        for (size_t i=0; i<nbFrames; ++i, p+=indexEntrySize)
+        {
+            m_times[i] = get<double>(p);
+            m_offsets[i] = get<uint64_t>(p+8);
+            if (m_offsets[i] + chunkHeaderSize > indexOffset)
+                return false;
+        }
+        return true;
+    }
+
+    // the recording was interrupted before the index was written: walk the chunks
+    size_t offset = headerSize;
+    while (offset + chunkHeaderSize <= m_size)
+    {
+        const size_t storedSize = get<uint32_t>(m_data+offset+12);
+        if (offset + chunkHeaderSize + storedSize > m_size)
+            break;
+        m_times.push_back(get<double>(m_data+offset));
+        m_offsets.push_back(offset);
+        offset += chunkHeaderSize + storedSize;
+    }
+    return true;
+}
+
+int StateRecordReader::findFrame(double time) const
+{
+    std::vector<double>::const_iterator it = std::upper_bound(m_times.begin(), m_times.end(), time);
+    return (int)(it - m_times.begin()) - 1;
+}
+
+bool StateRecordReader::readFrame(size_t frame, Frame& result) const
+{
+    if (frame >= m_offsets.size())
+        return false;
+
+    const char* chunk = m_data + m_offsets[frame];
+    const size_t rawSize = get<uint32_t>(chunk+8);
+    const size_t storedSize = get<uint32_t>(chunk+12);
+    const uint32_t flags = get<uint32_t>(chunk+16);
+    if (m_offsets[frame] + chunkHeaderSize + storedSize > m_size)
+        return false;
+
+    result.time = get<double>(chunk);
+    std::fill(result.present, result.present+StateRecordFile::NB_VECTORS, false);
+
+    const char* payload = chunk + chunkHeaderSize;
+    std::vector<char> inflated;
+    if (flags & CHUNK_DEFLATED)
+    {
+#if SOFAGENERALLOADER_HAVE_ZLIB
+        inflated.resize(rawSize);
+        uLongf size = (uLongf)rawSize;
+        if (uncompress(reinterpret_cast<Bytef*>(inflated.data()), &size,
+                       reinterpret_cast<const Bytef*>(payload), (uLong)storedSize) != Z_OK || size != rawSize)
+            return false;
+        payload = inflated.data();
+#else
+        return false;
+#endif
+    }
+    else if (storedSize != rawSize)
+        return false;
+
+    const size_t scalarSize = (m_scalarType == StateRecordFile::FLOAT) ? sizeof(float) : sizeof(double);
+    const char* p = payload;
+    const char* end = payload + rawSize;
+    while (p + 8 <= end)
+    {
+        const uint32_t v = get<uint32_t>(p);
+        const size_t size = get<uint32_t>(p+4);
+        p += 8;
+        if (v >= StateRecordFile::NB_VECTORS || size > (size_t)(end - p) / scalarSize)
+            return false;
+        if (m_scalarType == StateRecordFile::FLOAT)
+            decodeValues<float>(p, size, result.values[v]);
+        else
+            decodeValues<double>(p, size, result.values[v]);
+        result.present[v] = true;
+        p += size * scalarSize;
+    }
+    return true;
+}
+
+} // namespace misc
+
+} // namespace component
+
+} // namespace sofa
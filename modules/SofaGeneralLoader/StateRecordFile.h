@@ -0,0 +1,151 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2019 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#ifndef SOFA_COMPONENT_MISC_STATERECORDFILE_H
+#define SOFA_COMPONENT_MISC_STATERECORDFILE_H
+#include <SofaGeneralLoader/config.h>
+
+#include <sofa/helper/vector.h>
+#include <sofa/helper/io/MappedFile.h>
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+
+namespace sofa
+{
+
+namespace component
+{
+
+namespace misc
+{
+
+/** Binary state recording format shared by WriteState and ReadState.
+ *
+ * The file starts with a fixed header (magic, version, scalar size, compression
+ * and the offset of the frame index), followed by one chunk per recorded frame.
+ * Each chunk stores its time and a payload holding the recorded vectors, which
+ * may be deflated independently of the other frames. The frame index (time and
+ * offset of every chunk) is appended when the file is closed, so that a reader
+ * can seek to any time without parsing the frames in between. A file whose
+ * writer did not close it properly is still readable: the index is then rebuilt
+ * by walking the chunks.
+*/
+class SOFA_GENERAL_LOADER_API StateRecordFile
+{
+public:
+    enum ScalarType { DOUBLE=0, FLOAT=1 };
+    enum Compression { NONE=0, ZLIB=1 };
+    /// Recorded vectors, in the order they are written in a frame
+    enum Vector { POSITION=0, REST_POSITION=1, VELOCITY=2, FORCE=3, NB_VECTORS=4 };
+
+    static const char* getVectorName(Vector v);
+
+    /// Check the magic number at the beginning of the file
+    static bool isStateRecordFile(const std::string& filename);
+
+    /// Convert a text file written by WriteState (optionally gzipped) to the binary format
+    static bool convertFromText(const std::string& textFilename, const std::string& binaryFilename,
+                                ScalarType scalarType=DOUBLE, Compression compression=NONE);
+};
+
+/// Sequential writer of binary state recordings
+class SOFA_GENERAL_LOADER_API StateRecordWriter
+{
+public:
+    StateRecordWriter();
+    ~StateRecordWriter();
+
+    bool open(const std::string& filename,
+              StateRecordFile::ScalarType scalarType=StateRecordFile::DOUBLE,
+              StateRecordFile::Compression compression=StateRecordFile::NONE);
+    bool isOpen() const { return m_file.is_open(); }
+
+    void beginFrame(double time);
+    void addVector(StateRecordFile::Vector v, const SReal* values, size_t size);
+    /// Write the frame chunk and flush it, so that an interrupted recording stays readable
+    bool endFrame();
+
+    /// Append the frame index and close the file
+    bool close();
+
+    size_t getNbFrames() const { return m_times.size(); }
+
+protected:
+    std::ofstream m_file;
+    StateRecordFile::ScalarType m_scalarType;
+    StateRecordFile::Compression m_compression;
+    double m_frameTime;
+    std::vector<char> m_payload;
+    std::vector<char> m_compressed;
+    std::vector<double> m_times;
+    std::vector<uint64_t> m_offsets;
+};
+
+/// Random access reader of binary state recordings, memory-mapping the file when possible
+class SOFA_GENERAL_LOADER_API StateRecordReader
+{
+public:
+    /// Content of one decoded frame
+    struct Frame
+    {
+        double time;
+        bool present[StateRecordFile::NB_VECTORS];
+        helper::vector<SReal> values[StateRecordFile::NB_VECTORS];
+    };
+
+    StateRecordReader();
+    ~StateRecordReader();
+
+    bool open(const std::string& filename);
+    void close();
+    bool isOpen() const { return m_data != nullptr; }
+
+    size_t getNbFrames() const { return m_times.size(); }
+    double getFrameTime(size_t frame) const { return m_times[frame]; }
+    StateRecordFile::ScalarType getScalarType() const { return m_scalarType; }
+    StateRecordFile::Compression getCompression() const { return m_compression; }
+
+    /// Index of the last frame recorded at or before the given time, -1 if there is none
+    int findFrame(double time) const;
+
+    bool readFrame(size_t frame, Frame& result) const;
+
+protected:
+    bool buildIndex();
+
+    helper::io::MappedFile m_file;
+    const char* m_data;
+    size_t m_size;
+    StateRecordFile::ScalarType m_scalarType;
+    StateRecordFile::Compression m_compression;
+    std::vector<double> m_times;
+    std::vector<uint64_t> m_offsets;
+};
+
+} // namespace misc
+
+} // namespace component
+
+} // namespace sofa
+
+#endif
@@ -26,6 +26,7 @@
 #include <SofaHaptics/MechanicalStateForceFeedback.h>
 #include <sofa/core/behavior/MechanicalState.h>
 #include <sofa/helper/system/thread/CTime.h>
+#include <atomic>
 #include <mutex>
 
 namespace sofa
@@ -127,14 +128,28 @@ public:
 
 protected:
     core::behavior::MechanicalState<DataTypes> *mState; ///< The device try to follow this mechanical state.
+
+    /// Triple buffer of the constraint problem snapshots exchanged between the simulation and haptic threads.
+    /// Each buffer is owned either by the simulation thread, which fills it, by the haptic thread, which reads it,
+    /// or is the last one published. Ownership is exchanged with a single atomic operation, so that neither thread
+    /// ever waits for the other.
     VecCoord mVal[3];
     MatrixDeriv mConstraints[3];
     std::vector<int> mId_buf[3];
     component::constraintset::ConstraintProblem* mCP[3];
 
-    unsigned char mNextBufferId; // Next buffer id to be use
-    unsigned char mCurBufferId; // Current buffer id in use
-    bool mIsCuBufferInUse; // Is current buffer currently in use right now
+    /// Set on mNextBufferId when the published buffer has not been read by the haptic thread yet
+    static const unsigned char FreshBufferFlag = 0x4;
+    static const unsigned char BufferIdMask = 0x3;
+
+    std::atomic<unsigned char> mNextBufferId; // Last buffer published by the simulation thread
+    unsigned char mCurBufferId; // Current buffer id in use by the haptic thread
+    unsigned char mWriteBufferId; // Buffer id filled by the simulation thread
+
+    /// Buffers of the haptic thread, kept between calls to avoid allocations in the haptic loop
+    VecDeriv mDx;
+    VecDeriv mTempForces;
+    VecDeriv mLastForces; ///< forces returned when the computation is locked by another thread
 
     sofa::component::constraintset::ConstraintSolverImpl* constraintSolver;
 
@@ -146,6 +161,7 @@ protected:
     unsigned int num_constraints;
 
     /// mutex used in method @doComputeForce which can be touched from outside using method @sa setLock if components are modified in another thread.
+    /// The haptic thread does not wait for it: the last computed forces are used while it is locked.
     std::mutex lockForce;
 };
 
@@ -133,9 +133,9 @@ LCPForceFeedback<DataTypes>::LCPForceFeedback()
     , d_derivRotations(initData(&d_derivRotations, false, "derivRotations", "if true, deriv the rotations when updating the violations"))
     , d_localHapticConstraintAllFrames(initData(&d_localHapticConstraintAllFrames, false, "localHapticConstraintAllFrames", "Flag to enable/disable constraint haptic influence from all frames"))
     , mState(nullptr)
-    , mNextBufferId(0)
+    , mNextBufferId(1)
     , mCurBufferId(0)
-    , mIsCuBufferInUse(false)
+    , mWriteBufferId(2)
     , constraintSolver(nullptr)
     , _timer(nullptr)
     , time_buf(0)
@@ -198,11 +198,18 @@ void LCPForceFeedback<DataTypes>::computeForce(const VecCoord& state,  VecDeriv&
         return;
     }
     updateStats();
-    
-    lockForce.lock(); // check if computation has not been locked using setLock method.
+
+    if (!lockForce.try_lock()) // check if computation has not been locked using setLock method.
+    {
+        forces = mLastForces;
+        forces.resize(state.size());
+        return;
+    }
     updateConstraintProblem();
-    doComputeForce(state, forces);    
+    doComputeForce(state, forces);
     lockForce.unlock();
+
+    mLastForces = forces;
 }
 template <class DataTypes>
 void LCPForceFeedback<DataTypes>::updateStats()
@@ -222,28 +229,15 @@ void LCPForceFeedback<DataTypes>::updateStats()
 template <class DataTypes>
 bool LCPForceFeedback<DataTypes>::updateConstraintProblem()
 {
-    int prevId = mCurBufferId;
-
     //
-    // Retrieve the last LCP and constraints computed by the Sofa thread.
+    // Retrieve the last LCP and constraints computed by the Sofa thread, if not already done.
+    // The published buffer is exchanged with the current one, which the Sofa thread may reuse.
     //
-    mIsCuBufferInUse = true;
-
-    {
-        // TODO: Lock and/or memory barrier HERE
-        mCurBufferId = mNextBufferId;
-    }
-
-    bool changed = (prevId != mCurBufferId);
-
-    component::constraintset::ConstraintProblem* cp = mCP[mCurBufferId];
-
-    if(!cp)
-    {
-        mIsCuBufferInUse = false;
-    }
+    if (!(mNextBufferId.load() & FreshBufferFlag))
+        return false;
 
-    return changed;
+    mCurBufferId = mNextBufferId.exchange(mCurBufferId) & BufferIdMask;
+    return true;
 }
 
 template <class DataTypes>
@@ -270,7 +264,7 @@ void LCPForceFeedback<DataTypes>::doComputeForce(const VecCoord& state,  VecDeri
 
     if(!constraints.empty())
     {
-        VecDeriv dx;
+        VecDeriv& dx = mDx;
 
         derivVectors< DataTypes >(val, state, dx, d_derivRotations.getValue());
 
@@ -308,7 +302,8 @@ void LCPForceFeedback<DataTypes>::doComputeForce(const VecCoord& state,  VecDeri
             }
         }
 
-        VecDeriv tempForces;
+        VecDeriv& tempForces = mTempForces;
+        tempForces.clear();
         tempForces.resize(val.size());
 
         for (MatrixDerivRowConstIterator rowIt = constraints.begin(); rowIt != rowItEnd; ++rowIt)
@@ -349,17 +344,8 @@ void LCPForceFeedback<DataTypes>::handleEvent(sofa::core::objectmodel::Event *ev
     if (!new_cp)
         return;
 
-    // Find available buffer
-
-    unsigned char buf_index=0;
-    unsigned char cbuf_index=mCurBufferId;
-    unsigned char nbuf_index=mNextBufferId;
-
-    if (buf_index == cbuf_index || buf_index == nbuf_index)
-        buf_index++;
-
-    if (buf_index == cbuf_index || buf_index == nbuf_index)
-        buf_index++;
+    // Fill the buffer owned by the Sofa thread
+    const unsigned char buf_index = mWriteBufferId;
 
     // Compute constraints, id_buf lcp and val for the current lcp.
 
@@ -387,18 +373,11 @@ void LCPForceFeedback<DataTypes>::handleEvent(sofa::core::objectmodel::Event *ev
         constraints.addLine(rowIt.index(), rowIt.row());
     }
 
-    // valid buffer
-
-    {
-        // TODO: Lock and/or memory barrier HERE
-        mNextBufferId = buf_index;
-    }
+    // Publish the buffer, and get back the previously published one if the haptic thread did not take it
+    mWriteBufferId = mNextBufferId.exchange(buf_index | FreshBufferFlag) & BufferIdMask;
 
-    // Lock lcp to prevent its use by the SOFA thread while it is used by haptic thread
-    if(mIsCuBufferInUse)
-        constraintSolver->lockConstraintProblem(this, mCP[mCurBufferId], mCP[mNextBufferId]);
-    else
-        constraintSolver->lockConstraintProblem(this, mCP[mNextBufferId]);
+    // Lock the lcps of the two other buffers to prevent their use by the SOFA thread: the haptic thread may be using either of them
+    constraintSolver->lockConstraintProblem(this, mCP[(mWriteBufferId + 1) % 3], mCP[(mWriteBufferId + 2) % 3]);
 }
 
 
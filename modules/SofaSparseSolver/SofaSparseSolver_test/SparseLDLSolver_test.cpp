@@ -0,0 +1,200 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2019 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#include <SofaSparseSolver/SparseLDLSolver.h>
+using sofa::component::linearsolver::SparseLDLSolver ;
+using sofa::component::linearsolver::CompressedRowSparseMatrix ;
+using sofa::component::linearsolver::FullVector ;
+
+#include <SofaTest/Sofa_test.h>
+
+#include <random>
+
+namespace
+{
+
+typedef CompressedRowSparseMatrix<double> Matrix;
+typedef FullVector<double> Vector;
+typedef SparseLDLSolver<Matrix,Vector> Solver;
+
+class SparseLDLSolver_test : public sofa::Sofa_test<>
+{
+public:
+    /// Stiffness-like matrix of a n^3 grid of 3D nodes linked to their neighbors, symmetric positive definite
+    static void buildGridMatrix(Matrix& M, int n)
+    {
+        const double B[3][3] = {{2.0,0.5,0.1},{0.5,2.0,0.3},{0.1,0.3,2.0}};
+        const int nbNodes = n*n*n;
+        M.resize(3*nbNodes,3*nbNodes);
+
+        for (int z=0; z<n; z++)
+            for (int y=0; y<n; y++)
+                for (int x=0; x<n; x++)
+                {
+                    const int a = (z*n+y)*n+x;
+                    const int neighbors[3] = { x+1<n ? a+1 : -1, y+1<n ? a+n : -1, z+1<n ? a+n*n : -1 };
+                    for (int b : neighbors)
+                    {
+                        if (b < 0) continue;
+                        addSpring(M, a, b, B, 1.0);
+                    }
+                    for (int i=0; i<3; i++) M.add(3*a+i,3*a+i,0.1);
+                }
+        M.compress();
+    }
+
+    template<class TBlock>
+    static void addSpring(Matrix& M, int a, int b, const TBlock& B, double k)
+    {
+        for (int i=0; i<3; i++)
+            for (int j=0; j<3; j++)
+            {
+                M.add(3*a+i,3*a+j, k*B[i][j]);
+                M.add(3*b+i,3*b+j, k*B[i][j]);
+                M.add(3*a+i,3*b+j,-k*B[i][j]);
+                M.add(3*b+i,3*a+j,-k*B[i][j]);
+            }
+    }
+
+    Solver::SPtr createSolver(bool supernodal)
+    {
+        Solver::SPtr solver = sofa::core::objectmodel::New<Solver>();
+        solver->d_supernodal.setValue(supernodal);
+        return solver;
+    }
+
+    static Vector randomVector(int n)
+    {
+        std::mt19937 generator(42);
+        std::uniform_real_distribution<double> distribution(-1.0,1.0);
+        Vector v(n);
+        for (int i=0; i<n; i++) v[i] = distribution(generator);
+        return v;
+    }
+
+    /// infinity norm of M x - b
+    static double residual(const Matrix& M, const Vector& x, const Vector& b)
+    {
+        double r = 0;
+        for (int i=0; i<(int)M.rowSize(); i++)
+        {
+            double Mx = 0;
+            for (int j=0; j<(int)M.colSize(); j++) Mx += M.element(i,j) * x[j];
+            r = std::max(r, std::abs(Mx - b[i]));
+        }
+        return r;
+    }
+
+    Vector solve(Solver* solver, Matrix& M, const Vector& b)
+    {
+        Vector x(M.rowSize());
+        Vector r = b;
+        solver->invert(M);
+        solver->solve(M, x, r);
+        return x;
+    }
+
+    void checkSolve(bool supernodal)
+    {
+        Matrix M;
+        buildGridMatrix(M, 5);
+        const Vector b = randomVector(M.rowSize());
+
+        Solver::SPtr solver = createSolver(supernodal);
+        const Vector x = solve(solver.get(), M, b);
+
+        EXPECT_LT(residual(M, x, b), 1e-10);
+    }
+
+    void checkSupernodalMatchesSimplicial()
+    {
+        Matrix M;
+        buildGridMatrix(M, 6);
+        const Vector b = randomVector(M.rowSize());
+
+        Solver::SPtr simplicial = createSolver(false);
+        Solver::SPtr supernodal = createSolver(true);
+        const Vector x0 = solve(simplicial.get(), M, b);
+        const Vector x1 = solve(supernodal.get(), M, b);
+
+        for (int i=0; i<(int)x0.size(); i++)
+            EXPECT_NEAR(x0[i], x1[i], 1e-10);
+    }
+
+    /// A pattern that comes back after a change reuses its ordering, and gives the same solution
+    void checkSymbolicCache(bool supernodal)
+    {
+        Matrix A, B;
+        buildGridMatrix(A, 4);
+        buildGridMatrix(B, 4);
+        const double I[3][3] = {{1,0,0},{0,1,0},{0,0,1}};
+        addSpring(B, 0, 63, I, 0.5); // like a contact between two opposite corners
+        B.compress();
+
+        const Vector b = randomVector(A.rowSize());
+
+        Solver::SPtr solver = createSolver(supernodal);
+        Solver::InvertData* data = (Solver::InvertData*) solver->getMatrixInvertData(&A);
+
+        const Vector xA = solve(solver.get(), A, b);
+        EXPECT_EQ(data->symbolicCache.size(), 1u);
+
+        const Vector xB = solve(solver.get(), B, b);
+        EXPECT_EQ(data->symbolicCache.size(), 2u);
+        EXPECT_LT(residual(B, xB, b), 1e-10);
+
+        const Vector xA2 = solve(solver.get(), A, b);
+        EXPECT_EQ(data->symbolicCache.size(), 2u);
+        for (int i=0; i<(int)xA.size(); i++)
+            EXPECT_EQ(xA[i], xA2[i]);
+
+        solver->d_symbolicCacheSize.setValue(1);
+        solve(solver.get(), B, b);
+        EXPECT_EQ(data->symbolicCache.size(), 1u);
+    }
+};
+
+TEST_F(SparseLDLSolver_test, solve)
+{
+    checkSolve(false);
+}
+
+TEST_F(SparseLDLSolver_test, solveSupernodal)
+{
+    checkSolve(true);
+}
+
+TEST_F(SparseLDLSolver_test, supernodalMatchesSimplicial)
+{
+    checkSupernodalMatchesSimplicial();
+}
+
+TEST_F(SparseLDLSolver_test, symbolicCache)
+{
+    checkSymbolicCache(false);
+}
+
+TEST_F(SparseLDLSolver_test, symbolicCacheSupernodal)
+{
+    checkSymbolicCache(true);
+}
+
+}
@@ -25,6 +25,10 @@
 
 #include <sofa/core/behavior/LinearSolver.h>
 #include <SofaBaseLinearSolver/MatrixLinearSolver.h>
+#include <Eigen/Core>
+#include <algorithm>
+#include <cstdint>
+#include <list>
 
 extern "C" {
 #include <metis.h>
@@ -39,6 +43,15 @@ namespace component
 namespace linearsolver
 {
 
+/// Ordering and symbolic factorization of a sparsity pattern, kept to be reused when this pattern comes back
+struct SparseLDLSymbolicFactorization
+{
+    std::uint64_t hash;
+    int n;
+    helper::vector<int> M_colptr, M_rowind; ///< the pattern itself, to confirm a hash match
+    helper::vector<int> perm, invperm, Parent, L_colptr;
+};
+
 //defaut structure for a LDL factorization
 template<class VecInt,class VecReal>
 class SparseLDLImplInvertData : public MatrixInvertData {
@@ -49,8 +62,22 @@ public :
     VecReal P_values,L_values,LT_values,invD;
     helper::vector<int> Parent;
     bool new_factorization_needed;
+    std::list<SparseLDLSymbolicFactorization> symbolicCache; ///< most recently used pattern first
+    helper::vector<int> superBegin; ///< first column of each supernode followed by n, empty when factorizing column by column
 };
 
+/// FNV-1a hash of a compressed sparsity pattern
+inline std::uint64_t CSPARSE_pattern_hash(int n,const int * M_colptr,const int * M_rowind)
+{
+    std::uint64_t h = 14695981039346656037ull;
+    auto mix = [&h](int v) { h ^= (std::uint32_t) v; h *= 1099511628211ull; };
+
+    mix(n);
+    for (int i = 0 ; i <= n ; i++) mix(M_colptr[i]);
+    for (int p = 0 ; p < M_colptr[n] ; p++) mix(M_rowind[p]);
+    return h;
+}
+
 inline void CSPARSE_symbolic (int n,int * M_colptr,int * M_rowind,int * colptr,int * perm,int * invperm,int * Parent, int * Flag, int * Lnz)
 {
     for (int k = 0 ; k < n ; k++)
@@ -81,6 +108,42 @@ inline void CSPARSE_symbolic (int n,int * M_colptr,int * M_rowind,int * colptr,i
     for (int k = 0 ; k < n ; k++) colptr[k+1] = colptr[k] + Lnz[k] ;
 }
 
+/// Fill rowind with the (sorted) row indices of each column of L, colptr and Parent being given by CSPARSE_symbolic
+inline void CSPARSE_symbolic_pattern(int n,int * M_colptr,int * M_rowind,int * colptr,int * rowind,int * perm,int * invperm,int * Parent, int * Flag, int * Lnz)
+{
+    for (int k = 0 ; k < n ; k++)
+    {
+        Flag [k] = k ;
+        Lnz [k] = 0 ;
+        int kk = perm[k];
+        for (int p = M_colptr[kk] ; p < M_colptr[kk+1] ; p++)
+        {
+            int i = invperm[M_rowind[p]];
+            if (i < k)
+            {
+                for ( ; Flag [i] != k ; i = Parent [i])
+                {
+                    rowind[colptr[i] + Lnz[i]++] = k ; /* L (k,i) is nonzero, rows are visited in increasing order */
+                    Flag [i] = k ;
+                }
+            }
+        }
+    }
+}
+
+/// Group the columns of L in fundamental supernodes : column j+1 extends the supernode of column j when it is its parent
+/// in the elimination tree and the pattern of column j is j+1 followed by the pattern of column j+1
+inline void CSPARSE_supernodes(int n,const int * colptr,const int * Parent,helper::vector<int> & superBegin)
+{
+    superBegin.clear();
+    for (int j = 0 ; j < n ; j++)
+    {
+        const bool extend = j > 0 && Parent[j-1] == j && colptr[j] - colptr[j-1] == colptr[j+1] - colptr[j] + 1;
+        if (!extend) superBegin.push_back(j);
+    }
+    superBegin.push_back(n);
+}
+
 template<class Real>
 inline void CSPARSE_numeric(int n,int * M_colptr,int * M_rowind,Real * M_values,int * colptr,int * rowind,Real * values,Real * D,int * perm,int * invperm,int * Parent, int * Flag, int * Lnz, int * Pattern, Real * Y)
 {
@@ -149,6 +212,128 @@ inline bool CSPARSE_need_symbolic_factorization(int s_M, int * M_colptr,int * M_
     return false;
 }
 
+/// Work arrays of CSPARSE_supernodal_numeric
+template<class Real>
+struct CSPARSE_supernodal_workspace
+{
+    typedef Eigen::Matrix<Real,Eigen::Dynamic,Eigen::Dynamic> DenseMatrix;
+
+    helper::vector<int> superOf, panelBegin, position;
+    helper::vector<Real> panels;
+    DenseMatrix LD, U;
+};
+
+/// Supernodal version of CSPARSE_numeric : the columns of each supernode are factorized as a dense panel,
+/// and the update of the ancestors is computed as dense matrix products (BLAS-3) instead of column by column.
+/// rowind must already contain the pattern of L (CSPARSE_symbolic_pattern), and superBegin the supernodes (CSPARSE_supernodes).
+template<class Real>
+inline void CSPARSE_supernodal_numeric(int n,int * M_colptr,int * M_rowind,Real * M_values,int * colptr,int * rowind,Real * values,Real * D,int * perm,int * invperm,const int * superBegin,int nbSuper, CSPARSE_supernodal_workspace<Real> & work)
+{
+    typedef typename CSPARSE_supernodal_workspace<Real>::DenseMatrix DenseMatrix;
+    typedef Eigen::Map<DenseMatrix,0,Eigen::OuterStride<> > PanelMap;
+    typedef Eigen::Map<const Eigen::Matrix<Real,Eigen::Dynamic,1> > DiagonalMap;
+
+    /* the panel of supernode s stores, column-major, the rows of its own columns followed by the rows of L below them */
+    work.superOf.resize(n);
+    work.panelBegin.resize(nbSuper+1);
+    work.panelBegin[0] = 0;
+    for (int s = 0 ; s < nbSuper ; s++)
+    {
+        const int f = superBegin[s], l = superBegin[s+1];
+        const int ld = (l - f) + colptr[l] - colptr[l-1];
+        for (int j = f ; j < l ; j++) work.superOf[j] = s;
+        work.panelBegin[s+1] = work.panelBegin[s] + ld * (l - f);
+    }
+    work.panels.clear();
+    work.panels.resize(work.panelBegin[nbSuper]);
+    work.position.resize(n);
+
+    /* scatter A(i,k), i <= k, into L(k,i) */
+    for (int k = 0 ; k < n ; k++)
+    {
+        const int kk = perm[k];
+        for (int p = M_colptr[kk] ; p < M_colptr[kk+1] ; p++)
+        {
+            const int i = invperm[M_rowind[p]];
+            if (i > k) continue;
+            const int s = work.superOf[i];
+            const int f = superBegin[s], l = superBegin[s+1];
+            const int ld = (l - f) + colptr[l] - colptr[l-1];
+            const int row = (k < l) ? k - f : (l - f) + int(std::lower_bound(rowind + colptr[l-1], rowind + colptr[l], k) - (rowind + colptr[l-1]));
+            work.panels[work.panelBegin[s] + (i - f) * ld + row] += M_values[p];
+        }
+    }
+
+    for (int s = 0 ; s < nbSuper ; s++)
+    {
+        const int f = superBegin[s], l = superBegin[s+1], w = l - f;
+        const int m = colptr[l] - colptr[l-1];
+        const int ld = w + m;
+        Real * P = &work.panels[work.panelBegin[s]];
+
+        /* dense LDL^T of the columns of the supernode */
+        for (int j = 0 ; j < w ; j++)
+        {
+            const Real d = P[j*ld + j];
+            if (d == 0.0)
+            {
+                msg_error("SparseLDLSolver") << "Failed to factorize, D(k,k) is zero" ;
+                return;
+            }
+            D[f+j] = d;
+            for (int i = j+1 ; i < ld ; i++) P[j*ld + i] /= d;
+            for (int jj = j+1 ; jj < w ; jj++)
+            {
+                const Real ljd = P[j*ld + jj] * d;
+                for (int i = jj ; i < ld ; i++) P[jj*ld + i] -= P[j*ld + i] * ljd;
+            }
+        }
+
+        /* copy the columns back in the compressed storage of L */
+        for (int j = 0 ; j < w ; j++)
+        {
+            for (int q = 0 ; q < ld - j - 1 ; q++) values[colptr[f+j] + q] = P[j*ld + j + 1 + q];
+        }
+
+        if (m == 0) continue;
+
+        /* update the ancestors, one block of rows per target supernode : L(R,C) -= Lo(R,:) D Lo(C,:)^T */
+        PanelMap Lo(P + w, m, w, Eigen::OuterStride<>(ld));
+        work.LD.noalias() = Lo * DiagonalMap(D + f, w).asDiagonal();
+        const int * rows = rowind + colptr[l-1];
+
+        for (int a = 0, b = 0 ; a < m ; a = b)
+        {
+            const int t = work.superOf[rows[a]];
+            for (b = a+1 ; b < m && work.superOf[rows[b]] == t ; b++) ;
+
+            const int ft = superBegin[t], lt = superBegin[t+1], wt = lt - ft;
+            const int ldt = wt + colptr[lt] - colptr[lt-1];
+            const int * rowsT = rowind + colptr[lt-1];
+            Real * Pt = &work.panels[work.panelBegin[t]];
+
+            /* rows of s below the columns of t are a subset of the rows of t */
+            for (int r = a, q = 0 ; r < m ; r++)
+            {
+                if (rows[r] < lt) work.position[r] = rows[r] - ft;
+                else
+                {
+                    while (rowsT[q] != rows[r]) q++;
+                    work.position[r] = wt + q;
+                }
+            }
+
+            work.U.noalias() = Lo.bottomRows(m - a) * work.LD.middleRows(a, b - a).transpose();
+
+            for (int c = a ; c < b ; c++)
+            {
+                Real * col = Pt + (rows[c] - ft) * ldt;
+                for (int r = c ; r < m ; r++) col[work.position[r]] -= work.U(r - a, c - a);
+            }
+        }
+    }
+}
+
 template<class TMatrix, class TVector, class TThreadManager>
 class SparseLDLSolverImpl : public sofa::component::linearsolver::MatrixLinearSolver<TMatrix,TVector,TThreadManager>
 {
@@ -164,7 +349,17 @@ public:
 
 protected :
 
-    SparseLDLSolverImpl() : Inherit() {}
+    SparseLDLSolverImpl()
+        : Inherit()
+        , d_symbolicCacheSize(initData(&d_symbolicCacheSize, 4, "symbolicCacheSize", "Number of sparsity patterns whose ordering and symbolic factorization are kept, to be reused when a pattern comes back (0 to disable)"))
+        , d_supernodal(initData(&d_supernodal, false, "supernodal", "Factorize supernodes as dense blocks, faster on matrices with a large fill-in (e.g. 3x3 blocks of volumetric meshes)"))
+    {}
+
+public :
+    Data<int> d_symbolicCacheSize; ///< number of symbolic factorizations kept in cache
+    Data<bool> d_supernodal; ///< use the supernodal numeric factorization
+
+protected :
 
     template<class VecInt,class VecReal>
     void solve_cpu(Real * x,const Real * b,SparseLDLImplInvertData<VecInt,VecReal> * data) {
@@ -260,7 +455,7 @@ protected :
         METIS_NodeND(&n, xadj.data(), adj.data(), NULL, NULL, perm,invperm);
     }
 
-    void LDL_symbolic (int n,int * M_colptr,int * M_rowind,int * colptr,int * perm,int * invperm,int * Parent) {
+    void LDL_workspace(int n) {
         Lnz.clear();
         Flag.clear();
         Pattern.clear();
@@ -268,6 +463,10 @@ protected :
         Lnz.resize(n);
         Flag.resize(n);
         Pattern.resize(n);
+    }
+
+    void LDL_symbolic (int n,int * M_colptr,int * M_rowind,int * colptr,int * perm,int * invperm,int * Parent) {
+        LDL_workspace(n);
 
         CSPARSE_symbolic(n,M_colptr,M_rowind,colptr,perm,invperm,Parent,Flag.data(),Lnz.data());
     }
@@ -278,6 +477,59 @@ protected :
         CSPARSE_numeric<Real>(n,M_colptr,M_rowind,M_values,colptr,rowind,values,D,perm,invperm,Parent,Flag.data(),Lnz.data(),Pattern.data(),Y.data());
     }
 
+    /// Restore the ordering and symbolic factorization of this pattern if it is in the cache
+    template<class VecInt,class VecReal>
+    bool LDL_cached_symbolic(int n,int * M_colptr,int * M_rowind,std::uint64_t hash,SparseLDLImplInvertData<VecInt,VecReal> * data) {
+        std::list<SparseLDLSymbolicFactorization> & cache = data->symbolicCache;
+        for (auto it = cache.begin() ; it != cache.end() ; ++it) {
+            if (it->hash != hash || it->n != n || it->M_colptr.size() != (std::size_t)(n+1) || it->M_rowind.size() != (std::size_t)M_colptr[n]) continue;
+            if (!std::equal(it->M_colptr.begin(),it->M_colptr.end(),M_colptr) || !std::equal(it->M_rowind.begin(),it->M_rowind.end(),M_rowind)) continue;
+
+            memcpy(data->perm.data(),it->perm.data(),n * sizeof(int));
+            memcpy(data->invperm.data(),it->invperm.data(),n * sizeof(int));
+            memcpy(data->L_colptr.data(),it->L_colptr.data(),(n+1) * sizeof(int));
+            data->Parent = it->Parent;
+
+            cache.splice(cache.begin(),cache,it);
+            while (cache.size() > (std::size_t)std::max(d_symbolicCacheSize.getValue(),0)) cache.pop_back();
+            return true;
+        }
+        return false;
+    }
+
+    template<class VecInt,class VecReal>
+    void LDL_store_symbolic(int n,int * M_colptr,int * M_rowind,std::uint64_t hash,SparseLDLImplInvertData<VecInt,VecReal> * data) {
+        std::list<SparseLDLSymbolicFactorization> & cache = data->symbolicCache;
+        const int capacity = d_symbolicCacheSize.getValue();
+        if (capacity <= 0) {
+            cache.clear();
+            return;
+        }
+
+        cache.emplace_front();
+        SparseLDLSymbolicFactorization & entry = cache.front();
+        entry.hash = hash;
+        entry.n = n;
+        entry.M_colptr.assign(M_colptr,M_colptr + n+1);
+        entry.M_rowind.assign(M_rowind,M_rowind + M_colptr[n]);
+        entry.perm.assign(data->perm.data(),data->perm.data() + n);
+        entry.invperm.assign(data->invperm.data(),data->invperm.data() + n);
+        entry.L_colptr.assign(data->L_colptr.data(),data->L_colptr.data() + n+1);
+        entry.Parent = data->Parent;
+
+        while (cache.size() > (std::size_t)capacity) cache.pop_back();
+    }
+
+    template<class VecInt,class VecReal>
+    void LDL_supernodes(int n,int * M_colptr,int * M_rowind,SparseLDLImplInvertData<VecInt,VecReal> * data) {
+        LDL_workspace(n);
+
+        CSPARSE_symbolic_pattern(n,M_colptr,M_rowind,data->L_colptr.data(),data->L_rowind.data(),data->perm.data(),data->invperm.data(),data->Parent.data(),Flag.data(),Lnz.data());
+        CSPARSE_supernodes(n,data->L_colptr.data(),data->Parent.data(),data->superBegin);
+
+        msg_info() << data->superBegin.size()-1 << " supernodes for " << n << " columns" ;
+    }
+
     template<class VecInt,class VecReal>
     void factorize(int n,int * M_colptr, int * M_rowind, Real * M_values, SparseLDLImplInvertData<VecInt,VecReal> * data) {
         data->new_factorization_needed = data->P_colptr.size() == 0 || data->P_rowind.size() == 0 || CSPARSE_need_symbolic_factorization(n, M_colptr, M_rowind, data->n,
@@ -290,8 +542,6 @@ protected :
 
         // we test if the matrix has the same struct as previous factorized matrix
         if (data->new_factorization_needed) {
-            msg_info() << "Recomputing new factorization" ;
-
             data->perm.clear();data->perm.fastResize(data->n);
             data->invperm.clear();data->invperm.fastResize(data->n);
             data->invD.clear();data->invD.fastResize(data->n);
@@ -303,16 +553,28 @@ protected :
             memcpy(data->P_colptr.data(),M_colptr,(data->n+1) * sizeof(int));
             memcpy(data->P_rowind.data(),M_rowind,data->P_nnz * sizeof(int));
 
-            //ordering function
-            LDL_ordering(data->n,M_colptr,M_rowind,data->perm.data(),data->invperm.data());
+            // a pattern alternating between a few states (e.g. appearing and disappearing contacts) reuses its ordering
+            const std::uint64_t hash = CSPARSE_pattern_hash(data->n,M_colptr,M_rowind);
+            if (LDL_cached_symbolic(data->n,M_colptr,M_rowind,hash,data)) {
+                msg_info() << "Reusing the factorization of a previous sparsity pattern" ;
+                LDL_workspace(data->n);
+            } else {
+                msg_info() << "Recomputing new factorization" ;
+
+                //ordering function
+                LDL_ordering(data->n,M_colptr,M_rowind,data->perm.data(),data->invperm.data());
 
-            data->Parent.clear();
-            data->Parent.resize(data->n);
+                data->Parent.clear();
+                data->Parent.resize(data->n);
 
-            //symbolic factorization
-            LDL_symbolic(data->n,M_colptr,M_rowind,data->L_colptr.data(),
-                         data->perm.data(),data->invperm.data(),data->Parent.data());
+                //symbolic factorization
+                LDL_symbolic(data->n,M_colptr,M_rowind,data->L_colptr.data(),
+                             data->perm.data(),data->invperm.data(),data->Parent.data());
 
+                LDL_store_symbolic(data->n,M_colptr,M_rowind,hash,data);
+            }
+
+            data->superBegin.clear();
             data->L_nnz = data->L_colptr[data->n];
 
             data->L_rowind.clear();data->L_rowind.fastResize(data->L_nnz);
@@ -330,8 +592,15 @@ protected :
         Real * tran_values = data->LT_values.data();
 
         //Numeric Factorization
-        LDL_numeric(data->n,M_colptr,M_rowind,M_values,colptr,rowind,values,D,
-                    data->perm.data(),data->invperm.data(),data->Parent.data());
+        if (d_supernodal.getValue()) {
+            if (data->superBegin.empty()) LDL_supernodes(data->n,M_colptr,M_rowind,data);
+
+            CSPARSE_supernodal_numeric<Real>(data->n,M_colptr,M_rowind,M_values,colptr,rowind,values,D,
+                                             data->perm.data(),data->invperm.data(),data->superBegin.data(),(int) data->superBegin.size()-1,supernodalWork);
+        } else {
+            LDL_numeric(data->n,M_colptr,M_rowind,M_values,colptr,rowind,values,D,
+                        data->perm.data(),data->invperm.data(),data->Parent.data());
+        }
 
         //inverse the diagonal
         for (int i=0;i<data->n;i++) D[i] = 1.0/D[i];
@@ -371,6 +640,7 @@ protected : //the folowing variables are used during the factorization they cann
     helper::vector<Real> Y;
     helper::vector<int> Lnz,Flag,Pattern;
     helper::vector<int> tran_countvec;
+    CSPARSE_supernodal_workspace<Real> supernodalWork;
 
 //    helper::vector<int> perm, invperm; //premutation inverse
 